@@ -22,6 +22,7 @@
 #include "quakedef.h"
 #include "d_local.h"
 #include "r_local.h"
+#include "threads.h"
 
 static int	miplevel;
 
@@ -234,6 +235,357 @@ static const int SiegeFlatSkyFadeTable[25] =
 #endif	/* H2W */
 
 
+#if USE_SPANTHREADS
+/*
+==============================================================================
+
+THREADED SPAN DRAWING
+
+The opaque surfaces of a span flush are first walked on the main thread,
+which builds their surface caches and works out their gradients, then the
+screen is cut into bands of rows and the bands are drawn on all threads.
+The spans of the edge list never overlap, so the result is the same as
+drawing the surfaces one after another.
+
+==============================================================================
+*/
+
+#define	SPAN_BANDS_PER_THREAD	4
+#define	SPAN_CHUNK		64
+
+enum
+{
+	DS_SOLID,
+	DS_SKY,
+	DS_TURB,
+	DS_SPANS
+};
+
+typedef struct
+{
+	surf_t		*surf;
+	int		type;
+	int		color;		// DS_SOLID only
+
+	float		sdivzstepu, tdivzstepu, zistepu;
+	float		sdivzstepv, tdivzstepv, zistepv;
+	float		sdivzorigin, tdivzorigin, ziorigin;
+	fixed16_t	sadjust, tadjust, bbextents, bbextentt;
+	pixel_t		*cacheblock;
+	int		cachewidth;
+} spandraw_t;
+
+int			d_spanbatch;
+static int		spanbatch_count;
+
+static spandraw_t	*spandraws;
+static int		numspandraws, maxspandraws;
+static int		numspanbands;
+
+/*
+==============
+D_AddSpanDraw
+
+Keeps the current span drawing state for the surface
+==============
+*/
+static void D_AddSpanDraw (surf_t *s, int type, int color)
+{
+	spandraw_t	*d;
+
+	d = &spandraws[numspandraws++];
+	d->surf = s;
+	d->type = type;
+	d->color = color;
+
+	d->sdivzstepu = d_sdivzstepu;
+	d->tdivzstepu = d_tdivzstepu;
+	d->zistepu = d_zistepu;
+	d->sdivzstepv = d_sdivzstepv;
+	d->tdivzstepv = d_tdivzstepv;
+	d->zistepv = d_zistepv;
+	d->sdivzorigin = d_sdivzorigin;
+	d->tdivzorigin = d_tdivzorigin;
+	d->ziorigin = d_ziorigin;
+	d->sadjust = sadjust;
+	d->tadjust = tadjust;
+	d->bbextents = bbextents;
+	d->bbextentt = bbextentt;
+	d->cacheblock = cacheblock;
+	d->cachewidth = cachewidth;
+}
+
+static void D_DrawSpanChunk (const spandraw_t *d, espan_t *spans)
+{
+	surf_t		surf;
+
+	surf = *d->surf;
+	surf.spans = spans;
+
+	switch (d->type)
+	{
+	case DS_SOLID:
+		D_DrawSolidSurface (&surf, d->color);
+		break;
+	case DS_SKY:
+		D_DrawSkyScans8 (spans);
+		break;
+	case DS_TURB:
+		Turbulent8 (&surf);
+		break;
+	case DS_SPANS:
+		(*d_drawspans) (spans);
+		break;
+	}
+
+	D_DrawZSpans (spans);
+}
+
+/*
+==============
+D_DrawSpanBand
+
+Thread job: draws the spans of all collected surfaces that fall
+into one band of rows.
+==============
+*/
+static void D_DrawSpanBand (void *unused, int band)
+{
+	const spandraw_t	*d;
+	espan_t		chunk[SPAN_CHUNK];
+	espan_t		*span;
+	int		i, count, top, bottom;
+
+	top = r_refdef.vrect.y + r_refdef.vrect.height * band / numspanbands;
+	bottom = r_refdef.vrect.y + r_refdef.vrect.height * (band + 1) / numspanbands;
+	if (band == 0)
+		top = 0;
+	if (band == numspanbands - 1)
+		bottom = vid.height;
+
+	for (i = 0, d = spandraws; i < numspandraws; i++, d++)
+	{
+	// the span drawers take their state from the thread's own globals
+		d_sdivzstepu = d->sdivzstepu;
+		d_tdivzstepu = d->tdivzstepu;
+		d_zistepu = d->zistepu;
+		d_sdivzstepv = d->sdivzstepv;
+		d_tdivzstepv = d->tdivzstepv;
+		d_zistepv = d->zistepv;
+		d_sdivzorigin = d->sdivzorigin;
+		d_tdivzorigin = d->tdivzorigin;
+		d_ziorigin = d->ziorigin;
+		sadjust = d->sadjust;
+		tadjust = d->tadjust;
+		bbextents = d->bbextents;
+		bbextentt = d->bbextentt;
+		cacheblock = d->cacheblock;
+		cachewidth = d->cachewidth;
+
+		count = 0;
+		for (span = d->surf->spans ; span ; span = span->pnext)
+		{
+			if (span->v < top || span->v >= bottom)
+				continue;
+			chunk[count] = *span;
+			chunk[count].pnext = NULL;
+			if (count)
+				chunk[count - 1].pnext = &chunk[count];
+			if (++count == SPAN_CHUNK)
+			{
+				D_DrawSpanChunk (d, chunk);
+				count = 0;
+			}
+		}
+		if (count)
+			D_DrawSpanChunk (d, chunk);
+	}
+}
+
+/*
+==============
+D_FlushSpanBatch
+
+Draws the collected surfaces.  Also called by the surface cache before
+it reuses a block that one of them still reads from.
+==============
+*/
+void D_FlushSpanBatch (void)
+{
+	if (numspandraws)
+		Thread_Run (D_DrawSpanBand, NULL, numspanbands);
+	numspandraws = 0;
+
+	if (++spanbatch_count == 0)
+		spanbatch_count = 1;
+	d_spanbatch = spanbatch_count;
+}
+
+/*
+==============
+D_DrawSurfacesThreaded
+
+Same as the opaque pass of D_DrawSurfaces, with the drawing left to
+D_FlushSpanBatch.  The surface cache is only touched from here, on the
+main thread.
+==============
+*/
+static void D_DrawSurfacesThreaded (const vec3_t world_transformed_modelorg)
+{
+	surf_t			*s;
+	msurface_t		*pface;
+	surfcache_t		*pcurrentcache;
+	vec3_t			local_modelorg;
+	int			color;
+
+	if (maxspandraws < surface_p - surfaces)
+	{
+		maxspandraws = surface_p - surfaces;
+		spandraws = (spandraw_t *) realloc (spandraws, maxspandraws * sizeof(spandraw_t));
+		if (!spandraws)
+			Sys_Error ("%s: out of memory", __thisfunc__);
+	}
+	numspandraws = 0;
+	numspanbands = Thread_Count () * SPAN_BANDS_PER_THREAD;
+	if (numspanbands > r_refdef.vrect.height)
+		numspanbands = r_refdef.vrect.height;
+	if (numspanbands < 1)
+		numspanbands = 1;
+	D_FlushSpanBatch ();	// starts a new batch
+
+	for (s = &surfaces[1] ; s < surface_p ; s++)
+	{
+		if (!s->spans)
+			continue;
+
+		d_zistepu = s->d_zistepu;
+		d_zistepv = s->d_zistepv;
+		d_ziorigin = s->d_ziorigin;
+
+		if (r_drawflat.integer)
+		{
+			D_AddSpanDraw (s, DS_SOLID, (intptr_t)s->data & 0xFF);
+			continue;
+		}
+
+		r_drawnpolycount++;
+
+		if (s->flags & SURF_TRANSLUCENT)
+			continue;
+
+		if (s->flags & SURF_DRAWBLACK)	// black vis-breaker, no turb
+		{
+			color = 0;
+#	if defined (H2W)
+			if (cl_siege)
+				color = SiegeFlatSkyFadeTable[(int)floor(d_lightstylevalue[0]/22)];
+#	endif	/* H2W */
+			D_AddSpanDraw (s, DS_SOLID, color);
+			continue;
+		}
+
+		if (s->flags & SURF_DRAWSKY)
+		{
+			if (!r_skymade)
+			{
+				R_MakeSky ();
+			}
+
+			D_AddSpanDraw (s, DS_SKY, 0);
+			continue;
+		}
+
+		if (s->flags & SURF_DRAWBACKGROUND)
+		{
+			d_zistepu = 0;
+			d_zistepv = 0;
+			d_ziorigin = -0.9;
+
+			D_AddSpanDraw (s, DS_SOLID, r_clearcolor.integer & 0xFF);
+			continue;
+		}
+
+		pface = (msurface_t *) s->data;
+		if (!(s->flags & SURF_DRAWTURB) && (s->flags & SURF_DRAWSOLID) &&
+			((s->entity->drawflags & MLS_ABSLIGHT) == MLS_ABSLIGHT || !pface->samples))
+		{
+			byte *pixels = ((byte *)pface->texinfo->texture +
+				pface->texinfo->texture->offsets[0]);
+			int light;
+			if (!r_fullbright.integer)
+			{
+				if ((s->entity->drawflags & MLS_ABSLIGHT) == MLS_ABSLIGHT)
+					light = s->entity->abslight;
+				else
+					light = r_refdef.ambientlight;
+			}
+			else
+				light = 255;
+			D_AddSpanDraw (s, DS_SOLID, ((unsigned char *)vid.colormap)[(((255-light)<<VID_CBITS) & 0xFF00) + pixels[0]]);
+			continue;
+		}
+
+		if (s->insubmodel)
+			currententity = s->entity;
+
+		if (s->flags & SURF_DRAWTURB)
+		{
+			miplevel = 0;
+			cacheblock = (pixel_t *)
+					((byte *)pface->texinfo->texture +
+					pface->texinfo->texture->offsets[0]);
+			cachewidth = 64;
+		}
+		else
+		{
+		// cache the surface before R_RotateBmodel: a batch that is
+		// flushed from here mustn't see the rotated view vectors
+			miplevel = D_MipLevelForScale (s->nearzi * scale_for_mip
+							* pface->texinfo->mipadjust);
+			pcurrentcache = D_CacheSurface (pface, miplevel);
+			pcurrentcache->spanbatch = d_spanbatch;
+
+			cacheblock = (pixel_t *)pcurrentcache->data;
+			cachewidth = pcurrentcache->width;
+		}
+
+		if (s->insubmodel)
+		{
+			VectorSubtract (r_origin, currententity->origin, local_modelorg);
+			TransformVector (local_modelorg, transformed_modelorg);
+
+			R_RotateBmodel ();
+		}
+
+	// D_CacheSurface can flush the batch, and the main thread draws a
+	// band of it too: that leaves another surface's 1/z in the globals
+		d_zistepu = s->d_zistepu;
+		d_zistepv = s->d_zistepv;
+		d_ziorigin = s->d_ziorigin;
+
+		D_CalcGradients (pface);
+		D_AddSpanDraw (s, (s->flags & SURF_DRAWTURB) ? DS_TURB : DS_SPANS, 0);
+
+		if (s->insubmodel)
+		{
+		// restore the old drawing state
+			currententity = &r_worldentity;
+			VectorCopy (world_transformed_modelorg,
+						transformed_modelorg);
+			VectorCopy (base_vpn, vpn);
+			VectorCopy (base_vup, vup);
+			VectorCopy (base_vright, vright);
+			VectorCopy (base_modelorg, modelorg);
+			R_TransformFrustum ();
+		}
+	}
+
+	D_FlushSpanBatch ();
+	d_spanbatch = 0;
+}
+#endif	/* USE_SPANTHREADS */
+
+
 /*
 ==============
 D_DrawSurfaces
@@ -261,6 +613,14 @@ void D_DrawSurfaces (qboolean Translucent)
 	TransformVector (modelorg, transformed_modelorg);
 	VectorCopy (transformed_modelorg, world_transformed_modelorg);
 
+#if USE_SPANTHREADS
+	if (!Translucent && r_threads.integer && Thread_Count () > 1)
+	{
+		D_DrawSurfacesThreaded (world_transformed_modelorg);
+		return;
+	}
+#endif
+
 // TODO: could preset a lot of this at mode set time
 	if (r_drawflat.integer)
 	{
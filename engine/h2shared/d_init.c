@@ -27,6 +27,9 @@
 static	cvar_t	d_subdiv16 = {"d_subdiv16", "1", CVAR_NONE};
 static	cvar_t	d_mipcap = {"d_mipcap", "0", CVAR_NONE};
 static	cvar_t	d_mipscale = {"d_mipscale", "1", CVAR_NONE};
+#if	!id386 && !id68k
+static	cvar_t	d_spandrawer = {"d_spandrawer", "auto", CVAR_ARCHIVE};
+#endif
 
 surfcache_t		*d_initial_rover;
 qboolean		d_roverwrapped;
@@ -37,6 +40,38 @@ static float	basemip[NUM_MIPS-1] = {1.0, 0.5*0.8, 0.25*0.8};
 
 void (*d_drawspans) (espan_t *pspan);
 
+#if	!id386 && !id68k
+static void (*d_spanfunc) (espan_t *pspan) = D_DrawSpans8;
+
+/*
+===============
+D_SpanDrawer_f
+
+Picks the span drawer named by d_spandrawer, the fastest one for "auto"
+===============
+*/
+static void D_SpanDrawer_f (cvar_t *var)
+{
+	const spandrawer_t	*d, *fastest;
+
+	fastest = NULL;
+	for (d = D_SpanDrawers (); d->name; d++)
+	{
+		if (!q_strcasecmp(var->string, d->name))
+			break;
+		fastest = d;
+	}
+	if (!d->name)
+	{
+		if (q_strcasecmp(var->string, "auto"))
+			Con_Printf ("Unknown span drawer \"%s\", using %s\n", var->string, fastest->name);
+		d = fastest;
+	}
+
+	d_spanfunc = d->drawspans;
+}
+#endif
+
 
 /*
 ===============
@@ -48,6 +83,12 @@ void D_Init (void)
 	Cvar_RegisterVariable (&d_subdiv16);
 	Cvar_RegisterVariable (&d_mipcap);
 	Cvar_RegisterVariable (&d_mipscale);
+#if	!id386 && !id68k
+	Cvar_RegisterVariable (&d_spandrawer);
+	Cvar_SetCallback (&d_spandrawer, D_SpanDrawer_f);
+	D_SpanDrawer_f (&d_spandrawer);
+#endif
+	D_InitSurfCache ();
 
 #if 0
 	r_drawpolys = false;
@@ -123,6 +164,7 @@ void D_SetupFrame (void)
 	else
 		screenwidth = vid.rowbytes;
 
+	D_SurfCacheFrame ();
 	d_roverwrapped = false;
 	d_initial_rover = sc_rover;
 
@@ -141,7 +183,7 @@ void D_SetupFrame (void)
 	else
 		d_drawspans = D_DrawSpans8;
 #else
-	d_drawspans = D_DrawSpans8;
+	d_drawspans = d_spanfunc;
 #endif
 
 	d_aflatcolor = 0;
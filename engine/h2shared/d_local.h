@@ -52,6 +52,8 @@ typedef struct surfcache_s
 	struct texture_s	*texture;	// checked for animating textures
 	int			drawflags;
 	int			abslight;
+	int			spanbatch;	// threaded span batch drawing from it
+	int			lastframe;	// cache frame it was last drawn in
 	byte			data[4];	// width*height elements
 } surfcache_t;
 
@@ -93,20 +95,35 @@ extern qboolean		d_roverwrapped;
 extern surfcache_t	*sc_rover;
 extern surfcache_t	*d_initial_rover;
 
+void D_InitSurfCache (void);
+void D_SurfCacheFrame (void);
+void D_LimitCaches (int size);
+
+extern int		d_spanbatch;	// nonzero while D_DrawSurfaces collects spans
+void D_FlushSpanBatch (void);
+
 ASM_LINKAGE_BEGIN
 
-extern float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
-extern float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
-extern float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
+extern SPAN_THREADVAR float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
+extern SPAN_THREADVAR float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
+extern SPAN_THREADVAR float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
 
-extern fixed16_t	sadjust, tadjust;
-extern fixed16_t	bbextents, bbextentt;
+extern SPAN_THREADVAR fixed16_t	sadjust, tadjust;
+extern SPAN_THREADVAR fixed16_t	bbextents, bbextentt;
 
 ASM_LINKAGE_END
 
 
 extern void (*d_drawspans) (espan_t *pspan);
 
+typedef struct
+{
+	const char	*name;
+	void		(*drawspans) (espan_t *pspan);
+} spandrawer_t;
+
+const spandrawer_t *D_SpanDrawers (void);	// the C drawer comes first
+
 ASM_LINKAGE_BEGIN
 
 void D_DrawSpans8 (espan_t *pspans);
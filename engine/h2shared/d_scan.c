@@ -26,10 +26,10 @@
 #include "d_local.h"
 
 ASM_LINKAGE_BEGIN
-unsigned char	*r_turb_pbase, *r_turb_pdest;
-fixed16_t		r_turb_s, r_turb_t, r_turb_sstep, r_turb_tstep;
-int				*r_turb_turb;
-int				r_turb_spancount;
+SPAN_THREADVAR unsigned char	*r_turb_pbase, *r_turb_pdest;
+SPAN_THREADVAR fixed16_t	r_turb_s, r_turb_t, r_turb_sstep, r_turb_tstep;
+SPAN_THREADVAR int		*r_turb_turb;
+SPAN_THREADVAR int		r_turb_spancount;
 byte			scanList[SCAN_SIZE];
 int				ZScanCount;
 ASM_LINKAGE_END
@@ -0,0 +1,369 @@
+/* d_spansimd.c -- SIMD versions of the D_DrawSpans8 span drawer
+ *
+ * The perspective correction is done exactly as in D_DrawSpans8: once
+ * every 8 pixels, in scalar code.  The kernels work out the texel
+ * addresses of a whole 8 pixel group at once and write the group with
+ * a single store, so their output is the same as that of the C drawer.
+ * The x86 kernels are picked at run time from the cpu features, NEON is
+ * used when the compiler targets it.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "d_local.h"
+
+#if !id386 && !id68k
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define	SPANS_X86	1
+#include <immintrin.h>
+#else
+#define	SPANS_X86	0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define	SPANS_NEON	1
+#include <arm_neon.h>
+#else
+#define	SPANS_NEON	0
+#endif
+
+
+/*
+==============
+D_SPANS_WALK
+
+The span and subdivision stepping of D_DrawSpans8.  DRAWGROUP is called
+with pdest, pbase, s, t, sstep, tstep and spancount for every group of
+at most 8 pixels.
+==============
+*/
+#define D_SPANS_WALK(DRAWGROUP)							\
+	int				count, spancount;			\
+	unsigned char	*pbase, *pdest;						\
+	fixed16_t		s, t, snext, tnext, sstep, tstep;		\
+	float			sdivz, tdivz, zi, z, du, dv, spancountminus1;	\
+	float			sdivz8stepu, tdivz8stepu, zi8stepu;		\
+										\
+	sstep = 0;	/* keep compiler happy */				\
+	tstep = 0;	/* ditto */						\
+										\
+	pbase = (unsigned char *)cacheblock;					\
+										\
+	sdivz8stepu = d_sdivzstepu * 8;						\
+	tdivz8stepu = d_tdivzstepu * 8;						\
+	zi8stepu = d_zistepu * 8;						\
+										\
+	do									\
+	{									\
+		pdest = (unsigned char *)((byte *)d_viewbuffer + (screenwidth * pspan->v) + pspan->u); \
+		count = pspan->count;						\
+										\
+		du = (float)pspan->u;						\
+		dv = (float)pspan->v;						\
+										\
+		sdivz = d_sdivzorigin + dv*d_sdivzstepv + du*d_sdivzstepu;	\
+		tdivz = d_tdivzorigin + dv*d_tdivzstepv + du*d_tdivzstepu;	\
+		zi = d_ziorigin + dv*d_zistepv + du*d_zistepu;			\
+		z = (float)0x10000 / zi;					\
+										\
+		s = (int)(sdivz * z) + sadjust;					\
+		if (s > bbextents)						\
+			s = bbextents;						\
+		else if (s < 0)							\
+			s = 0;							\
+										\
+		t = (int)(tdivz * z) + tadjust;					\
+		if (t > bbextentt)						\
+			t = bbextentt;						\
+		else if (t < 0)							\
+			t = 0;							\
+										\
+		do								\
+		{								\
+			if (count >= 8)						\
+				spancount = 8;					\
+			else							\
+				spancount = count;				\
+										\
+			count -= spancount;					\
+										\
+			if (count)						\
+			{							\
+				sdivz += sdivz8stepu;				\
+				tdivz += tdivz8stepu;				\
+				zi += zi8stepu;					\
+				z = (float)0x10000 / zi;			\
+										\
+				snext = (int)(sdivz * z) + sadjust;		\
+				if (snext > bbextents)				\
+					snext = bbextents;			\
+				else if (snext < 8)				\
+					snext = 8;				\
+										\
+				tnext = (int)(tdivz * z) + tadjust;		\
+				if (tnext > bbextentt)				\
+					tnext = bbextentt;			\
+				else if (tnext < 8)				\
+					tnext = 8;				\
+										\
+				sstep = (snext - s) >> 3;			\
+				tstep = (tnext - t) >> 3;			\
+			}							\
+			else							\
+			{							\
+				spancountminus1 = (float)(spancount - 1);	\
+				sdivz += d_sdivzstepu * spancountminus1;	\
+				tdivz += d_tdivzstepu * spancountminus1;	\
+				zi += d_zistepu * spancountminus1;		\
+				z = (float)0x10000 / zi;			\
+				snext = (int)(sdivz * z) + sadjust;		\
+				if (snext > bbextents)				\
+					snext = bbextents;			\
+				else if (snext < 8)				\
+					snext = 8;				\
+										\
+				tnext = (int)(tdivz * z) + tadjust;		\
+				if (tnext > bbextentt)				\
+					tnext = bbextentt;			\
+				else if (tnext < 8)				\
+					tnext = 8;				\
+										\
+				if (spancount > 1)				\
+				{						\
+					sstep = (snext - s) / (spancount - 1);	\
+					tstep = (tnext - t) / (spancount - 1);	\
+				}						\
+			}							\
+										\
+			DRAWGROUP (pdest, pbase, s, t, sstep, tstep, spancount); \
+			pdest += spancount;					\
+										\
+			s = snext;						\
+			t = tnext;						\
+										\
+		} while (count > 0);						\
+										\
+	} while ((pspan = pspan->pnext) != NULL);
+
+
+#if SPANS_X86
+
+/*
+==============
+D_DrawSpans8_SSE41
+
+Four texel addresses at a time with pmulld, the texels themselves
+are fetched one by one and gathered into a register with pinsrb.
+==============
+*/
+#define SSE41_GROUP(pdest, pbase, s, t, sstep, tstep, n)			\
+{										\
+	__m128i	sv, tv, width, lo, hi;						\
+	int	addr_[8];							\
+	int	i_;								\
+										\
+	width = _mm_set1_epi32 (cachewidth);					\
+	sv = _mm_add_epi32 (_mm_set1_epi32 (s), _mm_mullo_epi32 (ramp, _mm_set1_epi32 (sstep))); \
+	tv = _mm_add_epi32 (_mm_set1_epi32 (t), _mm_mullo_epi32 (ramp, _mm_set1_epi32 (tstep))); \
+	lo = _mm_add_epi32 (_mm_srai_epi32 (sv, 16), _mm_mullo_epi32 (_mm_srai_epi32 (tv, 16), width)); \
+	sv = _mm_add_epi32 (sv, _mm_set1_epi32 (sstep * 4));			\
+	tv = _mm_add_epi32 (tv, _mm_set1_epi32 (tstep * 4));			\
+	hi = _mm_add_epi32 (_mm_srai_epi32 (sv, 16), _mm_mullo_epi32 (_mm_srai_epi32 (tv, 16), width)); \
+	_mm_storeu_si128 ((__m128i *)addr_, lo);				\
+	_mm_storeu_si128 ((__m128i *)(addr_ + 4), hi);				\
+										\
+	if (n == 8)								\
+	{									\
+		__m128i	pix_ = _mm_cvtsi32_si128 (pbase[addr_[0]]);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[1]], 1);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[2]], 2);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[3]], 3);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[4]], 4);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[5]], 5);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[6]], 6);		\
+		pix_ = _mm_insert_epi8 (pix_, pbase[addr_[7]], 7);		\
+		_mm_storel_epi64 ((__m128i *)pdest, pix_);			\
+	}									\
+	else									\
+	{									\
+		for (i_ = 0; i_ < n; i_++)					\
+			pdest[i_] = pbase[addr_[i_]];				\
+	}									\
+}
+
+__attribute__((__target__("sse4.1")))
+static void D_DrawSpans8_SSE41 (espan_t *pspan)
+{
+	const __m128i	ramp = _mm_setr_epi32 (0, 1, 2, 3);
+
+	D_SPANS_WALK (SSE41_GROUP)
+}
+
+/*
+==============
+D_DrawSpans8_AVX2
+
+All eight texels of a group with one gather.  The gather reads whole
+dwords, which is fine: the surface cache ends with its guard bytes.
+==============
+*/
+#define AVX2_GROUP(pdest, pbase, s, t, sstep, tstep, n)			\
+{										\
+	__m256i	ramp, sv, tv, addr, texels, mask;				\
+	__m128i	packed;								\
+										\
+	ramp = _mm256_setr_epi32 (0, 1, 2, 3, 4, 5, 6, 7);			\
+	sv = _mm256_add_epi32 (_mm256_set1_epi32 (s), _mm256_mullo_epi32 (ramp, _mm256_set1_epi32 (sstep))); \
+	tv = _mm256_add_epi32 (_mm256_set1_epi32 (t), _mm256_mullo_epi32 (ramp, _mm256_set1_epi32 (tstep))); \
+	addr = _mm256_add_epi32 (_mm256_srai_epi32 (sv, 16),			\
+			_mm256_mullo_epi32 (_mm256_srai_epi32 (tv, 16), _mm256_set1_epi32 (cachewidth))); \
+	if (n == 8)								\
+		texels = _mm256_i32gather_epi32 ((const int *)pbase, addr, 1);	\
+	else									\
+	{	/* the pixels past the end of the span aren't on the surface */ \
+		mask = _mm256_cmpgt_epi32 (_mm256_set1_epi32 (n), ramp);	\
+		texels = _mm256_mask_i32gather_epi32 (_mm256_setzero_si256 (),	\
+				(const int *)pbase, addr, mask, 1);		\
+	}									\
+	texels = _mm256_shuffle_epi8 (texels, pack8);				\
+	texels = _mm256_permutevar8x32_epi32 (texels, _mm256_setr_epi32 (0, 4, 0, 0, 0, 0, 0, 0)); \
+	packed = _mm256_castsi256_si128 (texels);				\
+	if (n == 8)								\
+		_mm_storel_epi64 ((__m128i *)pdest, packed);			\
+	else									\
+	{									\
+		byte	pix_[8];						\
+		int	i_;							\
+		_mm_storel_epi64 ((__m128i *)pix_, packed);			\
+		for (i_ = 0; i_ < n; i_++)					\
+			pdest[i_] = pix_[i_];					\
+	}									\
+}
+
+__attribute__((__target__("avx2")))
+static void D_DrawSpans8_AVX2 (espan_t *pspan)
+{
+	const __m256i	pack8 = _mm256_setr_epi8 (
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+	D_SPANS_WALK (AVX2_GROUP)
+}
+
+#endif	/* SPANS_X86 */
+
+
+#if SPANS_NEON
+
+/*
+==============
+D_DrawSpans8_NEON
+==============
+*/
+#define NEON_GROUP(pdest, pbase, s, t, sstep, tstep, n)			\
+{										\
+	int32x4_t	sv, tv, lo, hi, width;					\
+	int		addr_[8];						\
+	byte		pix_[8];						\
+	int		i_;							\
+										\
+	width = vdupq_n_s32 (cachewidth);					\
+	sv = vmlaq_s32 (vdupq_n_s32 (s), ramp, vdupq_n_s32 (sstep));		\
+	tv = vmlaq_s32 (vdupq_n_s32 (t), ramp, vdupq_n_s32 (tstep));		\
+	lo = vmlaq_s32 (vshrq_n_s32 (sv, 16), vshrq_n_s32 (tv, 16), width);	\
+	sv = vaddq_s32 (sv, vdupq_n_s32 (sstep * 4));				\
+	tv = vaddq_s32 (tv, vdupq_n_s32 (tstep * 4));				\
+	hi = vmlaq_s32 (vshrq_n_s32 (sv, 16), vshrq_n_s32 (tv, 16), width);	\
+	vst1q_s32 (addr_, lo);							\
+	vst1q_s32 (addr_ + 4, hi);						\
+										\
+	if (n == 8)								\
+	{									\
+		for (i_ = 0; i_ < 8; i_++)					\
+			pix_[i_] = pbase[addr_[i_]];				\
+		vst1_u8 (pdest, vld1_u8 (pix_));				\
+	}									\
+	else									\
+	{									\
+		for (i_ = 0; i_ < n; i_++)					\
+			pdest[i_] = pbase[addr_[i_]];				\
+	}									\
+}
+
+static void D_DrawSpans8_NEON (espan_t *pspan)
+{
+	static const int32_t	ramp_[4] = { 0, 1, 2, 3 };
+	const int32x4_t		ramp = vld1q_s32 (ramp_);
+
+	D_SPANS_WALK (NEON_GROUP)
+}
+
+#endif	/* SPANS_NEON */
+
+
+static spandrawer_t	spandrawers[] =
+{
+	{ "c",		D_DrawSpans8	},
+#if SPANS_X86
+	{ "sse4.1",	D_DrawSpans8_SSE41	},
+	{ "avx2",	D_DrawSpans8_AVX2	},
+#endif
+#if SPANS_NEON
+	{ "neon",	D_DrawSpans8_NEON	},
+#endif
+	{ NULL,		NULL		}
+};
+
+/*
+==============
+D_SpanDrawers
+
+Returns the span drawers that this cpu can run, from the slowest
+to the fastest, terminated by a NULL name.
+==============
+*/
+const spandrawer_t *D_SpanDrawers (void)
+{
+	static qboolean	checked = false;
+	int		i, j;
+
+	if (checked)
+		return spandrawers;
+	checked = true;
+
+#if SPANS_X86
+	__builtin_cpu_init ();
+#endif
+	for (i = j = 0; spandrawers[i].name; i++)
+	{
+#if SPANS_X86
+		if (spandrawers[i].drawspans == D_DrawSpans8_SSE41 && !__builtin_cpu_supports ("sse4.1"))
+			continue;
+		if (spandrawers[i].drawspans == D_DrawSpans8_AVX2 && !__builtin_cpu_supports ("avx2"))
+			continue;
+#endif
+		spandrawers[j++] = spandrawers[i];
+	}
+	spandrawers[j].name = NULL;
+	spandrawers[j].drawspans = NULL;
+
+	return spandrawers;
+}
+
+#endif	/* !id386 && !id68k */
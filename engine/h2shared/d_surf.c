@@ -31,6 +31,33 @@ surfcache_t			*sc_rover, *sc_base;
 
 #define GUARDSIZE       4
 
+/* r_surfcacheadapt 1 grows the cache into malloc'd memory, up to
+ * r_surfcachemax kilobytes, while too many surfaces are rebuilt, and
+ * makes D_SCAlloc pass over the surfaces drawn in the current frame. */
+static	cvar_t	r_surfcachestats = {"r_surfcachestats", "0", CVAR_NONE};
+static	cvar_t	r_surfcacheadapt = {"r_surfcacheadapt", "0", CVAR_ARCHIVE};
+static	cvar_t	r_surfcachemax = {"r_surfcachemax", "32768", CVAR_ARCHIVE};
+
+#define	SC_RECENTFRAMES		8	// evicting younger blocks is churn
+#define	SC_GROWFRAMES		16	// frames of churn before growing
+
+typedef struct
+{
+	int	hits;		// drawn from the cache as it was
+	int	misses;		// needed a new block
+	int	rebuilds;	// redrawn in place for lighting or animation
+	int	evictions;	// owned blocks thrown out
+	int	recent;		// ... of them drawn in the last SC_RECENTFRAMES
+	int	bytes;		// texels rebuilt
+} scstats_t;
+
+static scstats_t	sc_stats, sc_laststats;
+static int		sc_frame = 1;
+static int		sc_churnframes;
+static qboolean		sc_lapfailed;	// no old blocks left this frame
+static byte		*sc_growbuf;	// malloc'd cache after growing, or NULL
+static int		sc_fullsize;	// sc_size before D_LimitCaches, or 0
+
 
 int D_SurfaceCacheForRes (int width, int height)
 {
@@ -84,6 +111,14 @@ D_InitCaches
 */
 void D_InitCaches (void *buffer, int size)
 {
+	if (sc_growbuf && (byte *)buffer != sc_growbuf)
+	{
+		free (sc_growbuf);
+		sc_growbuf = NULL;
+	}
+	sc_churnframes = 0;
+	sc_fullsize = 0;
+
 	if (!msg_suppress_1)
 		Con_Printf ("%ik surface cache\n", size/1024);
 
@@ -94,6 +129,7 @@ void D_InitCaches (void *buffer, int size)
 	sc_base->next = NULL;
 	sc_base->owner = NULL;
 	sc_base->size = sc_size;
+	sc_base->spanbatch = 0;
 
 	D_ClearCacheGuard ();
 }
@@ -121,6 +157,107 @@ void D_FlushCaches (void)
 	sc_base->next = NULL;
 	sc_base->owner = NULL;
 	sc_base->size = sc_size;
+	sc_base->spanbatch = 0;
+}
+
+/*
+==================
+D_LimitCaches
+
+Flushes the cache and has it use only its first size bytes, or all of
+it again for a size of 0, so that r_threadcheck can draw with the cache
+under pressure.
+==================
+*/
+void D_LimitCaches (int size)
+{
+	if (!sc_base)
+		return;
+
+	D_FlushCaches ();
+	if (size > 0)
+	{
+		if (!sc_fullsize)
+			sc_fullsize = sc_size;
+		size &= ~(int)(sizeof(surfcache_t *) - 1);
+		if (size < sc_fullsize)
+			sc_size = size;
+	}
+	else if (sc_fullsize)
+	{
+		sc_size = sc_fullsize;
+		sc_fullsize = 0;
+	}
+	sc_base->size = sc_size;
+	D_ClearCacheGuard ();
+}
+
+/*
+=================
+D_SCRelease
+
+A block that the pending span batch still reads from can only be
+reused after that batch is drawn.
+=================
+*/
+static void D_SCRelease (surfcache_t *c)
+{
+#if USE_SPANTHREADS
+	if (d_spanbatch && c->spanbatch == d_spanbatch)
+		D_FlushSpanBatch ();
+#endif
+	if (c->owner)
+	{
+		*c->owner = NULL;
+		sc_stats.evictions++;
+		if (sc_frame - c->lastframe < SC_RECENTFRAMES)
+			sc_stats.recent++;
+	}
+}
+
+/*
+=================
+D_SCSkipRecent
+
+Moves the rover to the first run of at least size bytes that holds no
+surface drawn in the current frame, so that a frame doesn't throw out
+what it is still drawing while older surfaces sit in the cache.  Gives
+up for the rest of the frame after one lap around the cache.
+=================
+*/
+static void D_SCSkipRecent (int size, qboolean *wrapped)
+{
+	surfcache_t	*c;
+	int		run, scanned;
+
+	for (scanned = 0; scanned < sc_size; )
+	{
+		if (!sc_rover || (byte *)sc_rover - (byte *)sc_base > sc_size - size)
+		{
+			if (sc_rover)
+				*wrapped = true;
+			sc_rover = sc_base;
+		}
+
+		for (c = sc_rover, run = 0; c && run < size; c = c->next)
+		{
+			if (c->owner && c->lastframe == sc_frame)
+				break;
+			run += c->size;
+		}
+		if (run >= size)
+			return;
+
+		scanned += run;
+		if (c)
+		{
+			scanned += c->size;
+			c = c->next;
+		}
+		sc_rover = c;
+	}
+
+	sc_lapfailed = true;
 }
 
 /*
@@ -148,9 +285,11 @@ static surfcache_t *D_SCAlloc (int width, int size)
 	if (size > sc_size)
 		Sys_Error ("%s: %i > cache size", __thisfunc__, size);
 
-// if there is not size bytes after the rover, reset to the start
 	wrapped_this_time = false;
+	if (r_surfcacheadapt.integer && !sc_lapfailed)
+		D_SCSkipRecent (size, &wrapped_this_time);
 
+// if there is not size bytes after the rover, reset to the start
 	if ( !sc_rover || (byte *)sc_rover - (byte *)sc_base > sc_size - size)
 	{
 		if (sc_rover)
@@ -162,8 +301,7 @@ static surfcache_t *D_SCAlloc (int width, int size)
 
 // colect and free surfcache_t blocks until the rover block is large enough
 	new_sc = sc_rover;
-	if (sc_rover->owner)
-		*sc_rover->owner = NULL;
+	D_SCRelease (sc_rover);
 
 	while (new_sc->size < size)
 	{
@@ -171,8 +309,7 @@ static surfcache_t *D_SCAlloc (int width, int size)
 		sc_rover = sc_rover->next;
 		if (!sc_rover)
 			Sys_Error ("%s: hit the end of memory", __thisfunc__);
-		if (sc_rover->owner)
-			*sc_rover->owner = NULL;
+		D_SCRelease (sc_rover);
 
 		new_sc->size += sc_rover->size;
 		new_sc->next = sc_rover->next;
@@ -186,6 +323,7 @@ static surfcache_t *D_SCAlloc (int width, int size)
 		sc_rover->next = new_sc->next;
 		sc_rover->width = 0;
 		sc_rover->owner = NULL;
+		sc_rover->spanbatch = 0;
 		new_sc->next = sc_rover;
 		new_sc->size = size;
 	}
@@ -198,6 +336,7 @@ static surfcache_t *D_SCAlloc (int width, int size)
 		new_sc->height = (size - sizeof(*new_sc) + sizeof(new_sc->data)) / width;
 
 	new_sc->owner = NULL;		// should be set properly after return
+	new_sc->spanbatch = 0;
 
 	if (d_roverwrapped)
 	{
@@ -280,7 +419,11 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 			&& cache->lightadj[2] == r_drawsurf.lightadj[2]
 			&& cache->lightadj[3] == r_drawsurf.lightadj[3] 
 			&& !DoSurface)
+	{
+		cache->lastframe = sc_frame;
+		sc_stats.hits++;
 		return cache;
+	}
 
 //
 // determine shape of surface
@@ -301,6 +444,17 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 		surface->cachespots[miplevel] = cache;
 		cache->owner = &surface->cachespots[miplevel];
 		cache->mipscale = surfscale;
+		sc_stats.misses++;
+	}
+	else
+	{
+		sc_stats.rebuilds++;
+#if USE_SPANTHREADS
+		if (d_spanbatch && cache->spanbatch == d_spanbatch)
+		{	// redrawn in place while the pending span batch reads it
+			D_FlushSpanBatch ();
+		}
+#endif
 	}
 
 	cache->drawflags = currententity->drawflags;
@@ -311,6 +465,9 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 	else
 		cache->dlight = 0;
 
+	cache->lastframe = sc_frame;
+	sc_stats.bytes += r_drawsurf.surfwidth * r_drawsurf.surfheight;
+
 	r_drawsurf.surfdat = (pixel_t *)cache->data;
 
 	cache->texture = r_drawsurf.texture;
@@ -330,3 +487,154 @@ surfcache_t *D_CacheSurface (msurface_t *surface, int miplevel)
 	return surface->cachespots[miplevel];
 }
 
+
+
+//=============================================================================
+
+/*
+=================
+D_SCGrow
+
+Moves the cache into a larger malloc'd buffer.  The blocks keep their
+places, so nothing has to be redrawn; the new space becomes one free
+block at the end.
+=================
+*/
+static void D_SCGrow (int newsize)
+{
+	byte		*buf;
+	surfcache_t	*c, *last;
+	ptrdiff_t	delta;
+
+	buf = (byte *) malloc (newsize + GUARDSIZE);
+	if (!buf)
+		return;
+	memcpy (buf, sc_base, sc_size);
+	delta = buf - (byte *)sc_base;
+
+#define	SC_RELOC(p)	((surfcache_t *)((byte *)(p) + delta))
+	for (c = SC_RELOC(sc_base) ; ; c = c->next)
+	{
+		if (c->owner)
+			*c->owner = c;
+		if (!c->next)
+			break;
+		c->next = SC_RELOC(c->next);
+	}
+	last = c;
+	if (sc_rover)
+		sc_rover = SC_RELOC(sc_rover);
+#undef	SC_RELOC
+
+	if (last->owner)
+	{	// the old end need not be aligned for a block header
+		last->size += (-sc_size) & (sizeof(surfcache_t *) - 1);
+		c = (surfcache_t *)((byte *)last + last->size);
+		c->next = NULL;
+		c->owner = NULL;
+		c->size = newsize - ((byte *)c - buf);
+		c->width = 0;
+		c->spanbatch = 0;
+		last->next = c;
+	}
+	else
+		last->size += newsize - sc_size;
+
+	if (sc_growbuf)
+		free (sc_growbuf);
+	sc_growbuf = buf;
+	sc_base = (surfcache_t *)buf;
+	sc_size = newsize;
+	D_ClearCacheGuard ();
+
+	Con_DPrintf ("surface cache grown to %ik\n", newsize / 1024);
+}
+
+/*
+=================
+D_SurfCacheFrame
+
+Called at the start of every frame.  Keeps the last frame's counters
+for r_surfcachestats, and in adaptive mode grows the cache after
+SC_GROWFRAMES frames in a row that missed a tenth of their surfaces
+and threw out blocks still in use.
+=================
+*/
+void D_SurfCacheFrame (void)
+{
+	int	newsize, limit, total;
+
+	sc_laststats = sc_stats;
+	memset (&sc_stats, 0, sizeof(sc_stats));
+	sc_frame++;
+	sc_lapfailed = false;
+
+	if (!sc_base || !r_surfcacheadapt.integer || sc_fullsize)
+	{
+		sc_churnframes = 0;
+		return;
+	}
+
+	total = sc_laststats.hits + sc_laststats.misses;
+	if (sc_laststats.recent && sc_laststats.misses * 10 >= total)
+		sc_churnframes++;
+	else
+		sc_churnframes = 0;
+	if (sc_churnframes < SC_GROWFRAMES)
+		return;
+	sc_churnframes = 0;
+
+	limit = r_surfcachemax.integer;
+	if (limit > 0x100000)	// 1 gigabyte
+		limit = 0x100000;
+	limit *= 1024;
+	newsize = sc_size + sc_size / 2;
+	if (newsize > limit)
+		newsize = limit;
+	newsize &= ~(int)(sizeof(surfcache_t *) - 1);
+	if (newsize - sc_size >= (int)sizeof(surfcache_t) * 2)
+		D_SCGrow (newsize);
+}
+
+/*
+=================
+D_DrawSurfCacheStats
+=================
+*/
+void D_DrawSurfCacheStats (void)
+{
+	char	st[40];
+	int	x, y, total;
+
+	if (!r_surfcachestats.integer || !sc_base)
+		return;
+
+	total = sc_laststats.hits + sc_laststats.misses;
+	x = scr_vrect.x;
+	y = scr_vrect.y;
+
+	q_snprintf (st, sizeof(st), "surfcache %ik%s", (sc_size + GUARDSIZE) / 1024,
+				sc_growbuf ? " grown" : "");
+	Draw_String (x, y, st);
+	q_snprintf (st, sizeof(st), "hit %5i %3i%%", sc_laststats.hits,
+				total ? sc_laststats.hits * 100 / total : 100);
+	Draw_String (x, y + 8, st);
+	q_snprintf (st, sizeof(st), "miss %4i redo %4i", sc_laststats.misses, sc_laststats.rebuilds);
+	Draw_String (x, y + 16, st);
+	q_snprintf (st, sizeof(st), "evict %3i recent %3i", sc_laststats.evictions, sc_laststats.recent);
+	Draw_String (x, y + 24, st);
+	q_snprintf (st, sizeof(st), "built %ik", sc_laststats.bytes / 1024);
+	Draw_String (x, y + 32, st);
+}
+
+/*
+=================
+D_InitSurfCache
+=================
+*/
+void D_InitSurfCache (void)
+{
+	Cvar_RegisterVariable (&r_surfcachestats);
+	Cvar_RegisterVariable (&r_surfcacheadapt);
+	Cvar_RegisterVariable (&r_surfcachemax);
+}
@@ -32,14 +32,14 @@
 // FIXME: make into one big structure, like cl or sv
 // FIXME: do separately for refresh engine and driver
 
-float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
-float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
-float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
+SPAN_THREADVAR float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
+SPAN_THREADVAR float	d_sdivzstepv, d_tdivzstepv, d_zistepv;
+SPAN_THREADVAR float	d_sdivzorigin, d_tdivzorigin, d_ziorigin;
 
-fixed16_t	sadjust, tadjust, bbextents, bbextentt;
+SPAN_THREADVAR fixed16_t	sadjust, tadjust, bbextents, bbextentt;
 
-pixel_t		*cacheblock;
-int		cachewidth;
+SPAN_THREADVAR pixel_t		*cacheblock;
+SPAN_THREADVAR int		cachewidth;
 
 pixel_t		*d_viewbuffer;
 
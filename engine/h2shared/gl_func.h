@@ -70,6 +70,12 @@ GL_FUNCTION(void, glColor3ubv, (const GLubyte *))
 GL_FUNCTION(void, glColor3f, (GLfloat,GLfloat,GLfloat))
 GL_FUNCTION(void, glClearColor, (GLclampf,GLclampf,GLclampf,GLclampf))
 
+GL_FUNCTION(void, glVertexPointer, (GLint,GLenum,GLsizei,const GLvoid *))
+GL_FUNCTION(void, glTexCoordPointer, (GLint,GLenum,GLsizei,const GLvoid *))
+GL_FUNCTION(void, glEnableClientState, (GLenum))
+GL_FUNCTION(void, glDisableClientState, (GLenum))
+GL_FUNCTION(void, glDrawElements, (GLenum,GLsizei,GLenum,const GLvoid *))
+
 GL_FUNCTION(void, glAlphaFunc, (GLenum,GLclampf))
 GL_FUNCTION(void, glBlendFunc, (GLenum,GLenum))
 GL_FUNCTION(void, glShadeModel, (GLenum))
@@ -145,6 +151,12 @@ GL_FUNCTION(void, glClearStencil, (GLint))
 #define glColor3f_fp		glColor3f
 #define glClearColor_fp		glClearColor
 
+#define glVertexPointer_fp	glVertexPointer
+#define glTexCoordPointer_fp	glTexCoordPointer
+#define glEnableClientState_fp	glEnableClientState
+#define glDisableClientState_fp	glDisableClientState
+#define glDrawElements_fp	glDrawElements
+
 #define glAlphaFunc_fp		glAlphaFunc
 #define glBlendFunc_fp		glBlendFunc
 #define glShadeModel_fp		glShadeModel
@@ -198,6 +210,7 @@ __GL_FUNC_EXTERN func##_f func##_fp;
 /* GL_ARB_multitexture */
 GL_FUNCTION_OPT(void, glActiveTextureARB, (GLenum))
 GL_FUNCTION_OPT(void, glMultiTexCoord2fARB, (GLenum,GLfloat,GLfloat))
+GL_FUNCTION_OPT(void, glClientActiveTextureARB, (GLenum))
 
 #undef GL_FUNCTION_OPT
 
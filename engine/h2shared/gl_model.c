@@ -24,6 +24,7 @@
 
 #include "quakedef.h"
 #include "hashindex.h"
+#include "pvscache.h"
 #include "hwal.h"
 
 static qmodel_t*	loadmodel;
@@ -39,7 +40,7 @@ static void Mod_Print (void);
 
 static cvar_t	external_ents = {"external_ents", "1", CVAR_ARCHIVE};
 
-static byte	mod_novis[MAX_MAP_LEAFS/8];
+static unsigned int	mod_novis[(MAX_MAP_LEAFS+31)/32];
 
 // 650 should be enough with model handle recycling, but.. (Pa3PyX)
 #define	MAX_MOD_KNOWN	2048
@@ -67,6 +68,7 @@ void Mod_Init (void)
 	Cmd_AddCommand ("mcache", Mod_Print);
 
 	memset (mod_novis, 0xff, sizeof(mod_novis));
+	PVS_InitCache ();
 
 	Hash_Allocate (&hash_mod, MAX_MOD_KNOWN);
 }
@@ -131,9 +133,8 @@ mleaf_t *Mod_PointInLeaf (vec3_t p, qmodel_t *model)
 Mod_DecompressVis
 ===================
 */
-static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
+static byte *Mod_DecompressVis (byte *in, qmodel_t *model, byte *decompressed)
 {
-	static byte	decompressed[MAX_MAP_LEAFS/8];
 	int		c;
 	byte	*out;
 	int		row;
@@ -141,16 +142,6 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 	row = (model->numleafs+7)>>3;
 	out = decompressed;
 
-	if (!in)
-	{	// no vis info, so make all visible
-		while (row)
-		{
-			*out++ = 0xff;
-			row--;
-		}
-		return decompressed;
-	}
-
 	do
 	{
 		if (*in)
@@ -161,6 +152,8 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 
 		c = in[1];
 		in += 2;
+		if (c > row - (out - decompressed))	// don't run into the next cached row
+			c = row - (out - decompressed);
 		while (c)
 		{
 			*out++ = 0;
@@ -171,11 +164,28 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 	return decompressed;
 }
 
+/*
+===================
+Mod_LeafPVS
+
+The rows come from the pvs cache, padded to whole words.
+===================
+*/
 byte *Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model)
 {
-	if (leaf == model->leafs)
-		return mod_novis;
-	return Mod_DecompressVis (leaf->compressed_vis, model);
+	static unsigned int	decompressed[(MAX_MAP_LEAFS+31)/32];
+	byte		*row;
+	qboolean	fill;
+
+	if (leaf == model->leafs || !leaf->compressed_vis)
+		return (byte *)mod_novis;	// no vis info, so make all visible
+
+	row = PVS_CacheRow (model->visdata, model->numleafs + 1, leaf - model->leafs, &fill);
+	if (!row)
+		return Mod_DecompressVis (leaf->compressed_vis, model, (byte *)decompressed);
+	if (fill)
+		Mod_DecompressVis (leaf->compressed_vis, model, row);
+	return row;
 }
 
 /*
@@ -372,6 +382,39 @@ qmodel_t *Mod_ForName (const char *name, qboolean crash)
 	return Mod_LoadModel (mod, crash);
 }
 
+/*
+==================
+Mod_PrefetchModels
+
+Reads the files of the models which Mod_ForName is about to load on
+all threads.  The loaders themselves still run one at a time on the
+main thread, taking the data from memory.  Returns the bytes read.
+==================
+*/
+long Mod_PrefetchModels (char (*names)[MAX_QPATH], int count)
+{
+	const char	*list[MAX_MOD_KNOWN];
+	qmodel_t	*mod;
+	int		i, num;
+
+	for (i = num = 0; i < count && num < MAX_MOD_KNOWN; i++)
+	{
+		if (!names[i][0] || names[i][0] == '*')	// inline brush model
+			continue;
+		mod = Mod_FindName (names[i]);
+		if (mod->type == mod_alias)
+		{
+			if (Cache_Check(&mod->cache))
+				continue;
+		}
+		else if (mod->needload == NL_PRESENT)
+			continue;
+		list[num++] = names[i];
+	}
+
+	return FS_PrefetchFiles (list, num);
+}
+
 
 /*
 ===============================================================================
@@ -832,6 +875,7 @@ Mod_LoadVisibility
 */
 static void Mod_LoadVisibility (lump_t *l)
 {
+	PVS_FlushCache ();	// the hunk may hand out the old address again
 	if (!l->filelen)
 	{
 		loadmodel->visdata = NULL;
@@ -114,6 +114,7 @@ typedef struct glpoly_s
 	struct	glpoly_s	*chain;
 	int		numverts;
 	int		flags;		// for SURF_UNDERWATER
+	int		firstvert;	// in the brush model vertex array
 	float	verts[4][VERTEXSIZE];	// variable sized (xyz s1t1 s2t2)
 } glpoly_t;
 
@@ -509,6 +510,7 @@ qmodel_t *Mod_ForName (const char *name, qboolean crash);
 qmodel_t *Mod_FindName (const char *name);
 void	*Mod_Extradata (qmodel_t *mod);	// handles caching
 void	Mod_TouchModel (const char *name);
+long	Mod_PrefetchModels (char (*names)[MAX_QPATH], int count);
 void	Mod_ReloadTextures (void);
 
 mleaf_t *Mod_PointInLeaf (vec3_t p, qmodel_t *model);
@@ -1228,6 +1228,8 @@ needs almost the entire 256k of stack space!
 */
 void SCR_UpdateScreen (void)
 {
+	double		time1 = 0;
+
 	if (block_drawing)
 		return;
 
@@ -1284,7 +1286,13 @@ void SCR_UpdateScreen (void)
 	// no need to draw view in fullscreen intermission screens
 	if (!cl.intermission)
 #endif
+	{
+		if (cls.timedemo)
+			time1 = Sys_DoubleTime ();
 		V_RenderView ();
+		if (cls.timedemo)
+			CL_TimeDemoPhase (tdphase_world, Sys_DoubleTime () - time1);
+	}
 
 	GL_Set2D ();
 	SCR_TileClear ();	// draw any areas not covered by the refresh
@@ -796,6 +796,8 @@ static void CheckMultiTextureExtensions (void)
 			Con_SafePrintf ("Couldn't link to multitexture functions\n");
 			return;
 		}
+		/* only needed for the vertex array path */
+		glClientActiveTextureARB_fp = (glClientActiveTextureARB_f) wglGetProcAddress_fp("glClientActiveTextureARB");
 
 		have_mtex = true;
 		if (!gl_multitexture.integer)
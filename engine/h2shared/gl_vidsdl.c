@@ -739,6 +739,8 @@ static void CheckMultiTextureExtensions (void)
 			Con_SafePrintf ("Couldn't link to multitexture functions\n");
 			return;
 		}
+		/* only needed for the vertex array path */
+		glClientActiveTextureARB_fp = (glClientActiveTextureARB_f) SDL_GL_GetProcAddress("glClientActiveTextureARB");
 
 		have_mtex = true;
 		if (!gl_multitexture.integer)
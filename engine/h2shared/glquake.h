@@ -207,7 +207,7 @@ extern	vec3_t		modelorg, r_entorigin;
 extern	int		r_visframecount;	// ??? what difs?
 extern	int		r_framecount;
 extern	mplane_t	frustum[4];
-extern	int		c_brush_polys, c_alias_polys;
+extern	int		c_brush_polys, c_alias_polys, c_lightmap_bytes;
 
 /* palette stuff */
 extern	const int		ColorIndex[16];
@@ -264,6 +264,7 @@ extern	cvar_t	gl_coloredlight;
 extern	cvar_t	gl_colored_dynamic_lights;
 extern	cvar_t	gl_extra_dynamic_lights;
 extern	cvar_t	gl_lightmapfmt;
+extern	cvar_t	gl_vertexarrays;
 
 /* other globals */
 extern	int		gl_coloredstatic;	/* value of gl_coloredlight stored at level start */
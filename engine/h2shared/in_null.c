@@ -0,0 +1,70 @@
+/* in_null.c -- no input, for the headless video driver
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+
+static void Force_CenterView_f (void)
+{
+	cl.viewangles[PITCH] = 0;
+}
+
+void IN_Init (void)
+{
+	Cmd_AddCommand ("force_centerview", Force_CenterView_f);
+}
+
+void IN_ReInit (void)
+{
+}
+
+void IN_Shutdown (void)
+{
+}
+
+void IN_Commands (void)
+{
+}
+
+void IN_Move (usercmd_t *cmd)
+{
+}
+
+void IN_SendKeyEvents (void)
+{
+}
+
+void IN_ClearStates (void)
+{
+}
+
+void IN_ActivateMouse (void)
+{
+}
+
+void IN_DeactivateMouse (void)
+{
+}
+
+void IN_ShowMouse (void)
+{
+}
+
+void IN_HideMouse (void)
+{
+}
+
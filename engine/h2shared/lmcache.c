@@ -0,0 +1,230 @@
+/* lmcache.c -- built surface lightmaps, by lightstyle values
+ *
+ * R_BuildLightMap combines the style maps of a surface every time one of
+ * its lightstyle values changes.  Most lightstyle strings hold a value
+ * for several frames and flicker patterns come back to the same values,
+ * so the result is kept here, keyed by the surface and the values of its
+ * styles, in r_lightcache kilobytes of fixed size blocks that are
+ * recycled least recently used first.  A repeated state is then a copy
+ * instead of a rebuild.  Surfaces lit by dynamic lights are not cached.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "lmcache.h"
+
+static cvar_t	r_lightcache = {"r_lightcache", "4096", CVAR_ARCHIVE};	/* in KB, 0 disables */
+
+typedef struct
+{
+	const void	*key;		/* surface */
+	int		values[MAXLIGHTMAPS];	/* style values, -1 padded */
+	int		extra, size;
+	int		hashnext;
+	int		prev, next;	/* from most to least recently used */
+} lmslot_t;
+
+int		lm_cachehits, lm_cachelookups;
+
+static int	lm_cachesize;		/* r_lightcache value of the current setup */
+static int	lm_numslots, lm_usedslots;
+static byte	*lm_blocks;		/* [numslots][LM_MAXBLOCKBYTES] */
+static lmslot_t	*lm_slots;
+static int	*lm_hash;		/* hash -> first slot, -1 if none */
+static int	lm_hashmask;
+static int	lm_head, lm_tail;
+
+
+/*
+==================
+LM_FlushCache
+
+Must be called whenever the surfaces or their light data go away
+==================
+*/
+void LM_FlushCache (void)
+{
+	int	i;
+
+	lm_usedslots = 0;
+	lm_head = lm_tail = -1;
+	if (lm_hash)
+	{
+		for (i = 0; i <= lm_hashmask; i++)
+			lm_hash[i] = -1;
+	}
+}
+
+/*
+==================
+LM_SetupCache
+==================
+*/
+static void LM_SetupCache (void)
+{
+	free (lm_blocks);
+	free (lm_slots);
+	free (lm_hash);
+	lm_blocks = NULL;
+	lm_slots = NULL;
+	lm_hash = NULL;
+	lm_numslots = 0;
+	lm_hashmask = 0;
+
+	lm_cachesize = r_lightcache.integer;
+	if (lm_cachesize > 0)
+	{
+		lm_numslots = (int)((size_t)lm_cachesize * 1024 / LM_MAXBLOCKBYTES);
+		lm_hashmask = 1;
+		while (lm_hashmask < lm_numslots)
+			lm_hashmask <<= 1;
+		lm_hashmask--;
+
+		lm_blocks = (byte *) malloc ((size_t)lm_numslots * LM_MAXBLOCKBYTES);
+		lm_slots = (lmslot_t *) malloc (lm_numslots * sizeof(lmslot_t));
+		lm_hash = (int *) malloc ((lm_hashmask + 1) * sizeof(int));
+		if (!lm_blocks || !lm_slots || !lm_hash)
+		{
+			Con_DPrintf ("%s: out of memory for %d blocks\n", __thisfunc__, lm_numslots);
+			free (lm_blocks);
+			free (lm_slots);
+			free (lm_hash);
+			lm_blocks = NULL;
+			lm_slots = NULL;
+			lm_hash = NULL;
+			lm_numslots = 0;
+			lm_hashmask = 0;
+		}
+	}
+
+	LM_FlushCache ();
+}
+
+static int LM_Hash (const void *key, const int *values)
+{
+	unsigned int	h;
+	int		i;
+
+	h = (unsigned int)((size_t)key >> 2) * 2654435761U;
+	for (i = 0; i < MAXLIGHTMAPS; i++)
+		h = (h ^ (unsigned int)values[i]) * 16777619U;
+	return (int)((h ^ (h >> 16)) & lm_hashmask);
+}
+
+static void LM_Unlink (int slot)
+{
+	if (lm_slots[slot].prev != -1)
+		lm_slots[lm_slots[slot].prev].next = lm_slots[slot].next;
+	else	lm_head = lm_slots[slot].next;
+	if (lm_slots[slot].next != -1)
+		lm_slots[lm_slots[slot].next].prev = lm_slots[slot].prev;
+	else	lm_tail = lm_slots[slot].prev;
+}
+
+static void LM_LinkHead (int slot)
+{
+	lm_slots[slot].prev = -1;
+	lm_slots[slot].next = lm_head;
+	if (lm_head != -1)
+		lm_slots[lm_head].prev = slot;
+	lm_head = slot;
+	if (lm_tail == -1)
+		lm_tail = slot;
+}
+
+static void LM_UnhashSlot (int slot)
+{
+	int	*link;
+
+	link = &lm_hash[LM_Hash (lm_slots[slot].key, lm_slots[slot].values)];
+	while (*link != slot)
+		link = &lm_slots[*link].hashnext;
+	*link = lm_slots[slot].hashnext;
+}
+
+/*
+==================
+LM_CacheBlock
+==================
+*/
+byte *LM_CacheBlock (const void *key, const int *values, int numvalues,
+			int extra, int size, qboolean *fill)
+{
+	int		vals[MAXLIGHTMAPS];
+	int		i, h, slot;
+	lmslot_t	*s;
+
+	if (r_lightcache.integer != lm_cachesize)
+		LM_SetupCache ();
+	if (!lm_numslots || size > LM_MAXBLOCKBYTES || numvalues > MAXLIGHTMAPS)
+		return NULL;
+
+	for (i = 0; i < numvalues; i++)
+		vals[i] = values[i];
+	for ( ; i < MAXLIGHTMAPS; i++)
+		vals[i] = -1;
+
+	lm_cachelookups++;
+	h = LM_Hash (key, vals);
+	for (slot = lm_hash[h]; slot != -1; slot = s->hashnext)
+	{
+		s = &lm_slots[slot];
+		if (s->key == key && s->extra == extra && s->size == size &&
+		    !memcmp(s->values, vals, sizeof(vals)))
+		{
+			lm_cachehits++;
+			if (slot != lm_head)
+			{
+				LM_Unlink (slot);
+				LM_LinkHead (slot);
+			}
+			*fill = false;
+			return lm_blocks + (size_t)slot * LM_MAXBLOCKBYTES;
+		}
+	}
+
+	if (lm_usedslots < lm_numslots)
+		slot = lm_usedslots++;
+	else
+	{	/* recycle the least recently used block */
+		slot = lm_tail;
+		LM_Unlink (slot);
+		LM_UnhashSlot (slot);
+	}
+
+	s = &lm_slots[slot];
+	s->key = key;
+	memcpy (s->values, vals, sizeof(vals));
+	s->extra = extra;
+	s->size = size;
+	s->hashnext = lm_hash[h];
+	lm_hash[h] = slot;
+	LM_LinkHead (slot);
+
+	*fill = true;
+	return lm_blocks + (size_t)slot * LM_MAXBLOCKBYTES;
+}
+
+/*
+==================
+LM_InitCache
+==================
+*/
+void LM_InitCache (void)
+{
+	Cvar_RegisterVariable (&r_lightcache);
+}
@@ -0,0 +1,38 @@
+/* lmcache.h -- built surface lightmaps, by lightstyle values
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __LMCACHE_H
+#define __LMCACHE_H
+
+/* largest block the cache holds: 18x18 samples of 4 bytes */
+#define	LM_MAXBLOCKBYTES	(18*18*4)
+
+extern	int	lm_cachehits, lm_cachelookups;	/* reset by r_speeds */
+
+void	LM_InitCache (void);
+void	LM_FlushCache (void);
+
+/* returns the cache block of size bytes for surface key lit with the
+ * numvalues style values in values[] (extra covers any other setting
+ * the lightmap depends on), or NULL if the cache is disabled.  if *fill
+ * is set on return, the block is new and the caller must build the
+ * lightmap into it.  the block stays valid until the next call. */
+byte	*LM_CacheBlock (const void *key, const int *values, int numvalues,
+			int extra, int size, qboolean *fill);
+
+#endif	/* __LMCACHE_H */
@@ -0,0 +1,191 @@
+/* pvscache.c -- decompressed pvs rows of the world model
+ *
+ * Mod_LeafPVS used to run-length decode a pvs row into a static buffer
+ * on every call.  The rows are now kept here after their first use.
+ * If the whole set of rows fits under mod_pvscache kilobytes, every row
+ * has a fixed slot and a lookup is a pointer return.  Otherwise (large
+ * BSP2 maps) the slots are recycled least recently used first.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "pvscache.h"
+
+static cvar_t	mod_pvscache = {"mod_pvscache", "16384", CVAR_ARCHIVE};	/* in KB, 0 disables */
+
+static const void	*pvs_key;	/* visdata of the cached model */
+static int	pvs_cachesize;		/* mod_pvscache value of the current setup */
+static int	pvs_numrows, pvs_rowbytes;
+static int	pvs_numslots, pvs_usedslots;
+static byte	*pvs_rows;		/* [numslots][rowbytes] */
+static int	*pvs_slot;		/* row -> slot, -1 if not cached */
+static int	*pvs_owner;		/* slot -> row */
+static int	*pvs_prev, *pvs_next;	/* slots from most to least recently used */
+static int	pvs_head, pvs_tail;
+
+
+/*
+==================
+PVS_FlushCache
+==================
+*/
+void PVS_FlushCache (void)
+{
+	free (pvs_rows);
+	free (pvs_slot);
+	free (pvs_owner);
+	free (pvs_prev);
+	free (pvs_next);
+	pvs_rows = NULL;
+	pvs_slot = pvs_owner = pvs_prev = pvs_next = NULL;
+	pvs_key = NULL;
+	pvs_numrows = pvs_numslots = pvs_usedslots = 0;
+}
+
+/*
+==================
+PVS_SetupCache
+==================
+*/
+static void PVS_SetupCache (const void *key, int numrows)
+{
+	int	i;
+	size_t	limit;
+
+	PVS_FlushCache ();
+
+	pvs_key = key;
+	pvs_numrows = numrows;
+	pvs_rowbytes = PVS_ROWBYTES(numrows);
+	pvs_cachesize = mod_pvscache.integer;
+	if (pvs_cachesize <= 0 || numrows <= 0)
+		return;
+
+	limit = (size_t)pvs_cachesize * 1024 / pvs_rowbytes;
+	pvs_numslots = (limit < (size_t)numrows) ? (int)limit : numrows;
+	if (pvs_numslots < 1)
+	{
+		pvs_numslots = 0;
+		return;
+	}
+
+	pvs_rows = (byte *) calloc (pvs_numslots, pvs_rowbytes);
+	pvs_slot = (int *) malloc (numrows * sizeof(int));
+	if (pvs_numslots < numrows)
+	{
+		pvs_owner = (int *) malloc (pvs_numslots * sizeof(int));
+		pvs_prev = (int *) malloc (pvs_numslots * sizeof(int));
+		pvs_next = (int *) malloc (pvs_numslots * sizeof(int));
+	}
+	if (!pvs_rows || !pvs_slot ||
+	    (pvs_numslots < numrows && (!pvs_owner || !pvs_prev || !pvs_next)))
+	{
+		Con_DPrintf ("%s: out of memory for %d rows\n", __thisfunc__, pvs_numslots);
+		PVS_FlushCache ();
+		pvs_key = key;
+		pvs_numrows = numrows;
+		return;
+	}
+
+	for (i = 0; i < numrows; i++)
+		pvs_slot[i] = -1;
+	pvs_head = pvs_tail = -1;
+
+	Con_DPrintf ("PVS cache: %d of %d rows, %d KB\n", pvs_numslots, numrows,
+					(int)(((size_t)pvs_numslots * pvs_rowbytes) >> 10));
+}
+
+static void PVS_Unlink (int slot)
+{
+	if (pvs_prev[slot] != -1)
+		pvs_next[pvs_prev[slot]] = pvs_next[slot];
+	else	pvs_head = pvs_next[slot];
+	if (pvs_next[slot] != -1)
+		pvs_prev[pvs_next[slot]] = pvs_prev[slot];
+	else	pvs_tail = pvs_prev[slot];
+}
+
+static void PVS_LinkHead (int slot)
+{
+	pvs_prev[slot] = -1;
+	pvs_next[slot] = pvs_head;
+	if (pvs_head != -1)
+		pvs_prev[pvs_head] = slot;
+	pvs_head = slot;
+	if (pvs_tail == -1)
+		pvs_tail = slot;
+}
+
+/*
+==================
+PVS_CacheRow
+==================
+*/
+byte *PVS_CacheRow (const void *key, int numrows, int rownum, qboolean *fill)
+{
+	int	slot;
+
+	if (key != pvs_key || numrows != pvs_numrows || mod_pvscache.integer != pvs_cachesize)
+		PVS_SetupCache (key, numrows);
+	if (!pvs_numslots || rownum < 0 || rownum >= numrows)
+		return NULL;
+
+	slot = pvs_slot[rownum];
+
+	if (pvs_numslots == pvs_numrows)
+	{	/* everything fits: a fixed slot for each row */
+		*fill = (slot < 0);
+		pvs_slot[rownum] = rownum;
+		return pvs_rows + (size_t)rownum * pvs_rowbytes;
+	}
+
+	if (slot >= 0)
+	{
+		*fill = false;
+		if (slot != pvs_head)
+		{
+			PVS_Unlink (slot);
+			PVS_LinkHead (slot);
+		}
+		return pvs_rows + (size_t)slot * pvs_rowbytes;
+	}
+
+	if (pvs_usedslots < pvs_numslots)
+		slot = pvs_usedslots++;
+	else
+	{	/* recycle the least recently used row */
+		slot = pvs_tail;
+		PVS_Unlink (slot);
+		pvs_slot[pvs_owner[slot]] = -1;
+	}
+	pvs_owner[slot] = rownum;
+	pvs_slot[rownum] = slot;
+	PVS_LinkHead (slot);
+
+	*fill = true;
+	return pvs_rows + (size_t)slot * pvs_rowbytes;
+}
+
+/*
+==================
+PVS_InitCache
+==================
+*/
+void PVS_InitCache (void)
+{
+	Cvar_RegisterVariable (&mod_pvscache);
+}
@@ -0,0 +1,36 @@
+/* pvscache.h -- decompressed pvs rows of the world model
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __PVSCACHE_H
+#define __PVSCACHE_H
+
+/* bytes in a cached row for numleafs leafs:  rows are padded to whole
+ * words with zeroes, so that they can be or'ed together a word at a time. */
+#define	PVS_ROWBYTES(numleafs)	((((numleafs) + 31) >> 5) << 2)
+
+void	PVS_InitCache (void);
+void	PVS_FlushCache (void);
+
+/* returns the cache row for row number rownum of the model whose
+ * visdata is key, or NULL if the cache is disabled.  if *fill is set
+ * on return, the row is new and the caller must decompress into it.
+ * if the cache is too small to hold every row of the model, the row
+ * is only guaranteed to stay valid until the next call. */
+byte	*PVS_CacheRow (const void *key, int numrows, int rownum, qboolean *fill);
+
+#endif	/* __PVSCACHE_H */
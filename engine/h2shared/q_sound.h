@@ -94,6 +94,7 @@ void S_StaticSound (sfx_t *sfx, vec3_t origin, float vol, float attenuation);
 void S_StopSound (int entnum, int entchannel);
 void S_UpdateSoundPos (int entnum, int entchannel, vec3_t origin);
 void S_StopAllSounds(qboolean clear);
+void S_StopDynamicSounds (void);
 void S_ClearBuffer (void);
 void S_Update (vec3_t origin, vec3_t forward, vec3_t right, vec3_t up);
 void S_ExtraUpdate (void);
@@ -161,6 +162,7 @@ extern	cvar_t		bgmvolume;
 
 void S_LocalSound (const char *name);
 sfxcache_t *S_LoadSound (sfx_t *s);
+sfxcache_t *S_DecodeSound (const char *name, int *size);	/* thread-safe, malloc'd */
 
 wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength);
 
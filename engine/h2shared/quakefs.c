@@ -28,6 +28,7 @@
 #endif
 #include "filenames.h"
 #include "hashindex.h"
+#include "threads.h"
 
 typedef struct
 {
@@ -755,19 +756,23 @@ int FS_CreatePath (char *path)
 
 /*
 ===========
-FS_OpenFile
+FS_FindFile
 
-Finds the file in the search path, returns fs_filesize.
+Finds the file in the search path and opens it if file is not NULL.
+Returns the file size, or -1 if not found.  Touches no globals, so it
+is safe to call from the worker threads.  *file is left NULL if the
+file was found but couldn't be opened.
 ===========
 */
-long FS_OpenFile (const char *filename, FILE **file, unsigned int *path_id)
+static long FS_FindFile (const char *filename, FILE **file, unsigned int *path_id, int *from_pak)
 {
 	searchpath_t	*search;
 	pack_t		*pak;
 	char	ospath[MAX_OSPATH];
+	long	len;
 	int	i, key;
 
-	file_from_pak = 0;
+	*from_pak = 0;
 
 	/* search through the path, one element at a time */
 	for (search = fs_searchpaths ; search ; search = search->next)
@@ -781,44 +786,184 @@ long FS_OpenFile (const char *filename, FILE **file, unsigned int *path_id)
 				if (strcmp(pak->files[i].name, filename) != 0)
 					continue;
 				/* found it! */
-				fs_filesize = pak->files[i].filelen;
-				file_from_pak = 1;
+				*from_pak = 1;
 				if (path_id)
 					*path_id = search->path_id;
 				if (!file) /* for FS_FileExists() */
-					return fs_filesize;
+					return pak->files[i].filelen;
 				/* open a new file on the pakfile */
 				*file = fopen (pak->filename, "rb");
-				if (!*file)
-					Sys_Error ("Couldn't reopen %s", pak->filename);
-				fseek (*file, pak->files[i].filepos, SEEK_SET);
-				return fs_filesize;
+				if (*file)
+					fseek (*file, pak->files[i].filepos, SEEK_SET);
+				return pak->files[i].filelen;
 			}
 		}
 		else	/* check a file in the directory tree */
 		{
 			q_snprintf (ospath, sizeof(ospath), "%s/%s",search->filename, filename);
-			fs_filesize = Sys_filesize (ospath);
-			if (fs_filesize < 0)
+			len = Sys_filesize (ospath);
+			if (len < 0)
 				continue;
 			if (path_id)
 				*path_id = search->path_id;
 			if (!file) /* for FS_FileExists() */
-				return fs_filesize;
+				return len;
 			*file = fopen (ospath, "rb");
-			if (!*file)
-				Sys_Error ("Couldn't reopen %s", ospath);
-			return fs_filesize;
+			return len;
 		}
 	}
 
-	Sys_DPrintf ("%s: can't find %s\n", __thisfunc__, filename);
-
 	if (file) *file = NULL;
-	fs_filesize = -1;
+	return -1;
+}
+
+/*
+===========
+FS_OpenFile
+
+Finds the file in the search path, returns fs_filesize.
+===========
+*/
+long FS_OpenFile (const char *filename, FILE **file, unsigned int *path_id)
+{
+	fs_filesize = FS_FindFile (filename, file, path_id, &file_from_pak);
+	if (fs_filesize < 0)
+	{
+		Sys_DPrintf ("%s: can't find %s\n", __thisfunc__, filename);
+		return fs_filesize;
+	}
+	if (file && !*file)
+		Sys_Error ("Couldn't reopen %s", filename);
+
 	return fs_filesize;
 }
 
+/*
+===========
+FS_ReadMallocFile
+
+Reads a whole file into malloc'd memory with a 0 byte appended.
+Returns NULL if the file isn't found or can't be read.  Unlike the
+FS_Load*File functions below, this is safe to call from the worker
+threads:  it doesn't set fs_filesize or file_from_pak, and it never
+prints or errors out.
+===========
+*/
+byte *FS_ReadMallocFile (const char *path, long *len, unsigned int *path_id, int *from_pak)
+{
+	FILE	*h;
+	byte	*buf;
+	int	pak;
+
+	*len = FS_FindFile (path, &h, path_id, &pak);
+	if (from_pak)
+		*from_pak = pak;
+	if (*len < 0)
+		return NULL;
+	if (!h)
+	{
+		*len = -1;
+		return NULL;
+	}
+
+	buf = (byte *) malloc (*len + 1);
+	if (buf)
+	{
+		if (*len && fread(buf, (size_t)*len, 1, h) != 1)
+		{
+			free (buf);
+			buf = NULL;
+		}
+		else
+			buf[*len] = 0;
+	}
+	fclose (h);
+
+	if (!buf)
+		*len = -1;
+	return buf;
+}
+
+#if !defined(SERVERONLY)
+/*
+===========
+FS_PrefetchFiles
+
+Reads a list of files on all threads so that the FS_Load*File calls
+which follow can be served from memory.  Whatever isn't claimed by a
+load is released by FS_FreePrefetch.  Returns the number of bytes read.
+===========
+*/
+typedef struct
+{
+	char		name[MAX_QPATH];
+	byte		*data;
+	long		len;
+	unsigned int	path_id;
+	int		from_pak;
+} prefetch_t;
+
+static prefetch_t	*fs_prefetch;
+static int		fs_numprefetch;
+
+static void FS_PrefetchWork (void *data, int work)
+{
+	prefetch_t	*pf = (prefetch_t *)data + work;
+
+	pf->data = FS_ReadMallocFile (pf->name, &pf->len, &pf->path_id, &pf->from_pak);
+}
+
+long FS_PrefetchFiles (const char **names, int count)
+{
+	long	total;
+	int	i;
+
+	FS_FreePrefetch ();
+	if (count <= 0)
+		return 0;
+
+	fs_prefetch = (prefetch_t *) calloc (count, sizeof(prefetch_t));
+	if (!fs_prefetch)
+		return 0;
+	for (i = 0; i < count; i++)
+		q_strlcpy (fs_prefetch[i].name, names[i], MAX_QPATH);
+	fs_numprefetch = count;
+
+	Thread_Run (FS_PrefetchWork, fs_prefetch, count);
+
+	total = 0;
+	for (i = 0; i < count; i++)
+	{
+		if (fs_prefetch[i].data)
+			total += fs_prefetch[i].len;
+	}
+	return total;
+}
+
+void FS_FreePrefetch (void)
+{
+	int	i;
+
+	for (i = 0; i < fs_numprefetch; i++)
+		free (fs_prefetch[i].data);
+	free (fs_prefetch);
+	fs_prefetch = NULL;
+	fs_numprefetch = 0;
+}
+
+static prefetch_t *FS_FindPrefetch (const char *path)
+{
+	int	i;
+
+	for (i = 0; i < fs_numprefetch; i++)
+	{
+		if (fs_prefetch[i].data && !strcmp(fs_prefetch[i].name, path))
+			return &fs_prefetch[i];
+	}
+	return NULL;
+}
+#endif	/* SERVERONLY */
+
 /*
 ===========
 FS_FileExists
@@ -887,7 +1032,27 @@ static byte *FS_LoadFile (const char *path, int usehunk, unsigned int *path_id)
 	byte	*buf;
 	char	base[32];
 	long	len;
+#if !defined(SERVERONLY)
+	prefetch_t	*pf;
 
+/* see if it was read ahead by FS_PrefetchFiles */
+	pf = FS_FindPrefetch (path);
+	if (pf)
+	{
+		h = NULL;
+		len = fs_filesize = pf->len;
+		file_from_pak = pf->from_pak;
+		if (path_id)
+			*path_id = pf->path_id;
+		if (usehunk == LOADFILE_MALLOC)
+		{	/* hand it over */
+			buf = pf->data;
+			pf->data = NULL;
+			return buf;
+		}
+	}
+	else
+#endif
 /* look for it in the filesystem or pack files */
 	len = FS_OpenFile (path, &h, path_id);
 	if (len < 0)
@@ -931,6 +1096,16 @@ static byte *FS_LoadFile (const char *path, int usehunk, unsigned int *path_id)
 
 	((byte *)buf)[len] = 0;
 
+#if !defined(SERVERONLY)
+	if (pf)
+	{
+		memcpy (buf, pf->data, (size_t)len);
+		free (pf->data);
+		pf->data = NULL;
+		return buf;
+	}
+#endif
+
 	Draw_BeginDisc ();
 	if (!fread(buf, (size_t)len, 1, h))
 		Sys_Error ("%s: Error reading %s", __thisfunc__, path);
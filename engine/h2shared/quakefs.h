@@ -91,6 +91,20 @@ long FS_OpenFile (const char *filename, FILE **file, unsigned int *path_id);
 	 * returns fs_filesize on success or (-1) on failure.  If path_id is not NULL,
 	 * the id number of the opened file's gamedir is stored in path_id.  */
 
+byte *FS_ReadMallocFile (const char *path, long *len, unsigned int *path_id, int *from_pak);
+	/* Reads a file into malloc'd memory with a 0 byte appended, stores its
+	 * size in len.  Returns NULL on failure.  Doesn't set fs_filesize or
+	 * file_from_pak and never prints or errors:  safe to call from worker
+	 * threads.  from_pak may be NULL.  */
+
+#if !defined(SERVERONLY)
+long FS_PrefetchFiles (const char **names, int count);
+void FS_FreePrefetch (void);
+	/* Reads the named files on all threads ahead of their FS_Load*File
+	 * calls, which then take the data from memory.  FS_FreePrefetch drops
+	 * whatever wasn't loaded.  Returns the number of bytes read.  */
+#endif
+
 qboolean FS_FileExists (const char *filename, unsigned int *path_id);
 	/* Returns whether the file is found in the hexen2 filesystem.  if path_id is
 	 * not NULL, the id number of the found file's gamedir is stored in path_id. */
@@ -0,0 +1,668 @@
+/* r_aliassimd.c -- alias model vertex kernels
+ *
+ * The vertex loops of the software alias model drawer: transform, light
+ * and project the vertices of a trivially accepted model, transform,
+ * light, project and clip test them for a clipped one, and transform the
+ * corners of the bounding box for R_AliasCheckBBox.  The plain C versions
+ * are the old loops of r_alias.c; the SSE4.1 and AVX2 versions do four
+ * and eight vertices at a time with the same float operations in the same
+ * order, so they give the same results to the bit.  They are picked at run
+ * time from the cpu features, r_aliascheck compares them against C.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "r_local.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define	ALIAS_X86	1
+#include <immintrin.h>
+#else
+#define	ALIAS_X86	0
+#endif
+
+static cvar_t	r_aliaskernels = {"r_aliaskernels", "auto", CVAR_ARCHIVE};
+
+const aliaskernels_t	*r_aliask;
+
+/* the sums are grouped the same way in every version, so that they
+   round the same way in all of them */
+#define AliasTransform(v, t)	(((v)[0]*(t)[0] + (v)[1]*(t)[1]) + ((v)[2]*(t)[2] + (t)[3]))
+
+
+/*
+==============================================================================
+
+C VERSIONS
+
+==============================================================================
+*/
+
+static void R_AliasTransformPoints_C (auxvert_t *out, const float *in, int count)
+{
+	int		i;
+
+	for (i = 0; i < count; i++, out++, in += 3)
+	{
+		out->fv[0] = AliasTransform(in, aliastransform[0]);
+		out->fv[1] = AliasTransform(in, aliastransform[1]);
+		out->fv[2] = AliasTransform(in, aliastransform[2]);
+	}
+}
+
+static void R_AliasClipVerts_C (finalvert_t *fv, auxvert_t *av, const trivertx_t *pverts,
+				const int *shade, float ziscale, int count)
+{
+	int		i;
+	float		zi;
+
+	for (i = 0; i < count; i++, fv++, av++, pverts++)
+	{
+		av->fv[0] = AliasTransform(pverts->v, aliastransform[0]);
+		av->fv[1] = AliasTransform(pverts->v, aliastransform[1]);
+		av->fv[2] = AliasTransform(pverts->v, aliastransform[2]);
+
+		fv->v[4] = shade[pverts->lightnormalindex];
+
+		if (av->fv[2] < ALIAS_Z_CLIP_PLANE)
+		{
+			fv->flags = ALIAS_Z_CLIP;
+			continue;
+		}
+
+	// project points
+		zi = 1.0 / av->fv[2];
+
+		fv->v[5] = zi * ziscale;
+
+		fv->v[0] = (av->fv[0] * aliasxscale * zi) + aliasxcenter;
+		fv->v[1] = (av->fv[1] * aliasyscale * zi) + aliasycenter;
+
+		fv->flags = 0;
+		if (fv->v[0] < r_refdef.aliasvrect.x)
+			fv->flags |= ALIAS_LEFT_CLIP;
+		if (fv->v[1] < r_refdef.aliasvrect.y)
+			fv->flags |= ALIAS_TOP_CLIP;
+		if (fv->v[0] > r_refdef.aliasvrectright)
+			fv->flags |= ALIAS_RIGHT_CLIP;
+		if (fv->v[1] > r_refdef.aliasvrectbottom)
+			fv->flags |= ALIAS_BOTTOM_CLIP;
+	}
+}
+
+static void R_AliasProjectVerts_C (finalvert_t *fv, const trivertx_t *pverts, const stvert_t *pstverts,
+				const int *shade, int count)
+{
+	int		i;
+	float		zi;
+
+	for (i = 0; i < count; i++, fv++, pverts++, pstverts++)
+	{
+	// transform and project
+		zi = 1.0 / AliasTransform(pverts->v, aliastransform[2]);
+
+	// x, y, and z are scaled down by 1/2**31 in the transform, so 1/z is
+	// scaled up by 1/2**31, and the scaling cancels out for x and y in the
+	// projection
+		fv->v[5] = zi;
+
+		fv->v[0] = (AliasTransform(pverts->v, aliastransform[0]) * zi) + aliasxcenter;
+		fv->v[1] = (AliasTransform(pverts->v, aliastransform[1]) * zi) + aliasycenter;
+
+		fv->v[2] = pstverts->s;
+		fv->v[3] = pstverts->t;
+		fv->flags = pstverts->onseam;
+
+		fv->v[4] = shade[pverts->lightnormalindex];
+	}
+}
+
+
+#if ALIAS_X86
+/*
+==============================================================================
+
+SSE4.1 VERSIONS
+
+The vector parts work on the vertices in columns and leave them in small
+arrays, from where they are written into the finalverts one by one.
+
+==============================================================================
+*/
+
+/* -ffast-math lets the compiler regroup products and sums as it likes,
+   and it does so differently for the vector code: this hands it a value
+   it cannot look into, so that the grouping stays the one of the C code */
+#define	ALIAS_KEEP(v)	__asm__ ("" : "+x" (v))
+
+__attribute__((__target__("sse4.1")))
+static inline __m128 R_AliasTransformRow_SSE41 (__m128 x, __m128 y, __m128 z, const float *t)
+{
+	__m128		xy, zt;
+
+	xy = _mm_add_ps (_mm_mul_ps (x, _mm_set1_ps (t[0])), _mm_mul_ps (y, _mm_set1_ps (t[1])));
+	zt = _mm_add_ps (_mm_mul_ps (z, _mm_set1_ps (t[2])), _mm_set1_ps (t[3]));
+	ALIAS_KEEP (xy);
+	ALIAS_KEEP (zt);
+	return _mm_add_ps (xy, zt);
+}
+
+/* (a * scale * zi) + center, for the clipped case */
+__attribute__((__target__("sse4.1")))
+static inline __m128i R_AliasProject_SSE41 (__m128 a, float scale, __m128 zi, float center)
+{
+	a = _mm_mul_ps (a, _mm_set1_ps (scale));
+	ALIAS_KEEP (a);
+	return _mm_cvttps_epi32 (_mm_add_ps (_mm_mul_ps (a, zi), _mm_set1_ps (center)));
+}
+
+/* 1 / z in double, as the C code does it: -ffast-math would make a float
+   division a reciprocal estimate, which rounds differently */
+__attribute__((__target__("sse4.1")))
+static inline __m128 R_AliasRecip_SSE41 (__m128 z)
+{
+	__m128d		lo, hi;
+
+	lo = _mm_div_pd (_mm_set1_pd (1.0), _mm_cvtps_pd (z));
+	hi = _mm_div_pd (_mm_set1_pd (1.0), _mm_cvtps_pd (_mm_movehl_ps (z, z)));
+	return _mm_movelh_ps (_mm_cvtpd_ps (lo), _mm_cvtpd_ps (hi));
+}
+
+/* four trivertx_t are one 16 byte load: x, y and z are bytes 0, 1 and 2
+   of every dword, the light normal index is byte 3 */
+__attribute__((__target__("sse4.1")))
+static inline void R_AliasUnpackVerts_SSE41 (const trivertx_t *pverts, __m128 *x, __m128 *y, __m128 *z)
+{
+	__m128i		v, mask;
+
+	mask = _mm_set1_epi32 (0xff);
+	v = _mm_loadu_si128 ((const __m128i *)pverts);
+	*x = _mm_cvtepi32_ps (_mm_and_si128 (v, mask));
+	*y = _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (v, 8), mask));
+	*z = _mm_cvtepi32_ps (_mm_and_si128 (_mm_srli_epi32 (v, 16), mask));
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_AliasTransformPoints_SSE41 (auxvert_t *out, const float *in, int count)
+{
+	__m128		x, y, z;
+	float		ox[4], oy[4], oz[4];
+	int		i, j;
+
+	for (i = 0; i + 4 <= count; i += 4, out += 4, in += 12)
+	{
+		x = _mm_setr_ps (in[0], in[3], in[6], in[9]);
+		y = _mm_setr_ps (in[1], in[4], in[7], in[10]);
+		z = _mm_setr_ps (in[2], in[5], in[8], in[11]);
+		_mm_storeu_ps (ox, R_AliasTransformRow_SSE41 (x, y, z, aliastransform[0]));
+		_mm_storeu_ps (oy, R_AliasTransformRow_SSE41 (x, y, z, aliastransform[1]));
+		_mm_storeu_ps (oz, R_AliasTransformRow_SSE41 (x, y, z, aliastransform[2]));
+		for (j = 0; j < 4; j++)
+		{
+			out[j].fv[0] = ox[j];
+			out[j].fv[1] = oy[j];
+			out[j].fv[2] = oz[j];
+		}
+	}
+	R_AliasTransformPoints_C (out, in, count - i);
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_AliasClipVerts_SSE41 (finalvert_t *fv, auxvert_t *av, const trivertx_t *pverts,
+				const int *shade, float ziscale, int count)
+{
+	__m128		x, y, z, ax, ay, az, zi;
+	__m128i		u, v, flags, clip;
+	float		oax[4], oay[4], oaz[4];
+	int		ou[4], ov[4], oz[4], oflags[4];
+	int		i, j;
+
+	for (i = 0; i + 4 <= count; i += 4, fv += 4, av += 4, pverts += 4)
+	{
+		R_AliasUnpackVerts_SSE41 (pverts, &x, &y, &z);
+		ax = R_AliasTransformRow_SSE41 (x, y, z, aliastransform[0]);
+		ay = R_AliasTransformRow_SSE41 (x, y, z, aliastransform[1]);
+		az = R_AliasTransformRow_SSE41 (x, y, z, aliastransform[2]);
+
+	// the z clipped lanes are projected too, but not written out
+		zi = R_AliasRecip_SSE41 (az);
+		u = R_AliasProject_SSE41 (ax, aliasxscale, zi, aliasxcenter);
+		v = R_AliasProject_SSE41 (ay, aliasyscale, zi, aliasycenter);
+
+		clip = _mm_cmplt_epi32 (u, _mm_set1_epi32 (r_refdef.aliasvrect.x));
+		flags = _mm_and_si128 (clip, _mm_set1_epi32 (ALIAS_LEFT_CLIP));
+		clip = _mm_cmplt_epi32 (v, _mm_set1_epi32 (r_refdef.aliasvrect.y));
+		flags = _mm_or_si128 (flags, _mm_and_si128 (clip, _mm_set1_epi32 (ALIAS_TOP_CLIP)));
+		clip = _mm_cmpgt_epi32 (u, _mm_set1_epi32 (r_refdef.aliasvrectright));
+		flags = _mm_or_si128 (flags, _mm_and_si128 (clip, _mm_set1_epi32 (ALIAS_RIGHT_CLIP)));
+		clip = _mm_cmpgt_epi32 (v, _mm_set1_epi32 (r_refdef.aliasvrectbottom));
+		flags = _mm_or_si128 (flags, _mm_and_si128 (clip, _mm_set1_epi32 (ALIAS_BOTTOM_CLIP)));
+		clip = _mm_castps_si128 (_mm_cmplt_ps (az, _mm_set1_ps (ALIAS_Z_CLIP_PLANE)));
+		flags = _mm_blendv_epi8 (flags, _mm_set1_epi32 (ALIAS_Z_CLIP), clip);
+
+		_mm_storeu_ps (oax, ax);
+		_mm_storeu_ps (oay, ay);
+		_mm_storeu_ps (oaz, az);
+		_mm_storeu_si128 ((__m128i *)ou, u);
+		_mm_storeu_si128 ((__m128i *)ov, v);
+		_mm_storeu_si128 ((__m128i *)oz, _mm_cvttps_epi32 (_mm_mul_ps (zi, _mm_set1_ps (ziscale))));
+		_mm_storeu_si128 ((__m128i *)oflags, flags);
+		for (j = 0; j < 4; j++)
+		{
+			av[j].fv[0] = oax[j];
+			av[j].fv[1] = oay[j];
+			av[j].fv[2] = oaz[j];
+			fv[j].v[4] = shade[pverts[j].lightnormalindex];
+			fv[j].flags = oflags[j];
+			if (oflags[j] & ALIAS_Z_CLIP)
+				continue;
+			fv[j].v[0] = ou[j];
+			fv[j].v[1] = ov[j];
+			fv[j].v[5] = oz[j];
+		}
+	}
+	R_AliasClipVerts_C (fv, av, pverts, shade, ziscale, count - i);
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_AliasProjectVerts_SSE41 (finalvert_t *fv, const trivertx_t *pverts, const stvert_t *pstverts,
+				const int *shade, int count)
+{
+	__m128		x, y, z, zi, p;
+	int		ou[4], ov[4], oz[4];
+	int		i, j;
+
+	for (i = 0; i + 4 <= count; i += 4, fv += 4, pverts += 4, pstverts += 4)
+	{
+		R_AliasUnpackVerts_SSE41 (pverts, &x, &y, &z);
+		zi = R_AliasRecip_SSE41 (R_AliasTransformRow_SSE41 (x, y, z, aliastransform[2]));
+		_mm_storeu_si128 ((__m128i *)oz, _mm_cvttps_epi32 (zi));
+		p = _mm_mul_ps (R_AliasTransformRow_SSE41 (x, y, z, aliastransform[0]), zi);
+		_mm_storeu_si128 ((__m128i *)ou, _mm_cvttps_epi32 (_mm_add_ps (p, _mm_set1_ps (aliasxcenter))));
+		p = _mm_mul_ps (R_AliasTransformRow_SSE41 (x, y, z, aliastransform[1]), zi);
+		_mm_storeu_si128 ((__m128i *)ov, _mm_cvttps_epi32 (_mm_add_ps (p, _mm_set1_ps (aliasycenter))));
+		for (j = 0; j < 4; j++)
+		{
+			fv[j].v[0] = ou[j];
+			fv[j].v[1] = ov[j];
+			fv[j].v[2] = pstverts[j].s;
+			fv[j].v[3] = pstverts[j].t;
+			fv[j].v[4] = shade[pverts[j].lightnormalindex];
+			fv[j].v[5] = oz[j];
+			fv[j].flags = pstverts[j].onseam;
+		}
+	}
+	R_AliasProjectVerts_C (fv, pverts, pstverts, shade, count - i);
+}
+
+
+/*
+==============================================================================
+
+AVX2 VERSIONS
+
+==============================================================================
+*/
+
+__attribute__((__target__("avx2")))
+static inline __m256 R_AliasTransformRow_AVX2 (__m256 x, __m256 y, __m256 z, const float *t)
+{
+	__m256		xy, zt;
+
+	xy = _mm256_add_ps (_mm256_mul_ps (x, _mm256_set1_ps (t[0])), _mm256_mul_ps (y, _mm256_set1_ps (t[1])));
+	zt = _mm256_add_ps (_mm256_mul_ps (z, _mm256_set1_ps (t[2])), _mm256_set1_ps (t[3]));
+	ALIAS_KEEP (xy);
+	ALIAS_KEEP (zt);
+	return _mm256_add_ps (xy, zt);
+}
+
+__attribute__((__target__("avx2")))
+static inline __m256i R_AliasProject_AVX2 (__m256 a, float scale, __m256 zi, float center)
+{
+	a = _mm256_mul_ps (a, _mm256_set1_ps (scale));
+	ALIAS_KEEP (a);
+	return _mm256_cvttps_epi32 (_mm256_add_ps (_mm256_mul_ps (a, zi), _mm256_set1_ps (center)));
+}
+
+__attribute__((__target__("avx2")))
+static inline __m256 R_AliasRecip_AVX2 (__m256 z)
+{
+	__m128		lo, hi;
+
+	lo = _mm256_cvtpd_ps (_mm256_div_pd (_mm256_set1_pd (1.0), _mm256_cvtps_pd (_mm256_castps256_ps128 (z))));
+	hi = _mm256_cvtpd_ps (_mm256_div_pd (_mm256_set1_pd (1.0), _mm256_cvtps_pd (_mm256_extractf128_ps (z, 1))));
+	return _mm256_insertf128_ps (_mm256_castps128_ps256 (lo), hi, 1);
+}
+
+__attribute__((__target__("avx2")))
+static inline void R_AliasUnpackVerts_AVX2 (const trivertx_t *pverts, __m256 *x, __m256 *y, __m256 *z)
+{
+	__m256i		v, mask;
+
+	mask = _mm256_set1_epi32 (0xff);
+	v = _mm256_loadu_si256 ((const __m256i *)pverts);
+	*x = _mm256_cvtepi32_ps (_mm256_and_si256 (v, mask));
+	*y = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (v, 8), mask));
+	*z = _mm256_cvtepi32_ps (_mm256_and_si256 (_mm256_srli_epi32 (v, 16), mask));
+}
+
+__attribute__((__target__("avx2")))
+static void R_AliasTransformPoints_AVX2 (auxvert_t *out, const float *in, int count)
+{
+	__m256		x, y, z;
+	float		ox[8], oy[8], oz[8];
+	int		i, j;
+
+	for (i = 0; i + 8 <= count; i += 8, out += 8, in += 24)
+	{
+		x = _mm256_setr_ps (in[0], in[3], in[6], in[9], in[12], in[15], in[18], in[21]);
+		y = _mm256_setr_ps (in[1], in[4], in[7], in[10], in[13], in[16], in[19], in[22]);
+		z = _mm256_setr_ps (in[2], in[5], in[8], in[11], in[14], in[17], in[20], in[23]);
+		_mm256_storeu_ps (ox, R_AliasTransformRow_AVX2 (x, y, z, aliastransform[0]));
+		_mm256_storeu_ps (oy, R_AliasTransformRow_AVX2 (x, y, z, aliastransform[1]));
+		_mm256_storeu_ps (oz, R_AliasTransformRow_AVX2 (x, y, z, aliastransform[2]));
+		for (j = 0; j < 8; j++)
+		{
+			out[j].fv[0] = ox[j];
+			out[j].fv[1] = oy[j];
+			out[j].fv[2] = oz[j];
+		}
+	}
+	R_AliasTransformPoints_C (out, in, count - i);
+}
+
+__attribute__((__target__("avx2")))
+static void R_AliasClipVerts_AVX2 (finalvert_t *fv, auxvert_t *av, const trivertx_t *pverts,
+				const int *shade, float ziscale, int count)
+{
+	__m256		x, y, z, ax, ay, az, zi;
+	__m256i		u, v, flags, clip;
+	float		oax[8], oay[8], oaz[8];
+	int		ou[8], ov[8], oz[8], oflags[8];
+	int		i, j;
+
+	for (i = 0; i + 8 <= count; i += 8, fv += 8, av += 8, pverts += 8)
+	{
+		R_AliasUnpackVerts_AVX2 (pverts, &x, &y, &z);
+		ax = R_AliasTransformRow_AVX2 (x, y, z, aliastransform[0]);
+		ay = R_AliasTransformRow_AVX2 (x, y, z, aliastransform[1]);
+		az = R_AliasTransformRow_AVX2 (x, y, z, aliastransform[2]);
+
+		zi = R_AliasRecip_AVX2 (az);
+		u = R_AliasProject_AVX2 (ax, aliasxscale, zi, aliasxcenter);
+		v = R_AliasProject_AVX2 (ay, aliasyscale, zi, aliasycenter);
+
+		clip = _mm256_cmpgt_epi32 (_mm256_set1_epi32 (r_refdef.aliasvrect.x), u);
+		flags = _mm256_and_si256 (clip, _mm256_set1_epi32 (ALIAS_LEFT_CLIP));
+		clip = _mm256_cmpgt_epi32 (_mm256_set1_epi32 (r_refdef.aliasvrect.y), v);
+		flags = _mm256_or_si256 (flags, _mm256_and_si256 (clip, _mm256_set1_epi32 (ALIAS_TOP_CLIP)));
+		clip = _mm256_cmpgt_epi32 (u, _mm256_set1_epi32 (r_refdef.aliasvrectright));
+		flags = _mm256_or_si256 (flags, _mm256_and_si256 (clip, _mm256_set1_epi32 (ALIAS_RIGHT_CLIP)));
+		clip = _mm256_cmpgt_epi32 (v, _mm256_set1_epi32 (r_refdef.aliasvrectbottom));
+		flags = _mm256_or_si256 (flags, _mm256_and_si256 (clip, _mm256_set1_epi32 (ALIAS_BOTTOM_CLIP)));
+		clip = _mm256_castps_si256 (_mm256_cmp_ps (az, _mm256_set1_ps (ALIAS_Z_CLIP_PLANE), _CMP_LT_OQ));
+		flags = _mm256_blendv_epi8 (flags, _mm256_set1_epi32 (ALIAS_Z_CLIP), clip);
+
+		_mm256_storeu_ps (oax, ax);
+		_mm256_storeu_ps (oay, ay);
+		_mm256_storeu_ps (oaz, az);
+		_mm256_storeu_si256 ((__m256i *)ou, u);
+		_mm256_storeu_si256 ((__m256i *)ov, v);
+		_mm256_storeu_si256 ((__m256i *)oz, _mm256_cvttps_epi32 (_mm256_mul_ps (zi, _mm256_set1_ps (ziscale))));
+		_mm256_storeu_si256 ((__m256i *)oflags, flags);
+		for (j = 0; j < 8; j++)
+		{
+			av[j].fv[0] = oax[j];
+			av[j].fv[1] = oay[j];
+			av[j].fv[2] = oaz[j];
+			fv[j].v[4] = shade[pverts[j].lightnormalindex];
+			fv[j].flags = oflags[j];
+			if (oflags[j] & ALIAS_Z_CLIP)
+				continue;
+			fv[j].v[0] = ou[j];
+			fv[j].v[1] = ov[j];
+			fv[j].v[5] = oz[j];
+		}
+	}
+	R_AliasClipVerts_C (fv, av, pverts, shade, ziscale, count - i);
+}
+
+__attribute__((__target__("avx2")))
+static void R_AliasProjectVerts_AVX2 (finalvert_t *fv, const trivertx_t *pverts, const stvert_t *pstverts,
+				const int *shade, int count)
+{
+	__m256		x, y, z, zi, p;
+	int		ou[8], ov[8], oz[8], olight[8];
+	int		i, j;
+
+	for (i = 0; i + 8 <= count; i += 8, fv += 8, pverts += 8, pstverts += 8)
+	{
+		R_AliasUnpackVerts_AVX2 (pverts, &x, &y, &z);
+		zi = R_AliasRecip_AVX2 (R_AliasTransformRow_AVX2 (x, y, z, aliastransform[2]));
+		_mm256_storeu_si256 ((__m256i *)oz, _mm256_cvttps_epi32 (zi));
+		p = _mm256_mul_ps (R_AliasTransformRow_AVX2 (x, y, z, aliastransform[0]), zi);
+		_mm256_storeu_si256 ((__m256i *)ou, _mm256_cvttps_epi32 (_mm256_add_ps (p, _mm256_set1_ps (aliasxcenter))));
+		p = _mm256_mul_ps (R_AliasTransformRow_AVX2 (x, y, z, aliastransform[1]), zi);
+		_mm256_storeu_si256 ((__m256i *)ov, _mm256_cvttps_epi32 (_mm256_add_ps (p, _mm256_set1_ps (aliasycenter))));
+	// the light normal index is the top byte of every vertex
+		_mm256_storeu_si256 ((__m256i *)olight, _mm256_i32gather_epi32 (shade,
+					_mm256_srli_epi32 (_mm256_loadu_si256 ((const __m256i *)pverts), 24), 4));
+		for (j = 0; j < 8; j++)
+		{
+			fv[j].v[0] = ou[j];
+			fv[j].v[1] = ov[j];
+			fv[j].v[2] = pstverts[j].s;
+			fv[j].v[3] = pstverts[j].t;
+			fv[j].v[4] = olight[j];
+			fv[j].v[5] = oz[j];
+			fv[j].flags = pstverts[j].onseam;
+		}
+	}
+	R_AliasProjectVerts_C (fv, pverts, pstverts, shade, count - i);
+}
+#endif	/* ALIAS_X86 */
+
+
+static aliaskernels_t	aliaskernels[] =
+{
+	{ "c",		R_AliasTransformPoints_C,	R_AliasClipVerts_C,	R_AliasProjectVerts_C		},
+#if ALIAS_X86
+	{ "sse4.1",	R_AliasTransformPoints_SSE41,	R_AliasClipVerts_SSE41,	R_AliasProjectVerts_SSE41	},
+	{ "avx2",	R_AliasTransformPoints_AVX2,	R_AliasClipVerts_AVX2,	R_AliasProjectVerts_AVX2	},
+#endif
+	{ NULL,		NULL,				NULL,			NULL				}
+};
+
+/*
+==============
+R_AliasKernelList
+
+The kernel sets that this cpu can run, slowest first
+==============
+*/
+static const aliaskernels_t *R_AliasKernelList (void)
+{
+	static qboolean	checked = false;
+	int		i, j;
+
+	if (checked)
+		return aliaskernels;
+	checked = true;
+
+#if ALIAS_X86
+	__builtin_cpu_init ();
+#endif
+	for (i = j = 0; aliaskernels[i].name; i++)
+	{
+#if ALIAS_X86
+		if (aliaskernels[i].clipverts == R_AliasClipVerts_SSE41 && !__builtin_cpu_supports ("sse4.1"))
+			continue;
+		if (aliaskernels[i].clipverts == R_AliasClipVerts_AVX2 && !__builtin_cpu_supports ("avx2"))
+			continue;
+#endif
+		aliaskernels[j++] = aliaskernels[i];
+	}
+	aliaskernels[j] = aliaskernels[i];
+
+	return aliaskernels;
+}
+
+static void R_AliasKernels_f (cvar_t *var)
+{
+	const aliaskernels_t	*k, *fastest;
+
+	fastest = NULL;
+	for (k = R_AliasKernelList (); k->name; k++)
+	{
+		if (!q_strcasecmp(var->string, k->name))
+			break;
+		fastest = k;
+	}
+	if (!k->name)
+	{
+		if (q_strcasecmp(var->string, "auto"))
+			Con_Printf ("Unknown alias kernels \"%s\", using %s\n", var->string, fastest->name);
+		k = fastest;
+	}
+
+	r_aliask = k;
+}
+
+
+/*
+==============
+R_AliasCheck_f
+
+Runs every kernel set on random vertices and transforms, the clipped
+ones with the near plane cutting through the model, and counts the
+results that differ from the C kernels.
+==============
+*/
+#define	CHECK_VERTS	67
+
+static void R_AliasCheck_f (void)
+{
+	const aliaskernels_t	*k, *c;
+	float		savetransform[3][4], savescale[4];
+	float		points[CHECK_VERTS][3];
+	trivertx_t	verts[CHECK_VERTS];
+	stvert_t	stverts[CHECK_VERTS];
+	finalvert_t	ref[CHECK_VERTS], out[CHECK_VERTS];
+	auxvert_t	refaux[CHECK_VERTS], outaux[CHECK_VERTS];
+	int		shade[NUMVERTEXNORMALS];
+	int		i, j, iter, count, diffs;
+	float		scale;
+
+	memcpy (savetransform, aliastransform, sizeof(savetransform));
+	savescale[0] = aliasxscale;
+	savescale[1] = aliasyscale;
+	savescale[2] = aliasxcenter;
+	savescale[3] = aliasycenter;
+
+	aliasxscale = aliasyscale = 160;
+	aliasxcenter = 160;
+	aliasycenter = 100;
+	for (i = 0; i < NUMVERTEXNORMALS; i++)
+		shade[i] = rand() & 0xff;
+
+	c = R_AliasKernelList ();
+	for (k = c + 1; k->name; k++)
+	{
+		diffs = 0;
+		for (iter = 0; iter < 2000; iter++)
+		{
+			count = 1 + rand() % CHECK_VERTS;
+			for (i = 0; i < count; i++)
+			{
+				verts[i].v[0] = rand() & 0xff;
+				verts[i].v[1] = rand() & 0xff;
+				verts[i].v[2] = rand() & 0xff;
+				verts[i].lightnormalindex = rand() % NUMVERTEXNORMALS;
+				stverts[i].onseam = (rand() & 1) ? ALIAS_ONSEAM : 0;
+				stverts[i].s = rand() & 0x3fff;
+				stverts[i].t = rand() & 0x3fff;
+				points[i][0] = (rand() % 20000) / 10.0 - 1000;
+				points[i][1] = (rand() % 20000) / 10.0 - 1000;
+				points[i][2] = (rand() % 20000) / 10.0 - 1000;
+			}
+
+		// a model scale, a rotation-like part and a translation that
+		// puts some of it behind the near plane
+			for (i = 0; i < 3; i++)
+			{
+				for (j = 0; j < 3; j++)
+					aliastransform[i][j] = (rand() % 2001 - 1000) / 1000.0 * 0.8;
+				aliastransform[i][3] = (rand() % 8000) / 10.0 - 400;
+			}
+			aliastransform[2][3] = (rand() % 4000) / 10.0 - 100;
+
+			k->transformpoints (outaux, &points[0][0], count);
+			c->transformpoints (refaux, &points[0][0], count);
+			if (memcmp (refaux, outaux, count * sizeof(auxvert_t)))
+				diffs++;
+
+			memset (ref, 0, count * sizeof(finalvert_t));
+			memset (out, 0, count * sizeof(finalvert_t));
+			c->clipverts (ref, refaux, verts, shade, (float)0x8000 * (float)0x10000, count);
+			k->clipverts (out, outaux, verts, shade, (float)0x8000 * (float)0x10000, count);
+			if (memcmp (refaux, outaux, count * sizeof(auxvert_t)) ||
+			    memcmp (ref, out, count * sizeof(finalvert_t)))
+				diffs++;
+
+		// the trivial accept transform: all of it in front, and
+		// scaled like R_AliasSetUpTransform does it
+			aliastransform[2][3] = 300 + (rand() % 4000) / 10.0;
+			scale = 1.0 / ((float)0x8000 * 0x10000);
+			for (i = 0; i < 4; i++)
+			{
+				aliastransform[0][i] *= aliasxscale * scale;
+				aliastransform[1][i] *= aliasyscale * scale;
+				aliastransform[2][i] *= scale;
+			}
+			memset (ref, 0, count * sizeof(finalvert_t));
+			memset (out, 0, count * sizeof(finalvert_t));
+			c->projectverts (ref, verts, stverts, shade, count);
+			k->projectverts (out, verts, stverts, shade, count);
+			if (memcmp (ref, out, count * sizeof(finalvert_t)))
+				diffs++;
+		}
+		Con_Printf ("%-8s %d of %d results differ\n", k->name, diffs, iter * 3);
+	}
+	Con_Printf ("using %s\n", r_aliask->name);
+
+	memcpy (aliastransform, savetransform, sizeof(savetransform));
+	aliasxscale = savescale[0];
+	aliasyscale = savescale[1];
+	aliasxcenter = savescale[2];
+	aliasycenter = savescale[3];
+}
+
+
+/*
+==============
+R_InitAliasKernels
+==============
+*/
+void R_InitAliasKernels (void)
+{
+	Cvar_RegisterVariable (&r_aliaskernels);
+	Cvar_SetCallback (&r_aliaskernels, R_AliasKernels_f);
+	R_AliasKernels_f (&r_aliaskernels);
+
+	Cmd_AddCommand ("r_aliascheck", R_AliasCheck_f);
+}
@@ -85,6 +85,7 @@ extern cvar_t	r_teamcolor;
 #endif
 extern cvar_t	r_texture_external;
 extern cvar_t	r_dynamic;
+extern cvar_t	r_threads;
 
 #define XCENTERING	(1.0 / 2.0)
 #define YCENTERING	(1.0 / 2.0)
@@ -244,8 +245,8 @@ ASM_LINKAGE_BEGIN
 extern	int	ubasestep, errorterm, erroradjustup, erroradjustdown;
 extern	int	vstartscan;
 
-extern	fixed16_t	sadjust, tadjust;
-extern	fixed16_t	bbextents, bbextentt;
+extern	SPAN_THREADVAR fixed16_t	sadjust, tadjust;
+extern	SPAN_THREADVAR fixed16_t	bbextents, bbextentt;
 
 ASM_LINKAGE_END
 
@@ -298,6 +299,43 @@ qboolean R_AliasCheckBBox (void);
 #define	AMP2		3
 #define	SPEED		20
 
+//=========================================================
+// surface cache lighting and block kernels, see r_surfsimd.c
+
+typedef struct
+{
+	const char	*name;
+	void	(*addlightmap) (unsigned int *blocklights, const byte *lightmap, unsigned int scale, int size);
+	void	(*adddlight) (unsigned int *blocklights, int smax, int tmax,
+				float local0, float local1, float rad, float minlight);
+	void	(*finishlights) (unsigned int *blocklights, int size);
+	void	(*blockrow) (byte *prowdest, const byte *psource, const byte *colormap,
+				int light, int lightstep, int count);
+} surfkernels_t;
+
+extern	const surfkernels_t	*r_surfk;
+
+void R_InitSurfKernels (void);
+
+//=========================================================
+// alias model vertex kernels, see r_aliassimd.c
+
+extern	float	aliastransform[3][4];
+
+typedef struct
+{
+	const char	*name;
+	void	(*transformpoints) (auxvert_t *out, const float *in, int count);
+	void	(*clipverts) (finalvert_t *fv, auxvert_t *av, const trivertx_t *pverts,
+				const int *shade, float ziscale, int count);
+	void	(*projectverts) (finalvert_t *fv, const trivertx_t *pverts, const stvert_t *pstverts,
+				const int *shade, int count);
+} aliaskernels_t;
+
+extern	const aliaskernels_t	*r_aliask;
+
+void R_InitAliasKernels (void);
+
 //=========================================================
 
 void R_ReadPointFile_f (void);
@@ -361,6 +399,8 @@ ASM_LINKAGE_END
 
 void R_StoreEfrags (efrag_t **ppefrag);
 void R_TimeRefresh_f (void);
+void R_ThreadCheck_f (void);
+void R_TimeSpans_f (void);
 void R_TimeGraph (void);
 #ifdef H2W
 void R_ZGraph (void);
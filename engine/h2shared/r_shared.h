@@ -52,8 +52,8 @@ extern void	R_DrawLine (polyvert_t *polyvert0, polyvert_t *polyvert1);
 
 
 ASM_LINKAGE_BEGIN
-extern	int	cachewidth;
-extern	pixel_t	*cacheblock;
+extern	SPAN_THREADVAR int	cachewidth;
+extern	SPAN_THREADVAR pixel_t	*cacheblock;
 extern	int	screenwidth;
 ASM_LINKAGE_END
 
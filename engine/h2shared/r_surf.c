@@ -21,6 +21,7 @@
 
 #include "quakedef.h"
 #include "r_local.h"
+#include "lmcache.h"
 
 drawsurf_t	r_drawsurf;
 
@@ -111,6 +112,12 @@ static void R_AddDynamicLights (void)
 		local0 = DotProduct (impact, tex->vecs[0]) + tex->vecs[0][3] - surf->texturemins[0];
 		local1 = DotProduct (impact, tex->vecs[1]) + tex->vecs[1][3] - surf->texturemins[1];
 
+		if (!cl_dlights[lnum].dark && rad >= 0)
+		{
+			r_surfk->adddlight (blocklights, smax, tmax, local0, local1, rad, minlight);
+			continue;
+		}
+
 		pos = blocklights;
 		for (t = 0; t < tmax; t++)
 		{
@@ -167,13 +174,14 @@ Combine and scale multiple lightmaps into the 8.8 format in blocklights
 static void R_BuildLightMap (void)
 {
 	int		smax, tmax;
-	int		t;
 	int		i, size;
 	byte		*lightmap;
 	unsigned int	scale;
 	int		maps;
 	msurface_t	*surf;
 	int		light;
+	byte		*cache;
+	qboolean	fill;
 
 	surf = r_drawsurf.surf;
 
@@ -197,6 +205,21 @@ static void R_BuildLightMap (void)
 		return;
 	}
 
+// see if this combination of styles was built before
+	cache = NULL;
+	if (lightmap && surf->dlightframe != r_framecount)
+	{
+		for (maps = 0 ; maps < MAXLIGHTMAPS && surf->styles[maps] != 255 ; maps++)
+			;
+		cache = LM_CacheBlock (surf, r_drawsurf.lightadj, maps, r_refdef.ambientlight,
+					size * sizeof(blocklights[0]), &fill);
+		if (cache && !fill)
+		{
+			memcpy (blocklights, cache, size * sizeof(blocklights[0]));
+			return;
+		}
+	}
+
 // clear to ambient
 	for (i = 0; i < size; i++)
 		blocklights[i] = r_refdef.ambientlight<<8;
@@ -207,8 +230,7 @@ static void R_BuildLightMap (void)
 		for (maps = 0 ; maps < MAXLIGHTMAPS && surf->styles[maps] != 255 ; maps++)
 		{
 			scale = r_drawsurf.lightadj[maps];	// 8.8 fraction
-			for (i = 0; i < size; i++)
-				blocklights[i] += lightmap[i] * scale;
+			r_surfk->addlightmap (blocklights, lightmap, scale, size);
 			lightmap += size;	// skip to next lightmap
 		}
 	}
@@ -218,15 +240,10 @@ static void R_BuildLightMap (void)
 		R_AddDynamicLights ();
 
 // bound, invert, and shift
-	for (i = 0; i < size; i++)
-	{
-		t = (255*256 - (int)blocklights[i]) >> (8 - VID_CBITS);
-
-		if (t < (1 << 6))
-			t = (1 << 6);
+	r_surfk->finishlights (blocklights, size);
 
-		blocklights[i] = t;
-	}
+	if (cache)
+		memcpy (cache, blocklights, size * sizeof(blocklights[0]));
 }
 
 
@@ -366,8 +383,8 @@ R_DrawSurfaceBlock8_mip0
 */
 static void R_DrawSurfaceBlock8_mip0 (void)
 {
-	int		v, i, b, lightstep, lighttemp, light;
-	unsigned char	pix, *psource, *prowdest;
+	int		v, i, lightstep, lighttemp;
+	unsigned char	*psource, *prowdest;
 
 	psource = pbasesource;
 	prowdest = (unsigned char *) prowdestbase;
@@ -387,14 +404,8 @@ static void R_DrawSurfaceBlock8_mip0 (void)
 			lighttemp = lightleft - lightright;
 			lightstep = lighttemp >> 4;
 
-			light = lightright;
-
-			for (b = 15; b >= 0; b--)
-			{
-				pix = psource[b];
-				prowdest[b] = ((unsigned char *)vid.colormap)[(light & 0xFF00) + pix];
-				light += lightstep;
-			}
+			r_surfk->blockrow (prowdest, psource, (byte *)vid.colormap,
+						lightright, lightstep, 16);
 
 			psource += sourcetstep;
 			lightright += lightrightstep;
@@ -415,8 +426,8 @@ R_DrawSurfaceBlock8_mip1
 */
 static void R_DrawSurfaceBlock8_mip1 (void)
 {
-	int		v, i, b, lightstep, lighttemp, light;
-	unsigned char	pix, *psource, *prowdest;
+	int		v, i, lightstep, lighttemp;
+	unsigned char	*psource, *prowdest;
 
 	psource = pbasesource;
 	prowdest = (unsigned char *) prowdestbase;
@@ -436,14 +447,8 @@ static void R_DrawSurfaceBlock8_mip1 (void)
 			lighttemp = lightleft - lightright;
 			lightstep = lighttemp >> 3;
 
-			light = lightright;
-
-			for (b = 7; b >= 0; b--)
-			{
-				pix = psource[b];
-				prowdest[b] = ((unsigned char *)vid.colormap)[(light & 0xFF00) + pix];
-				light += lightstep;
-			}
+			r_surfk->blockrow (prowdest, psource, (byte *)vid.colormap,
+						lightright, lightstep, 8);
 
 			psource += sourcetstep;
 			lightright += lightrightstep;
@@ -464,8 +469,8 @@ R_DrawSurfaceBlock8_mip2
 */
 static void R_DrawSurfaceBlock8_mip2 (void)
 {
-	int		v, i, b, lightstep, lighttemp, light;
-	unsigned char	pix, *psource, *prowdest;
+	int		v, i, lightstep, lighttemp;
+	unsigned char	*psource, *prowdest;
 
 	psource = pbasesource;
 	prowdest = (unsigned char *) prowdestbase;
@@ -485,14 +490,8 @@ static void R_DrawSurfaceBlock8_mip2 (void)
 			lighttemp = lightleft - lightright;
 			lightstep = lighttemp >> 2;
 
-			light = lightright;
-
-			for (b = 3; b >= 0; b--)
-			{
-				pix = psource[b];
-				prowdest[b] = ((unsigned char *)vid.colormap)[(light & 0xFF00) + pix];
-				light += lightstep;
-			}
+			r_surfk->blockrow (prowdest, psource, (byte *)vid.colormap,
+						lightright, lightstep, 4);
 
 			psource += sourcetstep;
 			lightright += lightrightstep;
@@ -513,8 +512,8 @@ R_DrawSurfaceBlock8_mip3
 */
 static void R_DrawSurfaceBlock8_mip3 (void)
 {
-	int		v, i, b, lightstep, lighttemp, light;
-	unsigned char	pix, *psource, *prowdest;
+	int		v, i, lightstep, lighttemp;
+	unsigned char	*psource, *prowdest;
 
 	psource = pbasesource;
 	prowdest = (unsigned char *) prowdestbase;
@@ -534,14 +533,8 @@ static void R_DrawSurfaceBlock8_mip3 (void)
 			lighttemp = lightleft - lightright;
 			lightstep = lighttemp >> 1;
 
-			light = lightright;
-
-			for (b = 1; b >= 0; b--)
-			{
-				pix = psource[b];
-				prowdest[b] = ((unsigned char *)vid.colormap)[(light & 0xFF00) + pix];
-				light += lightstep;
-			}
+			r_surfk->blockrow (prowdest, psource, (byte *)vid.colormap,
+						lightright, lightstep, 2);
 
 			psource += sourcetstep;
 			lightright += lightrightstep;
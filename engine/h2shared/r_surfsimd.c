@@ -0,0 +1,533 @@
+/* r_surfsimd.c -- lightmap building and surface block kernels
+ *
+ * The inner loops of R_BuildLightMap, R_AddDynamicLights and the C
+ * R_DrawSurfaceBlock8 drawers, in plain C and in SSE4.1, AVX2 and NEON
+ * versions.  They all give the same results to the bit: the x86 ones
+ * are picked at run time from the cpu features, r_surfcheck compares
+ * them against the C ones.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "r_local.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define	SURF_X86	1
+#include <immintrin.h>
+#else
+#define	SURF_X86	0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define	SURF_NEON	1
+#include <arm_neon.h>
+#else
+#define	SURF_NEON	0
+#endif
+
+static cvar_t	r_surfkernels = {"r_surfkernels", "auto", CVAR_ARCHIVE};
+
+const surfkernels_t	*r_surfk;
+
+
+/*
+==============================================================================
+
+C VERSIONS
+
+==============================================================================
+*/
+
+static void R_AddLightmap_C (unsigned int *blocklights, const byte *lightmap, unsigned int scale, int size)
+{
+	int		i;
+
+	for (i = 0; i < size; i++)
+		blocklights[i] += lightmap[i] * scale;
+}
+
+static inline void R_DynamicLightSample (unsigned int *pos, int s, int td,
+				float local0, float rad, float minlight)
+{
+	int		sd;
+	float		dist;
+
+	sd = local0 - s*16;
+	if (sd < 0)
+		sd = -sd;
+	if (sd > td)
+		dist = sd + (td>>1);
+	else
+		dist = td + (sd>>1);
+	if (dist < minlight)
+	{
+		unsigned int	temp;
+		temp = (rad - dist)*256;
+		*pos += temp;
+	}
+}
+
+static void R_AddDynamicLight_C (unsigned int *blocklights, int smax, int tmax,
+				float local0, float local1, float rad, float minlight)
+{
+	int		s, t, td;
+	unsigned int	*pos;
+
+	pos = blocklights;
+	for (t = 0; t < tmax; t++)
+	{
+		td = local1 - t*16;
+		if (td < 0)
+			td = -td;
+		for (s = 0; s < smax; s++, pos++)
+			R_DynamicLightSample (pos, s, td, local0, rad, minlight);
+	}
+}
+
+static void R_FinishLights_C (unsigned int *blocklights, int size)
+{
+	int		i, t;
+
+	for (i = 0; i < size; i++)
+	{
+		t = (255*256 - (int)blocklights[i]) >> (8 - VID_CBITS);
+
+		if (t < (1 << 6))
+			t = (1 << 6);
+
+		blocklights[i] = t;
+	}
+}
+
+static void R_SurfaceBlockRow_C (byte *prowdest, const byte *psource, const byte *colormap,
+				int light, int lightstep, int count)
+{
+	int		b;
+
+	for (b = count - 1; b >= 0; b--)
+	{
+		prowdest[b] = colormap[(light & 0xFF00) + psource[b]];
+		light += lightstep;
+	}
+}
+
+
+#if SURF_X86
+/*
+==============================================================================
+
+SSE4.1 VERSIONS
+
+==============================================================================
+*/
+
+__attribute__((__target__("sse4.1")))
+static void R_AddLightmap_SSE41 (unsigned int *blocklights, const byte *lightmap, unsigned int scale, int size)
+{
+	__m128i		vscale, v;
+	int		i;
+
+	vscale = _mm_set1_epi32 (scale);
+	for (i = 0; i + 4 <= size; i += 4)
+	{
+		v = _mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (*(const int *)(lightmap + i)));
+		v = _mm_add_epi32 (_mm_loadu_si128 ((__m128i *)(blocklights + i)), _mm_mullo_epi32 (v, vscale));
+		_mm_storeu_si128 ((__m128i *)(blocklights + i), v);
+	}
+	for ( ; i < size; i++)
+		blocklights[i] += lightmap[i] * scale;
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_AddDynamicLight_SSE41 (unsigned int *blocklights, int smax, int tmax,
+				float local0, float local1, float rad, float minlight)
+{
+	__m128i		ramp, vtd, sd, dist, lit;
+	__m128		vdist;
+	int		s, t, td;
+	unsigned int	*pos;
+
+	ramp = _mm_setr_epi32 (0, 16, 32, 48);
+	pos = blocklights;
+	for (t = 0; t < tmax; t++)
+	{
+		td = local1 - t*16;
+		if (td < 0)
+			td = -td;
+		vtd = _mm_set1_epi32 (td);
+		for (s = 0; s + 4 <= smax; s += 4, pos += 4)
+		{
+			sd = _mm_add_epi32 (_mm_set1_epi32 (s*16), ramp);
+			sd = _mm_cvttps_epi32 (_mm_sub_ps (_mm_set1_ps (local0), _mm_cvtepi32_ps (sd)));
+			sd = _mm_abs_epi32 (sd);
+		// the larger distance plus half the smaller
+			dist = _mm_add_epi32 (_mm_max_epi32 (sd, vtd), _mm_srai_epi32 (_mm_min_epi32 (sd, vtd), 1));
+			vdist = _mm_cvtepi32_ps (dist);
+			lit = _mm_cvttps_epi32 (_mm_mul_ps (_mm_sub_ps (_mm_set1_ps (rad), vdist), _mm_set1_ps (256)));
+			lit = _mm_and_si128 (lit, _mm_castps_si128 (_mm_cmplt_ps (vdist, _mm_set1_ps (minlight))));
+			_mm_storeu_si128 ((__m128i *)pos, _mm_add_epi32 (_mm_loadu_si128 ((__m128i *)pos), lit));
+		}
+		for ( ; s < smax; s++, pos++)
+			R_DynamicLightSample (pos, s, td, local0, rad, minlight);
+	}
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_FinishLights_SSE41 (unsigned int *blocklights, int size)
+{
+	__m128i		v;
+	int		i;
+
+	for (i = 0; i + 4 <= size; i += 4)
+	{
+		v = _mm_sub_epi32 (_mm_set1_epi32 (255*256), _mm_loadu_si128 ((__m128i *)(blocklights + i)));
+		v = _mm_max_epi32 (_mm_srai_epi32 (v, 8 - VID_CBITS), _mm_set1_epi32 (1 << 6));
+		_mm_storeu_si128 ((__m128i *)(blocklights + i), v);
+	}
+	R_FinishLights_C (blocklights + i, size - i);
+}
+
+__attribute__((__target__("sse4.1")))
+static void R_SurfaceBlockRow_SSE41 (byte *prowdest, const byte *psource, const byte *colormap,
+				int light, int lightstep, int count)
+{
+	__m128i		ramp, vlight, idx, pix;
+	int		index[4];
+	int		b;
+
+	if (count & 3)
+	{
+		R_SurfaceBlockRow_C (prowdest, psource, colormap, light, lightstep, count);
+		return;
+	}
+
+// pixel b gets the light stepped count-1-b times from lightright
+	ramp = _mm_setr_epi32 (count - 1, count - 2, count - 3, count - 4);
+	for (b = 0; b < count; b += 4)
+	{
+		vlight = _mm_add_epi32 (_mm_set1_epi32 (light),
+				_mm_mullo_epi32 (_mm_sub_epi32 (ramp, _mm_set1_epi32 (b)), _mm_set1_epi32 (lightstep)));
+		idx = _mm_and_si128 (vlight, _mm_set1_epi32 (0xFF00));
+		idx = _mm_add_epi32 (idx, _mm_cvtepu8_epi32 (_mm_cvtsi32_si128 (*(const int *)(psource + b))));
+		_mm_storeu_si128 ((__m128i *)index, idx);
+		pix = _mm_cvtsi32_si128 (colormap[index[0]]);
+		pix = _mm_insert_epi8 (pix, colormap[index[1]], 1);
+		pix = _mm_insert_epi8 (pix, colormap[index[2]], 2);
+		pix = _mm_insert_epi8 (pix, colormap[index[3]], 3);
+		*(int *)(prowdest + b) = _mm_cvtsi128_si32 (pix);
+	}
+}
+
+
+/*
+==============================================================================
+
+AVX2 VERSIONS
+
+==============================================================================
+*/
+
+__attribute__((__target__("avx2")))
+static void R_AddLightmap_AVX2 (unsigned int *blocklights, const byte *lightmap, unsigned int scale, int size)
+{
+	__m256i		vscale, v;
+	int		i;
+
+	vscale = _mm256_set1_epi32 (scale);
+	for (i = 0; i + 8 <= size; i += 8)
+	{
+		v = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)(lightmap + i)));
+		v = _mm256_add_epi32 (_mm256_loadu_si256 ((__m256i *)(blocklights + i)), _mm256_mullo_epi32 (v, vscale));
+		_mm256_storeu_si256 ((__m256i *)(blocklights + i), v);
+	}
+	R_AddLightmap_C (blocklights + i, lightmap + i, scale, size - i);
+}
+
+__attribute__((__target__("avx2")))
+static void R_AddDynamicLight_AVX2 (unsigned int *blocklights, int smax, int tmax,
+				float local0, float local1, float rad, float minlight)
+{
+	__m256i		ramp, vtd, sd, dist, lit;
+	__m256		vdist;
+	int		s, t, td;
+	unsigned int	*pos;
+
+	ramp = _mm256_setr_epi32 (0, 16, 32, 48, 64, 80, 96, 112);
+	pos = blocklights;
+	for (t = 0; t < tmax; t++)
+	{
+		td = local1 - t*16;
+		if (td < 0)
+			td = -td;
+		vtd = _mm256_set1_epi32 (td);
+		for (s = 0; s + 8 <= smax; s += 8, pos += 8)
+		{
+			sd = _mm256_add_epi32 (_mm256_set1_epi32 (s*16), ramp);
+			sd = _mm256_cvttps_epi32 (_mm256_sub_ps (_mm256_set1_ps (local0), _mm256_cvtepi32_ps (sd)));
+			sd = _mm256_abs_epi32 (sd);
+			dist = _mm256_add_epi32 (_mm256_max_epi32 (sd, vtd), _mm256_srai_epi32 (_mm256_min_epi32 (sd, vtd), 1));
+			vdist = _mm256_cvtepi32_ps (dist);
+			lit = _mm256_cvttps_epi32 (_mm256_mul_ps (_mm256_sub_ps (_mm256_set1_ps (rad), vdist), _mm256_set1_ps (256)));
+			lit = _mm256_and_si256 (lit, _mm256_castps_si256 (_mm256_cmp_ps (vdist, _mm256_set1_ps (minlight), _CMP_LT_OQ)));
+			_mm256_storeu_si256 ((__m256i *)pos, _mm256_add_epi32 (_mm256_loadu_si256 ((__m256i *)pos), lit));
+		}
+		for ( ; s < smax; s++, pos++)
+			R_DynamicLightSample (pos, s, td, local0, rad, minlight);
+	}
+}
+
+__attribute__((__target__("avx2")))
+static void R_FinishLights_AVX2 (unsigned int *blocklights, int size)
+{
+	__m256i		v;
+	int		i;
+
+	for (i = 0; i + 8 <= size; i += 8)
+	{
+		v = _mm256_sub_epi32 (_mm256_set1_epi32 (255*256), _mm256_loadu_si256 ((__m256i *)(blocklights + i)));
+		v = _mm256_max_epi32 (_mm256_srai_epi32 (v, 8 - VID_CBITS), _mm256_set1_epi32 (1 << 6));
+		_mm256_storeu_si256 ((__m256i *)(blocklights + i), v);
+	}
+	R_FinishLights_C (blocklights + i, size - i);
+}
+
+/* the colormap lookups are one dword gather: the colormap is at most
+   read 3 bytes past index 16383, which is still inside the hunk block
+   of colormap.lmp (16385 bytes plus the NUL, rounded up to 16). */
+__attribute__((__target__("avx2")))
+static void R_SurfaceBlockRow_AVX2 (byte *prowdest, const byte *psource, const byte *colormap,
+				int light, int lightstep, int count)
+{
+	const __m256i	pack8 = _mm256_setr_epi8 (
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m256i		ramp, vlight, idx, pix;
+	int		b;
+
+	if (count & 7)
+	{
+		R_SurfaceBlockRow_C (prowdest, psource, colormap, light, lightstep, count);
+		return;
+	}
+
+	ramp = _mm256_setr_epi32 (count - 1, count - 2, count - 3, count - 4,
+				  count - 5, count - 6, count - 7, count - 8);
+	for (b = 0; b < count; b += 8)
+	{
+		vlight = _mm256_add_epi32 (_mm256_set1_epi32 (light),
+				_mm256_mullo_epi32 (_mm256_sub_epi32 (ramp, _mm256_set1_epi32 (b)), _mm256_set1_epi32 (lightstep)));
+		idx = _mm256_and_si256 (vlight, _mm256_set1_epi32 (0xFF00));
+		idx = _mm256_add_epi32 (idx, _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)(psource + b))));
+		pix = _mm256_i32gather_epi32 ((const int *)colormap, idx, 1);
+		pix = _mm256_shuffle_epi8 (pix, pack8);
+		pix = _mm256_permutevar8x32_epi32 (pix, _mm256_setr_epi32 (0, 4, 0, 0, 0, 0, 0, 0));
+		_mm_storel_epi64 ((__m128i *)(prowdest + b), _mm256_castsi256_si128 (pix));
+	}
+}
+#endif	/* SURF_X86 */
+
+
+#if SURF_NEON
+/*
+==============================================================================
+
+NEON VERSIONS
+
+==============================================================================
+*/
+
+static void R_AddLightmap_NEON (unsigned int *blocklights, const byte *lightmap, unsigned int scale, int size)
+{
+	uint16x8_t	v;
+	int		i;
+
+	for (i = 0; i + 8 <= size; i += 8)
+	{
+		v = vmovl_u8 (vld1_u8 (lightmap + i));
+		vst1q_u32 (blocklights + i, vmlaq_n_u32 (vld1q_u32 (blocklights + i), vmovl_u16 (vget_low_u16 (v)), scale));
+		vst1q_u32 (blocklights + i + 4, vmlaq_n_u32 (vld1q_u32 (blocklights + i + 4), vmovl_u16 (vget_high_u16 (v)), scale));
+	}
+	R_AddLightmap_C (blocklights + i, lightmap + i, scale, size - i);
+}
+
+static void R_FinishLights_NEON (unsigned int *blocklights, int size)
+{
+	int32x4_t	v;
+	int		i;
+
+	for (i = 0; i + 4 <= size; i += 4)
+	{
+		v = vsubq_s32 (vdupq_n_s32 (255*256), vreinterpretq_s32_u32 (vld1q_u32 (blocklights + i)));
+		v = vmaxq_s32 (vshrq_n_s32 (v, 8 - VID_CBITS), vdupq_n_s32 (1 << 6));
+		vst1q_u32 (blocklights + i, vreinterpretq_u32_s32 (v));
+	}
+	R_FinishLights_C (blocklights + i, size - i);
+}
+#endif	/* SURF_NEON */
+
+
+static surfkernels_t	surfkernels[] =
+{
+	{ "c",		R_AddLightmap_C,	R_AddDynamicLight_C,	R_FinishLights_C,	R_SurfaceBlockRow_C	},
+#if SURF_X86
+	{ "sse4.1",	R_AddLightmap_SSE41,	R_AddDynamicLight_SSE41, R_FinishLights_SSE41,	R_SurfaceBlockRow_SSE41	},
+	{ "avx2",	R_AddLightmap_AVX2,	R_AddDynamicLight_AVX2,	R_FinishLights_AVX2,	R_SurfaceBlockRow_AVX2	},
+#endif
+#if SURF_NEON
+	{ "neon",	R_AddLightmap_NEON,	R_AddDynamicLight_C,	R_FinishLights_NEON,	R_SurfaceBlockRow_C	},
+#endif
+	{ NULL,		NULL,			NULL,			NULL,			NULL			}
+};
+
+/*
+==============
+R_SurfKernelList
+
+The kernel sets that this cpu can run, slowest first
+==============
+*/
+static const surfkernels_t *R_SurfKernelList (void)
+{
+	static qboolean	checked = false;
+	int		i, j;
+
+	if (checked)
+		return surfkernels;
+	checked = true;
+
+#if SURF_X86
+	__builtin_cpu_init ();
+#endif
+	for (i = j = 0; surfkernels[i].name; i++)
+	{
+#if SURF_X86
+		if (surfkernels[i].addlightmap == R_AddLightmap_SSE41 && !__builtin_cpu_supports ("sse4.1"))
+			continue;
+		if (surfkernels[i].addlightmap == R_AddLightmap_AVX2 && !__builtin_cpu_supports ("avx2"))
+			continue;
+#endif
+		surfkernels[j++] = surfkernels[i];
+	}
+	surfkernels[j] = surfkernels[i];
+
+	return surfkernels;
+}
+
+static void R_SurfKernels_f (cvar_t *var)
+{
+	const surfkernels_t	*k, *fastest;
+
+	fastest = NULL;
+	for (k = R_SurfKernelList (); k->name; k++)
+	{
+		if (!q_strcasecmp(var->string, k->name))
+			break;
+		fastest = k;
+	}
+	if (!k->name)
+	{
+		if (q_strcasecmp(var->string, "auto"))
+			Con_Printf ("Unknown surface kernels \"%s\", using %s\n", var->string, fastest->name);
+		k = fastest;
+	}
+
+	r_surfk = k;
+}
+
+
+/*
+==============
+R_SurfCheck_f
+
+Runs every kernel set on random lightmaps, lights and texture
+rows and counts the results that differ from the C kernels.
+==============
+*/
+static void R_SurfCheck_f (void)
+{
+	const surfkernels_t	*k, *c;
+	unsigned int	ref[18*18], out[18*18];
+	byte		lightmap[18*18], source[16], colormap[64*256 + 16];
+	byte		refrow[16], outrow[16];
+	int		i, iter, size, smax, tmax, light, step, count, diffs;
+	float		local0, local1, rad, minlight;
+
+	c = R_SurfKernelList ();
+	for (i = 0; i < (int)sizeof(colormap); i++)
+		colormap[i] = rand() & 0xff;
+
+	for (k = c + 1; k->name; k++)
+	{
+		diffs = 0;
+		for (iter = 0; iter < 2000; iter++)
+		{
+			smax = 1 + rand() % 18;
+			tmax = 1 + rand() % 18;
+			size = smax * tmax;
+			for (i = 0; i < size; i++)
+			{
+				ref[i] = out[i] = (rand() & 0xff) << 8;
+				lightmap[i] = rand() & 0xff;
+			}
+
+			i = rand() & 0x3ff;
+			c->addlightmap (ref, lightmap, i, size);
+			k->addlightmap (out, lightmap, i, size);
+
+			local0 = (rand() % 8000) / 10.0 - 200;
+			local1 = (rand() % 8000) / 10.0 - 200;
+			rad = (rand() % 5000) / 10.0;
+			minlight = rad - (rand() % 640) / 10.0;
+			c->adddlight (ref, smax, tmax, local0, local1, rad, minlight);
+			k->adddlight (out, smax, tmax, local0, local1, rad, minlight);
+
+			c->finishlights (ref, size);
+			k->finishlights (out, size);
+			if (memcmp (ref, out, size * sizeof(unsigned int)))
+				diffs++;
+
+		// light and step as R_DrawSurfaceBlock8 would get them
+			count = 16 >> (rand() & 3);
+			light = ref[0];
+			step = ((int)ref[size - 1] - (int)ref[0]) / count;
+			for (i = 0; i < count; i++)
+				source[i] = rand() & 0xff;
+			c->blockrow (refrow, source, colormap, light, step, count);
+			k->blockrow (outrow, source, colormap, light, step, count);
+			if (memcmp (refrow, outrow, count))
+				diffs++;
+		}
+		Con_Printf ("%-8s %d of %d results differ\n", k->name, diffs, iter * 2);
+	}
+	Con_Printf ("using %s\n", r_surfk->name);
+}
+
+
+/*
+==============
+R_InitSurfKernels
+==============
+*/
+void R_InitSurfKernels (void)
+{
+	Cvar_RegisterVariable (&r_surfkernels);
+	Cvar_SetCallback (&r_surfkernels, R_SurfKernels_f);
+	R_SurfKernels_f (&r_surfkernels);
+
+	Cmd_AddCommand ("r_surfcheck", R_SurfCheck_f);
+}
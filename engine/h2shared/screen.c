@@ -1277,6 +1277,7 @@ needs almost the entire 256k of stack space!
 void SCR_UpdateScreen (void)
 {
 	vrect_t		vrect;
+	double		time1 = 0;
 
 	if (scr_skipupdate || block_drawing)
 		return;
@@ -1363,7 +1364,11 @@ void SCR_UpdateScreen (void)
 #endif
 	{
 		VID_LockBuffer ();
+		if (cls.timedemo)
+			time1 = Sys_DoubleTime ();
 		V_RenderView ();
+		if (cls.timedemo)
+			CL_TimeDemoPhase (tdphase_world, Sys_DoubleTime () - time1);
 		VID_UnlockBuffer ();
 	}
 
@@ -1409,6 +1414,7 @@ void SCR_UpdateScreen (void)
 		SCR_CheckDrawCenterString();
 		Sbar_Draw();
 		SCR_DrawFPS();
+		D_DrawSurfCacheStats();
 
 		Plaque_Draw(plaquemessage, false);
 		SCR_DrawConsole();
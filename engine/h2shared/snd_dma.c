@@ -26,6 +26,7 @@
 #include "snd_sys.h"
 #include "snd_codec.h"
 #include "bgmusic.h"
+#include "threads.h"
 
 static snd_driver_t	*qsnd_driver;
 
@@ -78,6 +79,18 @@ static hashindex_t	hash_sfx;
 
 static sfx_t	*ambient_sfx[NUM_AMBIENTS];
 
+// sounds queued between S_BeginPrecaching and S_EndPrecaching
+typedef struct
+{
+	sfx_t		*sfx;
+	sfxcache_t	*sc;
+	int		size;
+} sfxdecode_t;
+
+static sfxdecode_t	s_decode[MAX_SFX];
+static int	s_numdecode;
+static qboolean	s_deferprecache;
+
 static qboolean	sound_started = false;
 
 int		desired_speed = 22050;
@@ -419,7 +432,12 @@ sfx_t *S_PrecacheSound (const char *name)
 	sfx = S_FindName (name);
 
 // cache it in
-	if (precache.integer)
+	if (s_deferprecache)
+	{
+		if (!Cache_Check(&sfx->cache) && s_numdecode < MAX_SFX)
+			s_decode[s_numdecode++].sfx = sfx;
+	}
+	else if (precache.integer)
 		S_LoadSound (sfx);
 
 	return sfx;
@@ -667,6 +685,18 @@ void S_StopAllSounds (qboolean clear)
 		S_ClearBuffer ();
 }
 
+/* S_StopAllSounds (true) for a client that skipped ahead in a demo:
+ * the static sounds are kept, they only come with the signon.
+ */
+void S_StopDynamicSounds (void)
+{
+	if (!sound_started)
+		return;
+
+	memset(snd_channels, 0, (MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS) * sizeof(channel_t));
+	S_ClearBuffer ();
+}
+
 static void S_StopAllSoundsC (void)
 {
 	S_StopAllSounds (true);
@@ -1216,12 +1246,63 @@ void S_ClearPrecache (void)
 }
 
 
+/*
+==================
+S_BeginPrecaching
+
+Until S_EndPrecaching, S_PrecacheSound only queues the sounds which
+aren't in the cache, so that they can be decoded on all threads.
+==================
+*/
 void S_BeginPrecaching (void)
 {
+	s_numdecode = 0;
+	s_deferprecache = (sound_started && !nosound.integer && precache.integer);
 }
 
+static void S_DecodeWork (void *data, int work)
+{
+	sfxdecode_t	*d = (sfxdecode_t *)data + work;
 
+	d->sc = S_DecodeSound (d->sfx->name, &d->size);
+}
+
+/*
+==================
+S_EndPrecaching
+
+Decodes the queued sounds in parallel, then moves them into the
+cache one at a time.  Whatever failed to decode goes through the
+usual S_LoadSound path so that the reason gets printed.
+==================
+*/
 void S_EndPrecaching (void)
 {
+	sfxcache_t	*sc;
+	int		i;
+
+	if (!s_deferprecache)
+		return;
+	s_deferprecache = false;
+
+	Thread_Run (S_DecodeWork, s_decode, s_numdecode);
+
+	for (i = 0; i < s_numdecode; i++)
+	{
+		if (!s_decode[i].sc)
+		{
+			S_LoadSound (s_decode[i].sfx);
+			continue;
+		}
+		if (!Cache_Check(&s_decode[i].sfx->cache))
+		{
+			sc = (sfxcache_t *) Cache_Alloc (&s_decode[i].sfx->cache, s_decode[i].size, s_decode[i].sfx->name);
+			if (sc)
+				memcpy (sc, s_decode[i].sc, s_decode[i].size);
+		}
+		free (s_decode[i].sc);
+		s_decode[i].sc = NULL;
+	}
+	s_numdecode = 0;
 }
 
@@ -79,6 +79,10 @@ void S_StopAllSounds (qboolean clear)
 {
 }
 
+void S_StopDynamicSounds (void)
+{
+}
+
 void S_BeginPrecaching (void)
 {
 }
@@ -26,6 +26,7 @@
  */
 
 #include "quakedef.h"
+#include "pvscache.h"
 
 static qmodel_t*	loadmodel;
 static char	loadname[MAX_QPATH];	/* for hunk tags */
@@ -35,7 +36,7 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash);
 
 static cvar_t	external_ents = {"external_ents", "1", CVAR_ARCHIVE};
 
-static byte	mod_novis[MAX_MAP_LEAFS/8];
+static unsigned int	mod_novis[(MAX_MAP_LEAFS+31)/32];
 static int	*surfedges;
 static medge_t	*edges;
 
@@ -54,6 +55,7 @@ void Mod_Init (void)
 	Cvar_RegisterVariable (&external_ents);
 
 	memset (mod_novis, 0xff, sizeof(mod_novis));
+	PVS_InitCache ();
 }
 
 /*
@@ -84,9 +86,8 @@ mleaf_t *Mod_PointInLeaf (vec3_t p, qmodel_t *model)
 Mod_DecompressVis
 ===================
 */
-static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
+static byte *Mod_DecompressVis (byte *in, qmodel_t *model, byte *decompressed)
 {
-	static byte	decompressed[MAX_MAP_LEAFS/8];
 	int		c;
 	byte	*out;
 	int		row;
@@ -94,16 +95,6 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 	row = (model->numleafs+7)>>3;
 	out = decompressed;
 
-	if (!in)
-	{	// no vis info, so make all visible
-		while (row)
-		{
-			*out++ = 0xff;
-			row--;
-		}
-		return decompressed;
-	}
-
 	do
 	{
 		if (*in)
@@ -114,6 +105,8 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 
 		c = in[1];
 		in += 2;
+		if (c > row - (out - decompressed))	// don't run into the next cached row
+			c = row - (out - decompressed);
 		while (c)
 		{
 			*out++ = 0;
@@ -124,11 +117,28 @@ static byte *Mod_DecompressVis (byte *in, qmodel_t *model)
 	return decompressed;
 }
 
+/*
+===================
+Mod_LeafPVS
+
+The rows come from the pvs cache, padded to whole words.
+===================
+*/
 byte *Mod_LeafPVS (mleaf_t *leaf, qmodel_t *model)
 {
-	if (leaf == model->leafs)
-		return mod_novis;
-	return Mod_DecompressVis (leaf->compressed_vis, model);
+	static unsigned int	decompressed[(MAX_MAP_LEAFS+31)/32];
+	byte		*row;
+	qboolean	fill;
+
+	if (leaf == model->leafs || !leaf->compressed_vis)
+		return (byte *)mod_novis;	// no vis info, so make all visible
+
+	row = PVS_CacheRow (model->visdata, model->numleafs + 1, leaf - model->leafs, &fill);
+	if (!row)
+		return Mod_DecompressVis (leaf->compressed_vis, model, (byte *)decompressed);
+	if (fill)
+		Mod_DecompressVis (leaf->compressed_vis, model, row);
+	return row;
 }
 
 /*
@@ -276,6 +286,7 @@ Mod_LoadVisibility
 */
 static void Mod_LoadVisibility (lump_t *l)
 {
+	PVS_FlushCache ();	// the hunk may hand out the old address again
 	if (!l->filelen)
 	{
 		loadmodel->visdata = NULL;
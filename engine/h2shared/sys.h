@@ -144,6 +144,18 @@ char *Sys_GetClipboardData (void);
 #	define	ASM_LINKAGE_END
 #endif
 
+/* the C span drawers of the software renderer keep their per-surface
+   state in globals: those are thread local where D_DrawSurfaces () can
+   hand the span drawing to worker threads. the asm drawers address
+   them directly, so asm builds always draw on the main thread. */
+#if defined(USE_PTHREADS) && !id386 && !id68k
+#	define	USE_SPANTHREADS		1
+#	define	SPAN_THREADVAR		__thread
+#else
+#	define	USE_SPANTHREADS		0
+#	define	SPAN_THREADVAR
+#endif
+
 #if id386 /* fpu stuff with x86 asm */
 ASM_LINKAGE_BEGIN
 void	MaskExceptions (void);
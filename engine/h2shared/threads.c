@@ -0,0 +1,315 @@
+/* threads.c -- worker threads for parallel engine jobs
+ *
+ * The pthreads version keeps a pool of workers sleeping on a condition
+ * variable between jobs, so that it is cheap enough to use every frame.
+ * The Windows version starts its workers for each job.  Everything else
+ * (DOS, Amiga, OS/2 or a build without USE_PTHREADS) runs the work items
+ * in order on the calling thread.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "threads.h"
+
+#if defined(USE_PTHREADS)
+#include <pthread.h>
+#include <unistd.h>
+#elif defined(PLATFORM_WINDOWS)
+#include <windows.h>
+#include <process.h>
+#endif
+
+static int		numthreads = 1;
+
+static threadwork_t	job_func;
+static void		*job_data;
+static int		job_count;
+
+
+static int Thread_GetNumCPUS (void)
+{
+#if defined(USE_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+	int numcpus = sysconf(_SC_NPROCESSORS_ONLN);
+	return (numcpus < 1) ? 1 : numcpus;
+#elif defined(PLATFORM_WINDOWS)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors < 1) ? 1 : (int)info.dwNumberOfProcessors;
+#else
+	return 1;
+#endif
+}
+
+int Thread_Count (void)
+{
+	return numthreads;
+}
+
+
+#if defined(USE_PTHREADS)
+
+static pthread_t	work_threads[MAX_THREADS];
+static pthread_mutex_t	lock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t	job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	done_cond = PTHREAD_COND_INITIALIZER;
+static int		job_generation;
+static int		job_next;
+static int		job_busy;
+static qboolean		job_quit;
+
+void Thread_Lock (void)
+{
+	if (numthreads > 1)
+		pthread_mutex_lock (&lock_mutex);
+}
+
+void Thread_Unlock (void)
+{
+	if (numthreads > 1)
+		pthread_mutex_unlock (&lock_mutex);
+}
+
+/* takes work items until there are none left.
+ * called and returns with job_mutex held. */
+static void Thread_DoWork (void)
+{
+	int	work;
+
+	while (job_next < job_count)
+	{
+		work = job_next++;
+		pthread_mutex_unlock (&job_mutex);
+		job_func (job_data, work);
+		pthread_mutex_lock (&job_mutex);
+	}
+}
+
+static void *Thread_Worker (void *unused)
+{
+	int	seen = 0;
+
+	pthread_mutex_lock (&job_mutex);
+	while (1)
+	{
+		while (seen == job_generation && !job_quit)
+			pthread_cond_wait (&job_cond, &job_mutex);
+		if (job_quit)
+			break;
+		seen = job_generation;
+		job_busy++;
+		Thread_DoWork ();
+		if (--job_busy == 0)
+			pthread_cond_signal (&done_cond);
+	}
+	pthread_mutex_unlock (&job_mutex);
+
+	return NULL;
+}
+
+void Thread_Run (threadwork_t func, void *data, int workcnt)
+{
+	int	i;
+
+	if (numthreads <= 1 || workcnt <= 1)
+	{
+		for (i = 0; i < workcnt; i++)
+			func (data, i);
+		return;
+	}
+
+	pthread_mutex_lock (&job_mutex);
+	job_func = func;
+	job_data = data;
+	job_count = workcnt;
+	job_next = 0;
+	job_generation++;
+	pthread_cond_broadcast (&job_cond);
+
+	Thread_DoWork ();
+	while (job_busy > 0)
+		pthread_cond_wait (&done_cond, &job_mutex);
+	pthread_mutex_unlock (&job_mutex);
+}
+
+static qboolean Thread_StartWorkers (void)
+{
+	int	i;
+
+	for (i = 0; i < numthreads - 1; i++)
+	{
+		if (pthread_create (&work_threads[i], NULL, Thread_Worker, NULL) != 0)
+		{
+			Con_Printf ("%s: pthread_create failed\n", __thisfunc__);
+			numthreads = i + 1;
+			break;
+		}
+	}
+
+	return true;
+}
+
+void Thread_Shutdown (void)
+{
+	int	i;
+
+	if (numthreads <= 1)
+		return;
+
+	pthread_mutex_lock (&job_mutex);
+	job_quit = true;
+	pthread_cond_broadcast (&job_cond);
+	pthread_mutex_unlock (&job_mutex);
+
+	for (i = 0; i < numthreads - 1; i++)
+		pthread_join (work_threads[i], NULL);
+	numthreads = 1;
+}
+
+#elif defined(PLATFORM_WINDOWS)
+
+static CRITICAL_SECTION	lock_crit;
+static LONG volatile	job_next;
+
+void Thread_Lock (void)
+{
+	if (numthreads > 1)
+		EnterCriticalSection (&lock_crit);
+}
+
+void Thread_Unlock (void)
+{
+	if (numthreads > 1)
+		LeaveCriticalSection (&lock_crit);
+}
+
+static void Thread_DoWork (void)
+{
+	int	work;
+
+	while ((work = InterlockedIncrement (&job_next) - 1) < job_count)
+		job_func (job_data, work);
+}
+
+static unsigned __stdcall Thread_Worker (void *unused)
+{
+	Thread_DoWork ();
+	return 0;
+}
+
+void Thread_Run (threadwork_t func, void *data, int workcnt)
+{
+	HANDLE		work_threads[MAX_THREADS];
+	unsigned	id;
+	int		i, count;
+
+	if (numthreads <= 1 || workcnt <= 1)
+	{
+		for (i = 0; i < workcnt; i++)
+			func (data, i);
+		return;
+	}
+
+	job_func = func;
+	job_data = data;
+	job_count = workcnt;
+	job_next = 0;
+
+	count = numthreads - 1;
+	if (count > workcnt - 1)
+		count = workcnt - 1;
+	for (i = 0; i < count; i++)
+	{
+		work_threads[i] = (HANDLE) _beginthreadex (NULL, 0, Thread_Worker, NULL, 0, &id);
+		if (!work_threads[i])
+			break;
+	}
+	count = i;
+
+	Thread_DoWork ();
+	if (count)
+		WaitForMultipleObjects (count, work_threads, TRUE, INFINITE);
+	for (i = 0; i < count; i++)
+		CloseHandle (work_threads[i]);
+}
+
+static qboolean Thread_StartWorkers (void)
+{
+	InitializeCriticalSection (&lock_crit);
+	return true;
+}
+
+void Thread_Shutdown (void)
+{
+	if (numthreads <= 1)
+		return;
+	DeleteCriticalSection (&lock_crit);
+	numthreads = 1;
+}
+
+#else	/* single threaded */
+
+void Thread_Lock (void)
+{
+}
+
+void Thread_Unlock (void)
+{
+}
+
+void Thread_Run (threadwork_t func, void *data, int workcnt)
+{
+	int	i;
+
+	for (i = 0; i < workcnt; i++)
+		func (data, i);
+}
+
+static qboolean Thread_StartWorkers (void)
+{
+	return false;
+}
+
+void Thread_Shutdown (void)
+{
+}
+
+#endif
+
+
+/*
+================
+Thread_Init
+================
+*/
+void Thread_Init (void)
+{
+	int	i;
+
+	i = COM_CheckParm ("-threads");
+	if (i && i < com_argc-1)
+		numthreads = atoi (com_argv[i+1]);
+	else
+		numthreads = Thread_GetNumCPUS ();
+
+	if (numthreads > MAX_THREADS)
+		numthreads = MAX_THREADS;
+	if (numthreads <= 1 || !Thread_StartWorkers ())
+		numthreads = 1;
+
+	Con_SafePrintf ("Using %d thread%s\n", numthreads, (numthreads == 1) ? "" : "s");
+}
@@ -0,0 +1,40 @@
+/* threads.h -- worker threads for parallel engine jobs
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __H2_THREADS_H
+#define __H2_THREADS_H
+
+#define	MAX_THREADS	16
+
+/* a job function is called once for every work item, on any thread.
+ * it must not touch the hunk, the cache, the console or any other
+ * engine state that isn't private to the work item. */
+typedef void (*threadwork_t) (void *data, int work);
+
+void	Thread_Init (void);		/* -threads <n>, defaults to the cpu count */
+void	Thread_Shutdown (void);
+int	Thread_Count (void);		/* the main thread included */
+
+void	Thread_Lock (void);
+void	Thread_Unlock (void);
+
+/* runs func for work items 0..workcnt-1 on all threads, the calling
+ * thread included, and returns when every item is done. */
+void	Thread_Run (threadwork_t func, void *data, int workcnt);
+
+#endif	/* __H2_THREADS_H */
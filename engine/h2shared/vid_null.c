@@ -0,0 +1,220 @@
+/* vid_null.c -- headless video driver for the software renderer
+ *
+ * Renders into a framebuffer in memory and never shows it, so that the
+ * software renderer can be timed (timedemo, -benchmark, timerefresh) on
+ * machines without a display.  The size comes from -width and -height,
+ * 640x480 by default.  vid_dumpframes <n> writes every n-th frame as a
+ * ppm file under <userdir>/frames, so that the output of two builds can
+ * be compared.  (In hexen2, host_framerate steps every frame by the
+ * same time, which takes the speed of the machine out of the frames.)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include "d_local.h"
+
+#define MIN_WIDTH		320
+#define MIN_HEIGHT		200
+
+static unsigned char	vid_curpal[256*3];
+
+unsigned short	d_8to16table[256];
+unsigned int	d_8to24table[256];
+
+byte globalcolormap[VID_GRADES*256], lastglobalcolor = 0;
+byte *lastsourcecolormap = NULL;
+
+qboolean	in_mode_set;
+modestate_t	modestate = MS_UNINIT;
+
+viddef_t	vid;		// global video state
+
+cvar_t		_enable_mouse = {"_enable_mouse", "0", CVAR_NONE};
+static cvar_t	vid_dumpframes = {"vid_dumpframes", "0", CVAR_NONE};
+
+static byte	*vid_surfcache;
+static int	vid_surfcachesize;
+static int	vid_framenum;
+
+
+/*
+================
+VID_AllocBuffers
+
+The z buffer, the surface cache and the framebuffer in one block
+================
+*/
+static void VID_AllocBuffers (int width, int height)
+{
+	int		tsize, tbuffersize;
+
+	tbuffersize = width * height * sizeof (*d_pzbuffer);
+	tsize = D_SurfaceCacheForRes (width, height);
+	tbuffersize += tsize + width * height;
+
+	if (host_parms->memsize < tbuffersize + 0x180000 + 0xC00000)
+		Sys_Error ("Not enough memory for a %dx%d framebuffer", width, height);
+
+	vid_surfcachesize = tsize;
+	d_pzbuffer = (short *) Hunk_HighAllocName (tbuffersize, "video");
+	vid_surfcache = (byte *)d_pzbuffer + width * height * sizeof (*d_pzbuffer);
+	vid.buffer = vid_surfcache + vid_surfcachesize;
+}
+
+void VID_LockBuffer (void)
+{
+}
+
+void VID_UnlockBuffer (void)
+{
+}
+
+void VID_SetPalette (const unsigned char *palette)
+{
+	if (palette != vid_curpal)
+		memcpy (vid_curpal, palette, sizeof(vid_curpal));
+}
+
+void VID_ShiftPalette (const unsigned char *palette)
+{
+	VID_SetPalette (palette);
+}
+
+
+/*
+===================
+VID_Init
+===================
+*/
+void VID_Init (const unsigned char *palette)
+{
+	int		width, height, i;
+
+	Cvar_RegisterVariable (&_enable_mouse);
+	Cvar_RegisterVariable (&vid_dumpframes);
+
+	width = 640;
+	height = 480;
+	i = COM_CheckParm("-width");
+	if (i && i < com_argc-1)
+	{
+		width = atoi(com_argv[i+1]);
+		i = COM_CheckParm("-height");
+		if (i && i < com_argc-1)
+			height = atoi(com_argv[i+1]);
+		else	// proceed with 4/3 ratio
+			height = 3 * width / 4;
+	}
+	if (width < MIN_WIDTH || width > MAXWIDTH ||
+	    height < MIN_HEIGHT || height > MAXHEIGHT)
+	{
+		Sys_Error ("Bad framebuffer size %dx%d", width, height);
+	}
+
+	vid.maxwarpwidth = WARP_WIDTH;
+	vid.maxwarpheight = WARP_HEIGHT;
+	vid.colormap = host_colormap;
+	vid.fullbright = 256 - LittleLong (*((int *)vid.colormap + 2048));
+
+	VID_AllocBuffers (width, height);
+	D_InitCaches (vid_surfcache, vid_surfcachesize);
+
+	vid.height = vid.conheight = height;
+	vid.width = vid.conwidth = width;
+	vid.conbuffer = vid.direct = vid.buffer;
+	vid.rowbytes = vid.conrowbytes = width;
+	vid.numpages = 1;
+	vid.aspect = ((float)vid.height / (float)vid.width) * (320.0 / 240.0);
+	vid.recalc_refdef = 1;
+	modestate = MS_WINDOWED;
+
+	VID_SetPalette (palette);
+
+	Con_SafePrintf ("Video Mode: %ux%ux8 (no display)\n", vid.width, vid.height);
+}
+
+void VID_Shutdown (void)
+{
+}
+
+
+/*
+================
+VID_DumpFrame
+
+Writes the frame as a binary ppm, in the colors of the current palette
+================
+*/
+static void VID_DumpFrame (void)
+{
+	char	name[MAX_OSPATH];
+	byte	*buf, *out, *in, *rgb;
+	int	header, size, i;
+
+	FS_MakePath_BUF (FS_USERDIR, NULL, name, sizeof(name), "frames");
+	Sys_mkdir (name, false);
+
+	q_snprintf (name, sizeof(name), "P6\n%d %d\n255\n", vid.width, vid.height);
+	header = (int) strlen(name);
+	size = header + vid.width * vid.height * 3;
+	buf = (byte *) Hunk_TempAlloc (size);
+	memcpy (buf, name, header);
+
+	out = buf + header;
+	in = vid.buffer;
+	for (i = 0; i < vid.width * vid.height; i++)
+	{
+		rgb = vid_curpal + in[i] * 3;
+		*out++ = rgb[0];
+		*out++ = rgb[1];
+		*out++ = rgb[2];
+	}
+
+	q_snprintf (name, sizeof(name), "frames/frame%05d.ppm", vid_framenum);
+	FS_WriteFile (name, buf, size);
+}
+
+void VID_Update (vrect_t *rects)
+{
+	if (vid_dumpframes.integer > 0 && vid_framenum % vid_dumpframes.integer == 0)
+		VID_DumpFrame ();
+	vid_framenum++;
+}
+
+void D_BeginDirectRect (int x, int y, byte *pbitmap, int width, int height)
+{
+}
+
+void D_EndDirectRect (int x, int y, int width, int height)
+{
+}
+
+#ifndef H2W
+// unused in hexenworld
+void D_ShowLoadingSize (void)
+{
+}
+#endif
+
+void VID_HandlePause (qboolean paused)
+{
+}
+
+void VID_ToggleFullscreen (void)
+{
+}
+
@@ -689,6 +689,7 @@ void VID_Init (const unsigned char *palette)
 				"vid_config_swx",
 				"vid_config_swy" };
 #define num_readvars	( sizeof(read_vars)/sizeof(read_vars[0]) )
+	static char	sdl_env_dummy[32] = "SDL_VIDEODRIVER=dummy";
 
 	temp = scr_disabled_for_loading;
 	scr_disabled_for_loading = true;
@@ -706,6 +707,10 @@ void VID_Init (const unsigned char *palette)
 	Cmd_AddCommand ("vid_nummodes", VID_NumModes_f);
 	Cmd_AddCommand ("vid_restart", VID_Restart_f);
 
+	// -benchmark runs headless: let SDL render to its offscreen driver
+	if (COM_CheckParm("-benchmark") && !getenv("SDL_VIDEODRIVER"))
+		putenv (sdl_env_dummy);
+
 	// init sdl
 	// the first check is actually unnecessary
 	if ((SDL_WasInit(SDL_INIT_VIDEO)) == 0)
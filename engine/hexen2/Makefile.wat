@@ -400,12 +400,14 @@ SOFTOBJS = &
 	d_polyse.obj &
 	d_scan.obj &
 	d_sky.obj &
+	d_spansimd.obj &
 	d_sprite.obj &
 	d_surf.obj &
 	d_vars.obj &
 	d_zpoint.obj &
 	r_aclip.obj &
 	r_alias.obj &
+	r_aliassimd.obj &
 	r_bsp.obj &
 	r_draw.obj &
 	r_edge.obj &
@@ -414,9 +416,11 @@ SOFTOBJS = &
 	r_main.obj &
 	r_misc.obj &
 	r_part.obj &
+	lmcache.obj &
 	r_sky.obj &
 	r_sprite.obj &
 	r_surf.obj &
+	r_surfsimd.obj &
 	r_vars.obj &
 	screen.obj &
 	$(SYSOBJ_SOFT_VID) &
@@ -429,6 +433,7 @@ GLOBJS = &
 	gl_rmain.obj &
 	gl_rmisc.obj &
 	r_part.obj &
+	lmcache.obj &
 	gl_rsurf.obj &
 	gl_screen.obj &
 	gl_warp.obj &
@@ -493,6 +498,8 @@ COMMONOBJS = &
 	world.obj &
 	zone.obj &
 	hashindex.obj &
+	pvscache.obj &
+	threads.obj &
 	$(SYSOBJ_SYS)
 
 all: $(BUILD_TARGET)
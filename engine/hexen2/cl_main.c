@@ -86,6 +86,8 @@ void CL_ClearState (void)
 	memset (cl_lightstyle, 0, sizeof(cl_lightstyle));
 	CL_ClearTEnts();
 	CL_ClearEffects();
+	CL_DemoNewMap ();
+	FS_FreePrefetch ();	// left over if the last map load aborted
 
 // allocate the efrags and chain together into a free list
 	cl.free_efrags = cl_efrags;
@@ -127,6 +129,9 @@ void CL_Disconnect (void)
 	BGM_Stop();
 	CDAudio_Stop();
 	loading_stage = 0;
+// a Host_Error while loading models skips the FS_FreePrefetch in
+// CL_ParseServerInfo, so drop the prefetched files here
+	FS_FreePrefetch ();
 
 // bring the console down and fade the colors back to normal
 //	SCR_BringDownConsole ();
@@ -156,6 +161,7 @@ void CL_Disconnect (void)
 	}
 
 	cls.demoplayback = cls.timedemo = false;
+	CL_TimeDemoReset ();
 	cls.signon = 0;
 	cl.intermission = 0;
 }
@@ -1008,6 +1014,7 @@ void CL_Init (void)
 	Cmd_AddCommand ("stop", CL_Stop_f);
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
+	CL_InitDemo ();
 	Cmd_AddCommand ("sensitivity_save", CL_Sensitivity_save_f);
 
 	Cmd_AddCommand ("viewpos", CL_Viewpos_f);
@@ -24,6 +24,7 @@
 #include "bgmusic.h"
 #include "cdaudio.h"
 #include "r_shared.h"
+#include "threads.h"
 
 static const char *svc_strings[] =
 {
@@ -177,6 +178,8 @@ static void CL_ParseStartSoundPacket(void)
 	for (i = 0; i < 3; i++)
 		pos[i] = MSG_ReadCoord ();
 
+	if (CL_DemoSeeking ())
+		return;
 	S_StartSound (ent, channel, cl.sound_precache[sound_num], pos, volume/255.0, attenuation);
 }
 
@@ -251,6 +254,8 @@ static void CL_ParseServerInfo (void)
 	const char	*str;
 	int		i;
 	int		nummodels, numsounds;
+	long		prefetched;
+	double		time1, time2, time3, time4, time5;
 	char	model_precache[MAX_MODELS][MAX_QPATH];
 	char	sound_precache[MAX_SOUNDS][MAX_QPATH];
 // rjr	edict_t		*ent;
@@ -357,8 +362,15 @@ static void CL_ParseServerInfo (void)
 	// copy the naked name of the map file to the cl structure
 	COM_FileBase (model_precache[1], cl.mapname, sizeof(cl.mapname));
 
+	// read the files on all threads first, the world
+	// alone if the rest is to be loaded on demand.
+	time1 = Sys_DoubleTime ();
+	prefetched = Mod_PrefetchModels (model_precache + 1, precache.integer ? nummodels - 1 : 1);
+	time2 = Sys_DoubleTime ();
+
 	//always precache the world!!!
 	cl.model_precache[1] = Mod_ForName (model_precache[1], false);
+	time3 = Sys_DoubleTime ();
 	for (i = 2; i < nummodels; i++)
 	{
 		if (precache.integer)
@@ -372,11 +384,14 @@ static void CL_ParseServerInfo (void)
 
 		if (cl.model_precache[i] == NULL)
 		{
+			FS_FreePrefetch ();
 			Host_Error("Model %s not found", model_precache[i]);
 			return;
 		}
 		CL_KeepaliveMessage ();
 	}
+	FS_FreePrefetch ();
+	time4 = Sys_DoubleTime ();
 
 	player_models[0] = (qmodel_t *)Mod_FindName ("models/paladin.mdl");
 	player_models[1] = !(gameflags & GAME_OLD_DEMO) ? (qmodel_t *)Mod_FindName ("models/crusader.mdl") : NULL;
@@ -397,6 +412,12 @@ static void CL_ParseServerInfo (void)
 		CL_KeepaliveMessage ();
 	}
 	S_EndPrecaching ();
+	time5 = Sys_DoubleTime ();
+
+	Con_DPrintf ("precache: %ld KB read in %.1f ms, world %.1f ms, %d models %.1f ms, %d sounds %.1f ms (%d threads)\n",
+			prefetched >> 10, (time2 - time1) * 1000.0, (time3 - time2) * 1000.0,
+			nummodels - 2, (time4 - time3) * 1000.0,
+			numsounds - 1, (time5 - time4) * 1000.0, Thread_Count());
 
 	total_loading_size = 0;
 	loading_stage = 0;
@@ -1119,6 +1140,7 @@ void CL_ParseServerMessage (void)
 {
 	int		cmd;
 	int		i, j, k;
+	const char	*str;
 	int		EntityCount = 0;
 	int		EntitySize = 0;
 	int		before;
@@ -1237,7 +1259,9 @@ void CL_ParseServerMessage (void)
 			break;
 
 		case svc_stufftext:
-			Cbuf_AddText (MSG_ReadString ());
+			str = MSG_ReadString ();
+			if (!CL_DemoSeeking ())	// else they'd all run at once
+				Cbuf_AddText (str);
 			break;
 
 		case svc_damage:
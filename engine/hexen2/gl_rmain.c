@@ -19,6 +19,7 @@
  */
 
 #include "quakedef.h"
+#include "lmcache.h"
 
 entity_t	r_worldentity;
 vec3_t		modelorg, r_entorigin;
@@ -28,7 +29,7 @@ int			r_framecount;		// used for dlight push checking
 
 mplane_t	frustum[4];
 
-int			c_brush_polys, c_alias_polys;
+int			c_brush_polys, c_alias_polys, c_lightmap_bytes;
 
 qboolean	r_cache_thrash;			// compatability
 
@@ -1944,8 +1945,9 @@ static void R_PrintTimes (void)
 	ms = 1000 * (r_time2 - r_time1);
 	fps = 1000 / ms;
 
-	Con_Printf("%3.1f fps %5.0f ms\n%4i wpoly  %4i epoly\n",
-			fps, ms, c_brush_polys, c_alias_polys);
+	Con_Printf("%3.1f fps %5.0f ms\n%4i wpoly  %4i epoly\n%4i kb lightmap upload  %3i/%3i lightmaps cached\n",
+			fps, ms, c_brush_polys, c_alias_polys, (c_lightmap_bytes + 1023) >> 10,
+			lm_cachehits, lm_cachelookups);
 }
 
 
@@ -1973,6 +1975,8 @@ void R_RenderView (void)
 			r_time1 = Sys_DoubleTime ();
 		c_brush_polys = 0;
 		c_alias_polys = 0;
+		c_lightmap_bytes = 0;
+		lm_cachehits = lm_cachelookups = 0;
 	}
 
 	mirror = false;
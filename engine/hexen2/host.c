@@ -27,6 +27,7 @@
 #include "debuglog.h"
 #include "bgmusic.h"
 #include "cdaudio.h"
+#include "threads.h"
 #include <setjmp.h>
 
 /*
@@ -810,6 +811,7 @@ static void _Host_Frame (float time)
 	static double		time2 = 0;
 	static double		time3 = 0;
 	int			pass1, pass2, pass3;
+	double			tdtime = 0;
 #if !defined(FPS_20)
 	double	save_host_frametime,total_host_frametime;
 #endif
@@ -865,7 +867,13 @@ static void _Host_Frame (float time)
 
 // fetch results from server
 	if (cls.state == ca_connected)
+	{
+		if (cls.timedemo)
+			tdtime = Sys_DoubleTime ();
 		CL_ReadFromServer ();
+		if (cls.timedemo)
+			CL_TimeDemoPhase (tdphase_parse, Sys_DoubleTime () - tdtime);
+	}
 
 #else
 
@@ -897,7 +905,13 @@ static void _Host_Frame (float time)
 
 	// fetch results from server
 		if (cls.state == ca_connected)
+		{
+			if (cls.timedemo)
+				tdtime = Sys_DoubleTime ();
 			CL_ReadFromServer ();
+			if (cls.timedemo)
+				CL_TimeDemoPhase (tdphase_parse, Sys_DoubleTime () - tdtime);
+		}
 
 		R_UpdateParticles ();
 		CL_UpdateEffects ();
@@ -919,13 +933,15 @@ static void _Host_Frame (float time)
 #endif
 
 // update video
-	if (host_speeds.integer)
+	if (host_speeds.integer || cls.timedemo)
 		time1 = Sys_DoubleTime ();
 
 	SCR_UpdateScreen ();
 
-	if (host_speeds.integer)
+	if (host_speeds.integer || cls.timedemo)
 		time2 = Sys_DoubleTime ();
+	if (cls.timedemo)
+		CL_TimeDemoPhase (tdphase_screen, time2 - time1);
 
 // update audio
 	BGM_Update();	// adds music raw samples and/or advances midi driver
@@ -939,6 +955,12 @@ static void _Host_Frame (float time)
 
 	CDAudio_Update();
 
+	if (cls.timedemo)
+	{
+		CL_TimeDemoPhase (tdphase_sound, Sys_DoubleTime () - time2);
+		CL_TimeDemoEndFrame ();
+	}
+
 	if (host_speeds.integer)
 	{
 		pass1 = (time1 - time3)*1000;
@@ -1003,6 +1025,8 @@ void Host_Init (void)
 	Cbuf_Init ();
 	Cmd_Init ();
 	COM_Init ();
+	if (COM_CheckParm ("-benchmark"))
+		safemode = 1;	/* no sound, cd, midi or input devices */
 	SV_Init ();
 	FS_Init ();
 	CL_Cmd_Init ();
@@ -1012,6 +1036,7 @@ void Host_Init (void)
 	PR_Init ();
 	Mod_Init ();
 	NET_Init ();
+	Thread_Init ();
 
 	Con_Printf ("Exe: " __TIME__ " " __DATE__ "\n");
 	Con_Printf ("%4.1f megabyte heap\n", host_parms->memsize/(1024*1024.0));
@@ -1078,6 +1103,7 @@ void Host_Init (void)
 		Cbuf_InsertText ("exec hexen.rc\n");
 		if (!setjmp(host_abort))		/* in case exec fails with a longjmp(), e.g. Host_Error() */
 			Cbuf_Execute ();
+		CL_StartBenchmark ();
 	}
 
 	Cvar_UnlockAll ();				/* unlock the early-set cvars after init */
@@ -1127,6 +1153,8 @@ void Host_Shutdown(void)
 		VID_Shutdown();
 	}
 
+	Thread_Shutdown ();
+
 	LOG_Close ();
 }
 
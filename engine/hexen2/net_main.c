@@ -42,6 +42,7 @@ char		my_tcpip_address[NET_NAMELEN];
 
 #if defined(SERVERONLY)
 #define	listening	true	/* h2ded is always listening */
+static qboolean	sendtoall = false;	/* inside NET_SendToAll */
 #else
 static qboolean	listening = false;
 
@@ -536,6 +537,11 @@ qsocket_t *NET_CheckNewConnections (void)
 
 	SetNetTime();
 
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+		return SV_ReplayCheckNewConnections ();
+#endif	/* SERVERONLY */
+
 	for (net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
 		if (net_drivers[net_driverlevel].initialized == false)
@@ -545,6 +551,10 @@ qsocket_t *NET_CheckNewConnections (void)
 		ret = dfunc.CheckNewConnections ();
 		if (ret)
 		{
+#if defined(SERVERONLY)
+			if (sv_replay == SV_REPLAY_RECORD)
+				SV_ReplayRecordConnect (ret);
+#endif	/* SERVERONLY */
 			return ret;
 		}
 	}
@@ -567,6 +577,17 @@ void NET_Close (qsocket_t *sock)
 
 	SetNetTime();
 
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+	{
+		SV_ReplayClose (sock);
+		NET_FreeQSocket(sock);
+		return;
+	}
+	if (sv_replay == SV_REPLAY_RECORD)
+		SV_ReplayRecordClose (sock);
+#endif	/* SERVERONLY */
+
 	// call the driver_Close function
 	sfunc.Close (sock);
 
@@ -600,6 +621,11 @@ int	NET_GetMessage (qsocket_t *sock)
 
 	SetNetTime();
 
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+		return SV_ReplayGetMessage (sock);
+#endif	/* SERVERONLY */
+
 	ret = sfunc.QGetMessage(sock);
 
 	// see if this connection has timed out
@@ -622,6 +648,10 @@ int	NET_GetMessage (qsocket_t *sock)
 			else if (ret == 2)
 				unreliableMessagesReceived++;
 		}
+#if defined(SERVERONLY)
+		if (sv_replay == SV_REPLAY_RECORD && !sendtoall)
+			SV_ReplayRecordMessage (sock, ret);
+#endif	/* SERVERONLY */
 	}
 
 	return ret;
@@ -653,6 +683,10 @@ int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 	}
 
 	SetNetTime();
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+		return 1;
+#endif	/* SERVERONLY */
 	r = sfunc.QSendMessage(sock, data);
 	if (r == 1 && !IS_LOOP_DRIVER(sock->driver))
 		messagesSent++;
@@ -675,6 +709,10 @@ int NET_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 	}
 
 	SetNetTime();
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+		return 1;
+#endif	/* SERVERONLY */
 	r = sfunc.SendUnreliableMessage(sock, data);
 	if (r == 1 && !IS_LOOP_DRIVER(sock->driver))
 		unreliableMessagesSent++;
@@ -701,6 +739,11 @@ qboolean NET_CanSendMessage (qsocket_t *sock)
 
 	SetNetTime();
 
+#if defined(SERVERONLY)
+	if (sv_replay == SV_REPLAY_PLAY)
+		return true;
+#endif	/* SERVERONLY */
+
 	return sfunc.CanSendMessage(sock);
 }
 
@@ -738,6 +781,9 @@ int NET_SendToAll (sizebuf_t *data, double blocktime)
 	}
 
 	start = Sys_DoubleTime();
+#if defined(SERVERONLY)
+	sendtoall = true;	/* messages read while waiting here are dropped */
+#endif	/* SERVERONLY */
 	while (count)
 	{
 		count = 0;
@@ -775,6 +821,9 @@ int NET_SendToAll (sizebuf_t *data, double blocktime)
 		if ((Sys_DoubleTime() - start) > blocktime)
 			break;
 	}
+#if defined(SERVERONLY)
+	sendtoall = false;
+#endif	/* SERVERONLY */
 	return count;
 }
 
@@ -850,6 +899,12 @@ void NET_Init (void)
 	Cmd_AddCommand ("port", NET_Port_f);
 #endif	/* SERVERONLY */
 
+#if defined(SERVERONLY)
+	// a replay doesn't touch the network at all
+	if (sv_replay == SV_REPLAY_PLAY)
+		return;
+#endif	/* SERVERONLY */
+
 	// initialize all the drivers
 	for (i = net_driverlevel = 0; net_driverlevel < net_numdrivers; net_driverlevel++)
 	{
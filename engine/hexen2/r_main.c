@@ -21,6 +21,7 @@
 #include "quakedef.h"
 #include "r_local.h"
 #include "d_local.h"
+#include "lmcache.h"
 
 //#define	PASSAGES
 
@@ -167,6 +168,7 @@ cvar_t	r_wholeframe = {"r_wholeframe", "1", CVAR_ARCHIVE};
 cvar_t	r_transwater = {"r_transwater", "1", CVAR_ARCHIVE};
 cvar_t	r_texture_external = {"r_texture_external", "0", CVAR_ARCHIVE};
 cvar_t	r_dynamic = {"r_dynamic", "1", CVAR_NONE};
+cvar_t	r_threads = {"r_threads", "0", CVAR_ARCHIVE};	// threaded span drawing
 
 //void CreatePassages (void);
 //void SetVisibilityByPassages (void);
@@ -240,8 +242,13 @@ void R_Init (void)
 	r_stack_start = (byte *)&dummy;
 
 	R_InitTurb ();
+	R_InitSurfKernels ();
+	R_InitAliasKernels ();
+	LM_InitCache ();
 
 	Cmd_AddCommand ("timerefresh", R_TimeRefresh_f);
+	Cmd_AddCommand ("r_threadcheck", R_ThreadCheck_f);
+	Cmd_AddCommand ("timespans", R_TimeSpans_f);
 	Cmd_AddCommand ("pointfile", R_ReadPointFile_f);
 
 	Cvar_RegisterVariable (&r_draworder);
@@ -270,6 +277,7 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_transwater);
 	Cvar_RegisterVariable (&r_texture_external);
 	Cvar_RegisterVariable (&r_dynamic);
+	Cvar_RegisterVariable (&r_threads);
 
 	Cvar_SetValueQuick (&r_maxedges, (float)NUMSTACKEDGES);
 	Cvar_SetValueQuick (&r_maxsurfs, (float)NUMSTACKSURFACES);
@@ -345,6 +353,7 @@ void R_NewMap (void)
 
 	r_viewleaf = NULL;
 	R_ClearParticles ();
+	LM_FlushCache ();
 
 	r_cnumsurfs = r_maxsurfs.integer;
 
@@ -32,9 +32,9 @@
 #define	SFL_64			64
 #define	SFL_128			128
 
-#define	MAX_PARTICLES		7000	// default max # of particles at one time
 #define	ABSOLUTE_MIN_PARTICLES	512	// no fewer than this no matter what's
 					// on the command line
+#define	ABSOLUTE_MAX_PARTICLES	1048576
 
 //=============================================================================
 
@@ -55,19 +55,61 @@ static int ramp12[8] = { 136, 137, 138, 139, 140, 141, 142, 143 };
 
 //=============================================================================
 
-particle_t	*active_particles, *free_particles;
-particle_t	*particles;
-static int	r_numparticles;
+/* The live particles are kept as structures of arrays in chunks, one
+ * list of chunks per type, so that R_RunParticles can update each type in
+ * tight loops over the arrays it needs.  All chunks of a list but the
+ * first are full: a dead particle is replaced by the last one of its
+ * type, and spawned particles are appended.  AllocParticle hands out
+ * spawn records from r_spawned, which R_PackParticles moves into the
+ * chunks.  Types beyond the known ones (they come from the network) share
+ * the last list and only move.  */
+#define	PT_NUMTYPES		(pt_redfire + 1)
+#define	PT_NUMGROUPS		(PT_NUMTYPES + 1)
+#define	PT_GROUP(t)		((t) < PT_NUMTYPES ? (t) : PT_NUMTYPES)
+
+#define	PCHUNK_SIZE		64
+
+typedef struct
+{
+	vec3_t		min_org;
+	vec3_t		max_org;
+	byte		flags;
+	byte		count;
+} pextra_t;
+
+typedef struct pchunk_s
+{
+	struct pchunk_s	*next;
+	int		count;
+	float		org[3][PCHUNK_SIZE];
+	float		vel[3][PCHUNK_SIZE];
+	float		color[PCHUNK_SIZE];
+	float		ramp[PCHUNK_SIZE];
+	float		die[PCHUNK_SIZE];
+	byte		type[PCHUNK_SIZE];
+	pextra_t	extra[PCHUNK_SIZE];
+} pchunk_t;
+
+static pchunk_t		*r_pchunks, *r_freepchunks;
+static int		r_numpchunks;
+static pchunk_t		*r_pgroups[PT_NUMGROUPS];
+static int		r_numactive;
+
+static particle_t	*r_spawned;
+static int		r_numspawned;
+static int		r_numparticles;
 
 vec3_t		r_pright, r_pup, r_ppn;
 static	vec3_t	rider_origin;
 
+static	cvar_t	r_maxparticles = {"r_maxparticles", "7000", CVAR_ARCHIVE};	// max # of particles at one time
 static	cvar_t	leak_color = {"leak_color", "251", CVAR_ARCHIVE};
 static	cvar_t	snow_flurry= {"snow_flurry", "1", CVAR_ARCHIVE};
 static	cvar_t	snow_active= {"snow_active", "1", CVAR_ARCHIVE};
 
 
 static particle_t *AllocParticle (void);
+static void R_ParticleBench_f (void);
 
 void R_RunParticleEffect2 (vec3_t org, vec3_t dmin, vec3_t dmax, int color, ptype_t effect, int count);
 void R_RunParticleEffect3 (vec3_t org, vec3_t box, int color, ptype_t effect, int count);
@@ -76,6 +118,54 @@ void R_RunParticleEffect4 (vec3_t org, float radius, int color, ptype_t effect,
 //=============================================================================
 
 
+/*
+===============
+R_AllocParticles
+
+Makes room for count particles.  The live ones are dropped.
+===============
+*/
+static void R_AllocParticles (int count)
+{
+	pchunk_t	*chunks;
+	particle_t	*spawned;
+	int		numchunks;
+
+	numchunks = (count + PCHUNK_SIZE - 1) / PCHUNK_SIZE + PT_NUMGROUPS;
+	chunks = (pchunk_t *) malloc (numchunks * sizeof(pchunk_t));
+	spawned = (particle_t *) malloc (count * sizeof(particle_t));
+	if (!chunks || !spawned)
+	{
+		free (chunks);
+		free (spawned);
+		if (!r_pchunks)
+			Sys_Error ("%s: failed on allocating %d particles", __thisfunc__, count);
+		Con_Printf ("Not enough memory for %d particles\n", count);
+		return;
+	}
+
+	free (r_pchunks);
+	free (r_spawned);
+	r_pchunks = chunks;
+	r_numpchunks = numchunks;
+	r_spawned = spawned;
+	r_numparticles = count;
+	R_ClearParticles ();
+}
+
+static void R_MaxParticles_f (cvar_t *var)
+{
+	int		count;
+
+	count = var->integer;
+	if (count < ABSOLUTE_MIN_PARTICLES)
+		count = ABSOLUTE_MIN_PARTICLES;
+	else if (count > ABSOLUTE_MAX_PARTICLES)
+		count = ABSOLUTE_MAX_PARTICLES;
+	if (count != r_numparticles)
+		R_AllocParticles (count);
+}
+
 /*
 ===============
 R_InitParticles
@@ -85,20 +175,14 @@ void R_InitParticles (void)
 {
 	int		i;
 
+	Cvar_RegisterVariable (&r_maxparticles);
+	Cvar_SetCallback (&r_maxparticles, R_MaxParticles_f);
 	i = COM_CheckParm ("-particles");
-
 	if (i && i < com_argc-1)
-	{
-		r_numparticles = atoi(com_argv[i+1]);
-		if (r_numparticles < ABSOLUTE_MIN_PARTICLES)
-			r_numparticles = ABSOLUTE_MIN_PARTICLES;
-	}
-	else
-	{
-		r_numparticles = MAX_PARTICLES;
-	}
+		Cvar_SetROM ("r_maxparticles", com_argv[i+1]);
+	R_MaxParticles_f (&r_maxparticles);
 
-	particles = (particle_t *) Hunk_AllocName (r_numparticles * sizeof(particle_t), "particles");
+	Cmd_AddCommand ("r_particlebench", R_ParticleBench_f);
 
 	Cvar_RegisterVariable (&leak_color);
 	//JFM: snow test
@@ -159,13 +243,11 @@ static particle_t *AllocParticle (void)
 {
 	particle_t	*p;
 
-	if (!free_particles)
+	if (r_numactive + r_numspawned >= r_numparticles)
 		return NULL;
 
-	p = free_particles;
-	free_particles = p->next;
-	p->next = active_particles;
-	active_particles = p;
+	p = &r_spawned[r_numspawned++];
+	memset (p, 0, sizeof(particle_t));
 
 	return p;
 }
@@ -179,14 +261,15 @@ void R_ClearParticles (void)
 {
 	int		i;
 
-	if (!r_numparticles)
-		return;
-	free_particles = &particles[0];
-	active_particles = NULL;
-
-	for (i = 0; i < r_numparticles-1; i++)
-		particles[i].next = &particles[i+1];
-	particles[r_numparticles-1].next = NULL;
+	r_freepchunks = NULL;
+	for (i = r_numpchunks - 1; i >= 0; i--)
+	{
+		r_pchunks[i].next = r_freepchunks;
+		r_freepchunks = &r_pchunks[i];
+	}
+	memset (r_pgroups, 0, sizeof(r_pgroups));
+	r_numactive = 0;
+	r_numspawned = 0;
 }
 
 
@@ -1364,6 +1447,151 @@ void R_ColoredParticleExplosion (vec3_t org, int color, int radius, int counter)
 	}
 }
 
+/*
+===============
+R_AddParticle
+
+Appends the spawn record p to the chunks of its type
+===============
+*/
+static void R_AddParticle (const particle_t *p)
+{
+	pchunk_t	*c, **group;
+	int		i;
+
+	group = &r_pgroups[PT_GROUP(p->type)];
+	c = *group;
+	if (!c || c->count == PCHUNK_SIZE)
+	{
+		c = r_freepchunks;
+		if (!c)
+			return;		// out of chunks, drop the particle
+		r_freepchunks = c->next;
+		c->next = *group;
+		c->count = 0;
+		*group = c;
+	}
+
+	i = c->count++;
+	c->org[0][i] = p->org[0];
+	c->org[1][i] = p->org[1];
+	c->org[2][i] = p->org[2];
+	c->vel[0][i] = p->vel[0];
+	c->vel[1][i] = p->vel[1];
+	c->vel[2][i] = p->vel[2];
+	c->color[i] = p->color;
+	c->ramp[i] = p->ramp;
+	c->die[i] = p->die;
+	c->type[i] = p->type;
+	VectorCopy (p->min_org, c->extra[i].min_org);
+	VectorCopy (p->max_org, c->extra[i].max_org);
+	c->extra[i].flags = p->flags;
+	c->extra[i].count = p->count;
+	r_numactive++;
+}
+
+/*
+===============
+R_RemoveParticle
+
+Replaces particle i of chunk c by the last particle of the type.  Chunks
+emptied by earlier removals are given back here, the caller may still be
+walking the one it empties.
+===============
+*/
+static void R_RemoveParticle (pchunk_t **group, pchunk_t *c, int i)
+{
+	pchunk_t	*last;
+	int		j;
+
+	last = *group;
+	while (!last->count)
+	{
+		*group = last->next;
+		last->next = r_freepchunks;
+		r_freepchunks = last;
+		last = *group;
+	}
+
+	j = --last->count;
+	if (last != c || j != i)
+	{
+		c->org[0][i] = last->org[0][j];
+		c->org[1][i] = last->org[1][j];
+		c->org[2][i] = last->org[2][j];
+		c->vel[0][i] = last->vel[0][j];
+		c->vel[1][i] = last->vel[1][j];
+		c->vel[2][i] = last->vel[2][j];
+		c->color[i] = last->color[j];
+		c->ramp[i] = last->ramp[j];
+		c->die[i] = last->die[j];
+		c->type[i] = last->type[j];
+		c->extra[i] = last->extra[j];
+	}
+	r_numactive--;
+}
+
+/*
+===============
+R_PackParticles
+
+Drops the dead particles and moves the spawned ones into the chunks
+===============
+*/
+static void R_PackParticles (void)
+{
+	pchunk_t	*c, **group;
+	int		g, i;
+
+	for (g = 0; g < PT_NUMGROUPS; g++)
+	{
+		group = &r_pgroups[g];
+		for (c = *group; c; c = c->next)
+		{
+			for (i = 0; i < c->count; )
+			{
+				if (c->die[i] < cl.time)
+					R_RemoveParticle (group, c, i);
+				else
+					i++;
+			}
+		}
+
+		while (*group && !(*group)->count)
+		{
+			c = *group;
+			*group = c->next;
+			c->next = r_freepchunks;
+			r_freepchunks = c;
+		}
+	}
+
+	for (i = 0; i < r_numspawned; i++)
+	{
+		if (r_spawned[i].die >= cl.time)
+			R_AddParticle (&r_spawned[i]);
+	}
+	r_numspawned = 0;
+}
+
+/*
+===============
+R_GetParticle
+
+Gathers what the drivers need of particle i of chunk c into p
+===============
+*/
+static void R_GetParticle (const pchunk_t *c, int i, particle_t *p)
+{
+	p->org[0] = c->org[0][i];
+	p->org[1] = c->org[1][i];
+	p->org[2] = c->org[2][i];
+	p->color = c->color[i];
+	p->ramp = c->ramp[i];
+	p->type = c->type[i];
+	p->count = c->extra[i].count;
+}
+
 /*
 ===============
 R_DrawParticles
@@ -1380,15 +1608,59 @@ static const float ptex_coord[4][3][2] =
 	{ {1.000, 1.000}, {1.000, 0.180}, {0.180, 1.000} }	// snow count >= 69 : happy snow!
 };
 
-void R_DrawParticles (void)
+static void R_RenderParticle (particle_t *p)
 {
 	int		i, color;
-	particle_t	*p;
 	float		scale;
 #define	SCALE_BASE	((p->type == pt_snow) ? p->count/10 : 1)
 
+	// hack a scale up to keep particles from disapearing
+	scale = (p->org[0] - r_origin[0])*vpn[0] +
+		(p->org[1] - r_origin[1])*vpn[1] +
+		(p->org[2] - r_origin[2])*vpn[2];
+	if (scale < 20)
+		scale = SCALE_BASE;
+	else
+		scale = SCALE_BASE + scale * 0.004;
+
+/* clamp color to 0-511: particle->type 10 and 11 (pt_c_explode
+ * and pt_c_explode2, e.g. Crusader's ice particles hitting a
+ * wall) lead to negative values, because R_UpdateParticles ()
+ * decrements their color against time. */
+	color = ((int)p->color) & 0x01ff;
+	if (color < 256)
+		glColor3ubv_fp ((byte *)&d_8to24table[color]);
+	else
+		glColor4ubv_fp ((byte *)&d_8to24TranslucentTable[color-256]);
+
+	// setup texture coordinates
+	i = 0;
+	if (p->type == pt_snow)
+	{
+		if (p->count >= 69)
+			i = 3;	// happy snow!
+		else if (p->count >= 40)
+			i = 2;
+		else if (p->count >= 30)
+			i = 1;
+	}
+
+	glTexCoord2fv_fp (ptex_coord[i][0]);
+	glVertex3fv_fp (p->org);
+	glTexCoord2fv_fp (ptex_coord[i][1]);
+	glVertex3f_fp (p->org[0] + r_pup[0]*scale, p->org[1] + r_pup[1]*scale, p->org[2] + r_pup[2]*scale);
+	glTexCoord2fv_fp (ptex_coord[i][2]);
+	glVertex3f_fp (p->org[0] + r_pright[0]*scale, p->org[1] + r_pright[1]*scale, p->org[2] + r_pright[2]*scale);
+}
+
+void R_DrawParticles (void)
+{
+	particle_t	temp_p;
+	pchunk_t	*c;
+	int		g, i;
+
 	//ericw -- avoid empty glBegin/glEnd pair below.
-	if (!active_particles)
+	if (!r_numactive && !r_numspawned)
 		return;
 
 	GL_Bind(particletexture);
@@ -1399,46 +1671,19 @@ void R_DrawParticles (void)
 	VectorScale (vup, 1.5, r_pup);
 	VectorScale (vright, 1.5, r_pright);
 
-	for (p = active_particles ; p ; p = p->next)
+	for (g = 0; g < PT_NUMGROUPS; g++)
 	{
-		// hack a scale up to keep particles from disapearing
-		scale = (p->org[0] - r_origin[0])*vpn[0] +
-			(p->org[1] - r_origin[1])*vpn[1] +
-			(p->org[2] - r_origin[2])*vpn[2];
-		if (scale < 20)
-			scale = SCALE_BASE;
-		else
-			scale = SCALE_BASE + scale * 0.004;
-
-	/* clamp color to 0-511: particle->type 10 and 11 (pt_c_explode
-	 * and pt_c_explode2, e.g. Crusader's ice particles hitting a
-	 * wall) lead to negative values, because R_UpdateParticles ()
-	 * decrements their color against time. */
-		color = ((int)p->color) & 0x01ff;
-		if (color < 256)
-			glColor3ubv_fp ((byte *)&d_8to24table[color]);
-		else
-			glColor4ubv_fp ((byte *)&d_8to24TranslucentTable[color-256]);
-
-		// setup texture coordinates
-		i = 0;
-		if (p->type == pt_snow)
+		for (c = r_pgroups[g]; c; c = c->next)
 		{
-			if (p->count >= 69)
-				i = 3;	// happy snow!
-			else if (p->count >= 40)
-				i = 2;
-			else if (p->count >= 30)
-				i = 1;
+			for (i = 0; i < c->count; i++)
+			{
+				R_GetParticle (c, i, &temp_p);
+				R_RenderParticle (&temp_p);
+			}
 		}
-
-		glTexCoord2fv_fp (ptex_coord[i][0]);
-		glVertex3fv_fp (p->org);
-		glTexCoord2fv_fp (ptex_coord[i][1]);
-		glVertex3f_fp (p->org[0] + r_pup[0]*scale, p->org[1] + r_pup[1]*scale, p->org[2] + r_pup[2]*scale);
-		glTexCoord2fv_fp (ptex_coord[i][2]);
-		glVertex3f_fp (p->org[0] + r_pright[0]*scale, p->org[1] + r_pright[1]*scale, p->org[2] + r_pright[2]*scale);
 	}
+	for (i = 0; i < r_numspawned; i++)
+		R_RenderParticle (&r_spawned[i]);
 
 	glEnd_fp ();
 	glDisable_fp (GL_BLEND);
@@ -1447,573 +1692,730 @@ void R_DrawParticles (void)
 
 #else	/* !GLQUAKE */
 
-void R_DrawParticles (void)
+static void R_RenderParticle (particle_t *p)
 {
-	particle_t	*p;
 	int		i;
 	float		vel0, vel1, vel2;
 	vec3_t		save_org;
 
+	switch (p->type)
+	{
+	case pt_snow:
+		VectorCopy(p->org, save_org);
+		D_DrawParticle (p);
+
+		for (i = 1; i < p->count; i++)
+		{
+			switch (i)
+			{
+			// FIXME:  More translucency
+			//	   on outside particles?
+
+		//	case 0:
+		//	// original
+		//		break;
+			case 1:
+			// One to right
+				p->org[0] = save_org[0] + vright[0];
+				p->org[1] = save_org[1] + vright[1];
+				p->org[2] = save_org[2] + vright[2];
+				break;
+			case 2:
+			// One above
+				p->org[0] = save_org[0] + vup[0];
+				p->org[1] = save_org[1] + vup[1];
+				p->org[2] = save_org[2] + vup[2];
+				break;
+			case 3:
+			// One to left
+				p->org[0] = save_org[0] - vright[0];
+				p->org[1] = save_org[1] - vright[1];
+				p->org[2] = save_org[2] - vright[2];
+				break;
+			case 4:
+			// One below
+				p->org[0] = save_org[0] - vup[0];
+				p->org[1] = save_org[1] - vup[1];
+				p->org[2] = save_org[2] - vup[2];
+				break;
+			default:
+				Con_Printf ("count too big!\n");
+				break;
+			}
+			D_DrawParticle (p);
+		}
+		VectorCopy(save_org, p->org);	// Restore origin
+		break;
+
+	case pt_rain:
+		VectorCopy(p->org, save_org);
+
+		vel0 = p->vel[0]*.001;
+		vel1 = p->vel[1]*.001;
+		vel2 = p->vel[2]*.001;
+
+		for (i = 0; i < 4; i++)
+		{
+			D_DrawParticle(p);
+			p->org[0] += vel0;
+			p->org[1] += vel1;
+			p->org[2] += vel2;
+		}
+		D_DrawParticle(p);
+
+		VectorCopy(save_org, p->org);	// Restore origin
+		break;
+
+	default:
+		D_DrawParticle (p);
+		break;
+	}
+}
+
+void R_DrawParticles (void)
+{
+	particle_t	temp_p;
+	pchunk_t	*c;
+	int		g, i;
+
 	D_StartParticles ();
 
 	VectorScale (vright, xscaleshrink, r_pright);
 	VectorScale (vup, yscaleshrink, r_pup);
 	VectorCopy (vpn, r_ppn);
 
-	for (p = active_particles ; p ; p = p->next)
+	for (g = 0; g < PT_NUMGROUPS; g++)
 	{
-		switch (p->type)
+		for (c = r_pgroups[g]; c; c = c->next)
 		{
-		case pt_snow:
-			VectorCopy(p->org, save_org);
-			D_DrawParticle (p);
-
-			for (i = 1; i < p->count; i++)
+			for (i = 0; i < c->count; i++)
 			{
-				switch (i)
+				R_GetParticle (c, i, &temp_p);
+				if (g == pt_rain)
 				{
-				// FIXME:  More translucency
-				//	   on outside particles?
-
-			//	case 0:
-			//	// original
-			//		break;
-				case 1:
-				// One to right
-					p->org[0] = save_org[0] + vright[0];
-					p->org[1] = save_org[1] + vright[1];
-					p->org[2] = save_org[2] + vright[2];
-					break;
-				case 2:
-				// One above
-					p->org[0] = save_org[0] + vup[0];
-					p->org[1] = save_org[1] + vup[1];
-					p->org[2] = save_org[2] + vup[2];
-					break;
-				case 3:
-				// One to left
-					p->org[0] = save_org[0] - vright[0];
-					p->org[1] = save_org[1] - vright[1];
-					p->org[2] = save_org[2] - vright[2];
-					break;
-				case 4:
-				// One below
-					p->org[0] = save_org[0] - vup[0];
-					p->org[1] = save_org[1] - vup[1];
-					p->org[2] = save_org[2] - vup[2];
-					break;
-				default:
-					Con_Printf ("count too big!\n");
-					break;
+					temp_p.vel[0] = c->vel[0][i];
+					temp_p.vel[1] = c->vel[1][i];
+					temp_p.vel[2] = c->vel[2][i];
 				}
-				D_DrawParticle (p);
+				R_RenderParticle (&temp_p);
 			}
-			VectorCopy(save_org, p->org);	// Restore origin
-			break;
-
-		case pt_rain:
-			VectorCopy(p->org, save_org);
-
-			vel0 = p->vel[0]*.001;
-			vel1 = p->vel[1]*.001;
-			vel2 = p->vel[2]*.001;
-
-			for (i = 0; i < 4; i++)
-			{
-				D_DrawParticle(p);
-				p->org[0] += vel0;
-				p->org[1] += vel1;
-				p->org[2] += vel2;
- 			}
-			D_DrawParticle(p);
-
-			VectorCopy(save_org, p->org);	// Restore origin
-			break;
-
-		default:
-			D_DrawParticle (p);
-			break;
 		}
 	}
+	for (i = 0; i < r_numspawned; i++)
+		R_RenderParticle (&r_spawned[i]);
 
 	D_EndParticles ();
 }
 #endif	/* R_DrawParticles */
 
 
-void R_UpdateParticles (void)
+/*
+===============
+R_MoveParticles
+
+The flight of all but rain and snow, one coordinate at a time so that
+the compiler can vectorize it
+===============
+*/
+static void R_MoveParticles (pchunk_t *c, float frametime)
 {
-	particle_t	*p, *kill;
-	float		grav, grav2, percent;
-	int		i;
-	float		time2, time3, time4;
-	float		time1;
-	float		dvel;
-	float		frametime;
-	float		vel0, vel1, vel2;
-	float		colindex;
-	vec3_t		diff;
-//	vec3_t		save_org;
-//	float		speed;
-//	qboolean	in_solid;
+	int		i, j;
 
-	if (cls.state == ca_disconnected)
-		return;
+	for (j = 0; j < 3; j++)
+	{
+		for (i = 0; i < c->count; i++)
+			c->org[j][i] += c->vel[j][i] * frametime;
+	}
+}
 
-	frametime = cl.time - cl.oldtime;
-//	Con_Printf("%10.5f\n", frametime);
-	time4 = frametime * 20;
-	time3 = frametime * 15;
-	time2 = frametime * 10;
-	time1 = frametime * 5;
-	grav = frametime * sv_gravity.value * 0.05;
-	grav2 = frametime * sv_gravity.value * 0.025;
-	dvel = 4 * frametime;
-	percent = (frametime / HX_FRAME_TIME);
+static void R_MoveRain (pchunk_t *c, float frametime)
+{
+	float		step;
+	int		i, j, k;
 
-	for ( ;; )
+	for (j = 0; j < 3; j++)
 	{
-		kill = active_particles;
-		if (kill && kill->die < cl.time)
+		for (i = 0; i < c->count; i++)
 		{
-			active_particles = kill->next;
-			kill->next = free_particles;
-			free_particles = kill;
-			continue;
+			step = c->vel[j][i]*.001;
+			for (k = 0; k < 4; k++)
+				c->org[j][i] += step;
+			c->org[j][i] += c->vel[j][i] * (frametime - .004);
 		}
-		break;
 	}
+}
+
+static void R_RunSnow (pchunk_t *c, float frametime)
+{
+	pextra_t	*ex;
+	mleaf_t		*l;
+	vec3_t		org, vel, diff;
+	float		*color, *ramp, *die;
+	int		i, j, k;
 
-	for (p = active_particles ; p ; p = p->next)
+	color = c->color;
+	ramp = c->ramp;
+	die = c->die;
+
+	for (i = 0; i < c->count; i++)
 	{
-		for ( ;; )
+		for (j = 0; j < 3; j++)
 		{
-			kill = p->next;
-			if (kill && kill->die < cl.time)
-			{
-				p->next = kill->next;
-				kill->next = free_particles;
-				free_particles = kill;
-				continue;
-			}
-			break;
+			org[j] = c->org[j][i];
+			vel[j] = c->vel[j][i];
 		}
+		ex = &c->extra[i];
 
-		if (p->type == pt_rain)
+		if (vel[0] == 0 && vel[1] == 0 && vel[2] == 0)
 		{
-			vel0 = p->vel[0]*.001;
-			vel1 = p->vel[1]*.001;
-			vel2 = p->vel[2]*.001;
-			for (i = 0; i < 4; i++)
+		// Stopped moving
+			if (color[i] == 256 + 31)	// Most translucent white
 			{
-				p->org[0] += vel0;
-				p->org[1] += vel1;
-				p->org[2] += vel2;
-			}
-			p->org[0] += p->vel[0] * (frametime - .004);
-			p->org[1] += p->vel[1] * (frametime - .004);
-			p->org[2] += p->vel[2] * (frametime - .004);
-		}
-		else if (p->type == pt_snow)
-		{
-			if (p->vel[0] == 0 && p->vel[1] == 0 && p->vel[2] == 0)
-			{
-			// Stopped moving
-				if (p->color == 256 + 31)	// Most translucent white
-				{
-				// Go away
-					p->die = -1;
-				}
-				else
-				{
-				// Count fifty and fade in translucency
-				// once each time
-					p->ramp += 1;
-					if (p->ramp >= 7)
-					{
-						p->color += 1;	//Get more translucent
-						p->ramp = 0;
-					}
-				}
+			// Go away
+				die[i] = -1;
 			}
 			else
 			{
-			// FIXME: If flake going fast enough, can go through,
-			//	  do a check in increments ot 10, max?
-			// if not in_bounds Get length of diff, add in
-			// increments of 4 & check solid
-				mleaf_t		*l;
-
-				if (snow_flurry.integer == 1)
+			// Count fifty and fade in translucency
+			// once each time
+				ramp[i] += 1;
+				if (ramp[i] >= 7)
 				{
-				    if (rand() & 31)
-				    {
-				// Add flurry movement
-					float			snow_speed;
-					vec3_t			save_vel;
-					snow_speed = p->vel[0] * p->vel[0] +
-							p->vel[1] * p->vel[1] +
-							p->vel[2] * p->vel[2];
-					snow_speed = Q_sqrt(snow_speed);
-
-					VectorCopy(p->vel, save_vel);
-
-					save_vel[0] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
-					save_vel[1] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
-					if ((rand() & 7) || p->vel[2] > 10)
-						save_vel[2] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
-
-					VectorNormalizeFast(save_vel);
-					VectorScale(save_vel, snow_speed, p->vel);	// retain speed but use new dir
-				    }
+					color[i] += 1;	//Get more translucent
+					ramp[i] = 0;
 				}
+			}
+			continue;
+		}
 
-				/*
-				VectorScale(p->vel, frametime, diff);
-				speed = VectorNormalize(diff);
-				in_solid = false;
-				if (!(p->flags & SFL_IN_BOUNDS))
-				{
-				// Not cut off by bounds
-					if (speed >= 8)
-					{
-					// Moving more than 8 pixels this turn
-						for (i = 4; i < speed; i += 4)
-						{
-						// Check for solid in increments of 4
-							VectorScale(diff, i, save_org);
-							VectorAdd(p->org, save_org, save_org);
-						//	if (SV_PointContents(save_org) != CONTENTS_EMPTY)
-								l = Mod_PointInLeaf (save_org, cl.worldmodel);
-							if (l->contents != CONTENTS_EMPTY)
-							{
-								in_solid = true;
-								VectorCopy(save_org, p->org);
-								break;
-							}
-						}
-					}
-				}
+	// FIXME: If flake going fast enough, can go through,
+	//	  do a check in increments ot 10, max?
+	// if not in_bounds Get length of diff, add in
+	// increments of 4 & check solid
+		if (snow_flurry.integer == 1)
+		{
+		    if (rand() & 31)
+		    {
+		// Add flurry movement
+			float			snow_speed;
+			vec3_t			save_vel;
+			snow_speed = vel[0] * vel[0] +
+					vel[1] * vel[1] +
+					vel[2] * vel[2];
+			snow_speed = Q_sqrt(snow_speed);
+
+			VectorCopy(vel, save_vel);
+
+			save_vel[0] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
+			save_vel[1] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
+			if ((rand() & 7) || vel[2] > 10)
+				save_vel[2] += ( (rand() * (2.0 / RAND_MAX)) - 1 ) * 30;
+
+			VectorNormalizeFast(save_vel);
+			VectorScale(save_vel, snow_speed, vel);	// retain speed but use new dir
+		    }
+		}
 
-				if (!in_solid)
-				*/
-				{
-					VectorScale(p->vel, frametime, diff);
-					VectorAdd(p->org, diff, p->org);
-				}
+		VectorScale(vel, frametime, diff);
+		VectorAdd(org, diff, org);
 
-				if (p->flags & SFL_IN_BOUNDS)
+		if (ex->flags & SFL_IN_BOUNDS)
+		{
+		// Always stay inside the boundry!
+			if ( org[0] < ex->min_org[0]	||
+				org[0] > ex->max_org[0] ||
+				org[1] < ex->min_org[1] ||
+				org[1] > ex->max_org[1] ||
+				org[2] < ex->min_org[2] ||
+				org[2] > ex->max_org[2] )
+			{
+				die[i] = -1;
+			}
+		}
+		else
+		{
+			// if hit solid, go to last position,
+			// no velocity, fade out.
+			l = Mod_PointInLeaf (org, cl.worldmodel);
+			if (l->contents != CONTENTS_EMPTY)
+			{
+				if (ex->flags & SFL_NO_MELT)
 				{
-				// Always stay inside the boundry!
-					if ( p->org[0] < p->min_org[0]	||
-						p->org[0] > p->max_org[0] ||
-						p->org[1] < p->min_org[1] ||
-						p->org[1] > p->max_org[1] ||
-						p->org[2] < p->min_org[2] ||
-						p->org[2] > p->max_org[2] )
-					{
-						p->die = -1;
-					}
+				// Don't melt, just die
+					die[i] = -1;
 				}
 				else
 				{
-					// if hit solid, go to last position,
-					// no velocity, fade out.
-					l = Mod_PointInLeaf (p->org, cl.worldmodel);
-					if (l->contents != CONTENTS_EMPTY) // || in_solid == true
+				// still have small prob of snow melting on emitter
+					VectorScale(diff, 0.2, vel);
+					k = 6;
+					while (l->contents != CONTENTS_EMPTY)
 					{
-						if (p->flags & SFL_NO_MELT)
+						org[0] -= vel[0];
+						org[1] -= vel[1];
+						org[2] -= vel[2];
+						k--; //no infinite loops
+						if (!k)
 						{
-						// Don't melt, just die
-							p->die = -1;
-						}
-						else
-						{
-						// still have small prob of snow melting on emitter
-							VectorScale(diff, 0.2, p->vel);
-							i = 6;
-							while (l->contents != CONTENTS_EMPTY)
-							{
-								p->org[0] -= p->vel[0];
-								p->org[1] -= p->vel[1];
-								p->org[2] -= p->vel[2];
-								i--; //no infinite loops
-								if (!i)
-								{
-									p->die = -1;	//should never happen now!
-									break;
-								}
-								l = Mod_PointInLeaf (p->org, cl.worldmodel);
-							}
-							p->vel[0] = p->vel[1] = p->vel[2] = 0;
-							p->ramp = 0;
+							die[i] = -1;	//should never happen now!
+							break;
 						}
+						l = Mod_PointInLeaf (org, cl.worldmodel);
 					}
+					vel[0] = vel[1] = vel[2] = 0;
+					ramp[i] = 0;
 				}
 			}
 		}
-		else
+
+		for (j = 0; j < 3; j++)
 		{
-			p->org[0] += p->vel[0] * frametime;
-			p->org[1] += p->vel[1] * frametime;
-			p->org[2] += p->vel[2] * frametime;
+			c->org[j][i] = org[j];
+			c->vel[j][i] = vel[j];
 		}
+	}
+}
+
+/*
+===============
+R_RunParticles
+
+Moves the particles and runs their color ramps, type by type
+===============
+*/
+static void R_RunParticles (float frametime)
+{
+	float		grav, grav2, percent;
+	float		time2, time3, time4;
+	float		time1;
+	float		dvel, scale;
+	float		colindex;
+	float		*ox, *oy, *oz;
+	float		*vx, *vy, *vz;
+	float		*color, *ramp, *die;
+	pchunk_t	*c;
+	int		t, i, n;
+
+	time4 = frametime * 20;
+	time3 = frametime * 15;
+	time2 = frametime * 10;
+	time1 = frametime * 5;
+	grav = frametime * sv_gravity.value * 0.05;
+	grav2 = frametime * sv_gravity.value * 0.025;
+	dvel = 4 * frametime;
+	percent = (frametime / HX_FRAME_TIME);
 
-		switch (p->type)
+	for (t = 0; t < PT_NUMGROUPS; t++)
+	{
+	    for (c = r_pgroups[t]; c; c = c->next)
+	    {
+		switch (t)
 		{
-		case pt_static:
+		case pt_rain:
+			R_MoveRain (c, frametime);
+			break;
+		case pt_snow:
+			R_RunSnow (c, frametime);
+			break;
+		default:
+			R_MoveParticles (c, frametime);
 			break;
+		}
 
+		n = c->count;
+		ox = c->org[0];
+		oy = c->org[1];
+		oz = c->org[2];
+		vx = c->vel[0];
+		vy = c->vel[1];
+		vz = c->vel[2];
+		color = c->color;
+		ramp = c->ramp;
+		die = c->die;
+
+		switch (t)
+		{
 		case pt_fire:
-			p->ramp += time1;
-			if ((int)p->ramp >= 6)
-				p->die = -1;
-			else
-				p->color = ramp3[(int)p->ramp];
-			p->vel[2] += grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time1;
+				if ((int)ramp[i] >= 6)
+					die[i] = -1;
+				else
+					color[i] = ramp3[(int)ramp[i]];
+				vz[i] += grav;
+			}
 			break;
 
 		case pt_explode:
-			p->ramp += time2;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp1[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp1[(int)ramp[i]];
+				vx[i] += vx[i]*dvel;
+				vy[i] += vy[i]*dvel;
+				vz[i] += vz[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_explode2:
-			p->ramp += time3;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp2[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] -= p->vel[i] * frametime;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp2[(int)ramp[i]];
+				vx[i] -= vx[i] * frametime;
+				vy[i] -= vy[i] * frametime;
+				vz[i] -= vz[i] * frametime;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_c_explode:
-			p->ramp += time2;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else if (time2)
-				p->color--;
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else if (time2)
+					color[i]--;
+				vx[i] += vx[i]*dvel;
+				vy[i] += vy[i]*dvel;
+				vz[i] += vz[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_c_explode2:
-			p->ramp += time3;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else if (time3)
-				p->color -= 2;
-			for (i = 0; i < 3; i++)
-				p->vel[i] -= p->vel[i] * frametime;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else if (time3)
+					color[i] -= 2;
+				vx[i] -= vx[i] * frametime;
+				vy[i] -= vy[i] * frametime;
+				vz[i] -= vz[i] * frametime;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_grav:
 #ifdef QUAKE2
-			p->vel[2] -= grav * 20;
+			for (i = 0; i < n; i++)
+				vz[i] -= grav * 20;
 			break;
 #endif
 		case pt_slowgrav:
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+				vz[i] -= grav;
 			break;
 
 		case pt_fastgrav:
-			p->vel[2] -= grav * 4;
-			break;
-
-		case pt_rain:
-			break;
-
-		case pt_snow:
+			for (i = 0; i < n; i++)
+				vz[i] -= grav * 4;
 			break;
 
 		case pt_fireball:
-			p->ramp += time3;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp4[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp4[(int)ramp[i]];
+			}
 			break;
 
 		case pt_acidball:
-			p->ramp += time4 * 1.4;
-			if ((int)p->ramp >= 23)
-				p->die = -1;
-			else if ((int)p->ramp >= 15)
-				p->color = ramp11[(int)p->ramp - 15];
-			else
-				p->color = ramp10[(int)p->ramp];
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time4 * 1.4;
+				if ((int)ramp[i] >= 23)
+					die[i] = -1;
+				else if ((int)ramp[i] >= 15)
+					color[i] = ramp11[(int)ramp[i] - 15];
+				else
+					color[i] = ramp10[(int)ramp[i]];
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_spit:
-			p->ramp += time3;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp6[(int)p->ramp];
-		//	p->vel[2] += grav * 2;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp6[(int)ramp[i]];
+			}
 			break;
 
 		case pt_ice:
-			p->ramp += time4;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp5[(int)p->ramp];
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time4;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp5[(int)ramp[i]];
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_spell:
-			p->ramp += time2;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp7[(int)p->ramp];
-		//	p->vel[2] += grav * 2;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp7[(int)ramp[i]];
+			}
 			break;
 
 		case pt_test:
-			p->vel[2] += 1.3;
-			p->ramp += time3;
-			if ((int)p->ramp >= 13 || ((int)p->ramp > 10 && (int)p->vel[2] < 20) )
-				p->die = -1;
-			else
-				p->color = ramp8[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				vz[i] += 1.3;
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 13 || ((int)ramp[i] > 10 && (int)vz[i] < 20) )
+					die[i] = -1;
+				else
+					color[i] = ramp8[(int)ramp[i]];
+			}
 			break;
 
 		case pt_quake:
-			p->vel[0] *= 1.05;
-			p->vel[1] *= 1.05;
-			p->vel[2] -= grav * 4;
+			for (i = 0; i < n; i++)
+			{
+				vx[i] *= 1.05;
+				vy[i] *= 1.05;
+				vz[i] -= grav * 4;
+			}
 			break;
 
 		case pt_rd:
 			if (!frametime)
 				break;
 
-			p->ramp += percent;
-			if ((int)p->ramp > 50)
+			for (i = 0; i < n; i++)
 			{
-				p->ramp = 50;
-				p->die = -1;
-			}
-			p->color = 256 + 16 + 16 - (p->ramp / (50/16));
-
-			VectorSubtract(rider_origin, p->org, diff);
-
-			/*
-			p->org[0] += diff[0] * p->ramp / 80;
-			p->org[1] += diff[1] * p->ramp / 80;
-			p->org[2] += diff[2] * p->ramp / 80;
-			*/
-			vel0 = 1 / (51 - p->ramp);
-			p->org[0] += diff[0] * vel0;
-			p->org[1] += diff[1] * vel0;
-			p->org[2] += diff[2] * vel0;
+				ramp[i] += percent;
+				if ((int)ramp[i] > 50)
+				{
+					ramp[i] = 50;
+					die[i] = -1;
+				}
+				color[i] = 256 + 16 + 16 - (ramp[i] / (50/16));
 
+				scale = 1 / (51 - ramp[i]);
+				ox[i] += (rider_origin[0] - ox[i]) * scale;
+				oy[i] += (rider_origin[1] - oy[i]) * scale;
+				oz[i] += (rider_origin[2] - oz[i]) * scale;
+			}
 			break;
 
 		case pt_gravwell:
 			if (!frametime)
 				break;
 
-			p->ramp += percent;
-			if ((int)p->ramp > 35)
+			for (i = 0; i < n; i++)
 			{
-				p->ramp = 35;
-				p->die = -1;
-			}
-
-			VectorSubtract(rider_origin, p->org, diff);
-			/*
-			p->org[0] += diff[0] * p->ramp / 80;
-			p->org[1] += diff[1] * p->ramp / 80;
-			p->org[2] += diff[2] * p->ramp / 80;
-			*/
-
-			vel0 = 1 / (36 - p->ramp);
-			p->org[0] += diff[0] * vel0;
-			p->org[1] += diff[1] * vel0;
-			p->org[2] += diff[2] * vel0;
+				ramp[i] += percent;
+				if ((int)ramp[i] > 35)
+				{
+					ramp[i] = 35;
+					die[i] = -1;
+				}
 
+				scale = 1 / (36 - ramp[i]);
+				ox[i] += (rider_origin[0] - ox[i]) * scale;
+				oy[i] += (rider_origin[1] - oy[i]) * scale;
+				oz[i] += (rider_origin[2] - oz[i]) * scale;
+			}
 			break;
 
 		case pt_vorpal:
-			--p->color;
-			if ((int)p->color <= 37 + 256)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] <= 37 + 256)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_setstaff:
-			p->ramp += time1;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp9[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time1;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp9[(int)ramp[i]];
 
-			p->vel[0] *= 1.08 * percent;
-			p->vel[1] *= 1.08 * percent;
-			p->vel[2] -= grav2;
+				vx[i] *= 1.08 * percent;
+				vy[i] *= 1.08 * percent;
+				vz[i] -= grav2;
+			}
 			break;
 
 		case pt_redfire:
-			p->ramp += frametime * 3;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp12[(int)p->ramp] + 256;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += frametime * 3;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp12[(int)ramp[i]] + 256;
 
-			p->vel[0] *= .9;
-			p->vel[1] *= .9;
-			p->vel[2] += grav/2;
+				vx[i] *= .9;
+				vy[i] *= .9;
+				vz[i] += grav/2;
+			}
 			break;
 
 		case pt_magicmissile:
-			--p->color;
-			if ((int)p->color < 149)
-				p->color = 149;
-			p->ramp += time1;
-			if ((int)p->ramp > 16)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 149)
+					color[i] = 149;
+				ramp[i] += time1;
+				if ((int)ramp[i] > 16)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_boneshard:
-			--p->color;
-			if ((int)p->color < 368)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 368)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_scarab:
-			--p->color;
-			if ((int)p->color < 250)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 250)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_darken:
-			p->vel[2] -= grav;	//Also gravity
-			--p->color;
-			colindex = 0;
-			while (colindex < 224)
+			for (i = 0; i < n; i++)
 			{
-				if (colindex == 192 || colindex == 200)
-					colindex += 8;
-				else
-					colindex += 16;
-				if (p->color == colindex)
-					p->die = -1;
+				vz[i] -= grav;	//Also gravity
+				--color[i];
+				colindex = 0;
+				while (colindex < 224)
+				{
+					if (colindex == 192 || colindex == 200)
+						colindex += 8;
+					else
+						colindex += 16;
+					if (color[i] == colindex)
+						die[i] = -1;
+				}
 			}
-		    break;
+			break;
+
+		default:	// static, rain and snow, or unknown
+			break;
 		}
+	    }
 	}
 }
 
+void R_UpdateParticles (void)
+{
+	if (cls.state == ca_disconnected)
+		return;
+
+	R_PackParticles ();
+	R_RunParticles (cl.time - cl.oldtime);
+}
+
+
+/*
+===============
+R_ParticleBench_f
+
+r_particlebench [count] [frames] keeps count particles of assorted types
+in front of the view and times packing and updating them, frame after
+frame.  The particles are left alive, so that a timerefresh right after
+it times drawing them.
+===============
+*/
+static const byte bench_types[] =
+{
+	pt_static, pt_grav, pt_slowgrav, pt_fire, pt_explode, pt_explode2,
+	pt_c_explode, pt_spit, pt_ice, pt_spell, pt_setstaff, pt_rain, pt_darken
+};
+
+static void R_ParticleBench_f (void)
+{
+	particle_t	*p;
+	vec3_t		org;
+	double		start, packtime, runtime;
+	int		count, frames, i, j, k;
+
+	if (cls.state != ca_connected)
+	{
+		Con_Printf ("r_particlebench needs a running map\n");
+		return;
+	}
+
+	count = (Cmd_Argc() > 1) ? atoi(Cmd_Argv(1)) : r_numparticles;
+	frames = (Cmd_Argc() > 2) ? atoi(Cmd_Argv(2)) : 100;
+	if (count < 1 || count > r_numparticles)
+	{
+		Con_Printf ("count must be 1 to %d (r_maxparticles)\n", r_numparticles);
+		return;
+	}
+	if (frames < 1)
+		frames = 1;
+
+	VectorMA (r_refdef.vieworg, 128, vpn, org);
+	R_ClearParticles ();
+	packtime = runtime = 0;
+
+	for (i = 0; i < frames; i++)
+	{
+		for (j = r_numactive + r_numspawned; j < count; j++)
+		{
+			p = AllocParticle ();
+			p->type = bench_types[rand() % (sizeof(bench_types) / sizeof(bench_types[0]))];
+			p->die = cl.time + 1000;
+			p->color = rand() & 255;
+			p->ramp = rand() & 3;
+			for (k = 0; k < 3; k++)
+			{
+				p->org[k] = org[k] + (rand() & 63) - 32;
+				p->vel[k] = (rand() & 255) - 128;
+			}
+		}
+
+		start = Sys_DoubleTime ();
+		R_PackParticles ();
+		packtime += Sys_DoubleTime () - start;
+
+		start = Sys_DoubleTime ();
+		R_RunParticles (HX_FRAME_TIME);
+		runtime += Sys_DoubleTime () - start;
+	}
+
+	Con_Printf ("%d particles: %.3f ms packing, %.3f ms updating per frame\n",
+			count, packtime * 1000.0 / frames, runtime * 1000.0 / frames);
+}
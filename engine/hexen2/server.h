@@ -308,4 +308,37 @@ void SV_UpdateEffects (sizebuf_t *sb);
 void SV_SaveEffects (FILE *FH);
 void SV_LoadEffects (FILE *FH);
 
+#if defined(SERVERONLY)
+/* sv_replay.c: recording and benchmark replay of client traffic */
+#define	SV_REPLAY_NONE		0
+#define	SV_REPLAY_RECORD	1
+#define	SV_REPLAY_PLAY		2
+
+typedef enum
+{
+	svphase_clients,	/* new connections and client messages */
+	svphase_physics,	/* SV_Physics and QuakeC */
+	svphase_send,		/* building and sending client updates */
+	SV_REPLAY_NUMPHASES
+} svphase_t;
+
+extern	int	sv_replay;
+
+struct qsocket_s;
+void SV_ReplayInit (void);
+int  SV_ReplayMaxClients (void);
+void SV_ReplayRecordFrame (float time);
+void SV_ReplayRecordConsole (const char *text);
+void SV_ReplayRecordConnect (struct qsocket_s *sock);
+void SV_ReplayRecordMessage (struct qsocket_s *sock, int ret);
+void SV_ReplayRecordClose (struct qsocket_s *sock);
+const char *SV_ReplayConsoleInput (void);
+struct qsocket_s *SV_ReplayCheckNewConnections (void);
+int  SV_ReplayGetMessage (struct qsocket_s *sock);
+void SV_ReplayClose (struct qsocket_s *sock);
+void SV_ReplayPhase (int phase, double seconds);
+FUNC_NORETURN void SV_ReplayRun (void);
+void SV_ReplayShutdown (void);
+#endif	/* SERVERONLY */
+
 #endif	/* __HX2_SERVER_H */
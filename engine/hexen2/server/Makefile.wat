@@ -111,6 +111,7 @@ OBJECTS = &
 	mathlib.obj &
 	zone.obj &
 	hashindex.obj &
+	pvscache.obj &
 	$(SYSOBJ_NET) &
 	net_dgrm.obj &
 	net_main.obj &
@@ -125,6 +126,7 @@ OBJECTS = &
 	sv_main.obj &
 	sv_move.obj &
 	sv_phys.obj &
+	sv_replay.obj &
 	sv_user.obj &
 	world.obj &
 	$(SYSOBJ_SYS)
@@ -193,6 +193,8 @@ static void Host_FindMaxClients (void)
 	i = COM_CheckParm ("-dedicated");
 	if (i && i < com_argc-1)
 		svs.maxclients = atoi (com_argv[i+1]);
+	if (sv_replay == SV_REPLAY_PLAY)
+		svs.maxclients = SV_ReplayMaxClients ();
 
 	if (svs.maxclients < 2)
 		svs.maxclients = 8;
@@ -532,9 +534,13 @@ static void Host_GetConsoleCommands (void)
 
 	while (1)
 	{
-		cmd = Sys_ConsoleInput ();
+		if (sv_replay == SV_REPLAY_PLAY)
+			cmd = SV_ReplayConsoleInput ();
+		else	cmd = Sys_ConsoleInput ();
 		if (!cmd)
 			break;
+		if (sv_replay == SV_REPLAY_RECORD)
+			SV_ReplayRecordConsole (cmd);
 		Cbuf_AddText (cmd);
 	}
 }
@@ -548,25 +554,43 @@ Host_ServerFrame
 */
 static void Host_ServerFrame (void)
 {
+	double	time1 = 0, time2 = 0, time3 = 0;
+
 // run the world state
 	*sv_globals.frametime = host_frametime;
 
 // set the time and clear the general datagram
 	SV_ClearDatagram ();
 
+	if (sv_replay == SV_REPLAY_PLAY)
+		time1 = Sys_DoubleTime ();
+
 // check for new clients
 	SV_CheckForNewClients ();
 
 // read client messages
 	SV_RunClients ();
 
+	if (sv_replay == SV_REPLAY_PLAY)
+		time2 = Sys_DoubleTime ();
+
 // move things around and think
 // always pause in single player if in console or menus
 	if (!sv.paused)
 		SV_Physics ();
 
+	if (sv_replay == SV_REPLAY_PLAY)
+		time3 = Sys_DoubleTime ();
+
 // send all messages to the clients
 	SV_SendClientMessages ();
+
+	if (sv_replay == SV_REPLAY_PLAY)
+	{
+		SV_ReplayPhase (svphase_clients, time2 - time1);
+		SV_ReplayPhase (svphase_physics, time3 - time2);
+		SV_ReplayPhase (svphase_send, Sys_DoubleTime () - time3);
+	}
 }
 
 /*
@@ -578,6 +602,9 @@ Runs all active servers
 */
 static void _Host_Frame (float time)
 {
+	if (sv_replay == SV_REPLAY_RECORD)
+		SV_ReplayRecordFrame (time);
+
 // keep the random time dependent
 	rand ();
 
@@ -661,6 +688,7 @@ void Host_Init (void)
 	SV_Init ();
 	FS_Init ();
 	Host_RemoveGIPFiles(NULL);
+	SV_ReplayInit ();
 	Host_InitLocal ();
 	PR_Init ();
 	Mod_Init ();
@@ -677,6 +705,9 @@ void Host_Init (void)
 
 	Cvar_UnlockAll ();			/* unlock the early-set cvars after init */
 
+	if (sv_replay == SV_REPLAY_PLAY)	/* -replay: run the recording and quit */
+		SV_ReplayRun ();
+
 	Cbuf_InsertText ("exec server.cfg\n");
 	Cbuf_Execute ();
 
@@ -707,6 +738,7 @@ void Host_Shutdown(void)
 	isdown = true;
 
 	NET_Shutdown ();
+	SV_ReplayShutdown ();
 	LOG_Close ();
 }
 
@@ -626,13 +626,13 @@ crosses a waterline.
 =============================================================================
 */
 
-static int	fatbytes;
-static byte	fatpvs[MAX_MAP_LEAFS/8];
+static int	fatwords;
+static unsigned int	fatpvs[(MAX_MAP_LEAFS+31)/32];
 
 static void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 {
 	int		i;
-	byte	*pvs;
+	unsigned int	*pvs;
 	mplane_t	*plane;
 	float	d;
 
@@ -643,8 +643,9 @@ static void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 		{
 			if (node->contents != CONTENTS_SOLID)
 			{
-				pvs = Mod_LeafPVS ( (mleaf_t *)node, sv.worldmodel);
-				for (i = 0; i < fatbytes; i++)
+				// the pvs rows are padded to whole words
+				pvs = (unsigned int *) Mod_LeafPVS ( (mleaf_t *)node, sv.worldmodel);
+				for (i = 0; i < fatwords; i++)
 					fatpvs[i] |= pvs[i];
 			}
 			return;
@@ -674,10 +675,10 @@ given point.
 */
 static byte *SV_FatPVS (vec3_t org)
 {
-	fatbytes = (sv.worldmodel->numleafs+31)>>3;
-	memset (fatpvs, 0, fatbytes);
+	fatwords = (sv.worldmodel->numleafs+31)>>5;
+	memset (fatpvs, 0, fatwords * sizeof(unsigned int));
 	SV_AddToFatPVS (org, sv.worldmodel->nodes);
-	return fatpvs;
+	return (byte *)fatpvs;
 }
 
 #define CLIENT_FRAME_INIT	255
@@ -1936,6 +1937,7 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	static char	dummy[8] = { 0,0,0,0,0,0,0,0 };
 	edict_t		*ent;
 	int			i;
+	double		time1, time2, time3, time4;
 
 	// let's not have any servers with no name
 	if (hostname.string[0] == 0)
@@ -1945,6 +1947,7 @@ void SV_SpawnServer (const char *server, const char *startspot)
 #endif
 
 	Con_DPrintf ("%s: %s\n", __thisfunc__, server);
+	time1 = Sys_DoubleTime ();
 	if (svs.changelevel_issued)
 	{
 		SaveGamestate(true);
@@ -2041,6 +2044,7 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	q_strlcpy (sv.name, server, sizeof(sv.name));
 	q_snprintf (sv.modelname, sizeof(sv.modelname), "maps/%s.bsp", server);
 
+	time2 = Sys_DoubleTime ();
 	sv.worldmodel = Mod_ForName (sv.modelname, false);
 	if (!sv.worldmodel)
 	{
@@ -2094,7 +2098,9 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	current_loading_size += 5;
 	D_ShowLoadingSize();
 #endif
+	time3 = Sys_DoubleTime ();
 	ED_LoadFromFile (sv.worldmodel->entities);
+	time4 = Sys_DoubleTime ();
 
 	sv.active = true;
 
@@ -2118,7 +2124,9 @@ void SV_SpawnServer (const char *server, const char *startspot)
 
 	svs.changelevel_issued = false;		// now safe to issue another
 
-	Con_DPrintf ("Server spawned.\n");
+	Con_DPrintf ("Server spawned: progs %.1f ms, world %.1f ms, entities %.1f ms, total %.1f ms\n",
+			(time2 - time1) * 1000.0, (time3 - time2) * 1000.0,
+			(time4 - time3) * 1000.0, (Sys_DoubleTime() - time1) * 1000.0);
 
 #if !defined(SERVERONLY)
 	total_loading_size = 0;
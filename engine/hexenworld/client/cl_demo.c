@@ -24,6 +24,65 @@
 
 static void CL_FinishTimeDemo (void);
 
+/* per-frame timedemo profile, see CL_TimeDemoEndFrame() */
+typedef struct
+{
+	float	total;			/* wall time since the previous frame, msec */
+	float	phase[TD_NUMPHASES];	/* msec spent in each tdphase_t */
+} tdframe_t;
+
+static tdframe_t	*td_frames;
+static int		td_numframes, td_maxframes;
+static double		td_phase[TD_NUMPHASES];	/* current frame, seconds */
+static double		td_prevtime;
+static char		td_csvname[MAX_OSPATH];
+static qboolean		td_benchmark;		/* -benchmark: quit when done */
+static long		demo_endofs;		/* file offset just past the demo */
+static qboolean		demo_atend;		/* read up to demo_endofs */
+
+/* demo seeking.  a keyframe is the file offset of a demo record plus
+ * what is needed to resume parsing from there: either nothing, when the
+ * record starts a new map (signon keyframes), or a copy of the client
+ * state taken while playing the current map.  snapshots hold pointers
+ * to precached models, sounds and skins, so they are dropped on map
+ * changes.
+ */
+typedef struct
+{
+	client_state_t	cl;
+	netchan_t	netchan;	/* packet entities are delta compressed */
+	lightstyle_t	lightstyles[MAX_LIGHTSTYLES];
+/* followed by the effects state, see CL_DemoSaveState() */
+} demostate_t;
+
+typedef struct
+{
+	double		time;		/* demo time, seconds since the first record */
+	long		offset;
+	demostate_t	*state;		/* NULL for signon keyframes */
+} demokeyframe_t;
+
+#define	MAX_DEMO_KEYFRAMES	1024
+
+static demokeyframe_t	demo_keyframes[MAX_DEMO_KEYFRAMES];
+static int		demo_numkeyframes;
+static size_t		demo_keyframemem;
+static long		demo_msgofs;		/* offset of the last record read */
+static double		demo_time;
+static double		demo_basetime = -1;	/* demotime of the first record */
+static double		demo_seektime = -1;	/* fast-forward target, or -1 */
+
+/* demo_scan statistics */
+static qboolean		demo_scanning;
+static int		demo_scanmsgs, demo_scanbytes;
+static double		demo_scanstart;
+
+cvar_t	demo_keyframe_interval = {"demo_keyframe_interval", "30", CVAR_ARCHIVE};
+cvar_t	demo_keyframe_mem = {"demo_keyframe_mem", "64", CVAR_ARCHIVE};	/* MB */
+
+static void CL_DemoFreeKeyframes (void);
+static void CL_DemoAddKeyframe (qboolean signon);
+
 /*
 ==============================================================================
 
@@ -54,6 +113,22 @@ void CL_StopPlayback (void)
 	cls.demofile = NULL;
 	cls.state = ca_disconnected;
 
+	CL_DemoFreeKeyframes ();
+	demo_seektime = -1;
+	if (demo_scanning)
+	{
+		float	time = Sys_DoubleTime () - demo_scanstart;
+
+		demo_scanning = false;
+		if (!time)
+			time = 1;
+		Con_Printf ("demo_scan: %i messages, %i bytes, %.1f seconds of demo in %.2f seconds\n",
+				demo_scanmsgs, demo_scanbytes, demo_time, time);
+		Con_Printf ("demo_scan: %.0f messages/sec, %.2f MB/sec, %.0fx realtime\n",
+				demo_scanmsgs / time, demo_scanbytes / time / (1024.0 * 1024.0),
+				demo_time / time);
+	}
+
 	if (cls.timedemo)
 		CL_FinishTimeDemo ();
 }
@@ -130,6 +205,278 @@ static void CL_WriteDemoMessage (sizebuf_t *msg)
 	fflush (cls.demofile);
 }
 
+/*
+==============================================================================
+
+DEMO SEEKING
+
+Keyframes are collected while a demo plays.  demo_seek restores the last
+keyframe before the target, then fast-forwards by parsing messages without
+rendering until the target time is reached.
+==============================================================================
+*/
+
+static void CL_DemoFreeKeyframes (void)
+{
+	int	i;
+
+	for (i = 0; i < demo_numkeyframes; i++)
+		free (demo_keyframes[i].state);
+	demo_numkeyframes = 0;
+	demo_keyframemem = 0;
+}
+
+/*
+====================
+CL_DemoSaveState
+====================
+*/
+static demostate_t *CL_DemoSaveState (void)
+{
+	demostate_t	*st;
+	size_t	size;
+
+	size = sizeof(demostate_t) + CL_EffectStateSize();
+	if (demo_keyframemem + size > demo_keyframe_mem.value * 1024 * 1024)
+		return NULL;
+	st = (demostate_t *) malloc (size);
+	if (!st)
+		return NULL;
+	demo_keyframemem += size;
+
+	st->cl = cl;
+	st->netchan = cls.netchan;
+	memcpy (st->lightstyles, cl_lightstyle, sizeof(st->lightstyles));
+	CL_SaveEffectState (st + 1);
+
+	return st;
+}
+
+/*
+====================
+CL_DemoRestoreState
+====================
+*/
+static void CL_DemoRestoreState (const demostate_t *st)
+{
+	cl = st->cl;
+	cls.netchan = st->netchan;
+	cls.netchan.message.data = cls.netchan.message_buf;
+	memcpy (cl_lightstyle, st->lightstyles, sizeof(cl_lightstyle));
+	CL_RestoreEffectState (st + 1);
+	cls.state = ca_active;
+
+// transient effects are not worth saving
+	memset (cl_dlights, 0, sizeof(cl_dlights));
+	CL_ClearTEnts ();
+	R_ClearParticles ();
+}
+
+/*
+====================
+CL_DemoAddKeyframe
+
+Called at record boundaries.  Keyframes are kept sorted by file offset,
+because seeking backwards revisits parts of the demo already indexed.
+====================
+*/
+static void CL_DemoAddKeyframe (qboolean signon)
+{
+	demokeyframe_t	*k;
+	int	i;
+
+	for (i = demo_numkeyframes - 1; i >= 0; i--)
+	{
+		if (demo_keyframes[i].offset <= demo_msgofs)
+			break;
+	}
+
+	if (i >= 0 && demo_keyframes[i].offset == demo_msgofs)
+		return;		/* already have it */
+	if (!signon)
+	{
+		if (demo_keyframe_interval.value <= 0)
+			return;
+		if (i >= 0 && demo_time - demo_keyframes[i].time < demo_keyframe_interval.value)
+			return;
+	}
+	if (demo_numkeyframes == MAX_DEMO_KEYFRAMES)
+		return;
+
+	i++;
+	memmove (&demo_keyframes[i + 1], &demo_keyframes[i], (demo_numkeyframes - i) * sizeof(demokeyframe_t));
+	demo_numkeyframes++;
+
+	k = &demo_keyframes[i];
+	k->time = demo_time;
+	k->offset = demo_msgofs;
+	k->state = NULL;
+	if (!signon)
+	{
+		k->state = CL_DemoSaveState ();
+		if (!k->state)
+		{	/* over the memory limit: don't index this one */
+			demo_numkeyframes--;
+			memmove (k, k + 1, (demo_numkeyframes - i) * sizeof(demokeyframe_t));
+		}
+	}
+}
+
+/*
+====================
+CL_DemoNewMap
+
+Called from CL_ClearState when a demo changes maps: client state snapshots
+refer to the old map, so only the signon keyframes are kept.
+====================
+*/
+void CL_DemoNewMap (void)
+{
+	int	i, j;
+
+	if (!cls.demoplayback)
+		return;
+
+	for (i = j = 0; i < demo_numkeyframes; i++)
+	{
+		if (demo_keyframes[i].state)
+			free (demo_keyframes[i].state);
+		else	demo_keyframes[j++] = demo_keyframes[i];
+	}
+	demo_numkeyframes = j;
+	demo_keyframemem = 0;
+
+	CL_DemoAddKeyframe (true);
+}
+
+/*
+====================
+CL_DemoSeeking
+
+True while fast-forwarding, when sounds and stuffed commands of the
+skipped messages are dropped
+====================
+*/
+qboolean CL_DemoSeeking (void)
+{
+	return (demo_seektime >= 0);
+}
+
+/*
+====================
+CL_DemoFinishSeek
+====================
+*/
+static void CL_DemoFinishSeek (void)
+{
+	demo_seektime = -1;
+	S_StopDynamicSounds ();	// what the skipped messages started anyway
+	R_ClearParticles ();
+}
+
+/*
+====================
+CL_DemoSeek_f
+
+demo_seek <seconds>, or +/-<seconds> relative to the current demo time
+====================
+*/
+static void CL_DemoSeek_f (void)
+{
+	demokeyframe_t	*k;
+	const char	*arg;
+	double	target;
+	int	i;
+
+	if (!cls.demoplayback || cls.timedemo)
+	{
+		Con_Printf ("Not playing a demo.\n");
+		return;
+	}
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("demo_seek <time|+secs|-secs> : demo is at %.1f\n", demo_time);
+		return;
+	}
+
+	arg = Cmd_Argv(1);
+	target = atof(arg);
+	if (*arg == '+' || *arg == '-')
+		target += demo_time;
+	if (target < 0)
+		target = 0;
+
+// use the last keyframe before the target, unless that is behind us
+// and we can just keep going from here
+	k = NULL;
+	for (i = demo_numkeyframes - 1; i >= 0; i--)
+	{
+		if (demo_keyframes[i].time <= target)
+		{
+			k = &demo_keyframes[i];
+			break;
+		}
+	}
+	if (k && (target < demo_time || k->time > demo_time))
+	{
+		fseek (cls.demofile, k->offset, SEEK_SET);
+		if (k->state)
+		{
+			CL_DemoRestoreState (k->state);
+		}
+		else
+		{	/* parse the new map's signon again */
+			cls.state = ca_demostart;
+			Netchan_Setup (&cls.netchan, &net_from);
+		}
+		demo_time = k->time;
+		realtime = demo_basetime + k->time;
+	}
+
+	Con_DPrintf ("seeking to %.1f from %.1f\n", target, demo_time);
+	demo_seektime = target;
+}
+
+/*
+====================
+CL_DemoScan_f
+
+demo_scan <demoname> : measures demo parsing throughput without
+rendering or sound
+====================
+*/
+static void CL_DemoScan_f (void)
+{
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("demo_scan <demoname> : parse a demo at full speed\n");
+		return;
+	}
+
+	CL_PlayDemo_f ();
+	if (!cls.demofile)
+		return;
+
+	demo_scanning = true;
+	demo_scanmsgs = demo_scanbytes = 0;
+	demo_scanstart = Sys_DoubleTime ();
+	demo_seektime = 1.0e30;		/* fast-forward to the end */
+}
+
+/*
+====================
+CL_InitDemo
+====================
+*/
+void CL_InitDemo (void)
+{
+	Cvar_RegisterVariable (&demo_keyframe_interval);
+	Cvar_RegisterVariable (&demo_keyframe_mem);
+
+	Cmd_AddCommand ("demo_seek", CL_DemoSeek_f);
+	Cmd_AddCommand ("demo_scan", CL_DemoScan_f);
+}
+
 /*
 ====================
 CL_GetDemoMessage -- FIXME..
@@ -144,12 +491,26 @@ static qboolean CL_GetDemoMessage (void)
 	usercmd_t *pcmd;
 
 	// read the time from the packet
+	demo_msgofs = ftell(cls.demofile);
 	if (!fread(&demotime, sizeof(demotime), 1, cls.demofile))
 		goto corrupt;
 	demotime = LittleFloat(demotime);
+	if (demo_basetime < 0)
+		demo_basetime = demotime;
 
 	// decide if it is time to grab the next message
-	if (cls.timedemo)
+	if (demo_seektime >= 0)
+	{
+		// fast-forwarding: grab everything until the seek target is reached
+		if (cls.state == ca_active && demotime - demo_basetime >= demo_seektime)
+		{
+			fseek(cls.demofile, demo_msgofs, SEEK_SET);
+			CL_DemoFinishSeek ();
+			return 0;
+		}
+		realtime = demotime; // warp
+	}
+	else if (cls.timedemo)
 	{
 		if (cls.td_lastframe < 0)
 		{
@@ -195,6 +556,11 @@ static qboolean CL_GetDemoMessage (void)
 	if (cls.state < ca_demostart)
 		Host_Error ("%s: cls.state != ca_active", __thisfunc__);
 
+	// everything before this record has been parsed
+	demo_time = demotime - demo_basetime;
+	if (cls.state == ca_active && !cls.timedemo)
+		CL_DemoAddKeyframe (false);
+
 	// get the msg type
 	if (!fread(&c, sizeof(c), 1, cls.demofile))
 		goto corrupt;
@@ -234,6 +600,11 @@ static qboolean CL_GetDemoMessage (void)
 			Sys_Error ("Demo message > MAX_MSGLEN");
 		if (!fread(net_message.data, net_message.cursize, 1, cls.demofile))
 			goto corrupt;
+		if (demo_scanning)
+		{
+			demo_scanmsgs++;
+			demo_scanbytes += net_message.cursize;
+		}
 		break;
 
 	default :
@@ -243,6 +614,8 @@ static qboolean CL_GetDemoMessage (void)
 		return 0;
 	}
 
+	if (ftell (cls.demofile) >= demo_endofs)
+		demo_atend = true;
 	return 1;
 }
 
@@ -426,13 +799,16 @@ void CL_PlayDemo_f (void)
 	COM_AddExtension (name, ".qwd", sizeof(name));
 
 	Con_Printf ("Playing demo from %s.\n", name);
-	FS_OpenFile (name, &cls.demofile, NULL);
+	demo_endofs = FS_OpenFile (name, &cls.demofile, NULL);
 	if (!cls.demofile)
 	{
 		Con_Printf ("ERROR: couldn't open %s\n", name);
 		cls.demonum = -1;	// stop demo loop
 		return;
 	}
+// a demo in a pak file isn't followed by the end of the file
+	demo_endofs += ftell (cls.demofile);
+	demo_atend = false;
 
 // get rid of the menu and/or console
 	Key_SetDest (key_game);
@@ -441,6 +817,160 @@ void CL_PlayDemo_f (void)
 	cls.state = ca_demostart;
 	Netchan_Setup (&cls.netchan, &net_from);
 	realtime = 0;
+
+	CL_DemoFreeKeyframes ();
+	demo_seektime = -1;
+	demo_time = 0;
+	demo_basetime = -1;
+	demo_msgofs = ftell (cls.demofile);
+	CL_DemoAddKeyframe (true);
+}
+
+/*
+====================
+CL_TimeDemoPhase
+
+Accumulates time spent in one phase of the current timedemo frame.
+====================
+*/
+void CL_TimeDemoPhase (tdphase_t phase, double seconds)
+{
+	td_phase[phase] += seconds;
+}
+
+/*
+====================
+CL_TimeDemoEndFrame
+
+Called at the end of every host frame while a timedemo is running.
+====================
+*/
+void CL_TimeDemoEndFrame (void)
+{
+	tdframe_t	*f;
+	double	now;
+	int	i;
+
+	now = Sys_DoubleTime ();
+
+// the first frame didn't count, see CL_FinishTimeDemo
+	if (td_prevtime && cls.td_starttime && host_framecount > cls.td_startframe)
+	{
+		if (td_numframes == td_maxframes)
+		{
+			td_maxframes = td_maxframes ? td_maxframes * 2 : 4096;
+			td_frames = (tdframe_t *) realloc (td_frames, td_maxframes * sizeof(tdframe_t));
+			if (!td_frames)
+				Sys_Error ("%s: out of memory for %i frames", __thisfunc__, td_maxframes);
+		}
+		f = &td_frames[td_numframes++];
+		f->total = (now - td_prevtime) * 1000.0;
+	// the 2D pass is whatever part of the screen update wasn't the 3D refresh
+		td_phase[tdphase_screen] -= td_phase[tdphase_world];
+		for (i = 0; i < TD_NUMPHASES; i++)
+			f->phase[i] = td_phase[i] * 1000.0;
+	}
+
+	td_prevtime = now;
+	for (i = 0; i < TD_NUMPHASES; i++)
+		td_phase[i] = 0;
+}
+
+static int CL_TimeDemoCompare (const void *arg1, const void *arg2)
+{
+	float	a = *(const float *)arg1;
+	float	b = *(const float *)arg2;
+
+	return (a < b) ? -1 : (a > b);
+}
+
+/*
+====================
+CL_TimeDemoStats
+
+Writes the per-frame profile as CSV and prints the frame time percentiles.
+====================
+*/
+static void CL_TimeDemoStats (void)
+{
+	static const char *const phasenames[TD_NUMPHASES] = {
+		"parse", "world", "2d", "sound"
+	};
+	double	sum[TD_NUMPHASES];
+	float	*sorted;
+	FILE	*f;
+	int	i, j, worst;
+
+	if (!td_numframes)
+		return;
+
+	f = fopen (td_csvname, "w");
+	if (f)
+	{
+		fprintf (f, "frame,total_ms,parse_ms,world_ms,2d_ms,sound_ms\n");
+		for (i = 0; i < td_numframes; i++)
+		{
+			fprintf (f, "%i,%.4f", i, td_frames[i].total);
+			for (j = 0; j < TD_NUMPHASES; j++)
+				fprintf (f, ",%.4f", td_frames[i].phase[j]);
+			fprintf (f, "\n");
+		}
+		fclose (f);
+		Con_Printf ("wrote %s\n", td_csvname);
+	}
+	else
+	{
+		Con_Printf ("ERROR: couldn't create %s\n", td_csvname);
+	}
+
+	sorted = (float *) malloc (td_numframes * sizeof(float));
+	if (!sorted)
+		Sys_Error ("%s: out of memory", __thisfunc__);
+
+	worst = 0;
+	for (j = 0; j < TD_NUMPHASES; j++)
+		sum[j] = 0;
+	for (i = 0; i < td_numframes; i++)
+	{
+		sorted[i] = td_frames[i].total;
+		if (td_frames[i].total > td_frames[worst].total)
+			worst = i;
+		for (j = 0; j < TD_NUMPHASES; j++)
+			sum[j] += td_frames[i].phase[j];
+	}
+	qsort (sorted, td_numframes, sizeof(float), CL_TimeDemoCompare);
+
+	Con_Printf ("frame msec: p50 %.2f  p95 %.2f  p99 %.2f  worst %.2f (frame %i)\n",
+			sorted[(td_numframes - 1) * 50 / 100],
+			sorted[(td_numframes - 1) * 95 / 100],
+			sorted[(td_numframes - 1) * 99 / 100],
+			td_frames[worst].total, worst);
+	Con_Printf ("avg msec:");
+	for (j = 0; j < TD_NUMPHASES; j++)
+		Con_Printf (" %s %.2f", phasenames[j], sum[j] / td_numframes);
+	Con_Printf ("\n");
+
+	free (sorted);
+}
+
+/*
+====================
+CL_TimeDemoReset
+
+Drops the frame profile, also for a timedemo that was cut short
+by a disconnect or an error
+====================
+*/
+void CL_TimeDemoReset (void)
+{
+	int	i;
+
+	free (td_frames);
+	td_frames = NULL;
+	td_numframes = td_maxframes = 0;
+	td_prevtime = 0;
+	for (i = 0; i < TD_NUMPHASES; i++)
+		td_phase[i] = 0;
 }
 
 /*
@@ -462,36 +992,84 @@ static void CL_FinishTimeDemo (void)
 	if (!time)
 		time = 1;
 	Con_Printf ("%i frames %5.1f seconds %5.1f fps\n", frames, time, frames/time);
+
+	CL_TimeDemoStats ();
+	CL_TimeDemoReset ();
+
+	if (td_benchmark)
+	{
+	// a disconnect or an error before the end of the demo must not
+	// pass for a good run
+		if (!demo_atend)
+			Sys_Error ("benchmark: demo stopped before its end");
+		Sys_Quit ();
+	}
 }
 
 /*
 ====================
 CL_TimeDemo_f
 
-timedemo [demoname]
+timedemo [demoname] [csvfile]
 ====================
 */
 void CL_TimeDemo_f (void)
 {
-	if (Cmd_Argc() != 2)
+	const char	*csv;
+
+	if (Cmd_Argc() != 2 && Cmd_Argc() != 3)
 	{
-		Con_Printf ("timedemo <demoname> : gets demo speeds\n");
+		Con_Printf ("timedemo <demoname> [csvfile] : gets demo speeds\n");
 		return;
 	}
 
+	csv = (Cmd_Argc() == 3) ? Cmd_Argv(2) : "timedemo.csv";
+	if (*csv == '.' || strstr(csv, ".."))
+	{
+		Con_Printf ("Invalid csv file name.\n");
+		return;
+	}
+	FS_MakePath_BUF (FS_USERDIR, NULL, td_csvname, sizeof(td_csvname), csv);
+
 	CL_PlayDemo_f ();
 	if (!cls.demofile)
+	{
+		if (td_benchmark)
+			Sys_Error ("benchmark: couldn't play demo %s", Cmd_Argv(1));
 		return;
-
-//	if (cls.state != ca_active)
-//		return;
+	}
 
 // cls.td_starttime will be grabbed at the second frame of the demo, so
 // all the loading time doesn't get counted
 
+//	if (cls.state != ca_active)
+//		return;
+
 	cls.timedemo = true;
 	cls.td_starttime = 0;
 	cls.td_startframe = host_framecount;
 	cls.td_lastframe = -1;	// get a new message this frame
+
+	CL_TimeDemoReset ();
 }
 
+/*
+====================
+CL_StartBenchmark
+
+-benchmark <demoname> : runs a timedemo with sound and input disabled,
+prints the results and quits.  Intended for scripted regression runs.
+====================
+*/
+void CL_StartBenchmark (void)
+{
+	int	i;
+
+	i = COM_CheckParm ("-benchmark");
+	if (!i || i >= com_argc - 1)
+		return;
+
+	td_benchmark = true;
+	cls.demonum = -1;	// stop demo loop
+	Cbuf_AddText (va("timedemo %s\n", com_argv[i + 1]));
+}
@@ -170,6 +170,35 @@ void CL_ClearEffects (void)
 	EffectEntityCount = 0;
 }
 
+/* cl.Effects refer to effect entities, which live outside of cl:
+ * demo keyframes save and restore them along with the client state. */
+size_t CL_EffectStateSize (void)
+{
+	return sizeof(EffectEntities) + sizeof(EntityUsed) + sizeof(EffectEntityCount);
+}
+
+void CL_SaveEffectState (void *buf)
+{
+	byte	*p = (byte *) buf;
+
+	memcpy (p, EffectEntities, sizeof(EffectEntities));
+	p += sizeof(EffectEntities);
+	memcpy (p, EntityUsed, sizeof(EntityUsed));
+	p += sizeof(EntityUsed);
+	memcpy (p, &EffectEntityCount, sizeof(EffectEntityCount));
+}
+
+void CL_RestoreEffectState (const void *buf)
+{
+	const byte	*p = (const byte *) buf;
+
+	memcpy (EffectEntities, p, sizeof(EffectEntities));
+	p += sizeof(EffectEntities);
+	memcpy (EntityUsed, p, sizeof(EntityUsed));
+	p += sizeof(EntityUsed);
+	memcpy (&EffectEntityCount, p, sizeof(EffectEntityCount));
+}
+
 static void CL_FreeEffect (int idx)
 {
 	int		i;
@@ -32,6 +32,7 @@
 #include "debuglog.h"
 #include "bgmusic.h"
 #include "cdaudio.h"
+#include "threads.h"
 
 static	cvar_t	rcon_password = {"rcon_password", "", CVAR_NONE};
 static	cvar_t	rcon_address = {"rcon_address", "", CVAR_NONE};
@@ -338,6 +339,7 @@ void CL_ClearState (void)
 
 	CL_ClearTEnts ();
 	CL_ClearEffects();
+	CL_DemoNewMap ();
 
 // wipe the entire cl structure
 	memset (&cl, 0, sizeof(cl));
@@ -415,6 +417,7 @@ void CL_Disconnect (void)
 
 		cls.demoplayback = cls.demorecording = cls.timedemo = false;
 	}
+	CL_TimeDemoReset ();
 	Cam_Reset();
 	cl.intermission = 0;
 }
@@ -1107,6 +1110,7 @@ void CL_Init (void)
 	Cmd_AddCommand ("stop", CL_Stop_f);
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
+	CL_InitDemo ();
 	Cmd_AddCommand ("map", CL_Map_f);
 
 	Cmd_AddCommand ("skins", Skin_Skins_f);
@@ -1266,6 +1270,7 @@ void Host_Frame (float time)
 	static double		time2 = 0;
 	static double		time3 = 0;
 	int			pass1, pass2, pass3;
+	double			tdtime = 0;
 	float			fps;
 
 	if (setjmp(host_abort))
@@ -1295,7 +1300,11 @@ void Host_Frame (float time)
 	Cbuf_Execute ();
 
 	// fetch results from server
+	if (cls.timedemo)
+		tdtime = Sys_DoubleTime ();
 	CL_ReadPackets ();
+	if (cls.timedemo)
+		CL_TimeDemoPhase (tdphase_parse, Sys_DoubleTime () - tdtime);
 
 	// send intentions now
 	// resend a connection request if necessary
@@ -1321,13 +1330,15 @@ void Host_Frame (float time)
 	CL_EmitEntities ();
 
 	// update video
-	if (host_speeds.integer)
+	if (host_speeds.integer || cls.timedemo)
 		time1 = Sys_DoubleTime ();
 
 	SCR_UpdateScreen ();
 
-	if (host_speeds.integer)
+	if (host_speeds.integer || cls.timedemo)
 		time2 = Sys_DoubleTime ();
+	if (cls.timedemo)
+		CL_TimeDemoPhase (tdphase_screen, time2 - time1);
 
 	// update audio
 	BGM_Update();	// adds music raw samples and/or advances midi driver
@@ -1343,6 +1354,12 @@ void Host_Frame (float time)
 
 	CDAudio_Update();
 
+	if (cls.timedemo)
+	{
+		CL_TimeDemoPhase (tdphase_sound, Sys_DoubleTime () - time2);
+		CL_TimeDemoEndFrame ();
+	}
+
 	if (host_speeds.integer)
 	{
 		pass1 = (time1 - time3)*1000;
@@ -1375,6 +1392,8 @@ void Host_Init (void)
 
 	Cvar_RegisterVariable (&sys_nostdout);
 	COM_Init ();
+	if (COM_CheckParm ("-benchmark"))
+		safemode = 1;	/* no sound, cd, midi or input devices */
 	FS_Init ();
 	CL_Cmd_Init ();
 
@@ -1384,6 +1403,7 @@ void Host_Init (void)
 	CFG_OpenConfig ("config.cfg");
 
 	Mod_Init ();
+	Thread_Init ();
 
 	Con_Printf ("Exe: " __TIME__ " " __DATE__ "\n");
 	Con_Printf ("%4.1f megs RAM used.\n", host_parms->memsize/(1024*1024.0));
@@ -1443,6 +1463,7 @@ void Host_Init (void)
 	Cbuf_InsertText ("exec hexen.rc\n");
 	if (!setjmp(host_abort))		/* in case exec fails with a longjmp(), e.g. Host_Error() */
 		Cbuf_Execute ();
+	CL_StartBenchmark ();
 
 	Cvar_UnlockAll ();			/* unlock the early-set cvars after init */
 }
@@ -1477,6 +1498,7 @@ void Host_Shutdown(void)
 	IN_Shutdown ();
 	if (host_basepal)
 		VID_Shutdown();
+	Thread_Shutdown ();
 	LOG_Close ();
 }
 
@@ -24,6 +24,7 @@
 #include "bgmusic.h"
 #include "cdaudio.h"
 #include "r_shared.h"
+#include "threads.h"
 
 static const char *svc_strings[] =
 {
@@ -197,6 +198,8 @@ static void Model_NextDownload (void)
 {
 	const char	*s;
 	int	i;
+	long	prefetched;
+	double	time1, time2;
 
 	if (cls.downloadnumber == 0)
 	{
@@ -214,6 +217,17 @@ static void Model_NextDownload (void)
 			return;		// started a download
 	}
 
+	for (i = 1; i < MAX_MODELS; i++)
+	{
+		if (!cl.model_name[i][0])
+			break;
+	}
+
+	// read the files on all threads first
+	time1 = Sys_DoubleTime ();
+	prefetched = Mod_PrefetchModels (cl.model_name + 1, i - 1);
+	time2 = Sys_DoubleTime ();
+
 	for (i = 1; i < MAX_MODELS; i++)
 	{
 		if (!cl.model_name[i][0])
@@ -221,6 +235,7 @@ static void Model_NextDownload (void)
 		cl.model_precache[i] = Mod_ForName (cl.model_name[i], false);
 		if (!cl.model_precache[i])
 		{
+			FS_FreePrefetch ();
 			Con_Printf ("\nThe required model file '%s' could not be found or downloaded.\n\n", cl.model_name[i]);
 			Con_Printf ("You may need to download or purchase a %s client "
 					"pack in order to play on this server.\n\n", fs_gamedir_nopath);
@@ -228,6 +243,11 @@ static void Model_NextDownload (void)
 			return;
 		}
 	}
+	FS_FreePrefetch ();
+
+	Con_DPrintf ("precache: %ld KB read in %.1f ms, %d models %.1f ms (%d threads)\n",
+			prefetched >> 10, (time2 - time1) * 1000.0,
+			i - 1, (Sys_DoubleTime() - time2) * 1000.0, Thread_Count());
 
 	// copy the naked name of the map file to the cl structure
 	COM_FileBase (cl.model_name[1], cl.mapname, sizeof(cl.mapname));
@@ -254,6 +274,7 @@ static void Sound_NextDownload (void)
 {
 	const char	*s;
 	int	i;
+	double	time1;
 
 	if (cls.downloadnumber == 0)
 	{
@@ -269,12 +290,18 @@ static void Sound_NextDownload (void)
 			return;		// started a download
 	}
 
+	time1 = Sys_DoubleTime ();
+	S_BeginPrecaching ();
 	for (i = 1; i < MAX_SOUNDS; i++)
 	{
 		if (!cl.sound_name[i][0])
 			break;
 		cl.sound_precache[i] = S_PrecacheSound (cl.sound_name[i]);
 	}
+	S_EndPrecaching ();
+
+	Con_DPrintf ("precache: %d sounds %.1f ms (%d threads)\n",
+			i - 1, (Sys_DoubleTime() - time1) * 1000.0, Thread_Count());
 
 	// done with sounds, request models now
 	MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
@@ -851,6 +878,8 @@ static void CL_ParseStartSoundPacket(void)
 	if (ent > MAX_EDICTS)
 		Host_EndGame ("%s: ent = %i", __thisfunc__, ent);
 
+	if (CL_DemoSeeking ())
+		return;
 	S_StartSound (ent, channel, cl.sound_precache[sound_num], pos, volume/255.0, attenuation);
 }
 
@@ -1259,7 +1288,8 @@ void CL_ParseServerMessage (void)
 		case svc_stufftext:
 			s = MSG_ReadString ();
 			Con_DPrintf ("stufftext: %s\n", s);
-			Cbuf_AddText (s);
+			if (!CL_DemoSeeking ())	// else they'd all run at once
+				Cbuf_AddText (s);
 			break;
 
 		case svc_damage:
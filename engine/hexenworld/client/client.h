@@ -476,6 +476,27 @@ void CL_Record_f (void);
 void CL_ReRecord_f (void);
 void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
+void CL_StartBenchmark (void);
+void CL_InitDemo (void);
+void CL_DemoNewMap (void);
+qboolean CL_DemoSeeking (void);
+
+extern	cvar_t	demo_keyframe_interval;
+extern	cvar_t	demo_keyframe_mem;
+
+/* timedemo per-frame profiling phases */
+typedef enum
+{
+	tdphase_parse,		// reading and parsing server messages
+	tdphase_world,		// 3D refresh: V_RenderView
+	tdphase_screen,		// whole SCR_UpdateScreen, stored as the 2D part
+	tdphase_sound,		// sound, music and cd audio update
+	TD_NUMPHASES
+} tdphase_t;
+
+void CL_TimeDemoPhase (tdphase_t phase, double seconds);
+void CL_TimeDemoEndFrame (void);
+void CL_TimeDemoReset (void);
 
 void CL_WriteDemoCmd (const usercmd_t *pcmd);
 
@@ -530,6 +551,9 @@ extern	float		v_targDist;
 //
 void CL_InitEffects (void);
 void CL_ClearEffects (void);
+size_t CL_EffectStateSize (void);
+void CL_SaveEffectState (void *buf);
+void CL_RestoreEffectState (const void *buf);
 void CL_EndEffect (void);
 void CL_ParseEffect (void);
 void CL_ParseMultiEffect (void);
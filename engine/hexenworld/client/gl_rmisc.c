@@ -21,6 +21,7 @@
 
 #include "quakedef.h"
 #include "hashindex.h"
+#include "lmcache.h"
 
 byte			*playerTranslation;
 const int	color_offsets[MAX_PLAYER_CLASS] =
@@ -227,6 +228,7 @@ void R_Init (void)
 
 	Cvar_RegisterVariable (&gl_keeptjunctions);
 	Cvar_RegisterVariable (&gl_reporttjunctions);
+	Cvar_RegisterVariable (&gl_vertexarrays);
 
 	Cvar_RegisterVariable (&gl_glows);
 	Cvar_RegisterVariable (&gl_missile_glows);
@@ -238,6 +240,8 @@ void R_Init (void)
 
 	R_InitBubble();
 
+	LM_InitCache ();
+
 	R_InitParticles ();
 	R_InitParticleTexture ();
 	R_InitExtraTextures ();
@@ -21,9 +21,11 @@
  */
 
 #include "quakedef.h"
+#include "lmcache.h"
 
 int		gl_lightmap_format = GL_RGBA;
 cvar_t		gl_lightmapfmt = {"gl_lightmapfmt", "GL_RGBA", CVAR_ARCHIVE};
+cvar_t		gl_vertexarrays = {"gl_vertexarrays", "1", CVAR_ARCHIVE};
 int		lightmap_bytes = 4;		// 1, 2, or 4. default is 4 for GL_RGBA
 GLuint		lightmap_textures[MAX_LIGHTMAPS];
 
@@ -47,6 +49,13 @@ static int	allocated[MAX_LIGHTMAPS][BLOCK_WIDTH];
 // main memory so texsubimage can update properly
 static byte	lightmaps[4*MAX_LIGHTMAPS*BLOCK_WIDTH*BLOCK_HEIGHT];
 
+// the polygons of all brush models in one array, so that a whole
+// texture or lightmap chain can go out with a single glDrawElements
+#define	MAX_BATCH_INDICES	12288
+static float	*poly_verts;
+static GLuint	batch_indices[MAX_BATCH_INDICES];
+static int	batch_numindices;
+
 
 /*
 ===============
@@ -205,6 +214,10 @@ static void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 	unsigned int	scale;
 	int		maps;
 	unsigned int	*bl, *blcr, *blcg, *blcb;
+	int		values[MAXLIGHTMAPS];
+	byte		*cache, *base;
+	int		rowbytes, pitch;
+	qboolean	fill;
 
 	surf->cached_dlight = (surf->dlightframe == r_framecount);
 
@@ -212,6 +225,10 @@ static void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 	tmax = (surf->extents[1] >> 4) + 1;
 	size = smax*tmax;
 	lightmap = surf->samples;
+	cache = NULL;
+	base = dest;
+	pitch = stride;
+	rowbytes = smax * lightmap_bytes;
 
 // set to full bright if no light data
 	if (r_fullbright.integer || !cl.worldmodel->lightdata)
@@ -228,6 +245,20 @@ static void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 		goto store;
 	}
 
+// see if this combination of styles was built before
+	if (lightmap && !surf->cached_dlight)
+	{
+		for (maps = 0 ; maps < MAXLIGHTMAPS && surf->styles[maps] != 255 ; maps++)
+			values[maps] = surf->cached_light[maps] = d_lightstylevalue[surf->styles[maps]];
+		cache = LM_CacheBlock (surf, values, maps, gl_coloredlight.integer, size * lightmap_bytes, &fill);
+		if (cache && !fill)
+		{
+			for (i = 0; i < tmax; i++, base += pitch, cache += rowbytes)
+				memcpy (base, cache, rowbytes);
+			return;
+		}
+	}
+
 // clear to no light
 	for (i = 0; i < size; i++)
 	{
@@ -346,6 +377,12 @@ store:
 	default:
 		Sys_Error ("Bad lightmap format");
 	}
+
+	if (cache)
+	{
+		for (i = 0; i < tmax; i++, base += pitch, cache += rowbytes)
+			memcpy (cache, base, rowbytes);
+	}
 }
 
 
@@ -521,6 +558,117 @@ static void DrawGLPolyMTex (glpoly_t *p)
 }
 
 
+/*
+================
+R_UseVertexArrays
+================
+*/
+static qboolean R_UseVertexArrays (qboolean mtex)
+{
+	if (!gl_vertexarrays.integer || !poly_verts)
+		return false;
+	return (!mtex || glClientActiveTextureARB_fp != NULL);
+}
+
+/*
+================
+R_BeginBatch
+
+Points the client arrays at the brush model vertices.  Texture unit 0
+gets the texture coordinates, or the lightmap ones for the blend pass,
+and unit 1 the lightmap coordinates when multitexturing.
+================
+*/
+static void R_BeginBatch (qboolean lightmap, qboolean mtex)
+{
+	glVertexPointer_fp (3, GL_FLOAT, VERTEXSIZE*sizeof(float), poly_verts);
+	glEnableClientState_fp (GL_VERTEX_ARRAY);
+	if (mtex)
+	{
+		glClientActiveTextureARB_fp (GL_TEXTURE1_ARB);
+		glTexCoordPointer_fp (2, GL_FLOAT, VERTEXSIZE*sizeof(float), poly_verts + 5);
+		glEnableClientState_fp (GL_TEXTURE_COORD_ARRAY);
+		glClientActiveTextureARB_fp (GL_TEXTURE0_ARB);
+	}
+	glTexCoordPointer_fp (2, GL_FLOAT, VERTEXSIZE*sizeof(float), poly_verts + (lightmap ? 5 : 3));
+	glEnableClientState_fp (GL_TEXTURE_COORD_ARRAY);
+	batch_numindices = 0;
+}
+
+static void R_FlushBatch (void)
+{
+	if (batch_numindices)
+	{
+		glDrawElements_fp (GL_TRIANGLES, batch_numindices, GL_UNSIGNED_INT, batch_indices);
+		batch_numindices = 0;
+	}
+}
+
+static void R_EndBatch (qboolean mtex)
+{
+	R_FlushBatch ();
+	if (mtex)
+	{
+		glClientActiveTextureARB_fp (GL_TEXTURE1_ARB);
+		glDisableClientState_fp (GL_TEXTURE_COORD_ARRAY);
+		glClientActiveTextureARB_fp (GL_TEXTURE0_ARB);
+	}
+	glDisableClientState_fp (GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState_fp (GL_VERTEX_ARRAY);
+}
+
+/*
+================
+R_BatchPoly
+
+Adds the polygon to the batch as a triangle fan
+================
+*/
+static void R_BatchPoly (glpoly_t *p)
+{
+	int	i, count;
+	GLuint	*idx;
+
+	count = (p->numverts - 2) * 3;
+	if (count <= 0)
+		return;
+	if (batch_numindices + count > MAX_BATCH_INDICES)
+		R_FlushBatch ();
+
+	idx = batch_indices + batch_numindices;
+	for (i = 2; i < p->numverts; i++)
+	{
+		*idx++ = p->firstvert;
+		*idx++ = p->firstvert + i - 1;
+		*idx++ = p->firstvert + i;
+	}
+	batch_numindices += count;
+}
+
+
+/*
+================
+R_UploadLightmap
+
+Uploads the rows of a lightmap page that changed since its last upload
+================
+*/
+static void R_UploadLightmap (int lmap)
+{
+	glRect_t	*theRect;
+
+	lightmap_modified[lmap] = false;
+	theRect = &lightmap_rectchange[lmap];
+	glTexSubImage2D_fp(GL_TEXTURE_2D, 0, 0, theRect->t, BLOCK_WIDTH,
+			theRect->h, gl_lightmap_format, GL_UNSIGNED_BYTE,
+			lightmaps + (lmap* BLOCK_HEIGHT + theRect->t)*BLOCK_WIDTH*lightmap_bytes);
+	c_lightmap_bytes += theRect->h * BLOCK_WIDTH * lightmap_bytes;
+	theRect->l = BLOCK_WIDTH;
+	theRect->t = BLOCK_HEIGHT;
+	theRect->h = 0;
+	theRect->w = 0;
+}
+
 /*
 ================
 R_BlendLightmaps
@@ -532,7 +680,7 @@ static void R_BlendLightmaps (qboolean Translucent)
 	int			j;
 	glpoly_t	*p;
 	float		*v;
-	glRect_t	*theRect;
+	qboolean	batch;
 
 	if (r_fullbright.integer)
 		return;
@@ -564,6 +712,10 @@ static void R_BlendLightmaps (qboolean Translucent)
 		glGenTextures_fp(MAX_LIGHTMAPS, lightmap_textures);
 	}
 
+	batch = R_UseVertexArrays (false);
+	if (batch)
+		R_BeginBatch (true, false);
+
 	for (i = 0; i < MAX_LIGHTMAPS; i++)
 	{
 		p = lightmap_polys[i];
@@ -576,15 +728,7 @@ static void R_BlendLightmaps (qboolean Translucent)
 		{
 			// if current lightmap was changed reload it
 			// and mark as not changed.
-			lightmap_modified[i] = false;
-			theRect = &lightmap_rectchange[i];
-			glTexSubImage2D_fp(GL_TEXTURE_2D, 0, 0, theRect->t, BLOCK_WIDTH,
-					theRect->h, gl_lightmap_format, GL_UNSIGNED_BYTE,
-					lightmaps + (i* BLOCK_HEIGHT + theRect->t)*BLOCK_WIDTH*lightmap_bytes);
-			theRect->l = BLOCK_WIDTH;
-			theRect->t = BLOCK_HEIGHT;
-			theRect->h = 0;
-			theRect->w = 0;
+			R_UploadLightmap (i);
 		}
 
 		for ( ; p ; p = p->chain)
@@ -594,6 +738,8 @@ static void R_BlendLightmaps (qboolean Translucent)
 					(r_viewleaf->contents != CONTENTS_EMPTY && !(p->flags & SURF_UNDERWATER)) )
 				    && !(p->flags & SURF_DONTWARP) )
 				DrawGLWaterPolyLightmap (p);
+			else if (batch)
+				R_BatchPoly (p);
 			else
 			{
 				glBegin_fp (GL_POLYGON);
@@ -606,8 +752,14 @@ static void R_BlendLightmaps (qboolean Translucent)
 				glEnd_fp ();
 			}
 		}
+
+		if (batch)
+			R_FlushBatch ();
 	}
 
+	if (batch)
+		R_EndBatch (false);
+
 	if (!r_lightmap.integer)
 	{
 		glDisable_fp (GL_BLEND);
@@ -631,7 +783,6 @@ static void R_UpdateLightmaps (qboolean Translucent)
 {
 	unsigned int		i;
 	glpoly_t	*p;
-	glRect_t	*theRect;
 
 	if (r_fullbright.integer)
 		return;
@@ -658,15 +809,7 @@ static void R_UpdateLightmaps (qboolean Translucent)
 		{
 			// if current lightmap was changed reload it
 			// and mark as not changed.
-			lightmap_modified[i] = false;
-			theRect = &lightmap_rectchange[i];
-			glTexSubImage2D_fp(GL_TEXTURE_2D, 0, 0, theRect->t, BLOCK_WIDTH,
-					theRect->h, gl_lightmap_format, GL_UNSIGNED_BYTE,
-					lightmaps + (i* BLOCK_HEIGHT + theRect->t)*BLOCK_WIDTH*lightmap_bytes);
-			theRect->l = BLOCK_WIDTH;
-			theRect->t = BLOCK_HEIGHT;
-			theRect->h = 0;
-			theRect->w = 0;
+			R_UploadLightmap (i);
 		}
 	}
 
@@ -676,16 +819,71 @@ static void R_UpdateLightmaps (qboolean Translucent)
 
 /*
 ================
-R_RenderBrushPoly
+R_AddSurfaceLightmap
+
+Adds the surface to its lightmap chain and rebuilds
+the lightmap if its styles or dynamic lights changed
 ================
 */
-void R_RenderBrushPoly (entity_t *e, msurface_t *fa, qboolean override)
+static void R_AddSurfaceLightmap (msurface_t *fa)
 {
-	texture_t	*t;
 	byte		*base;
 	int		maps;
 	glRect_t	*theRect;
 	int		smax, tmax;
+
+	// add the poly to the proper lightmap chain
+	fa->polys->chain = lightmap_polys[fa->lightmaptexturenum];
+	lightmap_polys[fa->lightmaptexturenum] = fa->polys;
+
+	// check for lightmap modification
+	for (maps = 0; maps < MAXLIGHTMAPS && fa->styles[maps] != 255; maps++)
+	{
+		if (d_lightstylevalue[fa->styles[maps]] != fa->cached_light[maps])
+			goto dynamic;
+	}
+
+	if (fa->dlightframe == r_framecount	// dynamic this frame
+		|| fa->cached_dlight)		// dynamic previously
+	{
+dynamic:
+		if (r_dynamic.integer)
+		{
+			lightmap_modified[fa->lightmaptexturenum] = true;
+			theRect = &lightmap_rectchange[fa->lightmaptexturenum];
+			if (fa->light_t < theRect->t)
+			{
+				if (theRect->h)
+					theRect->h += theRect->t - fa->light_t;
+				theRect->t = fa->light_t;
+			}
+			if (fa->light_s < theRect->l)
+			{
+				if (theRect->w)
+					theRect->w += theRect->l - fa->light_s;
+				theRect->l = fa->light_s;
+			}
+			smax = (fa->extents[0] >> 4) + 1;
+			tmax = (fa->extents[1] >> 4) + 1;
+			if ((theRect->w + theRect->l) < (fa->light_s + smax))
+				theRect->w = (fa->light_s-theRect->l)+smax;
+			if ((theRect->h + theRect->t) < (fa->light_t + tmax))
+				theRect->h = (fa->light_t-theRect->t)+tmax;
+			base = lightmaps + fa->lightmaptexturenum*lightmap_bytes*BLOCK_WIDTH*BLOCK_HEIGHT;
+			base += fa->light_t * BLOCK_WIDTH * lightmap_bytes + fa->light_s * lightmap_bytes;
+			R_BuildLightMap (fa, base, BLOCK_WIDTH*lightmap_bytes);
+		}
+	}
+}
+
+/*
+================
+R_RenderBrushPoly
+================
+*/
+void R_RenderBrushPoly (entity_t *e, msurface_t *fa, qboolean override)
+{
+	texture_t	*t;
 	float		intensity, alpha_val;
 
 	c_brush_polys++;
@@ -776,48 +974,7 @@ void R_RenderBrushPoly (entity_t *e, msurface_t *fa, qboolean override)
 			DrawGLPoly (fa->polys);
 	}
 
-	// add the poly to the proper lightmap chain
-	fa->polys->chain = lightmap_polys[fa->lightmaptexturenum];
-	lightmap_polys[fa->lightmaptexturenum] = fa->polys;
-
-	// check for lightmap modification
-	for (maps = 0; maps < MAXLIGHTMAPS && fa->styles[maps] != 255; maps++)
-	{
-		if (d_lightstylevalue[fa->styles[maps]] != fa->cached_light[maps])
-			goto dynamic;
-	}
-
-	if (fa->dlightframe == r_framecount	// dynamic this frame
-		|| fa->cached_dlight)		// dynamic previously
-	{
-dynamic:
-		if (r_dynamic.integer)
-		{
-			lightmap_modified[fa->lightmaptexturenum] = true;
-			theRect = &lightmap_rectchange[fa->lightmaptexturenum];
-			if (fa->light_t < theRect->t)
-			{
-				if (theRect->h)
-					theRect->h += theRect->t - fa->light_t;
-				theRect->t = fa->light_t;
-			}
-			if (fa->light_s < theRect->l)
-			{
-				if (theRect->w)
-					theRect->w += theRect->l - fa->light_s;
-				theRect->l = fa->light_s;
-			}
-			smax = (fa->extents[0] >> 4) + 1;
-			tmax = (fa->extents[1] >> 4) + 1;
-			if ((theRect->w + theRect->l) < (fa->light_s + smax))
-				theRect->w = (fa->light_s-theRect->l)+smax;
-			if ((theRect->h + theRect->t) < (fa->light_t + tmax))
-				theRect->h = (fa->light_t-theRect->t)+tmax;
-			base = lightmaps + fa->lightmaptexturenum*lightmap_bytes*BLOCK_WIDTH*BLOCK_HEIGHT;
-			base += fa->light_t * BLOCK_WIDTH * lightmap_bytes + fa->light_s * lightmap_bytes;
-			R_BuildLightMap (fa, base, BLOCK_WIDTH*lightmap_bytes);
-		}
-	}
+	R_AddSurfaceLightmap (fa);
 
 	if ((e->drawflags & MLS_ABSLIGHT) == MLS_ABSLIGHT ||
 	    (e->drawflags & DRF_TRANSLUCENT))
@@ -834,10 +991,6 @@ dynamic:
 void R_RenderBrushPolyMTex (entity_t *e, msurface_t *fa, qboolean override)
 {
 	texture_t	*t;
-	byte		*base;
-	int		maps;
-	glRect_t	*theRect;
-	int		smax, tmax;
 	float		intensity, alpha_val;
 
 	c_brush_polys++;
@@ -923,48 +1076,7 @@ void R_RenderBrushPolyMTex (entity_t *e, msurface_t *fa, qboolean override)
 
 		glActiveTextureARB_fp(GL_TEXTURE1_ARB);
 
-		// add the poly to the proper lightmap chain
-		fa->polys->chain = lightmap_polys[fa->lightmaptexturenum];
-		lightmap_polys[fa->lightmaptexturenum] = fa->polys;
-
-		// check for lightmap modification
-		for (maps = 0; maps < MAXLIGHTMAPS && fa->styles[maps] != 255; maps++)
-		{
-			if (d_lightstylevalue[fa->styles[maps]] != fa->cached_light[maps])
-				goto dynamic1;
-		}
-
-		if (fa->dlightframe == r_framecount	// dynamic this frame
-		    || fa->cached_dlight)		// dynamic previously
-		{
-dynamic1:
-			if (r_dynamic.integer)
-			{
-				lightmap_modified[fa->lightmaptexturenum] = true;
-				theRect = &lightmap_rectchange[fa->lightmaptexturenum];
-				if (fa->light_t < theRect->t)
-				{
-					if (theRect->h)
-						theRect->h += theRect->t - fa->light_t;
-					theRect->t = fa->light_t;
-				}
-				if (fa->light_s < theRect->l)
-				{
-					if (theRect->w)
-						theRect->w += theRect->l - fa->light_s;
-					theRect->l = fa->light_s;
-				}
-				smax = (fa->extents[0] >> 4) + 1;
-				tmax = (fa->extents[1] >> 4) + 1;
-				if ((theRect->w + theRect->l) < (fa->light_s + smax))
-					theRect->w = (fa->light_s-theRect->l)+smax;
-				if ((theRect->h + theRect->t) < (fa->light_t + tmax))
-					theRect->h = (fa->light_t-theRect->t)+tmax;
-				base = lightmaps + fa->lightmaptexturenum*lightmap_bytes*BLOCK_WIDTH*BLOCK_HEIGHT;
-				base += fa->light_t * BLOCK_WIDTH * lightmap_bytes + fa->light_s * lightmap_bytes;
-				R_BuildLightMap (fa, base, BLOCK_WIDTH*lightmap_bytes);
-			}
-		}
+		R_AddSurfaceLightmap (fa);
 	}
 
 	glActiveTextureARB_fp(GL_TEXTURE0_ARB);
@@ -1058,6 +1170,89 @@ void R_DrawWaterSurfaces (void)
 	glDepthMask_fp (1);
 }
 
+/*
+================
+R_BatchTextureChain
+
+Same as calling R_RenderBrushPoly for every surface of an
+opaque chain, with the unwarped polygons drawn in one batch
+================
+*/
+static void R_BatchTextureChain (entity_t *e, msurface_t *s)
+{
+	texture_t	*t;
+
+	glColor4f_fp (1.0f, 1.0f, 1.0f, 1.0f);
+	t = R_TextureAnimation (e, s->texinfo->texture);
+	GL_Bind (t->gl_texturenum);
+
+	for ( ; s ; s = s->texturechain)
+	{
+		if ( ( (r_viewleaf->contents == CONTENTS_EMPTY && (s->flags & SURF_UNDERWATER)) ||
+				(r_viewleaf->contents != CONTENTS_EMPTY && !(s->flags & SURF_UNDERWATER)) )
+			    && !(s->flags & SURF_DONTWARP) )
+		{
+			R_FlushBatch ();
+			R_RenderBrushPoly (e, s, false);
+			continue;
+		}
+
+		c_brush_polys++;
+		R_BatchPoly (s->polys);
+		R_AddSurfaceLightmap (s);
+	}
+
+	R_FlushBatch ();
+}
+
+/*
+================
+R_BatchTextureChainMTex
+
+Same as calling R_RenderBrushPolyMTex for every surface of an opaque
+chain, with the unwarped polygons batched for as long as they share
+the same lightmap texture
+================
+*/
+static void R_BatchTextureChainMTex (entity_t *e, msurface_t *s)
+{
+	texture_t	*t;
+	int		lightmapnum;
+
+	glDisable_fp (GL_BLEND);
+	glColor4f_fp (1.0f, 1.0f, 1.0f, 1.0f);
+	glActiveTextureARB_fp (GL_TEXTURE0_ARB);
+	t = R_TextureAnimation (e, s->texinfo->texture);
+	GL_Bind (t->gl_texturenum);
+	glActiveTextureARB_fp (GL_TEXTURE1_ARB);
+
+	lightmapnum = -1;
+	for ( ; s ; s = s->texturechain)
+	{
+		if ( ( (r_viewleaf->contents == CONTENTS_EMPTY && (s->flags & SURF_UNDERWATER)) ||
+				(r_viewleaf->contents != CONTENTS_EMPTY && !(s->flags & SURF_UNDERWATER)) )
+			    && !(s->flags & SURF_DONTWARP) )
+		{
+			R_FlushBatch ();
+			R_RenderBrushPolyMTex (e, s, false);
+			lightmapnum = s->lightmaptexturenum;
+			continue;
+		}
+
+		c_brush_polys++;
+		if (s->lightmaptexturenum != lightmapnum)
+		{
+			R_FlushBatch ();
+			lightmapnum = s->lightmaptexturenum;
+			GL_Bind (lightmap_textures[lightmapnum]);
+		}
+		R_BatchPoly (s->polys);
+		R_AddSurfaceLightmap (s);
+	}
+
+	R_FlushBatch ();
+}
+
 /*
 ================
 DrawTextureChains
@@ -1068,6 +1263,11 @@ static void DrawTextureChains (entity_t *e)
 	int		i;
 	msurface_t	*s;
 	texture_t	*t;
+	qboolean	batch;
+
+	batch = R_UseVertexArrays (gl_mtexable);
+	if (batch)
+		R_BeginBatch (false, gl_mtexable);
 
 	for (i = 0; i < cl.worldmodel->numtextures; i++)
 	{
@@ -1109,14 +1309,23 @@ static void DrawTextureChains (entity_t *e)
 
 				glEnable_fp (GL_BLEND);
 
-				for ( ; s ; s = s->texturechain)
-					R_RenderBrushPolyMTex (e, s, false);
+				if (batch && !(s->flags & SURF_DRAWTURB))
+					R_BatchTextureChainMTex (e, s);
+				else
+				{
+					for ( ; s ; s = s->texturechain)
+						R_RenderBrushPolyMTex (e, s, false);
+				}
 
 				glDisable_fp(GL_TEXTURE_2D);
 				glTexEnvf_fp(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 				glDisable_fp (GL_BLEND);
 				glActiveTextureARB_fp(GL_TEXTURE0_ARB);
 			}
+			else if (batch && !(s->flags & SURF_DRAWTURB))
+			{
+				R_BatchTextureChain (e, s);
+			}
 			else
 			{
 				for ( ; s ; s = s->texturechain)
@@ -1126,6 +1335,9 @@ static void DrawTextureChains (entity_t *e)
 
 		t->texturechain = NULL;
 	}
+
+	if (batch)
+		R_EndBatch (gl_mtexable);
 }
 
 /*
@@ -1612,6 +1824,62 @@ static void GL_CreateSurfaceLightmap (msurface_t *surf)
 }
 
 
+/*
+==================
+GL_BuildPolyArray
+
+Copies the polygons of all brush models into
+one array for the vertex array renderer
+==================
+*/
+static void GL_BuildPolyArray (void)
+{
+	int		i, j, numverts;
+	qmodel_t	*m;
+	glpoly_t	*p;
+	float		*v;
+
+	numverts = 0;
+	for (j = 1; j < MAX_MODELS; j++)
+	{
+		m = cl.model_precache[j];
+		if (!m)
+			break;
+		if (m->name[0] == '*')
+			continue;
+		for (i = 0; i < m->numsurfaces; i++)
+		{
+			if (m->surfaces[i].flags & (SURF_DRAWTURB|SURF_DRAWSKY))
+				continue;
+			for (p = m->surfaces[i].polys; p; p = p->next)
+				numverts += p->numverts;
+		}
+	}
+
+	poly_verts = v = (float *) Hunk_AllocName (numverts * VERTEXSIZE*sizeof(float), "polyverts");
+	numverts = 0;
+	for (j = 1; j < MAX_MODELS; j++)
+	{
+		m = cl.model_precache[j];
+		if (!m)
+			break;
+		if (m->name[0] == '*')
+			continue;
+		for (i = 0; i < m->numsurfaces; i++)
+		{
+			if (m->surfaces[i].flags & (SURF_DRAWTURB|SURF_DRAWSKY))
+				continue;
+			for (p = m->surfaces[i].polys; p; p = p->next)
+			{
+				p->firstvert = numverts;
+				memcpy (v, p->verts, p->numverts * VERTEXSIZE*sizeof(float));
+				v += p->numverts * VERTEXSIZE;
+				numverts += p->numverts;
+			}
+		}
+	}
+}
+
 /*
 ==================
 GL_BuildLightmaps
@@ -1626,6 +1894,7 @@ void GL_BuildLightmaps (void)
 	qmodel_t	*m;
 
 	memset (allocated, 0, sizeof(allocated));
+	LM_FlushCache ();
 
 	r_framecount = 1;		// no dlightcache
 
@@ -1659,6 +1928,9 @@ void GL_BuildLightmaps (void)
 		}
 	}
 
+	if (!draw_reinit)
+		GL_BuildPolyArray ();
+
 	if (gl_mtexable)
 		glActiveTextureARB_fp (GL_TEXTURE1_ARB);
 
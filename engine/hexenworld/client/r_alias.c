@@ -49,6 +49,10 @@ newmdl_t		*pmdl;		//JFM: new model fmt
 static qmodel_t		*pmodel;
 static float		ziscale;
 
+#if !id68k
+static int		r_aliasshade[NUMVERTEXNORMALS];	// light of every vertex normal
+#endif
+
 static vec3_t		alias_forward, alias_right, alias_up;
 
 static maliasskindesc_t	*pskindesc;
@@ -77,14 +81,7 @@ static aedge_t	aedges[12] =
 };
 
 
-#if !id386 && !id68k
-static void R_AliasTransformAndProjectFinalVerts (finalvert_t *fv, stvert_t *pstverts);
-#endif
 static void R_AliasSetUpTransform (int trivial_accept);
-#if !id68k
-static void R_AliasTransformVector (vec3_t in, vec3_t out);
-static void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av, trivertx_t *pverts);
-#endif
 
 
 /*
@@ -164,10 +161,14 @@ qboolean R_AliasCheckBBox (void)
 	zfullyclipped = true;
 
 	minz = 9999;
+#if id68k
 	for (i = 0 ; i < 8 ; i++)
-	{
 		R_AliasTransformVector (&basepts[i][0], &viewaux[i].fv[0]);
-
+#else
+	r_aliask->transformpoints (viewaux, &basepts[0][0], 8);
+#endif
+	for (i = 0 ; i < 8 ; i++)
+	{
 		if (viewaux[i].fv[2] < ALIAS_Z_CLIP_PLANE)
 		{
 		// we must clip points that are closer than the near clip plane
@@ -264,21 +265,6 @@ qboolean R_AliasCheckBBox (void)
 }
 
 
-#if !id68k
-/*
-================
-R_AliasTransformVector
-================
-*/
-static void R_AliasTransformVector (vec3_t in, vec3_t out)
-{
-	out[0] = DotProduct(in, aliastransform[0]) + aliastransform[0][3];
-	out[1] = DotProduct(in, aliastransform[1]) + aliastransform[1][3];
-	out[2] = DotProduct(in, aliastransform[2]) + aliastransform[2][3];
-}
-#endif
-
-
 /*
 ================
 R_AliasPreparePoints
@@ -290,13 +276,16 @@ static void R_AliasPreparePoints (void)
 {
 	int			i;
 	stvert_t	*pstverts;
+#if id68k
 	finalvert_t	*fv;
 	auxvert_t	*av;
+#endif
 	mtriangle_t	*ptri;
 	finalvert_t	*pfv[3];
 
 	pstverts = (stvert_t *)((byte *)paliashdr + paliashdr->stverts);
 	r_anumverts = pmdl->numverts;
+#if id68k
 	fv = pfinalverts;
 	av = pauxverts;
 
@@ -320,6 +309,10 @@ static void R_AliasPreparePoints (void)
 				fv->flags |= ALIAS_BOTTOM_CLIP;
 		}
 	}
+#else
+	r_aliask->clipverts (pfinalverts, pauxverts, r_apverts, r_aliasshade, ziscale, r_anumverts);
+	r_apverts += r_anumverts;
+#endif
 
 //
 // clip and draw all triangles
@@ -555,98 +548,6 @@ static void R_AliasSetUpTransform (int trivial_accept)
 }
 
 
-#if !id68k
-/*
-================
-R_AliasTransformFinalVert
-================
-*/
-static void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av, trivertx_t *pverts)
-{
-	int		temp;
-	float	lightcos, *plightnormal;
-
-	av->fv[0] = DotProduct(pverts->v, aliastransform[0]) + aliastransform[0][3];
-	av->fv[1] = DotProduct(pverts->v, aliastransform[1]) + aliastransform[1][3];
-	av->fv[2] = DotProduct(pverts->v, aliastransform[2]) + aliastransform[2][3];
-
-// lighting
-	plightnormal = r_avertexnormals[pverts->lightnormalindex];
-	lightcos = DotProduct (plightnormal, r_plightvec);
-	temp = r_ambientlight;
-
-	if (lightcos < 0)
-	{
-		temp += (int)(r_shadelight * lightcos);
-
-	// clamp; because we limited the minimum ambient and shading light, we
-	// don't have to clamp low light, just bright
-		if (temp < 0)
-			temp = 0;
-	}
-
-	fv->v[4] = temp;
-}
-#endif
-
-
-#if	!id386 && !id68k
-
-/*
-================
-R_AliasTransformAndProjectFinalVerts
-================
-*/
-static void R_AliasTransformAndProjectFinalVerts (finalvert_t *fv, stvert_t *pstverts)
-{
-	int			i, temp;
-	float		lightcos, *plightnormal, zi;
-	trivertx_t	*pverts;
-
-	pverts = r_apverts;
-
-	for (i = 0 ; i < r_anumverts ; i++, fv++, pverts++, pstverts++)
-	{
-	// transform and project
-		zi = 1.0 / (DotProduct(pverts->v, aliastransform[2]) +
-						aliastransform[2][3]);
-
-	// x, y, and z are scaled down by 1/2**31 in the transform, so 1/z is
-	// scaled up by 1/2**31, and the scaling cancels out for x and y in the
-	// projection
-		fv->v[5] = zi;
-
-		fv->v[0] = ((DotProduct(pverts->v, aliastransform[0]) +
-				aliastransform[0][3]) * zi) + aliasxcenter;
-		fv->v[1] = ((DotProduct(pverts->v, aliastransform[1]) +
-				aliastransform[1][3]) * zi) + aliasycenter;
-
-		fv->v[2] = pstverts->s;
-		fv->v[3] = pstverts->t;
-		fv->flags = pstverts->onseam;
-
-	// lighting
-		plightnormal = r_avertexnormals[pverts->lightnormalindex];
-		lightcos = DotProduct (plightnormal, r_plightvec);
-		temp = r_ambientlight;
-
-		if (lightcos < 0)
-		{
-			temp += (int)(r_shadelight * lightcos);
-
-		// clamp; because we limited the minimum ambient and shading
-		// light, we don't have to clamp low light, just bright
-			if (temp < 0)
-				temp = 0;
-		}
-
-		fv->v[4] = temp;
-	}
-}
-
-#endif
-
-
 /*
 ================
 R_AliasProjectFinalVert
@@ -683,7 +584,11 @@ void R_AliasPrepareUnclippedPoints (void)
 // FIXME: just use pfinalverts directly?
 	fv = pfinalverts;
 
+#if id386 || id68k
 	R_AliasTransformAndProjectFinalVerts (fv, pstverts);
+#else
+	r_aliask->projectverts (fv, r_apverts, pstverts, r_aliasshade, r_anumverts);
+#endif
 
 	r_affinetridesc.pfinalverts = pfinalverts;
 	r_affinetridesc.ptriangles = (mtriangle_t *)
@@ -885,6 +790,39 @@ static void R_AliasSetupLighting (alight_t *plighting)
 	r_plightvec[2] = DotProduct (plighting->plightvec, alias_up);
 }
 
+#if !id68k
+/*
+================
+R_AliasSetupShading
+
+Lights every vertex normal once, the vertex kernels look the light up
+================
+*/
+static void R_AliasSetupShading (void)
+{
+	int		i, temp;
+	float	lightcos;
+
+	for (i = 0 ; i < NUMVERTEXNORMALS ; i++)
+	{
+		lightcos = DotProduct (r_avertexnormals[i], r_plightvec);
+		temp = r_ambientlight;
+
+		if (lightcos < 0)
+		{
+			temp += (int)(r_shadelight * lightcos);
+
+		// clamp; because we limited the minimum ambient and shading
+		// light, we don't have to clamp low light, just bright
+			if (temp < 0)
+				temp = 0;
+		}
+
+		r_aliasshade[i] = temp;
+	}
+}
+#endif
+
 /*
 =================
 R_AliasSetupFrame
@@ -1105,6 +1043,10 @@ void R_AliasDrawModel (alight_t *plighting)
 	else
 		ziscale = (float)0x8000 * (float)0x10000 * 3.0;
 
+#if !id68k
+	R_AliasSetupShading ();
+#endif
+
 	if (currententity->trivial_accept)
 		R_AliasPrepareUnclippedPoints ();
 	else
@@ -20,6 +20,9 @@
 
 #include "quakedef.h"
 #include "r_local.h"
+#include "lmcache.h"
+#include "d_local.h"
+#include "threads.h"
 
 /*
 ===============
@@ -85,6 +88,183 @@ void R_TimeRefresh_f (void)
 	r_refdef.viewangles[1] = startangle;
 }
 
+#if USE_SPANTHREADS
+/*
+====================
+R_ThreadDiffs
+
+Renders the view serially into serial and then threaded into
+the screen and returns the number of pixels that differ.
+====================
+*/
+static int R_ThreadDiffs (byte *serial)
+{
+	byte		*src, *dst;
+	int		x, y, diffs;
+
+	Cvar_SetValueQuick (&r_threads, 0);
+	R_PushDlights ();
+	R_RenderView ();
+	memcpy (serial, vid.buffer, vid.rowbytes * vid.height);
+
+	Cvar_SetValueQuick (&r_threads, 1);
+	R_PushDlights ();
+	R_RenderView ();
+
+	diffs = 0;
+	for (y = r_refdef.vrect.y; y < r_refdef.vrect.y + r_refdef.vrect.height; y++)
+	{
+		src = serial + y * vid.rowbytes;
+		dst = vid.buffer + y * vid.rowbytes;
+		for (x = r_refdef.vrect.x; x < r_refdef.vrect.x + r_refdef.vrect.width; x++)
+		{
+			if (src[x] != dst[x])
+				diffs++;
+		}
+	}
+
+	return diffs;
+}
+#endif	/* USE_SPANTHREADS */
+
+/*
+====================
+R_ThreadCheck_f
+
+Renders the view with and without the threaded span drawing
+and counts the pixels that came out different, once with the
+normal surface cache and once with one that barely holds the
+largest surface, so that the span batches get flushed early.
+====================
+*/
+void R_ThreadCheck_f (void)
+{
+#if USE_SPANTHREADS
+	byte		*serial;
+	int		diffs, smalldiffs, oldthreads;
+
+	if (cls.state != ca_active)
+	{
+		Con_Printf("Not connected to a server\n");
+		return;
+	}
+	if (Thread_Count () < 2)
+	{
+		Con_Printf("Only one thread, nothing to compare\n");
+		return;
+	}
+
+	serial = (byte *) malloc (vid.rowbytes * vid.height);
+	if (!serial)
+	{
+		Con_Printf("Not enough memory\n");
+		return;
+	}
+
+	oldthreads = r_threads.integer;
+
+	VID_LockBuffer ();
+
+	diffs = R_ThreadDiffs (serial);
+
+// D_SCAlloc takes blocks of up to 0x10000 bytes plus the header
+	D_LimitCaches (0x10000 + 1024);
+	smalldiffs = R_ThreadDiffs (serial);
+	D_LimitCaches (0);
+
+	VID_UnlockBuffer ();
+
+	Cvar_SetValueQuick (&r_threads, oldthreads);
+	free (serial);
+
+	Con_Printf ("%d of %d pixels differ (%d threads)\n", diffs,
+			r_refdef.vrect.width * r_refdef.vrect.height, Thread_Count ());
+	Con_Printf ("%d differ with a small surface cache\n", smalldiffs);
+#else
+	Con_Printf("Threaded span drawing is not available in this build\n");
+#endif
+}
+
+/*
+====================
+R_TimeSpans_f
+
+timerefresh with each span drawer that the cpu can run, and a
+count of the pixels where they differ from the C drawer
+====================
+*/
+void R_TimeSpans_f (void)
+{
+#if !id386 && !id68k
+	const spandrawer_t	*d;
+	char		olddrawer[32];
+	byte		*reference;
+	int		i, x, y, diffs;
+	float		start, stop, time;
+	int		startangle;
+
+	if (cls.state != ca_active)
+	{
+		Con_Printf("Not connected to a server\n");
+		return;
+	}
+
+	reference = (byte *) malloc (vid.rowbytes * vid.height);
+	if (!reference)
+	{
+		Con_Printf("Not enough memory\n");
+		return;
+	}
+
+	q_strlcpy (olddrawer, Cvar_VariableString("d_spandrawer"), sizeof(olddrawer));
+	startangle = r_refdef.viewangles[1];
+
+	for (d = D_SpanDrawers (); d->name; d++)
+	{
+		Cvar_Set ("d_spandrawer", d->name);
+
+		VID_LockBuffer ();
+		r_refdef.viewangles[1] = startangle;
+		R_PushDlights ();
+		R_RenderView ();
+		diffs = 0;
+		if (d == D_SpanDrawers ())
+			memcpy (reference, vid.buffer, vid.rowbytes * vid.height);
+		else
+		{
+			for (y = r_refdef.vrect.y; y < r_refdef.vrect.y + r_refdef.vrect.height; y++)
+			{
+				for (x = r_refdef.vrect.x; x < r_refdef.vrect.x + r_refdef.vrect.width; x++)
+				{
+					if (reference[y * vid.rowbytes + x] != vid.buffer[y * vid.rowbytes + x])
+						diffs++;
+				}
+			}
+		}
+		VID_UnlockBuffer ();
+
+		start = Sys_DoubleTime ();
+		for (i = 0; i < 128; i++)
+		{
+			r_refdef.viewangles[1] = i/128.0*360.0;
+
+			VID_LockBuffer ();
+			R_RenderView ();
+			VID_UnlockBuffer ();
+		}
+		stop = Sys_DoubleTime ();
+		time = stop-start;
+		Con_Printf ("%-8s %f seconds (%f fps), %d pixels differ\n", d->name, time, 128/time, diffs);
+	}
+
+	r_refdef.viewangles[1] = startangle;
+	Cvar_Set ("d_spandrawer", olddrawer);
+	free (reference);
+#else
+	Con_Printf("The asm span drawers are the only ones in this build\n");
+#endif
+}
+
 /*
 ================
 R_LineGraph
@@ -391,10 +571,12 @@ void R_PrintTimes(void)
 	ms = 1000 * (r_time2 - r_time1);
 	fps = 1000 / ms;
 
-	Con_Printf("%3.1f fps %5.0f ms\n%3i/%3i/%3i poly %3i surf\n",
-		fps, ms, c_faceclip, r_polycount, r_drawnpolycount, c_surf);
+	Con_Printf("%3.1f fps %5.0f ms\n%3i/%3i/%3i poly %3i surf\n%3i/%3i lightmaps cached\n",
+		fps, ms, c_faceclip, r_polycount, r_drawnpolycount, c_surf,
+		lm_cachehits, lm_cachelookups);
 
 	c_surf = 0;
+	lm_cachehits = lm_cachelookups = 0;
 }
 
 /*
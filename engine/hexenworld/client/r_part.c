@@ -23,9 +23,9 @@
 #include "r_local.h"
 
 
-#define	MAX_PARTICLES		2048	// default max # of particles at one time
 #define	ABSOLUTE_MIN_PARTICLES	512	// no fewer than this no matter what's
 					// on the command line
+#define	ABSOLUTE_MAX_PARTICLES	1048576
 
 //=============================================================================
 
@@ -47,17 +47,50 @@ static int ramp13[16] ={ 144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154,
 
 //=============================================================================
 
-particle_t	*active_particles, *free_particles;
-particle_t	*particles;
-static int	r_numparticles;
+/* The live particles are kept as structures of arrays in chunks, one
+ * list of chunks per type, so that R_RunParticles can update each type in
+ * tight loops over the arrays it needs.  All chunks of a list but the
+ * first are full: a dead particle is replaced by the last one of its
+ * type, and spawned particles are appended.  AllocParticle hands out
+ * spawn records from r_spawned, which R_PackParticles moves into the
+ * chunks.  Types beyond the known ones (they come from the network) share
+ * the last list and only move.  */
+#define	PT_NUMTYPES		(pt_bluestep + 1)
+#define	PT_NUMGROUPS		(PT_NUMTYPES + 1)
+#define	PT_GROUP(t)		((t) < PT_NUMTYPES ? (t) : PT_NUMTYPES)
+
+#define	PCHUNK_SIZE		64
+
+typedef struct pchunk_s
+{
+	struct pchunk_s	*next;
+	int		count;
+	float		org[3][PCHUNK_SIZE];
+	float		vel[3][PCHUNK_SIZE];
+	float		color[PCHUNK_SIZE];
+	float		ramp[PCHUNK_SIZE];
+	float		die[PCHUNK_SIZE];
+	byte		type[PCHUNK_SIZE];
+} pchunk_t;
+
+static pchunk_t		*r_pchunks, *r_freepchunks;
+static int		r_numpchunks;
+static pchunk_t		*r_pgroups[PT_NUMGROUPS];
+static int		r_numactive;
+
+static particle_t	*r_spawned;
+static int		r_numspawned;
+static int		r_numparticles;
 
 vec3_t		r_pright, r_pup, r_ppn;
 static	vec3_t	rider_origin;
 
+static	cvar_t	r_maxparticles = {"r_maxparticles", "2048", CVAR_ARCHIVE};	// max # of particles at one time
 static	cvar_t	leak_color = {"leak_color", "251", CVAR_ARCHIVE};
 
 
 static particle_t *AllocParticle (void);
+static void R_ParticleBench_f (void);
 
 void R_RunParticleEffect2 (vec3_t org, vec3_t dmin, vec3_t dmax, int color, ptype_t effect, int count);
 void R_RunParticleEffect3 (vec3_t org, vec3_t box, int color, ptype_t effect, int count);
@@ -66,6 +99,54 @@ void R_RunParticleEffect4 (vec3_t org, float radius, int color, ptype_t effect,
 //=============================================================================
 
 
+/*
+===============
+R_AllocParticles
+
+Makes room for count particles.  The live ones are dropped.
+===============
+*/
+static void R_AllocParticles (int count)
+{
+	pchunk_t	*chunks;
+	particle_t	*spawned;
+	int		numchunks;
+
+	numchunks = (count + PCHUNK_SIZE - 1) / PCHUNK_SIZE + PT_NUMGROUPS;
+	chunks = (pchunk_t *) malloc (numchunks * sizeof(pchunk_t));
+	spawned = (particle_t *) malloc (count * sizeof(particle_t));
+	if (!chunks || !spawned)
+	{
+		free (chunks);
+		free (spawned);
+		if (!r_pchunks)
+			Sys_Error ("%s: failed on allocating %d particles", __thisfunc__, count);
+		Con_Printf ("Not enough memory for %d particles\n", count);
+		return;
+	}
+
+	free (r_pchunks);
+	free (r_spawned);
+	r_pchunks = chunks;
+	r_numpchunks = numchunks;
+	r_spawned = spawned;
+	r_numparticles = count;
+	R_ClearParticles ();
+}
+
+static void R_MaxParticles_f (cvar_t *var)
+{
+	int		count;
+
+	count = var->integer;
+	if (count < ABSOLUTE_MIN_PARTICLES)
+		count = ABSOLUTE_MIN_PARTICLES;
+	else if (count > ABSOLUTE_MAX_PARTICLES)
+		count = ABSOLUTE_MAX_PARTICLES;
+	if (count != r_numparticles)
+		R_AllocParticles (count);
+}
+
 /*
 ===============
 R_InitParticles
@@ -75,20 +156,14 @@ void R_InitParticles (void)
 {
 	int		i;
 
+	Cvar_RegisterVariable (&r_maxparticles);
+	Cvar_SetCallback (&r_maxparticles, R_MaxParticles_f);
 	i = COM_CheckParm ("-particles");
-
 	if (i && i < com_argc-1)
-	{
-		r_numparticles = atoi(com_argv[i+1]);
-		if (r_numparticles < ABSOLUTE_MIN_PARTICLES)
-			r_numparticles = ABSOLUTE_MIN_PARTICLES;
-	}
-	else
-	{
-		r_numparticles = MAX_PARTICLES;
-	}
+		Cvar_SetROM ("r_maxparticles", com_argv[i+1]);
+	R_MaxParticles_f (&r_maxparticles);
 
-	particles = (particle_t *) Hunk_AllocName (r_numparticles * sizeof(particle_t), "particles");
+	Cmd_AddCommand ("r_particlebench", R_ParticleBench_f);
 
 	Cvar_RegisterVariable (&leak_color);
 }
@@ -146,13 +221,11 @@ static particle_t *AllocParticle (void)
 {
 	particle_t	*p;
 
-	if (!free_particles)
+	if (r_numactive + r_numspawned >= r_numparticles)
 		return NULL;
 
-	p = free_particles;
-	free_particles = p->next;
-	p->next = active_particles;
-	active_particles = p;
+	p = &r_spawned[r_numspawned++];
+	memset (p, 0, sizeof(particle_t));
 
 	return p;
 }
@@ -166,14 +239,15 @@ void R_ClearParticles (void)
 {
 	int		i;
 
-	if (!r_numparticles)
-		return;
-	free_particles = &particles[0];
-	active_particles = NULL;
-
-	for (i = 0; i < r_numparticles-1; i++)
-		particles[i].next = &particles[i+1];
-	particles[r_numparticles-1].next = NULL;
+	r_freepchunks = NULL;
+	for (i = r_numpchunks - 1; i >= 0; i--)
+	{
+		r_pchunks[i].next = r_freepchunks;
+		r_freepchunks = &r_pchunks[i];
+	}
+	memset (r_pgroups, 0, sizeof(r_pgroups));
+	r_numactive = 0;
+	r_numspawned = 0;
 }
 
 
@@ -1551,6 +1625,146 @@ void R_ColoredParticleExplosion (vec3_t org, int color, int radius, int counter)
 }
 
 
+/*
+===============
+R_AddParticle
+
+Appends the spawn record p to the chunks of its type
+===============
+*/
+static void R_AddParticle (const particle_t *p)
+{
+	pchunk_t	*c, **group;
+	int		i;
+
+	group = &r_pgroups[PT_GROUP(p->type)];
+	c = *group;
+	if (!c || c->count == PCHUNK_SIZE)
+	{
+		c = r_freepchunks;
+		if (!c)
+			return;		// out of chunks, drop the particle
+		r_freepchunks = c->next;
+		c->next = *group;
+		c->count = 0;
+		*group = c;
+	}
+
+	i = c->count++;
+	c->org[0][i] = p->org[0];
+	c->org[1][i] = p->org[1];
+	c->org[2][i] = p->org[2];
+	c->vel[0][i] = p->vel[0];
+	c->vel[1][i] = p->vel[1];
+	c->vel[2][i] = p->vel[2];
+	c->color[i] = p->color;
+	c->ramp[i] = p->ramp;
+	c->die[i] = p->die;
+	c->type[i] = p->type;
+	r_numactive++;
+}
+
+/*
+===============
+R_RemoveParticle
+
+Replaces particle i of chunk c by the last particle of the type.  Chunks
+emptied by earlier removals are given back here, the caller may still be
+walking the one it empties.
+===============
+*/
+static void R_RemoveParticle (pchunk_t **group, pchunk_t *c, int i)
+{
+	pchunk_t	*last;
+	int		j;
+
+	last = *group;
+	while (!last->count)
+	{
+		*group = last->next;
+		last->next = r_freepchunks;
+		r_freepchunks = last;
+		last = *group;
+	}
+
+	j = --last->count;
+	if (last != c || j != i)
+	{
+		c->org[0][i] = last->org[0][j];
+		c->org[1][i] = last->org[1][j];
+		c->org[2][i] = last->org[2][j];
+		c->vel[0][i] = last->vel[0][j];
+		c->vel[1][i] = last->vel[1][j];
+		c->vel[2][i] = last->vel[2][j];
+		c->color[i] = last->color[j];
+		c->ramp[i] = last->ramp[j];
+		c->die[i] = last->die[j];
+		c->type[i] = last->type[j];
+	}
+	r_numactive--;
+}
+
+/*
+===============
+R_PackParticles
+
+Drops the dead particles and moves the spawned ones into the chunks
+===============
+*/
+static void R_PackParticles (void)
+{
+	pchunk_t	*c, **group;
+	int		g, i;
+
+	for (g = 0; g < PT_NUMGROUPS; g++)
+	{
+		group = &r_pgroups[g];
+		for (c = *group; c; c = c->next)
+		{
+			for (i = 0; i < c->count; )
+			{
+				if (c->die[i] < cl.time)
+					R_RemoveParticle (group, c, i);
+				else
+					i++;
+			}
+		}
+
+		while (*group && !(*group)->count)
+		{
+			c = *group;
+			*group = c->next;
+			c->next = r_freepchunks;
+			r_freepchunks = c;
+		}
+	}
+
+	for (i = 0; i < r_numspawned; i++)
+	{
+		if (r_spawned[i].die >= cl.time)
+			R_AddParticle (&r_spawned[i]);
+	}
+	r_numspawned = 0;
+}
+
+/*
+===============
+R_GetParticle
+
+Gathers what the drivers need of particle i of chunk c into p
+===============
+*/
+static void R_GetParticle (const pchunk_t *c, int i, particle_t *p)
+{
+	p->org[0] = c->org[0][i];
+	p->org[1] = c->org[1][i];
+	p->org[2] = c->org[2][i];
+	p->color = c->color[i];
+	p->ramp = c->ramp[i];
+	p->type = c->type[i];
+}
+
+
 #ifdef GLQUAKE
 static qboolean		alphaTestEnabled;
 static vec3_t		up, right;
@@ -1628,42 +1842,42 @@ static void R_RenderParticle (particle_t *p)
 
 /*
 ===============
-R_DrawParticles
+R_MoveParticles
+
+org += vel * frametime for the particles of chunk c, one coordinate at a
+time so that the compiler can vectorize it
 ===============
 */
-void R_DrawParticles (void)
+static void R_MoveParticles (pchunk_t *c, float frametime)
 {
-	particle_t	*p, *kill, temp_p;
-	float		grav, grav2, percent;
-	int		i;
-	float		time2, time3, time4;
-	float		time1;
-	float		dvel;
-	float		frametime;
-	float		vel0, vel1, vel2;
-	vec3_t		diff;
-
-#ifdef GLQUAKE
-	GL_Bind(particletexture);
-	alphaTestEnabled = glIsEnabled_fp(GL_ALPHA_TEST);
+	int		i, j;
 
-	if (alphaTestEnabled)
-		glDisable_fp(GL_ALPHA_TEST);
-	glEnable_fp (GL_BLEND);
-	glTexEnvf_fp(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-	glBegin_fp (GL_TRIANGLES);
+	for (j = 0; j < 3; j++)
+	{
+		for (i = 0; i < c->count; i++)
+			c->org[j][i] += c->vel[j][i] * frametime;
+	}
+}
 
-	VectorScale (vup, 1.5, up);
-	VectorScale (vright, 1.5, right);
-#else
-	D_StartParticles ();
+/*
+===============
+R_RunParticles
 
-	VectorScale (vright, xscaleshrink, r_pright);
-	VectorScale (vup, yscaleshrink, r_pup);
-	VectorCopy (vpn, r_ppn);
-#endif
+Moves the particles and runs their color ramps, type by type
+===============
+*/
+static void R_RunParticles (float frametime)
+{
+	float		grav, grav2, percent;
+	float		time2, time3, time4;
+	float		time1;
+	float		dvel, scale;
+	float		*ox, *oy, *oz;
+	float		*vx, *vy, *vz;
+	float		*color, *ramp, *die;
+	pchunk_t	*c;
+	int		t, i, n;
 
-	frametime = host_frametime;
 	time4 = frametime * 20;
 	time3 = frametime * 15;
 	time2 = frametime * 10; // 15;
@@ -1673,329 +1887,421 @@ void R_DrawParticles (void)
 	dvel = 4 * frametime;
 	percent = (frametime / HX_FRAME_TIME);
 
-	/*
-	temp_p.org[0] = -1013;
-	temp_p.org[1] = -1863;
-	temp_p.org[2] = 50;
-	temp_p.color = 31;
-	R_RenderParticle(&temp_p);
-	*/
-	for ( ;; )
+	for (t = 0; t < PT_NUMGROUPS; t++)
 	{
-		kill = active_particles;
-		if (kill && kill->die < cl.time)
+	    for (c = r_pgroups[t]; c; c = c->next)
+	    {
+		R_MoveParticles (c, frametime);
+
+		n = c->count;
+		ox = c->org[0];
+		oy = c->org[1];
+		oz = c->org[2];
+		vx = c->vel[0];
+		vy = c->vel[1];
+		vz = c->vel[2];
+		color = c->color;
+		ramp = c->ramp;
+		die = c->die;
+
+		switch (t)
 		{
-			active_particles = kill->next;
-			kill->next = free_particles;
-			free_particles = kill;
-			continue;
-		}
-		break;
-	}
-
-	for (p = active_particles ; p ; p = p->next)
-	{
-		for ( ;; )
-		{
-			kill = p->next;
-			if (kill && kill->die < cl.time)
+		case pt_fire:
+			for (i = 0; i < n; i++)
 			{
-				p->next = kill->next;
-				kill->next = free_particles;
-				free_particles = kill;
-				continue;
+				ramp[i] += time1;
+				if ((int)ramp[i] >= 6)
+					die[i] = -1;
+				else
+					color[i] = ramp3[(int)ramp[i]];
+				vz[i] += grav;
 			}
 			break;
-		}
-
-		if (p->type == pt_rain)
-		{
-			temp_p = *p;
-
-			vel0 = temp_p.vel[0]*.001;
-			vel1 = temp_p.vel[1]*.001;
-			vel2 = temp_p.vel[2]*.001;
-			for (i = 0; i < 4; i++)
-			{
-				R_RenderParticle(&temp_p);
-
-				temp_p.org[0] += vel0;
-				temp_p.org[1] += vel1;
-				temp_p.org[2] += vel2;
- 			}
-		}
-
-		R_RenderParticle(p);
-		p->org[0] += p->vel[0] * frametime;
-		p->org[1] += p->vel[1] * frametime;
-		p->org[2] += p->vel[2] * frametime;
-
-		switch (p->type)
-		{
-		case pt_static:
-			break;
-
-		case pt_fire:
-			p->ramp += time1;
-			if ((int)p->ramp >= 6)
-				p->die = -1;
-			else
-				p->color = ramp3[(int)p->ramp];
-			p->vel[2] += grav;
-			break;
 
 		case pt_explode:
-			p->ramp += time2;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp1[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp1[(int)ramp[i]];
+				vx[i] += vx[i]*dvel;
+				vy[i] += vy[i]*dvel;
+				vz[i] += vz[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_explode2:
-			p->ramp += time3;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp2[(int)p->ramp];
-			for (i = 0; i < 3; i++)
-				p->vel[i] -= p->vel[i] * frametime;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp2[(int)ramp[i]];
+				vx[i] -= vx[i] * frametime;
+				vy[i] -= vy[i] * frametime;
+				vz[i] -= vz[i] * frametime;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_c_explode:
-			p->ramp += time2;
-			if ((int)p->ramp >= 8 || p->color <= 0)
-				p->die = -1;
-			else if (time2)
-				p->color--;
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 8 || color[i] <= 0)
+					die[i] = -1;
+				else if (time2)
+					color[i]--;
+				vx[i] += vx[i]*dvel;
+				vy[i] += vy[i]*dvel;
+				vz[i] += vz[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_c_explode2:
-			p->ramp += time3;
-			if ((int)p->ramp >= 8 || p->color <= 1)
-				p->die = -1;
-			else if (time3)
-				p->color -= 2;
-			for (i = 0; i < 3; i++)
-				p->vel[i] -= p->vel[i] * frametime;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 8 || color[i] <= 1)
+					die[i] = -1;
+				else if (time3)
+					color[i] -= 2;
+				vx[i] -= vx[i] * frametime;
+				vy[i] -= vy[i] * frametime;
+				vz[i] -= vz[i] * frametime;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_blob:
-			for (i = 0; i < 3; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				vx[i] += vx[i]*dvel;
+				vy[i] += vy[i]*dvel;
+				vz[i] += vz[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_blob2:
-			for (i = 0; i < 2; i++)
-				p->vel[i] -= p->vel[i]*dvel;
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				vx[i] -= vx[i]*dvel;
+				vy[i] -= vy[i]*dvel;
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_grav:
 #ifdef QUAKE2
-			p->vel[2] -= grav * 20;
+			for (i = 0; i < n; i++)
+				vz[i] -= grav * 20;
 			break;
 #endif
 		case pt_slowgrav:
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+				vz[i] -= grav;
 			break;
 
 		case pt_grensmoke:
-			p->vel[0] += time3 * ((rand() % 3) - 1);
-			p->vel[1] += time3 * ((rand() % 3) - 1);
-			p->vel[2] += time3 * ((rand() % 3) - 1);
+			for (i = 0; i < n; i++)
+			{
+				vx[i] += time3 * ((rand() % 3) - 1);
+				vy[i] += time3 * ((rand() % 3) - 1);
+				vz[i] += time3 * ((rand() % 3) - 1);
+			}
 			break;
 
 		case pt_fastgrav:
-			p->vel[2] -= grav * 4;
-			break;
-
-		case pt_rain:
+			for (i = 0; i < n; i++)
+				vz[i] -= grav * 4;
 			break;
 
 		case pt_fireball:
-			p->ramp += time3;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp4[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp4[(int)ramp[i]];
+			}
 			break;
 
 		case pt_acidball:
-			p->ramp += time4 * 1.4;
-			if ((int)p->ramp >= 23)
-				p->die = -1;
-			else if ((int)p->ramp >= 15)
-				p->color = ramp11[(int)p->ramp - 15];
-			else
-				p->color = ramp10[(int)p->ramp];
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time4 * 1.4;
+				if ((int)ramp[i] >= 23)
+					die[i] = -1;
+				else if ((int)ramp[i] >= 15)
+					color[i] = ramp11[(int)ramp[i] - 15];
+				else
+					color[i] = ramp10[(int)ramp[i]];
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_spit:
-			p->ramp += time3;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp6[(int)p->ramp];
-		//	p->vel[2] += grav * 2;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp6[(int)ramp[i]];
+			}
 			break;
 
 		case pt_ice:
-			p->ramp += time4;
-			if ((int)p->ramp > 15)
-				p->die = -1;
-			else
-				p->color = ramp5[(int)p->ramp];
-			p->vel[2] -= grav;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time4;
+				if ((int)ramp[i] > 15)
+					die[i] = -1;
+				else
+					color[i] = ramp5[(int)ramp[i]];
+				vz[i] -= grav;
+			}
 			break;
 
 		case pt_spell:
-			p->ramp += time2;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp7[(int)p->ramp];
-		//	p->vel[2] += grav * 2;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time2;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp7[(int)ramp[i]];
+			}
 			break;
 
 		case pt_test:
-			p->vel[2] += 1.3;
-			p->ramp += time3;
-			if ((int)p->ramp >= 13 || ((int)p->ramp > 10 && p->vel[2] < 20) )
-				p->die = -1;
-			else
-				p->color = ramp8[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				vz[i] += 1.3;
+				ramp[i] += time3;
+				if ((int)ramp[i] >= 13 || ((int)ramp[i] > 10 && vz[i] < 20) )
+					die[i] = -1;
+				else
+					color[i] = ramp8[(int)ramp[i]];
+			}
 			break;
 
 		case pt_quake:
-			p->vel[0] *= 1.05;
-			p->vel[1] *= 1.05;
-			p->vel[2] -= grav * 4;
-			if (p->color < 160 && p->color > 143)
-				p->color = 152 + 7 * ((p->die - cl.time) * 2.0);
-			if (p->color < 144 && p->color > 127)
-				p->color = 136 + 7 * ((p->die - cl.time) * 2.0);
+			for (i = 0; i < n; i++)
+			{
+				vx[i] *= 1.05;
+				vy[i] *= 1.05;
+				vz[i] -= grav * 4;
+				if (color[i] < 160 && color[i] > 143)
+					color[i] = 152 + 7 * ((die[i] - cl.time) * 2.0);
+				if (color[i] < 144 && color[i] > 127)
+					color[i] = 136 + 7 * ((die[i] - cl.time) * 2.0);
+			}
 			break;
 
 		case pt_rd:
 			if (!frametime)
 				break;
 
-			p->ramp += percent;
-			if ((int)p->ramp > 50)
+			for (i = 0; i < n; i++)
 			{
-				p->ramp = 50;
-				p->die = -1;
-			}
-			p->color = 256 + 16 + 16 - (p->ramp / (50/16));
-
-			VectorSubtract(rider_origin, p->org, diff);
-
-			/*
-			p->org[0] += diff[0] * p->ramp / 80;
-			p->org[1] += diff[1] * p->ramp / 80;
-			p->org[2] += diff[2] * p->ramp / 80;
-			*/
-			vel0 = 1 / (51 - p->ramp);
-			p->org[0] += diff[0] * vel0;
-			p->org[1] += diff[1] * vel0;
-			p->org[2] += diff[2] * vel0;
+				ramp[i] += percent;
+				if ((int)ramp[i] > 50)
+				{
+					ramp[i] = 50;
+					die[i] = -1;
+				}
+				color[i] = 256 + 16 + 16 - (ramp[i] / (50/16));
 
+				scale = 1 / (51 - ramp[i]);
+				ox[i] += (rider_origin[0] - ox[i]) * scale;
+				oy[i] += (rider_origin[1] - oy[i]) * scale;
+				oz[i] += (rider_origin[2] - oz[i]) * scale;
+			}
 			break;
 
 		case pt_vorpal:
-			--p->color;
-			if ((int)p->color <= 37 + 256)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] <= 37 + 256)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_setstaff:
-			p->ramp += time1;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp9[(int)p->ramp];
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += time1;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp9[(int)ramp[i]];
 
-			p->vel[0] *= 1.08 * percent;
-			p->vel[1] *= 1.08 * percent;
-			p->vel[2] -= grav2;
+				vx[i] *= 1.08 * percent;
+				vy[i] *= 1.08 * percent;
+				vz[i] -= grav2;
+			}
 			break;
 
 		case pt_redfire:
-			p->ramp += frametime * 3;
-			if ((int)p->ramp >= 8)
-				p->die = -1;
-			else
-				p->color = ramp12[(int)p->ramp] + 256;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += frametime * 3;
+				if ((int)ramp[i] >= 8)
+					die[i] = -1;
+				else
+					color[i] = ramp12[(int)ramp[i]] + 256;
 
-			p->vel[0] *= .9;
-			p->vel[1] *= .9;
-			p->vel[2] += grav/2;
+				vx[i] *= .9;
+				vy[i] *= .9;
+				vz[i] += grav/2;
+			}
 			break;
 
 		case pt_bluestep:
-			p->ramp += frametime * 8;
-			if ((int)p->ramp >= 16)
-				p->die = -1;
-			else
-				p->color = ramp13[(int)p->ramp] + 256;
+			for (i = 0; i < n; i++)
+			{
+				ramp[i] += frametime * 8;
+				if ((int)ramp[i] >= 16)
+					die[i] = -1;
+				else
+					color[i] = ramp13[(int)ramp[i]] + 256;
 
-			p->vel[0] *= .9;
-			p->vel[1] *= .9;
-			p->vel[2] += grav;
+				vx[i] *= .9;
+				vy[i] *= .9;
+				vz[i] += grav;
+			}
 			break;
 
 		case pt_magicmissile:
-			--p->color;
-			if ((int)p->color < 149)
-				p->color = 149;
-			p->ramp += time1;
-			if ((int)p->ramp > 16)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 149)
+					color[i] = 149;
+				ramp[i] += time1;
+				if ((int)ramp[i] > 16)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_boneshard:
-			--p->color;
-			if ((int)p->color < 368)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 368)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_scarab:
-			--p->color;
-			if ((int)p->color < 250)
-				p->die = -1;
+			for (i = 0; i < n; i++)
+			{
+				--color[i];
+				if ((int)color[i] < 250)
+					die[i] = -1;
+			}
 			break;
 
 		case pt_darken:
-		    {
-			int	colindex;
-			p->vel[2] -= grav * 2;	// Also gravity
-			if (rand() & 1)
-				--p->color;
-			colindex = 0;
-			while (colindex < 224)
+			for (i = 0; i < n; i++)
 			{
-				if (colindex == 192 || colindex == 200)
-					colindex += 8;
-				else
-					colindex += 16;
-				if (p->color == colindex)
-					p->die = -1;
+				int	colindex;
+				vz[i] -= grav * 2;	// Also gravity
+				if (rand() & 1)
+					--color[i];
+				colindex = 0;
+				while (colindex < 224)
+				{
+					if (colindex == 192 || colindex == 200)
+						colindex += 8;
+					else
+						colindex += 16;
+					if (color[i] == colindex)
+						die[i] = -1;
+				}
 			}
-		    }
-		    break;
+			break;
+
+		default:	// static, rain, or unknown
+			break;
 		}
+	    }
 	}
+}
+
+/*
+===============
+R_DrawParticles
+===============
+*/
+void R_DrawParticles (void)
+{
+	particle_t	temp_p;
+	pchunk_t	*c;
+	int		g, i, j;
+	float		vel0, vel1, vel2;
+
+#ifdef GLQUAKE
+	GL_Bind(particletexture);
+	alphaTestEnabled = glIsEnabled_fp(GL_ALPHA_TEST);
+
+	if (alphaTestEnabled)
+		glDisable_fp(GL_ALPHA_TEST);
+	glEnable_fp (GL_BLEND);
+	glTexEnvf_fp(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glBegin_fp (GL_TRIANGLES);
+
+	VectorScale (vup, 1.5, up);
+	VectorScale (vright, 1.5, right);
+#else
+	D_StartParticles ();
+
+	VectorScale (vright, xscaleshrink, r_pright);
+	VectorScale (vup, yscaleshrink, r_pup);
+	VectorCopy (vpn, r_ppn);
+#endif
+
+	R_PackParticles ();
+
+	for (g = 0; g < PT_NUMGROUPS; g++)
+	{
+	    for (c = r_pgroups[g]; c; c = c->next)
+	    {
+		for (i = 0; i < c->count; i++)
+		{
+			R_GetParticle (c, i, &temp_p);
+
+			if (g == pt_rain)
+			{
+				vel0 = c->vel[0][i]*.001;
+				vel1 = c->vel[1][i]*.001;
+				vel2 = c->vel[2][i]*.001;
+				for (j = 0; j < 4; j++)
+				{
+					R_RenderParticle(&temp_p);
+
+					temp_p.org[0] += vel0;
+					temp_p.org[1] += vel1;
+					temp_p.org[2] += vel2;
+				}
+				R_GetParticle (c, i, &temp_p);
+			}
+
+			R_RenderParticle(&temp_p);
+		}
+	    }
+	}
+
+	R_RunParticles (host_frametime);
 
 #ifdef GLQUAKE
 	glEnd_fp ();
@@ -2008,3 +2314,75 @@ void R_DrawParticles (void)
 #endif
 }
 
+
+/*
+===============
+R_ParticleBench_f
+
+r_particlebench [count] [frames] keeps count particles of assorted types
+in front of the view and times packing and updating them, frame after
+frame.  The particles are left alive, so that a timerefresh right after
+it times drawing and updating them.
+===============
+*/
+static const byte bench_types[] =
+{
+	pt_static, pt_grav, pt_slowgrav, pt_fire, pt_explode, pt_explode2,
+	pt_c_explode, pt_spit, pt_ice, pt_spell, pt_setstaff, pt_rain, pt_darken
+};
+
+static void R_ParticleBench_f (void)
+{
+	particle_t	*p;
+	vec3_t		org;
+	double		start, packtime, runtime;
+	int		count, frames, i, j, k;
+
+	if (cls.state != ca_active)
+	{
+		Con_Printf ("r_particlebench needs a running map\n");
+		return;
+	}
+
+	count = (Cmd_Argc() > 1) ? atoi(Cmd_Argv(1)) : r_numparticles;
+	frames = (Cmd_Argc() > 2) ? atoi(Cmd_Argv(2)) : 100;
+	if (count < 1 || count > r_numparticles)
+	{
+		Con_Printf ("count must be 1 to %d (r_maxparticles)\n", r_numparticles);
+		return;
+	}
+	if (frames < 1)
+		frames = 1;
+
+	VectorMA (r_refdef.vieworg, 128, vpn, org);
+	R_ClearParticles ();
+	packtime = runtime = 0;
+
+	for (i = 0; i < frames; i++)
+	{
+		for (j = r_numactive + r_numspawned; j < count; j++)
+		{
+			p = AllocParticle ();
+			p->type = bench_types[rand() % (sizeof(bench_types) / sizeof(bench_types[0]))];
+			p->die = cl.time + 1000;
+			p->color = rand() & 255;
+			p->ramp = rand() & 3;
+			for (k = 0; k < 3; k++)
+			{
+				p->org[k] = org[k] + (rand() & 63) - 32;
+				p->vel[k] = (rand() & 255) - 128;
+			}
+		}
+
+		start = Sys_DoubleTime ();
+		R_PackParticles ();
+		packtime += Sys_DoubleTime () - start;
+
+		start = Sys_DoubleTime ();
+		R_RunParticles (HX_FRAME_TIME);
+		runtime += Sys_DoubleTime () - start;
+	}
+
+	Con_Printf ("%d particles: %.3f ms packing, %.3f ms updating per frame\n",
+			count, packtime * 1000.0 / frames, runtime * 1000.0 / frames);
+}
@@ -115,6 +115,7 @@ OBJECTS = &
 	mathlib.obj &
 	zone.obj &
 	hashindex.obj &
+	pvscache.obj &
 	huffman.obj &
 	net_udp.obj &
 	net_chan.obj &
@@ -131,6 +132,7 @@ OBJECTS = &
 	sv_main.obj &
 	sv_move.obj &
 	sv_phys.obj &
+	sv_replay.obj &
 	sv_send.obj &
 	sv_user.obj &
 	world.obj &
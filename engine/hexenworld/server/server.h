@@ -506,5 +506,32 @@ void SV_SendEffect (sizebuf_t *sb, int idx);
 void SV_SaveEffects (FILE *FH);
 void SV_LoadEffects (FILE *FH);
 
+//
+// sv_replay.c
+//
+#define	SV_REPLAY_NONE		0
+#define	SV_REPLAY_RECORD	1
+#define	SV_REPLAY_PLAY		2
+
+typedef enum
+{
+	svphase_physics,	/* SV_Physics and QuakeC */
+	svphase_packets,	/* reading client packets and console commands */
+	svphase_send,		/* building and sending client updates */
+	SV_REPLAY_NUMPHASES
+} svphase_t;
+
+extern	int	sv_replay;
+
+void SV_ReplayInit (void);
+void SV_ReplayRecordFrame (float time);
+void SV_ReplayRecordConsole (const char *text);
+void SV_ReplayRecordPacket (void);
+const char *SV_ReplayConsoleInput (void);
+int  SV_ReplayGetPacket (void);
+void SV_ReplayPhase (int phase, double seconds);
+FUNC_NORETURN void SV_ReplayRun (void);
+void SV_ReplayShutdown (void);
+
 #endif	/* __H2W_SERVER_H */
 
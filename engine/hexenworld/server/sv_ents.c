@@ -32,13 +32,13 @@ crosses a waterline.
 =============================================================================
 */
 
-static int	fatbytes;
-static byte	fatpvs[MAX_MAP_LEAFS/8];
+static int	fatwords;
+static unsigned int	fatpvs[(MAX_MAP_LEAFS+31)/32];
 
 static void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 {
 	int		i;
-	byte	*pvs;
+	unsigned int	*pvs;
 	mplane_t	*plane;
 	float	d;
 
@@ -49,8 +49,9 @@ static void SV_AddToFatPVS (vec3_t org, mnode_t *node)
 		{
 			if (node->contents != CONTENTS_SOLID)
 			{
-				pvs = Mod_LeafPVS ( (mleaf_t *)node, sv.worldmodel);
-				for (i = 0; i < fatbytes; i++)
+				// the pvs rows are padded to whole words
+				pvs = (unsigned int *) Mod_LeafPVS ( (mleaf_t *)node, sv.worldmodel);
+				for (i = 0; i < fatwords; i++)
 					fatpvs[i] |= pvs[i];
 			}
 			return;
@@ -80,10 +81,10 @@ given point.
 */
 static byte *SV_FatPVS (vec3_t org)
 {
-	fatbytes = (sv.worldmodel->numleafs+31)>>3;
-	memset (fatpvs, 0, fatbytes);
+	fatwords = (sv.worldmodel->numleafs+31)>>5;
+	memset (fatpvs, 0, fatwords * sizeof(unsigned int));
 	SV_AddToFatPVS (org, sv.worldmodel->nodes);
-	return fatpvs;
+	return (byte *)fatpvs;
 }
 
 //=============================================================================
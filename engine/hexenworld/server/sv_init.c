@@ -301,8 +301,10 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	static char	dummy[8] = { 0,0,0,0,0,0,0,0 };
 	edict_t		*ent;
 	int			i;
+	double		time1, time2, time3, time4, time5, time6;
 
 	Con_DPrintf ("%s: %s\n", __thisfunc__, server);
+	time1 = Sys_DoubleTime ();
 
 	SV_SaveSpawnparms ();
 
@@ -352,8 +354,11 @@ void SV_SpawnServer (const char *server, const char *startspot)
 
 	q_strlcpy (sv.name, server, sizeof(sv.name));
 	q_snprintf (sv.modelname, sizeof(sv.modelname), "maps/%s.bsp", server);
+	time2 = Sys_DoubleTime ();
 	sv.worldmodel = Mod_ForName (sv.modelname, true);
+	time3 = Sys_DoubleTime ();
 	SV_CalcPHS ();
+	time4 = Sys_DoubleTime ();
 
 	//
 	// clear physics interaction links
@@ -427,7 +432,9 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	SV_ProgStartFrame ();
 
 	// load and spawn all other entities
+	time5 = Sys_DoubleTime ();
 	ED_LoadFromFile (sv.worldmodel->entities);
+	time6 = Sys_DoubleTime ();
 
 	// look up some model indexes for specialized message compression
 	SV_FindModelNumbers ();
@@ -456,7 +463,9 @@ void SV_SpawnServer (const char *server, const char *startspot)
 	sv.signon_buffer_size[sv.num_signon_buffers-1] = sv.signon.cursize;
 
 	Info_SetValueForKey (svs.info, "map", sv.name, MAX_SERVERINFO_STRING);
-	Con_DPrintf ("Server spawned.\n");
+	Con_DPrintf ("Server spawned: progs %.1f ms, world %.1f ms, phs %.1f ms, entities %.1f ms, total %.1f ms\n",
+			(time2 - time1) * 1000.0, (time3 - time2) * 1000.0, (time4 - time3) * 1000.0,
+			(time6 - time5) * 1000.0, (Sys_DoubleTime() - time1) * 1000.0);
 
 	svs.changelevel_issued = false;	// now safe to issue another
 }
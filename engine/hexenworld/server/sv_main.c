@@ -142,6 +142,7 @@ void SV_Shutdown (void)
 		sv_logfile = NULL;
 	}
 	NET_Shutdown ();
+	SV_ReplayShutdown ();
 }
 
 
@@ -1055,8 +1056,11 @@ static void SV_ReadPackets (void)
 	int			i;
 	client_t	*cl;
 
-	while (NET_GetPacket ())
+	while (sv_replay == SV_REPLAY_PLAY ? SV_ReplayGetPacket () : NET_GetPacket ())
 	{
+		if (sv_replay == SV_REPLAY_RECORD)
+			SV_ReplayRecordPacket ();
+
 		if (SV_FilterPacket ())
 		{
 			SV_SendBan ();	// tell them we aren't listening...
@@ -1146,9 +1150,13 @@ static void SV_GetConsoleCommands (void)
 
 	while (1)
 	{
-		cmd = Sys_ConsoleInput ();
+		if (sv_replay == SV_REPLAY_PLAY)
+			cmd = SV_ReplayConsoleInput ();
+		else	cmd = Sys_ConsoleInput ();
 		if (!cmd)
 			break;
+		if (sv_replay == SV_REPLAY_RECORD)
+			SV_ReplayRecordConsole (cmd);
 		Cbuf_AddText (cmd);
 	}
 }
@@ -1193,6 +1201,10 @@ SV_Frame
 void SV_Frame (float time)
 {
 	static double	start, end;
+	double		time1 = 0, time2 = 0, time3 = 0;
+
+	if (sv_replay == SV_REPLAY_RECORD)
+		SV_ReplayRecordFrame (time);
 
 	start = Sys_DoubleTime ();
 	svs.stats.idle += start - end;
@@ -1211,7 +1223,11 @@ void SV_Frame (float time)
 	SV_CheckLog ();
 
 // move autonomous things around if enough time has passed
+	if (sv_replay == SV_REPLAY_PLAY)
+		time1 = Sys_DoubleTime ();
 	SV_Physics ();
+	if (sv_replay == SV_REPLAY_PLAY)
+		time2 = Sys_DoubleTime ();
 
 // get packets
 	SV_ReadPackets ();
@@ -1224,9 +1240,19 @@ void SV_Frame (float time)
 
 	SV_CheckVars ();
 
+	if (sv_replay == SV_REPLAY_PLAY)
+		time3 = Sys_DoubleTime ();
+
 // send messages back to the clients that had packets read this frame
 	SV_SendClientMessages ();
 
+	if (sv_replay == SV_REPLAY_PLAY)
+	{
+		SV_ReplayPhase (svphase_physics, time2 - time1);
+		SV_ReplayPhase (svphase_packets, time3 - time2);
+		SV_ReplayPhase (svphase_send, Sys_DoubleTime () - time3);
+	}
+
 // send a heartbeat to the master if needed
 	Master_Heartbeat ();
 
@@ -1602,7 +1628,8 @@ static void SV_InitNet (void)
 		port = atoi(com_argv[p+1]);
 		Con_Printf ("Port: %i\n", port);
 	}
-	NET_Init (port);
+	if (sv_replay != SV_REPLAY_PLAY)	/* a replay doesn't open a socket */
+		NET_Init (port);
 
 	Netchan_Init ();
 
@@ -1641,6 +1668,7 @@ void SV_Init (void)
 
 	COM_Init ();
 	FS_Init ();
+	SV_ReplayInit ();
 
 	PR_Init ();
 	Mod_Init ();
@@ -1660,6 +1688,9 @@ void SV_Init (void)
 
 	Cvar_UnlockAll ();			/* unlock the early-set cvars after init */
 
+	if (sv_replay == SV_REPLAY_PLAY)	/* -replay: run the recording and quit */
+		SV_ReplayRun ();
+
 	Cbuf_InsertText ("exec server.cfg\n");
 	Cbuf_Execute ();
 
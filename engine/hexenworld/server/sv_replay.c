@@ -0,0 +1,459 @@
+/* sv_replay.c -- record the client packets of a live hwsv session
+ * and replay them through the server without sockets for benchmarking.
+ *
+ * hwsv -record <name> writes every packet read by the server and every
+ * console command, together with the frame times of the session, into
+ * <userdir>/<name>.rec.  hwsv -replay <name> restarts the recorded map
+ * with the recorded cvars and random seed and feeds the packets back
+ * to SV_ReadPackets as fast as possible, reporting frames per second
+ * and the time spent in SV_Physics, in reading client packets and in
+ * building the client updates.  Outgoing packets are encoded but not
+ * sent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "quakedef.h"
+#include <time.h>
+
+#define	REPLAY_MAGIC		(('R'<<24)+('S'<<16)+('W'<<8)+'H')	/* "HWSR" */
+#define	REPLAY_VERSION		1
+
+/* event types in the recording */
+#define	RP_FRAME		'f'	/* float time passed to SV_Frame */
+#define	RP_CONSOLE		'c'	/* console command text */
+#define	RP_PACKET		'p'	/* packet returned by NET_GetPacket */
+
+#define	MAX_UDP_PACKET		(MAX_MSGLEN + 9)	/* same as net_udp.c */
+
+typedef struct
+{
+	int		type;
+	netadr_t	from;
+	int		len;
+	int		ofs;		/* into rp_data */
+	qboolean	done;
+} rpevent_t;
+
+int		sv_replay = SV_REPLAY_NONE;
+
+static FILE	*rp_file;
+static char	rp_name[MAX_OSPATH];
+static int	rp_seed;
+static char	rp_map[64];
+static char	*rp_cvars;
+static qboolean	rp_header;
+static byte	rp_message_buffer[MAX_UDP_PACKET];
+
+/* events of the frame being replayed */
+static rpevent_t	*rp_events;
+static int	rp_numevents, rp_maxevents;
+static byte	*rp_data;
+static int	rp_datasize, rp_maxdata;
+static int	rp_nexttype;
+static float	rp_nexttime;
+
+/* replay statistics */
+static int	rp_frames;
+static int	rp_unmatched;
+static double	rp_starttime, rp_frametime, rp_worst;
+static double	rp_phase[SV_REPLAY_NUMPHASES];
+
+
+//=============================================================================
+
+static void RP_WriteLong (int l)
+{
+	l = LittleLong (l);
+	fwrite (&l, 4, 1, rp_file);
+}
+
+static void RP_WriteFloat (float f)
+{
+	f = LittleFloat (f);
+	fwrite (&f, 4, 1, rp_file);
+}
+
+static qboolean RP_ReadLong (int *l)
+{
+	if (fread (l, 4, 1, rp_file) != 1)
+		return false;
+	*l = LittleLong (*l);
+	return true;
+}
+
+static qboolean RP_ReadFloat (float *f)
+{
+	if (fread (f, 4, 1, rp_file) != 1)
+		return false;
+	*f = LittleFloat (*f);
+	return true;
+}
+
+
+/*
+==================
+SV_ReplayInit
+
+Handles -record and -replay.  Called before the network is set up,
+because a replay doesn't open a socket.
+==================
+*/
+void SV_ReplayInit (void)
+{
+	char	text[MAX_OSPATH];
+	int	i, magic, version, len;
+
+	i = COM_CheckParm ("-replay");
+	if (i && i < com_argc-1)
+	{
+		q_strlcpy (text, com_argv[i+1], sizeof(text));
+		COM_AddExtension (text, ".rec", sizeof(text));
+		rp_file = fopen (text, "rb");
+		if (!rp_file)
+		{
+			FS_MakePath_BUF (FS_USERDIR, NULL, rp_name, sizeof(rp_name), text);
+			rp_file = fopen (rp_name, "rb");
+		}
+		else
+		{
+			q_strlcpy (rp_name, text, sizeof(rp_name));
+		}
+		if (!rp_file)
+			Sys_Error ("Couldn't open %s", text);
+
+		if (!RP_ReadLong (&magic) || magic != REPLAY_MAGIC ||
+		    !RP_ReadLong (&version) || version != REPLAY_VERSION)
+			Sys_Error ("%s is not a version %d server recording", rp_name, REPLAY_VERSION);
+		if (!RP_ReadLong (&rp_seed) ||
+		    fread (rp_map, 1, sizeof(rp_map), rp_file) != sizeof(rp_map) ||
+		    !RP_ReadLong (&len) || len < 0)
+			Sys_Error ("%s: truncated header", rp_name);
+		rp_map[sizeof(rp_map)-1] = 0;
+		rp_cvars = (char *) Z_Malloc (len + 1, Z_MAINZONE);
+		if (fread (rp_cvars, 1, len, rp_file) != (size_t)len)
+			Sys_Error ("%s: truncated header", rp_name);
+		rp_cvars[len] = 0;
+
+		rp_nexttype = fgetc (rp_file);
+		if (rp_nexttype == RP_FRAME && !RP_ReadFloat (&rp_nexttime))
+			rp_nexttype = EOF;
+
+	/* NET_Init isn't called, so the message buffer is ours */
+		SZ_Init (&net_message, rp_message_buffer, sizeof(rp_message_buffer));
+
+		sv_replay = SV_REPLAY_PLAY;
+		Sys_Printf ("Replaying %s (map %s)\n", rp_name, rp_map);
+		return;
+	}
+
+	i = COM_CheckParm ("-record");
+	if (i && i < com_argc-1)
+	{
+		FS_MakePath_BUF (FS_USERDIR, NULL, rp_name, sizeof(rp_name), com_argv[i+1]);
+		COM_AddExtension (rp_name, ".rec", sizeof(rp_name));
+		rp_file = fopen (rp_name, "wb");
+		if (!rp_file)
+			Sys_Error ("Couldn't create %s", rp_name);
+
+	/* the replay starts its first map from the same seed */
+		rp_seed = (int) time (NULL);
+		srand (rp_seed);
+
+		sv_replay = SV_REPLAY_RECORD;
+		Sys_Printf ("Recording client traffic to %s\n", rp_name);
+	}
+}
+
+/*
+==================
+SV_ReplayWriteHeader
+
+The header is written lazily with the first recorded frame, so that it
+holds the map and the cvars the command line has set up.
+==================
+*/
+static void SV_ReplayWriteHeader (void)
+{
+	cvar_t	*var;
+	char	map[64];
+	long	start, end;
+
+	RP_WriteLong (REPLAY_MAGIC);
+	RP_WriteLong (REPLAY_VERSION);
+	RP_WriteLong (rp_seed);
+	memset (map, 0, sizeof(map));
+	q_strlcpy (map, sv.name, sizeof(map));
+	fwrite (map, 1, sizeof(map), rp_file);
+
+	start = ftell (rp_file);
+	RP_WriteLong (0);
+	for (var = Cvar_FindVarAfter ("", 0); var; var = var->next)
+	{
+		if (var->flags & CVAR_ROM)
+			continue;
+		fprintf (rp_file, "%s \"%s\"\n", var->name, var->string);
+	}
+	end = ftell (rp_file);
+	fseek (rp_file, start, SEEK_SET);
+	RP_WriteLong ((int)(end - start - 4));
+	fseek (rp_file, end, SEEK_SET);
+
+	rp_header = true;
+}
+
+
+/*
+===============================================================================
+
+RECORDING
+
+===============================================================================
+*/
+
+void SV_ReplayRecordFrame (float time)
+{
+	if (sv.state == ss_dead && !rp_header)
+		return;
+	if (!rp_header)
+		SV_ReplayWriteHeader ();
+	fputc (RP_FRAME, rp_file);
+	RP_WriteFloat (time);
+}
+
+void SV_ReplayRecordConsole (const char *text)
+{
+	int	len;
+
+	if (!rp_header)
+		return;
+	len = (int)strlen(text) + 1;
+	fputc (RP_CONSOLE, rp_file);
+	RP_WriteLong (len);
+	fwrite (text, 1, len, rp_file);
+}
+
+void SV_ReplayRecordPacket (void)
+{
+	if (!rp_header)
+		return;
+	fputc (RP_PACKET, rp_file);
+	fwrite (net_from.ip, 1, 4, rp_file);
+	fwrite (&net_from.port, 2, 1, rp_file);	/* network byte order */
+	RP_WriteLong (net_message.cursize);
+	fwrite (net_message.data, 1, net_message.cursize, rp_file);
+}
+
+
+/*
+===============================================================================
+
+REPLAY
+
+===============================================================================
+*/
+
+/*
+==================
+SV_ReplayReadFrame
+
+Loads the events of the next recorded frame.  Returns false at the
+end of the recording.
+==================
+*/
+static qboolean SV_ReplayReadFrame (float *time)
+{
+	rpevent_t	*ev;
+	int		i;
+
+	for (i = 0; i < rp_numevents; i++)
+	{
+		if (!rp_events[i].done)
+			rp_unmatched++;
+	}
+	rp_numevents = 0;
+	rp_datasize = 0;
+
+	if (rp_nexttype != RP_FRAME)
+		return false;
+	*time = rp_nexttime;
+
+	while (1)
+	{
+		rp_nexttype = fgetc (rp_file);
+		if (rp_nexttype == EOF)
+			break;
+		if (rp_nexttype == RP_FRAME)
+		{
+			if (!RP_ReadFloat (&rp_nexttime))
+				rp_nexttype = EOF;
+			break;
+		}
+
+		if (rp_numevents == rp_maxevents)
+		{
+			rp_maxevents = rp_maxevents ? rp_maxevents * 2 : 64;
+			rp_events = (rpevent_t *) realloc (rp_events, rp_maxevents * sizeof(rpevent_t));
+			if (!rp_events)
+				Sys_Error ("%s: out of memory", __thisfunc__);
+		}
+		ev = &rp_events[rp_numevents];
+		memset (ev, 0, sizeof(*ev));
+		ev->type = rp_nexttype;
+		if (ev->type == RP_PACKET &&
+		    (fread (ev->from.ip, 1, 4, rp_file) != 4 ||
+		     fread (&ev->from.port, 2, 1, rp_file) != 1))
+		{
+			Con_Printf ("%s: truncated recording\n", rp_name);
+			rp_nexttype = EOF;
+			break;
+		}
+		if (!RP_ReadLong (&ev->len) || ev->len < 0 || ev->len > MAX_UDP_PACKET)
+		{
+			Con_Printf ("%s: truncated recording\n", rp_name);
+			rp_nexttype = EOF;
+			break;
+		}
+		if (rp_datasize + ev->len > rp_maxdata)
+		{
+			rp_maxdata = (rp_datasize + ev->len) * 2;
+			rp_data = (byte *) realloc (rp_data, rp_maxdata);
+			if (!rp_data)
+				Sys_Error ("%s: out of memory", __thisfunc__);
+		}
+		ev->ofs = rp_datasize;
+		if (fread (rp_data + rp_datasize, 1, ev->len, rp_file) != (size_t)ev->len)
+		{
+			Con_Printf ("%s: truncated recording\n", rp_name);
+			rp_nexttype = EOF;
+			break;
+		}
+		rp_datasize += ev->len;
+		rp_numevents++;
+	}
+
+	return true;
+}
+
+static rpevent_t *RP_NextEvent (int type)
+{
+	int		i;
+
+	for (i = 0; i < rp_numevents; i++)
+	{
+		if (!rp_events[i].done && rp_events[i].type == type)
+			return &rp_events[i];
+	}
+	return NULL;
+}
+
+const char *SV_ReplayConsoleInput (void)
+{
+	rpevent_t	*ev = RP_NextEvent (RP_CONSOLE);
+
+	if (!ev)
+		return NULL;
+	ev->done = true;
+	return (const char *) rp_data + ev->ofs;
+}
+
+int SV_ReplayGetPacket (void)
+{
+	rpevent_t	*ev = RP_NextEvent (RP_PACKET);
+
+	if (!ev)
+		return 0;
+	ev->done = true;
+	net_from = ev->from;
+	SZ_Clear (&net_message);
+	SZ_Write (&net_message, rp_data + ev->ofs, ev->len);
+	return ev->len;
+}
+
+void SV_ReplayPhase (int phase, double seconds)
+{
+	rp_phase[phase] += seconds;
+}
+
+static void SV_ReplayReport (void)
+{
+	static const char *phasenames[SV_REPLAY_NUMPHASES] =
+	{
+		"physics", "packets", "send"
+	};
+	double	total;
+	int	i;
+
+	total = Sys_DoubleTime () - rp_starttime;
+	if (rp_frames == 0 || total <= 0)
+		return;
+
+	Con_Printf ("%d frames %5.2f seconds %5.1f fps\n", rp_frames, total, rp_frames / total);
+	Con_Printf ("frame avg %.3f ms, worst %.3f ms\n", total * 1000.0 / rp_frames, rp_worst * 1000.0);
+	for (i = 0; i < SV_REPLAY_NUMPHASES; i++)
+	{
+		Con_Printf ("%-8s avg %.3f ms (%4.1f%%)\n", phasenames[i],
+				rp_phase[i] * 1000.0 / rp_frames, rp_phase[i] * 100.0 / total);
+	}
+	if (rp_unmatched)
+		Con_Printf ("warning: %d recorded events did not match the replay\n", rp_unmatched);
+}
+
+/*
+==================
+SV_ReplayRun
+
+Restarts the recorded map and runs every recorded frame, then quits.
+==================
+*/
+FUNC_NORETURN void SV_ReplayRun (void)
+{
+	float	time;
+	double	now;
+
+	Cbuf_AddText (rp_cvars);
+	Cbuf_Execute ();
+
+	srand (rp_seed);
+	Cmd_ExecuteString (va("map %s", rp_map), src_command);
+	if (sv.state == ss_dead)
+		SV_Error ("%s: couldn't spawn %s", __thisfunc__, rp_map);
+
+	rp_starttime = rp_frametime = Sys_DoubleTime ();
+	while (SV_ReplayReadFrame (&time))
+	{
+		SV_Frame (time);
+		rp_frames++;
+
+		now = Sys_DoubleTime ();
+		if (now - rp_frametime > rp_worst)
+			rp_worst = now - rp_frametime;
+		rp_frametime = now;
+	}
+
+	SV_ReplayReport ();
+	Sys_Quit ();
+}
+
+void SV_ReplayShutdown (void)
+{
+	if (rp_file)
+	{
+		fclose (rp_file);
+		rp_file = NULL;
+	}
+	sv_replay = SV_REPLAY_NONE;
+}
@@ -226,6 +226,8 @@ void NET_SendPacket (int length, void *data, const netadr_t *to)
 
 	NetadrToSockadr (to, &addr);
 	HuffEncode((unsigned char *)data, huffbuff, length, &outlen);
+	if (net_socket == INVALID_SOCKET)
+		return;	/* no socket: hwsv -replay benchmark */
 
 	ret = sendto (net_socket, (char *) huffbuff, outlen, 0,
 				(struct sockaddr *)&addr, sizeof(addr) );
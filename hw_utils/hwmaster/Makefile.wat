@@ -24,6 +24,7 @@ USE_WINSOCK2=no
 
 # Names of the binaries
 BINARY=hwmaster.exe
+LOADGEN=hwmload.exe
 
 # Compiler flags
 CFLAGS = -zq -wx -bm -bt=nt -5s -sg -otexan -fp5 -fpi87 -ei -j -zp8
@@ -56,14 +57,18 @@ LIBS = $(LIBWINSOCK) winmm.lib
 
 # Objects
 OBJECTS = qsnprint.obj sizebuf.obj msg_io.obj cmds.obj common.obj net.obj master.obj sys_win.obj
+LOADGEN_OBJS = qsnprint.obj hwmload.obj
 
-all: $(BINARY)
+all: $(BINARY) $(LOADGEN)
 
 $(BINARY): $(OBJECTS)
 	wlink N $@ SYS NT OP q LIBR {$(LIBS)} F {$(OBJECTS)}
 
+$(LOADGEN): $(LOADGEN_OBJS)
+	wlink N $@ SYS NT OP q LIBR {$(LIBS)} F {$(LOADGEN_OBJS)}
+
 INCLUDES+= -I"$(OSLIBS)/windows/misc/include"
 clean: .symbolic
 	rm -f *.obj *.res *.err
 distclean: clean .symbolic
-	rm -f $(BINARY)
+	rm -f $(BINARY) $(LOADGEN)
@@ -4,7 +4,7 @@ UHEXEN2_TOP=../..
 . $UHEXEN2_TOP/scripts/cross_defs.amigaos
 
 if test "$1" = "strip"; then
-	$STRIPPER -S hwmaster
+	$STRIPPER -S hwmaster hwmload
 	exit 0
 fi
 
@@ -6,7 +6,7 @@ UHEXEN2_TOP=../..
 . $UHEXEN2_TOP/scripts/cross_defs.aros
 
 if test "$1" = "strip"; then
-	$STRIPPER -S hwmaster
+	$STRIPPER -S hwmaster hwmload
 	exit 0
 fi
 
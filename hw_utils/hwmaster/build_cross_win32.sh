@@ -4,7 +4,7 @@ UHEXEN2_TOP=../..
 . $UHEXEN2_TOP/scripts/cross_defs.w32
 
 if test "$1" = "strip"; then
-	$STRIPPER hwmaster.exe
+	$STRIPPER hwmaster.exe hwmload.exe
 	exit 0
 fi
 
@@ -0,0 +1,683 @@
+/* hwmload.c - load generator for the hexenworld master server
+ *
+ * Copyright (C) 2006-2011 O. Sezer <sezero@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* hwmload plays a crowd of hexenworld servers and server browsers for a
+ * master server: every simulated server heartbeats from its own udp port
+ * on the loopback address, and every simulated client keeps asking for
+ * the server list and reads back all the packets of the answer.  at the
+ * end it prints how many requests got complete lists, how many of those
+ * listed every server, and how many went unanswered.  */
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "arch_def.h"
+#include "compiler.h"
+#define	COMPILE_TIME_ASSERT(name, x)	\
+	typedef int dummy_ ## name[(x) * 2 - 1]
+#include "net_sys.h"
+#include "qsnprint.h"
+
+#if defined(PLATFORM_WINDOWS)
+#include <mmsystem.h>
+#else
+#include <sys/time.h>
+#endif
+
+/*****************************************************************************/
+
+typedef struct
+{
+	unsigned char	ip[4];
+	unsigned short	port;
+	unsigned short	pad;
+} netadr_t;
+
+#if defined(_MSC_VER)
+#if defined(_WIN64)
+#define ssize_t	SSIZE_T
+#else
+typedef int	ssize_t;
+#endif	/* _WIN64 */
+#endif	/* _MSC_VER */
+
+#if defined(PLATFORM_AMIGA)
+struct Library	*SocketBase;
+#endif
+#if defined(PLATFORM_WINDOWS)
+#include "wsaerror.h"
+static WSADATA	winsockdata;
+#endif
+
+FUNC_NORETURN void Sys_Error (const char *error, ...) FUNC_PRINTF(1,2);
+#ifdef __WATCOMC__
+#pragma aux Sys_Error aborts;
+#endif
+
+/*****************************************************************************/
+
+static void NetadrToSockadr (const netadr_t *a, struct sockaddr_in *s)
+{
+	memset (s, 0, sizeof(*s));
+	s->sin_family = AF_INET;
+
+	memcpy (&s->sin_addr, a->ip, 4);
+	s->sin_port = a->port;
+}
+
+static int NET_StringToAdr (const char *s, netadr_t *a)
+{
+	struct hostent		*h;
+	struct sockaddr_in	sadr;
+	char	*colon;
+	char	copy[128];
+
+	memset (&sadr, 0, sizeof(sadr));
+	sadr.sin_family = AF_INET;
+	sadr.sin_port = 0;
+
+	strncpy (copy, s, sizeof(copy) - 1);
+	copy[sizeof(copy) - 1] = '\0';
+	/* strip off a trailing :port if present */
+	for (colon = copy; *colon; colon++)
+	{
+		if (*colon == ':')
+		{
+			*colon = 0;
+			sadr.sin_port = htons((short)atoi(colon+1));
+		}
+	}
+
+	if (copy[0] >= '0' && copy[0] <= '9')
+	{
+		sadr.sin_addr.s_addr = inet_addr(copy);
+	}
+	else
+	{
+		h = gethostbyname (copy);
+		if (!h)
+			return 0;
+		sadr.sin_addr.s_addr = *(in_addr_t *)h->h_addr_list[0];
+	}
+
+	memcpy (a->ip, &sadr.sin_addr, 4);
+	a->port = sadr.sin_port;
+
+	return 1;
+}
+
+static void NET_Init (void)
+{
+#if defined(PLATFORM_WINDOWS)
+	int err = WSAStartup(MAKEWORD(1,1), &winsockdata);
+	if (err != 0)
+		Sys_Error ("Winsock initialization failed (%s)", socketerror(err));
+#endif	/* PLATFORM_WINDOWS */
+#if defined(PLATFORM_OS2) && !defined(__EMX__)
+	if (sock_init() < 0)
+		Sys_Error ("Can't initialize IBM OS/2 sockets");
+#endif	/* OS/2 */
+#ifdef PLATFORM_AMIGA
+	SocketBase = OpenLibrary("bsdsocket.library", 0);
+	if (!SocketBase)
+		Sys_Error ("Can't open bsdsocket.library.");
+#endif	/* PLATFORM_AMIGA */
+}
+
+static void NET_Shutdown (void)
+{
+#if defined(PLATFORM_WINDOWS)
+	WSACleanup ();
+#endif
+#ifdef PLATFORM_AMIGA
+	if (SocketBase)
+	{
+		CloseLibrary(SocketBase);
+		SocketBase = NULL;
+	}
+#endif
+}
+
+/*****************************************************************************/
+
+void Sys_Error (const char *error, ...)
+{
+	va_list		argptr;
+	char		text[1024];
+
+	va_start (argptr,error);
+	q_vsnprintf (text, sizeof (text), error,argptr);
+	va_end (argptr);
+
+	NET_Shutdown ();
+
+	printf ("\nERROR: %s\n\n", text);
+
+	exit (1);
+}
+
+static double Sys_DoubleTime (void)
+{
+#if defined(PLATFORM_WINDOWS)
+	return timeGetTime () / 1000.0;
+#else
+	struct timeval	tp;
+
+	gettimeofday (&tp, NULL);
+	return tp.tv_sec + tp.tv_usec / 1e6;
+#endif
+}
+
+/*****************************************************************************/
+
+#define	VER_HWMLOAD_MAJ		0
+#define	VER_HWMLOAD_MID		1
+#define	VER_HWMLOAD_MIN		1
+
+#define	PORT_MASTER		26900
+
+#define	S2C_CHALLENGE		'c'
+#define	M2C_SERVERLST		'd'
+#define	S2M_HEARTBEAT		'a'
+#define	S2M_SHUTDOWN		'C'
+
+#define	MAX_PACKET		2048
+
+/* the master fills every list packet but the last one */
+#define	LIST_HEADERSIZE		7
+#define	LIST_ENTRYSIZE		6
+#define	LIST_PERPACKET		((1450 - LIST_HEADERSIZE) / LIST_ENTRYSIZE)
+
+#define	MAX_LOADCLIENTS		256	/* they all go in one fd_set */
+#define	QUERY_TIMEOUT		2.0
+
+static const unsigned char query_msg[] =
+		{ 255, S2C_CHALLENGE, '\0' };
+
+static const unsigned char reply_hdr[] =
+		{ 255, 255, 255, 255,
+		  255, M2C_SERVERLST, '\n' };
+
+typedef struct
+{
+	double	next;		/* when to send the next heartbeat */
+	int	sequence;
+} loadserver_t;
+
+typedef struct
+{
+	sys_socket_t	socket;
+	double	next;		/* when to send the next list request */
+	double	sent;		/* when the pending one went out, 0 if none */
+	int	packets, entries;
+} loadclient_t;
+
+static netadr_t		master_adr, bind_adr;
+static netadr_t		client_adr;	/* address of the first client */
+static int	shared_clientadr;	/* clients all query from bind_adr */
+static loadserver_t	*servers;
+static loadclient_t	*clients;
+static int	num_servers = 2000;
+static int	num_clients = 16;
+static int	first_port = 20000;	/* below the usual ephemeral ports */
+static double	run_time = 30;
+static double	heartbeat_time = 10;
+static double	query_time = 2;
+static double	warmup_end;
+
+static int	heartbeats, bind_failures;
+static int	queries, complete_lists, full_lists, unanswered, incomplete;
+static int	list_packets, list_entries, bad_packets;
+static double	total_latency, max_latency;
+
+
+static void SetNonBlocking (sys_socket_t s)
+{
+#if defined(PLATFORM_WINDOWS) || defined(PLATFORM_DOS)
+	u_long	_true = 1;
+#else
+	int	_true = 1;
+#endif
+	int	err;
+
+	if (ioctlsocket (s, FIONBIO, IOCTLARG_P(&_true)) == SOCKET_ERROR)
+	{
+		err = SOCKETERRNO;
+		Sys_Error ("ioctl FIONBIO: %s", socketerror(err));
+	}
+}
+
+/* the master tells servers apart by address and port, so each simulated
+ * server sends from its own port.  a socket is opened for each packet
+ * instead of being kept around so that thousands of servers don't need
+ * thousands of descriptors.  */
+static void SendFromPort (int port, const void *data, int length)
+{
+	struct sockaddr_in	address;
+	sys_socket_t	s;
+	int	_true = 1;
+
+	s = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == INVALID_SOCKET)
+	{
+		int err = SOCKETERRNO;
+		Sys_Error ("Couldn't open socket: %s", socketerror(err));
+	}
+	setsockopt (s, SOL_SOCKET, SO_REUSEADDR, (char *)&_true, sizeof(_true));
+
+	NetadrToSockadr (&bind_adr, &address);
+	address.sin_port = htons((unsigned short)port);
+	if (bind (s, (struct sockaddr *)&address, sizeof(address)) == SOCKET_ERROR)
+	{
+		bind_failures++;
+		closesocket (s);
+		return;
+	}
+
+	NetadrToSockadr (&master_adr, &address);
+	sendto (s, (const char *)data, length, 0,
+			(struct sockaddr *)&address, sizeof(address));
+	closesocket (s);
+}
+
+static void Server_Heartbeat (int i)
+{
+	char	text[64];
+	int	length;
+
+	/* the leading 255 is the uncompressed marker of the game's
+	 * huffman layer.  */
+	servers[i].sequence++;
+	length = q_snprintf (text, sizeof(text), "%c%c\n%i\n%i\n", 255,
+				S2M_HEARTBEAT, servers[i].sequence, i & 7);
+	SendFromPort (first_port + i, text, length);
+	heartbeats++;
+}
+
+static void Server_Shutdown (int i)
+{
+	static const unsigned char text[] =
+			{ 255, S2M_SHUTDOWN, '\n', '\0', '\0' };
+
+	SendFromPort (first_port + i, text, sizeof(text));
+}
+
+static void Client_FinishQuery (loadclient_t *cl, double now, int complete)
+{
+	double	latency;
+
+	if (complete)
+	{
+		latency = now - cl->sent;
+		total_latency += latency;
+		if (latency > max_latency)
+			max_latency = latency;
+		complete_lists++;
+		/* servers can come and go while the master is still
+		 * seeing the first round of heartbeats */
+		if (cl->sent >= warmup_end && cl->entries == num_servers)
+			full_lists++;
+	}
+	else if (cl->packets)
+	{
+		incomplete++;
+	}
+	else
+	{
+		unanswered++;
+	}
+
+	cl->sent = 0;
+}
+
+static void Client_Query (loadclient_t *cl, double now)
+{
+	struct sockaddr_in	address;
+
+	if (cl->sent)
+		Client_FinishQuery (cl, now, 0);
+
+	NetadrToSockadr (&master_adr, &address);
+	sendto (cl->socket, (const char *)query_msg, sizeof(query_msg), 0,
+			(struct sockaddr *)&address, sizeof(address));
+	cl->sent = now;
+	cl->packets = 0;
+	cl->entries = 0;
+	queries++;
+}
+
+static void Client_Read (loadclient_t *cl, double now)
+{
+	static unsigned char	response[MAX_PACKET];
+	struct sockaddr_in	address;
+	socklen_t	fromlen;
+	ssize_t		size;
+	int		count;
+
+	while (1)
+	{
+		fromlen = sizeof(address);
+		size = recvfrom (cl->socket, (char *)response, sizeof(response), 0,
+				(struct sockaddr *)&address, &fromlen);
+		if (size == SOCKET_ERROR)
+			return;
+
+		if (size < LIST_HEADERSIZE || memcmp(response, reply_hdr, LIST_HEADERSIZE) != 0 ||
+		    (size - LIST_HEADERSIZE) % LIST_ENTRYSIZE != 0)
+		{
+			bad_packets++;
+			continue;
+		}
+		list_packets++;
+		if (!cl->sent)
+			continue;	/* late answer to a timed out request */
+
+		count = (size - LIST_HEADERSIZE) / LIST_ENTRYSIZE;
+		list_entries += count;
+		cl->packets++;
+		cl->entries += count;
+		if (count < LIST_PERPACKET)
+			Client_FinishQuery (cl, now, 1);
+	}
+}
+
+static void RunLoad (void)
+{
+	struct timeval	timeout;
+	fd_set		readfds;
+	sys_socket_t	maxfd;
+	double	start, now, wait;
+	int	i, cursor;
+
+	start = Sys_DoubleTime ();
+
+	/* the first round of heartbeats is spread over a second, and
+	 * the later ones keep the same order.  */
+	for (i = 0; i < num_servers; i++)
+		servers[i].next = start + (double)i / num_servers;
+	warmup_end = start + 1.0 + 0.25;
+	for (i = 0; i < num_clients; i++)
+		clients[i].next = start + query_time * i / num_clients;
+
+	cursor = 0;
+	while (1)
+	{
+		now = Sys_DoubleTime ();
+		if (now - start >= run_time)
+			break;
+
+		while (servers[cursor].next <= now)
+		{
+			Server_Heartbeat (cursor);
+			servers[cursor].next += heartbeat_time;
+			cursor = (cursor + 1) % num_servers;
+		}
+
+		for (i = 0; i < num_clients; i++)
+		{
+			if (clients[i].sent && now - clients[i].sent > QUERY_TIMEOUT)
+				Client_FinishQuery (&clients[i], now, 0);
+			if (clients[i].next <= now)
+			{
+				Client_Query (&clients[i], now);
+				clients[i].next += query_time;
+			}
+		}
+
+		wait = servers[cursor].next - now;
+		if (wait > 0.01)
+			wait = 0.01;
+		if (wait < 0)
+			wait = 0;
+		timeout.tv_sec = 0;
+		timeout.tv_usec = (long)(wait * 1000000);
+
+		FD_ZERO (&readfds);
+		maxfd = 0;
+		for (i = 0; i < num_clients; i++)
+		{
+			FD_SET (clients[i].socket, &readfds);
+			if (clients[i].socket > maxfd)
+				maxfd = clients[i].socket;
+		}
+		if (selectsocket (maxfd + 1, &readfds, NULL, NULL, &timeout) <= 0)
+			continue;
+
+		now = Sys_DoubleTime ();
+		for (i = 0; i < num_clients; i++)
+		{
+			if (FD_ISSET (clients[i].socket, &readfds))
+				Client_Read (&clients[i], now);
+		}
+	}
+
+	/* give the last answers a moment, then count what is left */
+	now = Sys_DoubleTime ();
+	wait = now + QUERY_TIMEOUT;
+	while (now < wait)
+	{
+		for (i = 0; i < num_clients; i++)
+		{
+			if (clients[i].sent)
+				Client_Read (&clients[i], now);
+		}
+		for (i = 0; i < num_clients; i++)
+		{
+			if (clients[i].sent)
+				break;
+		}
+		if (i == num_clients)
+			break;
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 10000;
+		selectsocket (0, NULL, NULL, NULL, &timeout);
+		now = Sys_DoubleTime ();
+	}
+	for (i = 0; i < num_clients; i++)
+	{
+		if (clients[i].sent)
+			Client_FinishQuery (&clients[i], now, 0);
+	}
+
+}
+
+/* the master limits the list requests of each address, so the clients
+ * query from consecutive addresses, 127.0.0.2 and up by default: all of
+ * 127/8 is loopback on linux and windows.  */
+static int BindClient (sys_socket_t s, int n)
+{
+	struct sockaddr_in	address;
+	netadr_t	adr;
+	unsigned long	ip;
+
+	adr = client_adr;
+	if (!shared_clientadr)
+	{
+		ip = ((unsigned long)adr.ip[0] << 24) | (adr.ip[1] << 16) | (adr.ip[2] << 8) | adr.ip[3];
+		ip += n;
+		adr.ip[0] = (ip >> 24) & 0xff;
+		adr.ip[1] = (ip >> 16) & 0xff;
+		adr.ip[2] = (ip >> 8) & 0xff;
+		adr.ip[3] = ip & 0xff;
+	}
+	NetadrToSockadr (&adr, &address);
+	return bind (s, (struct sockaddr *)&address, sizeof(address));
+}
+
+static void PrintUsage (const char *name)
+{
+	printf ("Usage: %s [options] [<address>[:port]]\n", name);
+	printf ("Simulates heartbeating servers and querying clients against a\n"
+		"master server, by default the one at 127.0.0.1:%d.\n\n", PORT_MASTER);
+	printf ("  -servers <n>     number of servers (default %d)\n", num_servers);
+	printf ("  -clients <n>     number of clients, at most %d (default %d)\n", MAX_LOADCLIENTS, num_clients);
+	printf ("  -time <s>        seconds to run (default %g)\n", run_time);
+	printf ("  -heartbeat <s>   seconds between the heartbeats of a server (default %g)\n", heartbeat_time);
+	printf ("  -query <s>       seconds between the list requests of a client (default %g)\n", query_time);
+	printf ("  -port <n>        first udp port of the servers (default %d)\n", first_port);
+	printf ("  -bind <address>  local address of the servers (default 127.0.0.1)\n");
+	printf ("  -clientbind <address>\n"
+		"                   local address of the first client, the others use\n"
+		"                   the following ones (default 127.0.0.2)\n");
+	printf ("  -sameaddress     run all the clients from the -bind address\n");
+	printf ("  -noshutdown      leave the servers registered at the end\n");
+}
+
+int main (int argc, char **argv)
+{
+	const char	*master = "127.0.0.1";
+	const char	*bindaddr = "127.0.0.1";
+	const char	*clientaddr = "127.0.0.2";
+	int		i, err;
+	int		shutdown = 1;
+
+	printf ("HWMASTER LOAD %d.%d.%d\n", VER_HWMLOAD_MAJ, VER_HWMLOAD_MID, VER_HWMLOAD_MIN);
+
+/* parse the command line */
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-servers") && i < argc - 1)
+			num_servers = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-clients") && i < argc - 1)
+			num_clients = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-time") && i < argc - 1)
+			run_time = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-heartbeat") && i < argc - 1)
+			heartbeat_time = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-query") && i < argc - 1)
+			query_time = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-port") && i < argc - 1)
+			first_port = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-bind") && i < argc - 1)
+			bindaddr = argv[++i];
+		else if (!strcmp(argv[i], "-clientbind") && i < argc - 1)
+			clientaddr = argv[++i];
+		else if (!strcmp(argv[i], "-sameaddress"))
+			shared_clientadr = 1;
+		else if (!strcmp(argv[i], "-noshutdown"))
+			shutdown = 0;
+		else if (argv[i][0] != '-')
+			master = argv[i];
+		else
+		{
+			PrintUsage (argv[0]);
+			exit (1);
+		}
+	}
+	if (num_servers < 1 || first_port < 1 || first_port + num_servers > 65536)
+		Sys_Error ("The servers don't fit in the ports from %d", first_port);
+	if (num_clients < 0 || num_clients > MAX_LOADCLIENTS)
+		Sys_Error ("Can run 0 to %d clients", MAX_LOADCLIENTS);
+	if (heartbeat_time <= 0 || query_time <= 0)
+		Sys_Error ("Invalid heartbeat or query time");
+
+/* init OS-specific network stuff */
+	NET_Init ();
+
+	if (!NET_StringToAdr(master, &master_adr))
+		Sys_Error ("Unable to resolve address %s", master);
+	if (master_adr.port == 0)
+		master_adr.port = htons(PORT_MASTER);
+	if (!NET_StringToAdr(bindaddr, &bind_adr))
+		Sys_Error ("Unable to resolve address %s", bindaddr);
+	if (shared_clientadr)
+		client_adr = bind_adr;
+	else if (!NET_StringToAdr(clientaddr, &client_adr))
+		Sys_Error ("Unable to resolve address %s", clientaddr);
+	client_adr.port = 0;
+
+	servers = (loadserver_t *) calloc (num_servers, sizeof(loadserver_t));
+	clients = (loadclient_t *) calloc (num_clients + 1, sizeof(loadclient_t));
+	if (!servers || !clients)
+		Sys_Error ("Out of memory");
+
+	for (i = 0; i < num_clients; i++)
+	{
+		clients[i].socket = socket (PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (clients[i].socket == INVALID_SOCKET)
+		{
+			err = SOCKETERRNO;
+			Sys_Error ("Couldn't open socket: %s", socketerror(err));
+		}
+		if (BindClient (clients[i].socket, i) == SOCKET_ERROR)
+		{
+			err = SOCKETERRNO;
+			if (!shared_clientadr)	/* e.g. only 127.0.0.1 is loopback here */
+				Sys_Error ("Couldn't bind client %d: %s\n"
+					"Try -clientbind or -sameaddress", i, socketerror(err));
+			Sys_Error ("Couldn't bind socket: %s", socketerror(err));
+		}
+		SetNonBlocking (clients[i].socket);
+	}
+
+	printf ("%d servers from ports %d-%d and %d clients against %d.%d.%d.%d:%d for %g seconds\n",
+		num_servers, first_port, first_port + num_servers - 1, num_clients,
+		master_adr.ip[0], master_adr.ip[1], master_adr.ip[2], master_adr.ip[3],
+		ntohs(master_adr.port), run_time);
+
+	RunLoad ();
+
+	if (shutdown)
+	{
+		for (i = 0; i < num_servers; i++)
+		{
+			Server_Shutdown (i);
+			if ((i & 63) == 63)
+			{	/* don't overrun the master's socket buffer */
+				struct timeval	pause;
+				pause.tv_sec = 0;
+				pause.tv_usec = 10000;
+				selectsocket (0, NULL, NULL, NULL, &pause);
+			}
+		}
+	}
+
+	for (i = 0; i < num_clients; i++)
+		closesocket (clients[i].socket);
+	NET_Shutdown ();
+
+	printf ("\n%d heartbeats in %.1f seconds (%.0f per second)", heartbeats,
+			run_time, heartbeats / run_time);
+	if (bind_failures)
+		printf (", %d not sent: port in use", bind_failures);
+	printf ("\n%d list requests: %d complete lists, %d with all %d servers\n",
+			queries, complete_lists, full_lists, num_servers);
+	printf ("%d unanswered, %d incomplete\n", unanswered, incomplete);
+	if (unanswered && shared_clientadr && num_clients > 1)
+	{
+		printf ("(the clients share one address: unless the master runs with\n"
+			" -querylimit 0, its per-address limit drops most requests)\n");
+	}
+	printf ("%d list packets with %d entries", list_packets, list_entries);
+	if (bad_packets)
+		printf (", %d bad packets", bad_packets);
+	printf ("\n");
+	if (complete_lists)
+	{
+		printf ("list latency: %.2f ms average, %.2f ms max\n",
+			total_latency * 1000 / complete_lists, max_latency * 1000);
+	}
+
+	return 0;
+}
+
@@ -299,14 +299,68 @@ typedef struct server_s
 	netadr_t	ip;
 	struct	server_s *next;
 	struct	server_s *previous;
+	struct	server_s *hashnext;	/* chain in sv_hash */
 	double	timeout;
 } server_t;
 
 server_t *sv_list = NULL;
 
+/* servers are also kept in a hash table keyed by ip and port, so that
+ * a heartbeat doesn't have to walk the whole list to find its server.
+ * the table doubles whenever it holds twice as many servers as it has
+ * buckets.  */
+#define	SV_MINHASH	256
+
+static server_t	**sv_hash = NULL;
+static int	sv_hashsize = 0;	/* always a power of two */
+static int	sv_count = 0;
+
+
+static unsigned int SVL_HashAdr (const netadr_t *adr)
+{
+	unsigned int	h;
+
+	h = ((unsigned int)adr->ip[0] << 24) | ((unsigned int)adr->ip[1] << 16) |
+	    ((unsigned int)adr->ip[2] <<  8) |  (unsigned int)adr->ip[3];
+	h = (h ^ adr->port) * 2654435761U;
+	return h ^ (h >> 16);
+}
+
+static void SVL_Rehash (int newsize)
+{
+	server_t	*sv;
+	int		i;
+
+	free (sv_hash);
+	sv_hash = (server_t **)calloc(newsize, sizeof(server_t *));
+	if (!sv_hash)
+		Sys_Error ("%s: failed on allocation of %d buckets", __thisfunc__, newsize);
+	sv_hashsize = newsize;
+
+	for (sv = sv_list ; sv ; sv = sv->next)
+	{
+		i = SVL_HashAdr(&sv->ip) & (sv_hashsize - 1);
+		sv->hashnext = sv_hash[i];
+		sv_hash[i] = sv;
+	}
+}
 
 static void SVL_Remove (server_t *sv)
 {
+	server_t	**link;
+
+	link = &sv_hash[SVL_HashAdr(&sv->ip) & (sv_hashsize - 1)];
+	for ( ; *link ; link = &(*link)->hashnext)
+	{
+		if (*link == sv)
+		{
+			*link = sv->hashnext;
+			sv_count--;
+			break;
+		}
+	}
+	sv->hashnext = NULL;
+
 	if (sv_list == sv)
 		sv_list = sv->next;
 
@@ -351,18 +405,29 @@ static server_t *SVL_New (const netadr_t *adr)
 
 static void SVL_Add (server_t *sv)
 {
+	int	i;
+
 	sv->next = sv_list;
 	sv->previous = NULL;
 	if (sv_list)
 		sv_list->previous = sv;
 	sv_list = sv;
+
+	if (++sv_count > sv_hashsize * 2)
+	{
+		SVL_Rehash (sv_hashsize * 2);
+		return;	/* already linked in by the rehash */
+	}
+	i = SVL_HashAdr(&sv->ip) & (sv_hashsize - 1);
+	sv->hashnext = sv_hash[i];
+	sv_hash[i] = sv;
 }
 
 static server_t *SVL_Find (const netadr_t *adr)
 {
 	server_t *sv;
 
-	for (sv = sv_list ; sv ; sv = sv->next)
+	for (sv = sv_hash[SVL_HashAdr(adr) & (sv_hashsize - 1)] ; sv ; sv = sv->hashnext)
 	{
 		if (NET_CompareAdr(&sv->ip, adr))
 			return sv;
@@ -380,6 +445,100 @@ static void SVL_ServerList_f (void)
 }
 
 
+/*
+==============================================================================
+
+QUERY RATE LIMITING
+
+==============================================================================
+*/
+
+/* a list request is answered with a packet per couple hundred servers, so
+ * they are rationed per ip address with a token bucket: an address may send
+ * ql_burst requests at once and then gets ql_rate more per second.  */
+#define	QL_HASHSIZE	1024	/* power of two */
+
+typedef struct querylimit_s
+{
+	byte	ip[4];
+	double	tokens;
+	double	time;	/* when the tokens were last counted */
+	struct querylimit_s *next;
+} querylimit_t;
+
+static querylimit_t	*ql_hash[QL_HASHSIZE];
+static double	ql_burst = 5;
+static double	ql_rate = 1;	/* requests per second, 0 to disable */
+
+static int	ql_answered, ql_dropped;
+
+
+static qboolean QL_Allow (const netadr_t *adr)
+{
+	querylimit_t	*ql;
+	double		t;
+	unsigned int	h;
+
+	if (ql_rate <= 0)
+		return true;
+
+	h = adr->ip[0] | (adr->ip[1] << 8) | (adr->ip[2] << 16) | ((unsigned int)adr->ip[3] << 24);
+	h = (h * 2654435761U) >> 16;
+	h &= QL_HASHSIZE - 1;
+
+	t = Sys_DoubleTime();
+	for (ql = ql_hash[h] ; ql ; ql = ql->next)
+	{
+		if (!memcmp(ql->ip, adr->ip, 4))
+			break;
+	}
+	if (!ql)
+	{
+		ql = (querylimit_t *)malloc(sizeof(querylimit_t));
+		if (!ql)
+			return false;	/* can't keep count, so don't answer */
+		memcpy(ql->ip, adr->ip, 4);
+		ql->tokens = ql_burst;
+		ql->time = t;
+		ql->next = ql_hash[h];
+		ql_hash[h] = ql;
+	}
+
+	ql->tokens += (t - ql->time) * ql_rate;
+	if (ql->tokens > ql_burst)
+		ql->tokens = ql_burst;
+	ql->time = t;
+
+	if (ql->tokens < 1)
+		return false;
+	ql->tokens -= 1;
+	return true;
+}
+
+static void QL_TimeOut (double t)
+{
+	querylimit_t	*ql, **link;
+	int		i;
+
+	/* an address whose bucket filled up again is the same as a new one */
+	for (i = 0 ; i < QL_HASHSIZE ; i++)
+	{
+		for (link = &ql_hash[i] ; (ql = *link) != NULL ; )
+		{
+			if (ql->tokens + (t - ql->time) * ql_rate >= ql_burst)
+			{
+				*link = ql->next;
+				free(ql);
+			}
+			else
+			{
+				link = &ql->next;
+			}
+		}
+	}
+}
+
+
 /*
 ==============================================================================
 
@@ -413,22 +572,38 @@ static void SV_AnalysePacket (void)
 	}
 }
 
+/* a server list that doesn't fit in one datagram goes out as several
+ * packets, each one a complete M2C_SERVERLST message on its own, so a
+ * client that reads a single packet still gets a valid, if partial,
+ * list.  every packet but the last one is full, and the last one is
+ * short: when the list fills its packets exactly, an empty list packet
+ * follows to end the sequence.  */
+#define	LIST_HEADERSIZE		7
+#define	LIST_ENTRYSIZE		6	/* 4 bytes of ip, 2 of port */
+#define	LIST_PERPACKET		((MAX_DATAGRAM - LIST_HEADERSIZE) / LIST_ENTRYSIZE)
+
+static void Mst_BeginList (sizebuf_t *msg)
+{
+	SZ_Clear (msg);
+	MSG_WriteByte(msg,255);
+	MSG_WriteByte(msg,255);
+	MSG_WriteByte(msg,255);
+	MSG_WriteByte(msg,255);
+	MSG_WriteByte(msg,255);
+	MSG_WriteByte(msg,M2C_SERVERLST);
+	MSG_WriteByte(msg,'\n');
+}
+
 static void Mst_SendList (void)
 {
 	byte		buf[MAX_DATAGRAM];
 	sizebuf_t	msg;
 	server_t	*sv;
+	int		count;
 
 	SZ_Init (&msg, buf, sizeof(buf));
-	msg.allowoverflow = true;
-
-	MSG_WriteByte(&msg,255);
-	MSG_WriteByte(&msg,255);
-	MSG_WriteByte(&msg,255);
-	MSG_WriteByte(&msg,255);
-	MSG_WriteByte(&msg,255);
-	MSG_WriteByte(&msg,M2C_SERVERLST);
-	MSG_WriteByte(&msg,'\n');
+	Mst_BeginList (&msg);
+	count = 0;
 
 	for (sv = sv_list ; sv ; sv = sv->next)
 	{
@@ -437,11 +612,45 @@ static void Mst_SendList (void)
 		MSG_WriteByte(&msg,sv->ip.ip[2]);
 		MSG_WriteByte(&msg,sv->ip.ip[3]);
 		MSG_WriteShort(&msg,sv->ip.port);
+
+		if (++count == LIST_PERPACKET)
+		{
+			NET_SendPacket(msg.cursize,msg.data,&net_from);
+			Mst_BeginList (&msg);
+			count = 0;
+		}
 	}
 
 	NET_SendPacket(msg.cursize,msg.data,&net_from);
 }
 
+
+static void Mst_ListRequest (const char *what)
+{
+	printf("%s >> ", NET_AdrToString(&net_from));
+
+	if (!QL_Allow(&net_from))
+	{
+		printf("%s server list request dropped\n", what);
+		ql_dropped++;
+		return;
+	}
+
+	printf("%s server list request\n", what);
+	ql_answered++;
+	Mst_SendList();
+}
+
+static void Mst_Stats_f (void)
+{
+	printf("%d servers in %d hash buckets\n", sv_count, sv_hashsize);
+	printf("%d list requests answered, %d dropped\n", ql_answered, ql_dropped);
+	if (ql_rate > 0)
+		printf("list request limit: %g at once, %g per second\n\n", ql_burst, ql_rate);
+	else
+		printf("list requests are not limited\n\n");
+}
+
 static void Mst_Packet (void)
 {
 	char		msg;
@@ -484,9 +693,7 @@ static void Mst_Packet (void)
 		break;
 
 	case S2C_CHALLENGE:
-		printf("%s >> ", NET_AdrToString(&net_from));
-		printf("Gamespy server list request\n");
-		Mst_SendList();
+		Mst_ListRequest("Gamespy");
 		break;
 
 	default:
@@ -496,9 +703,7 @@ static void Mst_Packet (void)
 
 			if (p[0] == 0 && p[1] == 'y')
 			{
-				printf("%s >> ", NET_AdrToString(&net_from));
-				printf("Pingtool server list request\n");
-				Mst_SendList();
+				Mst_ListRequest("Pingtool");
 			}
 			else
 			{
@@ -542,10 +747,19 @@ static void SV_GetConsoleCommands (void)
 
 static void SV_TimeOut(void)
 {
+	static double	last_check = 0;
 	double t = Sys_DoubleTime();
 	server_t *sv;
 	server_t *next;
 
+	/* the timeouts are in the minutes, no need to walk the lists
+	 * on every frame.  */
+	if (t - last_check < 1)
+		return;
+	last_check = t;
+
+	QL_TimeOut(t);
+
 	if (sv_list == NULL)
 		return;
 
@@ -620,6 +834,18 @@ void SV_InitNet (void)
 	}
 	NET_Init (port);
 
+	p = COM_CheckParm ("-querylimit");
+	if (p && p < com_argc-1)
+	{
+		ql_burst = atof(com_argv[p+1]);
+		if (p < com_argc-2 && com_argv[p+2][0] != '-')
+			ql_rate = atof(com_argv[p+2]);
+		if (ql_burst < 1)
+			ql_rate = 0;
+	}
+
+	SVL_Rehash (SV_MINHASH);
+
 	/* Add filters */
 	if ( (filters = fopen(filters_file,"rt")) )
 	{
@@ -636,6 +862,7 @@ void SV_InitNet (void)
 	Cmd_AddCommand("clear", SVL_Clear);
 	Cmd_AddCommand("list", SVL_ServerList_f);
 	Cmd_AddCommand("filter", FL_Filter_f);
+	Cmd_AddCommand("stats", Mst_Stats_f);
 	Cmd_AddCommand("quit", SV_Quit_f);
 }
 
@@ -213,7 +213,7 @@ int main (int argc, char **argv)
 			     !(strcmp(argv[t], "--help")) || !(strcmp(argv[t], "-?")) )
 			{
 				printf("HexenWorld master server %s\n\n", VER_HWMASTER_STR);
-				printf("Usage:     hwmaster [-port xxxxx]\n");
+				printf("Usage:     hwmaster [-port xxxxx] [-querylimit burst [rate]]\n");
 				printf("See the documentation for details\n\n");
 				exit(0);
 			}
@@ -55,7 +55,7 @@ LIBS = $(LIBWINSOCK) winmm.lib
 	wcc386 $(INCLUDES) $(CFLAGS) $(CPPFLAGS) -fo=$^@ $<
 
 # Objects
-OBJECTS = qsnprint.obj hwmquery.obj
+OBJECTS = qsnprint.obj huffman.obj hwmquery.obj
 
 all: $(HWMQUERY)
 
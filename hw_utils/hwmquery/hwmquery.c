@@ -29,6 +29,13 @@
 	typedef int dummy_ ## name[(x) * 2 - 1]
 #include "net_sys.h"
 #include "qsnprint.h"
+#include "huffman.h"
+
+#if defined(PLATFORM_WINDOWS)
+#include <mmsystem.h>
+#else
+#include <sys/time.h>
+#endif
 
 /*****************************************************************************/
 
@@ -207,19 +214,40 @@ void Sys_Error (const char *error, ...)
 	exit (1);
 }
 
+static double Sys_DoubleTime (void)
+{
+#if defined(PLATFORM_WINDOWS)
+	return timeGetTime () / 1000.0;
+#else
+	struct timeval	tp;
+
+	gettimeofday (&tp, NULL);
+	return tp.tv_sec + tp.tv_usec / 1e6;
+#endif
+}
+
 /*****************************************************************************/
 
 #define	VER_HWMQUERY_MAJ	0
-#define	VER_HWMQUERY_MID	2
-#define	VER_HWMQUERY_MIN	3
+#define	VER_HWMQUERY_MID	3
+#define	VER_HWMQUERY_MIN	0
 
 #define	PORT_MASTER		26900
 #define	PORT_SERVER		26950
 
 #define	S2C_CHALLENGE		'c'
 #define	M2C_SERVERLST		'd'
+#define	A2A_ACK			'l'
+#define	A2C_PRINT		'n'
+
+#define	MAX_PACKET		8192	/* a status reply can be around 5k */
+#define	SEND_BATCH		32	/* requests between two reads in a scan */
 
-#define	MAX_PACKET		2048
+/* a long server list comes in several packets, all of them full
+ * but the last one.  */
+#define	LIST_HEADERSIZE		7
+#define	LIST_ENTRYSIZE		6
+#define	LIST_PERPACKET		((1450 - LIST_HEADERSIZE) / LIST_ENTRYSIZE)
 
 static const unsigned char query_msg[] =
 		{ 255, S2C_CHALLENGE, '\0' };
@@ -228,40 +256,483 @@ static const unsigned char reply_hdr[] =
 		{ 255, 255, 255, 255,
 		  255, M2C_SERVERLST, '\n' };
 
+/* the servers run every packet through their huffman decoder: we need
+ * not use HuffEncode, a leading 0xff tells it that the rest is plain.  */
+static const char ping_msg[] = "\377\377\377\377\377ping";
+static const char status_msg[] = "\377\377\377\377\377status";
+
 static unsigned char	response[MAX_PACKET];
+static unsigned char	decoded[MAX_PACKET];
 
-int main (int argc, char **argv)
+typedef struct
+{
+	netadr_t	adr;
+	double	sent;		/* when the last request went out */
+	int	attempts;
+	int	done;
+} target_t;
+
+static target_t	*targets;
+static int	num_targets, max_targets;
+
+static void AddTarget (const netadr_t *adr)
 {
+	if (num_targets == max_targets)
+	{
+		max_targets = max_targets ? max_targets * 2 : 256;
+		targets = (target_t *) realloc (targets, max_targets * sizeof(target_t));
+		if (!targets)
+			Sys_Error ("Out of memory");
+	}
+	memset (&targets[num_targets], 0, sizeof(target_t));
+	targets[num_targets].adr = *adr;
+	num_targets++;
+}
+
+/*****************************************************************************/
+
+static void QueryMaster (const netadr_t *master, FILE *msgs)
+{
+	struct sockaddr_in	hostaddress;
+	socklen_t	fromlen;
 	ssize_t		size;
+	netadr_t	adr;
+	unsigned char	*tmp;
+	unsigned short	port;
+	int		err, count, packets;
+
+/* send the query packet */
+	fprintf (msgs, "Querying master server at %s\n", NET_AdrToString(master));
+	NetadrToSockadr (master, &hostaddress);
+	size = sendto(socketfd, (const char *)query_msg, sizeof(query_msg), 0,
+			(struct sockaddr *)&hostaddress, sizeof(hostaddress));
+
+/* see if it worked */
+	if (size != sizeof(query_msg))
+	{
+		err = SOCKETERRNO;
+		Sys_Error ("Sendto failed: %s", socketerror(err));
+	}
+
+/* read the response packets, up to the short one that ends the list */
+	for (packets = 0; ; )
+	{
+		if (NET_CheckReadTimeout(packets ? 2 : 5, 0) <= 0)
+		{
+			if (!packets)
+				Sys_Error ("*** timeout waiting for reply");
+			fprintf (msgs, "Warning: timeout waiting for the rest of the list\n");
+			break;
+		}
+
+		memset (response, 0, sizeof(response));
+		fromlen = sizeof(hostaddress);
+		size = recvfrom(socketfd, (char *)response, sizeof(response), 0,
+				(struct sockaddr *)&hostaddress, &fromlen);
+		if (size == SOCKET_ERROR)
+		{
+			err = SOCKETERRNO;
+			if (err != NET_EWOULDBLOCK)
+				Sys_Error ("Recv failed: %s", socketerror(err));
+			continue;
+		}
+		if (size == sizeof(response))
+			Sys_Error ("Received oversized packet!");
+		if (memcmp(response, reply_hdr, LIST_HEADERSIZE) != 0)
+			Sys_Error ("Invalid response received");
+
+		packets++;
+		tmp = &response[LIST_HEADERSIZE];
+		size -= LIST_HEADERSIZE;
+		if (size % LIST_ENTRYSIZE != 0)
+			fprintf (msgs, "Warning: not counting truncated last entry\n");
+		/* each address is 4 bytes (ip) + 2 bytes (port) == 6 bytes */
+		for (count = 0; size >= LIST_ENTRYSIZE; count++)
+		{
+			port = ntohs (tmp[4] + (tmp[5] << 8));
+			memcpy (adr.ip, tmp, 4);
+			adr.port = htons (port);
+			AddTarget (&adr);
+			tmp += LIST_ENTRYSIZE;
+			size -= LIST_ENTRYSIZE;
+		}
+		if (count < LIST_PERPACKET)
+			break;
+	}
+
+	fprintf (msgs, "H2W Servers registered at %s:", NET_AdrToString(master));
+	if (!num_targets)
+		fprintf (msgs, " NONE\n");
+	else
+		fprintf (msgs, " %d entries\n", num_targets);
+}
+
+static void ReadServerFile (const char *name)
+{
+	FILE	*f;
+	char	line[256], *p;
+	netadr_t	adr;
+
+	f = strcmp(name, "-") ? fopen (name, "r") : stdin;
+	if (!f)
+		Sys_Error ("Couldn't open %s", name);
+
+	while (fgets(line, sizeof(line), f))
+	{
+		/* one address per line, # starts a comment */
+		line[strcspn(line, "#\r\n")] = '\0';
+		for (p = line; *p == ' ' || *p == '\t'; p++)
+			;
+		p[strcspn(p, " \t")] = '\0';
+		if (!*p)
+			continue;
+		if (!NET_StringToAdr(p, &adr))
+		{
+			fprintf (stderr, "Unable to resolve address %s\n", p);
+			continue;
+		}
+		if (adr.port == 0)
+			adr.port = htons(PORT_SERVER);
+		AddTarget (&adr);
+	}
+
+	if (f != stdin)
+		fclose (f);
+}
+
+/*****************************************************************************/
+
+/* the scan output is one json object per line and per server.  strings
+ * are written byte by byte, the high half of the hexen2 charset becomes
+ * \u0080 to \u00ff.  */
+static void JSON_String (const char *s)
+{
+	const unsigned char	*p;
+
+	putchar ('\"');
+	for (p = (const unsigned char *)s; *p; p++)
+	{
+		if (*p == '\"' || *p == '\\')
+			printf ("\\%c", *p);
+		else if (*p < 0x20 || *p >= 0x7f)
+			printf ("\\u%04x", *p);
+		else
+			putchar (*p);
+	}
+	putchar ('\"');
+}
+
+static char *GetQuoted (char **s)
+{
+	char	*start, *end;
+
+	start = *s;
+	while (*start == ' ')
+		start++;
+	if (*start++ != '\"')
+		return NULL;
+	if (!(end = strchr(start, '\"')))
+		return NULL;
+	*end = '\0';
+	*s = end + 1;
+	return start;
+}
+
+/* the players follow the serverinfo line as
+ * userid frags minutes ping "name" "skin" topcolor bottomcolor */
+static int PrintPlayer (char *line, int first)
+{
+	int	v[4], top, bottom, i;
+	char	*p, *end, *name, *skin;
+
+	p = line;
+	for (i = 0; i < 4; i++)
+	{
+		v[i] = (int) strtol (p, &end, 10);
+		if (end == p)
+			return 0;
+		p = end;
+	}
+	if (!(name = GetQuoted(&p)) || !(skin = GetQuoted(&p)))
+		return 0;
+	top = (int) strtol (p, &p, 10);
+	bottom = (int) strtol (p, &p, 10);
+
+	if (!first)
+		putchar (',');
+	printf ("{\"userid\":%d,\"frags\":%d,\"time\":%d,\"ping\":%d,\"name\":",
+			v[0], v[1], v[2], v[3]);
+	JSON_String (name);
+	printf (",\"skin\":");
+	JSON_String (skin);
+	printf (",\"top\":%d,\"bottom\":%d}", top, bottom);
+	return 1;
+}
+
+static void PrintStatus (const target_t *t, double rtt, char *text)
+{
+	char	*p, *key, *value, *line, *next;
+	char	c;
+	int	first, players;
+
+	printf ("{\"address\":\"%s\",\"rtt\":%.1f,\"attempts\":%d,\"info\":{",
+			NET_AdrToString(&t->adr), rtt * 1000, t->attempts);
+
+	/* the first line is the serverinfo string: \key\value\key\value */
+	next = strchr (text, '\n');
+	if (next)
+		*next++ = '\0';
+	first = 1;
+	for (p = text; *p == '\\'; *p = c)
+	{
+		key = p + 1;
+		if (!(value = strchr(key, '\\')))
+			break;
+		*value++ = '\0';
+		p = value + strcspn(value, "\\");
+		c = *p;
+		*p = '\0';
+		if (!first)
+			putchar (',');
+		first = 0;
+		JSON_String (key);
+		putchar (':');
+		JSON_String (value);
+	}
+
+	printf ("},\"players\":[");
+	players = 0;
+	while ((line = next) != NULL)
+	{
+		next = strchr (line, '\n');
+		if (next)
+			*next++ = '\0';
+		players += PrintPlayer (line, !players);
+	}
+	printf ("],\"numplayers\":%d}\n", players);
+}
+
+static int CompareTargets (const void *a, const void *b)
+{
+	const netadr_t	*x = &((const target_t *)a)->adr;
+	const netadr_t	*y = &((const target_t *)b)->adr;
+	int	d;
+
+	if ((d = memcmp(x->ip, y->ip, 4)) != 0)
+		return d;
+	return (int)x->port - (int)y->port;
+}
+
+static target_t *FindTarget (const netadr_t *adr)
+{
+	target_t	key;
+
+	key.adr = *adr;
+	return (target_t *) bsearch (&key, targets, num_targets, sizeof(target_t), CompareTargets);
+}
+
+/* returns the number of servers that answered */
+static int ReadReplies (int status)
+{
+	struct sockaddr_in	from;
 	socklen_t	fromlen;
+	ssize_t		size;
+	netadr_t	adr;
+	target_t	*t;
+	double		now;
+	int		len, answered;
+
+	answered = 0;
+	while (1)
+	{
+		fromlen = sizeof(from);
+		size = recvfrom(socketfd, (char *)response, sizeof(response), 0,
+				(struct sockaddr *)&from, &fromlen);
+		if (size == SOCKET_ERROR)
+			break;	/* would block, or an icmp error from a dead server */
+		now = Sys_DoubleTime ();
+
+		SockadrToNetadr (&from, &adr);
+		t = FindTarget (&adr);
+		if (!t || t->done)
+			continue;
+
+		HuffDecode (response, decoded, size, &len, sizeof(decoded) - 1);
+		if (len > (int) sizeof(decoded) - 1)
+			len = sizeof(decoded) - 1;
+		decoded[len] = '\0';
+
+		if (status)
+		{
+			if (len < 5 || memcmp(decoded, "\377\377\377\377", 4) != 0 || decoded[4] != A2C_PRINT)
+				continue;
+			PrintStatus (t, now - t->sent, (char *)&decoded[5]);
+		}
+		else
+		{
+			if (len < 1 || decoded[0] != A2A_ACK)
+				continue;
+			printf ("{\"address\":\"%s\",\"rtt\":%.1f,\"attempts\":%d}\n",
+				NET_AdrToString(&t->adr), (now - t->sent) * 1000, t->attempts);
+		}
+		t->done = 1;
+		answered++;
+	}
+
+	return answered;
+}
+
+/* all the requests go out at once from the one socket, then the replies
+ * are matched to their servers by address as they come back.  a server
+ * that doesn't answer in time is asked again, up to retries times.  */
+static void ScanServers (int status, double timeout, int retries)
+{
+	const char	*msg;
+	int		msglen, i, j, err;
+	int		pending, answered, sends;
+	double		start, now;
+	target_t	*t;
+
+	msg = status ? status_msg : ping_msg;
+	msglen = (status ? sizeof(status_msg) : sizeof(ping_msg));
+
+	if (!num_targets)
+		return;
+
+	/* sort for the lookups, and drop the duplicates */
+	qsort (targets, num_targets, sizeof(target_t), CompareTargets);
+	for (i = j = 1; i < num_targets; i++)
+	{
+		if (CompareTargets(&targets[i], &targets[j - 1]) != 0)
+			targets[j++] = targets[i];
+	}
+	num_targets = j;
+
+	HuffInit ();
+
+	start = Sys_DoubleTime ();
+	pending = num_targets;
+	answered = 0;
+	sends = 0;
+	while (pending)
+	{
+		now = Sys_DoubleTime ();
+		for (i = 0; i < num_targets; i++)
+		{
+			struct sockaddr_in	hostaddress;
+
+			t = &targets[i];
+			if (t->done || (t->attempts && now - t->sent < timeout))
+				continue;
+			if (t->attempts > retries)
+			{
+				printf ("{\"address\":\"%s\",\"error\":\"timeout\",\"attempts\":%d}\n",
+						NET_AdrToString(&t->adr), t->attempts);
+				t->done = 1;
+				pending--;
+				continue;
+			}
+
+			NetadrToSockadr (&t->adr, &hostaddress);
+			if (sendto(socketfd, msg, msglen, 0, (struct sockaddr *)&hostaddress,
+					sizeof(hostaddress)) == SOCKET_ERROR)
+			{
+				err = SOCKETERRNO;
+				if (err == NET_EWOULDBLOCK)
+					break;	/* the send buffer is full, go on later */
+			}
+			t->sent = now;
+			t->attempts++;
+
+			/* a thousand answers at once would overflow the socket's
+			 * receive buffer, read the ones that are in already.  */
+			if (++sends % SEND_BATCH == 0)
+			{
+				j = ReadReplies (status);
+				answered += j;
+				pending -= j;
+			}
+		}
+
+		if (pending && NET_CheckReadTimeout(0, 10000) > 0)
+		{
+			i = ReadReplies (status);
+			answered += i;
+			pending -= i;
+		}
+	}
+
+	fprintf (stderr, "%d servers: %d answered, %d timed out in %.0f ms\n", num_targets,
+			answered, num_targets - answered, (Sys_DoubleTime() - start) * 1000);
+}
+
+/*****************************************************************************/
+
+static void PrintUsage (const char *name)
+{
+	printf ("Usage: %s [-ping | -status] [options] <address>[:port]\n", name);
+	printf ("       %s -ping | -status [options] -file <list>\n\n", name);
+	printf ("Without -ping or -status, lists the servers registered at the master\n"
+		"server at the given address.  With them, asks every listed server for\n"
+		"a ping or its status, all at once, and prints a json object per line.\n\n");
+	printf ("  -timeout <ms>  time to wait for a server's answer (default 1000)\n");
+	printf ("  -retries <n>   times to ask again a server that doesn't answer (default 1)\n");
+	printf ("  -file <list>   read the server addresses from a file, - for stdin\n");
+}
+
+int main (int argc, char **argv)
+{
 	netadr_t		ipaddress;
-	struct sockaddr_in	hostaddress;
+	const char	*master = NULL, *listfile = NULL;
+	FILE		*msgs;
 #if defined(PLATFORM_WINDOWS) || defined(PLATFORM_DOS)
 	u_long	_true = 1;
 #else
 	int	_true = 1;
 #endif
-	int		err;
-
-	printf ("HWMASTER QUERY %d.%d.%d\n", VER_HWMQUERY_MAJ, VER_HWMQUERY_MID, VER_HWMQUERY_MIN);
+	int		err, i;
+	int		bad = 0;
+	int		scan = 0;	/* 1: ping, 2: status */
+	int		retries = 1;
+	double		timeout = 1.0;
 
 /* command line sanity checking */
-	if (argc < 2)
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-ping"))
+			scan = 1;
+		else if (!strcmp(argv[i], "-status"))
+			scan = 2;
+		else if (!strcmp(argv[i], "-timeout") && i < argc - 1)
+			timeout = atoi(argv[++i]) / 1000.0;
+		else if (!strcmp(argv[i], "-retries") && i < argc - 1)
+			retries = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-file") && i < argc - 1)
+			listfile = argv[++i];
+		else if (argv[i][0] != '-' && !master)
+			master = argv[i];
+		else
+		{
+			bad = 1;
+			break;
+		}
+	}
+	/* the json lines go to stdout, everything else to stderr */
+	msgs = scan ? stderr : stdout;
+
+	fprintf (msgs, "HWMASTER QUERY %d.%d.%d\n", VER_HWMQUERY_MAJ, VER_HWMQUERY_MID, VER_HWMQUERY_MIN);
+
+	if (bad || (!master && !listfile) || (listfile && (master || !scan)))
 	{
-		printf ("Usage: %s <address>[:port]\n", argv[0]);
+		PrintUsage (argv[0]);
 		exit (1);
 	}
+	if (timeout <= 0 || retries < 0)
+		Sys_Error ("Invalid timeout or retries");
 
 /* init OS-specific network stuff */
 	NET_Init ();
 
-/* decode the address and port */
-	if (!NET_StringToAdr(argv[1], &ipaddress))
-		Sys_Error ("Unable to resolve address %s", argv[1]);
-	if (ipaddress.port == 0)
-		ipaddress.port = htons(PORT_MASTER);
-	NetadrToSockadr(&ipaddress, &hostaddress);
-
 /* open the socket */
 	socketfd = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
 	if (socketfd == INVALID_SOCKET)
@@ -276,67 +747,39 @@ int main (int argc, char **argv)
 		Sys_Error ("ioctl FIONBIO: %s", socketerror(err));
 	}
 
-/* send the query packet */
-	printf ("Querying master server at %s\n", NET_AdrToString(&ipaddress));
-	size = sendto(socketfd, (const char *)query_msg, sizeof(query_msg), 0,
-			(struct sockaddr *)&hostaddress, sizeof(hostaddress));
-
-/* see if it worked */
-	if (size != sizeof(query_msg))
+	if (scan)
 	{
-		err = SOCKETERRNO;
-		Sys_Error ("Sendto failed: %s", socketerror(err));
+	/* make room for the answers that come in together */
+		int	bufsize = 1 << 20;
+		setsockopt (socketfd, SOL_SOCKET, SO_RCVBUF, (char *)&bufsize, sizeof(bufsize));
 	}
 
-/* read the response */
-	memset (response, 0, sizeof(response));
-	fromlen = sizeof(hostaddress);
-	if (NET_CheckReadTimeout(5, 0) <= 0)
-		Sys_Error ("*** timeout waiting for reply");
-
-	size = recvfrom(socketfd, (char *)response, sizeof(response), 0,
-			(struct sockaddr *)&hostaddress, &fromlen);
-	if (size == SOCKET_ERROR)
+	if (listfile)
 	{
-		err = SOCKETERRNO;
-		if (err != NET_EWOULDBLOCK)
-			Sys_Error ("Recv failed: %s", socketerror(err));
+		ReadServerFile (listfile);
 	}
-	else if (size == sizeof(response))
+	else
 	{
-		Sys_Error ("Received oversized packet!");
+	/* decode the address and port */
+		if (!NET_StringToAdr(master, &ipaddress))
+			Sys_Error ("Unable to resolve address %s", master);
+		if (ipaddress.port == 0)
+			ipaddress.port = htons(PORT_MASTER);
+
+		QueryMaster (&ipaddress, msgs);
 	}
-	else if (memcmp(response, reply_hdr, 7) != 0)
+
+	if (scan)
 	{
-		Sys_Error ("Invalid response received");
+		ScanServers (scan == 2, timeout, retries);
 	}
 	else
 	{
-		unsigned char	*tmp;
-		unsigned short	port;
-
-		printf ("H2W Servers registered at %s:", NET_AdrToString(&ipaddress));
-
-		tmp = &response[7];
-		size -= 7;
-		if (!size)
-			printf (" NONE\n");
-		else
-		{
-			/* each address is 4 bytes (ip) + 2 bytes (port) == 6 bytes */
-			printf (" %d entries\n", (int)size / 6);
-			if (size % 6 != 0)
-				printf ("Warning: not counting truncated last entry\n");
-			while (size >= 6)
-			{
-				port = ntohs (tmp[4] + (tmp[5] << 8));
-				printf ("%u.%u.%u.%u:%u\n", tmp[0], tmp[1], tmp[2], tmp[3], port);
-				tmp += 6;
-				size -= 6;
-			}
-		}
+		for (i = 0; i < num_targets; i++)
+			printf ("%s\n", NET_AdrToString(&targets[i].adr));
 	}
 
 	NET_Shutdown ();
 	return 0;
 }
+
@@ -15,6 +15,7 @@ if test "$1" = "strip"; then
 		qfiles/qfiles$exe_ext		\
 		pak/pakx$exe_ext		\
 		pak/paklist$exe_ext		\
+		pak/pakmake$exe_ext		\
 		genmodel/genmodel$exe_ext	\
 		jsh2color/jsh2colour$exe_ext	\
 		texutils/bsp2wal/bsp2wal$exe_ext	\
@@ -15,6 +15,7 @@ if test "$1" = "strip"; then
 		qfiles/qfiles.exe		\
 		pak/pakx.exe			\
 		pak/paklist.exe			\
+		pak/pakmake.exe			\
 		genmodel/genmodel.exe		\
 		jsh2color/jsh2colour.exe	\
 		texutils/bsp2wal/bsp2wal.exe	\
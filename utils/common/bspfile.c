@@ -25,6 +25,7 @@
 #include "mathlib.h"
 #include "q_endian.h"
 #include "bspfile.h"
+#include "buildcache.h"
 
 //=============================================================================
 
@@ -536,3 +537,151 @@ void PrintBSPFileSizes (int bsp2)
 	printf ("      entdata      %6i\n", entdatasize);
 }
 
+
+/*
+=============================================================================
+
+BSP FILE HASHES
+
+=============================================================================
+*/
+
+/*
+==================
+Hash_BSPGeometry
+
+Everything qbsp makes except the entities and the textures, which qbsp
+can put in an existing bsp file without building it again.  The vis and
+light fields of the leafs and faces are left out.
+==================
+*/
+void Hash_BSPGeometry (buildhash_t *hash)
+{
+	int		i;
+	dleaf_t		leaf;
+	dleaf2_t	leaf2;
+	dface_t		face;
+	dface2_t	face2;
+
+	Hash_Int (hash, is_bsp2);
+
+	Hash_Int (hash, numplanes);
+	Hash_Data (hash, dplanes, numplanes*sizeof(dplane_t));
+	Hash_Int (hash, numvertexes);
+	Hash_Data (hash, dvertexes, numvertexes*sizeof(dvertex_t));
+	Hash_Int (hash, numtexinfo);
+	Hash_Data (hash, texinfo, numtexinfo*sizeof(texinfo_t));
+	Hash_Int (hash, numsurfedges);
+	Hash_Data (hash, dsurfedges, numsurfedges*sizeof(dsurfedges[0]));
+	Hash_Int (hash, nummodels);
+	Hash_Data (hash, dmodels, nummodels*sizeof(dmodel_t));
+
+	Hash_Int (hash, numleafs);
+	Hash_Int (hash, numfaces);
+	if (is_bsp2)
+	{
+		for (i = 0 ; i < numleafs ; i++)
+		{
+			leaf2 = dleafs2[i];
+			leaf2.visofs = 0;
+			memset (leaf2.ambient_level, 0, sizeof(leaf2.ambient_level));
+			Hash_Data (hash, &leaf2, sizeof(leaf2));
+		}
+		for (i = 0 ; i < numfaces ; i++)
+		{
+			face2 = dfaces2[i];
+			memset (face2.styles, 0, sizeof(face2.styles));
+			face2.lightofs = 0;
+			Hash_Data (hash, &face2, sizeof(face2));
+		}
+		Hash_Int (hash, numnodes);
+		Hash_Data (hash, dnodes2, numnodes*sizeof(dnode2_t));
+		Hash_Int (hash, numclipnodes);
+		Hash_Data (hash, dclipnodes2, numclipnodes*sizeof(dclipnode2_t));
+		Hash_Int (hash, nummarksurfaces);
+		Hash_Data (hash, dmarksurfaces2, nummarksurfaces*sizeof(dmarksurfaces2[0]));
+		Hash_Int (hash, numedges);
+		Hash_Data (hash, dedges2, numedges*sizeof(dedge2_t));
+	}
+	else
+	{
+		for (i = 0 ; i < numleafs ; i++)
+		{
+			leaf = dleafs[i];
+			leaf.visofs = 0;
+			memset (leaf.ambient_level, 0, sizeof(leaf.ambient_level));
+			Hash_Data (hash, &leaf, sizeof(leaf));
+		}
+		for (i = 0 ; i < numfaces ; i++)
+		{
+			face = dfaces[i];
+			memset (face.styles, 0, sizeof(face.styles));
+			face.lightofs = 0;
+			Hash_Data (hash, &face, sizeof(face));
+		}
+		Hash_Int (hash, numnodes);
+		Hash_Data (hash, dnodes, numnodes*sizeof(dnode_t));
+		Hash_Int (hash, numclipnodes);
+		Hash_Data (hash, dclipnodes, numclipnodes*sizeof(dclipnode_t));
+		Hash_Int (hash, nummarksurfaces);
+		Hash_Data (hash, dmarksurfaces, nummarksurfaces*sizeof(dmarksurfaces[0]));
+		Hash_Int (hash, numedges);
+		Hash_Data (hash, dedges, numedges*sizeof(dedge_t));
+	}
+}
+
+/*
+==================
+Hash_BSPVis
+
+What vis puts in the bsp file
+==================
+*/
+void Hash_BSPVis (buildhash_t *hash)
+{
+	int		i;
+
+	Hash_Int (hash, visdatasize);
+	Hash_Data (hash, dvisdata, visdatasize);
+	for (i = 0 ; i < numleafs ; i++)
+	{
+		if (is_bsp2)
+		{
+			Hash_Int (hash, dleafs2[i].visofs);
+			Hash_Data (hash, dleafs2[i].ambient_level, sizeof(dleafs2[i].ambient_level));
+		}
+		else
+		{
+			Hash_Int (hash, dleafs[i].visofs);
+			Hash_Data (hash, dleafs[i].ambient_level, sizeof(dleafs[i].ambient_level));
+		}
+	}
+}
+
+/*
+==================
+Hash_BSPLighting
+
+What light puts in the bsp file, but the entities
+==================
+*/
+void Hash_BSPLighting (buildhash_t *hash)
+{
+	int		i;
+
+	Hash_Int (hash, lightdatasize);
+	Hash_Data (hash, dlightdata, lightdatasize);
+	for (i = 0 ; i < numfaces ; i++)
+	{
+		if (is_bsp2)
+		{
+			Hash_Data (hash, dfaces2[i].styles, sizeof(dfaces2[i].styles));
+			Hash_Int (hash, dfaces2[i].lightofs);
+		}
+		else
+		{
+			Hash_Data (hash, dfaces[i].styles, sizeof(dfaces[i].styles));
+			Hash_Int (hash, dfaces[i].lightofs);
+		}
+	}
+}
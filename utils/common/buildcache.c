@@ -0,0 +1,358 @@
+/* buildcache.c -- content hashes and the build cache shared by the tools
+ *
+ * The cache is a list of named blobs.  qbsp keeps the hashes of its input
+ * and of the bsp it wrote in it, and the clipping hulls of the models so
+ * that an untouched model doesn't have to be built again.  vis and light
+ * keep the hashes of their input and of what they added to the bsp, and
+ * do nothing when neither changed since.  hcc keeps the parse trees of
+ * the source files, under the hashes of their text.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "q_stdinc.h"
+#include "compiler.h"
+#include "arch_def.h"
+#include "cmdlib.h"
+#include "q_endian.h"
+#include "util_io.h"
+#include "buildcache.h"
+
+
+/*
+=============================================================================
+
+HASHING
+
+Two 32 bit lanes, a FNV-1a and a multiply and shift one, so that the
+chance of two different inputs getting the same hash is out of the way.
+
+=============================================================================
+*/
+
+void Hash_Init (buildhash_t *hash)
+{
+	hash->h[0] = 2166136261U;
+	hash->h[1] = 0x9747b28cU;
+}
+
+void Hash_Data (buildhash_t *hash, const void *data, int size)
+{
+	const byte	*p = (const byte *)data;
+	unsigned int	a = hash->h[0], b = hash->h[1];
+	int		i;
+
+	for (i = 0 ; i < size ; i++)
+	{
+		a = (a ^ p[i]) * 16777619U;
+		b = (b ^ p[i]) * 0x5bd1e995U;
+		b ^= b >> 15;
+	}
+
+	hash->h[0] = a;
+	hash->h[1] = b;
+}
+
+void Hash_Int (buildhash_t *hash, int v)
+{
+	Hash_Data (hash, &v, sizeof(v));
+}
+
+void Hash_Float (buildhash_t *hash, double v)
+{
+	Hash_Data (hash, &v, sizeof(v));
+}
+
+void Hash_String (buildhash_t *hash, const char *s)
+{
+	Hash_Data (hash, s, strlen(s) + 1);	// with the terminator
+}
+
+void Hash_Hex (const buildhash_t *hash, char *out)
+{
+	sprintf (out, "%08x%08x", hash->h[0], hash->h[1]);
+}
+
+
+/*
+=============================================================================
+
+CACHE FILE
+
+"BCACHE1" and a zero, the number of entries, and every entry as the
+length and characters of its name and the length and bytes of its data.
+The numbers are little endian.
+
+=============================================================================
+*/
+
+#define	CACHE_ID	"BCACHE1"
+
+typedef struct
+{
+	char		*key;
+	byte		*data;
+	int		size;
+	qboolean	used;	// looked up or set by this run
+} cacheentry_t;
+
+static char		cachefilename[1024];
+static cacheentry_t	*cache;
+static int		numcache, maxcache;
+
+static cacheentry_t *FindEntry (const char *key)
+{
+	int		i;
+
+	for (i = 0 ; i < numcache ; i++)
+	{
+		if (!strcmp (cache[i].key, key))
+			return &cache[i];
+	}
+	return NULL;
+}
+
+static cacheentry_t *NewEntry (const char *key)
+{
+	cacheentry_t	*e;
+
+	if (numcache == maxcache)
+	{
+		maxcache = maxcache ? maxcache * 2 : 64;
+		e = (cacheentry_t *) SafeMalloc (maxcache * sizeof(cacheentry_t));
+		if (numcache)
+			memcpy (e, cache, numcache * sizeof(cacheentry_t));
+		free (cache);
+		cache = e;
+	}
+
+	e = &cache[numcache++];
+	e->key = SafeStrdup (key);
+	e->data = NULL;
+	e->size = 0;
+	e->used = false;
+	return e;
+}
+
+static void FreeEntries (void)
+{
+	int		i;
+
+	for (i = 0 ; i < numcache ; i++)
+	{
+		free (cache[i].key);
+		free (cache[i].data);
+	}
+	numcache = 0;
+}
+
+static int ReadInt (const byte **p, const byte *end)
+{
+	int		v;
+
+	if (end - *p < 4)
+		return -1;
+	memcpy (&v, *p, 4);
+	*p += 4;
+	return LittleLong (v);
+}
+
+/*
+==================
+Cache_Load
+
+A missing or damaged cache file is an empty cache
+==================
+*/
+void Cache_Load (const char *filename)
+{
+	void		*buf;
+	const byte	*p, *end;
+	int		len, i, count, keylen, size;
+	char		key[256];
+	cacheentry_t	*e;
+
+	strcpy (cachefilename, filename);
+	FreeEntries ();
+
+	if (Q_FileType (filename) != FS_ENT_FILE)
+		return;
+
+	len = LoadFile (filename, &buf);
+	p = (const byte *)buf;
+	end = p + len;
+
+	if (len < 8 || memcmp (p, CACHE_ID, 8))
+		goto bad;
+	p += 8;
+
+	count = ReadInt (&p, end);
+	if (count < 0)
+		goto bad;
+	for (i = 0 ; i < count ; i++)
+	{
+		keylen = ReadInt (&p, end);
+		if (keylen <= 0 || keylen >= (int)sizeof(key) || end - p < keylen)
+			goto bad;
+		memcpy (key, p, keylen);
+		key[keylen] = 0;
+		p += keylen;
+
+		size = ReadInt (&p, end);
+		if (size < 0 || end - p < size)
+			goto bad;
+
+		e = NewEntry (key);
+		e->data = (byte *) SafeMalloc (size ? size : 1);
+		memcpy (e->data, p, size);
+		e->size = size;
+		p += size;
+	}
+
+	free (buf);
+	return;
+
+bad:
+	printf ("WARNING: %s is damaged, not using it\n", filename);
+	FreeEntries ();
+	free (buf);
+}
+
+static void WriteInt (FILE *f, int v)
+{
+	v = LittleLong (v);
+	SafeWrite (f, &v, 4);
+}
+
+void Cache_Save (void)
+{
+	FILE	*f;
+	int		i, len;
+
+	f = SafeOpenWrite (cachefilename);
+	SafeWrite (f, CACHE_ID, 8);
+	WriteInt (f, numcache);
+	for (i = 0 ; i < numcache ; i++)
+	{
+		len = strlen (cache[i].key);
+		WriteInt (f, len);
+		SafeWrite (f, cache[i].key, len);
+		WriteInt (f, cache[i].size);
+		SafeWrite (f, cache[i].data, cache[i].size);
+	}
+	fclose (f);
+}
+
+/*
+==================
+Cache_Get
+
+Doesn't change the cache, so threads can look things up at the same time
+as long as nothing is set
+==================
+*/
+const void *Cache_Get (const char *key, int *size)
+{
+	cacheentry_t	*e;
+
+	e = FindEntry (key);
+	if (!e)
+		return NULL;
+	e->used = true;
+	if (size)
+		*size = e->size;
+	return e->data;
+}
+
+void Cache_Set (const char *key, const void *data, int size)
+{
+	cacheentry_t	*e;
+
+	e = FindEntry (key);
+	if (!e)
+		e = NewEntry (key);
+	free (e->data);
+	e->data = (byte *) SafeMalloc (size ? size : 1);
+	memcpy (e->data, data, size);
+	e->size = size;
+	e->used = true;
+}
+
+/*
+==================
+Cache_Match
+
+True if the entry is the string value
+==================
+*/
+qboolean Cache_Match (const char *key, const char *value)
+{
+	const char	*data;
+	int		size;
+
+	data = (const char *) Cache_Get (key, &size);
+	if (!data)
+		return false;
+	return size == (int)strlen(value) + 1 && !memcmp (data, value, size);
+}
+
+void Cache_SetString (const char *key, const char *value)
+{
+	Cache_Set (key, value, strlen(value) + 1);
+}
+
+static void RemoveEntries (const char *prefix, qboolean unusedonly)
+{
+	int		i, j, len;
+
+	len = strlen (prefix);
+	for (i = j = 0 ; i < numcache ; i++)
+	{
+		if (!strncmp (cache[i].key, prefix, len) && !(unusedonly && cache[i].used))
+		{
+			free (cache[i].key);
+			free (cache[i].data);
+			continue;
+		}
+		cache[j++] = cache[i];
+	}
+	numcache = j;
+}
+
+/*
+==================
+Cache_Remove
+
+Removes all the entries whose names start with prefix
+==================
+*/
+void Cache_Remove (const char *prefix)
+{
+	RemoveEntries (prefix, false);
+}
+
+/*
+==================
+Cache_RemoveUnused
+
+Removes the entries whose names start with prefix that this run didn't
+look up or set, so that the cache doesn't grow with every edit
+==================
+*/
+void Cache_RemoveUnused (const char *prefix)
+{
+	RemoveEntries (prefix, true);
+}
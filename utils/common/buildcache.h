@@ -0,0 +1,58 @@
+/* buildcache.h -- content hashes and the build cache shared by the tools
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef H2UTILS_BUILDCACHE_H
+#define H2UTILS_BUILDCACHE_H
+
+/* qbsp, vis and light keep what they last did to a map in <map>.bcache
+ * next to the bsp file, so that a tool can skip the work when its input
+ * didn't change since.  hcc keeps its parsed source files in <src>.bcache
+ * next to the .src file.  the hashes are made from the data in memory, so
+ * a cache file is only good for the byte order it was made with.  */
+
+#define	HASH_STRLEN	17	/* 16 hex digits and the terminator */
+
+typedef struct
+{
+	unsigned int	h[2];
+} buildhash_t;
+
+void	Hash_Init (buildhash_t *hash);
+void	Hash_Data (buildhash_t *hash, const void *data, int size);
+void	Hash_Int (buildhash_t *hash, int v);
+void	Hash_Float (buildhash_t *hash, double v);
+void	Hash_String (buildhash_t *hash, const char *s);
+void	Hash_Hex (const buildhash_t *hash, char *out);	/* HASH_STRLEN chars */
+
+/* hashes of the bsp file lumps that are in memory, in bspfile.c.  the
+ * geometry is everything but the entities and textures, and what vis and
+ * light add to it.  */
+void	Hash_BSPGeometry (buildhash_t *hash);
+void	Hash_BSPVis (buildhash_t *hash);
+void	Hash_BSPLighting (buildhash_t *hash);
+
+void	Cache_Load (const char *filename);
+void	Cache_Save (void);
+const void *Cache_Get (const char *key, int *size);	/* NULL if not there */
+void	Cache_Set (const char *key, const void *data, int size);
+qboolean Cache_Match (const char *key, const char *value);
+void	Cache_SetString (const char *key, const char *value);
+void	Cache_Remove (const char *prefix);
+void	Cache_RemoveUnused (const char *prefix);
+
+#endif	/* H2UTILS_BUILDCACHE_H */
@@ -209,6 +209,11 @@ void ThreadUnlock (void)
 		ReleaseMutex (my_mutex);
 }
 
+int Thread_GetNumThreads (void)
+{
+	return numthreads;
+}
+
 /*
 ===============
 RunThreadsOn
@@ -298,6 +303,11 @@ void ThreadUnlock (void)
 		release_lock (&lck);
 }
 
+int Thread_GetNumThreads (void)
+{
+	return numthreads;
+}
+
 /*
 =============
 RunThreadsOn
@@ -395,6 +405,11 @@ void ThreadUnlock (void)
 		pthread_mutex_unlock (my_mutex);
 }
 
+int Thread_GetNumThreads (void)
+{
+	return numthreads;
+}
+
 /*
 ===============
 RunThreadsOn
@@ -490,6 +505,11 @@ void ThreadUnlock (void)
 		pthread_mutex_unlock (my_mutex);
 }
 
+int Thread_GetNumThreads (void)
+{
+	return numthreads;
+}
+
 /*
 =============
 RunThreadsOn
@@ -591,6 +611,11 @@ void ThreadUnlock (void)
 		DosReleaseMutexSem (my_mutex);
 }
 
+int Thread_GetNumThreads (void)
+{
+	return numthreads;
+}
+
 /*
 ===============
 RunThreadsOn
@@ -641,6 +666,11 @@ void ThreadUnlock (void)
 	/* ( nothing ) */
 }
 
+int Thread_GetNumThreads (void)
+{
+	return 1;
+}
+
 /*
 ===============
 RunThreadsOn
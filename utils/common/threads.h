@@ -30,5 +30,6 @@ void	InitThreads (int wantthreads, size_t needstack);
 void	ThreadLock (void);
 void	ThreadUnlock (void);
 void	RunThreadsOn (threadfunc_t func);
+int	Thread_GetNumThreads (void);	/* as set by InitThreads */
 
 #endif	/* H2UTILS_THREADS_H */
@@ -49,6 +49,9 @@ OBJECTS = qsnprint.obj &
 	strlcpy.obj &
 	cmdlib.obj &
 	util_io.obj &
+	pathutil.obj &
+	threads.obj &
+	buildcache.obj &
 	q_endian.obj &
 	byteordr.obj &
 	crc.obj &
@@ -57,7 +60,8 @@ OBJECTS = qsnprint.obj &
 	hcc.obj &
 	pr_comp.obj &
 	pr_lex.obj &
-	stmt.obj
+	stmt.obj &
+	tree.obj
 
 all: $(BINARY)
 
@@ -38,9 +38,17 @@
 
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
-static def_t *Term(void);
-static def_t *ParseFunctionCall(def_t *func);
-static def_t *ParseIntrinsicFunc(const char *name);
+static int Term(void);
+static int ParseFunctionCall(int func);
+static int ParseIntrinsicFunc(const char *name);
+static def_t *GenBinary(pnode_t *n);
+static def_t *GenNot(pnode_t *n);
+static def_t *GetName(pnode_t *n);
+static def_t *GenIndex(pnode_t *n);
+static def_t *GenIndexStore(pnode_t *n);
+static def_t *GenFunctionCall(pnode_t *n);
+static def_t *GenIntrinsicFunc(pnode_t *n);
+static void PrecacheFileName(const char *n, int ch);
 static void PrecacheSound(def_t *e, int ch);
 static void PrecacheModel(def_t *e, int ch);
 static void PrecacheFile(def_t *e, int ch);
@@ -114,16 +122,12 @@ void EX_Init (void)
 //
 //==========================================================================
 
-def_t *EX_Expression (int priority)
+int EX_Expression (int priority)
 {
 	opcode_t	*op;
-	def_t	*e;
-	def_t	*e2;
-	etype_t	type_a;
-	etype_t	type_b;
-	etype_t	type_c;
-	int	tag;
-	int	opIndex;
+	int		e;
+	int		e2;
+	int		opIndex;
 
 	if (priority == 0)
 	{
@@ -145,100 +149,160 @@ def_t *EX_Expression (int priority)
 			return e;
 		}
 
-		for (op = &pr_opcodes[opIndex]; op->name; op++)
+		op = &pr_opcodes[opIndex];
+		if (op->priority != priority)
 		{
-			if (op->priority != priority)
-			{
-				return e;
-			}
-			if (!LX_CheckFetch(op->name))
-			{
-				return e;
-			}
-			if (op->right_associative)
-			{
-				if ((unsigned int)(statements[numstatements-1].op - OP_LOAD_F) < 6)
-				{
-					// The preceding statement was an indirect.  Change it to
-					// an address of.
-					statements[numstatements-1].op = OP_ADDRESS;
-					def_pointer.type->aux_type = e->type;
-					e->type = def_pointer.type;
-				}
-				/*
-				else if ((unsigned int)(statements[numstatements-1].op - OP_FETCH_GBL_F) < 5)
-				{
-					// The preceding statement was an array lookup.  Assignment
-					// is currently not allowed to arrays.
-					PR_ParseError("assignment not allowed to arrays");
-				}
-				*/
-				e2 = EX_Expression(priority);
-			}
-			else
-			{
-				e2 = EX_Expression(priority-1);
-			}
+			return e;
+		}
+		if (!LX_CheckFetch(op->name))
+		{
+			return e;
+		}
+		if (op->right_associative)
+		{
+			e2 = EX_Expression(priority);
+		}
+		else
+		{
+			e2 = EX_Expression(priority-1);
+		}
+		e = TR_NewNode(PN_BINARY, opIndex, e, e2, 0);
+	}
+}
 
-			// Set types a, b, and c
-			type_a = e->type->type;
-			type_b = e2->type->type;
-			if (op->name[0] == '.')
-			{ // Field access gets type from field
-				if (e2->type->aux_type)
-				{
-					type_c = e2->type->aux_type->type;
-				}
-				else
-				{ // Not a field
-					type_c = ev_bad;
-				}
-			}
-			else
-			{
-				type_c = ev_void;
-			}
+//==========================================================================
+//
+// EX_GenExpression
+//
+//==========================================================================
 
-			// Find the opcode that matches the types
-			tag = op->tag;
-			while ( type_a != op->type_a->type->type ||
-				type_b != op->type_b->type->type ||
-				(type_c != ev_void && type_c != op->type_c->type->type))
-			{
-				op++;
-				if (tag != op->tag)
-				{
-					op--;
-					PR_ParseError("type mismatch for %s", op->name);
-				}
-			}
-			if (type_a == ev_pointer && type_b != e->type->aux_type->type)
-			{
-				PR_ParseError("type mismatch for %s", op->name);
-			}
+def_t *EX_GenExpression (int node)
+{
+	pnode_t	*n;
+	def_t	*d;
+
+	n = NODE(node);
+	switch (n->kind)
+	{
+	case PN_EXPR:
+		return EX_GenExpression(n->a);
+	case PN_IMMEDIATE:
+		return CO_GenImmediate(node);
+	case PN_NOT:
+		return GenNot(n);
+	case PN_NAME:
+		return GetName(n);
+	case PN_INDEX:
+		return GenIndex(n);
+	case PN_INDEXSTORE:
+		return GenIndexStore(n);
+	case PN_BINARY:
+		return GenBinary(n);
+	case PN_CALL:
+		return GenFunctionCall(n);
+	case PN_RANDOM:
+	case PN_RANDOMV:
+	case PN_PRECACHE_FILE:
+		d = GenIntrinsicFunc(n);
+		d->referenceCount++;
+		if (d->parentVector != NULL)
+			d->parentVector->referenceCount++;
+		return d;
+	}
+	COM_Error("%s: bad node kind %d", __thisfunc__, n->kind);
+	return NULL;
+}
 
-			// Emit the statement
-			if (op->right_associative)
-			{
-				e = CO_GenCode(op, e2, e);
-			}
-			else
-			{
-				e = CO_GenCode(op, e, e2);
-			}
+//==========================================================================
+//
+// GenBinary
+//
+//==========================================================================
 
-			if (type_c != ev_void)
-			{ // Field access gets type from field
-				e->type = e2->type->aux_type;
-			}
+static def_t *GenBinary (pnode_t *n)
+{
+	opcode_t	*op;
+	def_t	*e;
+	def_t	*e2;
+	etype_t	type_a;
+	etype_t	type_b;
+	etype_t	type_c;
+	int	tag;
 
-			break;
+	op = &pr_opcodes[n->op];
+	e = EX_GenExpression(n->a);
+	if (op->right_associative)
+	{
+		if ((unsigned int)(statements[numstatements-1].op - OP_LOAD_F) < 6)
+		{
+			// The preceding statement was an indirect.  Change it to
+			// an address of.
+			statements[numstatements-1].op = OP_ADDRESS;
+			def_pointer.type->aux_type = e->type;
+			e->type = def_pointer.type;
 		}
+		/*
+		else if ((unsigned int)(statements[numstatements-1].op - OP_FETCH_GBL_F) < 5)
+		{
+			// The preceding statement was an array lookup.  Assignment
+			// is currently not allowed to arrays.
+			PR_ParseError("assignment not allowed to arrays");
+		}
+		*/
+	}
+	e2 = EX_GenExpression(n->b);
+	lx_SourceLine = n->line;
 
-		if (!op->name)
-		{ // Next token isn't at this priority level
-			break;
+	// Set types a, b, and c
+	type_a = e->type->type;
+	type_b = e2->type->type;
+	if (op->name[0] == '.')
+	{ // Field access gets type from field
+		if (e2->type->aux_type)
+		{
+			type_c = e2->type->aux_type->type;
 		}
+		else
+		{ // Not a field
+			type_c = ev_bad;
+		}
+	}
+	else
+	{
+		type_c = ev_void;
+	}
+
+	// Find the opcode that matches the types
+	tag = op->tag;
+	while ( type_a != op->type_a->type->type ||
+		type_b != op->type_b->type->type ||
+		(type_c != ev_void && type_c != op->type_c->type->type))
+	{
+		op++;
+		if (tag != op->tag)
+		{
+			op--;
+			PR_ParseError("type mismatch for %s", op->name);
+		}
+	}
+	if (type_a == ev_pointer && type_b != e->type->aux_type->type)
+	{
+		PR_ParseError("type mismatch for %s", op->name);
+	}
+
+	// Emit the statement
+	if (op->right_associative)
+	{
+		e = CO_GenCode(op, e2, e);
+	}
+	else
+	{
+		e = CO_GenCode(op, e, e2);
+	}
+
+	if (type_c != ev_void)
+	{ // Field access gets type from field
+		e->type = e2->type->aux_type;
 	}
 
 	return e;
@@ -250,32 +314,15 @@ def_t *EX_Expression (int priority)
 //
 //==========================================================================
 
-static def_t *Term (void)
+static int Term (void)
 {
-	def_t	*d, *e, *e2;
-	etype_t		t;
-	const char	*name;
+	int		d, e, e2;
+	int		name;
 
 	if (TK_CHECK(TK_NOT))
 	{
 		e = EX_Expression(NOT_PRIORITY);
-		t = e->type->type;
-		if (t == ev_float)
-			e2 = CO_GenCode(&pr_opcodes[OP_NOT_F], e, NULL);
-		else if (t == ev_string)
-			e2 = CO_GenCode(&pr_opcodes[OP_NOT_S], e, NULL);
-		else if (t == ev_entity)
-			e2 = CO_GenCode(&pr_opcodes[OP_NOT_ENT], e, NULL);
-		else if (t == ev_vector)
-			e2 = CO_GenCode(&pr_opcodes[OP_NOT_V], e, NULL);
-		else if (t == ev_function)
-			e2 = CO_GenCode(&pr_opcodes[OP_NOT_FNC], e, NULL);
-		else
-		{
-			e2 = NULL; // Shut up compiler warning
-			PR_ParseError("type mismatch for !");
-		}
-		return e2;
+		return TR_NewNode(PN_NOT, 0, e, 0, 0);
 	}
 
 	if (TK_CHECK(TK_LPAREN))
@@ -287,20 +334,81 @@ static def_t *Term (void)
 
 	if (pr_token_type == tt_immediate)
 	{
-		d = CO_ParseImmediate();
+		d = CO_NewImmediate();
 		LX_Fetch();
 		return d;
 	}
 
-	name = PR_ParseName();
-	if ((d = ParseIntrinsicFunc(name)) != NULL)
+	name = TR_NewString(PR_ParseName());
+	if ((d = ParseIntrinsicFunc(NODE_STRING(name))) != 0)
 	{ // Found and parsed an intrinsic function
-		d->referenceCount++;
-		if (d->parentVector != NULL)
-			d->parentVector->referenceCount++;
 		return d;
 	}
 
+	d = TR_NewNode(PN_NAME, 0, name, 0, 0);
+
+	if (TK_CHECK(TK_LBRACKET))
+	{
+		e = EX_Expression(TOP_PRIORITY);
+		LX_Require("]");
+
+		if (TK_TEST(TK_ASSIGN))
+		{
+			LX_Fetch();
+			e2 = EX_Expression(TOP_PRIORITY);
+			return TR_NewNode(PN_INDEXSTORE, 0, d, e, e2);
+		}
+
+		return TR_NewNode(PN_INDEX, 0, d, e, 0);
+	}
+	return d;
+}
+
+//==========================================================================
+//
+// GenNot
+//
+//==========================================================================
+
+static def_t *GenNot (pnode_t *n)
+{
+	def_t	*e, *e2;
+	etype_t		t;
+
+	e = EX_GenExpression(n->a);
+	lx_SourceLine = n->line;
+	t = e->type->type;
+	if (t == ev_float)
+		e2 = CO_GenCode(&pr_opcodes[OP_NOT_F], e, NULL);
+	else if (t == ev_string)
+		e2 = CO_GenCode(&pr_opcodes[OP_NOT_S], e, NULL);
+	else if (t == ev_entity)
+		e2 = CO_GenCode(&pr_opcodes[OP_NOT_ENT], e, NULL);
+	else if (t == ev_vector)
+		e2 = CO_GenCode(&pr_opcodes[OP_NOT_V], e, NULL);
+	else if (t == ev_function)
+		e2 = CO_GenCode(&pr_opcodes[OP_NOT_FNC], e, NULL);
+	else
+	{
+		e2 = NULL; // Shut up compiler warning
+		PR_ParseError("type mismatch for !");
+	}
+	return e2;
+}
+
+//==========================================================================
+//
+// GetName
+//
+//==========================================================================
+
+static def_t *GetName (pnode_t *n)
+{
+	def_t	*d;
+	const char	*name;
+
+	name = NODE_STRING(n->a);
+	lx_SourceLine = n->line;
 	d = PR_GetDef(NULL, name, pr_scope, false);
 	if (!d)
 	{
@@ -311,64 +419,112 @@ static def_t *Term (void)
 	if (d->parentVector != NULL)
 		d->parentVector->referenceCount++;
 
-	if (TK_CHECK(TK_LBRACKET))
+	return d;
+}
+
+//==========================================================================
+//
+// GenIndex
+//
+//==========================================================================
+
+static def_t *GenIndex (pnode_t *n)
+{
+	def_t	*d, *e, *e2;
+
+	d = GetName(NODE(n->a));
+	e = EX_GenExpression(n->b);
+	lx_SourceLine = n->line;
+
+	switch (d->type->type)
+	{
+	case ev_float:
+		e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_F], d, e);
+		break;
+	case ev_vector:
+		e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_V], d, e);
+		break;
+	case ev_string:
+		e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_S], d, e);
+		break;
+	case ev_entity:
+		e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_E], d, e);
+		break;
+	case ev_function:
+		e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_FNC], d, e);
+		break;
+	default:
+		e2 = NULL; // Shut up compiler warning
+		PR_ParseError("type mismatch for []");
+		break;
+	}
+	return e2;
+}
+
+//==========================================================================
+//
+// GenIndexStore
+//
+//==========================================================================
+
+static def_t *GenIndexStore (pnode_t *n)
+{
+	def_t	*d, *e2;
+
+	d = GetName(NODE(n->a));
+	EX_GenExpression(n->b);
+	e2 = EX_GenExpression(n->c);
+	lx_SourceLine = n->line;
+	//PR_ParseError("assignment is not allowed to arrays");
+
+	if (d->type->type != e2->type->type)
 	{
-		e = EX_Expression(TOP_PRIORITY);
-		LX_Require("]");
+		PR_ParseError("type mismatch for =");
+	}
+	return NULL;
+}
 
-		if (TK_TEST(TK_ASSIGN))
-		{
-			LX_Fetch();
-			e2 = EX_Expression(TOP_PRIORITY);
-			//PR_ParseError("assignment is not allowed to arrays");
+//==========================================================================
+//
+// ParseFunctionCall
+//
+//==========================================================================
 
-			if (d->type->type != e2->type->type)
-			{
-				PR_ParseError("type mismatch for =");
-			}
-			return NULL;
-		}
+static int ParseFunctionCall (int func)
+{
+	int		arg;
+	plist_t	args;
 
-		switch (d->type->type)
+	memset(&args, 0, sizeof(args));
+	if (!TK_CHECK(TK_RPAREN))
+	{
+		do
 		{
-		case ev_float:
-			e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_F], d, e);
-			break;
-		case ev_vector:
-			e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_V], d, e);
-			break;
-		case ev_string:
-			e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_S], d, e);
-			break;
-		case ev_entity:
-			e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_E], d, e);
-			break;
-		case ev_function:
-			e2 = CO_GenCode(&pr_opcodes[OP_FETCH_GBL_FNC], d, e);
-			break;
-		default:
-			e2 = NULL; // Shut up compiler warning
-			PR_ParseError("type mismatch for []");
-			break;
-		}
-		return e2;
+			arg = EX_Expression(TOP_PRIORITY);
+			TR_AddToList(&args, TR_NewNode(PN_EXPR, 0, arg, 0, 0));
+		} while (TK_CHECK(TK_COMMA));
+		LX_Require(")");
 	}
-	return d;
+	return TR_NewNode(PN_CALL, 0, func, args.first, 0);
 }
 
 //==========================================================================
 //
-// ParseFunctionCall
+// GenFunctionCall
 //
 //==========================================================================
 
-static def_t *ParseFunctionCall (def_t *func)
+static def_t *GenFunctionCall (pnode_t *n)
 {
+	def_t	*func;
 	def_t	*e;
 	def_t	*args[2];
 	int	argCount;
+	int	arg;
 	type_t	*t;
 
+	func = EX_GenExpression(n->a);
+	lx_SourceLine = n->line;
 	t = func->type;
 	if (t->type != ev_function)
 	{
@@ -384,64 +540,62 @@ static def_t *ParseFunctionCall (def_t *func)
 	argCount = 0;
 	args[0] = NULL;
 	args[1] = NULL;
-	if (!TK_CHECK(TK_RPAREN))
+	for (arg = n->b; arg; arg = NODE(arg)->next)
 	{
-		do
+		if (argCount == 8)
 		{
-			if (argCount == 8)
+			PR_ParseError("more than eight parameters");
+		}
+		if (t->num_parms != -1 && argCount >= t->num_parms)
+		{
+			PR_ParseError("too many parameters");
+		}
+		e = EX_GenExpression(arg);
+		lx_SourceLine = NODE(arg)->line;
+
+		if (argCount == 0 && func->name)
+		{ // Check for sound / model / file caching
+			if (!strncmp(func->name, "precache_sound", 14))
 			{
-				PR_ParseError("more than eight parameters");
+				PrecacheSound(e, func->name[14]);
 			}
-			if (t->num_parms != -1 && argCount >= t->num_parms)
+			else if (!strncmp(func->name, "precache_model", 14))
 			{
-				PR_ParseError("too many parameters");
-			}
-			e = EX_Expression(TOP_PRIORITY);
-
-			if (argCount == 0 && func->name)
-			{ // Check for sound / model / file caching
-				if (!strncmp(func->name, "precache_sound", 14))
-				{
-					PrecacheSound(e, func->name[14]);
-				}
-				else if (!strncmp(func->name, "precache_model", 14))
-				{
-					PrecacheModel(e, func->name[14]);
-				}
-				else if (!strncmp(func->name, "precache_file", 13))
-				{
-					PrecacheFile(e, func->name[13]);
-				}
+				PrecacheModel(e, func->name[14]);
 			}
-
-			if (t->num_parms != -1 && (e->type != t->parm_types[argCount]))
+			else if (!strncmp(func->name, "precache_file", 13))
 			{
-				PR_ParseError("type mismatch on parm %i", argCount);
+				PrecacheFile(e, func->name[13]);
 			}
+		}
 
-			def_parms[argCount].type = t->parm_types[argCount];
-			if (argCount < 2)
+		if (t->num_parms != -1 && (e->type != t->parm_types[argCount]))
+		{
+			PR_ParseError("type mismatch on parm %i", argCount);
+		}
+
+		def_parms[argCount].type = t->parm_types[argCount];
+		if (argCount < 2)
+		{
+			args[argCount] = e;
+		}
+		else
+		{
+			if (t->parm_types[argCount] == NULL ||		// Variable args
+			    t->parm_types[argCount]->type == ev_vector)
 			{
-				args[argCount] = e;
+				CO_GenCode(&pr_opcodes[OP_STORE_V], e,
+						&def_parms[argCount]);
 			}
 			else
 			{
-				if (t->parm_types[argCount] == NULL ||		// Variable args
-				    t->parm_types[argCount]->type == ev_vector)
-				{
-					CO_GenCode(&pr_opcodes[OP_STORE_V], e,
-							&def_parms[argCount]);
-				}
-				else
-				{
-					CO_GenCode(&pr_opcodes[OP_STORE_F], e,
-							&def_parms[argCount]);
-				}
+				CO_GenCode(&pr_opcodes[OP_STORE_F], e,
+						&def_parms[argCount]);
 			}
-			argCount++;
-		} while (TK_CHECK(TK_COMMA));
-		LX_Require(")");
+		}
+		argCount++;
 	}
+	lx_SourceLine = n->line;
 
 	if (t->num_parms != -1 && argCount != t->num_parms)
 	{
@@ -597,100 +751,109 @@ static void PrecacheFile (def_t *e, int ch)
 //
 //==========================================================================
 
-static def_t *ParseIntrinsicFunc (const char *name)
+static int ParseIntrinsicFunc (const char *name)
 {
-	def_t	*expr1, *expr2;
-
-	if (strcmp(name, "random") == 0)
-	{
-		LX_Require("(");
-		if (TK_CHECK(TK_RPAREN))
-		{
-			CO_GenCode(&pr_opcodes[OP_RAND0], NULL, NULL);
-		}
-		else
-		{
-			expr1 = EX_Expression(TOP_PRIORITY);
-			if (expr1->type->type != ev_float)
-			{
-				PR_ParseError("'random' : incompatible parameter type");
-			}
-			if (TK_CHECK(TK_COMMA))
-			{
-				expr2 = EX_Expression(TOP_PRIORITY);
-				if (expr2->type->type != ev_float)
-				{
-					PR_ParseError("'random' : incompatible parameter type");
-				}
-				LX_Require(")");
-				CO_GenCode(&pr_opcodes[OP_RAND2], expr1, expr2);
-			}
-			else
-			{
-				LX_Require(")");
-				CO_GenCode(&pr_opcodes[OP_RAND1], expr1, NULL);
-			}
-		}
-		def_ret.type = &type_float;
-		return &def_ret;
-	}
+	int		kind;
+	int		expr1, expr2;
+	int		count;
 
-	if (strcmp(name, "randomv") == 0)
+	if (strcmp(name, "random") == 0 || strcmp(name, "randomv") == 0)
 	{
+		kind = (name[6] == 'v') ? PN_RANDOMV : PN_RANDOM;
 		LX_Require("(");
-		if (TK_CHECK(TK_RPAREN))
-		{
-			CO_GenCode(&pr_opcodes[OP_RANDV0], NULL, NULL);
-		}
-		else
+		count = 0;
+		expr1 = expr2 = 0;
+		if (!TK_CHECK(TK_RPAREN))
 		{
 			expr1 = EX_Expression(TOP_PRIORITY);
-			if (expr1->type->type != ev_vector)
-			{
-				PR_ParseError("'randomv' : incompatible parameter type");
-			}
+			count = 1;
 			if (TK_CHECK(TK_COMMA))
 			{
 				expr2 = EX_Expression(TOP_PRIORITY);
-				if (expr2->type->type != ev_vector)
-				{
-					PR_ParseError("'randomv' : incompatible parameter type");
-				}
-				LX_Require(")");
-				CO_GenCode(&pr_opcodes[OP_RANDV2], expr1, expr2);
-			}
-			else
-			{
-				LX_Require(")");
-				CO_GenCode(&pr_opcodes[OP_RANDV1], expr1, NULL);
+				count = 2;
 			}
+			LX_Require(")");
 		}
-		def_ret.type = &type_vector;
-		return &def_ret;
+		return TR_NewNode(kind, count, expr1, expr2, 0);
 	}
 
 	if (!strncmp(name, "precache_file", 13) && !hcc_Compat_precache_file)	//keep it from going into progs.dat
 	{
-		def_ret.type = &type_void;
 		LX_Require("(");
-		if (TK_CHECK(TK_RPAREN))
-			return &def_ret;	//it's empty for some reason.
+		if (TK_CHECK(TK_RPAREN))	//it's empty for some reason.
+			return TR_NewNode(PN_PRECACHE_FILE, 0, 0, name[13], 0);
 		//i should be getting an immediate string here
 		if (pr_token_type != tt_immediate)	//oops
-			return NULL;
-		/*
-		expr1 = CO_ParseImmediate();
-		if (expr1->type->type != ev_string)
-			PR_ParseError("'precache_file' : parm not a string");
-		*/
+			return 0;
 		if (pr_immediate_type != &type_string)
 			PR_ParseError("'precache_file' : parm not a string");
-		PrecacheFileName(pr_immediate_string, name[13]);
+		expr1 = TR_NewString(pr_immediate_string);
 		LX_Fetch();
 		LX_Require(")");
-		return &def_ret;
+		return TR_NewNode(PN_PRECACHE_FILE, 1, expr1, name[13], 0);
 	}
 
-	return NULL;
+	return 0;
 }
 
+//==========================================================================
+//
+// GenIntrinsicFunc
+//
+//==========================================================================
+
+static def_t *GenIntrinsicFunc (pnode_t *n)
+{
+	def_t	*expr1, *expr2;
+	etype_t	type;
+	const char	*message;
+	int	base;
+
+	if (n->kind == PN_PRECACHE_FILE)
+	{
+		def_ret.type = &type_void;
+		if (n->op)
+		{
+			PrecacheFileName(NODE_STRING(n->a), n->b);
+		}
+		return &def_ret;
+	}
+
+	if (n->kind == PN_RANDOMV)
+	{
+		type = ev_vector;
+		message = "'randomv' : incompatible parameter type";
+		base = OP_RANDV0;
+	}
+	else
+	{
+		type = ev_float;
+		message = "'random' : incompatible parameter type";
+		base = OP_RAND0;
+	}
+
+	expr1 = expr2 = NULL;
+	if (n->op > 0)
+	{
+		expr1 = EX_GenExpression(n->a);
+		if (expr1->type->type != type)
+		{
+			lx_SourceLine = NODE(n->a)->line;
+			PR_ParseError("%s", message);
+		}
+	}
+	if (n->op > 1)
+	{
+		expr2 = EX_GenExpression(n->b);
+		if (expr2->type->type != type)
+		{
+			lx_SourceLine = NODE(n->b)->line;
+			PR_ParseError("%s", message);
+		}
+	}
+	lx_SourceLine = n->line;
+	CO_GenCode(&pr_opcodes[base+n->op], expr1, expr2);
+
+	def_ret.type = (type == ev_vector) ? &type_vector : &type_float;
+	return &def_ret;
+}
@@ -31,12 +31,17 @@
 #include "util_io.h"
 #include "crc.h"
 #include "hcc.h"
+#include "threads.h"
+#include "buildcache.h"
+#include "pathutil.h"
 #include "q_endian.h"
 #include "byteordr.h"
 #include "filenames.h"
 
 // MACROS ------------------------------------------------------------------
 
+#define TREE_CACHE_VERSION	"hcc tree 1"
+
 // TYPES -------------------------------------------------------------------
 
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
@@ -47,6 +52,7 @@
 
 static void PR_BeginCompilation (void);
 static qboolean PR_FinishCompilation (void);
+static void ParseSourceFiles (const char *cachefile, qboolean nocache, int wantthreads);
 
 // EXTERNAL DATA DECLARATIONS ----------------------------------------------
 
@@ -98,6 +104,14 @@ int			numfiles;
 static char	sourcedir[1024];
 static char	destfile[1024];
 
+// the files of the .src, in their order
+static int	numsrcfiles;
+static char	**srcnames;
+static char	**srctexts;
+static punit_t	*srcunits;
+static qboolean	*srccached;
+static int	nextsrcfile;	// for ParseThread()
+
 // CODE --------------------------------------------------------------------
 
 /*
@@ -951,7 +965,10 @@ void PR_ParseError (const char *error, ...)
 	q_vsnprintf (string, sizeof(string), error, argptr);
 	va_end (argptr);
 
-	printf ("%s(%d) : %s\n", strings+s_file, lx_SourceLine, string);
+	if (pr_parsing)	// CO_GenFile() prints it
+		TR_AddError (string);
+	else
+		printf ("%s(%d) : %s\n", strings+s_file, lx_SourceLine, string);
 
 	longjmp (pr_parse_abort, 1);
 }
@@ -976,6 +993,96 @@ void PR_ParseWarning (const char *error, ...)
 	printf ("%s(%d) : warning : %s\n", strings+s_file, lx_SourceLine, string);
 }
 
+/*
+==============
+ParseThread
+
+Parses the files that aren't parsed yet, one after the other.
+==============
+*/
+static void ParseThread (void *unused)
+{
+	int		i;
+
+	while (1)
+	{
+		ThreadLock ();
+		while (nextsrcfile < numsrcfiles && srccached[nextsrcfile])
+			nextsrcfile++;
+		i = nextsrcfile++;
+		ThreadUnlock ();
+		if (i >= numsrcfiles)
+			return;
+		CO_ParseFile (&srcunits[i], srctexts[i]);
+	}
+}
+
+/*
+==============
+ParseSourceFiles
+
+Makes the parse trees of the source files.  The cache keeps them by the
+text of the files, so only the files which changed since the last run
+are parsed.  The trees don't depend on each other, so the files can be
+parsed by several threads; the code is generated from the trees in the
+order of the files afterwards.
+==============
+*/
+static void ParseSourceFiles (const char *cachefile, qboolean nocache, int wantthreads)
+{
+	int		i, size;
+	char		**keys;
+	const void	*data;
+	void		*tree;
+	buildhash_t	hash;
+	char		hex[HASH_STRLEN];
+
+	srcunits = (punit_t *) SafeMalloc(numsrcfiles*sizeof(punit_t));
+	srccached = (qboolean *) SafeMalloc(numsrcfiles*sizeof(qboolean));
+	keys = (char **) SafeMalloc(numsrcfiles*sizeof(char *));
+
+	Cache_Load (cachefile);
+	for (i = 0; i < numsrcfiles; i++)
+	{
+		Hash_Init (&hash);
+		Hash_String (&hash, TREE_CACHE_VERSION);
+		Hash_Int (&hash, (int) sizeof(pnode_t));
+		Hash_Int (&hash, hcc_Compat_precache_file);
+		Hash_String (&hash, srctexts[i]);
+		Hash_Hex (&hash, hex);
+		keys[i] = (char *) SafeMalloc(4+HASH_STRLEN);
+		sprintf (keys[i], "hcc:%s", hex);
+
+		if (nocache)
+			continue;
+		data = Cache_Get (keys[i], &size);
+		if (data != NULL)
+			srccached[i] = TR_LoadUnit (&srcunits[i], data, size);
+	}
+
+#if USE_PARSETHREADS
+	if (wantthreads != 1)
+		InitThreads (wantthreads, 0);
+#endif
+	nextsrcfile = 0;
+	RunThreadsOn (ParseThread);
+
+	for (i = 0; i < numsrcfiles; i++)
+	{
+		if (!srccached[i])
+		{
+			tree = TR_SaveUnit (&srcunits[i], &size);
+			Cache_Set (keys[i], tree, size);
+			free (tree);
+		}
+		free (keys[i]);
+		free (srctexts[i]);
+	}
+	free (keys);
+	Cache_RemoveUnused ("hcc:");
+	Cache_Save ();
+}
+
 /*
 ============
 main
@@ -986,6 +1093,7 @@ int main (int argc, char **argv)
 	const char	*psrc;
 	void		*src, *src2;
 	char	filename[1024];
+	char	cachefile[1024];
 	char	*nameptr; /* filename[] without the parent sourcedir */
 	int		p, crc;
 	double	start, stop;
@@ -994,6 +1102,9 @@ int main (int argc, char **argv)
 	int		functionCount, functionSize;
 	int		fileInfo;
 	int		quiet;
+	int		nocache;
+	int		wantthreads;
+	int		i;
 
 	myargc = argc;
 	myargv = argv;
@@ -1013,6 +1124,8 @@ int main (int argc, char **argv)
 		printf(" -version <n>     : Output progs as version n (either 6 or 7)\n");
 		printf(" -v6              : Output progs as version 6\n");
 		printf(" -v7              : Output progs as version 7\n");
+		printf(" -threads <n>     : Parse the source files with n threads\n");
+		printf(" -nocache         : Parse all the source files again\n");
 		exit(0);
 	}
 
@@ -1082,6 +1195,10 @@ int main (int argc, char **argv)
 	LoadFile(filename, &src);
 	psrc = (char *) src;
 
+	strcpy (cachefile, filename);
+	StripExtension (cachefile);
+	strcat (cachefile, ".bcache");
+
 	psrc = COM_Parse(psrc);
 	if (!psrc)
 		COM_Error("No destination filename. hcc -help for info.");
@@ -1102,31 +1219,56 @@ int main (int argc, char **argv)
 
 	fileInfo = CheckParm("-fileinfo");
 	quiet = CheckParm("-quiet");
+	nocache = CheckParm("-nocache");
+
+	wantthreads = 1;
+	p = CheckParm("-threads");
+	if (p != 0)
+	{
+		if (p >= argc - 1)
+			COM_Error ("No num specified for -threads");
+		wantthreads = atoi(argv[p+1]);
+	}
 
 	InitData ();
 	LX_Init ();
 	CO_Init ();
 	EX_Init ();
 
+	// read the list of the files
+	while ((psrc = COM_Parse(psrc)) != NULL)
+	{
+		if ((numsrcfiles & 63) == 0)
+		{
+			srcnames = (char **) realloc(srcnames, (numsrcfiles+64)*sizeof(char *));
+			srctexts = (char **) realloc(srctexts, (numsrcfiles+64)*sizeof(char *));
+			if (!srcnames || !srctexts)
+				COM_Error ("out of memory for the source files");
+		}
+		srcnames[numsrcfiles] = (char *) SafeMalloc(strlen(com_token)+1);
+		strcpy (srcnames[numsrcfiles], com_token);
+		strcpy (nameptr, com_token);
+		LoadFile (filename, &src2);
+		srctexts[numsrcfiles] = (char *) src2;
+		numsrcfiles++;
+	}
+
+	// parse them, then compile them in order
+	ParseSourceFiles (cachefile, nocache, wantthreads);
+
 	PR_BeginCompilation();
 
-	// compile all the files
-	do
+	for (i = 0; i < numsrcfiles; i++)
 	{
-		psrc = COM_Parse(psrc);
-		if (!psrc)
-			break;
-
 		registerCount = numpr_globals;
 		statementCount = numstatements;
 		functionCount = numfunctions;
-		strcpy (nameptr, com_token);
 		if (!quiet)
-			printf("compiling %s\n", nameptr);
-		LoadFile (filename, &src2);
+			printf("compiling %s\n", srcnames[i]);
 
-		if (!CO_CompileFile((char *)src2, nameptr))
+		if (!CO_GenFile(&srcunits[i], srcnames[i]))
 			exit (1);
+		TR_FreeUnit(&srcunits[i]);
 		if (!quiet && fileInfo)
 		{
 			registerCount = numpr_globals-registerCount;
@@ -1140,7 +1282,7 @@ int main (int argc, char **argv)
 			printf("      functions: %10d (%10d bytes)\n", functionCount, functionSize);
 			printf("     total size: %10d bytes\n", registerSize+statementSize+functionSize);
 		}
-	} while (1);
+	}
 
 	if (!PR_FinishCompilation())
 		COM_Error ("compilation errors");
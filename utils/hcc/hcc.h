@@ -67,6 +67,26 @@
 #define TOP_PRIORITY		6
 #define NOT_PRIORITY		4
 
+// The lexer and the parser keep their state in globals: those are thread
+// local where the source files can be parsed by worker threads.  The code
+// generation always runs on the main thread.
+#if defined(USE_PTHREADS)
+#define USE_PARSETHREADS	1
+#define PARSE_THREADVAR		__thread
+#else
+#define USE_PARSETHREADS	0
+#define PARSE_THREADVAR
+#endif
+
+#define NODE(n)		(&pr_unit->nodes[n])
+#define NODE_STRING(o)	(pr_unit->strings + (o))
+#define NODE_TYPE(t)	(pr_unit->types[t])
+
+// Parse tree types, PR_ParseType() returns an index into the unit's
+// type table.  The simple types keep their etype_t as index.
+#define PT_UNION		5
+#define PT_FIRSTCOMPLEX		6
+
 // TYPES -------------------------------------------------------------------
 
 typedef int	gofs_t;
@@ -92,6 +112,7 @@ typedef struct def_s
 	int	initialized;	// 1 when a declaration included "= immediate"
 	int	referenceCount;
 	struct def_s	*parentVector;
+	int	listnum;	// position in the pr.def_head list
 } def_t;
 
 typedef union eval_s
@@ -132,6 +153,106 @@ typedef struct
 	int		tag;
 } opcode_t;
 
+// Parse tree nodes.  The children are node indices, 0 is no node.
+enum
+{
+	PN_NONE,
+	PN_ERROR,	// a: message, op: PE_ flags
+	PN_DEFS,	// a: type, b: declarators
+	PN_VAR,		// a: name, b: element count, c: initialization, op: INIT_
+	PN_CFUNC,	// a: name, b: function type, c: body, op: parsed
+	PN_FUNCTION,	// a: state, b: statements, c: parm names, op: has a body
+	PN_BUILTIN,	// op: builtin number
+	PN_STATE,	// a, b: frames, c: function name, op: opcode
+	PN_UNION,	// a: members, op: parsed
+	PN_STRUCT,	// a: field lists, op: parsed
+	PN_FIELDS,	// a: type, b: names
+	PN_IDENT,	// a: name
+	PN_BLOCK,	// a: statements
+	PN_EMPTY,
+	PN_RETURN,	// a: value
+	PN_LOOP,	// a: statement
+	PN_WHILE,	// a: condition, b: statement
+	PN_UNTIL,	// a: condition, b: statement
+	PN_DO,		// a: statement, b: condition, op: opcode
+	PN_IF,		// a: condition, b: statement, c: else, op: opcode
+	PN_ELSE,	// a: statement
+	PN_SWITCH,	// a: value, b: statement
+	PN_CASE,	// a: values
+	PN_CASEVALUE,	// a: value, b: end of range
+	PN_BREAK,
+	PN_CONTINUE,
+	PN_DEFAULT,
+	PN_THINKTIME,	// a: entity, b: time
+	PN_LOCAL,	// a: definitions
+	PN_EXPR,	// a: expression
+	PN_IMMEDIATE,	// a: string, b: bytes of value set, op: etype_t
+	PN_NAME,	// a: name
+	PN_INDEX,	// a: name, b: index
+	PN_INDEXSTORE,	// a: name, b: index, c: value
+	PN_NOT,		// a: operand
+	PN_BINARY,	// a, b: operands, op: opcode
+	PN_CALL,	// a: function, b: arguments
+	PN_RANDOM,	// a, b: arguments, op: argument count
+	PN_RANDOMV,	// a, b: arguments, op: argument count
+	PN_PRECACHE_FILE	// a: file name, b: block number char, op: has a name
+};
+
+// PN_ERROR flags: where the parse continued after the error
+#define PE_FIRST	1	// error while reading the first token
+#define PE_EOF		2	// the error recovery hit the end of the file
+#define PE_RESUMED	4	// the parse went on
+
+// PN_VAR initializations
+enum
+{
+	INIT_PARTIAL = -1,
+	INIT_NONE,
+	INIT_IMMEDIATE,
+	INIT_ARRAY,
+	INIT_FUNCTION
+};
+
+typedef struct
+{
+	int	kind;
+	int	op;
+	int	line;		// source line, for the code and the errors
+	int	a, b, c;
+	int	next;		// next node of a list
+	float	value[3];	// immediates
+} pnode_t;
+
+typedef struct
+{
+	etype_t	type;
+	int	aux_type;	// -1 = none
+	int	num_parms;
+	int	parm_types[MAX_PARMS];
+} ptype_t;
+
+typedef struct
+{
+	int	first, last;
+} plist_t;
+
+// The parse tree of a source file.  It doesn't refer to any def or type
+// of the compilation: CO_GenFile() resolves the names and the types when
+// it generates the code, so the trees of the files can be made in any
+// order and kept from one compilation to the next.
+typedef struct
+{
+	pnode_t	*nodes;
+	int	numnodes, maxnodes;
+	ptype_t	*ptypes;
+	int	numptypes, maxptypes;
+	char	*strings;
+	int	strofs, maxstrings;
+	plist_t	top;		// the definitions of the file
+	int	endimmediate;	// the lexer's immediate at the end of the file
+	type_t	**types;	// the ptypes, as PR_FindType() has them
+} punit_t;
+
 typedef enum
 {
 	tt_eof,
@@ -205,24 +326,42 @@ void	LX_NewLine (void);
 void	LX_ErrorRecovery (void);
 
 type_t	*PR_FindType (type_t *type);
-type_t	*PR_ParseType (void);
+int	PR_ParseType (void);
 const char	*PR_ParseName (void);
 
 // comp.c
 void	CO_Init (void);
-qboolean CO_CompileFile (const char *fileText, const char *fileName);
+void	CO_ParseFile (punit_t *unit, const char *fileText);
+qboolean CO_GenFile (punit_t *unit, const char *fileName);
 def_t	*CO_GenCode (opcode_t *op, def_t *var_a, def_t *var_b);
 void	CO_GenCodeDirect (opcode_t *op, def_t *var_a, def_t *var_b, def_t *var_c);
 def_t	*CO_ParseImmediate (void);
-void	CO_ParseDefs (void);
+int	CO_NewImmediate (void);
+def_t	*CO_GenImmediate (int node);
+void	CO_ParseDefs (plist_t *list);
+void	CO_GenDefs (int node);
 def_t	*PR_GetDef (type_t *type, const char *name, def_t *scope, qboolean allocate);
 
 // expr.c
 void	EX_Init (void);
-def_t	*EX_Expression (int priority);
+int	EX_Expression (int priority);
+def_t	*EX_GenExpression (int node);
 
 // stmt.c
-void	ST_ParseStatement (void);
+int	ST_ParseStatement (void);
+void	ST_GenStatement (int node);
+
+// tree.c
+void	TR_InitUnit (punit_t *unit);
+void	TR_FreeUnit (punit_t *unit);
+int	TR_NewNode (int kind, int op, int a, int b, int c);
+void	TR_AddToList (plist_t *list, int node);
+int	TR_NewString (const char *str);
+int	TR_NewType (const ptype_t *type);
+void	TR_AddError (const char *message);
+void	TR_ResolveTypes (void);
+void	*TR_SaveUnit (const punit_t *unit, int *size);
+qboolean TR_LoadUnit (punit_t *unit, const void *data, int size);
 
 
 // PUBLIC DATA DECLARATIONS ------------------------------------------------
@@ -251,22 +390,26 @@ extern	opcode_t	pr_opcodes[128];	// sized by initialization
 
 extern	def_t	*pr_global_defs[MAX_REGS];	// to find def for a global variable
 
-extern	int	pr_tokenclass;
-extern	char		pr_token[2048];
-extern	token_type_t	pr_token_type;
-extern	type_t		*pr_immediate_type;
-extern	eval_t		pr_immediate;
+extern	PARSE_THREADVAR int	pr_tokenclass;
+extern	PARSE_THREADVAR char		pr_token[2048];
+extern	PARSE_THREADVAR token_type_t	pr_token_type;
+extern	PARSE_THREADVAR type_t		*pr_immediate_type;
+extern	PARSE_THREADVAR eval_t		pr_immediate;
 
 extern	int	locals_end;	// for tracking local variables vs temps
 
-extern	jmp_buf	pr_parse_abort;	// longjump with this on parse error
+extern	PARSE_THREADVAR jmp_buf	pr_parse_abort;	// longjump with this on parse error
+
+extern	PARSE_THREADVAR int	lx_SourceLine;
+extern	PARSE_THREADVAR int	lx_ImmediateBytes;
 
-extern	int	lx_SourceLine;
+extern	PARSE_THREADVAR punit_t	*pr_unit;	// the tree being parsed or compiled
+extern	PARSE_THREADVAR qboolean pr_parsing;	// errors go into pr_unit
 
 extern	def_t	*pr_scope;
 extern	int	pr_error_count;
 
-extern	char	pr_parm_names[MAX_PARMS][MAX_NAME];
+extern	PARSE_THREADVAR char	pr_parm_names[MAX_PARMS][MAX_NAME];
 
 extern	string_t	s_file;	// filename for function definition
 
@@ -285,7 +428,7 @@ extern	int		numfunctions;
 extern	float		*pr_globals;	/* [MAX_REGS] */
 extern	int		numpr_globals;
 
-extern	char	pr_immediate_string[2048];
+extern	PARSE_THREADVAR char	pr_immediate_string[2048];
 
 extern	char	precache_sounds[MAX_SOUNDS][MAX_DATA_PATH];
 extern	int	precache_sounds_block[MAX_SOUNDS];
@@ -49,36 +49,55 @@ struct hash_element
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
 static void InitHashTable(void);
-static void ParseUnion(void);
-static type_t *ParseUnionType(void);
-static void ParseFunctionDef(def_t *def, type_t *type);
-static void ParseCStyleFunctionDef(const char *funcName, type_t *type);
-static def_t *GetArrayDef(const char *name, type_t *type, int *elementCount);
-static def_t *GetFieldArrayDef(const char *name, type_t *type, int *elementCount);
-static int ParseArray(const char *name, type_t *type);
+static void ParseFile(const char *fileText);
+static void MarkError(int flags);
+static qboolean GenError(pnode_t *n);
+static void ParseUnion(plist_t *list);
+static int ParseUnionType(void);
+static void GenUnion(pnode_t *n);
+static int ParseFunctionDef(int type);
+static void GenFunctionDef(def_t *def, type_t *type, int body);
+static void ParseCStyleFunctionDef(int defs, plist_t *decls, int funcName, int type);
+static void GenCStyleFunctionDef(pnode_t *n);
+static void GenVarDef(pnode_t *n, type_t *type);
+static def_t *GetArrayDef(const char *name, type_t *type, int count);
+static def_t *GetFieldArrayDef(const char *name, type_t *type, int count);
+static int ParseArray(int type);
 static def_t *NewVarDef(const char *name, type_t *type);
-static function_t *ParseImmediateStatements(type_t *type);
-static void ParseState(void);
+static void LinkDef(def_t *def);
+static void AddConstant(def_t *def);
+static def_t *FindConstant(void);
+static void LoadImmediate(int node);
+static int ParseImmediateStatements(int type);
+static function_t *GenImmediateStatements(type_t *type, int node);
+static int ParseState(void);
+static void GenState(int node);
 
 // EXTERNAL DATA DECLARATIONS ----------------------------------------------
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
-static int FrameIndex;
+static PARSE_THREADVAR int FrameIndex;
+static PARSE_THREADVAR qboolean InFunction;	// the parse is in a function body
 static struct hash_element *HashTable[HASH_TABLE_SIZE];
+static struct hash_element *ConstTable[HASH_TABLE_SIZE];
+static int NumDefs;
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 pr_info_t pr;
 def_t *pr_global_defs[MAX_REGS];	// to find def for a global variable
 
-def_t *pr_scope;	// the function being parsed, or NULL
+def_t *pr_scope;	// the function being compiled, or NULL
 
 string_t s_file;	// filename for function definition
 
 int locals_end;		// for tracking local variables vs temps
 
-jmp_buf pr_parse_abort;	// longjump with this on parse error
+PARSE_THREADVAR jmp_buf pr_parse_abort;	// longjump with this on parse error
+
+PARSE_THREADVAR punit_t *pr_unit;	// the tree being parsed or compiled
+PARSE_THREADVAR qboolean pr_parsing;	// errors go into pr_unit
 
 opcode_t pr_opcodes[] =
 {
@@ -255,21 +274,46 @@ void CO_Init(void)
 static void InitHashTable (void)
 {
 	memset(HashTable, 0, sizeof(HashTable));
+	memset(ConstTable, 0, sizeof(ConstTable));
+}
+
+//==========================================================================
+//
+// CO_ParseFile
+//
+// Parses a source file into a tree, for CO_GenFile() to compile.  The
+// parse keeps no state of the compilation, a worker thread can run it.
+//
+//==========================================================================
+
+void CO_ParseFile (punit_t *unit, const char *fileText)
+{
+	TR_InitUnit(unit);
+	pr_unit = unit;
+	pr_parsing = true;
+	ParseFile(fileText);
+	unit->endimmediate = CO_NewImmediate();
+	pr_parsing = false;
+	pr_unit = NULL;
 }
 
 //==========================================================================
 //
-// CO_CompileFile
+// ParseFile
+//
+// Goes through the file like the code generation will go through its
+// tree: the errors stop the parse where they will stop the compilation.
 //
 //==========================================================================
 
-qboolean CO_CompileFile (const char *fileText, const char *fileName)
+static void ParseFile (const char *fileText)
 {
 	volatile qboolean	inProgress;
+	volatile int	errors;
 
 	FrameIndex = -1;
 	inProgress = false;
-	s_file = CopyString(fileName);
+	errors = 0;
 
 	// Ugly hack to prevent longjmp failure from within
 	// LX_NewSourceFile().
@@ -278,9 +322,11 @@ qboolean CO_CompileFile (const char *fileText, const char *fileName)
 		LX_ErrorRecovery();
 		if (pr_token_type == tt_eof)
 		{
-			return false;
+			MarkError(PE_FIRST|PE_EOF);
+			return;
 		}
-		pr_error_count++;
+		MarkError(PE_FIRST|PE_RESUMED);
+		errors++;
 		inProgress = true;
 	}
 
@@ -290,6 +336,68 @@ qboolean CO_CompileFile (const char *fileText, const char *fileName)
 	}
 
 	while (pr_token_type != tt_eof)
+	{
+		if (setjmp(pr_parse_abort))
+		{
+			if (++errors >= MAX_ERRORS)
+			{
+				return;
+			}
+			LX_ErrorRecovery();
+			if (pr_token_type == tt_eof)
+			{
+				MarkError(PE_EOF);
+				return;
+			}
+			MarkError(PE_RESUMED);
+		}
+		InFunction = false;
+		CO_ParseDefs(&pr_unit->top);
+	}
+}
+
+//==========================================================================
+//
+// MarkError
+//
+// Notes how the parse went on after the last error.  The errors before
+// the first token are all the file has yet.
+//
+//==========================================================================
+
+static void MarkError (int flags)
+{
+	int		node;
+
+	if (flags & PE_FIRST)
+	{
+		for (node = pr_unit->top.first; node; node = NODE(node)->next)
+		{
+			NODE(node)->op = PE_FIRST;
+		}
+	}
+	NODE(pr_unit->top.last)->op |= flags;
+}
+
+//==========================================================================
+//
+// CO_GenFile
+//
+// Compiles the tree of a source file.
+//
+//==========================================================================
+
+qboolean CO_GenFile (punit_t *unit, const char *fileName)
+{
+	volatile int	node;
+	pnode_t	*n;
+
+	pr_unit = unit;
+	s_file = CopyString(fileName);
+	TR_ResolveTypes();
+
+	node = unit->top.first;
+	while (node)
 	{
 		if (setjmp(pr_parse_abort))
 		{
@@ -298,18 +406,65 @@ qboolean CO_CompileFile (const char *fileText, const char *fileName)
 				printf("stopped at %d errors\n", pr_error_count);
 				return false;
 			}
-			LX_ErrorRecovery();
-			if (pr_token_type == tt_eof)
+			node = NODE(node)->next;
+			continue;
+		}
+		n = NODE(node);
+		if (n->kind == PN_ERROR)
+		{
+			if (!GenError(n))
 			{
 				return false;
 			}
 		}
-		pr_scope = NULL;
-		CO_ParseDefs();
+		else
+		{
+			pr_scope = NULL;
+			CO_GenDefs(node);
+		}
+		node = NODE(node)->next;
 	}
+	LoadImmediate(unit->endimmediate);
 	return (pr_error_count == 0);
 }
 
+//==========================================================================
+//
+// GenError
+//
+// Reports a parse error.  Returns false where the compilation of the
+// file stops.
+//
+//==========================================================================
+
+static qboolean GenError (pnode_t *n)
+{
+	lx_SourceLine = n->line;
+	printf("%s(%d) : %s\n", strings+s_file, n->line, NODE_STRING(n->a));
+	if (n->op & PE_FIRST)
+	{
+		if (n->op & PE_EOF)
+		{
+			return false;
+		}
+		if (n->op & PE_RESUMED)
+		{
+			pr_error_count++;
+		}
+		return true;
+	}
+	if (++pr_error_count >= MAX_ERRORS)
+	{
+		printf("stopped at %d errors\n", pr_error_count);
+		return false;
+	}
+	if (n->op & PE_EOF)
+	{
+		return false;
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // CO_GenCode
@@ -386,6 +541,165 @@ void CO_GenCodeDirect (opcode_t *op, def_t *var_a, def_t *var_b, def_t *var_c)
 	statement->c = var_c ? var_c->ofs : 0;
 }
 
+//==========================================================================
+//
+// LinkDef
+//
+// Appends a new def to the def list.
+//
+//==========================================================================
+
+static void LinkDef (def_t *def)
+{
+	def->next = NULL;
+	def->listnum = NumDefs++;
+	pr.def_tail->next = def;
+	pr.def_tail = def;
+}
+
+//==========================================================================
+//
+// ConstHash
+//
+// Hashes a string, float or vector value so that the values that compare
+// equal (0 and -0) hash the same.
+//
+//==========================================================================
+
+static int ConstHash (etype_t type, const void *value)
+{
+	unsigned int	hash;
+	const unsigned char	*s;
+	float	v[3];
+	int		i, n;
+
+	hash = 2166136261U;
+	if (type == ev_string)
+	{
+		for (s = (const unsigned char *) value; *s; s++)
+			hash = (hash ^ *s) * 16777619U;
+		return hash % HASH_TABLE_SIZE;
+	}
+
+	n = (type == ev_vector) ? 3 : 1;
+	for (i = 0; i < n; i++)
+	{
+		v[i] = ((const float *) value)[i];
+		if (v[i] == 0)
+			v[i] = 0;
+		s = (const unsigned char *) &v[i];
+		hash = (hash ^ s[0]) * 16777619U;
+		hash = (hash ^ s[1]) * 16777619U;
+		hash = (hash ^ s[2]) * 16777619U;
+		hash = (hash ^ s[3]) * 16777619U;
+	}
+	return hash % HASH_TABLE_SIZE;
+}
+
+//==========================================================================
+//
+// AddConstant
+//
+// Enters an initialized def into the table FindConstant searches.
+//
+//==========================================================================
+
+static void AddConstant (def_t *def)
+{
+	struct hash_element *cell;
+	etype_t	type;
+	int		idx;
+
+	if (!hcc_OptimizeImmediates)
+	{
+		return;
+	}
+	type = def->type->type;
+	if (type == ev_string)
+	{
+		idx = ConstHash(type, G_STRING(def->ofs));
+	}
+	else if (type == ev_float || type == ev_vector)
+	{
+		idx = ConstHash(type, &G_FLOAT(def->ofs));
+	}
+	else
+	{
+		return;
+	}
+
+	cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
+	cell->next = ConstTable[idx];
+	cell->def = def;
+	ConstTable[idx] = cell;
+}
+
+//==========================================================================
+//
+// FindConstant
+//
+// Returns the initialized def with the value of the immediate that comes
+// first in the def list, which is the one a search of the whole list
+// would find, or NULL.
+//
+//==========================================================================
+
+static def_t *FindConstant (void)
+{
+	struct hash_element *cell;
+	def_t	*cn, *best;
+	int		idx;
+
+	if (pr_immediate_type == &type_string)
+	{
+		idx = ConstHash(ev_string, pr_immediate_string);
+	}
+	else
+	{
+		idx = ConstHash(pr_immediate_type->type, &pr_immediate);
+	}
+
+	best = NULL;
+	for (cell = ConstTable[idx]; cell != NULL; cell = cell->next)
+	{
+		cn = cell->def;
+		if (cn->type != pr_immediate_type)
+		{
+			continue;
+		}
+		if (best != NULL && best->listnum < cn->listnum)
+		{
+			continue;
+		}
+		if (pr_immediate_type == &type_string)
+		{
+			if (STRCMP(G_STRING(cn->ofs), pr_immediate_string))
+			{
+				continue;
+			}
+		}
+		else if (pr_immediate_type == &type_float)
+		{
+			if (G_FLOAT(cn->ofs) != pr_immediate._float)
+			{
+				continue;
+			}
+		}
+		else
+		{
+			if ((G_FLOAT(cn->ofs) != pr_immediate.vector[0])
+				|| (G_FLOAT(cn->ofs+1) != pr_immediate.vector[1])
+				|| (G_FLOAT(cn->ofs+2) != pr_immediate.vector[2]))
+			{
+				continue;
+			}
+		}
+		best = cn;
+	}
+
+	return best;
+}
+
 //==========================================================================
 //
 // CO_ParseImmediate
@@ -461,59 +775,20 @@ def_t *CO_ParseImmediate (void)
 
 	if (hcc_OptimizeImmediates)
 	{	// Check for a constant with the same value
-		for (cn = pr.def_head.next; cn; cn = cn->next)
+		cn = FindConstant();
+		if (cn != NULL)
 		{
-			if (!cn->initialized || (cn->type != pr_immediate_type))
-			{
-				continue;
-			}
-			if (pr_immediate_type == &type_string)
-			{
-				if (!STRCMP(G_STRING(cn->ofs), pr_immediate_string))
-				{
-					cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
-					cell->next = HashTable[idx];
-					cell->def = cn;
-					HashTable[idx] = cell;
-					return cn;
-				}
-			}
-			else if (pr_immediate_type == &type_float)
-			{
-				if (G_FLOAT(cn->ofs) == pr_immediate._float)
-				{
-					cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
-					cell->next = HashTable[idx];
-					cell->def = cn;
-					HashTable[idx] = cell;
-					return cn;
-				}
-			}
-			else if (pr_immediate_type == &type_vector)
-			{
-				if ((G_FLOAT(cn->ofs) == pr_immediate.vector[0])
-					&& ( G_FLOAT(cn->ofs+1) == pr_immediate.vector[1])
-					&& ( G_FLOAT(cn->ofs+2) == pr_immediate.vector[2]))
-				{
-					cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
-					cell->next = HashTable[idx];
-					cell->def = cn;
-					HashTable[idx] = cell;
-					return cn;
-				}
-			}
-			else
-			{
-				PR_ParseError("weird immediate type");
-			}
+			cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
+			cell->next = HashTable[idx];
+			cell->def = cn;
+			HashTable[idx] = cell;
+			return cn;
 		}
 	}
 
 	// Allocate a new one
 	cn = (def_t *) SafeMalloc(sizeof(def_t));
-	cn->next = NULL;
-	pr.def_tail->next = cn;
-	pr.def_tail = cn;
+	LinkDef(cn);
 
 	cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
 	cell->next = HashTable[idx];
@@ -534,10 +809,87 @@ def_t *CO_ParseImmediate (void)
 		pr_immediate.string = CopyString(pr_immediate_string);
 	}
 	memcpy(pr_globals+cn->ofs, &pr_immediate, 4*type_size[pr_immediate_type->type]);
+	AddConstant(cn);
 
 	return cn;
 }
 
+//==========================================================================
+//
+// CO_NewImmediate
+//
+// Takes the lexer's immediate into the parse tree, for CO_GenImmediate().
+// Only the bytes of pr_immediate the lexer set since the last immediate
+// node go in: the others keep what the code generation left there, like
+// the strings CO_ParseImmediate() allocates.  The type is ev_bad when
+// the file didn't set one yet.
+//
+//==========================================================================
+
+int CO_NewImmediate (void)
+{
+	int		node;
+	int		type;
+	int		str;
+
+	type = ev_bad;
+	str = 0;
+	if (pr_immediate_type != NULL)
+	{
+		type = pr_immediate_type->type;
+		if (type == ev_string)
+		{
+			str = TR_NewString(pr_immediate_string);
+		}
+	}
+	node = TR_NewNode(PN_IMMEDIATE, type, str, lx_ImmediateBytes, 0);
+	memcpy(NODE(node)->value, &pr_immediate, lx_ImmediateBytes);
+	lx_ImmediateBytes = 0;
+	return node;
+}
+
+//==========================================================================
+//
+// LoadImmediate
+//
+// Puts an immediate of the parse tree back into the lexer's globals.
+//
+//==========================================================================
+
+static void LoadImmediate (int node)
+{
+	pnode_t	*n;
+
+	n = NODE(node);
+	lx_SourceLine = n->line;
+	switch (n->op)
+	{
+	case ev_string:
+		pr_immediate_type = &type_string;
+		strcpy(pr_immediate_string, NODE_STRING(n->a));
+		break;
+	case ev_float:
+		pr_immediate_type = &type_float;
+		break;
+	case ev_vector:
+		pr_immediate_type = &type_vector;
+		break;
+	}
+	memcpy(&pr_immediate, n->value, n->b);
+}
+
+//==========================================================================
+//
+// CO_GenImmediate
+//
+//==========================================================================
+
+def_t *CO_GenImmediate (int node)
+{
+	LoadImmediate(node);
+	return CO_ParseImmediate();
+}
+
 //==========================================================================
 //
 // ParseState
@@ -551,31 +903,30 @@ def_t *CO_ParseImmediate (void)
 //
 //==========================================================================
 
-static void ParseState (void)
+static int ParseState (void)
 {
-	const char	*name;
-	def_t	*def;
-	def_t	*s1, *s2;
-	int	frame1, frame2;
-	int	direction;
+	int		name;
+	int		s1, s2;
+	int		frame1, frame2;
+	int		direction;
 	qboolean	weapon;
 
 	if (pr_token_type == tt_name)
 	{
 		FrameIndex++;
 
-		// Stuff a float for CO_ParseImmediate()
+		// Stuff a float for CO_NewImmediate()
 		pr_token_type = tt_immediate;
 		pr_immediate_type = &type_float;
 		pr_immediate._float = (float)FrameIndex;
-		s1 = CO_ParseImmediate();
+		if (lx_ImmediateBytes < 4)
+			lx_ImmediateBytes = 4;
+		s1 = CO_NewImmediate();
 
 		pr_token_type = tt_name;
-		name = PR_ParseName();
-		def = PR_GetDef(&type_function, name, NULL, true);
+		name = TR_NewString(PR_ParseName());
 		LX_Require("]");
-		CO_GenCode(&pr_opcodes[OP_STATE], s1, def);
-		return;
+		return TR_NewNode(PN_STATE, OP_STATE, s1, 0, name);
 	}
 	else if (pr_tokenclass == TK_INC || pr_tokenclass == TK_DEC)
 	{
@@ -601,7 +952,7 @@ static void ParseState (void)
 			PR_ParseError("state frame must be a number");
 		}
 		frame1 = (int)pr_immediate._float;
-		s1 = CO_ParseImmediate();
+		s1 = CO_NewImmediate();
 		LX_Fetch();
 		LX_Require("..");
 		if (pr_token_type != tt_immediate
@@ -610,7 +961,7 @@ static void ParseState (void)
 			PR_ParseError("state frame must be a number");
 		}
 		frame2 = (int)pr_immediate._float;
-		s2 = CO_ParseImmediate();
+		s2 = CO_NewImmediate();
 		LX_Fetch();
 		if (direction == TK_INC)
 		{
@@ -624,45 +975,124 @@ static void ParseState (void)
 			PR_ParseError("bad frame order in state cycle");
 		}
 		LX_Require("]");
-		if (weapon == true)
-		{
-			CO_GenCode(&pr_opcodes[OP_CWSTATE], s1, s2);
-		}
-		else
+		return TR_NewNode(PN_STATE, weapon ? OP_CWSTATE : OP_CSTATE, s1, s2, 0);
+	}
+
+	if (pr_token_type != tt_immediate
+		|| pr_immediate_type != &type_float)
+	{
+		PR_ParseError("state frame must be a number");
+	}
+	FrameIndex = (int)pr_immediate._float;
+	s1 = CO_NewImmediate();
+	LX_Fetch();
+	if (pr_tokenclass == TK_COMMA)
+	{
+		LX_Fetch();
+	}
+	name = TR_NewString(PR_ParseName());
+
+	LX_Require("]");
+	return TR_NewNode(PN_STATE, OP_STATE, s1, 0, name);
+}
+
+//==========================================================================
+//
+// GenState
+//
+//==========================================================================
+
+static void GenState (int node)
+{
+	pnode_t	*n;
+	def_t	*def;
+	def_t	*s1, *s2;
+
+	n = NODE(node);
+	s1 = CO_GenImmediate(n->a);
+	if (n->op == OP_STATE)
+	{
+		lx_SourceLine = n->line;
+		def = PR_GetDef(&type_function, NODE_STRING(n->c), NULL, true);
+		CO_GenCode(&pr_opcodes[OP_STATE], s1, def);
+		return;
+	}
+	s2 = CO_GenImmediate(n->b);
+	lx_SourceLine = n->line;
+	CO_GenCode(&pr_opcodes[n->op], s1, s2);
+}
+
+//==========================================================================
+//
+// ParseImmediateStatements
+//
+//==========================================================================
+
+static int ParseImmediateStatements (int type)
+{
+	int		i;
+	int		node;
+	int		state;
+	plist_t	parms;
+	plist_t	body;
+
+	// Check for builtin function definition
+	if (TK_CHECK(TK_COLON))
+	{
+		if (pr_token_type != tt_immediate
+			|| pr_immediate_type != &type_float
+			|| pr_immediate._float != (int)pr_immediate._float)
 		{
-			CO_GenCode(&pr_opcodes[OP_CSTATE], s1, s2);
+			PR_ParseError("bad builtin immediate");
 		}
-		return;
+		node = TR_NewNode(PN_BUILTIN, (int)pr_immediate._float, 0, 0, 0);
+		LX_Fetch();
+		return node;
 	}
 
-	if (pr_token_type != tt_immediate
-		|| pr_immediate_type != &type_float)
+	// Keep the names of the parms
+	memset(&parms, 0, sizeof(parms));
+	for (i = 0; i < pr_unit->ptypes[type].num_parms; i++)
 	{
-		PR_ParseError("state frame must be a number");
+		TR_AddToList(&parms, TR_NewNode(PN_IDENT, 0,
+					TR_NewString(pr_parm_names[i]), 0, 0));
 	}
-	FrameIndex = (int)pr_immediate._float;
-	s1 = CO_ParseImmediate();
-	LX_Fetch();
-	if (pr_tokenclass == TK_COMMA)
+
+	// Check for a state opcode
+	state = 0;
+	if (TK_CHECK(TK_LBRACKET))
+	{
+		state = ParseState();
+	}
+
+	// Check for regular statements
+	if (TK_CHECK(TK_LBRACE))
 	{
+		memset(&body, 0, sizeof(body));
+		while (pr_tokenclass != TK_RBRACE)
+		{
+			TR_AddToList(&body, ST_ParseStatement());
+		}
+		node = TR_NewNode(PN_FUNCTION, true, state, body.first, parms.first);
 		LX_Fetch();
+		return node;
 	}
-	name = PR_ParseName();
-	def = PR_GetDef(&type_function, name, NULL, true);
 
-	LX_Require("]");
-	CO_GenCode(&pr_opcodes[OP_STATE], s1, def);
+	return TR_NewNode(PN_FUNCTION, false, state, 0, parms.first);
 }
 
 //==========================================================================
 //
-// ParseImmediateStatements
+// GenImmediateStatements
 //
 //==========================================================================
 
-static function_t *ParseImmediateStatements (type_t *type)
+static function_t *GenImmediateStatements (type_t *type, int node)
 {
 	int		i;
+	int		parm;
+	int		statement;
+	pnode_t	*n;
 	function_t	*f;
 	def_t	*defs[MAX_PARMS];
 	def_t	*scopeDef;
@@ -670,26 +1100,21 @@ static function_t *ParseImmediateStatements (type_t *type)
 
 	f = (function_t *) SafeMalloc(sizeof(function_t));
 
-	// Check for builtin function definition
-	if (TK_CHECK(TK_COLON))
+	n = NODE(node);
+	if (n->kind == PN_BUILTIN)
 	{
-		if (pr_token_type != tt_immediate
-			|| pr_immediate_type != &type_float
-			|| pr_immediate._float != (int)pr_immediate._float)
-		{
-			PR_ParseError("bad builtin immediate");
-		}
-		f->builtin = (int)pr_immediate._float;
-		LX_Fetch();
+		f->builtin = n->op;
 		return f;
 	}
 
 	f->builtin = 0;
 
 	// Define the parms
-	for (i = 0; i < type->num_parms; i++)
+	parm = n->c;
+	for (i = 0; i < type->num_parms; i++, parm = NODE(parm)->next)
 	{
-		defs[i] = PR_GetDef(type->parm_types[i], pr_parm_names[i], pr_scope, true);
+		lx_SourceLine = NODE(parm)->line;
+		defs[i] = PR_GetDef(type->parm_types[i], NODE_STRING(NODE(parm)->a), pr_scope, true);
 		f->parm_ofs[i] = defs[i]->ofs;
 		if (i > 0 && f->parm_ofs[i] < f->parm_ofs[i-1])
 		{
@@ -700,24 +1125,25 @@ static function_t *ParseImmediateStatements (type_t *type)
 	f->code = numstatements;
 
 	// Check for a state opcode
-	if (TK_CHECK(TK_LBRACKET))
+	if (n->a)
 	{
-		ParseState();
+		GenState(n->a);
 	}
 
 	// Check for regular statements
 	st_ReturnType = type->aux_type;
 	st_ReturnParsed = false;
-	if (TK_CHECK(TK_LBRACE))
+	if (n->op)
 	{
 		scopeDef = pr_scope;
 		searchDef = pr.def_tail;
 
-		while (pr_tokenclass != TK_RBRACE)
+		for (statement = n->b; statement; statement = NODE(statement)->next)
 		{
-			ST_ParseStatement();
+			ST_GenStatement(statement);
 		}
 
+		lx_SourceLine = n->line;
 		while ((searchDef = searchDef->next) != NULL)
 		{
 			if (searchDef->scope == scopeDef
@@ -731,12 +1157,14 @@ static function_t *ParseImmediateStatements (type_t *type)
 		{
 			PR_ParseError("missing return");
 		}
-
-		LX_Fetch();
 	}
-	else if (type->aux_type->type != ev_void && st_ReturnParsed == false)
+	else
 	{
-		PR_ParseError("missing return");
+		lx_SourceLine = n->line;
+		if (type->aux_type->type != ev_void && st_ReturnParsed == false)
+		{
+			PR_ParseError("missing return");
+		}
 	}
 
 	// Emit an end of statements opcode
@@ -818,9 +1246,7 @@ def_t *PR_GetDef (type_t *type, const char *name, def_t *scope, qboolean allocat
 
 	// Allocate a new def
 	def = (def_t *) SafeMalloc(sizeof(def_t));
-	def->next = NULL;
-	pr.def_tail->next = def;
-	pr.def_tail = def;
+	LinkDef(def);
 
 	// Add to hash table
 	cell = (struct hash_element *) SafeMalloc(sizeof(struct hash_element));
@@ -878,61 +1304,68 @@ def_t *PR_GetDef (type_t *type, const char *name, def_t *scope, qboolean allocat
 //
 // CO_ParseDefs
 //
+// Adds the definitions to list as they are parsed: after an error, the
+// code generation still declares what came before it.
+//
 //==========================================================================
 
-void CO_ParseDefs (void)
+void CO_ParseDefs (plist_t *list)
 {
 	int		i;
-	const char	*name;
-	def_t	*def;
-	type_t	*type;
-	int	elementCount;
-	gofs_t	offset;
+	int		type;
+	etype_t	etype;
+	int		name;
+	int		defs;
+	int		var;
+	int		init;
+	int		elementCount;
+	plist_t	decls;
+	plist_t	elements;
 
 	type = PR_ParseType();
 
-	if (type == &type_union)
+	if (type == PT_UNION)
 	{
-		if (pr_scope)
+		if (InFunction)
 		{
 			PR_ParseError("unions must be global");
 		}
-		ParseUnion();
+		ParseUnion(list);
 		return;
 	}
 
-	if (pr_scope && (type->type == ev_field || type->type == ev_function))
+	etype = pr_unit->ptypes[type].type;
+	if (InFunction && (etype == ev_field || etype == ev_function))
 	{
 		PR_ParseError("fields and functions must be global");
 	}
 
+	defs = TR_NewNode(PN_DEFS, 0, type, 0, 0);
+	TR_AddToList(list, defs);
+	memset(&decls, 0, sizeof(decls));
 	do
 	{
-		name = PR_ParseName();
+		name = TR_NewString(PR_ParseName());
 		if (TK_CHECK(TK_LPAREN))
 		{
-			ParseCStyleFunctionDef(name, type);
+			ParseCStyleFunctionDef(defs, &decls, name, type);
 			return;
 		}
 
 		elementCount = 0;
 		if (TK_CHECK(TK_LBRACKET))
 		{
-			def = GetArrayDef(name, type, &elementCount);
-		}
-		else
-		{
-			def = PR_GetDef(type, name, pr_scope, true);
+			elementCount = ParseArray(type);
 		}
+		var = TR_NewNode(PN_VAR, INIT_NONE, name, elementCount, 0);
+		TR_AddToList(&decls, var);
+		NODE(defs)->b = decls.first;
 
 		// Check for initialization
 		if (TK_CHECK(TK_ASSIGN))
 		{
-			if (def->initialized)
-			{
-				PR_ParseError("'%s' : redefinition", name);
-			}
-			if (type->type == ev_field)
+			NODE(var)->op = INIT_PARTIAL;
+			if (etype == ev_field)
 			{
 				PR_ParseError("fields cannot be initialized");
 			}
@@ -941,19 +1374,18 @@ void CO_ParseDefs (void)
 			{
 				LX_Require("{");
 				i = 0;
-				offset = def->ofs;
+				memset(&elements, 0, sizeof(elements));
 				do
 				{
 					if (pr_token_type != tt_immediate)
 					{
-						PR_ParseError("immediate type required for %s", name);
+						PR_ParseError("immediate type required for %s", NODE_STRING(name));
 					}
-					if (pr_immediate_type->type != type->type)
+					if (pr_immediate_type->type != etype)
 					{
-						PR_ParseError("wrong immediate type for %s", name);
+						PR_ParseError("wrong immediate type for %s", NODE_STRING(name));
 					}
-					memcpy(pr_globals+offset, &pr_immediate, 4*type_size[pr_immediate_type->type]);
-					offset += type_size[pr_immediate_type->type];
+					TR_AddToList(&elements, CO_NewImmediate());
 					i++;
 					LX_Fetch();
 				} while (TK_CHECK(TK_COMMA));
@@ -963,30 +1395,135 @@ void CO_ParseDefs (void)
 				{
 					PR_ParseError("element count mismatch in array initialization");
 				}
-				def->initialized = 1;
+				NODE(var)->op = INIT_ARRAY;
+				NODE(var)->c = elements.first;
 				continue;
 			}
-			else if (type->type == ev_function)
+			else if (etype == ev_function)
 			{
-				ParseFunctionDef(def, type);
+				init = ParseFunctionDef(type);
+				NODE(var)->c = init;
+				NODE(var)->op = INIT_FUNCTION;
 				continue;
 			}
-			else if (pr_immediate_type != type)
-			{
-				PR_ParseError("wrong immediate type for %s", name);
-			}
-			def->initialized = 1;
-			memcpy(pr_globals+def->ofs, &pr_immediate, 4*type_size[pr_immediate_type->type]);
+			init = CO_NewImmediate();
+			NODE(var)->c = init;
+			NODE(var)->op = INIT_IMMEDIATE;
 			LX_Fetch();
 		}
-		else if (elementCount != 0 && type->type != ev_field)
+	} while (TK_CHECK(TK_COMMA));
+
+	LX_Require(";");
+}
+
+//==========================================================================
+//
+// CO_GenDefs
+//
+//==========================================================================
+
+void CO_GenDefs (int node)
+{
+	pnode_t	*n;
+	type_t	*type;
+	int		var;
+
+	n = NODE(node);
+	if (n->kind == PN_UNION)
+	{
+		GenUnion(n);
+		return;
+	}
+
+	type = NODE_TYPE(n->a);
+	for (var = n->b; var; var = NODE(var)->next)
+	{
+		if (NODE(var)->kind == PN_CFUNC)
+		{
+			GenCStyleFunctionDef(NODE(var));
+			return;
+		}
+		GenVarDef(NODE(var), type);
+	}
+}
+
+//==========================================================================
+//
+// GenVarDef
+//
+//==========================================================================
+
+static void GenVarDef (pnode_t *n, type_t *type)
+{
+	const char	*name;
+	def_t	*def;
+	gofs_t	offset;
+	int		element;
+
+	name = NODE_STRING(n->a);
+	lx_SourceLine = n->line;
+	if (n->b != 0)
+	{
+		def = GetArrayDef(name, type, n->b);
+	}
+	else
+	{
+		def = PR_GetDef(type, name, pr_scope, true);
+	}
+
+	switch (n->op)
+	{
+	case INIT_PARTIAL:	// the parse stopped at an error
+		break;
+
+	case INIT_NONE:
+		if (n->b != 0 && type->type != ev_field)
 		{
-			memset(pr_globals+def->ofs, 0, elementCount*4*type_size[type->type]);
+			memset(pr_globals+def->ofs, 0, n->b*4*type_size[type->type]);
 			def->initialized = 1;
+			AddConstant(def);
 		}
-	} while (TK_CHECK(TK_COMMA));
+		break;
 
-	LX_Require(";");
+	case INIT_ARRAY:
+		if (def->initialized)
+		{
+			PR_ParseError("'%s' : redefinition", name);
+		}
+		offset = def->ofs;
+		for (element = n->c; element; element = NODE(element)->next)
+		{
+			LoadImmediate(element);
+			memcpy(pr_globals+offset, &pr_immediate, 4*type_size[pr_immediate_type->type]);
+			offset += type_size[pr_immediate_type->type];
+		}
+		def->initialized = 1;
+		AddConstant(def);
+		break;
+
+	case INIT_FUNCTION:
+		if (def->initialized)
+		{
+			PR_ParseError("'%s' : redefinition", name);
+		}
+		GenFunctionDef(def, type, n->c);
+		break;
+
+	case INIT_IMMEDIATE:
+		if (def->initialized)
+		{
+			PR_ParseError("'%s' : redefinition", name);
+		}
+		LoadImmediate(n->c);
+		if (pr_immediate_type != type)
+		{
+			PR_ParseError("wrong immediate type for %s", name);
+		}
+		def->initialized = 1;
+		memcpy(pr_globals+def->ofs, &pr_immediate, 4*type_size[pr_immediate_type->type]);
+		AddConstant(def);
+		break;
+	}
 }
 
 //==========================================================================
@@ -995,18 +1532,20 @@ void CO_ParseDefs (void)
 //
 //==========================================================================
 
-static def_t *GetArrayDef (const char *name, type_t *type, int *elementCount)
+static def_t *GetArrayDef (const char *name, type_t *type, int count)
 {
 	def_t	*def;
-	int		count;
 	int		regCount;
 
-	if (type->type == ev_field)
+	if (PR_GetDef(type, name, pr_scope, false) != NULL)
 	{
-		return GetFieldArrayDef(name, type, elementCount);
+		PR_ParseError("array redefinition");
 	}
 
-	count = ParseArray(name, type);
+	if (type->type == ev_field)
+	{
+		return GetFieldArrayDef(name, type, count);
+	}
 
 	def = NewVarDef(name, type);
 
@@ -1024,7 +1563,6 @@ static def_t *GetArrayDef (const char *name, type_t *type, int *elementCount)
 		numpr_globals++;
 	} while (--regCount);
 
-	*elementCount = count;
 	return def;
 }
 
@@ -1034,12 +1572,9 @@ static def_t *GetArrayDef (const char *name, type_t *type, int *elementCount)
 //
 //==========================================================================
 
-static def_t *GetFieldArrayDef (const char *name, type_t *type, int *elementCount)
+static def_t *GetFieldArrayDef (const char *name, type_t *type, int count)
 {
 	def_t	*def;
-	int		count;
-
-	count = ParseArray(name, type);
 
 	def = NewVarDef(name, type);
 
@@ -1049,7 +1584,6 @@ static def_t *GetFieldArrayDef (const char *name, type_t *type, int *elementCoun
 	numpr_globals++;
 	pr.size_fields += type_size[type->aux_type->type]*count;
 
-	*elementCount = count;
 	return def;
 }
 
@@ -1068,9 +1602,7 @@ static def_t *NewVarDef (const char *name, type_t *type)
 
 	// Allocate the array def
 	def = (def_t *) SafeMalloc(sizeof(def_t));
-	def->next = NULL;
-	pr.def_tail->next = def;
-	pr.def_tail = def;
+	LinkDef(def);
 
 	// Add it to the hash table
 	if (pr_scope != NULL)
@@ -1100,25 +1632,23 @@ static def_t *NewVarDef (const char *name, type_t *type)
 //
 //==========================================================================
 
-static int ParseArray (const char *name, type_t *type)
+static int ParseArray (int type)
 {
 	int		count;
+	ptype_t	*pt;
 	etype_t	t;
 
-	t = type->type;
+	pt = &pr_unit->ptypes[type];
+	t = pt->type;
 	if (t == ev_field)
 	{
-		t = type->aux_type->type;
+		t = pr_unit->ptypes[pt->aux_type].type;
 	}
 	if (t != ev_float && t != ev_vector && t != ev_string
 		&& t != ev_entity && t != ev_function)
 	{
 		PR_ParseError("bad array type");
 	}
-	if (PR_GetDef(type, name, pr_scope, false) != NULL)
-	{
-		PR_ParseError("array redefinition");
-	}
 	if (pr_token_type != tt_immediate
 		|| pr_immediate_type != &type_float
 		|| pr_immediate._float != (int)pr_immediate._float)
@@ -1141,29 +1671,39 @@ static int ParseArray (const char *name, type_t *type)
 //
 //==========================================================================
 
-static void ParseUnion (void)
+static void ParseUnion (plist_t *list)
 {
-	const char	*name;
-	type_t	*type;
-	int	startFieldOffset;
-	int	highestFieldOffset;
-
+	int		node;
+	int		group;
+	int		fields;
+	plist_t	members;
+	plist_t	groups;
+	plist_t	names;
+
+	node = TR_NewNode(PN_UNION, false, 0, 0, 0);
+	TR_AddToList(list, node);
+	memset(&members, 0, sizeof(members));
 	LX_Require("{");
-	startFieldOffset = pr.size_fields;
-	highestFieldOffset = startFieldOffset;
 	do
 	{
 		if (LX_CheckFetch("struct"))
 		{
-			pr.size_fields = startFieldOffset;
+			group = TR_NewNode(PN_STRUCT, false, 0, 0, 0);
+			TR_AddToList(&members, group);
+			NODE(node)->a = members.first;
+			memset(&groups, 0, sizeof(groups));
 			LX_Require("{");
 			do
 			{
-				type = ParseUnionType();
+				fields = TR_NewNode(PN_FIELDS, 0, ParseUnionType(), 0, 0);
+				TR_AddToList(&groups, fields);
+				NODE(group)->a = groups.first;
+				memset(&names, 0, sizeof(names));
 				do
 				{
-					name = PR_ParseName();
-					PR_GetDef(type, name, pr_scope, true);
+					TR_AddToList(&names, TR_NewNode(PN_IDENT, 0,
+							TR_NewString(PR_ParseName()), 0, 0));
+					NODE(fields)->b = names.first;
 				} while (TK_CHECK(TK_COMMA));
 
 				LX_Require(";");
@@ -1171,23 +1711,19 @@ static void ParseUnion (void)
 
 			LX_Require("}");
 			LX_Require(";");
-			if (pr.size_fields > highestFieldOffset)
-			{
-				highestFieldOffset = pr.size_fields;
-			}
+			NODE(group)->op = true;
 		}
 		else
 		{
-			type = ParseUnionType();
+			fields = TR_NewNode(PN_FIELDS, 0, ParseUnionType(), 0, 0);
+			TR_AddToList(&members, fields);
+			NODE(node)->a = members.first;
+			memset(&names, 0, sizeof(names));
 			do
 			{
-				name = PR_ParseName();
-				pr.size_fields = startFieldOffset;
-				PR_GetDef(type, name, pr_scope, true);
-				if (pr.size_fields > highestFieldOffset)
-				{
-					highestFieldOffset = pr.size_fields;
-				}
+				TR_AddToList(&names, TR_NewNode(PN_IDENT, 0,
+						TR_NewString(PR_ParseName()), 0, 0));
+				NODE(fields)->b = names.first;
 			} while (TK_CHECK(TK_COMMA));
 
 			LX_Require(";");
@@ -1196,7 +1732,7 @@ static void ParseUnion (void)
 
 	LX_Require("}");
 	LX_Require(";");
-	pr.size_fields = highestFieldOffset;
+	NODE(node)->op = true;
 }
 
 //==========================================================================
@@ -1205,20 +1741,85 @@ static void ParseUnion (void)
 //
 //==========================================================================
 
-static type_t *ParseUnionType (void)
+static int ParseUnionType (void)
 {
-	type_t	*type;
-	type_t	newType;
+	int		type;
+	ptype_t	newType;
 
 	type = PR_ParseType();
-	if (type->type == ev_field)
+	if (pr_unit->ptypes[type].type == ev_field)
 	{
 		PR_ParseError("union field types are implicit");
 	}
 	memset(&newType, 0, sizeof(newType));
 	newType.type = ev_field;
 	newType.aux_type = type;
-	return PR_FindType(&newType);
+	return TR_NewType(&newType);
+}
+
+//==========================================================================
+//
+// GenUnion
+//
+// Overlaps the fields of the members.  The members of a union the parse
+// didn't finish only get declared.
+//
+//==========================================================================
+
+static void GenUnion (pnode_t *n)
+{
+	int		member;
+	int		fields;
+	int		name;
+	type_t	*type;
+	int	startFieldOffset;
+	int	highestFieldOffset;
+
+	startFieldOffset = pr.size_fields;
+	highestFieldOffset = startFieldOffset;
+	for (member = n->a; member; member = NODE(member)->next)
+	{
+		if (NODE(member)->kind == PN_STRUCT)
+		{
+			pr.size_fields = startFieldOffset;
+			for (fields = NODE(member)->a; fields; fields = NODE(fields)->next)
+			{
+				type = NODE_TYPE(NODE(fields)->a);
+				for (name = NODE(fields)->b; name; name = NODE(name)->next)
+				{
+					lx_SourceLine = NODE(name)->line;
+					PR_GetDef(type, NODE_STRING(NODE(name)->a), pr_scope, true);
+				}
+			}
+			if (!NODE(member)->op)
+			{
+				return;
+			}
+			if (pr.size_fields > highestFieldOffset)
+			{
+				highestFieldOffset = pr.size_fields;
+			}
+		}
+		else
+		{
+			type = NODE_TYPE(NODE(member)->a);
+			for (name = NODE(member)->b; name; name = NODE(name)->next)
+			{
+				lx_SourceLine = NODE(name)->line;
+				pr.size_fields = startFieldOffset;
+				PR_GetDef(type, NODE_STRING(NODE(name)->a), pr_scope, true);
+				if (pr.size_fields > highestFieldOffset)
+				{
+					highestFieldOffset = pr.size_fields;
+				}
+			}
+		}
+	}
+
+	if (n->op)
+	{
+		pr.size_fields = highestFieldOffset;
+	}
 }
 
 //==========================================================================
@@ -1227,7 +1828,23 @@ static type_t *ParseUnionType (void)
 //
 //==========================================================================
 
-static void ParseFunctionDef (def_t *def, type_t *type)
+static int ParseFunctionDef (int type)
+{
+	int		node;
+
+	InFunction = true;
+	node = ParseImmediateStatements(type);
+	InFunction = false;
+	return node;
+}
+
+//==========================================================================
+//
+// GenFunctionDef
+//
+//==========================================================================
+
+static void GenFunctionDef (def_t *def, type_t *type, int body)
 {
 	int		i;
 	function_t	*f;
@@ -1236,7 +1853,7 @@ static void ParseFunctionDef (def_t *def, type_t *type)
 
 	locals_start = locals_end = numpr_globals;
 	pr_scope = def;
-	f = ParseImmediateStatements(type);
+	f = GenImmediateStatements(type, body);
 	pr_scope = NULL;
 	def->initialized = 1;
 	G_FUNCTION(def->ofs) = numfunctions;
@@ -1271,20 +1888,14 @@ static void ParseFunctionDef (def_t *def, type_t *type)
 //
 //==========================================================================
 
-static void ParseCStyleFunctionDef (const char *funcName, type_t *type)
+static void ParseCStyleFunctionDef (int defs, plist_t *decls, int funcName, int type)
 {
-	int		i;
-	const char	*name = "???";	// FIXME: init to "???", silence compiler
-	type_t	newType;
-	type_t	*funcType;
-	def_t	*def;
-	function_t	*f;
-	dfunction_t	*df;
-	int	locals_start;
-	char	funcIdent[MAX_NAME];
+	int		node;
+	int		name;
+	int		body;
+	ptype_t	newType;
 	int	initClass;
 
-	strcpy(funcIdent, funcName);
 	memset(&newType, 0, sizeof(newType));
 	newType.type = ev_function;
 	newType.aux_type = type; // Return type
@@ -1300,8 +1911,8 @@ static void ParseCStyleFunctionDef (const char *funcName, type_t *type)
 			do
 			{
 				type = PR_ParseType();
-				name = PR_ParseName();
-				strcpy(pr_parm_names[newType.num_parms], name);
+				name = TR_NewString(PR_ParseName());
+				strcpy(pr_parm_names[newType.num_parms], NODE_STRING(name));
 				newType.parm_types[newType.num_parms] = type;
 				newType.num_parms++;
 			} while (TK_CHECK(TK_COMMA));
@@ -1309,51 +1920,17 @@ static void ParseCStyleFunctionDef (const char *funcName, type_t *type)
 		LX_Require(")");
 	}
 
-	funcType = PR_FindType(&newType);
-	def = PR_GetDef(funcType, funcIdent, pr_scope, true);
-
-	if (def->initialized)
-	{
-		PR_ParseError("%s redeclared", funcName);
-	}
+	node = TR_NewNode(PN_CFUNC, false, funcName, TR_NewType(&newType), 0);
+	TR_AddToList(decls, node);
+	NODE(defs)->b = decls->first;
 
 	if (TK_TEST(TK_LBRACE)
 		|| TK_TEST(TK_LBRACKET)
 		|| TK_TEST(TK_COLON))
 	{
 		initClass = pr_tokenclass;
-		if (def->initialized)
-		{
-			PR_ParseError("%s redeclared", name);
-		}
-		locals_start = locals_end = numpr_globals;
-		pr_scope = def;
-		f = ParseImmediateStatements(funcType);
-		pr_scope = NULL;
-		def->initialized = 1;
-		G_FUNCTION(def->ofs) = numfunctions;
-		f->def = def;
-		df = &functions[numfunctions];
-		numfunctions++;
-		if (f->builtin)
-		{
-			df->first_statement = -f->builtin;
-			def->referenceCount++;
-		}
-		else
-		{
-			df->first_statement = f->code;
-		}
-		df->s_name = CopyString(f->def->name);
-		df->s_file = s_file;
-		df->numparms =  f->def->type->num_parms;
-		df->locals = locals_end - locals_start;
-		df->parm_start = locals_start;
-		for (i = 0; i < df->numparms; i++)
-		{
-			df->parm_size[i] =
-				type_size[f->def->type->parm_types[i]->type];
-		}
+		body = ParseFunctionDef(NODE(node)->b);
+		NODE(node)->c = body;
 		if (initClass == TK_COLON)
 		{
 			LX_Require(";");
@@ -1363,4 +1940,39 @@ static void ParseCStyleFunctionDef (const char *funcName, type_t *type)
 	{
 		LX_Require(";");
 	}
+	NODE(node)->op = true;
+}
+
+//==========================================================================
+//
+// GenCStyleFunctionDef
+//
+// A definition the parse didn't finish only gets declared.
+//
+//==========================================================================
+
+static void GenCStyleFunctionDef (pnode_t *n)
+{
+	const char	*funcName;
+	type_t	*funcType;
+	def_t	*def;
+
+	funcName = NODE_STRING(n->a);
+	funcType = NODE_TYPE(n->b);
+	lx_SourceLine = n->line;
+	def = PR_GetDef(funcType, funcName, pr_scope, true);
+	if (!n->op)
+	{
+		return;
+	}
+
+	if (def->initialized)
+	{
+		PR_ParseError("%s redeclared", funcName);
+	}
+
+	if (n->c)
+	{
+		GenFunctionDef(def, funcType, n->c);
+	}
 }
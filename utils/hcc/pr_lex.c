@@ -67,29 +67,33 @@ static void ClearFrameMacros(void);
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
-int lx_SourceLine;
+PARSE_THREADVAR int lx_SourceLine;
+
+// Bytes of pr_immediate the lexer set since the parser last took the
+// immediate into the parse tree.
+PARSE_THREADVAR int lx_ImmediateBytes;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
-static char FrameMacroNames[MAX_FRAME_DEFS][24];
-static int FrameMacroValues[MAX_FRAME_DEFS];
-static int FrameMacroBookmarks[MAX_BOOKMARKS];
-static int FrameMacroCount;
-static int FrameMacroIndex;
+static PARSE_THREADVAR char FrameMacroNames[MAX_FRAME_DEFS][24];
+static PARSE_THREADVAR int FrameMacroValues[MAX_FRAME_DEFS];
+static PARSE_THREADVAR int FrameMacroBookmarks[MAX_BOOKMARKS];
+static PARSE_THREADVAR int FrameMacroCount;
+static PARSE_THREADVAR int FrameMacroIndex;
 
 static int ASCIIToChrCode[256];
 
-static const char *pr_file_p;
+static PARSE_THREADVAR const char *pr_file_p;
 
-static int pr_bracelevel;
+static PARSE_THREADVAR int pr_bracelevel;
 
-int		pr_tokenclass;
-char		pr_token[2048];
-token_type_t	pr_token_type;
-type_t		*pr_immediate_type;
-eval_t		pr_immediate;
+PARSE_THREADVAR int		pr_tokenclass;
+PARSE_THREADVAR char		pr_token[2048];
+PARSE_THREADVAR token_type_t	pr_token_type;
+PARSE_THREADVAR type_t		*pr_immediate_type;
+PARSE_THREADVAR eval_t		pr_immediate;
 
-char	pr_immediate_string[2048];
+PARSE_THREADVAR char	pr_immediate_string[2048];
 
 int		pr_error_count;
 
@@ -170,6 +174,12 @@ void LX_NewSourceFile (const char *fileText)
 {
 	pr_file_p = fileText;
 	ClearFrameMacros();
+	// Whatever thread parses the file, it starts from the same state.
+	// The immediate the file inherits from the one before is left to
+	// the code generation.
+	pr_bracelevel = 0;
+	pr_immediate_type = NULL;
+	lx_ImmediateBytes = 0;
 	lx_SourceLine = 0;
 	NewLine();
 	LX_Fetch();
@@ -389,6 +399,7 @@ static void LexVector (void)
 	pr_file_p++;
 	pr_token_type = tt_immediate;
 	pr_immediate_type = &type_vector;
+	lx_ImmediateBytes = 12;
 	for (i = 0; i < 3; i++)
 	{
 		LexWhitespace();
@@ -580,6 +591,8 @@ static void LexPunctuation (void)
 			pr_token_type = tt_immediate;
 			pr_immediate_type = &type_float;
 			pr_immediate._float = LexNumber();
+			if (lx_ImmediateBytes < 4)
+				lx_ImmediateBytes = 4;
 			return;
 		}
 		if (*pr_file_p == '.')
@@ -619,6 +632,8 @@ static void LexPunctuation (void)
 			pr_token_type = tt_immediate;
 			pr_immediate_type = &type_float;
 			pr_immediate._float = LexNumber();
+			if (lx_ImmediateBytes < 4)
+				lx_ImmediateBytes = 4;
 			return;
 		}
 		pr_tokenclass = TK_MINUS;
@@ -723,6 +738,8 @@ static void FindFrameMacro (void)
 			pr_token_type = tt_immediate;
 			pr_immediate_type = &type_float;
 			pr_immediate._float = (float)FrameMacroValues[i];
+			if (lx_ImmediateBytes < 4)
+				lx_ImmediateBytes = 4;
 			return;
 		}
 	}
@@ -894,6 +911,8 @@ void LX_Fetch (void)
 		pr_token_type = tt_immediate;
 		pr_immediate_type = &type_float;
 		pr_immediate._float = LexNumber();
+		if (lx_ImmediateBytes < 4)
+			lx_ImmediateBytes = 4;
 		return;
 	case CHR_DQUOTE:
 		LexString();
@@ -974,7 +993,7 @@ qboolean LX_Check (const char *string)
 
 const char *PR_ParseName (void)
 {
-	static char	ident[MAX_NAME];
+	static PARSE_THREADVAR char	ident[MAX_NAME];
 
 	if (pr_token_type != tt_name)
 	{
@@ -1042,44 +1061,45 @@ type_t *PR_FindType (type_t *type)
 //
 // PR_ParseType
 //
-// Parses a variable type, including field and functions types
+// Parses a variable type, including field and functions types.  Returns
+// the index of the type in the parse tree.
 //
 //==========================================================================
 
-char pr_parm_names[MAX_PARMS][MAX_NAME];
+PARSE_THREADVAR char pr_parm_names[MAX_PARMS][MAX_NAME];
 
-type_t *PR_ParseType (void)
+int PR_ParseType (void)
 {
 	const char	*name;
-	type_t	newtype;
-	type_t	*type;
+	ptype_t	newtype;
+	int	type;
 
 	if (TK_CHECK(TK_PERIOD))
 	{
 		if (LX_CheckFetch("union"))
 		{
-			return &type_union;
+			return PT_UNION;
 		}
 		memset(&newtype, 0, sizeof(newtype));
 		newtype.type = ev_field;
 		newtype.aux_type = PR_ParseType();
-		return PR_FindType(&newtype);
+		return TR_NewType(&newtype);
 	}
 
 	if (!strcmp (pr_token, "float"))
-		type = &type_float;
+		type = ev_float;
 	else if (!strcmp (pr_token, "vector"))
-		type = &type_vector;
+		type = ev_vector;
 	else if (!strcmp (pr_token, "entity"))
-		type = &type_entity;
+		type = ev_entity;
 	else if (!strcmp (pr_token, "string"))
-		type = &type_string;
+		type = ev_string;
 	else if (!strcmp (pr_token, "void"))
-		type = &type_void;
+		type = ev_void;
 	else
 	{
 		PR_ParseError ("\"%s\" is not a type", pr_token);
-		return NULL; /* silence compiler */
+		return 0; /* silence compiler */
 	}
 	LX_Fetch();
 
@@ -1112,7 +1132,7 @@ type_t *PR_ParseType (void)
 		}
 		LX_Require(")");
 	}
-	return PR_FindType(&newtype);
+	return TR_NewType(&newtype);
 }
 
 //==========================================================================
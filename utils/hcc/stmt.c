@@ -69,27 +69,35 @@ typedef struct
 
 // PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
 
-static void ParseStatement(scontext_t owner);
-static void ParseReturn(void);
-static void ParseLoop(void);
-static void ParseWhile(void);
-static void ParseUntil(void);
-static void ParseDo(void);
-static void ParseIf(void);
-static void ParseLocalDefs(void);
-static void ParseSwitch(void);
-static void ParseCase(void);
-static void ParseBreak(void);
-static void ParseContinue(void);
-static void ParseDefault(void);
-static void ParseThinktime(void);
+static int ParseStatement(scontext_t owner);
+static int ParseCondition(void);
+static int ParseReturn(void);
+static int ParseLoop(void);
+static int ParseWhile(int kind, scontext_t owner);
+static int ParseDo(void);
+static int ParseIf(void);
+static int ParseLocalDefs(void);
+static int ParseSwitch(void);
+static int ParseCase(void);
+static int ParseThinktime(void);
+static qboolean BreakAncestor(void);
+static qboolean ContinueAncestor(void);
+static void GenStatement(int node, scontext_t owner);
+static def_t *GenCondition(int node);
+static void GenReturn(pnode_t *n);
+static void GenLoop(pnode_t *n);
+static void GenWhile(pnode_t *n, int ifOpcode, scontext_t owner);
+static void GenDo(pnode_t *n);
+static void GenIf(pnode_t *n);
+static void GenLocalDefs(pnode_t *n);
+static void GenSwitch(pnode_t *n);
+static void GenCase(pnode_t *n);
+static void GenThinktime(pnode_t *n);
 static void AddCase(etype_t type, def_t *value1, def_t *value2, qboolean isDefault);
 static int GetCaseInfo(caseInfo_t **info);
 static void AddBreak(void);
-static qboolean BreakAncestor(void);
 static void FixBreaks(void);
 static void AddContinue(void);
-static qboolean ContinueAncestor(void);
 static void FixContinues(int statement);
 
 // EXTERNAL DATA DECLARATIONS ----------------------------------------------
@@ -101,12 +109,15 @@ qboolean st_ReturnParsed;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
+// the parse of the statements
+static PARSE_THREADVAR int StatementIndex;
+static PARSE_THREADVAR scontext_t ContextHistory[MAX_STATEMENT_DEPTH];
+
+// the code generation
 static int CaseIndex;
 static int BreakIndex;
 static int ContinueIndex;
-static int StatementIndex;
 static int ContextLevel;
-static scontext_t ContextHistory[MAX_STATEMENT_DEPTH];
 static caseInfo_t CaseInfo[MAX_CASE];
 static patchInfo_t BreakInfo[MAX_BREAK];
 static patchInfo_t ContinueInfo[MAX_CONTINUE];
@@ -155,14 +166,10 @@ static qboolean ContinueAllowed[] =
 //
 //==========================================================================
 
-void ST_ParseStatement (void)
+int ST_ParseStatement (void)
 {
-	CaseIndex = 0;
-	BreakIndex = 0;
-	ContinueIndex = 0;
 	StatementIndex = 0;
-	ContextLevel = 0;
-	ParseStatement(SCONTEXT_FUNCTION);
+	return ParseStatement(SCONTEXT_FUNCTION);
 }
 
 //==========================================================================
@@ -171,8 +178,11 @@ void ST_ParseStatement (void)
 //
 //==========================================================================
 
-static void ParseStatement (scontext_t owner)
+static int ParseStatement (scontext_t owner)
 {
+	int		node;
+	plist_t	list;
+
 	if (StatementIndex == MAX_STATEMENT_DEPTH)
 	{
 		PR_ParseError("statement overflow");
@@ -181,124 +191,117 @@ static void ParseStatement (scontext_t owner)
 
 	if (TK_CHECK(TK_LBRACE))
 	{
-		ContextLevel += EnterContext[owner];
+		memset(&list, 0, sizeof(list));
 		do
 		{
-			ParseStatement(owner);
+			TR_AddToList(&list, ParseStatement(owner));
 		} while (!TK_CHECK(TK_RBRACE));
 
-		ContextLevel -= EnterContext[owner];
 		StatementIndex--;
-		return;
+		return TR_NewNode(PN_BLOCK, 0, list.first, 0, 0);
 	}
 
 	if (TK_CHECK(TK_SEMICOLON))
 	{
-		StatementIndex--;
-		return;
+		node = TR_NewNode(PN_EMPTY, 0, 0, 0, 0);
 	}
-	if (LX_CheckFetch("return"))
+	else if (LX_CheckFetch("return"))
 	{
-		ParseReturn();
-		StatementIndex--;
-		return;
+		node = ParseReturn();
 	}
-	if (LX_CheckFetch("loop"))
+	else if (LX_CheckFetch("loop"))
 	{
-		ParseLoop();
-		StatementIndex--;
-		return;
+		node = ParseLoop();
 	}
-	if (LX_CheckFetch("while"))
+	else if (LX_CheckFetch("while"))
 	{
-		ParseWhile();
-		StatementIndex--;
-		return;
+		node = ParseWhile(PN_WHILE, SCONTEXT_WHILE);
 	}
-	if (LX_CheckFetch("until"))
+	else if (LX_CheckFetch("until"))
 	{
-		ParseUntil();
-		StatementIndex--;
-		return;
+		node = ParseWhile(PN_UNTIL, SCONTEXT_UNTIL);
 	}
-	if (LX_CheckFetch("do"))
+	else if (LX_CheckFetch("do"))
 	{
-		ParseDo();
-		StatementIndex--;
-		return;
+		node = ParseDo();
 	}
-	if (LX_CheckFetch("switch"))
+	else if (LX_CheckFetch("switch"))
 	{
-		ParseSwitch();
-		StatementIndex--;
-		return;
+		node = ParseSwitch();
 	}
-	if (LX_CheckFetch("case"))
+	else if (LX_CheckFetch("case"))
 	{
 		if (owner != SCONTEXT_SWITCH)
 		{
 			PR_ParseError("misplaced case");
 		}
-		ParseCase();
-		StatementIndex--;
-		return;
+		node = ParseCase();
 	}
-	if (LX_CheckFetch("break"))
+	else if (LX_CheckFetch("break"))
 	{
 		if (BreakAncestor() == false)
 		{
 			PR_ParseError("misplaced break");
 		}
-		ParseBreak();
-		StatementIndex--;
-		return;
+		LX_Require(";");
+		node = TR_NewNode(PN_BREAK, 0, 0, 0, 0);
 	}
-	if (LX_CheckFetch("continue"))
+	else if (LX_CheckFetch("continue"))
 	{
 		if (ContinueAncestor() == false)
 		{
 			PR_ParseError("misplaced continue");
 		}
-		ParseContinue();
-		StatementIndex--;
-		return;
+		LX_Require(";");
+		node = TR_NewNode(PN_CONTINUE, 0, 0, 0, 0);
 	}
-	if (LX_CheckFetch("default"))
+	else if (LX_CheckFetch("default"))
 	{
-		ParseDefault();
-		StatementIndex--;
-		return;
+		LX_Require(":");
+		node = TR_NewNode(PN_DEFAULT, 0, 0, 0, 0);
 	}
-	if (LX_CheckFetch("thinktime"))
+	else if (LX_CheckFetch("thinktime"))
 	{
-		ParseThinktime();
-		StatementIndex--;
-		return;
+		node = ParseThinktime();
 	}
-	if (LX_CheckFetch("local"))
+	else if (LX_CheckFetch("local"))
 	{
-		ParseLocalDefs();
-		StatementIndex--;
-		return;
+		node = ParseLocalDefs();
 	}
-	if (LX_Check("float") || LX_Check("vector")
+	else if (LX_Check("float") || LX_Check("vector")
 		|| LX_Check("entity") || LX_Check("string")
 		|| LX_Check("void"))
 	{
-		ParseLocalDefs();
-		StatementIndex--;
-		return;
+		node = ParseLocalDefs();
 	}
-	if (LX_CheckFetch("if"))
+	else if (LX_CheckFetch("if"))
 	{
-		ParseIf();
-		StatementIndex--;
-		return;
+		node = ParseIf();
+	}
+	else
+	{
+		node = EX_Expression(TOP_PRIORITY);
+		LX_Require(";");
+		node = TR_NewNode(PN_EXPR, 0, node, 0, 0);
 	}
-
-	EX_Expression(TOP_PRIORITY);
-	LX_Require(";");
 	StatementIndex--;
+	return node;
+}
+
+//==========================================================================
+//
+// ParseCondition
+//
+//==========================================================================
+
+static int ParseCondition (void)
+{
+	int		e;
+
+	LX_Require("(");
+	e = EX_Expression(TOP_PRIORITY);
+	LX_Require(")");
+	return e;
 }
 
 //==========================================================================
@@ -307,29 +310,21 @@ static void ParseStatement (scontext_t owner)
 //
 //==========================================================================
 
-static void ParseReturn (void)
+static int ParseReturn (void)
 {
-	def_t	*e;
+	int		node;
+	int		e;
 
 	//if (TK_CHECK(TK_SEMICOLON))
 	if (pr_tokenclass == TK_SEMICOLON)
 	{
-		if (st_ReturnType->type != ev_void)
-		{
-			PR_ParseError("missing return value");
-		}
-		CO_GenCode(&pr_opcodes[OP_RETURN], NULL, NULL);
+		node = TR_NewNode(PN_RETURN, 0, 0, 0, 0);
 		LX_Fetch();
-		return;
+		return node;
 	}
 	e = EX_Expression(TOP_PRIORITY);
-	if (e->type != st_ReturnType)
-	{
-		PR_ParseError("return type mismatch");
-	}
 	LX_Require(";");
-	CO_GenCode(&pr_opcodes[OP_RETURN], e, NULL);
-	st_ReturnParsed = true;
+	return TR_NewNode(PN_RETURN, 0, e, 0, 0);
 }
 
 //==========================================================================
@@ -338,72 +333,399 @@ static void ParseReturn (void)
 //
 //==========================================================================
 
-static void ParseLoop (void)
+static int ParseLoop (void)
 {
-	dstatement_t	*patch1;
-	def_t	tempDef;
-	int	contStatement;
+	int		s;
 
-	contStatement = numstatements;
-	patch1 = &statements[numstatements];
-	ParseStatement(SCONTEXT_LOOP);
-	tempDef.ofs = patch1 - &statements[numstatements];
-	CO_GenCode(&pr_opcodes[OP_GOTO], &tempDef, NULL);
-	FixContinues(contStatement);
-	FixBreaks();
+	s = ParseStatement(SCONTEXT_LOOP);
+	return TR_NewNode(PN_LOOP, 0, s, 0, 0);
 }
 
 //==========================================================================
 //
 // ParseWhile
 //
+// Parses a while or an until loop.
+//
+//==========================================================================
+
+static int ParseWhile (int kind, scontext_t owner)
+{
+	int		e;
+	int		s;
+
+	e = ParseCondition();
+	LX_CheckFetch("do");
+	// The test goes at the line of the PN_EXPR
+	e = TR_NewNode(PN_EXPR, 0, e, 0, 0);
+	s = ParseStatement(owner);
+	return TR_NewNode(kind, 0, e, s, 0);
+}
+
+//==========================================================================
+//
+// ParseDo
+//
+//==========================================================================
+
+static int ParseDo (void)
+{
+	int		s;
+	int		e;
+	int		ifOpcode;
+
+	s = ParseStatement(SCONTEXT_DO);
+	if (LX_CheckFetch("until"))
+	{
+		ifOpcode = OP_IFNOT;
+	}
+	else
+	{
+		LX_Require("while");
+		ifOpcode = OP_IF;
+	}
+	e = ParseCondition();
+	LX_Require(";");
+	return TR_NewNode(PN_DO, ifOpcode, s, e, 0);
+}
+
+//==========================================================================
+//
+// ParseIf
+//
+//==========================================================================
+
+static int ParseIf (void)
+{
+	int		e;
+	int		s;
+	int		s2;
+	int		elseNode;
+	int		ifOpcode;
+
+	if (LX_CheckFetch("not"))
+	{
+		ifOpcode = OP_IF;
+	}
+	else
+	{
+		ifOpcode = OP_IFNOT;
+	}
+
+	e = ParseCondition();
+	e = TR_NewNode(PN_EXPR, 0, e, 0, 0);
+
+	s = ParseStatement(SCONTEXT_IF);
+
+	elseNode = 0;
+	if (LX_CheckFetch("else"))
+	{
+		elseNode = TR_NewNode(PN_ELSE, 0, 0, 0, 0);
+		s2 = ParseStatement(SCONTEXT_ELSE);
+		NODE(elseNode)->a = s2;
+	}
+	return TR_NewNode(PN_IF, ifOpcode, e, s, elseNode);
+}
+
+//==========================================================================
+//
+// ParseLocalDefs
+//
+//==========================================================================
+
+static int ParseLocalDefs (void)
+{
+	plist_t	defs;
+
+	memset(&defs, 0, sizeof(defs));
+	CO_ParseDefs(&defs);
+	return TR_NewNode(PN_LOCAL, 0, defs.first, 0, 0);
+}
+
+//==========================================================================
+//
+// ParseSwitch
+//
+//==========================================================================
+
+static int ParseSwitch (void)
+{
+	int		e;
+	int		s;
+
+	e = ParseCondition();
+	e = TR_NewNode(PN_EXPR, 0, e, 0, 0);
+	s = ParseStatement(SCONTEXT_SWITCH);
+	return TR_NewNode(PN_SWITCH, 0, e, s, 0);
+}
+
+//==========================================================================
+//
+// ParseCase
+//
+//==========================================================================
+
+static int ParseCase (void)
+{
+	int		e;
+	int		e2;
+	plist_t	values;
+
+	memset(&values, 0, sizeof(values));
+	do
+	{
+		e = EX_Expression(TOP_PRIORITY);
+		e2 = 0;
+		if (TK_CHECK(TK_RANGE))
+		{
+			e2 = EX_Expression(TOP_PRIORITY);
+		}
+		TR_AddToList(&values, TR_NewNode(PN_CASEVALUE, 0, e, e2, 0));
+	} while (TK_CHECK(TK_COMMA));
+
+	LX_Require(":");
+	return TR_NewNode(PN_CASE, 0, values.first, 0, 0);
+}
+
+//==========================================================================
+//
+// BreakAncestor
+//
+//==========================================================================
+
+static qboolean BreakAncestor (void)
+{
+	int		i;
+
+	for (i = 0; i < StatementIndex; i++)
+	{
+		if (BreakAllowed[ContextHistory[i]])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//==========================================================================
+//
+// ContinueAncestor
+//
+//==========================================================================
+
+static qboolean ContinueAncestor (void)
+{
+	int		i;
+
+	for (i = 0; i < StatementIndex; i++)
+	{
+		if (ContinueAllowed[ContextHistory[i]])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//==========================================================================
+//
+// ParseThinktime
+//
 //==========================================================================
 
-static void ParseWhile (void)
+static int ParseThinktime (void)
+{
+	int		expr1;
+	int		expr2;
+
+	expr1 = EX_Expression(TOP_PRIORITY);
+	LX_Require(":");
+	expr2 = EX_Expression(TOP_PRIORITY);
+	LX_Require(";");
+	return TR_NewNode(PN_THINKTIME, 0, expr1, expr2, 0);
+}
+
+//==========================================================================
+//
+// ST_GenStatement
+//
+//==========================================================================
+
+void ST_GenStatement (int node)
+{
+	CaseIndex = 0;
+	BreakIndex = 0;
+	ContinueIndex = 0;
+	ContextLevel = 0;
+	GenStatement(node, SCONTEXT_FUNCTION);
+}
+
+//==========================================================================
+//
+// GenStatement
+//
+//==========================================================================
+
+static void GenStatement (int node, scontext_t owner)
+{
+	pnode_t	*n;
+	int		s;
+
+	n = NODE(node);
+	switch (n->kind)
+	{
+	case PN_BLOCK:
+		ContextLevel += EnterContext[owner];
+		for (s = n->a; s; s = NODE(s)->next)
+		{
+			GenStatement(s, owner);
+		}
+		ContextLevel -= EnterContext[owner];
+		break;
+	case PN_EMPTY:
+		break;
+	case PN_RETURN:
+		GenReturn(n);
+		break;
+	case PN_LOOP:
+		GenLoop(n);
+		break;
+	case PN_WHILE:
+		GenWhile(n, OP_IFNOT, SCONTEXT_WHILE);
+		break;
+	case PN_UNTIL:
+		GenWhile(n, OP_IF, SCONTEXT_UNTIL);
+		break;
+	case PN_DO:
+		GenDo(n);
+		break;
+	case PN_SWITCH:
+		GenSwitch(n);
+		break;
+	case PN_CASE:
+		GenCase(n);
+		break;
+	case PN_BREAK:
+		lx_SourceLine = n->line;
+		AddBreak();
+		break;
+	case PN_CONTINUE:
+		lx_SourceLine = n->line;
+		AddContinue();
+		break;
+	case PN_DEFAULT:
+		lx_SourceLine = n->line;
+		AddCase(ev_void, NULL, NULL, true);
+		break;
+	case PN_THINKTIME:
+		GenThinktime(n);
+		break;
+	case PN_LOCAL:
+		GenLocalDefs(n);
+		break;
+	case PN_IF:
+		GenIf(n);
+		break;
+	case PN_EXPR:
+		EX_GenExpression(n->a);
+		break;
+	default:
+		COM_Error("%s: bad node kind %d", __thisfunc__, n->kind);
+	}
+}
+
+//==========================================================================
+//
+// GenCondition
+//
+// Returns the value of a PN_EXPR node, with the line of the code testing
+// it.
+//
+//==========================================================================
+
+static def_t *GenCondition (int node)
 {
 	def_t	*e;
-	dstatement_t	*patch1, *patch2;
+
+	e = EX_GenExpression(NODE(node)->a);
+	lx_SourceLine = NODE(node)->line;
+	return e;
+}
+
+//==========================================================================
+//
+// GenReturn
+//
+//==========================================================================
+
+static void GenReturn (pnode_t *n)
+{
+	def_t	*e;
+
+	if (n->a == 0)
+	{
+		lx_SourceLine = n->line;
+		if (st_ReturnType->type != ev_void)
+		{
+			PR_ParseError("missing return value");
+		}
+		CO_GenCode(&pr_opcodes[OP_RETURN], NULL, NULL);
+		return;
+	}
+	e = EX_GenExpression(n->a);
+	lx_SourceLine = n->line;
+	if (e->type != st_ReturnType)
+	{
+		PR_ParseError("return type mismatch");
+	}
+	CO_GenCode(&pr_opcodes[OP_RETURN], e, NULL);
+	st_ReturnParsed = true;
+}
+
+//==========================================================================
+//
+// GenLoop
+//
+//==========================================================================
+
+static void GenLoop (pnode_t *n)
+{
+	dstatement_t	*patch1;
 	def_t	tempDef;
 	int	contStatement;
 
-	LX_Require("(");
 	contStatement = numstatements;
-	patch2 = &statements[numstatements];
-	e = EX_Expression(TOP_PRIORITY);
-	LX_Require(")");
-	LX_CheckFetch("do");
 	patch1 = &statements[numstatements];
-	CO_GenCode(&pr_opcodes[OP_IFNOT], e, NULL);
-	ParseStatement(SCONTEXT_WHILE);
-	tempDef.ofs = patch2 - &statements[numstatements];
+	GenStatement(n->a, SCONTEXT_LOOP);
+	lx_SourceLine = n->line;
+	tempDef.ofs = patch1 - &statements[numstatements];
 	CO_GenCode(&pr_opcodes[OP_GOTO], &tempDef, NULL);
-	patch1->b = &statements[numstatements] - patch1;
 	FixContinues(contStatement);
 	FixBreaks();
 }
 
 //==========================================================================
 //
-// ParseUntil
+// GenWhile
+//
+// Generates a while or an until loop.
 //
 //==========================================================================
 
-static void ParseUntil (void)
+static void GenWhile (pnode_t *n, int ifOpcode, scontext_t owner)
 {
 	def_t	*e;
 	dstatement_t	*patch1, *patch2;
 	def_t	tempDef;
 	int	contStatement;
 
-	LX_Require("(");
 	contStatement = numstatements;
 	patch2 = &statements[numstatements];
-	e = EX_Expression(TOP_PRIORITY);
-	LX_Require(")");
-	LX_CheckFetch("do");
+	e = GenCondition(n->a);
 	patch1 = &statements[numstatements];
-	CO_GenCode(&pr_opcodes[OP_IF], e, NULL);
-	ParseStatement(SCONTEXT_UNTIL);
+	CO_GenCode(&pr_opcodes[ifOpcode], e, NULL);
+	GenStatement(n->b, owner);
+	lx_SourceLine = n->line;
 	tempDef.ofs = patch2 - &statements[numstatements];
 	CO_GenCode(&pr_opcodes[OP_GOTO], &tempDef, NULL);
 	patch1->b = &statements[numstatements] - patch1;
@@ -413,76 +735,55 @@ static void ParseUntil (void)
 
 //==========================================================================
 //
-// ParseDo
+// GenDo
 //
 //==========================================================================
 
-static void ParseDo (void)
+static void GenDo (pnode_t *n)
 {
 	def_t	*e;
 	dstatement_t	*patch1;
-	int	ifOpcode;
 	def_t	tempDef;
 	int	contStatement;
 
 	patch1 = &statements[numstatements];
-	ParseStatement(SCONTEXT_DO);
-	if (LX_CheckFetch("until"))
-	{
-		ifOpcode = OP_IFNOT;
-	}
-	else
-	{
-		LX_Require("while");
-		ifOpcode = OP_IF;
-	}
-	LX_Require("(");
+	GenStatement(n->a, SCONTEXT_DO);
 	contStatement = numstatements;
-	e = EX_Expression(TOP_PRIORITY);
-	LX_Require(")");
-	LX_Require(";");
+	e = EX_GenExpression(n->b);
+	lx_SourceLine = n->line;
 	tempDef.ofs = patch1 - &statements[numstatements];
-	CO_GenCode(&pr_opcodes[ifOpcode], e, &tempDef);
+	CO_GenCode(&pr_opcodes[n->op], e, &tempDef);
 	FixContinues(contStatement);
 	FixBreaks();
 }
 
 //==========================================================================
 //
-// ParseIf
+// GenIf
 //
 //==========================================================================
 
-static void ParseIf (void)
+static void GenIf (pnode_t *n)
 {
 	def_t	*e;
 	dstatement_t	*patch1, *patch2;
-	int	ifOpcode;
-
-	if (LX_CheckFetch("not"))
-	{
-		ifOpcode = OP_IF;
-	}
-	else
-	{
-		ifOpcode = OP_IFNOT;
-	}
+	pnode_t	*elseNode;
 
-	LX_Require("(");
-	e = EX_Expression(TOP_PRIORITY);
-	LX_Require(")");
+	e = GenCondition(n->a);
 
 	patch1 = &statements[numstatements];
-	CO_GenCode(&pr_opcodes[ifOpcode], e, NULL);
+	CO_GenCode(&pr_opcodes[n->op], e, NULL);
 
-	ParseStatement(SCONTEXT_IF);
+	GenStatement(n->b, SCONTEXT_IF);
 
-	if (LX_CheckFetch("else"))
+	if (n->c)
 	{
+		elseNode = NODE(n->c);
+		lx_SourceLine = elseNode->line;
 		patch2 = &statements[numstatements];
 		CO_GenCode(&pr_opcodes[OP_GOTO], NULL, NULL);
 		patch1->b = &statements[numstatements] - patch1;
-		ParseStatement(SCONTEXT_ELSE);
+		GenStatement(elseNode->a, SCONTEXT_ELSE);
 		patch2->a = &statements[numstatements] - patch2;
 	}
 	else
@@ -493,23 +794,28 @@ static void ParseIf (void)
 
 //==========================================================================
 //
-// ParseLocalDefs
+// GenLocalDefs
 //
 //==========================================================================
 
-static void ParseLocalDefs (void)
+static void GenLocalDefs (pnode_t *n)
 {
-	CO_ParseDefs();
+	int		defs;
+
+	for (defs = n->a; defs; defs = NODE(defs)->next)
+	{
+		CO_GenDefs(defs);
+	}
 	locals_end = numpr_globals;
 }
 
 //==========================================================================
 //
-// ParseSwitch
+// GenSwitch
 //
 //==========================================================================
 
-static void ParseSwitch (void)
+static void GenSwitch (pnode_t *n)
 {
 	int		i;
 	def_t	*e;
@@ -521,9 +827,7 @@ static void ParseSwitch (void)
 	int	defaultStatement;
 	etype_t	switchType;
 
-	LX_Require("(");
-	e = EX_Expression(TOP_PRIORITY);
-	LX_Require(")");
+	e = GenCondition(n->a);
 	switchType = e->type->type;
 	switch (switchType)
 	{
@@ -548,7 +852,8 @@ static void ParseSwitch (void)
 	}
 	patch = &statements[numstatements];
 	CO_GenCode(&pr_opcodes[opcode], e, NULL);
-	ParseStatement(SCONTEXT_SWITCH);
+	GenStatement(n->b, SCONTEXT_SWITCH);
+	lx_SourceLine = n->line;
 
 	// Switch opcode fixup
 	patch->b = &statements[numstatements]-patch;
@@ -611,34 +916,34 @@ static void ParseSwitch (void)
 
 //==========================================================================
 //
-// ParseCase
+// GenCase
 //
 //==========================================================================
 
-static void ParseCase (void)
+static void GenCase (pnode_t *n)
 {
 	def_t	*e;
 	def_t	*e2;
+	int		value;
+	int		end;
 
-	do
+	for (value = n->a; value; value = NODE(value)->next)
 	{
-		e = EX_Expression(TOP_PRIORITY);
-		if (TK_CHECK(TK_RANGE))
+		end = NODE(value)->b;
+		e = EX_GenExpression(NODE(value)->a);
+		e2 = NULL;
+		if (end)
 		{
-			e2 = EX_Expression(TOP_PRIORITY);
+			e2 = EX_GenExpression(end);
+			lx_SourceLine = NODE(value)->line;
 			if (e->type->type != ev_float || e2->type->type != ev_float)
 			{
 				PR_ParseError("type mismatch for case range");
 			}
 		}
-		else
-		{
-			e2 = NULL;
-		}
+		lx_SourceLine = NODE(value)->line;
 		AddCase(e->type->type, e, e2, false);
-	} while (TK_CHECK(TK_COMMA));
-
-	LX_Require(":");
+	}
 }
 
 //==========================================================================
@@ -684,18 +989,6 @@ static int GetCaseInfo (caseInfo_t **info)
 	return count;
 }
 
-//==========================================================================
-//
-// ParseBreak
-//
-//==========================================================================
-
-static void ParseBreak (void)
-{
-	LX_Require(";");
-	AddBreak();
-}
-
 //==========================================================================
 //
 // AddBreak
@@ -738,50 +1031,6 @@ static void FixBreaks (void)
 	}
 }
 
-//==========================================================================
-//
-// BreakAncestor
-//
-//==========================================================================
-
-static qboolean BreakAncestor (void)
-{
-	int		i;
-
-	for (i = 0; i < StatementIndex; i++)
-	{
-		if (BreakAllowed[ContextHistory[i]])
-		{
-			return true;
-		}
-	}
-	return false;
-}
-
-//==========================================================================
-//
-// ParseDefault
-//
-//==========================================================================
-
-static void ParseDefault (void)
-{
-	LX_Require(":");
-	AddCase(ev_void, NULL, NULL, true);
-}
-
-//==========================================================================
-//
-// ParseContinue
-//
-//==========================================================================
-
-static void ParseContinue (void)
-{
-	LX_Require(";");
-	AddContinue();
-}
-
 //==========================================================================
 //
 // AddContinue
@@ -826,42 +1075,21 @@ static void FixContinues (int statement)
 
 //==========================================================================
 //
-// ContinueAncestor
+// GenThinktime
 //
 //==========================================================================
 
-static qboolean ContinueAncestor (void)
-{
-	int		i;
-
-	for (i = 0; i < StatementIndex; i++)
-	{
-		if (ContinueAllowed[ContextHistory[i]])
-		{
-			return true;
-		}
-	}
-	return false;
-}
-
-//==========================================================================
-//
-// ParseThinktime
-//
-//==========================================================================
-
-static void ParseThinktime (void)
+static void GenThinktime (pnode_t *n)
 {
 	def_t	*expr1;
 	def_t	*expr2;
 
-	expr1 = EX_Expression(TOP_PRIORITY);
-	LX_Require(":");
-	expr2 = EX_Expression(TOP_PRIORITY);
+	expr1 = EX_GenExpression(n->a);
+	expr2 = EX_GenExpression(n->b);
+	lx_SourceLine = n->line;
 	if (expr1->type->type != ev_entity || expr2->type->type != ev_float)
 	{
 		PR_ParseError("type mismatch for thinktime");
 	}
-	LX_Require(";");
 	CO_GenCode(&pr_opcodes[OP_THINKTIME], expr1, expr2);
 }
@@ -0,0 +1,379 @@
+/* tree.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// HEADER FILES ------------------------------------------------------------
+
+#include "q_stdinc.h"
+#include "compiler.h"
+#include "arch_def.h"
+#include "cmdlib.h"
+#include "hcc.h"
+
+// MACROS ------------------------------------------------------------------
+
+#define TREE_VERSION	1
+
+// TYPES -------------------------------------------------------------------
+
+typedef struct
+{
+	int	version;
+	int	numnodes;
+	int	numptypes;
+	int	strofs;
+	plist_t	top;
+	int	endimmediate;
+} treeheader_t;
+
+// EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
+
+// PUBLIC FUNCTION PROTOTYPES ----------------------------------------------
+
+// PRIVATE FUNCTION PROTOTYPES ---------------------------------------------
+
+static void *Grow(void *p, int count, int *maxcount, int size);
+
+// EXTERNAL DATA DECLARATIONS ----------------------------------------------
+
+// PUBLIC DATA DEFINITIONS -------------------------------------------------
+
+// PRIVATE DATA DEFINITIONS ------------------------------------------------
+
+// CODE --------------------------------------------------------------------
+
+//==========================================================================
+//
+// TR_InitUnit
+//
+// Node 0 stands for no node, string 0 is "" and the first ptypes are the
+// simple types and the union.
+//
+//==========================================================================
+
+void TR_InitUnit (punit_t *unit)
+{
+	int		i;
+	ptype_t	*t;
+
+	memset(unit, 0, sizeof(*unit));
+	unit->maxnodes = 1024;
+	unit->nodes = (pnode_t *) SafeMalloc(unit->maxnodes*sizeof(pnode_t));
+	unit->numnodes = 1;
+	unit->maxptypes = 64;
+	unit->ptypes = (ptype_t *) SafeMalloc(unit->maxptypes*sizeof(ptype_t));
+	for (i = 0; i < PT_FIRSTCOMPLEX; i++)
+	{
+		t = &unit->ptypes[i];
+		t->type = (i == PT_UNION) ? ev_void : (etype_t) i;
+		t->aux_type = -1;
+	}
+	unit->numptypes = PT_FIRSTCOMPLEX;
+	unit->maxstrings = 4096;
+	unit->strings = (char *) SafeMalloc(unit->maxstrings);
+	unit->strofs = 1;
+}
+
+//==========================================================================
+//
+// TR_FreeUnit
+//
+//==========================================================================
+
+void TR_FreeUnit (punit_t *unit)
+{
+	free(unit->nodes);
+	free(unit->ptypes);
+	free(unit->strings);
+	free(unit->types);
+	memset(unit, 0, sizeof(*unit));
+}
+
+//==========================================================================
+//
+// Grow
+//
+// Doubles an array of the unit when it is full.
+//
+//==========================================================================
+
+static void *Grow (void *p, int count, int *maxcount, int size)
+{
+	if (count < *maxcount)
+	{
+		return p;
+	}
+	*maxcount *= 2;
+	p = realloc(p, *maxcount*size);
+	if (!p)
+	{
+		COM_Error("%s: out of memory", __thisfunc__);
+	}
+	return p;
+}
+
+//==========================================================================
+//
+// TR_NewNode
+//
+// Adds a node to the unit being parsed.  It gets the current source line.
+// The node array can move: take node pointers again after adding nodes.
+//
+//==========================================================================
+
+int TR_NewNode (int kind, int op, int a, int b, int c)
+{
+	pnode_t	*n;
+
+	pr_unit->nodes = (pnode_t *) Grow(pr_unit->nodes, pr_unit->numnodes,
+					&pr_unit->maxnodes, sizeof(pnode_t));
+	n = &pr_unit->nodes[pr_unit->numnodes];
+	memset(n, 0, sizeof(*n));
+	n->kind = kind;
+	n->op = op;
+	n->line = lx_SourceLine;
+	n->a = a;
+	n->b = b;
+	n->c = c;
+	return pr_unit->numnodes++;
+}
+
+//==========================================================================
+//
+// TR_AddToList
+//
+//==========================================================================
+
+void TR_AddToList (plist_t *list, int node)
+{
+	if (list->first == 0)
+	{
+		list->first = node;
+	}
+	else
+	{
+		NODE(list->last)->next = node;
+	}
+	list->last = node;
+}
+
+//==========================================================================
+//
+// TR_NewString
+//
+//==========================================================================
+
+int TR_NewString (const char *str)
+{
+	int		ofs;
+	int		len;
+
+	len = strlen(str)+1;
+	while (pr_unit->strofs+len > pr_unit->maxstrings)
+	{
+		pr_unit->maxstrings *= 2;
+		pr_unit->strings = (char *) realloc(pr_unit->strings, pr_unit->maxstrings);
+		if (!pr_unit->strings)
+		{
+			COM_Error("%s: out of memory", __thisfunc__);
+		}
+	}
+	ofs = pr_unit->strofs;
+	memcpy(pr_unit->strings+ofs, str, len);
+	pr_unit->strofs += len;
+	return ofs;
+}
+
+//==========================================================================
+//
+// TR_NewType
+//
+// Returns the index of a matching ptype of the unit, or adds one.
+//
+//==========================================================================
+
+int TR_NewType (const ptype_t *type)
+{
+	ptype_t	*check;
+	int		i, j;
+
+	for (i = PT_FIRSTCOMPLEX; i < pr_unit->numptypes; i++)
+	{
+		check = &pr_unit->ptypes[i];
+		if (check->type != type->type ||
+		    check->aux_type != type->aux_type ||
+		    check->num_parms != type->num_parms)
+		{
+			continue;
+		}
+		for (j = 0; j < type->num_parms; j++)
+		{
+			if (check->parm_types[j] != type->parm_types[j])
+				break;
+		}
+		if (j >= type->num_parms)
+		{
+			return i;
+		}
+	}
+
+	pr_unit->ptypes = (ptype_t *) Grow(pr_unit->ptypes, pr_unit->numptypes,
+					&pr_unit->maxptypes, sizeof(ptype_t));
+	pr_unit->ptypes[pr_unit->numptypes] = *type;
+	return pr_unit->numptypes++;
+}
+
+//==========================================================================
+//
+// TR_AddError
+//
+// Keeps a parse error in the definitions of the file, for CO_GenFile()
+// to report it with the errors of the code generation, in their order.
+//
+//==========================================================================
+
+void TR_AddError (const char *message)
+{
+	TR_AddToList(&pr_unit->top,
+		TR_NewNode(PN_ERROR, 0, TR_NewString(message), 0, 0));
+}
+
+//==========================================================================
+//
+// TR_ResolveTypes
+//
+// Finds the types of the compilation for the ptypes of pr_unit.  The
+// ptypes only refer to the ones before them.
+//
+//==========================================================================
+
+void TR_ResolveTypes (void)
+{
+	static type_t *simpleTypes[PT_FIRSTCOMPLEX] =
+	{
+		&type_void, &type_string, &type_float,
+		&type_vector, &type_entity, &type_union
+	};
+	int		i, j;
+	ptype_t	*pt;
+	type_t	newtype;
+
+	free(pr_unit->types);
+	pr_unit->types = (type_t **) SafeMalloc(pr_unit->numptypes*sizeof(type_t *));
+	for (i = 0; i < PT_FIRSTCOMPLEX; i++)
+	{
+		pr_unit->types[i] = simpleTypes[i];
+	}
+	for ( ; i < pr_unit->numptypes; i++)
+	{
+		pt = &pr_unit->ptypes[i];
+		memset(&newtype, 0, sizeof(newtype));
+		newtype.type = pt->type;
+		if (pt->aux_type != -1)
+		{
+			newtype.aux_type = pr_unit->types[pt->aux_type];
+		}
+		newtype.num_parms = pt->num_parms;
+		for (j = 0; j < pt->num_parms; j++)
+		{
+			newtype.parm_types[j] = pr_unit->types[pt->parm_types[j]];
+		}
+		pr_unit->types[i] = PR_FindType(&newtype);
+	}
+}
+
+//==========================================================================
+//
+// TR_SaveUnit
+//
+// Returns the unit in one block, for the build cache.
+//
+//==========================================================================
+
+void *TR_SaveUnit (const punit_t *unit, int *size)
+{
+	treeheader_t	*header;
+	byte	*data, *p;
+
+	*size = sizeof(treeheader_t)
+		+ unit->numnodes*sizeof(pnode_t)
+		+ unit->numptypes*sizeof(ptype_t)
+		+ unit->strofs;
+	data = (byte *) SafeMalloc(*size);
+	header = (treeheader_t *) data;
+	header->version = TREE_VERSION;
+	header->numnodes = unit->numnodes;
+	header->numptypes = unit->numptypes;
+	header->strofs = unit->strofs;
+	header->top = unit->top;
+	header->endimmediate = unit->endimmediate;
+	p = data + sizeof(treeheader_t);
+	memcpy(p, unit->nodes, unit->numnodes*sizeof(pnode_t));
+	p += unit->numnodes*sizeof(pnode_t);
+	memcpy(p, unit->ptypes, unit->numptypes*sizeof(ptype_t));
+	p += unit->numptypes*sizeof(ptype_t);
+	memcpy(p, unit->strings, unit->strofs);
+	return data;
+}
+
+//==========================================================================
+//
+// TR_LoadUnit
+//
+// Makes a unit of a block from TR_SaveUnit().  Returns false if the block
+// isn't one.
+//
+//==========================================================================
+
+qboolean TR_LoadUnit (punit_t *unit, const void *data, int size)
+{
+	treeheader_t	header;
+	const byte	*p;
+
+	if (size < (int)sizeof(treeheader_t))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if (header.version != TREE_VERSION
+		|| header.numnodes < 1 || header.numptypes < PT_FIRSTCOMPLEX
+		|| header.strofs < 1
+		|| size != (int)(sizeof(treeheader_t)
+				+ header.numnodes*sizeof(pnode_t)
+				+ header.numptypes*sizeof(ptype_t)
+				+ header.strofs))
+	{
+		return false;
+	}
+
+	memset(unit, 0, sizeof(*unit));
+	unit->numnodes = unit->maxnodes = header.numnodes;
+	unit->numptypes = unit->maxptypes = header.numptypes;
+	unit->strofs = unit->maxstrings = header.strofs;
+	unit->top = header.top;
+	unit->endimmediate = header.endimmediate;
+	p = (const byte *) data + sizeof(treeheader_t);
+	unit->nodes = (pnode_t *) SafeMalloc(unit->numnodes*sizeof(pnode_t));
+	memcpy(unit->nodes, p, unit->numnodes*sizeof(pnode_t));
+	p += unit->numnodes*sizeof(pnode_t);
+	unit->ptypes = (ptype_t *) SafeMalloc(unit->numptypes*sizeof(ptype_t));
+	memcpy(unit->ptypes, p, unit->numptypes*sizeof(ptype_t));
+	p += unit->numptypes*sizeof(ptype_t);
+	unit->strings = (char *) SafeMalloc(unit->strofs);
+	memcpy(unit->strings, p, unit->strofs);
+	return true;
+}
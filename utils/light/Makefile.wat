@@ -54,7 +54,8 @@ OBJ_COMMON= qsnprint.obj &
 	util_io.obj &
 	pathutil.obj &
 	mathlib.obj &
-	bspfile.obj
+	bspfile.obj &
+	buildcache.obj
 
 OBJ_LIGHT= threads.obj &
 	entities.obj &
@@ -29,6 +29,7 @@
 #include "bspfile.h"
 #include "entities.h"
 #include "threads.h"
+#include "buildcache.h"
 #include "light.h"
 
 qboolean	extrasamples;
@@ -38,7 +39,6 @@ float		scalecos	= 0.5F;
 float		rangescale	= 0.5F;
 
 //dmodel_t	*bspmodel;
-int		bspfileface;	// next surface to dispatch
 vec3_t		bsp_origin;
 
 byte		*filebase;
@@ -47,15 +47,73 @@ static byte	*file_p, *file_end;
 float		minlights[MAX_MAP_FACES];
 
 
-byte *GetFileSpace (int size)
+/*
+=============================================================================
+
+FACE SCHEDULING
+
+The faces are handed out to the threads most expensive first, so that a
+big face doesn't start last and keep one thread busy after the others are
+done.  Each face's light is kept apart until all are done, and then put
+in the light lump in face order, so the output doesn't depend on the order
+the faces were done in.
+
+=============================================================================
+*/
+
+static int	*faceorder;	// most expensive first
+static int	*facecosts;
+static int	nextface;	// next in faceorder to dispatch
+static byte	**facelight;
+static int	*facelightsize;
+
+static int CostCompare (const void *a, const void *b)
+{
+	int		f1 = *(const int *)a, f2 = *(const int *)b;
+
+	if (facecosts[f1] != facecosts[f2])
+		return facecosts[f2] - facecosts[f1];
+	return f1 - f2;
+}
+
+static void SetupFaceOrder (void)
+{
+	int		i;
+
+	faceorder = (int *) SafeMalloc (numfaces * sizeof(int));
+	facecosts = (int *) SafeMalloc (numfaces * sizeof(int));
+	for (i = 0 ; i < numfaces ; i++)
+	{
+		faceorder[i] = i;
+		facecosts[i] = FaceCost (i);
+	}
+	qsort (faceorder, numfaces, sizeof(int), CostCompare);
+
+	facelight = (byte **) SafeMalloc (numfaces * sizeof(byte *));
+	facelightsize = (int *) SafeMalloc (numfaces * sizeof(int));
+}
+
+/*
+=============
+GetFaceSpace
+
+Returns room for the size bytes of light of a face
+=============
+*/
+byte *GetFaceSpace (int surfnum, int size)
+{
+	facelight[surfnum] = (byte *) SafeMalloc (size);
+	facelightsize[surfnum] = size;
+	return facelight[surfnum];
+}
+
+static byte *GetFileSpace (int size)
 {
 	byte	*buf;
 
-	ThreadLock();
 	file_p = (byte *)(((intptr_t)file_p + 3) & ~3);
 	buf = file_p;
 	file_p += size;
-	ThreadUnlock();
 	if (file_p > file_end)
 		COM_Error ("%s: overrun", __thisfunc__);
 	return buf;
@@ -70,15 +128,15 @@ void LightThread (void *junk)
 	while (1)
 	{
 		ThreadLock();
-		i = bspfileface++;
+		i = nextface++;
 		ThreadUnlock();
 		if (i >= numfaces)
 			return;
 
 		if (is_bsp2)
-			LightFace2 (i);
+			LightFace2 (faceorder[i]);
 		else
-			LightFace (i);
+			LightFace (faceorder[i]);
 	}
 }
 
@@ -89,17 +147,109 @@ LightWorld
 */
 static void LightWorld (void)
 {
+	int		i;
+	byte	*out;
+
 	filebase = file_p = dlightdata;
 	file_end = filebase + MAX_MAP_LIGHTING;
+// the alignment gaps from GetFileSpace would keep the old map's bytes
+	memset (dlightdata, 0, MAX_MAP_LIGHTING);
+
+	SetupFaceOrder ();
 
 	RunThreadsOn (LightThread);
 
+	for (i = 0 ; i < numfaces ; i++)
+	{
+		if (!facelight[i])
+			continue;
+		out = GetFileSpace (facelightsize[i]);
+		memcpy (out, facelight[i], facelightsize[i]);
+		free (facelight[i]);
+		if (is_bsp2)
+			dfaces2[i].lightofs = out - filebase;
+		else
+			dfaces[i].lightofs = out - filebase;
+	}
+
 	lightdatasize = file_p - filebase;
 
 	printf ("lightdatasize: %i\n", lightdatasize);
 }
 
 
+/*
+========
+LightInputHash
+
+Everything the light data is made from: the geometry, the lights and the
+options, and the vis data when the lights are culled by it
+========
+*/
+static void LightInputHash (char *out)
+{
+	buildhash_t	hash;
+	entity_t	*e;
+	int		i;
+
+	Hash_Init (&hash);
+	Hash_String (&hash, "light 1");
+	Hash_Int (&hash, extrasamples);
+	Hash_Float (&hash, scaledist);
+	Hash_Float (&hash, rangescale);
+	Hash_Int (&hash, pvscull);
+
+	Hash_BSPGeometry (&hash);
+	if (pvscull)
+		Hash_BSPVis (&hash);
+
+	for (i = 0, e = entities ; i < num_entities ; i++, e++)
+	{
+		if (!e->light)
+			continue;
+		Hash_Int (&hash, i);
+		Hash_Float (&hash, e->origin[0]);
+		Hash_Float (&hash, e->origin[1]);
+		Hash_Float (&hash, e->origin[2]);
+		Hash_Int (&hash, e->light);
+		Hash_Int (&hash, e->style);
+		Hash_Float (&hash, e->angle);
+		if (e->targetent)
+		{
+			Hash_Float (&hash, e->targetent->origin[0]);
+			Hash_Float (&hash, e->targetent->origin[1]);
+			Hash_Float (&hash, e->targetent->origin[2]);
+		}
+		else
+			Hash_String (&hash, "notarget");
+	}
+
+	Hash_Hex (&hash, out);
+}
+
+/*
+========
+LightingUpToDate
+
+True if the light data in the bsp file is what light made the last time
+from the same input
+========
+*/
+static qboolean LightingUpToDate (const char *input)
+{
+	buildhash_t	hash;
+	char		hex[HASH_STRLEN];
+
+	if (!Cache_Match ("light:input", input))
+		return false;
+
+	Hash_Init (&hash);
+	Hash_BSPLighting (&hash);
+	Hash_Hex (&hash, hex);
+	return Cache_Match ("light:output", hex);
+}
+
+
 /*
 ========
 main
@@ -113,12 +263,19 @@ int main (int argc, char **argv)
 	int		wantthreads;
 	double		start, end;
 	char		source[1024];
+	char		cachefile[1024];
+	char		input[HASH_STRLEN], output[HASH_STRLEN];
+	buildhash_t	hash;
+	qboolean	nocache;
+	char		*oldentdata;
+	int		oldentdatasize;
 
 	printf ("----- LightFaces ----\n");
 
 	ValidateByteorder ();
 
 	wantthreads = -1;		// default to auto-detect.
+	nocache = false;
 
 	for (i = 1 ; i < argc ; i++)
 	{
@@ -145,6 +302,15 @@ int main (int argc, char **argv)
 				COM_Error("Missing argument to \"%s\"", argv[i]);
 			rangescale = (float)atof (argv[++i]);
 		}
+		else if (!strcmp(argv[i],"-pvs"))
+		{
+			pvscull = true;
+			printf ("lights culled by pvs\n");
+		}
+		else if (!strcmp(argv[i],"-nocache"))
+		{
+			nocache = true;
+		}
 		else if (argv[i][0] == '-')
 			COM_Error ("Unknown option \"%s\"", argv[i]);
 		else
@@ -152,7 +318,7 @@ int main (int argc, char **argv)
 	}
 
 	if (i != argc - 1)
-		COM_Error ("usage: light [-threads num] [-extra] [-dist ?] [-range ?] bspfile");
+		COM_Error ("usage: light [-threads num] [-extra] [-dist ?] [-range ?] [-pvs] [-nocache] bspfile");
 
 	InitThreads (wantthreads, 0);
 
@@ -162,15 +328,53 @@ int main (int argc, char **argv)
 	StripExtension (source);
 	DefaultExtension (source, ".bsp", sizeof(source));
 
+	strcpy (cachefile, argv[i]);
+	StripExtension (cachefile);
+	strcat (cachefile, ".bcache");
+
 	LoadBSPFile (source);
 	LoadEntities ();
 
+	Cache_Load (cachefile);
+	LightInputHash (input);
+
+// if only the entities that aren't lights changed, the light data is
+// still good and only the entities need writing back
+	if (!nocache && LightingUpToDate (input))
+	{
+		oldentdatasize = entdatasize;
+		oldentdata = (char *) SafeMalloc (oldentdatasize);
+		memcpy (oldentdata, dentdata, oldentdatasize);
+
+		WriteEntitiesToString ();
+		if (entdatasize == oldentdatasize && !memcmp (dentdata, oldentdata, entdatasize))
+			printf ("%s: lighting is up to date\n", source);
+		else
+		{
+			printf ("%s: lighting is up to date, updating entities\n", source);
+			WriteBSPFile (source, is_bsp2);
+		}
+		free (oldentdata);
+
+		end = COM_GetTime ();
+		printf ("%5.1f seconds elapsed\n", end-start);
+		return 0;
+	}
+
 	MakeTnodes (&dmodels[0]);
+	SetupLights ();
 
 	LightWorld ();
 
+	Hash_Init (&hash);
+	Hash_BSPLighting (&hash);
+	Hash_Hex (&hash, output);
+	Cache_SetString ("light:input", input);
+	Cache_SetString ("light:output", output);
+
 	WriteEntitiesToString ();
 	WriteBSPFile (source, is_bsp2);
+	Cache_Save ();
 
 	end = COM_GetTime ();
 	printf ("%5.1f seconds elapsed\n", end-start);
@@ -38,9 +38,16 @@ extern	float		minlights[MAX_MAP_FACES];
 
 extern	qboolean	extrasamples;
 
-byte	*GetFileSpace (int size);
+extern	qboolean	pvscull;
+
+#define	MAX_PACKET	8	// lines traced together by TestLines
+
+byte	*GetFaceSpace (int surfnum, int size);
 
 qboolean TestLine (const vec3_t start, const vec3_t stop);
+int	TestLines (const vec3_t start, const vec3_t *stops, int numstops);
+void	SetupLights (void);
+int	FaceCost (int surfnum);
 void	LightFace (int surfnum);
 void	LightFace2 (int surfnum);
 void	MakeTnodes (dmodel_t *bm);
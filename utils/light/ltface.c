@@ -30,21 +30,15 @@
 
 /*
 ============
-CastRay
+RayLength
 
-Returns the distance between the points, or -1 if blocked
+Returns the distance between the points
 =============
 */
-static double CastRay (vec3_t p1, vec3_t p2)
+static double RayLength (const vec3_t p1, const vec3_t p2)
 {
 	int		i;
 	double	t;
-	qboolean	trace;
-
-	trace = TestLine (p1, p2);
-
-	if (!trace)
-		return -1;		// ray was blocked
 
 	t = 0;
 	for (i = 0 ; i < 3 ; i++)
@@ -56,6 +50,21 @@ static double CastRay (vec3_t p1, vec3_t p2)
 	return sqrt(t);
 }
 
+/*
+============
+CastRay
+
+Returns the distance between the points, or -1 if blocked
+=============
+*/
+static double CastRay (vec3_t p1, vec3_t p2)
+{
+	if (!TestLine (p1, p2))
+		return -1;		// ray was blocked
+
+	return RayLength (p1, p2);
+}
+
 
 /*
 ===============================================================================
@@ -79,6 +88,7 @@ towards the center until it is valid.
 */
 
 #define	SINGLEMAP	(18*18*4)
+#define	MAX_FACELEAFS	64
 
 typedef struct
 {
@@ -90,6 +100,10 @@ typedef struct
 
 	int		numsurfpt;
 	vec3_t	surfpt[SINGLEMAP];
+	vec3_t	surfmins, surfmaxs;	// bounds of surfpt
+
+	int		numleafs;	// -1 if too many to cull by
+	int		leafs[MAX_FACELEAFS];	// holding the face or its points
 
 	vec3_t	texorg;
 	vec3_t	worldtotex[2];	// s = (world - texorg) . worldtotex[0]
@@ -294,6 +308,8 @@ static void CalcPoints (lightinfo_t *l)
 	int		i;
 	int		s, t, j;
 	int		w, h, step;
+	int		c, n, clear;
+	byte	good[SINGLEMAP];
 	double	starts, startt, us, ut;
 	double	*surf;
 	double	mids, midt;
@@ -329,12 +345,38 @@ static void CalcPoints (lightinfo_t *l)
 	}
 
 	l->numsurfpt = w * h;
+
+// the grid points are tried from facemid in packets first
 	for (t = 0 ; t < h ; t++)
 	{
 		for (s = 0 ; s < w ; s++, surf+=3)
 		{
 			us = starts + s*step;
 			ut = startt + t*step;
+			for (j = 0 ; j < 3 ; j++)
+				surf[j] = l->texorg[j] + l->textoworld[0][j]*us + l->textoworld[1][j]*ut;
+		}
+	}
+	for (c = 0 ; c < l->numsurfpt ; c += MAX_PACKET)
+	{
+		n = l->numsurfpt - c;
+		if (n > MAX_PACKET)
+			n = MAX_PACKET;
+		clear = TestLines (facemid, l->surfpt + c, n);
+		for (i = 0 ; i < n ; i++)
+			good[c+i] = (clear >> i) & 1;
+	}
+
+	surf = l->surfpt[0];
+	for (t = 0 ; t < h ; t++)
+	{
+		for (s = 0 ; s < w ; s++, surf+=3)
+		{
+			if (good[t*w+s])
+				continue;
+
+			us = starts + s*step;
+			ut = startt + t*step;
 
 		// if a line can be traced from surf to facemid, the point is good
 			for (i = 0 ; i < 6 ; i++)
@@ -343,7 +385,7 @@ static void CalcPoints (lightinfo_t *l)
 				for (j = 0 ; j < 3 ; j++)
 					surf[j] = l->texorg[j] + l->textoworld[0][j]*us + l->textoworld[1][j]*ut;
 
-				if (CastRay (facemid, surf) != -1)
+				if (i > 0 && CastRay (facemid, surf) != -1)
 					break;	// got it
 
 				if (i & 1)
@@ -386,6 +428,295 @@ static void CalcPoints (lightinfo_t *l)
 			//	c_bad++;
 		}
 	}
+
+	VectorCopy (l->surfpt[0], l->surfmins);
+	VectorCopy (l->surfpt[0], l->surfmaxs);
+	for (i = 1 ; i < l->numsurfpt ; i++)
+	{
+		for (j = 0 ; j < 3 ; j++)
+		{
+			if (l->surfpt[i][j] < l->surfmins[j])
+				l->surfmins[j] = l->surfpt[i][j];
+			if (l->surfpt[i][j] > l->surfmaxs[j])
+				l->surfmaxs[j] = l->surfpt[i][j];
+		}
+	}
+}
+
+
+/*
+===============================================================================
+
+LIGHT CULLING
+
+Most lights are far from most faces.  A light is skipped for a face when
+it can't reach the nearest point of the bounds of the sample points, which
+changes nothing.  With -pvs, it is also skipped when the empty leaf it is
+in can't see any leaf that holds the face or one of its sample points, if
+those are all empty too.  That needs a vised bsp, and loses the light that
+shines through sky or liquid, which vis doesn't see through but the light
+tracing does.
+
+===============================================================================
+*/
+
+qboolean	pvscull;
+
+static int		numlights;
+static entity_t		**lights;
+static byte		**lightpvs;	// decompressed, NULL if not known
+static int		*faceleafstart;	// [numfaces+1] into faceleaflist
+static int		*faceleaflist;
+
+static int PointInLeaf (const vec3_t point)
+{
+	int		num;
+	double	d;
+	dplane_t	*plane;
+
+	num = 0;
+	while (num >= 0)
+	{
+		if (is_bsp2)
+		{
+			plane = dplanes + dnodes2[num].planenum;
+			d = DotProduct (point, plane->normal) - plane->dist;
+			num = dnodes2[num].children[d < 0];
+		}
+		else
+		{
+			plane = dplanes + dnodes[num].planenum;
+			d = DotProduct (point, plane->normal) - plane->dist;
+			num = dnodes[num].children[d < 0];
+		}
+	}
+
+	return -num - 1;
+}
+
+static int LeafContents (int leafnum)
+{
+	return is_bsp2 ? dleafs2[leafnum].contents : dleafs[leafnum].contents;
+}
+
+static byte *DecompressVis (int leafnum)
+{
+	int		c, row, visofs;
+	byte	*in, *out, *vis;
+
+	visofs = is_bsp2 ? dleafs2[leafnum].visofs : dleafs[leafnum].visofs;
+	if (LeafContents (leafnum) != CONTENTS_EMPTY || visofs < 0 || visofs >= visdatasize)
+		return NULL;
+
+	row = (dmodels[0].visleafs + 7) >> 3;
+	vis = out = (byte *) SafeMalloc (row);
+	in = dvisdata + visofs;
+	while (out - vis < row)
+	{
+		if (*in)
+		{
+			*out++ = *in++;
+			continue;
+		}
+		c = in[1];
+		in += 2;
+		if (out - vis + c > row)
+			c = row - (out - vis);
+		memset (out, 0, c);
+		out += c;
+	}
+
+	return vis;
+}
+
+/*
+=============
+SetupLights
+
+Collects the light entities, and with -pvs what their leafs can see
+=============
+*/
+void SetupLights (void)
+{
+	int		i, j, leaf, numleafs, first, count;
+	int		*counts;
+
+	lights = (entity_t **) SafeMalloc (num_entities * sizeof(entity_t *));
+	numlights = 0;
+	for (i = 0 ; i < num_entities ; i++)
+	{
+		if (entities[i].light)
+			lights[numlights++] = &entities[i];
+	}
+	printf ("%i lights\n", numlights);
+
+	if (!pvscull)
+		return;
+	if (!visdatasize)
+	{
+		printf ("no vis data, -pvs ignored\n");
+		pvscull = false;
+		return;
+	}
+
+	lightpvs = (byte **) SafeMalloc (numlights * sizeof(byte *));
+	for (i = 0 ; i < numlights ; i++)
+		lightpvs[i] = DecompressVis (PointInLeaf (lights[i]->origin));
+
+// the leafs each face is marked in
+	numleafs = dmodels[0].visleafs + 1;
+	counts = (int *) SafeMalloc ((numfaces + 1) * sizeof(int));
+	for (i = 1 ; i < numleafs ; i++)
+	{
+		first = is_bsp2 ? (int)dleafs2[i].firstmarksurface : dleafs[i].firstmarksurface;
+		count = is_bsp2 ? (int)dleafs2[i].nummarksurfaces : dleafs[i].nummarksurfaces;
+		for (j = 0 ; j < count ; j++)
+			counts[is_bsp2 ? dmarksurfaces2[first+j] : dmarksurfaces[first+j]]++;
+	}
+	faceleafstart = (int *) SafeMalloc ((numfaces + 1) * sizeof(int));
+	for (i = 0 ; i < numfaces ; i++)
+		faceleafstart[i+1] = faceleafstart[i] + counts[i];
+	faceleaflist = (int *) SafeMalloc ((faceleafstart[numfaces] + 1) * sizeof(int));
+	memset (counts, 0, (numfaces + 1) * sizeof(int));
+	for (leaf = 1 ; leaf < numleafs ; leaf++)
+	{
+		first = is_bsp2 ? (int)dleafs2[leaf].firstmarksurface : dleafs[leaf].firstmarksurface;
+		count = is_bsp2 ? (int)dleafs2[leaf].nummarksurfaces : dleafs[leaf].nummarksurfaces;
+		for (j = 0 ; j < count ; j++)
+		{
+			i = is_bsp2 ? dmarksurfaces2[first+j] : dmarksurfaces[first+j];
+			faceleaflist[faceleafstart[i] + counts[i]++] = leaf;
+		}
+	}
+	free (counts);
+}
+
+static void AddFaceLeaf (lightinfo_t *l, int leaf)
+{
+	int		i;
+
+	if (l->numleafs < 0)
+		return;
+	for (i = l->numleafs - 1 ; i >= 0 ; i--)
+	{	// neighbouring points are mostly in the same leaf
+		if (l->leafs[i] == leaf)
+			return;
+	}
+	if (LeafContents (leaf) != CONTENTS_EMPTY || l->numleafs == MAX_FACELEAFS)
+		l->numleafs = -1;	// not vised or too spread out, don't cull
+	else
+		l->leafs[l->numleafs++] = leaf;
+}
+
+/*
+=============
+CullLights
+
+Fills in the lights that can reach the face, in entity order, so that the
+styles get the same slots
+=============
+*/
+static int CullLights (lightinfo_t *l, entity_t **out)
+{
+	int		i, j, count;
+	double	d, dist;
+	entity_t	*light;
+	byte	*vis;
+
+	count = 0;
+	for (i = 0 ; i < numlights ; i++)
+	{
+		light = lights[i];
+
+	// the nearest any sample point can be
+		if (scaledist > 0)
+		{
+			dist = 0;
+			for (j = 0 ; j < 3 ; j++)
+			{
+				if (light->origin[j] < l->surfmins[j])
+					d = l->surfmins[j] - light->origin[j];
+				else if (light->origin[j] > l->surfmaxs[j])
+					d = light->origin[j] - l->surfmaxs[j];
+				else
+					continue;
+				dist += d*d;
+			}
+			if (sqrt(dist) * scaledist > light->light + ON_EPSILON)
+				continue;
+		}
+
+		if (pvscull && lightpvs[i])
+		{
+			if (!l->numleafs)
+			{	// find the leafs once some light needs them
+				for (j = faceleafstart[l->surfnum] ; j < faceleafstart[l->surfnum+1] ; j++)
+					AddFaceLeaf (l, faceleaflist[j]);
+				for (j = 0 ; j < l->numsurfpt && l->numleafs >= 0 ; j++)
+					AddFaceLeaf (l, PointInLeaf (l->surfpt[j]));
+			}
+			vis = lightpvs[i];
+			for (j = 0 ; j < l->numleafs ; j++)
+			{
+				if (vis[(l->leafs[j]-1)>>3] & (1<<((l->leafs[j]-1)&7)))
+					break;
+			}
+			if (l->numleafs > 0 && j == l->numleafs)
+				continue;
+		}
+
+		out[count++] = light;
+	}
+
+	return count;
+}
+
+/*
+=============
+FaceCost
+
+A guess at the relative time lighting a face takes, for scheduling
+=============
+*/
+int FaceCost (int surfnum)
+{
+	static lightinfo_t	*l;
+	int		i, count, texinfonum, planenum, side;
+	double	dist;
+	vec3_t	rel;
+
+	if (!l)
+		l = (lightinfo_t *) SafeMalloc (sizeof(lightinfo_t));
+
+	l->face = is_bsp2 ? (void *)(dfaces2 + surfnum) : (void *)(dfaces + surfnum);
+	texinfonum = is_bsp2 ? dfaces2[surfnum].texinfo : dfaces[surfnum].texinfo;
+	planenum = is_bsp2 ? dfaces2[surfnum].planenum : dfaces[surfnum].planenum;
+	side = is_bsp2 ? dfaces2[surfnum].side : dfaces[surfnum].side;
+	if (texinfo[texinfonum].flags & TEX_SPECIAL)
+		return 0;
+
+	VectorCopy (dplanes[planenum].normal, l->facenormal);
+	l->facedist = dplanes[planenum].dist;
+	if (side)
+	{
+		VectorNegate (l->facenormal, l->facenormal);
+		l->facedist = -l->facedist;
+	}
+	if (is_bsp2)
+		CalcFaceExtents2 (l);
+	else
+		CalcFaceExtents (l);
+
+	count = 1;	// the sample points are traced anyway
+	for (i = 0 ; i < numlights ; i++)
+	{
+		VectorSubtract (lights[i]->origin, bsp_origin, rel);
+		dist = scaledist * (DotProduct (rel, l->facenormal) - l->facedist);
+		if (dist > 0 && dist <= lights[i]->light)
+			count++;
+	}
+
+	return (l->texsize[0] + 1) * (l->texsize[1] + 1) * count;
 }
 
 
@@ -413,12 +744,13 @@ static void SingleLightFace (entity_t *light, lightinfo_t *l)
 	qboolean	hit;
 	int		mapnum;
 	int		size;
-	int		c, i;
+	int		c, i, n, clear;
 	vec3_t	rel;
 	vec3_t	spotvec;
 	double	falloff;
 	double	*lightsamp;
 
+	clear = 0;
 	VectorSubtract (light->origin, bsp_origin, rel);
 	dist = scaledist * (DotProduct (rel, l->facenormal) - l->facedist);
 
@@ -475,9 +807,16 @@ static void SingleLightFace (entity_t *light, lightinfo_t *l)
 	surf = l->surfpt[0];
 	for (c = 0 ; c < l->numsurfpt ; c++, surf+=3)
 	{
-		dist = CastRay(light->origin, surf)*scaledist;
-		if (dist < 0)
+		if (!(c % MAX_PACKET))
+		{
+			n = l->numsurfpt - c;
+			if (n > MAX_PACKET)
+				n = MAX_PACKET;
+			clear = TestLines (light->origin, l->surfpt + c, n);
+		}
+		if (!(clear & (1 << (c % MAX_PACKET))))
 			continue;	// light doesn't reach
+		dist = RayLength(light->origin, surf)*scaledist;
 
 		VectorSubtract (light->origin, surf, incoming);
 		VectorNormalize (incoming);
@@ -555,6 +894,8 @@ void LightFace (int surfnum)
 {
 	dface_t	*f;
 	lightinfo_t	l;
+	entity_t	*facelights[MAX_MAP_ENTITIES];
+	int		numfacelights;
 	int		s, t;
 	int		i, j, c;
 	double	total;
@@ -607,12 +948,12 @@ void LightFace (int surfnum)
 		l.lightstyles[i] = 255;
 
 //
-// cast all lights
+// cast all lights that can reach it
 //
 	l.numlightstyles = 0;
-	for (i = 0 ; i < num_entities ; i++)
-		if (entities[i].light)
-			SingleLightFace (&entities[i], &l);
+	numfacelights = CullLights (&l, facelights);
+	for (i = 0 ; i < numfacelights ; i++)
+		SingleLightFace (facelights[i], &l);
 
 	FixMinlight (&l);
 
@@ -629,8 +970,7 @@ void LightFace (int surfnum)
 
 	lightmapsize = size*l.numlightstyles;
 
-	out = GetFileSpace (lightmapsize);
-	f->lightofs = out - filebase;
+	out = GetFaceSpace (surfnum, lightmapsize);
 
 // extra filtering
 //	h = (l.texsize[1] + 1) * 2;
@@ -669,6 +1009,8 @@ void LightFace2 (int surfnum)
 {
 	dface2_t	*f;
 	lightinfo_t	l;
+	entity_t	*facelights[MAX_MAP_ENTITIES];
+	int		numfacelights;
 	int		s, t;
 	int		i, j, c;
 	double	total;
@@ -721,12 +1063,12 @@ void LightFace2 (int surfnum)
 		l.lightstyles[i] = 255;
 
 //
-// cast all lights
+// cast all lights that can reach it
 //
 	l.numlightstyles = 0;
-	for (i = 0 ; i < num_entities ; i++)
-		if (entities[i].light)
-			SingleLightFace (&entities[i], &l);
+	numfacelights = CullLights (&l, facelights);
+	for (i = 0 ; i < numfacelights ; i++)
+		SingleLightFace (facelights[i], &l);
 
 	FixMinlight (&l);
 
@@ -743,8 +1085,7 @@ void LightFace2 (int surfnum)
 
 	lightmapsize = size*l.numlightstyles;
 
-	out = GetFileSpace (lightmapsize);
-	f->lightofs = out - filebase;
+	out = GetFaceSpace (surfnum, lightmapsize);
 
 // extra filtering
 //	h = (l.texsize[1] + 1) * 2;
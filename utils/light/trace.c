@@ -247,3 +247,162 @@ qboolean TestLine (const vec3_t start, const vec3_t stop)
 		node = tnode->children[side];
 	}
 }
+
+
+/*
+==============================================================================
+
+PACKET TRACING
+
+The lines from one light to a group of sample points start together and
+mostly go down the same nodes, so they are traced as a packet: each node
+is looked at once for all of them, and the packet only splits up where
+the lines go different ways.  Every line is cut exactly as TestLine would
+cut it, so the answers are the same.
+
+==============================================================================
+*/
+
+typedef struct
+{
+	float	front[MAX_PACKET][3];
+	float	back[MAX_PACKET][3];
+} tracepacket_t;
+
+/*
+==============
+TracePacket_r
+
+Returns the lines of mask that hit solid below node
+==============
+*/
+static int TracePacket_r (int node, int mask, const tracepacket_t *p)
+{
+	int		i, bit, side, mask0, mask1, split;
+	float		front[MAX_PACKET], back[MAX_PACKET], frac;
+	const float	*f, *b;
+	float		*mid;
+	tnode_t		*tnode;
+	tracepacket_t	child[2];
+	int		blocked;
+
+	while (node >= 0)
+	{
+		tnode = &tnodes[node];
+		mask0 = mask1 = split = 0;
+		for (i = 0, bit = 1 ; i < MAX_PACKET ; i++, bit <<= 1)
+		{
+			if (!(mask & bit))
+				continue;
+			f = p->front[i];
+			b = p->back[i];
+			switch (tnode->type)
+			{
+			case PLANE_X:
+				front[i] = f[0] - tnode->dist;
+				back[i] = b[0] - tnode->dist;
+				break;
+			case PLANE_Y:
+				front[i] = f[1] - tnode->dist;
+				back[i] = b[1] - tnode->dist;
+				break;
+			case PLANE_Z:
+				front[i] = f[2] - tnode->dist;
+				back[i] = b[2] - tnode->dist;
+				break;
+			default:
+				front[i] = (float)((f[0]*tnode->normal[0] + f[1]*tnode->normal[1] + f[2]*tnode->normal[2]) - tnode->dist);
+				back[i] = (float)((b[0]*tnode->normal[0] + b[1]*tnode->normal[1] + b[2]*tnode->normal[2]) - tnode->dist);
+				break;
+			}
+			if (front[i] > -ON_EPSILON && back[i] > -ON_EPSILON)
+				mask0 |= bit;
+			else if (front[i] < ON_EPSILON && back[i] < ON_EPSILON)
+				mask1 |= bit;
+			else
+				split |= bit;
+		}
+
+		if (!split)
+		{
+			if (!mask1)
+			{
+				node = tnode->children[0];
+				continue;
+			}
+			if (!mask0)
+			{
+				node = tnode->children[1];
+				continue;
+			}
+		}
+
+	// the lines go different ways: each side gets the whole lines on
+	// its side and its parts of the split ones
+		for (i = 0, bit = 1 ; i < MAX_PACKET ; i++, bit <<= 1)
+		{
+			if (mask0 & bit)
+			{
+				VectorCopy (p->front[i], child[0].front[i]);
+				VectorCopy (p->back[i], child[0].back[i]);
+			}
+			else if (mask1 & bit)
+			{
+				VectorCopy (p->front[i], child[1].front[i]);
+				VectorCopy (p->back[i], child[1].back[i]);
+			}
+			else if (split & bit)
+			{
+				side = (front[i] < 0.0f) ? 1 : 0;
+				frac = front[i] / (front[i] - back[i]);
+				mid = child[side].back[i];
+				mid[0] = p->front[i][0] + frac*(p->back[i][0]-p->front[i][0]);
+				mid[1] = p->front[i][1] + frac*(p->back[i][1]-p->front[i][1]);
+				mid[2] = p->front[i][2] + frac*(p->back[i][2]-p->front[i][2]);
+				VectorCopy (p->front[i], child[side].front[i]);
+				VectorCopy (mid, child[!side].front[i]);
+				VectorCopy (p->back[i], child[!side].back[i]);
+			}
+		}
+
+		blocked = TracePacket_r (tnode->children[0], mask0 | split, &child[0]);
+		mask1 = (mask1 | split) & ~blocked;
+		if (mask1)
+			blocked |= TracePacket_r (tnode->children[1], mask1, &child[1]);
+		return blocked;
+	}
+
+	if (node == CONTENTS_SOLID)
+		return mask;
+	return 0;
+}
+
+/*
+==============
+TestLines
+
+Tests the lines from start to each of the numstops points as TestLine
+does, and returns the ones that are clear as bits
+==============
+*/
+int TestLines (const vec3_t start, const vec3_t *stops, int numstops)
+{
+	tracepacket_t	p;
+	int		i, mask;
+
+	if (numstops > MAX_PACKET)
+		COM_Error ("%s: %i lines", __thisfunc__, numstops);
+
+	for (i = 0 ; i < numstops ; i++)
+	{
+		p.front[i][0] = (float)start[0];
+		p.front[i][1] = (float)start[1];
+		p.front[i][2] = (float)start[2];
+		p.back[i][0] = (float)stops[i][0];
+		p.back[i][1] = (float)stops[i][1];
+		p.back[i][2] = (float)stops[i][2];
+	}
+
+	mask = (1 << numstops) - 1;
+	return mask & ~TracePacket_r (0, mask, &p);
+}
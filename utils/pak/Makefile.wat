@@ -23,6 +23,7 @@ OSLIBS=$(UHEXEN2_TOP)/oslibs
 # Names of the binaries
 PAKX=pakx.exe
 PAKLIST=paklist.exe
+PAKMAKE=pakmake.exe
 
 # Compiler flags
 CFLAGS = -zq -wx -bm -bt=nt -5s -sg -otexan -fp5 -fpi87 -ei -j -zp8
@@ -56,8 +57,9 @@ OBJ_COMMON= qsnprint.obj &
 	pakfile.obj
 OBJ_PAKX= pakx.obj
 OBJ_PAKL= paklist.obj
+OBJ_PAKM= pakmake.obj
 
-all: $(PAKX) $(PAKLIST)
+all: $(PAKX) $(PAKLIST) $(PAKMAKE)
 
 $(PAKX): $(OBJ_COMMON) $(OBJ_PAKX)
 	wlink N $@ SYS NT OP q F {$(OBJ_COMMON) $(OBJ_PAKX)}
@@ -65,8 +67,11 @@ $(PAKX): $(OBJ_COMMON) $(OBJ_PAKX)
 $(PAKLIST): $(OBJ_COMMON) $(OBJ_PAKL)
 	wlink N $@ SYS NT OP q F {$(OBJ_COMMON) $(OBJ_PAKL)}
 
+$(PAKMAKE): $(OBJ_COMMON) $(OBJ_PAKM)
+	wlink N $@ SYS NT OP q F {$(OBJ_COMMON) $(OBJ_PAKM)}
+
 INCLUDES+= -I"$(OSLIBS)/windows/misc/include"
 clean: .symbolic
 	rm -f *.obj *.res *.err
 distclean: clean .symbolic
-	rm -f $(PAKX) $(PAKLIST)
+	rm -f $(PAKX) $(PAKLIST) $(PAKMAKE)
@@ -6,7 +6,7 @@ UHEXEN2_TOP=../..
 . $UHEXEN2_TOP/scripts/cross_defs.aros
 
 if test "$1" = "strip"; then
-	$STRIPPER -S pakx paklist
+	$STRIPPER -S pakx paklist pakmake
 	exit 0
 fi
 
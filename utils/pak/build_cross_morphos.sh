@@ -4,7 +4,7 @@ UHEXEN2_TOP=../..
 . $UHEXEN2_TOP/scripts/cross_defs.morphos
 
 if test "$1" = "strip"; then
-	$STRIPPER -S pakx paklist
+	$STRIPPER -S pakx paklist pakmake
 	exit 0
 fi
 
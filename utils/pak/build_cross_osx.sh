@@ -1,9 +1,9 @@
 #!/bin/sh
 
-rm -f	pakx.ppc paklist.ppc \
-	pakx.x86 paklist.x86 \
-	pakx.x86_64 paklist.x86_64 \
-	pakx.bin paklist.bin
+rm -f	pakx.ppc paklist.ppc pakmake.ppc \
+	pakx.x86 paklist.x86 pakmake.x86 \
+	pakx.x86_64 paklist.x86_64 pakmake.x86_64 \
+	pakx.bin paklist.bin pakmake.bin
 make distclean
 
 OLDPATH=$PATH
@@ -23,8 +23,10 @@ export PATH CC AS AR RANLIB LIPO
 $MAKE_CMD MACH_TYPE=ppc $* || exit 1
 powerpc-apple-darwin9-strip -S pakx || exit 1
 powerpc-apple-darwin9-strip -S paklist || exit 1
+powerpc-apple-darwin9-strip -S pakmake || exit 1
 mv pakx pakx.ppc || exit 1
 mv paklist paklist.ppc || exit 1
+mv pakmake pakmake.ppc || exit 1
 $MAKE_CMD distclean
 
 # x86
@@ -38,8 +40,10 @@ export PATH CC AS AR RANLIB LIPO
 $MAKE_CMD MACH_TYPE=x86 $* || exit 1
 i686-apple-darwin9-strip -S pakx || exit 1
 i686-apple-darwin9-strip -S paklist || exit 1
+i686-apple-darwin9-strip -S pakmake || exit 1
 mv pakx pakx.x86 || exit 1
 mv paklist paklist.x86 || exit 1
+mv pakmake pakmake.x86 || exit 1
 $MAKE_CMD distclean
 
 # x86_64
@@ -53,9 +57,12 @@ export PATH CC AS AR RANLIB LIPO
 $MAKE_CMD MACH_TYPE=x86_64 $* || exit 1
 x86_64-apple-darwin9-strip -S pakx || exit 1
 x86_64-apple-darwin9-strip -S paklist || exit 1
+x86_64-apple-darwin9-strip -S pakmake || exit 1
 mv pakx pakx.x86_64 || exit 1
 mv paklist paklist.x86_64 || exit 1
+mv pakmake pakmake.x86_64 || exit 1
 $MAKE_CMD distclean
 
 $LIPO -create -o pakx.bin pakx.ppc pakx.x86 pakx.x86_64 || exit 1
 $LIPO -create -o paklist.bin paklist.ppc paklist.x86 paklist.x86_64 || exit 1
+$LIPO -create -o pakmake.bin pakmake.ppc pakmake.x86 pakmake.x86_64 || exit 1
@@ -0,0 +1,539 @@
+/* pakmake.c -- pack file building tool.
+ * Copyright (C) 1996-2001 Id Software, Inc.
+ * Copyright (C) 2010 Ozkan Sezer <sezero@users.sourceforge.net>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "q_stdinc.h"
+#include "compiler.h"
+#include "arch_def.h"
+#include "cmdlib.h"
+#include "util_io.h"
+#include "q_endian.h"
+#include "byteordr.h"
+#include "pathutil.h"
+#include "pakfile.h"
+#include "pak.h"
+#include "crc.h"
+
+/*
+======================================================================
+
+The files are read from the source directory, named by a list with one
+game path per line, such as the output of "find . -type f" run in it.
+
+The files named by an access log, one game path per line in the order
+the game opened them, go first in the pak and in the same order, so that
+loading a map reads the pak from the front to the back.  The rest follow
+in the order of the list.
+
+A file with the same contents as one before it is not stored again, its
+directory entry points at the data of the first one.
+
+With -template, the directory of an existing pak is used as it is: the
+same names, the same order and the same offsets, so that the pak comes
+out with the same directory crc that the engine checks the original paks
+with, when the files are the ones that were extracted from it.
+
+The index written next to the pak has the directory crc and a crc of
+each file, to check the files in the pak against.
+
+======================================================================
+*/
+
+typedef struct
+{
+	char	name[PAK_PATH_LENGTH];
+	byte	*data;
+	int		filepos, filelen;
+	unsigned short	crc;
+	int		shared;		// earlier entry with the same data, or -1
+	qboolean	ordered;
+} pakentry_t;
+
+static pakentry_t	entries[MAX_FILES_IN_PACK];
+static int		numentries;
+static int		order[MAX_FILES_IN_PACK];	// the directory order
+
+static const char	*srcdir;
+
+static dpackheader_t	tmplheader;
+static dpackfile_t	*tmpldir;
+
+//======================================================================
+
+/*
+==============
+CleanName
+
+Makes a game path from a line of a file list: forward slashes only, and
+without the source directory or a leading "./" in front of it
+==============
+*/
+static char *CleanName (char *line)
+{
+	char	*name, *s;
+	size_t	len;
+
+	for (s = line ; *s ; s++)
+	{
+		if (*s == '\\')
+			*s = '/';
+	}
+	name = line;
+	while (*name == ' ' || *name == '\t')
+		name++;
+	len = strlen (name);
+	while (len && (name[len-1] == '\n' || name[len-1] == '\r' ||
+			name[len-1] == ' ' || name[len-1] == '\t'))
+		name[--len] = 0;
+
+	len = strlen (srcdir);
+	if (len && !strncmp (name, srcdir, len) && name[len] == '/')
+		name += len + 1;
+	while (name[0] == '.' && name[1] == '/')
+		name += 2;
+	while (*name == '/')
+		name++;
+
+	return name;
+}
+
+static int FindEntry (const char *name)
+{
+	int		i;
+
+	for (i = 0 ; i < numentries ; i++)
+	{
+		if (!strcmp (entries[i].name, name))
+			return i;
+	}
+	return -1;
+}
+
+/*
+==============
+ReadFileList
+==============
+*/
+static void ReadFileList (const char *listfile)
+{
+	FILE	*f;
+	char	line[1024], *name;
+
+	if (!strcmp (listfile, "-"))
+		f = stdin;
+	else
+		f = SafeOpenRead (listfile);
+
+	while (fgets (line, sizeof(line), f))
+	{
+		name = CleanName (line);
+		if (!*name)
+			continue;
+		if (strlen (name) >= PAK_PATH_LENGTH)
+			COM_Error ("%s: name longer than %i characters", name, PAK_PATH_LENGTH - 1);
+		if (FindEntry (name) != -1)
+		{
+			printf ("WARNING: %s is listed twice\n", name);
+			continue;
+		}
+		if (numentries == MAX_FILES_IN_PACK)
+			COM_Error ("More than %i files, the engine won't load the pak", MAX_FILES_IN_PACK);
+		strcpy (entries[numentries].name, name);
+		order[numentries] = numentries;
+		numentries++;
+	}
+
+	if (f != stdin)
+		fclose (f);
+}
+
+/*
+==============
+ReadAccessLog
+
+Puts the files named by the log in front, in the order they were opened
+==============
+*/
+static void ReadAccessLog (const char *logfile)
+{
+	FILE	*f;
+	char	line[1024], *name;
+	int		i, e, numordered, numlogged, missing;
+
+	f = SafeOpenRead (logfile);
+	numordered = missing = 0;
+
+	while (fgets (line, sizeof(line), f))
+	{
+		name = CleanName (line);
+		if (!*name)
+			continue;
+		e = FindEntry (name);
+		if (e == -1)
+		{
+			missing++;
+			continue;
+		}
+		if (entries[e].ordered)
+			continue;
+		entries[e].ordered = true;
+		order[numordered++] = e;
+	}
+	fclose (f);
+	numlogged = numordered;
+
+	for (i = 0 ; i < numentries ; i++)
+	{
+		if (!entries[i].ordered)
+			order[numordered++] = i;
+	}
+
+	printf ("%i files ordered by %s", numlogged, logfile);
+	if (missing)
+		printf (", %i logged files not in the pak", missing);
+	printf ("\n");
+}
+
+/*
+==============
+ReadTemplate
+
+Takes the directory of an existing pak as it is
+==============
+*/
+static void ReadTemplate (const char *pakfile)
+{
+	FILE	*f;
+	int		i;
+
+	f = SafeOpenRead (pakfile);
+	SafeRead (f, &tmplheader, sizeof(tmplheader));
+	if (tmplheader.id[0] != 'P' || tmplheader.id[1] != 'A' ||
+	    tmplheader.id[2] != 'C' || tmplheader.id[3] != 'K')
+		COM_Error ("%s is not a packfile.", pakfile);
+
+	tmplheader.dirofs = LittleLong (tmplheader.dirofs);
+	tmplheader.dirlen = LittleLong (tmplheader.dirlen);
+	numentries = tmplheader.dirlen / sizeof(dpackfile_t);
+	if (tmplheader.dirlen < 0 || tmplheader.dirofs < 0 || numentries > MAX_FILES_IN_PACK)
+	{
+		COM_Error ("Invalid packfile %s (dirlen: %i, dirofs: %i)",
+				pakfile, tmplheader.dirlen, tmplheader.dirofs);
+	}
+
+	tmpldir = (dpackfile_t *) SafeMalloc (tmplheader.dirlen + 1);
+	fseek (f, tmplheader.dirofs, SEEK_SET);
+	SafeRead (f, tmpldir, tmplheader.dirlen);
+	fclose (f);
+
+// the name bytes after the terminator are kept in tmpldir as well,
+// they are part of what the crc is made from
+	for (i = 0 ; i < numentries ; i++)
+	{
+		memcpy (entries[i].name, tmpldir[i].name, PAK_PATH_LENGTH);
+		entries[i].name[PAK_PATH_LENGTH - 1] = 0;
+		entries[i].filepos = LittleLong (tmpldir[i].filepos);
+		entries[i].filelen = LittleLong (tmpldir[i].filelen);
+		order[i] = i;
+	}
+}
+
+//======================================================================
+
+/*
+==============
+LoadEntries
+==============
+*/
+static void LoadEntries (void)
+{
+	char	path[1024];
+	void	*buf;
+	int		i, len;
+
+	for (i = 0 ; i < numentries ; i++)
+	{
+		q_snprintf (path, sizeof(path), "%s/%s", srcdir, entries[i].name);
+		len = LoadFile (path, &buf);
+		if (tmpldir && len != entries[i].filelen)
+		{
+			COM_Error ("%s is %i bytes, the template has %i",
+					path, len, entries[i].filelen);
+		}
+		entries[i].data = (byte *) buf;
+		entries[i].filelen = len;
+		entries[i].crc = CRC_Block (entries[i].data, len);
+		entries[i].shared = -1;
+	}
+}
+
+/*
+==============
+ShareData
+
+Points the files that are the same as one before them at its data
+==============
+*/
+static void ShareData (void)
+{
+	pakentry_t	*e, *prev;
+	int		i, j, count, saved;
+
+	count = saved = 0;
+	for (i = 0 ; i < numentries ; i++)
+	{
+		e = &entries[order[i]];
+		for (j = 0 ; j < i ; j++)
+		{
+			prev = &entries[order[j]];
+			if (prev->shared != -1 || prev->filelen != e->filelen ||
+					prev->crc != e->crc)
+				continue;
+			if (memcmp (prev->data, e->data, e->filelen))
+				continue;
+			e->shared = order[j];
+			count++;
+			saved += e->filelen;
+			break;
+		}
+	}
+
+	if (count)
+		printf ("%i files share the data of another, %i bytes saved\n", count, saved);
+}
+
+/*
+==============
+LayoutPak
+
+Returns the size of the pak file
+==============
+*/
+static int LayoutPak (void)
+{
+	pakentry_t	*e;
+	int		i, pos;
+
+	if (tmpldir)
+	{
+		pos = tmplheader.dirofs + tmplheader.dirlen;
+		for (i = 0 ; i < numentries ; i++)
+		{
+			if (entries[i].filepos + entries[i].filelen > pos)
+				pos = entries[i].filepos + entries[i].filelen;
+		}
+		return pos;
+	}
+
+	pos = sizeof(dpackheader_t);
+	for (i = 0 ; i < numentries ; i++)
+	{
+		e = &entries[order[i]];
+		if (e->shared != -1)
+			continue;
+		e->filepos = pos;
+		pos += e->filelen;
+	}
+	for (i = 0 ; i < numentries ; i++)
+	{
+		e = &entries[order[i]];
+		if (e->shared != -1)
+			e->filepos = entries[e->shared].filepos;
+	}
+
+	return pos + numentries * sizeof(dpackfile_t);
+}
+
+/*
+==============
+WritePak
+
+Returns the directory crc
+==============
+*/
+static unsigned short WritePak (const char *pakfile, int size)
+{
+	byte		*buf;
+	dpackheader_t	*header;
+	dpackfile_t	*dir;
+	pakentry_t	*e;
+	unsigned short	crc;
+	int		i, dirofs, dirlen;
+
+	buf = (byte *) SafeMalloc (size);
+
+	for (i = 0 ; i < numentries ; i++)
+	{
+		e = &entries[i];
+		if (e->shared == -1)
+			memcpy (buf + e->filepos, e->data, e->filelen);
+	}
+
+	if (tmpldir)
+	{
+	// files may share their data in the template as well, but only
+	// when it is the same data
+		for (i = 0 ; i < numentries ; i++)
+		{
+			e = &entries[i];
+			if (memcmp (buf + e->filepos, e->data, e->filelen))
+				COM_Error ("%s overlaps another file in the template", e->name);
+		}
+		dirofs = tmplheader.dirofs;
+		dirlen = tmplheader.dirlen;
+		memcpy (buf + dirofs, tmpldir, dirlen);
+	}
+	else
+	{
+		dirlen = numentries * sizeof(dpackfile_t);
+		dirofs = size - dirlen;
+		dir = (dpackfile_t *) (buf + dirofs);
+		for (i = 0 ; i < numentries ; i++)
+		{
+			e = &entries[order[i]];
+			strcpy (dir[i].name, e->name);
+			dir[i].filepos = LittleLong (e->filepos);
+			dir[i].filelen = LittleLong (e->filelen);
+		}
+	}
+
+	header = (dpackheader_t *) buf;
+	header->id[0] = 'P';
+	header->id[1] = 'A';
+	header->id[2] = 'C';
+	header->id[3] = 'K';
+	header->dirofs = LittleLong (dirofs);
+	header->dirlen = LittleLong (dirlen);
+
+	CRC_Init (&crc);
+	CRC_ProcessBlock (buf + dirofs, &crc, dirlen);
+
+	SaveFile (pakfile, buf, size);
+	free (buf);
+
+	return crc;
+}
+
+/*
+==============
+WriteIndex
+==============
+*/
+static void WriteIndex (const char *indexfile, const char *pakfile, int size, unsigned short crc)
+{
+	FILE		*f;
+	pakentry_t	*e;
+	int		i;
+
+	f = SafeOpenWrite (indexfile);
+	fprintf (f, "// %s\n", pakfile);
+	fprintf (f, "numfiles %i\n", numentries);
+	fprintf (f, "dircrc %u\n", crc);
+	fprintf (f, "size %i\n", size);
+	fprintf (f, "// crc filepos filelen name\n");
+	for (i = 0 ; i < numentries ; i++)
+	{
+		e = &entries[order[i]];
+		fprintf (f, "%5u %10d %10d %s\n", e->crc, e->filepos, e->filelen, e->name);
+	}
+	fclose (f);
+}
+
+//======================================================================
+
+FUNC_NORETURN static void usage (int ret) {
+	printf ("Usage:  pakmake [options] <srcdir> <pakfile>\n");
+	printf ("        pakmake  -h  to display this help message.\n");
+	printf ("Options:\n");
+	printf ("  -list <file>      the files to put in the pak, one per line.  \"-\" reads\n");
+	printf ("                    the list from stdin, which is the default.\n");
+	printf ("  -order <file>     put the files named by an access log first, in its order.\n");
+	printf ("  -template <pak>   use the directory of an existing pak to reproduce it.\n");
+	printf ("  -index <file>     where to write the index, default is <pakfile>.idx\n");
+	printf ("  -nodedup          store every file, even when another has the same data.\n");
+	printf ("\n");
+	exit (ret);
+}
+
+int main (int argc, char **argv)
+{
+	const char	*listfile, *orderfile, *tmplfile, *pakfile;
+	char		indexfile[1024];
+	qboolean	dedup;
+	unsigned short	crc;
+	int		i, size;
+
+	listfile = "-";
+	orderfile = tmplfile = NULL;
+	indexfile[0] = 0;
+	dedup = true;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-h"))
+			usage (0);
+		else if (!strcmp(argv[i], "-list") && i < argc - 1)
+			listfile = argv[++i];
+		else if (!strcmp(argv[i], "-order") && i < argc - 1)
+			orderfile = argv[++i];
+		else if (!strcmp(argv[i], "-template") && i < argc - 1)
+			tmplfile = argv[++i];
+		else if (!strcmp(argv[i], "-index") && i < argc - 1)
+			q_strlcpy (indexfile, argv[++i], sizeof(indexfile));
+		else if (!strcmp(argv[i], "-nodedup"))
+			dedup = false;
+		else if (argv[i][0] == '-')
+			usage (1);
+		else
+			break;
+	}
+	if (i != argc - 2)
+		usage (1);
+	if (tmplfile && orderfile)
+		COM_Error ("-order can't be used with -template");
+
+	ValidateByteorder ();
+
+	srcdir = argv[i];
+	pakfile = argv[i + 1];
+	if (!indexfile[0])
+		q_snprintf (indexfile, sizeof(indexfile), "%s.idx", pakfile);
+
+	if (tmplfile)
+		ReadTemplate (tmplfile);
+	else
+		ReadFileList (listfile);
+	if (!numentries)
+		COM_Error ("No files to put in %s", pakfile);
+	if (orderfile)
+		ReadAccessLog (orderfile);
+
+	LoadEntries ();
+	if (dedup && !tmplfile)
+		ShareData ();
+
+	size = LayoutPak ();
+	crc = WritePak (pakfile, size);
+	WriteIndex (indexfile, pakfile, size, crc);
+
+	printf ("PAK file %s: %i bytes, %i files, header crc %u.\n",
+			pakfile, size, numentries, crc);
+
+	return 0;
+}
@@ -54,9 +54,11 @@ OBJ_COMMON= qsnprint.obj &
 	util_io.obj &
 	pathutil.obj &
 	mathlib.obj &
-	bspfile.obj
+	bspfile.obj &
+	buildcache.obj
 
-OBJ_QBSP= brush.obj &
+OBJ_QBSP= threads.obj &
+	brush.obj &
 	csg4.obj &
 	map.obj &
 	merge.obj &
@@ -64,6 +66,7 @@ OBJ_QBSP= brush.obj &
 	outside.obj &
 	portals.obj &
 	qbsp.obj &
+	rebuild.obj &
 	region.obj &
 	solidbsp.obj &
 	surfaces.obj &
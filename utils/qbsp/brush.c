@@ -220,16 +220,47 @@ static void NormalizePlane (plane_t *dp)
 	}
 }
 
+// the planes are hashed by cells of their normal and distance, so that
+// FindPlane only has to look at the planes in the cells that are within
+// the match epsilons around the new one
+#define	PLANE_HASHES		4096
+#define	NORMAL_CELLS		16	// per unit
+#define	NORMAL_TOLERANCE	0.01	// more than any component can differ by within ANGLEEPSILON
+#define	DIST_CELLS		1
+
+static int	planehash[PLANE_HASHES];	// first plane + 1 in the chain, 0 if none
+static int	planechain[MAX_MAP_PLANES];	// next plane + 1 with the same hash
+
+static int PlaneCell (double v, double cells)
+{
+	return (int) floor (v * cells + 0.5);
+}
+
+static int PlaneHash (int d, int x, int y, int z)
+{
+	unsigned int	h;
+
+	h = (unsigned int)d * 2654435761U;
+	h = (h ^ (unsigned int)x) * 16777619U;
+	h = (h ^ (unsigned int)y) * 16777619U;
+	h = (h ^ (unsigned int)z) * 16777619U;
+	return (int)((h ^ (h >> 16)) & (PLANE_HASHES - 1));
+}
+
 /*
 ===============
 FindPlane
 
-Returns a global plane number and the side that will be the front
+Returns a global plane number and the side that will be the front.
+Only the first plane to be created adds to the list, the concurrent hull
+threads just look their planes up.
 ===============
 */
 int FindPlane (plane_t *dplane, int *side)
 {
-	int			i;
+	int			i, best;
+	int			d, x, y, z;
+	int			lo[4], hi[4];
 	plane_t		*dp, pl;
 	double		dot;
 
@@ -244,21 +275,46 @@ int FindPlane (plane_t *dplane, int *side)
 	else
 		*side = 1;
 
-	dp = planes;
-	for (i = 0 ; i < numbrushplanes ; i++, dp++)
+	lo[0] = PlaneCell (pl.dist - DISTEPSILON, DIST_CELLS);
+	hi[0] = PlaneCell (pl.dist + DISTEPSILON, DIST_CELLS);
+	for (i = 0 ; i < 3 ; i++)
 	{
-		dot = DotProduct (dp->normal, pl.normal);
-		if (dot > 1.0 - ANGLEEPSILON && fabs(dp->dist - pl.dist) < DISTEPSILON)
-		{	// regular match
-			return i;
-		}
+		lo[i+1] = PlaneCell (pl.normal[i] - NORMAL_TOLERANCE, NORMAL_CELLS);
+		hi[i+1] = PlaneCell (pl.normal[i] + NORMAL_TOLERANCE, NORMAL_CELLS);
 	}
 
+// the lowest numbered match, as the old linear search would find
+	best = -1;
+	for (d = lo[0] ; d <= hi[0] ; d++)
+	  for (x = lo[1] ; x <= hi[1] ; x++)
+	    for (y = lo[2] ; y <= hi[2] ; y++)
+	      for (z = lo[3] ; z <= hi[3] ; z++)
+	      {
+		for (i = planehash[PlaneHash(d, x, y, z)] ; i ; i = planechain[i-1])
+		{
+			if (best != -1 && i-1 >= best)
+				continue;
+			dp = &planes[i-1];
+			dot = DotProduct (dp->normal, pl.normal);
+			if (dot > 1.0 - ANGLEEPSILON && fabs(dp->dist - pl.dist) < DISTEPSILON)
+			{	// regular match
+				best = i-1;
+			}
+		}
+	      }
+	if (best != -1)
+		return best;
+
 	if (numbrushplanes == MAX_MAP_PLANES)
 		COM_Error ("numbrushplanes == MAX_MAP_PLANES");
 
 	planes[numbrushplanes] = pl;
 
+	i = PlaneHash (PlaneCell(pl.dist, DIST_CELLS), PlaneCell(pl.normal[0], NORMAL_CELLS),
+			PlaneCell(pl.normal[1], NORMAL_CELLS), PlaneCell(pl.normal[2], NORMAL_CELLS));
+	planechain[numbrushplanes] = planehash[i];
+	planehash[i] = numbrushplanes + 1;
+
 	numbrushplanes++;
 
 	return numbrushplanes-1;
@@ -380,7 +436,7 @@ CreateBrushFaces
 =================
 */
 #define	ZERO_EPSILON	0.001
-static void CreateBrushFaces (void)
+static void CreateBrushFaces (hullinfo_t *hull)
 {
 	int			i, j, k;
 	double		r;
@@ -398,7 +454,7 @@ static void CreateBrushFaces (void)
 	{
 		mf = &faces[i];
 
-		w = BaseWindingForPlane (&mf->plane);
+		w = BaseWindingForPlane (hull, &mf->plane);
 
 		for (j = 0 ; j < numbrushfaces && w ; j++)
 		{
@@ -408,14 +464,14 @@ static void CreateBrushFaces (void)
 			VectorNegate (faces[j].plane.normal, plane.normal);
 			plane.dist = -faces[j].plane.dist;
 
-			w = ClipWinding (w, &plane, false);
+			w = ClipWinding (hull, w, &plane, false);
 		}
 
 		if (!w)
 			continue;	// overcontrained plane
 
 	// this face is a keeper
-		f = AllocFace ();
+		f = AllocBrushFace (hull);
 		f->numpoints = w->numpoints;
 		if (f->numpoints > MAXEDGES)
 			COM_Error ("f->numpoints > MAXEDGES");
@@ -436,7 +492,7 @@ static void CreateBrushFaces (void)
 					brush_maxs[k] = f->pts[j][k];
 			}
 		}
-		FreeWinding (w);
+		FreeWinding (hull, w);
 		f->texturenum = mf->texinfo;
 		f->planenum = FindPlane (&mf->plane, &f->planeside);
 		f->next = brush_faces;
@@ -759,7 +815,7 @@ LoadBrush
 Converts a mapbrush to a bsp brush
 ===============
 */
-static brush_t *LoadBrush (mbrush_t *mb, int hullnumber)
+static brush_t *LoadBrush (hullinfo_t *hull, mbrush_t *mb)
 {
 	brush_t		*b;
 	int			contents;
@@ -772,7 +828,7 @@ static brush_t *LoadBrush (mbrush_t *mb, int hullnumber)
 //
 	name = miptex[texinfo[mb->faces->texinfo].miptex];
 
-	if (!q_strcasecmp(name, "clip") && hullnumber == 0)
+	if (!q_strcasecmp(name, "clip") && hull->hullnum == 0)
 		return NULL;	// "clip" brushes don't show up in the draw hull
 
 	if (name[0] == '*' && worldmodel)	// entities never use water merging
@@ -784,12 +840,12 @@ static brush_t *LoadBrush (mbrush_t *mb, int hullnumber)
 		else
 			contents = CONTENTS_WATER;
 	}
-	else if (!q_strncasecmp (name, "sky",3) && worldmodel && hullnumber == 0)
+	else if (!q_strncasecmp (name, "sky",3) && worldmodel && hull->hullnum == 0)
 		contents = CONTENTS_SKY;
 	else
 		contents = CONTENTS_SOLID;
 
-	if (hullnumber && contents != CONTENTS_SOLID && contents != CONTENTS_SKY)
+	if (hull->hullnum && contents != CONTENTS_SOLID && contents != CONTENTS_SKY)
 		return NULL;	// water brushes don't show up in clipping hulls
 
 // no seperate textures on clip hull
@@ -803,12 +859,12 @@ static brush_t *LoadBrush (mbrush_t *mb, int hullnumber)
 	for (f = mb->faces ; f ; f = f->next)
 	{
 		faces[numbrushfaces] = *f;
-		if (hullnumber)
+		if (hull->hullnum)
 			faces[numbrushfaces].texinfo = 0;
 		numbrushfaces++;
 	}
 
-	CreateBrushFaces ();
+	CreateBrushFaces (hull);
 
 	if (!brush_faces)
 	{
@@ -816,10 +872,10 @@ static brush_t *LoadBrush (mbrush_t *mb, int hullnumber)
 		return NULL;
 	}
 
-	if (hullnumber)
+	if (hull->hullnum)
 	{
-		ExpandBrush (hullnumber);
-		CreateBrushFaces ();
+		ExpandBrush (hull->hullnum);
+		CreateBrushFaces (hull);
 	}
 
 	for (f2 = brush_faces ; f2 ; f2 = f2->next)
@@ -867,7 +923,7 @@ static void Brush_DrawAll (brushset_t *bs)
 Brush_LoadEntity
 ============
 */
-brushset_t *Brush_LoadEntity (entity_t *ent, int hullnumber)
+brushset_t *Brush_LoadEntity (hullinfo_t *hull, entity_t *ent)
 {
 	brush_t		*b, *next, *water, *other;
 	mbrush_t	*mbr;
@@ -888,7 +944,7 @@ brushset_t *Brush_LoadEntity (entity_t *ent, int hullnumber)
 
 	for (mbr = ent->brushes ; mbr ; mbr = mbr->next)
 	{
-		b = LoadBrush (mbr, hullnumber);
+		b = LoadBrush (hull, mbr);
 		if (!b)
 			continue;
 
@@ -919,7 +975,6 @@ brushset_t *Brush_LoadEntity (entity_t *ent, int hullnumber)
 
 	bset->brushes = other;
 
-	brushset = bset;
 	Brush_DrawAll (bset);
 
 	qprintf ("%i brushes read\n",numbrushes);
@@ -32,8 +32,6 @@ typedef struct
 
 #include "map.h"
 
-#define	MAX_THREADS	4
-
 #define	ON_EPSILON	0.01
 #define	BOGUS_RANGE	18000
 
@@ -41,24 +39,28 @@ typedef struct
 // volume.  is this still needed?
 #define	SIDESPACE	24
 
+// the state of one hull while it is being built, see qbsp.c
+typedef struct hullinfo_s	hullinfo_t;
+
 //============================================================================
 
 
 typedef struct
 {
 	int		numpoints;
+	int		maxpoints;		// allocated size
 	vec3_t	points[8];		// variable sized
 } winding_t;
 
 #define MAX_POINTS_ON_WINDING	64
 
-winding_t	*BaseWindingForPlane (plane_t *p);
+winding_t	*BaseWindingForPlane (hullinfo_t *hull, plane_t *p);
 void		CheckWinding (winding_t *w);
-winding_t	*NewWinding (int points);
-void		FreeWinding (winding_t *w);
-winding_t	*CopyWinding (winding_t *w);
-winding_t	*ClipWinding (winding_t *in, plane_t *split, qboolean keepon);
-void		DivideWinding (winding_t *in, plane_t *split, winding_t **front, winding_t **back);
+winding_t	*NewWinding (hullinfo_t *hull, int points);
+void		FreeWinding (hullinfo_t *hull, winding_t *w);
+winding_t	*CopyWinding (hullinfo_t *hull, winding_t *w);
+winding_t	*ClipWinding (hullinfo_t *hull, winding_t *in, plane_t *split, qboolean keepon);
+void		DivideWinding (hullinfo_t *hull, winding_t *in, plane_t *split, winding_t **front, winding_t **back);
 
 //============================================================================
  
@@ -149,7 +151,7 @@ typedef struct
 extern	int			numbrushplanes;
 extern	plane_t		planes[MAX_MAP_PLANES];
 
-brushset_t	*Brush_LoadEntity (entity_t *ent, int hullnumber);
+brushset_t	*Brush_LoadEntity (hullinfo_t *hull, entity_t *ent);
 int		PlaneTypeForNormal (vec3_t normal);
 int		FindPlane (plane_t *dplane, int *side);
 
@@ -158,12 +160,11 @@ int		FindPlane (plane_t *dplane, int *side);
 // csg4.c
 
 // build surfaces is also used by GatherNodeFaces
-extern	face_t	*validfaces[MAX_MAP_PLANES];
-surface_t	*BuildSurfaces (void);
+surface_t	*BuildSurfaces (hullinfo_t *hull);
 
-face_t		*NewFaceFromFace (face_t *in);
-surface_t	*CSGFaces (brushset_t *bs);
-void		SplitFace (face_t *in, plane_t *split, face_t **front, face_t **back);
+face_t		*NewFaceFromFace (hullinfo_t *hull, face_t *in);
+surface_t	*CSGFaces (hullinfo_t *hull, brushset_t *bs);
+void		SplitFace (hullinfo_t *hull, face_t *in, plane_t *split, face_t **front, face_t **back);
 
 //=============================================================================
 
@@ -171,17 +172,17 @@ void		SplitFace (face_t *in, plane_t *split, face_t **front, face_t **back);
 
 void	DivideFacet (face_t *in, plane_t *split, face_t **front, face_t **back);
 void	CalcSurfaceInfo (surface_t *surf);
-void	SubdivideFace (face_t *f, face_t **prevptr);
-node_t	*SolidBSP (surface_t *surfhead, qboolean midsplit);
+int	SubdivideFace (hullinfo_t *hull, face_t *f, face_t **prevptr);
+node_t	*SolidBSP (hullinfo_t *hull, surface_t *surfhead, qboolean midsplit);
 
 //=============================================================================
 
 // merge.c
 
-void	MergePlaneFaces (surface_t *plane);
-face_t	*MergeFaceToList (face_t *face, face_t *list);
-face_t	*FreeMergeListScraps (face_t *merged);
-void	MergeAll (surface_t *surfhead);
+void	MergePlaneFaces (hullinfo_t *hull, surface_t *plane);
+face_t	*MergeFaceToList (hullinfo_t *hull, face_t *face, face_t *list);
+face_t	*FreeMergeListScraps (hullinfo_t *hull, face_t *merged);
+void	MergeAll (hullinfo_t *hull, surface_t *surfhead);
 
 //=============================================================================
 
@@ -194,8 +195,8 @@ extern	face_t		*edgefaces[MAX_MAP_EDGES][2];
 extern	int		firstmodeledge;
 extern	int		firstmodelface;
 
-void		SubdivideFaces (surface_t *surfhead);
-surface_t	*GatherNodeFaces (node_t *headnode);
+void		SubdivideFaces (hullinfo_t *hull, surface_t *surfhead);
+surface_t	*GatherNodeFaces (hullinfo_t *hull, node_t *headnode);
 void		MakeFaceEdges (node_t *headnode);
 
 //=============================================================================
@@ -210,11 +211,10 @@ typedef struct portal_s
 	winding_t	*winding;
 } portal_t;
 
-extern	node_t	outside_node;		// portals outside the world face this
-
-void	PortalizeWorld (node_t *headnode);
+void	AddHeadnodePlanes (brushset_t *bs);
+void	PortalizeWorld (hullinfo_t *hull, node_t *headnode);
 void	WritePortalfile (node_t *headnode);
-void	FreeAllPortals (node_t *node);
+void	FreeAllPortals (hullinfo_t *hull, node_t *node);
 
 //=============================================================================
 
@@ -226,7 +226,7 @@ void	GrowNodeRegions (node_t *headnode);
 
 // tjunc.c
 
-void	tjunc (node_t *headnode);
+void	tjunc (hullinfo_t *hull, node_t *headnode);
 
 //=============================================================================
 
@@ -234,15 +234,16 @@ void	tjunc (node_t *headnode);
 
 extern	int	LightValues[MAX_MAP_CLIPNODES];
 
-void	WriteNodePlanes (node_t *headnode);
-void	WriteClipNodes (node_t *headnode);
+void	WriteNodePlanes (hullinfo_t *hull, node_t *headnode);
+void	WriteClipNodes (hullinfo_t *hull, node_t *headnode);
 void	WriteDrawNodes (node_t *headnode);
 
-void	BumpModel (int hullnumber);
+void	BumpModel (hullinfo_t *hull);
 int	FindFinalPlane (dplane_t *p);
 
 void	BeginBSPFile (void);
 void	FinishBSPFile (void);
+void	WriteMiptex (void);
 
 //=============================================================================
 
@@ -270,7 +271,108 @@ void	DrawTri (vec3_t p1, vec3_t p2, vec3_t p3);
 
 // outside.c
 
-qboolean FillOutside (node_t *node);
+qboolean FillOutside (hullinfo_t *hull, node_t *node);
+
+//=============================================================================
+
+// rebuild.c
+
+#define	CACHEKEY_LEN	24	// "h1:" and a build hash
+
+void	InitBuildCache (void);
+qboolean UpdateCachedBSP (void);
+qboolean ReuseClipHull (hullinfo_t *hull, int entnum);
+void	KeepClipHull (hullinfo_t *hull, int entnum, int firstplane);
+void	StoreClipHulls (hullinfo_t *hull);
+void	UpdateBuildCache (qboolean filled);
+void	SaveBuildCache (void);
+
+//=============================================================================
+
+// qbsp.c
+
+// items of one size, taken from big blocks and recycled through a free
+// list.  the blocks are kept until the pool is freed, ResetPool makes all
+// of them available again at once.
+typedef struct poolblock_s
+{
+	struct poolblock_s	*next;
+	double		align;		// the items follow
+} poolblock_t;
+
+typedef struct
+{
+	size_t		itemsize;
+	int		blockitems;
+	poolblock_t	*blocks;
+	poolblock_t	*curblock;	// NULL before the first block
+	int		used;		// items taken from curblock
+	void		*freelist;
+	int		active, peak;	// items in use
+	int		allocs;
+	int		numblocks;
+} mempool_t;
+
+#define	NUM_WINDINGPOOLS	4	// up to 8, 16, 32 and 64 points
+
+// everything that changes while a hull is built.  the brushes of all the
+// hulls are loaded first, in the original hull order, so that the plane
+// list is complete and only read while the hulls are built concurrently.
+struct hullinfo_s
+{
+	int		hullnum;
+	qboolean	verbose;	// for hprintf, set per entity
+	brushset_t	*brushset;	// the entity being processed
+	brushset_t	*brushsets[MAX_MAP_ENTITIES];	// NULL if not a bmodel
+	qboolean	entverbose[MAX_MAP_ENTITIES];
+
+// csg4.c
+	face_t		*validfaces[MAX_MAP_PLANES];
+	face_t		*inside, *outside;
+	int		brushfaces;
+	int		csgfaces;
+	int		csgmergefaces;
+
+// solidbsp.c
+	qboolean	usemidsplit;
+	int		splitnodes;
+	int		leaffaces;
+	int		nodefaces;
+	int		c_solid, c_empty, c_water;
+
+// portals.c and outside.c
+	node_t		outside_node;	// portals outside the world face this
+	int		valid;		// for flood filling
+	int		outleafs;
+	int		hit_occupied;
+	int		backdraw;
+	portal_t	*prevleaknode;
+	FILE		*leakfile;
+
+// writebsp.c
+	int		planemapping[MAX_MAP_PLANES];
+	dplane_t	*dplanes;	// the real dplanes for the drawing hull
+	int		numplanes;
+	dclipnode2_t	*clipnodes;	// clipping hulls only
+	int		numclipnodes;
+	int		headclipnode;
+	int		nummodels;
+	int		headnodes[MAX_MAP_MODELS];
+
+// rebuild.c
+	qboolean	filled;		// the world got filled
+	int		reused;		// models taken from the build cache
+	char		cachekeys[MAX_MAP_ENTITIES][CACHEKEY_LEN];	// "" if not cached
+	byte		*cachedata[MAX_MAP_ENTITIES];	// built by this run
+	int		cachesize[MAX_MAP_ENTITIES];
+
+// qbsp.c, all of it is reset after each entity except the brush faces
+	mempool_t	facepool;
+	mempool_t	surfacepool;
+	mempool_t	portalpool;
+	mempool_t	windingpools[NUM_WINDINGPOOLS];
+	mempool_t	brushfacepool;
+};
 
 //=============================================================================
 
@@ -278,13 +380,14 @@ extern	qboolean	drawflag;
 extern	qboolean	nofill;
 extern	qboolean	notjunc;
 extern	qboolean	noclip;
+extern	qboolean	nocache;
+extern	qboolean	onlyents;
+extern	qboolean	usehulls;
+extern	qboolean	watervis;
 
 extern	int		hullnum;
 extern	qboolean	oldhullsize;	// if true, use original H2 sizes for hulls #5 and #6, not H2MP ones
 
-extern	brushset_t	*brushset;
-
-extern	int		valid;
 extern	int		usebsp2;
 
 extern	char	portfilename[1024];
@@ -295,25 +398,29 @@ extern	char	projectpath[1024];	// with a trailing slash, for finding wads
 
 extern	qboolean	worldmodel;
 
+void	SetModelKeys (void);
+
 
 //=============================================================================
 // verbose printf
 
 extern	qboolean	verbose;
 void	qprintf (const char *fmt, ...) FUNC_PRINTF(1,2);	// only prints if verbose
+void	hprintf (hullinfo_t *hull, const char *fmt, ...) FUNC_PRINTF(2,3);	// only prints if hull->verbose
 
 
 //=============================================================================
 // misc functions
 
-face_t		*AllocFace (void);
-void		FreeFace (face_t *f);
+face_t		*AllocFace (hullinfo_t *hull);
+face_t		*AllocBrushFace (hullinfo_t *hull);
+void		FreeFace (hullinfo_t *hull, face_t *f);
 
-struct portal_s	*AllocPortal (void);
-void		FreePortal (struct portal_s *p);
+struct portal_s	*AllocPortal (hullinfo_t *hull);
+void		FreePortal (hullinfo_t *hull, struct portal_s *p);
 
-surface_t	*AllocSurface (void);
-void		FreeSurface (surface_t *s);
+surface_t	*AllocSurface (hullinfo_t *hull);
+void		FreeSurface (hullinfo_t *hull, surface_t *s);
 
 node_t		*AllocNode (void);
 struct brush_s	*AllocBrush (void);
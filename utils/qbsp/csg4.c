@@ -34,14 +34,6 @@ Brushes that touch still need to be split at the cut point to make a tjunction
 
 */
 
-face_t		*validfaces[MAX_MAP_PLANES];
-
-
-static face_t	*inside, *outside;
-static int	brushfaces;
-static int	csgfaces;
-static int	csgmergefaces;
-
 #if 0
 void DrawList (face_t *list)
 {
@@ -59,11 +51,11 @@ Duplicates the non point information of a face, used by SplitFace and
 MergeFace.
 ==================
 */
-face_t *NewFaceFromFace (face_t *in)
+face_t *NewFaceFromFace (hullinfo_t *hull, face_t *in)
 {
 	face_t	*newf;
 
-	newf = AllocFace ();
+	newf = AllocFace (hull);
 
 	newf->planenum = in->planenum;
 	newf->texturenum = in->texturenum;
@@ -83,7 +75,7 @@ SplitFace
 
 ==================
 */
-void SplitFace (face_t *in, plane_t *split, face_t **front, face_t **back)
+void SplitFace (hullinfo_t *hull, face_t *in, plane_t *split, face_t **front, face_t **back)
 {
 	double	dists[MAXEDGES+1];
 	int		sides[MAXEDGES+1];
@@ -129,8 +121,8 @@ void SplitFace (face_t *in, plane_t *split, face_t **front, face_t **back)
 		return;
 	}
 
-	*back = newf = NewFaceFromFace (in);
-	*front = new2 = NewFaceFromFace (in);
+	*back = newf = NewFaceFromFace (hull, in);
+	*front = new2 = NewFaceFromFace (hull, in);
 
 // distribute the points and generate splits
 
@@ -193,7 +185,7 @@ void SplitFace (face_t *in, plane_t *split, face_t **front, face_t **back)
 #endif
 
 // free the original face now that is is represented by the fragments
-	FreeFace (in);
+	FreeFace (hull, in);
 }
 
 /*
@@ -208,7 +200,7 @@ Faces exactly on the plane will stay inside unless overdrawn by later brush
 frontside is the side of the plane that holds the outside list
 =================
 */
-static void ClipInside (int splitplane, int frontside, qboolean precedence)
+static void ClipInside (hullinfo_t *hull, int splitplane, int frontside, qboolean precedence)
 {
 	face_t	*f, *next;
 	face_t	*frags[2];
@@ -218,7 +210,7 @@ static void ClipInside (int splitplane, int frontside, qboolean precedence)
 	split = &planes[splitplane];
 
 	insidelist = NULL;
-	for (f = inside ; f ; f = next)
+	for (f = hull->inside ; f ; f = next)
 	{
 		next = f->next;
 
@@ -237,13 +229,13 @@ static void ClipInside (int splitplane, int frontside, qboolean precedence)
 		}
 		else
 		{	// proper split
-			SplitFace (f, split, &frags[0], &frags[1]);
+			SplitFace (hull, f, split, &frags[0], &frags[1]);
 		}
 
 		if (frags[frontside])
 		{
-			frags[frontside]->next = outside;
-			outside = frags[frontside];
+			frags[frontside]->next = hull->outside;
+			hull->outside = frags[frontside];
 		}
 		if (frags[!frontside])
 		{
@@ -252,7 +244,7 @@ static void ClipInside (int splitplane, int frontside, qboolean precedence)
 		}
 	}
 
-	inside = insidelist;
+	hull->inside = insidelist;
 }
 
 
@@ -263,22 +255,22 @@ SaveOutside
 Saves all of the faces in the outside list to the bsp plane list
 ==================
 */
-static void SaveOutside (qboolean mirror)
+static void SaveOutside (hullinfo_t *hull, qboolean mirror)
 {
 	face_t	*f, *next, *newf;
 	int		i;
 	int		planenum;
 
-	for (f = outside ; f ; f = next)
+	for (f = hull->outside ; f ; f = next)
 	{
 		next = f->next;
-		csgfaces++;
+		hull->csgfaces++;
 		Draw_DrawFace (f);
 		planenum = f->planenum;
 
 		if (mirror)
 		{
-			newf = NewFaceFromFace (f);
+			newf = NewFaceFromFace (hull, f);
 
 			newf->numpoints = f->numpoints;
 			newf->planeside = f->planeside ^ 1;	// reverse side
@@ -293,11 +285,11 @@ static void SaveOutside (qboolean mirror)
 		else
 			newf = NULL;
 
-		validfaces[planenum] = MergeFaceToList(f, validfaces[planenum]);
+		hull->validfaces[planenum] = MergeFaceToList(hull, f, hull->validfaces[planenum]);
 		if (newf)
-			validfaces[planenum] = MergeFaceToList(newf, validfaces[planenum]);
+			hull->validfaces[planenum] = MergeFaceToList(hull, newf, hull->validfaces[planenum]);
 
-		validfaces[planenum] = FreeMergeListScraps (validfaces[planenum]);
+		hull->validfaces[planenum] = FreeMergeListScraps (hull, hull->validfaces[planenum]);
 	}
 }
 
@@ -308,22 +300,22 @@ FreeInside
 Free all the faces that got clipped out
 ==================
 */
-static void FreeInside (int contents)
+static void FreeInside (hullinfo_t *hull, int contents)
 {
 	face_t	*f, *next;
 
-	for (f = inside ; f ; f = next)
+	for (f = hull->inside ; f ; f = next)
 	{
 		next = f->next;
 
 		if (contents != CONTENTS_SOLID)
 		{
 			f->contents[0] = contents;
-			f->next = outside;
-			outside = f;
+			f->next = hull->outside;
+			hull->outside = f;
 		}
 		else
-			FreeFace (f);
+			FreeFace (hull, f);
 	}
 }
 
@@ -338,7 +330,7 @@ Returns a chain of all the external surfaces with one or more visible
 faces.
 ==================
 */
-surface_t *BuildSurfaces (void)
+surface_t *BuildSurfaces (hullinfo_t *hull)
 {
 	face_t			**f;
 	face_t			*count;
@@ -348,20 +340,20 @@ surface_t *BuildSurfaces (void)
 
 	surfhead = NULL;
 
-	f = validfaces;
+	f = hull->validfaces;
 	for (i = 0 ; i < numbrushplanes ; i++, f++)
 	{
 		if (!*f)
 			continue;	// nothing left on this plane
 
 	// create a new surface to hold the faces on this plane
-		s = AllocSurface ();
+		s = AllocSurface (hull);
 		s->planenum = i;
 		s->next = surfhead;
 		surfhead = s;
 		s->faces = *f;
 		for (count = s->faces ; count ; count = count->next)
-			csgmergefaces++;
+			hull->csgmergefaces++;
 		CalcSurfaceInfo (s);	// bounding box and flags
 	}
 
@@ -375,15 +367,15 @@ surface_t *BuildSurfaces (void)
 CopyFacesToOutside
 ==================
 */
-static void CopyFacesToOutside (brush_t *b)
+static void CopyFacesToOutside (hullinfo_t *hull, brush_t *b)
 {
 	face_t		*f, *newf;
 
-	outside = NULL;
+	hull->outside = NULL;
 
 	for (f = b->faces ; f ; f = f->next)
 	{
-		brushfaces++;
+		hull->brushfaces++;
 #if 0
 		{
 			int		i;
@@ -393,12 +385,12 @@ static void CopyFacesToOutside (brush_t *b)
 			printf ("\n");
 		}
 #endif
-		newf = AllocFace ();
+		newf = AllocFace (hull);
 		*newf = *f;
-		newf->next = outside;
+		newf->next = hull->outside;
 		newf->contents[0] = CONTENTS_EMPTY;
 		newf->contents[1] = b->contents;
-		outside = newf;
+		hull->outside = newf;
 	}
 }
 
@@ -410,7 +402,7 @@ CSGFaces
 Returns a list of surfaces containing aall of the faces
 ==================
 */
-surface_t *CSGFaces (brushset_t *bs)
+surface_t *CSGFaces (hullinfo_t *hull, brushset_t *bs)
 {
 	brush_t		*b1, *b2;
 	int			i;
@@ -418,11 +410,11 @@ surface_t *CSGFaces (brushset_t *bs)
 	face_t		*f;
 	surface_t	*surfhead;
 
-	qprintf ("---- CSGFaces ----\n");
+	hprintf (hull, "---- CSGFaces ----\n");
 
-	memset (validfaces, 0, sizeof(validfaces));
+	memset (hull->validfaces, 0, sizeof(hull->validfaces));
 
-	csgfaces = brushfaces = csgmergefaces = 0;
+	hull->csgfaces = hull->brushfaces = hull->csgmergefaces = 0;
 
 	Draw_ClearWindow ();
 
@@ -432,7 +424,7 @@ surface_t *CSGFaces (brushset_t *bs)
 	for (b1 = bs->brushes ; b1 ; b1 = b1->next)
 	{
 	// set outside to a copy of the brush's faces
-		CopyFacesToOutside (b1);
+		CopyFacesToOutside (hull, b1);
 
 		overwrite = false;
 
@@ -455,36 +447,36 @@ surface_t *CSGFaces (brushset_t *bs)
 
 		// divide faces by the planes of the new brush
 
-			inside = outside;
-			outside = NULL;
+			hull->inside = hull->outside;
+			hull->outside = NULL;
 
 			for (f = b2->faces ; f ; f = f->next)
-				ClipInside (f->planenum, f->planeside, overwrite);
+				ClipInside (hull, f->planenum, f->planeside, overwrite);
 
 		// these faces are continued in another brush, so get rid of them
 			if (b1->contents == CONTENTS_SOLID && b2->contents <= CONTENTS_WATER)
-				FreeInside (b2->contents);
+				FreeInside (hull, b2->contents);
 			else
-				FreeInside (CONTENTS_SOLID);
+				FreeInside (hull, CONTENTS_SOLID);
 		}
 
 	// all of the faces left in outside are real surface faces
 		if (b1->contents != CONTENTS_SOLID)
-			SaveOutside (true);	// mirror faces for inside view
+			SaveOutside (hull, true);	// mirror faces for inside view
 		else
-			SaveOutside (false);
+			SaveOutside (hull, false);
 	}
 
 #if 0
-	if (!csgfaces)
+	if (!hull->csgfaces)
 		COM_Error ("No faces");
 #endif
 
-	surfhead = BuildSurfaces ();
+	surfhead = BuildSurfaces (hull);
 
-	qprintf ("%5i brushfaces\n", brushfaces);
-	qprintf ("%5i csgfaces\n", csgfaces);
-	qprintf ("%5i mergedfaces\n", csgmergefaces);
+	hprintf (hull, "%5i brushfaces\n", hull->brushfaces);
+	hprintf (hull, "%5i csgfaces\n", hull->csgfaces);
+	hprintf (hull, "%5i mergedfaces\n", hull->csgmergefaces);
 
 	return surfhead;
 }
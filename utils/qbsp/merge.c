@@ -70,7 +70,7 @@ Returns NULL if the faces couldn't be merged, or the new face.
 The originals will NOT be freed.
 =============
 */
-static face_t *TryMerge (face_t *f1, face_t *f2)
+static face_t *TryMerge (hullinfo_t *hull, face_t *f1, face_t *f2)
 {
 	double		*p1, *p2, *p3, *p4, *back;
 	face_t		*newf;
@@ -166,7 +166,7 @@ static face_t *TryMerge (face_t *f1, face_t *f2)
 		return NULL;
 	}
 
-	newf = NewFaceFromFace (f1);
+	newf = NewFaceFromFace (hull, f1);
 
 // copy first polygon
 	for (k = (i+1)%f1->numpoints ; k != i ; k = (k+1)%f1->numpoints)
@@ -197,7 +197,7 @@ MergeFaceToList
 ===============
 */
 static qboolean		mergedebug;
-face_t *MergeFaceToList (face_t *face, face_t *list)
+face_t *MergeFaceToList (hullinfo_t *hull, face_t *face, face_t *list)
 {
 	face_t	*newf, *f;
 
@@ -211,12 +211,12 @@ face_t *MergeFaceToList (face_t *face, face_t *list)
 			Draw_DrawFace (f);
 			Draw_SetBlack ();
 		}
-		newf = TryMerge (face, f);
+		newf = TryMerge (hull, face, f);
 		if (!newf)
 			continue;
-		FreeFace (face);
+		FreeFace (hull, face);
 		f->numpoints = -1;		// merged out
-		return MergeFaceToList (newf, list);
+		return MergeFaceToList (hull, newf, list);
 	}
 
 // didn't merge, so add at start
@@ -230,7 +230,7 @@ face_t *MergeFaceToList (face_t *face, face_t *list)
 FreeMergeListScraps
 ===============
 */
-face_t *FreeMergeListScraps (face_t *merged)
+face_t *FreeMergeListScraps (hullinfo_t *hull, face_t *merged)
 {
 	face_t	*head, *next;
 
@@ -239,7 +239,7 @@ face_t *FreeMergeListScraps (face_t *merged)
 	{
 		next = merged->next;
 		if (merged->numpoints == -1)
-			FreeFace (merged);
+			FreeFace (hull, merged);
 		else
 		{
 			merged->next = head;
@@ -256,7 +256,7 @@ face_t *FreeMergeListScraps (face_t *merged)
 MergePlaneFaces
 ===============
 */
-void MergePlaneFaces (surface_t *plane)
+void MergePlaneFaces (hullinfo_t *hull, surface_t *plane)
 {
 	face_t	*f1, *next;
 	face_t	*merged;
@@ -266,11 +266,11 @@ void MergePlaneFaces (surface_t *plane)
 	for (f1 = plane->faces ; f1 ; f1 = next)
 	{
 		next = f1->next;
-		merged = MergeFaceToList (f1, merged);
+		merged = MergeFaceToList (hull, f1, merged);
 	}
 
 // chain all of the non-empty faces to the plane
-	plane->faces = FreeMergeListScraps (merged);
+	plane->faces = FreeMergeListScraps (hull, merged);
 }
 
 
@@ -279,7 +279,7 @@ void MergePlaneFaces (surface_t *plane)
 MergeAll
 ============
 */
-void MergeAll (surface_t *surfhead)
+void MergeAll (hullinfo_t *hull, surface_t *surfhead)
 {
 	surface_t	*surf;
 	int			mergefaces;
@@ -290,7 +290,7 @@ void MergeAll (surface_t *surfhead)
 	mergefaces = 0;
 	for (surf = surfhead ; surf ; surf = surf->next)
 	{
-		MergePlaneFaces (surf);
+		MergePlaneFaces (hull, surf);
 		Draw_ClearWindow ();
 		for (f = surf->faces ; f ; f = f->next)
 		{
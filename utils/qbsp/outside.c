@@ -27,8 +27,6 @@
 #include "bsp5.h"
 
 
-static int		outleafs;
-
 /*
 ===========
 PointInLeaf
@@ -71,20 +69,18 @@ static qboolean PlaceOccupant (int num, vec3_t point, node_t *headnode)
 MarkLeakTrail
 ==============
 */
-static portal_t	*prevleaknode;
-static FILE	*leakfile;
-static void MarkLeakTrail (portal_t *n2)
+static void MarkLeakTrail (hullinfo_t *hull, portal_t *n2)
 {
 	int		i, j;
 	vec3_t	p1, p2, dir;
 	float	len;
 	portal_t	*n1;
 
-	if (hullnum)
+	if (hull->hullnum)
 		return;
 
-	n1 = prevleaknode;
-	prevleaknode = n2;
+	n1 = hull->prevleaknode;
+	hull->prevleaknode = n2;
 
 	if (!n1)
 		return;
@@ -109,7 +105,7 @@ static void MarkLeakTrail (portal_t *n2)
 
 	while (len > 2)
 	{
-		fprintf (leakfile,"%f %f %f\n", p1[0], p1[1], p1[2]);
+		fprintf (hull->leakfile,"%f %f %f\n", p1[0], p1[1], p1[2]);
 		for (i = 0 ; i < 3 ; i++)
 			p1[i] += dir[i]*2;
 		len -= 2;
@@ -124,9 +120,7 @@ If fill is false, just check, don't fill
 Returns true if an occupied leaf is reached
 ==================
 */
-static int		hit_occupied;
-static int		backdraw;
-static qboolean RecursiveFillOutside (node_t *l, qboolean fill)
+static qboolean RecursiveFillOutside (hullinfo_t *hull, node_t *l, qboolean fill)
 {
 	portal_t	*p;
 	int			s;
@@ -135,18 +129,18 @@ static qboolean RecursiveFillOutside (node_t *l, qboolean fill)
 	if (l->contents == CONTENTS_SOLID)
 		return false;
 
-	if (l->valid == valid)
+	if (l->valid == hull->valid)
 		return false;
 
-	l->valid = valid;
+	l->valid = hull->valid;
 
 // Some people have been intentionaly putting lights inside sky volumes,
 // so I have to fail the check now that I am testing
 	if (l->occupied && l->contents != CONTENTS_SKY)
 	{
-		hit_occupied = l->occupied;
+		hull->hit_occupied = l->occupied;
 		//drawflag = true;
-		backdraw = 4000;
+		hull->backdraw = 4000;
 		Draw_ClearWindow ();
 		DrawLeaf (l, 2);
 		return true;
@@ -156,7 +150,7 @@ static qboolean RecursiveFillOutside (node_t *l, qboolean fill)
 	original_contents = l->contents;
 	if (fill)
 		l->contents = CONTENTS_SOLID;
-	outleafs++;
+	hull->outleafs++;
 
 	for (p = l->portals ; p ; )
 	{
@@ -165,11 +159,11 @@ static qboolean RecursiveFillOutside (node_t *l, qboolean fill)
 	// flood fill into skys, but not back out
 		if (original_contents != CONTENTS_SKY || p->nodes[s]->contents == CONTENTS_SKY )
 		{
-			if (RecursiveFillOutside (p->nodes[s], fill) )
+			if (RecursiveFillOutside (hull, p->nodes[s], fill) )
 			{	// leaked, so stop filling
-				if (backdraw-- > 0)
+				if (hull->backdraw-- > 0)
 				{
-					MarkLeakTrail (p);
+					MarkLeakTrail (hull, p);
 					DrawLeaf (l, 2);
 				}
 				return true;
@@ -217,14 +211,15 @@ FillOutside
 
 ===========
 */
-qboolean FillOutside (node_t *node)
+qboolean FillOutside (hullinfo_t *hull, node_t *node)
 {
 	int			s;
 	double		*v;
 	int			i;
 	qboolean	inside;
+	node_t		*outside_node;
 
-	qprintf ("----- FillOutside ----\n");
+	hprintf (hull, "----- FillOutside ----\n");
 
 	if (nofill)
 	{
@@ -244,48 +239,49 @@ qboolean FillOutside (node_t *node)
 
 	if (!inside)
 	{
-		printf ("Hullnum %i: No entities in empty space -- no filling performed\n", hullnum);
+		printf ("Hullnum %i: No entities in empty space -- no filling performed\n", hull->hullnum);
 		return false;
 	}
 
-	s = !(outside_node.portals->nodes[1] == &outside_node);
+	outside_node = &hull->outside_node;
+	s = !(outside_node->portals->nodes[1] == outside_node);
 
 // first check to see if an occupied leaf is hit
-	outleafs = 0;
-	valid++;
+	hull->outleafs = 0;
+	hull->valid++;
 
-	prevleaknode = NULL;
+	hull->prevleaknode = NULL;
 
-	if (!hullnum)
+	if (!hull->hullnum)
 	{
-		leakfile = fopen (pointfilename, "w");
-		if (!leakfile)
+		hull->leakfile = fopen (pointfilename, "w");
+		if (!hull->leakfile)
 			COM_Error ("Couldn't open %s\n", pointfilename);
 	}
 
-	if (RecursiveFillOutside (outside_node.portals->nodes[s], false))
+	if (RecursiveFillOutside (hull, outside_node->portals->nodes[s], false))
 	{
-		v = entities[hit_occupied].origin;
-		qprintf ("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
-		qprintf ("reached occupant at: (%4.0f,%4.0f,%4.0f)\n", v[0], v[1], v[2]);
-		qprintf ("no filling performed\n");
-		if (!hullnum)
-			fclose (leakfile);
-		qprintf ("leak file written to %s\n", pointfilename);
-		qprintf ("!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
+		v = entities[hull->hit_occupied].origin;
+		hprintf (hull, "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
+		hprintf (hull, "reached occupant at: (%4.0f,%4.0f,%4.0f)\n", v[0], v[1], v[2]);
+		hprintf (hull, "no filling performed\n");
+		if (!hull->hullnum)
+			fclose (hull->leakfile);
+		hprintf (hull, "leak file written to %s\n", pointfilename);
+		hprintf (hull, "!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!\n");
 		return false;
 	}
-	if (!hullnum)
-		fclose (leakfile);
+	if (!hull->hullnum)
+		fclose (hull->leakfile);
 
 // now go back and fill things in
-	valid++;
-	RecursiveFillOutside (outside_node.portals->nodes[s], true);
+	hull->valid++;
+	RecursiveFillOutside (hull, outside_node->portals->nodes[s], true);
 
 // remove faces from filled in leafs
 	ClearOutFaces (node);
 
-	qprintf ("%4i outleafs\n", outleafs);
+	hprintf (hull, "%4i outleafs\n", hull->outleafs);
 	return true;
 }
 
@@ -27,8 +27,6 @@
 #include "bsp5.h"
 
 
-node_t	outside_node;		// portals outside the world face this
-
 //=============================================================================
 
 /*
@@ -108,41 +106,29 @@ void PrintPortal (portal_t *p)
 
 /*
 ================
-MakeHeadnodePortals
+MakeHeadnodePlanes
 
-The created portals will face the global outside_node
+The planes of the box around the brushset, padded with some space so
+there will never be null volume leafs
 ================
 */
-static void MakeHeadnodePortals (node_t *node)
+static void MakeHeadnodePlanes (brushset_t *bs, plane_t *bplanes)
 {
 	vec3_t		bounds[2];
-	int			i, j, n;
-	portal_t	*p, *portals[6];
-	plane_t		bplanes[6], *pl;
-	int			side;
-
-	Draw_ClearWindow ();
+	int			i, j;
+	plane_t		*pl;
 
-// pad with some space so there will never be null volume leafs
 	for (i = 0 ; i < 3 ; i++)
 	{
-		bounds[0][i] = brushset->mins[i] - SIDESPACE;
-		bounds[1][i] = brushset->maxs[i] + SIDESPACE;
+		bounds[0][i] = bs->mins[i] - SIDESPACE;
+		bounds[1][i] = bs->maxs[i] + SIDESPACE;
 	}
 
-	outside_node.contents = CONTENTS_SOLID;
-	outside_node.portals = NULL;
-
 	for (i = 0 ; i < 3 ; i++)
 	{
 		for (j = 0 ; j < 2 ; j++)
 		{
-			n = j*3 + i;
-
-			p = AllocPortal ();
-			portals[n] = p;
-
-			pl = &bplanes[n];
+			pl = &bplanes[j*3 + i];
 			memset (pl, 0, sizeof(*pl));
 			if (j)
 			{
@@ -154,13 +140,73 @@ static void MakeHeadnodePortals (node_t *node)
 				pl->normal[i] = 1;
 				pl->dist = bounds[j][i];
 			}
+		}
+	}
+}
+
+/*
+================
+AddHeadnodePlanes
+
+Adds the headnode planes to the plane list in the order MakeHeadnodePortals
+looks them up, so that portalizing the brushset later doesn't have to
+create any planes.
+================
+*/
+void AddHeadnodePlanes (brushset_t *bs)
+{
+	plane_t		bplanes[6];
+	int			i, j, side;
+
+	MakeHeadnodePlanes (bs, bplanes);
+
+	for (i = 0 ; i < 3 ; i++)
+	{
+		for (j = 0 ; j < 2 ; j++)
+			FindPlane (&bplanes[j*3 + i], &side);
+	}
+}
+
+/*
+================
+MakeHeadnodePortals
+
+The created portals will face the hull's outside_node
+================
+*/
+static void MakeHeadnodePortals (hullinfo_t *hull, node_t *node)
+{
+	int			i, j, n;
+	portal_t	*p, *portals[6];
+	plane_t		bplanes[6], *pl;
+	int			side;
+	node_t		*outside_node;
+
+	Draw_ClearWindow ();
+
+	MakeHeadnodePlanes (hull->brushset, bplanes);
+
+	outside_node = &hull->outside_node;
+	outside_node->contents = CONTENTS_SOLID;
+	outside_node->portals = NULL;
+
+	for (i = 0 ; i < 3 ; i++)
+	{
+		for (j = 0 ; j < 2 ; j++)
+		{
+			n = j*3 + i;
+
+			p = AllocPortal (hull);
+			portals[n] = p;
+
+			pl = &bplanes[n];
 			p->planenum = FindPlane (pl, &side);
 
-			p->winding = BaseWindingForPlane (pl);
+			p->winding = BaseWindingForPlane (hull, pl);
 			if (side)
-				AddPortalToNodes (p, &outside_node, node);
+				AddPortalToNodes (p, outside_node, node);
 			else
-				AddPortalToNodes (p, node, &outside_node);
+				AddPortalToNodes (p, node, outside_node);
 		}
 	}
 
@@ -171,7 +217,7 @@ static void MakeHeadnodePortals (node_t *node)
 		{
 			if (j == i)
 				continue;
-			portals[i]->winding = ClipWinding (portals[i]->winding, &bplanes[j], true);
+			portals[i]->winding = ClipWinding (hull, portals[i]->winding, &bplanes[j], true);
 		}
 	}
 }
@@ -285,7 +331,7 @@ CutNodePortals_r
 
 ================
 */
-static void CutNodePortals_r (node_t *node)
+static void CutNodePortals_r (hullinfo_t *hull, node_t *node)
 {
 	plane_t		*plane, clipplane;
 	node_t		*f, *b, *other_node;
@@ -312,10 +358,10 @@ static void CutNodePortals_r (node_t *node)
 // create the new portal by taking the full plane winding for the cutting plane
 // and clipping it by all of the planes from the other portals
 //
-	new_portal = AllocPortal ();
+	new_portal = AllocPortal (hull);
 	new_portal->planenum = node->planenum;
 
-	w = BaseWindingForPlane (&planes[node->planenum]);
+	w = BaseWindingForPlane (hull, &planes[node->planenum]);
 	for (p = node->portals ; p ; p = p->next[side])
 	{
 		clipplane = planes[p->planenum];
@@ -333,7 +379,7 @@ static void CutNodePortals_r (node_t *node)
 			return; /* silence compiler */
 		}
 
-		w = ClipWinding (w, &clipplane, true);
+		w = ClipWinding (hull, w, &clipplane, true);
 		if (!w)
 		{
 			printf ("WARNING: %s: new portal was clipped away\n", __thisfunc__);
@@ -368,7 +414,7 @@ static void CutNodePortals_r (node_t *node)
 //
 // cut the portal into two portals, one on each side of the cut plane
 //
-		DivideWinding (p->winding, plane, &frontwinding, &backwinding);
+		DivideWinding (hull, p->winding, plane, &frontwinding, &backwinding);
 
 		if (!frontwinding)
 		{
@@ -388,10 +434,10 @@ static void CutNodePortals_r (node_t *node)
 		}
 
 	// the winding is split
-		new_portal = AllocPortal ();
+		new_portal = AllocPortal (hull);
 		*new_portal = *p;
 		new_portal->winding = backwinding;
-		FreeWinding (p->winding);
+		FreeWinding (hull, p->winding);
 		p->winding = frontwinding;
 
 		if (side == 0)
@@ -409,8 +455,8 @@ static void CutNodePortals_r (node_t *node)
 	DrawLeaf (f,1);
 	DrawLeaf (b,2);
 
-	CutNodePortals_r (f);
-	CutNodePortals_r (b);
+	CutNodePortals_r (hull, f);
+	CutNodePortals_r (hull, b);
 }
 
 
@@ -421,12 +467,12 @@ PortalizeWorld
 Builds the exact polyhedrons for the nodes and leafs
 ==================
 */
-void PortalizeWorld (node_t *headnode)
+void PortalizeWorld (hullinfo_t *hull, node_t *headnode)
 {
-	qprintf ("----- portalize ----\n");
+	hprintf (hull, "----- portalize ----\n");
 
-	MakeHeadnodePortals (headnode);
-	CutNodePortals_r (headnode);
+	MakeHeadnodePortals (hull, headnode);
+	CutNodePortals_r (hull, headnode);
 }
 
 
@@ -436,14 +482,14 @@ FreeAllPortals
 
 ==================
 */
-void FreeAllPortals (node_t *node)
+void FreeAllPortals (hullinfo_t *hull, node_t *node)
 {
 	portal_t	*p, *nextp;
 
 	if (!node->contents)
 	{
-		FreeAllPortals (node->children[0]);
-		FreeAllPortals (node->children[1]);
+		FreeAllPortals (hull, node->children[0]);
+		FreeAllPortals (hull, node->children[1]);
 	}
 
 	for (p = node->portals ; p ; p = nextp)
@@ -454,8 +500,8 @@ void FreeAllPortals (node_t *node)
 			nextp = p->next[1];
 		RemovePortalFromNode (p, p->nodes[0]);
 		RemovePortalFromNode (p, p->nodes[1]);
-		FreeWinding (p->winding);
-		FreePortal (p);
+		FreeWinding (hull, p->winding);
+		FreePortal (hull, p);
 	}
 }
 
@@ -29,6 +29,7 @@
 #include "mathlib.h"
 #include "bspfile.h"
 #include "bsp5.h"
+#include "threads.h"
 #include "filenames.h"
 
 
@@ -45,6 +46,7 @@ qboolean	allverbose;
 qboolean	usehulls;
 qboolean	oldhullsize;
 qboolean	watervis = false;
+qboolean	nocache;
 
 char	projectpath[1024];	// with a trailing slash
 char	bspfilename[1024];
@@ -52,12 +54,19 @@ char	pointfilename[1024];
 char	portfilename[1024];
 char	hullfilename[1024];
 
-int		valid;
 int		usebsp2 = 0;
 qboolean        worldmodel;
 int             hullnum = 0;
 
-brushset_t	*brushset;
+// the hulls being built concurrently
+static hullinfo_t	*hulls[NUM_HULLS];
+static int		numhulls, nexthull;
+
+// the worker threads recurse through the node trees
+#define	HULL_STACKSIZE	0x800000
+
+// all the hulls of the world were filled, for the build cache
+static qboolean	worldfilled;
 
 
 //===========================================================================
@@ -74,12 +83,24 @@ void qprintf (const char *fmt, ...)
 	va_end (argptr);
 }
 
+void hprintf (hullinfo_t *hull, const char *fmt, ...)
+{
+	va_list argptr;
+
+	if (!hull->verbose)
+		return;
+
+	va_start (argptr, fmt);
+	vprintf (fmt, argptr);
+	va_end (argptr);
+}
+
 /*
 =================
 BaseWindingForPlane
 =================
 */
-winding_t *BaseWindingForPlane (plane_t *p)
+winding_t *BaseWindingForPlane (hullinfo_t *hull, plane_t *p)
 {
 	int		i, x;
 	double	max, v;
@@ -125,7 +146,7 @@ winding_t *BaseWindingForPlane (plane_t *p)
 	VectorScale (vright, 8192, vright);
 
 // project a really big axis aligned box onto the plane
-	w = NewWinding (4);
+	w = NewWinding (hull, 4);
 
 	VectorSubtract (org, vright, w->points[0]);
 	VectorAdd (w->points[0], vup, w->points[0]);
@@ -150,14 +171,13 @@ winding_t *BaseWindingForPlane (plane_t *p)
 CopyWinding
 ==================
 */
-winding_t *CopyWinding (winding_t *w)
+winding_t *CopyWinding (hullinfo_t *hull, winding_t *w)
 {
-	size_t			size;
 	winding_t	*c;
 
-	size = (size_t)((winding_t *)0)->points[w->numpoints];
-	c = (winding_t *) SafeMalloc (size);
-	memcpy (c, w, size);
+	c = NewWinding (hull, w->numpoints);
+	c->numpoints = w->numpoints;
+	memcpy (c->points, w->points, w->numpoints * sizeof(vec3_t));
 	return c;
 }
 
@@ -186,7 +206,7 @@ If keepon is true, an exactly on-plane winding will be saved, otherwise
 it will be clipped away.
 ==================
 */
-winding_t *ClipWinding (winding_t *in, plane_t *split, qboolean keepon)
+winding_t *ClipWinding (hullinfo_t *hull, winding_t *in, plane_t *split, qboolean keepon)
 {
 	double	dists[MAX_POINTS_ON_WINDING];
 	int		sides[MAX_POINTS_ON_WINDING];
@@ -225,7 +245,7 @@ winding_t *ClipWinding (winding_t *in, plane_t *split, qboolean keepon)
 
 	if (!counts[0])
 	{
-		FreeWinding (in);
+		FreeWinding (hull, in);
 		return NULL;
 	}
 	if (!counts[1])
@@ -233,7 +253,7 @@ winding_t *ClipWinding (winding_t *in, plane_t *split, qboolean keepon)
 
 	maxpts = in->numpoints + 4;	// can't use counts[0]+2 because
 					// of fp grouping errors
-	neww = NewWinding (maxpts);
+	neww = NewWinding (hull, maxpts);
 
 	for (i = 0 ; i < in->numpoints ; i++)
 	{
@@ -277,7 +297,7 @@ winding_t *ClipWinding (winding_t *in, plane_t *split, qboolean keepon)
 		COM_Error ("%s: points exceeded estimate", __thisfunc__);
 
 // free the original winding
-	FreeWinding (in);
+	FreeWinding (hull, in);
 
 	return neww;
 }
@@ -293,7 +313,7 @@ returned winding will be the input winding.  If on both sides, two
 new windings will be created.
 ==================
 */
-void DivideWinding (winding_t *in, plane_t *split, winding_t **front, winding_t **back)
+void DivideWinding (hullinfo_t *hull, winding_t *in, plane_t *split, winding_t **front, winding_t **back)
 {
 	double	dists[MAX_POINTS_ON_WINDING];
 	int		sides[MAX_POINTS_ON_WINDING];
@@ -343,8 +363,8 @@ void DivideWinding (winding_t *in, plane_t *split, winding_t **front, winding_t
 	maxpts = in->numpoints + 4;	// can't use counts[0]+2 because
 					// of fp grouping errors
 
-	*front = f = NewWinding (maxpts);
-	*back = b = NewWinding (maxpts);
+	*front = f = NewWinding (hull, maxpts);
+	*back = b = NewWinding (hull, maxpts);
 
 	for (i = 0 ; i < in->numpoints ; i++)
 	{
@@ -400,49 +420,172 @@ void DivideWinding (winding_t *in, plane_t *split, winding_t **front, winding_t
 
 //===========================================================================
 
-#if 0	/* no users */
-static int		c_activefaces, c_peakfaces;
-static int		c_activesurfaces, c_peaksurfaces;
-static int		c_activewindings, c_peakwindings;
-static int		c_activeportals, c_peakportals;
+/*
+=============================================================================
+
+MEMORY POOLS
+
+Faces, surfaces, portals and windings are allocated and freed many times
+for every entity.  Each hull keeps them in its own pools, so the hull
+threads don't share a heap and no locks are needed.
+
+=============================================================================
+*/
+
+#define	POOL_BLOCKSIZE		0x10000
 
-void PrintMemory (void)
+static void InitPool (mempool_t *pool, size_t itemsize)
 {
-	printf ("faces   : %6i (%6i)\n", c_activefaces, c_peakfaces);
-	printf ("surfaces: %6i (%6i)\n", c_activesurfaces, c_peaksurfaces);
-	printf ("windings: %6i (%6i)\n", c_activewindings, c_peakwindings);
-	printf ("portals : %6i (%6i)\n", c_activeportals, c_peakportals);
+	pool->itemsize = itemsize;
+	pool->blockitems = (int)(POOL_BLOCKSIZE / itemsize);
+	if (pool->blockitems < 1)
+		pool->blockitems = 1;
+}
+
+static void *PoolAlloc (mempool_t *pool)
+{
+	void		*p;
+	poolblock_t	*block;
+
+	if (pool->freelist)
+	{
+		p = pool->freelist;
+		pool->freelist = *(void **)p;
+		memset (p, 0, pool->itemsize);
+	}
+	else
+	{
+		if (!pool->curblock || pool->used == pool->blockitems)
+		{
+			block = pool->curblock ? pool->curblock->next : pool->blocks;
+			if (!block)
+			{	// the blocks come zeroed from SafeMalloc
+				block = (poolblock_t *) SafeMalloc (sizeof(poolblock_t) + pool->blockitems * pool->itemsize);
+				if (pool->curblock)
+					pool->curblock->next = block;
+				else
+					pool->blocks = block;
+				pool->numblocks++;
+			}
+			else
+			{
+				memset (block + 1, 0, pool->blockitems * pool->itemsize);
+			}
+			pool->curblock = block;
+			pool->used = 0;
+		}
+		p = (byte *)(pool->curblock + 1) + pool->used * pool->itemsize;
+		pool->used++;
+	}
+
+	pool->allocs++;
+	pool->active++;
+	if (pool->active > pool->peak)
+		pool->peak = pool->active;
+
+	return p;
+}
+
+static void PoolFree (mempool_t *pool, void *p)
+{
+	*(void **)p = pool->freelist;
+	pool->freelist = p;
+	pool->active--;
+}
+
+static void ResetPool (mempool_t *pool)
+{
+	pool->curblock = NULL;
+	pool->used = 0;
+	pool->freelist = NULL;
+	pool->active = 0;
+}
+
+static void FreePool (mempool_t *pool)
+{
+	poolblock_t	*block, *next;
+
+	for (block = pool->blocks ; block ; block = next)
+	{
+		next = block->next;
+		free (block);
+	}
+	pool->blocks = pool->curblock = NULL;
+	pool->numblocks = 0;
+	ResetPool (pool);
+}
+
+static int PoolBytes (mempool_t *pool)
+{
+	return pool->numblocks * (int)(sizeof(poolblock_t) + pool->blockitems * pool->itemsize);
+}
+
+static void PrintPool (const char *name, mempool_t *pool)
+{
+	printf ("%-10s: %8i allocs %7i peak %6i KB\n", name,
+			pool->allocs, pool->peak, PoolBytes(pool) / 1024);
+}
+
+/*
+==================
+PrintMemory
+
+The peak use of the pools of the hull, for -verbose
+==================
+*/
+static void PrintMemory (hullinfo_t *hull)
+{
+	mempool_t	windings;
+	int		i, total;
+
+	memset (&windings, 0, sizeof(windings));
+	total = PoolBytes(&hull->facepool) + PoolBytes(&hull->surfacepool) +
+		PoolBytes(&hull->portalpool) + PoolBytes(&hull->brushfacepool);
+	for (i = 0 ; i < NUM_WINDINGPOOLS ; i++)
+	{
+		windings.allocs += hull->windingpools[i].allocs;
+		windings.peak += hull->windingpools[i].peak;
+		total += PoolBytes(&hull->windingpools[i]);
+	}
+
+	printf ("---- hull %i memory ----\n", hull->hullnum);
+	PrintPool ("brushfaces", &hull->brushfacepool);
+	PrintPool ("faces", &hull->facepool);
+	PrintPool ("surfaces", &hull->surfacepool);
+	PrintPool ("portals", &hull->portalpool);
+	printf ("%-10s: %8i allocs %7i peak\n", "windings", windings.allocs, windings.peak);
+	printf ("%i KB peak in pools\n", total / 1024);
 }
-#endif
 
 /*
 ==================
 NewWinding
 ==================
 */
-winding_t *NewWinding (int points)
+winding_t *NewWinding (hullinfo_t *hull, int points)
 {
 	winding_t	*w;
-	size_t			size;
+	int		i, maxpoints;
 
 	if (points > MAX_POINTS_ON_WINDING)
 		COM_Error ("%s: %i points", __thisfunc__, points);
 
-//	c_activewindings++;
-//	if (c_activewindings > c_peakwindings)
-//		c_peakwindings = c_activewindings;
-
-	size = (size_t)((winding_t *)0)->points[points];
-	w = (winding_t *) SafeMalloc (size);
+	for (i = 0, maxpoints = 8 ; maxpoints < points ; i++)
+		maxpoints <<= 1;
+	w = (winding_t *) PoolAlloc (&hull->windingpools[i]);
+	w->maxpoints = maxpoints;
 
 	return w;
 }
 
 
-void FreeWinding (winding_t *w)
+void FreeWinding (hullinfo_t *hull, winding_t *w)
 {
-//	c_activewindings--;
-	free (w);
+	int		i, maxpoints;
+
+	for (i = 0, maxpoints = 8 ; maxpoints < w->maxpoints ; i++)
+		maxpoints <<= 1;
+	PoolFree (&hull->windingpools[i], w);
 }
 
 
@@ -451,26 +594,38 @@ void FreeWinding (winding_t *w)
 AllocFace
 ===========
 */
-face_t *AllocFace (void)
+face_t *AllocFace (hullinfo_t *hull)
 {
 	face_t	*f;
 
-//	c_activefaces++;
-//	if (c_activefaces > c_peakfaces)
-//		c_peakfaces = c_activefaces;
+	f = (face_t *) PoolAlloc (&hull->facepool);
+	f->planenum = -1;
+
+	return f;
+}
+
+/*
+===========
+AllocBrushFace
+
+The brush faces of all the entities are loaded before the first one is
+processed, so they don't go away with the rest after each entity.
+===========
+*/
+face_t *AllocBrushFace (hullinfo_t *hull)
+{
+	face_t	*f;
 
-	f = (face_t *) SafeMalloc (sizeof(face_t));
+	f = (face_t *) PoolAlloc (&hull->brushfacepool);
 	f->planenum = -1;
 
 	return f;
 }
 
 
-void FreeFace (face_t *f)
+void FreeFace (hullinfo_t *hull, face_t *f)
 {
-//	c_activefaces--;
-//	memset (f,0xff,sizeof(face_t));
-	free (f);
+	PoolFree (&hull->facepool, f);
 }
 
 
@@ -479,23 +634,14 @@ void FreeFace (face_t *f)
 AllocSurface
 ===========
 */
-surface_t *AllocSurface (void)
+surface_t *AllocSurface (hullinfo_t *hull)
 {
-	surface_t	*s;
-
-	s = (surface_t *) SafeMalloc (sizeof(surface_t));
-
-//	c_activesurfaces++;
-//	if (c_activesurfaces > c_peaksurfaces)
-//		c_peaksurfaces = c_activesurfaces;
-
-	return s;
+	return (surface_t *) PoolAlloc (&hull->surfacepool);
 }
 
-void FreeSurface (surface_t *s)
+void FreeSurface (hullinfo_t *hull, surface_t *s)
 {
-//	c_activesurfaces--;
-	free (s);
+	PoolFree (&hull->surfacepool, s);
 }
 
 /*
@@ -503,23 +649,14 @@ void FreeSurface (surface_t *s)
 AllocPortal
 ===========
 */
-portal_t *AllocPortal (void)
+portal_t *AllocPortal (hullinfo_t *hull)
 {
-	portal_t	*p;
-
-//	c_activeportals++;
-//	if (c_activeportals > c_peakportals)
-//		c_peakportals = c_activeportals;
-
-	p = (portal_t *) SafeMalloc (sizeof(portal_t));
-
-	return p;
+	return (portal_t *) PoolAlloc (&hull->portalpool);
 }
 
-void FreePortal (portal_t *p)
+void FreePortal (hullinfo_t *hull, portal_t *p)
 {
-//	c_activeportals--;
-	free (p);
+	PoolFree (&hull->portalpool, p);
 }
 
 
@@ -553,44 +690,113 @@ brush_t *AllocBrush (void)
 
 //===========================================================================
 
+/*
+===========
+AllocHull
+===========
+*/
+static hullinfo_t *AllocHull (int hullnumber)
+{
+	hullinfo_t	*hull;
+	int		i;
+
+	hull = (hullinfo_t *) SafeMalloc (sizeof(hullinfo_t));
+	hull->hullnum = hullnumber;
+
+	InitPool (&hull->facepool, sizeof(face_t));
+	InitPool (&hull->surfacepool, sizeof(surface_t));
+	InitPool (&hull->portalpool, sizeof(portal_t));
+	for (i = 0 ; i < NUM_WINDINGPOOLS ; i++)
+		InitPool (&hull->windingpools[i], (size_t)((winding_t *)0)->points[8 << i]);
+	InitPool (&hull->brushfacepool, sizeof(face_t));
+
+	if (hullnumber)
+	{
+		hull->dplanes = (dplane_t *) SafeMalloc (MAX_MAP_PLANES * sizeof(dplane_t));
+		hull->clipnodes = (dclipnode2_t *) SafeMalloc (MAX_MAP_CLIPNODES * sizeof(dclipnode2_t));
+	}
+	else
+	{	// the drawing hull goes straight to the bsp file
+		hull->dplanes = dplanes;
+	}
+
+	return hull;
+}
+
+/*
+===========
+ResetHullPools
+
+Called after each entity, nothing from the entity is used afterwards
+===========
+*/
+static void ResetHullPools (hullinfo_t *hull)
+{
+	int		i;
+
+	ResetPool (&hull->facepool);
+	ResetPool (&hull->surfacepool);
+	ResetPool (&hull->portalpool);
+	for (i = 0 ; i < NUM_WINDINGPOOLS ; i++)
+		ResetPool (&hull->windingpools[i]);
+}
+
+static void FreeHull (hullinfo_t *hull)
+{
+	int		i;
+
+	if (allverbose)
+		PrintMemory (hull);
+
+	FreePool (&hull->facepool);
+	FreePool (&hull->surfacepool);
+	FreePool (&hull->portalpool);
+	for (i = 0 ; i < NUM_WINDINGPOOLS ; i++)
+		FreePool (&hull->windingpools[i]);
+	FreePool (&hull->brushfacepool);
+
+	if (hull->hullnum)
+	{
+		free (hull->dplanes);
+		free (hull->clipnodes);
+	}
+	free (hull);
+}
+
+//===========================================================================
+
 /*
 ===============
-ProcessEntity
+LoadEntity
+
+Loads the brushes of a bmodel for the hull
 ===============
 */
-static void ProcessEntity (int entnum)
+static void LoadEntity (hullinfo_t *hull, int entnum, int modelnum)
 {
 	entity_t	*ent;
 	char	mod[80];
-	surface_t	*surfs;
-	node_t		*nodes;
 	brushset_t	*bs;
 
 	ent = &entities[entnum];
-	if (!ent->brushes)
-		return;		// non-bmodel entity
 
 	if (entnum > 0)
 	{
 		worldmodel = false;
 		if (entnum == 1)
 			qprintf ("--- Internal Entities ---\n");
-		sprintf (mod, "*%i", nummodels);
+		sprintf (mod, "*%i", modelnum);
 		if (verbose)
 			PrintEntity (ent);
 
-		if (hullnum == 0)
+		if (hull->hullnum == 0)
 			printf ("MODEL: %s\n", mod);
 		SetKeyValue (ent, "model", mod);
 	}
 	else
 		worldmodel = true;
 
-//
-// take the brush_ts and clip off all overlapping and contained faces,
-// leaving a perfect skin of the model with no hidden faces
-//
-	bs = Brush_LoadEntity (ent, hullnum);
+	bs = Brush_LoadEntity (hull, ent);
 
 	if (!bs->brushes)
 	{
@@ -598,25 +804,85 @@ static void ProcessEntity (int entnum)
 		COM_Error ("Entity with no valid brushes");
 	}
 
-	brushset = bs;
-	surfs = CSGFaces (bs);
+	if (entnum == 0 && !nofill)	// the world will be portalized
+		AddHeadnodePlanes (bs);
+
+	hull->brushsets[entnum] = bs;
+}
+
+/*
+===============
+LoadHullBrushes
+
+Loads the brushes of all the entities for the hull.  This creates all the
+planes the hull will use, so the hulls must be loaded one at a time and
+always in the same order to get the same plane numbers.
+===============
+*/
+static void LoadHullBrushes (hullinfo_t *hull)
+{
+	int		entnum, modelnum;
 
-	if (hullnum != 0)
+	modelnum = 0;
+	for (entnum = 0 ; entnum < num_entities ; entnum++)
 	{
-		nodes = SolidBSP (surfs, true);
+		hull->entverbose[entnum] = verbose;
+		if (entities[entnum].brushes)	// else a non-bmodel entity
+			LoadEntity (hull, entnum, modelnum++);
+		if (!allverbose)
+			verbose = false;	// don't print rest of entities
+	}
+}
+
+/*
+===============
+ProcessEntity
+===============
+*/
+static void ProcessEntity (hullinfo_t *hull, int entnum)
+{
+	surface_t	*surfs;
+	node_t		*nodes;
+	brushset_t	*bs;
+	int		firstplane;
+
+	bs = hull->brushsets[entnum];
+	if (!bs)
+		return;		// non-bmodel entity
+
+	hull->verbose = hull->entverbose[entnum];
+	if (hull->hullnum == 0)
+		verbose = hull->verbose;	// only the drawing hull uses qprintf from here
+
+	if (hull->hullnum != 0 && ReuseClipHull (hull, entnum))
+		return;
+
+//
+// take the brush_ts and clip off all overlapping and contained faces,
+// leaving a perfect skin of the model with no hidden faces
+//
+	hull->brushset = bs;
+	surfs = CSGFaces (hull, bs);
+
+	if (hull->hullnum != 0)
+	{
+		nodes = SolidBSP (hull, surfs, true);
 		if (entnum == 0 && !nofill)	// assume non-world bmodels are simple
 		{
-			PortalizeWorld (nodes);
-			if (FillOutside (nodes))
+			PortalizeWorld (hull, nodes);
+			hull->filled = FillOutside (hull, nodes);
+			if (hull->filled)
 			{
-				surfs = GatherNodeFaces (nodes);
-				nodes = SolidBSP (surfs, false);	// make a really good tree
+				surfs = GatherNodeFaces (hull, nodes);
+				nodes = SolidBSP (hull, surfs, false);	// make a really good tree
 			}
-			FreeAllPortals (nodes);
+			FreeAllPortals (hull, nodes);
 		}
-		WriteNodePlanes (nodes);
-		WriteClipNodes (nodes);
-		BumpModel (hullnum);
+		firstplane = hull->numplanes;
+		WriteNodePlanes (hull, nodes);
+		WriteClipNodes (hull, nodes);
+		KeepClipHull (hull, entnum, firstplane);
+		BumpModel (hull);
 	}
 	else
 	{
@@ -626,7 +892,7 @@ static void ProcessEntity (int entnum)
 	// if not the world, make a good tree first
 	// the world is just going to make a bad tree
 	// because the outside filling will force a regeneration later
-		nodes = SolidBSP (surfs, entnum == 0);
+		nodes = SolidBSP (hull, surfs, entnum == 0);
 
 	//
 	// build all the portals in the bsp tree
@@ -634,46 +900,68 @@ static void ProcessEntity (int entnum)
 	//
 		if (entnum == 0 && !nofill)	// assume non-world bmodels are simple
 		{
-			PortalizeWorld (nodes);
+			PortalizeWorld (hull, nodes);
 
-			if (FillOutside (nodes))
+			hull->filled = FillOutside (hull, nodes);
+			if (hull->filled)
 			{
-				FreeAllPortals (nodes);
+				FreeAllPortals (hull, nodes);
 
 			// get the remaining faces together into surfaces again
-				surfs = GatherNodeFaces (nodes);
+				surfs = GatherNodeFaces (hull, nodes);
 
 			// merge polygons
-				MergeAll (surfs);
+				MergeAll (hull, surfs);
 
 			// make a really good tree
-				nodes = SolidBSP (surfs, false);
+				nodes = SolidBSP (hull, surfs, false);
 
 			// make the real portals for vis tracing
-				PortalizeWorld (nodes);
+				PortalizeWorld (hull, nodes);
 
 			// save portal file for vis tracing
 				WritePortalfile (nodes);
 
 			// fix tjunctions
-				tjunc (nodes);
+				tjunc (hull, nodes);
 			}
-			FreeAllPortals (nodes);
+			FreeAllPortals (hull, nodes);
 		}
 
-		WriteNodePlanes (nodes);
+		WriteNodePlanes (hull, nodes);
 		MakeFaceEdges (nodes);
 		WriteDrawNodes (nodes);
 	}
+
+	ResetHullPools (hull);
+}
+
+/*
+===============
+BuildHull
+
+The brushes must have been loaded with LoadHullBrushes
+===============
+*/
+static void BuildHull (hullinfo_t *hull)
+{
+	int		entnum;
+
+	for (entnum = 0 ; entnum < num_entities ; entnum++)
+		ProcessEntity (hull, entnum);
+
+	if (hull->hullnum == 0)
+		numplanes = hull->numplanes;
 }
 
 /*
 =================
-UpdateEntLump
+SetModelKeys
 
+Numbers the bmodels the way LoadHullBrushes does
 =================
 */
-static void UpdateEntLump (void)
+void SetModelKeys (void)
 {
 	int		m, entnum;
 	char	mod[80];
@@ -687,6 +975,17 @@ static void UpdateEntLump (void)
 		SetKeyValue (&entities[entnum], "model", mod);
 		m++;
 	}
+}
+
+/*
+=================
+UpdateEntLump
+
+=================
+*/
+static void UpdateEntLump (void)
+{
+	SetModelKeys ();
 
 	printf ("Updating entities lump...\n");
 	LoadBSPFile (bspfilename);
@@ -701,48 +1000,14 @@ WriteClipHull
 Write the clipping hull out to a text file so the parent process can get it
 =================
 */
-static void WriteClipHull (void)
-{
-	FILE	*f;
-	int		i;
-	dplane_t	*p;
-	dclipnode_t	*d;
-
-	hullfilename[strlen(hullfilename)-1] = '0' + hullnum;
-
-	qprintf ("---- WriteClipHull ----\n");
-	qprintf ("Writing %s\n", hullfilename);
-
-	f = fopen (hullfilename, "w");
-	if (!f)
-		COM_Error ("Couldn't open %s", hullfilename);
-
-	fprintf (f, "%i\n", nummodels);
-
-	for (i = 0 ; i < nummodels ; i++)
-		fprintf (f, "%i\n", dmodels[i].headnode[hullnum]);
-
-	fprintf (f, "\n%i\n", numclipnodes);
-
-	for (i = 0 ; i < numclipnodes ; i++)
-	{
-		d = &dclipnodes[i];
-		p = &dplanes[d->planenum];
-		// the node number is only written out for human readability
-		fprintf (f, "%5i : %f %f %f %f : %5i %5i\n", i, p->normal[0], p->normal[1], p->normal[2], p->dist, d->children[0], d->children[1]);
-	}
-
-	fclose (f);
-}
-
-static void WriteClipHull2 (void)
+static void WriteClipHull (hullinfo_t *hull)
 {
 	FILE	*f;
 	int		i;
 	dplane_t	*p;
 	dclipnode2_t	*d;
 
-	hullfilename[strlen(hullfilename)-1] = '0' + hullnum;
+	hullfilename[strlen(hullfilename)-1] = '0' + hull->hullnum;
 
 	qprintf ("---- WriteClipHull ----\n");
 	qprintf ("Writing %s\n", hullfilename);
@@ -751,17 +1016,17 @@ static void WriteClipHull2 (void)
 	if (!f)
 		COM_Error ("Couldn't open %s", hullfilename);
 
-	fprintf (f, "%i\n", nummodels);
+	fprintf (f, "%i\n", hull->nummodels);
 
-	for (i = 0 ; i < nummodels ; i++)
-		fprintf (f, "%i\n", dmodels[i].headnode[hullnum]);
+	for (i = 0 ; i < hull->nummodels ; i++)
+		fprintf (f, "%i\n", hull->headnodes[i]);
 
-	fprintf (f, "\n%i\n", numclipnodes);
+	fprintf (f, "\n%i\n", hull->numclipnodes);
 
-	for (i = 0 ; i < numclipnodes ; i++)
+	for (i = 0 ; i < hull->numclipnodes ; i++)
 	{
-		d = &dclipnodes2[i];
-		p = &dplanes[d->planenum];
+		d = &hull->clipnodes[i];
+		p = &hull->dplanes[d->planenum];
 		// the node number is only written out for human readability
 		fprintf (f, "%5i : %f %f %f %f : %5i %5i\n", i, p->normal[0], p->normal[1], p->normal[2], p->dist, d->children[0], d->children[1]);
 	}
@@ -896,6 +1161,87 @@ static void ReadClipHull2 (int hullnumber)
 	}
 }
 
+/*
+=================
+HullFileFloat
+
+The clipping hulls used to reach the parent process through the hull files,
+which have the planes with six decimals.  Round the same way so that the
+bsp files don't change.
+=================
+*/
+static float HullFileFloat (float f)
+{
+	char	buf[64];
+	float	v;
+
+	sprintf (buf, "%f", f);
+	if (sscanf (buf, "%f", &v) != 1)
+		COM_Error ("%s: bad value %s", __thisfunc__, buf);
+
+	return v;
+}
+
+/*
+=================
+MergeClipHull
+
+Adds a clipping hull that was built in memory the way ReadClipHull adds
+one from a hull file
+=================
+*/
+static void MergeClipHull (hullinfo_t *hull)
+{
+	int			i, j;
+	int			firstclipnode;
+	dplane_t	p, *hp;
+	dclipnode2_t	*hd;
+	int			c[2];
+	vec3_t		norm;
+
+	if (hull->nummodels != nummodels)
+		COM_Error ("%s: hull had %i models, base had %i", __thisfunc__, hull->nummodels, nummodels);
+
+	for (i = 0 ; i < nummodels ; i++)
+		dmodels[i].headnode[hull->hullnum] = numclipnodes + hull->headnodes[i];
+
+	firstclipnode = numclipnodes;
+
+	for (i = 0 ; i < hull->numclipnodes ; i++)
+	{
+		if (numclipnodes == MAX_MAP_CLIPNODES)
+			COM_Error ("%s: MAX_MAP_CLIPNODES", __thisfunc__);
+
+		hd = &hull->clipnodes[i];
+		hp = &hull->dplanes[hd->planenum];
+
+		for (j = 0 ; j < 3 ; j++)
+		{
+			p.normal[j] = HullFileFloat (hp->normal[j]);
+			norm[j] = p.normal[j];	// double precision
+		}
+		p.dist = HullFileFloat (hp->dist);
+		p.type = PlaneTypeForNormal (norm);
+
+		for (j = 0 ; j < 2 ; j++)
+			c[j] = hd->children[j] >= 0 ? hd->children[j] + firstclipnode : hd->children[j];
+
+		if (usebsp2)
+		{
+			dclipnodes2[numclipnodes].children[0] = c[0];
+			dclipnodes2[numclipnodes].children[1] = c[1];
+			dclipnodes2[numclipnodes].planenum = FindFinalPlane (&p);
+		}
+		else
+		{
+			dclipnodes[numclipnodes].children[0] = c[0];
+			dclipnodes[numclipnodes].children[1] = c[1];
+			dclipnodes[numclipnodes].planenum = FindFinalPlane (&p);
+		}
+		numclipnodes++;
+	}
+}
+
 /*
 =================
 CreateSingleHull
@@ -904,22 +1250,57 @@ CreateSingleHull
 */
 static void CreateSingleHull (void)
 {
-	int			entnum;
+	hullinfo_t	*hull;
 
-// for each entity in the map file that has geometry
-	for (entnum = 0 ; entnum < num_entities ; entnum++)
+	hull = AllocHull (hullnum);
+	LoadHullBrushes (hull);
+	BuildHull (hull);
+
+	if (hullnum)
+		WriteClipHull (hull);
+
+	FreeHull (hull);
+}
+
+/*
+=================
+ReadClipHulls
+
+Reads the existing hull files for the hulls that weren't built
+=================
+*/
+static void ReadClipHulls (void)
+{
+	int		i;
+
+	for (i = 1 ; i < NUM_HULLS ; i++)
 	{
-		ProcessEntity (entnum);
-		if (!allverbose)
-			verbose = false;	// don't print rest of entities
+		if (usebsp2)
+			ReadClipHull2 (i);
+		else
+			ReadClipHull (i);
 	}
+}
 
-	if (hullnum)
+/*
+=================
+BuildHullsThread
+
+=================
+*/
+static void BuildHullsThread (void *unused)
+{
+	int		i;
+
+	while (1)
 	{
-	    if (usebsp2)
-		WriteClipHull2 ();
-	    else
-		WriteClipHull ();
+		ThreadLock ();
+		i = nexthull++;
+		ThreadUnlock ();
+
+		if (i >= numhulls)
+			break;
+		BuildHull (hulls[i]);
 	}
 }
 
@@ -931,6 +1312,8 @@ CreateHulls
 */
 static void CreateHulls (void)
 {
+	int		i, reused;
+
 	if (hullnum) {
 	// commanded to create a single hull only
 		CreateSingleHull ();
@@ -940,50 +1323,52 @@ static void CreateHulls (void)
 	if (usehulls) {
 	// commanded to use the already existing hulls 1 and 2
 		CreateSingleHull ();
+		ReadClipHulls ();
 		return;
 	}
 
 	if (noclip) {
 	// commanded to ignore the hulls altogether
 		CreateSingleHull ();
+		ReadClipHulls ();
 		return;
 	}
 
 // create all the hulls
-	printf ("building hulls sequentially...\n");
-
-	hullnum = 1;
-	CreateSingleHull ();
-
-	nummodels = 0;
-	numplanes = 0;
-	numclipnodes = 0;
-	hullnum = 2;
-	CreateSingleHull ();
-
-	nummodels = 0;
-	numplanes = 0;
-	numclipnodes = 0;
-	hullnum = 3;
-	CreateSingleHull ();
-
-	nummodels = 0;
-	numplanes = 0;
-	numclipnodes = 0;
-	hullnum = 4;
-	CreateSingleHull ();
-
-	nummodels = 0;
-	numplanes = 0;
-	numclipnodes = 0;
-	hullnum = 5;
-	CreateSingleHull ();
-
-	nummodels = 0;
-	numplanes = 0;
-	numclipnodes = 0;
-	hullnum = 0;
-	CreateSingleHull ();
+	printf ("building hulls concurrently...\n");
+
+// the planes are all created while loading, in the order the hulls used
+// to be built one after another.  hull 0 takes the longest, so it is the
+// first one picked up by the threads.
+	numhulls = NUM_HULLS;
+	for (i = 0 ; i < numhulls ; i++)
+		hulls[i] = AllocHull (i);
+	for (i = 1 ; i <= numhulls ; i++)
+		LoadHullBrushes (hulls[i % numhulls]);
+
+	nexthull = 0;
+	RunThreadsOn (BuildHullsThread);
+
+	for (i = 1 ; i < numhulls ; i++)
+		MergeClipHull (hulls[i]);
+
+	reused = 0;
+	worldfilled = true;
+	for (i = 0 ; i < numhulls ; i++)
+	{
+		StoreClipHulls (hulls[i]);
+		reused += hulls[i]->reused;
+		if (!hulls[i]->filled)
+			worldfilled = false;
+	}
+	if (reused)
+		printf ("%i clipping hull models taken from the build cache\n", reused);
+
+	for (i = 0 ; i < numhulls ; i++)
+	{
+		FreeHull (hulls[i]);
+		hulls[i] = NULL;
+	}
 }
 
 /*
@@ -1015,26 +1400,6 @@ static void ProcessFile (char *sourcebase, char *bspfilename1)
 	StripExtension (pointfilename);
 	strcat (pointfilename, ".pts");
 
-	if (!onlyents)
-	{
-		Q_unlink (bspfilename);
-		if (!usehulls && hullnum == 0)
-		{
-			hullfilename[strlen(hullfilename)-1] = '1';
-			Q_unlink (hullfilename);
-			hullfilename[strlen(hullfilename)-1] = '2';
-			Q_unlink (hullfilename);
-			hullfilename[strlen(hullfilename)-1] = '3';
-			Q_unlink (hullfilename);
-			hullfilename[strlen(hullfilename)-1] = '4';
-			Q_unlink (hullfilename);
-			hullfilename[strlen(hullfilename)-1] = '5';
-			Q_unlink (hullfilename);
-		}
-		Q_unlink (portfilename);
-		Q_unlink (pointfilename);
-	}
-
 // load brushes and entities
 	LoadMapFile (sourcebase);
 	if (onlyents)
@@ -1043,34 +1408,41 @@ static void ProcessFile (char *sourcebase, char *bspfilename1)
 		return;
 	}
 
+// if the brushes didn't change, only the entities have to be updated
+	InitBuildCache ();
+	if (UpdateCachedBSP ())
+		return;
+
+	Q_unlink (bspfilename);
+	if (!usehulls && hullnum == 0)
+	{
+		hullfilename[strlen(hullfilename)-1] = '1';
+		Q_unlink (hullfilename);
+		hullfilename[strlen(hullfilename)-1] = '2';
+		Q_unlink (hullfilename);
+		hullfilename[strlen(hullfilename)-1] = '3';
+		Q_unlink (hullfilename);
+		hullfilename[strlen(hullfilename)-1] = '4';
+		Q_unlink (hullfilename);
+		hullfilename[strlen(hullfilename)-1] = '5';
+		Q_unlink (hullfilename);
+	}
+	Q_unlink (portfilename);
+	Q_unlink (pointfilename);
+
 // init the tables to be shared by all models
 	BeginBSPFile ();
 
 	for (i = 0 ; i < MAX_MAP_CLIPNODES ; i++)
 		LightValues[i] = -2;
 
-// the clipping hulls will be written out to text files by forked processes
+// build the drawing hull and add the clipping hulls to it
 	CreateHulls ();
 
-	if (usebsp2)
-	{
-		ReadClipHull2 (1);
-		ReadClipHull2 (2);
-		ReadClipHull2 (3);
-		ReadClipHull2 (4);
-		ReadClipHull2 (5);
-	}
-	else
-	{
-		ReadClipHull (1);
-		ReadClipHull (2);
-		ReadClipHull (3);
-		ReadClipHull (4);
-		ReadClipHull (5);
-	}
-
 	WriteEntitiesToString();
+	UpdateBuildCache (nofill || worldfilled);
 	FinishBSPFile ();
+	SaveBuildCache ();
 
 /*	strcpy (radfilename, bspfilename1);
 	StripExtension (radfilename);
@@ -1129,6 +1501,7 @@ main
 int main (int argc, char **argv)
 {
 	int			i;
+	int			wantthreads;
 	double		start, end;
 	char		sourcename[1024];
 	char		destname[1024];
@@ -1137,6 +1510,7 @@ int main (int argc, char **argv)
 
 	ValidateByteorder ();
 
+	wantthreads = -1;		// default to auto-detect.
 	for (i = 1 ; i < argc ; i++)
 	{
 		if (argv[i][0] != '-')
@@ -1161,6 +1535,14 @@ int main (int argc, char **argv)
 			oldhullsize = true;	// original H2 sizes for hulls #5 and #6, not H2MP ones
 		else if (!strcmp (argv[i],"-usehulls"))
 			usehulls = true;	// don't fork -- use the existing files
+		else if (!strcmp (argv[i],"-nocache"))
+			nocache = true;		// build everything, but still fill the cache
+		else if (!strcmp (argv[i],"-threads"))
+		{
+			if (i >= argc - 1)
+				COM_Error("Missing argument to \"%s\"", argv[i]);
+			wantthreads = atoi (argv[++i]);
+		}
 		else if (!strcmp (argv[i],"-hullnum"))
 		{
 			if (i >= argc - 1)
@@ -1178,7 +1560,9 @@ int main (int argc, char **argv)
 	}
 
 	if (i != argc - 2 && i != argc - 1)
-		COM_Error ("usage: qbsp [options] sourcefile [destfile]\noptions: -notjunc -nofill -draw -onlyents -verbose -oldhullsize -proj <projectpath>");
+		COM_Error ("usage: qbsp [options] sourcefile [destfile]\noptions: -notjunc -nofill -draw -onlyents -verbose -oldhullsize -nocache -threads # -proj <projectpath>");
+
+	InitThreads (wantthreads, HULL_STACKSIZE);
 
 	MakeProjectPath (argv[i]);
 
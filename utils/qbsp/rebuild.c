@@ -0,0 +1,664 @@
+/* rebuild.c -- the build cache of qbsp
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "q_stdinc.h"
+#include "compiler.h"
+#include "arch_def.h"
+#include "cmdlib.h"
+#include "q_endian.h"
+#include "util_io.h"
+#include "pathutil.h"
+#include "mathlib.h"
+#include "bspfile.h"
+#include "bsp5.h"
+#include "buildcache.h"
+
+/*
+=============================================================================
+
+BUILD CACHE
+
+The map is hashed after it is loaded: the brushes of all the bmodels and
+the options that change what is built from them.  When that is the same
+as for the bsp file that is there, only the entities and the textures are
+put in the bsp file again, like -onlyents does, and what vis and light
+added to it is kept.  That needs the outside filling to come out the same
+as well, which it does when each hull still has an entity inside and no
+entity that could be outside.
+
+Otherwise everything is built again, but the clipping hull of a model is
+taken from the cache when its expanded brushes are the same as the last
+time.  The drawing hull is always built, its faces, edges and vertexes
+go in lumps shared by all the models.
+
+=============================================================================
+*/
+
+#define	QBSP_CACHE_VERSION	"qbsp 1"
+
+static qboolean	cacheon;
+static char	mapkey[HASH_STRLEN];
+
+
+static void HashOptions (buildhash_t *hash)
+{
+	Hash_Int (hash, usebsp2);
+	Hash_Int (hash, nofill);
+	Hash_Int (hash, notjunc);
+	Hash_Int (hash, watervis);
+	Hash_Int (hash, oldhullsize);
+}
+
+/*
+==================
+InitBuildCache
+
+Loads the cache and hashes the map.  Not used for the ways of building
+that don't make all the hulls at once.
+==================
+*/
+void InitBuildCache (void)
+{
+	char		cachefilename[1024];
+	buildhash_t	hash;
+	int		i;
+	entity_t	*ent;
+	mbrush_t	*b;
+	mface_t		*f;
+
+	cacheon = !(hullnum || usehulls || noclip || onlyents);
+	if (!cacheon)
+		return;
+
+	strcpy (cachefilename, bspfilename);
+	StripExtension (cachefilename);
+	strcat (cachefilename, ".bcache");
+	Cache_Load (cachefilename);
+
+	Hash_Init (&hash);
+	Hash_String (&hash, QBSP_CACHE_VERSION);
+	HashOptions (&hash);
+
+	Hash_Int (&hash, nummiptex);
+	for (i = 0 ; i < nummiptex ; i++)
+		Hash_String (&hash, miptex[i]);
+
+	for (i = 0, ent = entities ; i < num_entities ; i++, ent++)
+	{
+		if (!ent->brushes)
+			continue;
+		Hash_Int (&hash, -1);
+		for (b = ent->brushes ; b ; b = b->next)
+		{
+			Hash_Int (&hash, -2);
+			Hash_Int (&hash, b->Light);
+			for (f = b->faces ; f ; f = f->next)
+			{
+				Hash_Float (&hash, f->plane.normal[0]);
+				Hash_Float (&hash, f->plane.normal[1]);
+				Hash_Float (&hash, f->plane.normal[2]);
+				Hash_Float (&hash, f->plane.dist);
+				Hash_Data (&hash, &texinfo[f->texinfo], sizeof(texinfo_t));
+			}
+		}
+	}
+
+	Hash_Hex (&hash, mapkey);
+}
+
+/*
+==================
+KeepOrigins
+
+The entities that were there when the outside was filled
+==================
+*/
+static void KeepOrigins (void)
+{
+	double		*origins;
+	int		i;
+
+	origins = (double *) SafeMalloc (num_entities * 3 * sizeof(double));
+	for (i = 0 ; i < num_entities ; i++)
+		VectorCopy (entities[i].origin, origins + i*3);
+	Cache_Set ("qbsp:origins", origins, num_entities * 3 * sizeof(double));
+	free (origins);
+}
+
+/*
+==================
+UpdateBuildCache
+
+Called when the bsp file is complete in memory
+==================
+*/
+void UpdateBuildCache (qboolean filled)
+{
+	buildhash_t	hash;
+	char		hex[HASH_STRLEN];
+
+	if (!cacheon)
+		return;
+
+	is_bsp2 = usebsp2;
+	Hash_Init (&hash);
+	Hash_BSPGeometry (&hash);
+	Hash_Hex (&hash, hex);
+
+	Cache_SetString ("qbsp:map", mapkey);
+	Cache_SetString ("qbsp:bsp", hex);
+	Cache_SetString ("qbsp:filled", filled ? "1" : "0");
+	KeepOrigins ();
+
+	Cache_RemoveUnused ("h");
+}
+
+/*
+==================
+SaveBuildCache
+
+Called after the bsp file is written
+==================
+*/
+void SaveBuildCache (void)
+{
+	if (cacheon)
+		Cache_Save ();
+}
+
+//===========================================================================
+
+/*
+==================
+HullContents
+
+The contents at the point in a hull of the world in the bsp file, on a
+plane counts as the back side like PointInLeaf in outside.c
+==================
+*/
+static int HullContents (int hullnumber, vec3_t point)
+{
+	int		num, planenum, child[2];
+	dplane_t	*plane;
+	double		d;
+
+	num = dmodels[0].headnode[hullnumber];
+	if (hullnumber == 0)
+	{
+		while (num >= 0 && num < numnodes)
+		{
+			if (is_bsp2)
+			{
+				planenum = dnodes2[num].planenum;
+				child[0] = dnodes2[num].children[0];
+				child[1] = dnodes2[num].children[1];
+			}
+			else
+			{
+				planenum = dnodes[num].planenum;
+				child[0] = dnodes[num].children[0];
+				child[1] = dnodes[num].children[1];
+			}
+			plane = &dplanes[planenum];
+			d = DotProduct (plane->normal, point) - plane->dist;
+			num = (d > 0) ? child[0] : child[1];
+		}
+		if (num >= 0)
+			return CONTENTS_SOLID;
+		num = -1 - num;
+		return is_bsp2 ? dleafs2[num].contents : dleafs[num].contents;
+	}
+
+	while (num >= 0 && num < numclipnodes)
+	{
+		if (is_bsp2)
+		{
+			planenum = dclipnodes2[num].planenum;
+			child[0] = dclipnodes2[num].children[0];
+			child[1] = dclipnodes2[num].children[1];
+		}
+		else
+		{
+			planenum = dclipnodes[num].planenum;
+			child[0] = dclipnodes[num].children[0];
+			child[1] = dclipnodes[num].children[1];
+		}
+		plane = &dplanes[planenum];
+		d = DotProduct (plane->normal, point) - plane->dist;
+		num = (d > 0) ? child[0] : child[1];
+	}
+	return (num >= 0) ? CONTENTS_SOLID : num;
+}
+
+/*
+==================
+FillUnchanged
+
+The filled bsp file only keeps the leafs that can't be reached from the
+outside, so an entity in one of those is still inside.  The clipping hulls
+have less empty space than the drawing hull, so an entity that is inside
+the drawing hull can't be reached from the outside of any hull.  Any other
+entity could cause a leak now, unless it was at the same place when the
+outside was filled.  Each hull still needs an entity in its empty space,
+or it wouldn't be filled at all.
+==================
+*/
+static qboolean FillUnchanged (void)
+{
+	double		*origins;
+	int		size, numorigins;
+	int		h, i, j;
+	qboolean	inside;
+
+	if (!Cache_Match ("qbsp:filled", "1"))
+		return false;
+	origins = (double *) Cache_Get ("qbsp:origins", &size);
+	if (!origins)
+		return false;
+	numorigins = size / (3 * sizeof(double));
+
+	for (i = 1 ; i < num_entities ; i++)
+	{
+		if (VectorCompare (entities[i].origin, vec3_origin))
+			continue;
+		if (HullContents (0, entities[i].origin) != CONTENTS_SOLID)
+			continue;
+		for (j = 1 ; j < numorigins ; j++)
+		{
+			if (VectorCompare (entities[i].origin, origins + j*3))
+				break;
+		}
+		if (j >= numorigins)
+			return false;
+	}
+
+	for (h = 0 ; h < NUM_HULLS ; h++)
+	{
+		inside = false;
+		for (i = 1 ; i < num_entities && !inside ; i++)
+		{
+			if (!VectorCompare (entities[i].origin, vec3_origin)
+					&& HullContents (h, entities[i].origin) != CONTENTS_SOLID)
+				inside = true;
+		}
+		if (!inside)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+==================
+ClearBSPFile
+
+Puts back the lumps that LoadBSPFile replaced, for building the bsp file
+==================
+*/
+static void ClearBSPFile (texinfo_t *maptexinfo, int nummaptexinfo)
+{
+	numplanes = numvertexes = numnodes = numfaces = numclipnodes = 0;
+	numleafs = numedges = nummarksurfaces = numsurfedges = nummodels = 0;
+	visdatasize = lightdatasize = texdatasize = entdatasize = 0;
+
+	memcpy (texinfo, maptexinfo, nummaptexinfo * sizeof(texinfo_t));
+	numtexinfo = nummaptexinfo;
+}
+
+/*
+==================
+UpdateCachedBSP
+
+Returns true if the bsp file is the one the brushes make, and only the
+entities and the textures had to be put in it
+==================
+*/
+qboolean UpdateCachedBSP (void)
+{
+	buildhash_t	hash;
+	char		hex[HASH_STRLEN];
+	texinfo_t	*maptexinfo;
+	int		nummaptexinfo;
+	byte		*oldtexdata;
+	int		oldtexdatasize;
+	char		*oldentdata;
+	int		oldentdatasize;
+	qboolean	same;
+
+	if (!cacheon || nocache)
+		return false;
+	if (!Cache_Match ("qbsp:map", mapkey))
+		return false;
+	if (Q_FileType (bspfilename) != FS_ENT_FILE)
+		return false;
+
+	nummaptexinfo = numtexinfo;
+	maptexinfo = (texinfo_t *) SafeMalloc ((numtexinfo + 1) * sizeof(texinfo_t));
+	memcpy (maptexinfo, texinfo, numtexinfo * sizeof(texinfo_t));
+
+	LoadBSPFile (bspfilename);
+	Hash_Init (&hash);
+	Hash_BSPGeometry (&hash);
+	Hash_Hex (&hash, hex);
+	if (is_bsp2 != usebsp2 || !Cache_Match ("qbsp:bsp", hex) || (!nofill && !FillUnchanged ()))
+	{
+		ClearBSPFile (maptexinfo, nummaptexinfo);
+		free (maptexinfo);
+		return false;
+	}
+	free (maptexinfo);
+
+	printf ("---- UpdateCachedBSP ----\n");
+	printf ("brushes unchanged since %s was built\n", bspfilename);
+
+// light writes the entities back in its own way, so they are compared
+// with what is in the file and not with what qbsp wrote last
+	oldentdatasize = entdatasize;
+	oldentdata = (char *) SafeMalloc (entdatasize + 1);
+	memcpy (oldentdata, dentdata, entdatasize);
+	SetModelKeys ();
+	WriteEntitiesToString ();
+	same = (entdatasize == oldentdatasize && !memcmp (dentdata, oldentdata, entdatasize));
+	free (oldentdata);
+
+	oldtexdatasize = texdatasize;
+	oldtexdata = (byte *) SafeMalloc (texdatasize + 1);
+	memcpy (oldtexdata, dtexdata, texdatasize);
+	WriteMiptex ();
+	if (texdatasize != oldtexdatasize || memcmp (dtexdata, oldtexdata, texdatasize))
+		same = false;
+	free (oldtexdata);
+
+	if (same)
+		printf ("%s is up to date\n", bspfilename);
+	else
+	{
+		printf ("Updating entities lump...\n");
+		WriteBSPFile (bspfilename, is_bsp2);
+	}
+
+	KeepOrigins ();
+	Cache_Save ();
+
+	return true;
+}
+
+//===========================================================================
+
+static int IntCompare (const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+==================
+HashBrushSet
+
+Everything about the expanded brushes of the model that building its
+clipping hull depends on.  The planes are put in the order of their plane
+numbers, which decides the order of the faces, but the numbers themselves
+change with the brushes of the other models.
+==================
+*/
+static void HashBrushSet (hullinfo_t *hull, int entnum, buildhash_t *hash)
+{
+	brushset_t	*bs;
+	brush_t		*b;
+	face_t		*f;
+	int		*planenums;
+	int		i, j, n, count;
+	plane_t		*plane;
+	int		*rank;
+
+	bs = hull->brushsets[entnum];
+
+	count = 0;
+	for (b = bs->brushes ; b ; b = b->next)
+	{
+		for (f = b->faces ; f ; f = f->next)
+			count++;
+	}
+	planenums = (int *) SafeMalloc ((count + 1) * sizeof(int));
+	count = 0;
+	for (b = bs->brushes ; b ; b = b->next)
+	{
+		for (f = b->faces ; f ; f = f->next)
+			planenums[count++] = f->planenum;
+	}
+	qsort (planenums, count, sizeof(int), IntCompare);
+	for (i = n = 0 ; i < count ; i++)
+	{
+		if (!n || planenums[n-1] != planenums[i])
+			planenums[n++] = planenums[i];
+	}
+
+	Hash_Init (hash);
+	Hash_String (hash, QBSP_CACHE_VERSION);
+	HashOptions (hash);
+	Hash_Int (hash, hull->hullnum);
+	Hash_Int (hash, entnum == 0);
+
+	for (i = 0 ; i < 3 ; i++)
+	{
+		Hash_Float (hash, bs->mins[i]);
+		Hash_Float (hash, bs->maxs[i]);
+	}
+
+	for (b = bs->brushes ; b ; b = b->next)
+	{
+		Hash_Int (hash, b->contents);
+		for (i = 0 ; i < 3 ; i++)
+		{
+			Hash_Float (hash, b->mins[i]);
+			Hash_Float (hash, b->maxs[i]);
+		}
+		for (f = b->faces ; f ; f = f->next)
+		{
+			rank = (int *) bsearch (&f->planenum, planenums, n, sizeof(int), IntCompare);
+			Hash_Int (hash, (int)(rank - planenums));
+			plane = &planes[f->planenum];
+			Hash_Float (hash, plane->normal[0]);
+			Hash_Float (hash, plane->normal[1]);
+			Hash_Float (hash, plane->normal[2]);
+			Hash_Float (hash, plane->dist);
+			Hash_Int (hash, f->planeside);
+			if (f->texturenum >= 0 && f->texturenum < numtexinfo)
+				Hash_Data (hash, &texinfo[f->texturenum], sizeof(texinfo_t));
+			else
+				Hash_Int (hash, f->texturenum);
+			Hash_Int (hash, f->numpoints);
+			for (i = 0 ; i < f->numpoints ; i++)
+			{
+				for (j = 0 ; j < 3 ; j++)
+					Hash_Float (hash, f->pts[i][j]);
+			}
+		}
+		Hash_Int (hash, -1);
+	}
+
+// the outside filling of the world depends on the entities
+	if (entnum == 0 && !nofill)
+	{
+		Hash_Int (hash, num_entities);
+		for (i = 1 ; i < num_entities ; i++)
+		{
+			for (j = 0 ; j < 3 ; j++)
+				Hash_Float (hash, entities[i].origin[j]);
+		}
+	}
+
+	free (planenums);
+}
+
+/*
+==================
+ReuseClipHull
+
+Called from the hull threads before a model is built.  If the clipping
+hull of the model is in the cache, adds it to the hull the way building
+it would have.
+
+The cached hull is the filled flag, the plane and clipnode counts, the
+planes as normal, dist and type, and the clipnodes with the plane numbers
+and children counted from the first ones of the model.
+==================
+*/
+qboolean ReuseClipHull (hullinfo_t *hull, int entnum)
+{
+	buildhash_t	hash;
+	const int	*data;
+	int		size, i, j;
+	int		numplanes1, numclipnodes1;
+	int		firstplane, c;
+	dplane_t	*p;
+	dclipnode2_t	*cn;
+	char		hex[HASH_STRLEN];
+
+	hull->cachekeys[entnum][0] = 0;
+	if (!cacheon)
+		return false;
+
+	HashBrushSet (hull, entnum, &hash);
+	Hash_Hex (&hash, hex);
+	sprintf (hull->cachekeys[entnum], "h%i:%s", hull->hullnum, hex);
+
+	if (nocache)
+		return false;
+	data = (const int *) Cache_Get (hull->cachekeys[entnum], &size);
+	if (!data || size < 3 * 4)
+		return false;
+	numplanes1 = LittleLong (data[1]);
+	numclipnodes1 = LittleLong (data[2]);
+	if (size != (3 + numplanes1*5 + numclipnodes1*3) * 4)
+		return false;
+
+	if (entnum == 0)
+		hull->filled = LittleLong (data[0]);
+	data += 3;
+
+	firstplane = hull->numplanes;
+	if (hull->numplanes + numplanes1 > MAX_MAP_PLANES)
+		COM_Error ("numplanes == MAX_MAP_PLANES");
+	for (i = 0 ; i < numplanes1 ; i++, data += 5)
+	{
+		p = &hull->dplanes[hull->numplanes++];
+		for (j = 0 ; j < 3 ; j++)
+			p->normal[j] = LittleFloat (((const float *)data)[j]);
+		p->dist = LittleFloat (((const float *)data)[3]);
+		p->type = LittleLong (data[4]);
+	}
+
+	hull->headclipnode = hull->numclipnodes;
+	if (hull->numclipnodes + numclipnodes1 > MAX_MAP_CLIPNODES)
+		COM_Error ("numclipnodes == MAX_MAP_CLIPNODES");
+	for (i = 0 ; i < numclipnodes1 ; i++, data += 3)
+	{
+		cn = &hull->clipnodes[hull->numclipnodes++];
+		cn->planenum = LittleLong (data[0]) + firstplane;
+		for (j = 0 ; j < 2 ; j++)
+		{
+			c = LittleLong (data[1 + j]);
+			if (c >= 0)
+				c += hull->headclipnode;
+			if (!usebsp2)	// what a dclipnode_t can hold
+				c = (short) c;
+			cn->children[j] = c;
+		}
+	}
+
+	BumpModel (hull);
+	hull->reused++;
+
+	return true;
+}
+
+/*
+==================
+KeepClipHull
+
+Called after the clipping hull of the model is written, makes the cached
+version of it.  It goes in the cache after all the hulls are done.
+==================
+*/
+void KeepClipHull (hullinfo_t *hull, int entnum, int firstplane)
+{
+	int		*data;
+	int		numplanes1, numclipnodes1;
+	int		i, j, c;
+	dplane_t	*p;
+	dclipnode2_t	*cn;
+
+	if (!hull->cachekeys[entnum][0])
+		return;
+	if (!usebsp2 && hull->numclipnodes > 32767)
+		return;	// the children were cut to shorts
+
+	numplanes1 = hull->numplanes - firstplane;
+	numclipnodes1 = hull->numclipnodes - hull->headclipnode;
+	hull->cachesize[entnum] = (3 + numplanes1*5 + numclipnodes1*3) * 4;
+	data = (int *) SafeMalloc (hull->cachesize[entnum]);
+	hull->cachedata[entnum] = (byte *)data;
+
+	data[0] = LittleLong (entnum == 0 && hull->filled);
+	data[1] = LittleLong (numplanes1);
+	data[2] = LittleLong (numclipnodes1);
+	data += 3;
+
+	for (i = 0 ; i < numplanes1 ; i++, data += 5)
+	{
+		p = &hull->dplanes[firstplane + i];
+		for (j = 0 ; j < 3 ; j++)
+			((float *)data)[j] = LittleFloat (p->normal[j]);
+		((float *)data)[3] = LittleFloat (p->dist);
+		data[4] = LittleLong (p->type);
+	}
+
+	for (i = 0 ; i < numclipnodes1 ; i++, data += 3)
+	{
+		cn = &hull->clipnodes[hull->headclipnode + i];
+		data[0] = LittleLong (cn->planenum - firstplane);
+		for (j = 0 ; j < 2 ; j++)
+		{
+			c = cn->children[j];
+			if (c >= 0)
+				c -= hull->headclipnode;
+			data[1 + j] = LittleLong (c);
+		}
+	}
+}
+
+/*
+==================
+StoreClipHulls
+
+Puts the clipping hulls built by a hull thread in the cache
+==================
+*/
+void StoreClipHulls (hullinfo_t *hull)
+{
+	int		entnum;
+
+	for (entnum = 0 ; entnum < num_entities ; entnum++)
+	{
+		if (!hull->cachedata[entnum])
+			continue;
+		Cache_Set (hull->cachekeys[entnum], hull->cachedata[entnum], hull->cachesize[entnum]);
+		free (hull->cachedata[entnum]);
+		hull->cachedata[entnum] = NULL;
+	}
+}
@@ -26,13 +26,6 @@
 #include "bspfile.h"
 #include "bsp5.h"
 
-static int		leaffaces;
-static int		nodefaces;
-static int		splitnodes;
-static int		c_solid, c_empty, c_water;
-
-static qboolean		usemidsplit;
-
 //============================================================================
 
 /*
@@ -279,7 +272,7 @@ Selects a surface from a linked list of surfaces to split the group on
 returns NULL if the surface list can not be divided any more (a leaf)
 ==================
 */
-static surface_t *SelectPartition (surface_t *surfaces)
+static surface_t *SelectPartition (hullinfo_t *hull, surface_t *surfaces)
 {
 	int			i, j;
 	vec3_t		mins, maxs;
@@ -323,7 +316,7 @@ static surface_t *SelectPartition (surface_t *surfaces)
 				maxs[j] = p->maxs[j];
 		}
 
-	if (usemidsplit)	// do fast way for clipping hull
+	if (hull->usemidsplit)	// do fast way for clipping hull
 		return ChooseMidPlaneFromList (surfaces, mins, maxs);
 
 // do slow way to save poly splits for drawing hull
@@ -384,7 +377,7 @@ void CalcSurfaceInfo (surface_t *surf)
 DividePlane
 ==================
 */
-void DividePlane (surface_t *in, plane_t *split, surface_t **front, surface_t **back)
+void DividePlane (hullinfo_t *hull, surface_t *in, plane_t *split, surface_t **front, surface_t **back)
 {
 	face_t		*facet, *next;
 	face_t		*frontlist, *backlist;
@@ -400,7 +393,7 @@ void DividePlane (surface_t *in, plane_t *split, surface_t **front, surface_t **
 // check for exactly on node
 		if (inplane->dist == split->dist)
 		{	// divide the facets to the front and back sides
-			news = AllocSurface ();
+			news = AllocSurface (hull);
 			*news = *in;
 
 			facet=in->faces;
@@ -455,7 +448,7 @@ void DividePlane (surface_t *in, plane_t *split, surface_t **front, surface_t **
 	for (facet = in->faces ; facet ; facet = next)
 	{
 		next = facet->next;
-		SplitFace (facet, split, &frontfrag, &backfrag);
+		SplitFace (hull, facet, split, &frontfrag, &backfrag);
 		if (frontfrag)
 		{
 			frontfrag->next = frontlist;
@@ -487,7 +480,7 @@ void DividePlane (surface_t *in, plane_t *split, surface_t **front, surface_t **
 	}
 
 // stuff got split, so allocate one new plane and reuse in
-	news = AllocSurface ();
+	news = AllocSurface (hull);
 	*news = *in;
 	news->faces = backlist;
 	*back = news;
@@ -528,7 +521,7 @@ Determines the contents of the leaf and creates the final list of
 original faces that have some fragment inside this leaf
 ==================
 */
-static void LinkConvexFaces (surface_t *planelist, node_t *leafnode)
+static void LinkConvexFaces (hullinfo_t *hull, surface_t *planelist, node_t *leafnode)
 {
 	face_t		*f, *next;
 	surface_t	*surf, *pnext;
@@ -557,16 +550,16 @@ static void LinkConvexFaces (surface_t *planelist, node_t *leafnode)
 	switch (leafnode->contents)
 	{
 	case CONTENTS_EMPTY:
-		c_empty++;
+		hull->c_empty++;
 		break;
 	case CONTENTS_SOLID:
-		c_solid++;
+		hull->c_solid++;
 		break;
 	case CONTENTS_WATER:
 	case CONTENTS_SLIME:
 	case CONTENTS_LAVA:
 	case CONTENTS_SKY:
-		c_water++;
+		hull->c_water++;
 		break;
 
 	case CONTENTS_ORIGIN:
@@ -586,7 +579,7 @@ static void LinkConvexFaces (surface_t *planelist, node_t *leafnode)
 //
 // write the list of faces, and free the originals
 //
-	leaffaces += count;
+	hull->leaffaces += count;
 	leafnode->markfaces = (face_t **) SafeMalloc(sizeof(face_t *)*(count+1));
 	i = 0;
 	for (surf = planelist ; surf ; surf = pnext)
@@ -597,9 +590,9 @@ static void LinkConvexFaces (surface_t *planelist, node_t *leafnode)
 			next = f->next;
 			leafnode->markfaces[i] = f->original;
 			i++;
-			FreeFace (f);
+			FreeFace (hull, f);
 		}
-		FreeSurface (surf);
+		FreeSurface (hull, surf);
 	}
 	leafnode->markfaces[i] = NULL;	// sentinal
 }
@@ -612,7 +605,7 @@ LinkNodeFaces
 Returns a duplicated list of all faces on surface
 ==================
 */
-static face_t *LinkNodeFaces (surface_t *surface)
+static face_t *LinkNodeFaces (hullinfo_t *hull, surface_t *surface)
 {
 	face_t	*f, *newf, **prevptr;
 	face_t	*list;
@@ -626,7 +619,7 @@ static face_t *LinkNodeFaces (surface_t *surface)
 		f = *prevptr;
 		if (!f)
 			break;
-		SubdivideFace (f, prevptr);
+		SubdivideFace (hull, f, prevptr);
 		f = *prevptr;
 		prevptr = &f->next;
 	}
@@ -634,8 +627,8 @@ static face_t *LinkNodeFaces (surface_t *surface)
 // copy
 	for (f = surface->faces ; f ; f = f->next)
 	{
-		nodefaces++;
-		newf = AllocFace ();
+		hull->nodefaces++;
+		newf = AllocFace (hull);
 		*newf = *f;
 		f->original = newf;
 		newf->next = list;
@@ -651,23 +644,23 @@ static face_t *LinkNodeFaces (surface_t *surface)
 PartitionSurfaces
 ==================
 */
-static void PartitionSurfaces (surface_t *surfaces, node_t *node)
+static void PartitionSurfaces (hullinfo_t *hull, surface_t *surfaces, node_t *node)
 {
 	surface_t	*split, *p, *next;
 	surface_t	*frontlist, *backlist;
 	surface_t	*frontfrag, *backfrag;
 	plane_t		*splitplane;
 
-	split = SelectPartition (surfaces);
+	split = SelectPartition (hull, surfaces);
 	if (!split)
 	{	// this is a leaf node
 		node->planenum = PLANENUM_LEAF;
-		LinkConvexFaces (surfaces, node);
+		LinkConvexFaces (hull, surfaces, node);
 		return;
 	}
 
-	splitnodes++;
-	node->faces = LinkNodeFaces (split);
+	hull->splitnodes++;
+	node->faces = LinkNodeFaces (hull, split);
 	node->children[0] = AllocNode ();
 	node->children[1] = AllocNode ();
 	node->planenum = split->planenum;
@@ -685,7 +678,7 @@ static void PartitionSurfaces (surface_t *surfaces, node_t *node)
 	for (p = surfaces ; p ; p = next)
 	{
 		next = p->next;
-		DividePlane (p, splitplane, &frontfrag, &backfrag);
+		DividePlane (hull, p, splitplane, &frontfrag, &backfrag);
 		if (frontfrag && backfrag)
 		{
 		// the plane was split, which may expose oportunities to merge
@@ -710,8 +703,8 @@ static void PartitionSurfaces (surface_t *surfaces, node_t *node)
 		}
 	}
 
-	PartitionSurfaces (frontlist, node->children[0]);
-	PartitionSurfaces (backlist, node->children[1]);
+	PartitionSurfaces (hull, frontlist, node->children[0]);
+	PartitionSurfaces (hull, backlist, node->children[1]);
 }
 
 #if 0	/* no users */
@@ -749,42 +742,42 @@ void DrawSurfaceList (surface_t *surf)
 SolidBSP
 ==================
 */
-node_t *SolidBSP (surface_t *surfhead, qboolean midsplit)
+node_t *SolidBSP (hullinfo_t *hull, surface_t *surfhead, qboolean midsplit)
 {
 	int		i;
 	node_t	*headnode;
 
-	qprintf ("----- SolidBSP -----\n");
+	hprintf (hull, "----- SolidBSP -----\n");
 
 	headnode = AllocNode ();
-	usemidsplit = midsplit;
+	hull->usemidsplit = midsplit;
 
 //
 // calculate a bounding box for the entire model
 //
 	for (i = 0 ; i < 3 ; i++)
 	{
-		headnode->mins[i] = brushset->mins[i] - SIDESPACE;
-		headnode->maxs[i] = brushset->maxs[i] + SIDESPACE;
+		headnode->mins[i] = hull->brushset->mins[i] - SIDESPACE;
+		headnode->maxs[i] = hull->brushset->maxs[i] + SIDESPACE;
 	}
 
 //
 // recursively partition everything
 //
 	Draw_ClearWindow ();
-	splitnodes = 0;
-	leaffaces = 0;
-	nodefaces = 0;
-	c_solid = c_empty = c_water = 0;
-
-	PartitionSurfaces (surfhead, headnode);
-
-	qprintf ("%5i split nodes\n", splitnodes);
-	qprintf ("%5i solid leafs\n", c_solid);
-	qprintf ("%5i empty leafs\n", c_empty);
-	qprintf ("%5i water leafs\n", c_water);	
-	qprintf ("%5i leaffaces\n",leaffaces);
-	qprintf ("%5i nodefaces\n", nodefaces);
+	hull->splitnodes = 0;
+	hull->leaffaces = 0;
+	hull->nodefaces = 0;
+	hull->c_solid = hull->c_empty = hull->c_water = 0;
+
+	PartitionSurfaces (hull, surfhead, headnode);
+
+	hprintf (hull, "%5i split nodes\n", hull->splitnodes);
+	hprintf (hull, "%5i solid leafs\n", hull->c_solid);
+	hprintf (hull, "%5i empty leafs\n", hull->c_empty);
+	hprintf (hull, "%5i water leafs\n", hull->c_water);	
+	hprintf (hull, "%5i leaffaces\n", hull->leaffaces);
+	hprintf (hull, "%5i nodefaces\n", hull->nodefaces);
 
 	return headnode;
 }
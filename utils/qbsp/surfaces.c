@@ -121,14 +121,15 @@ void SubdivideFace (face_t *f, face_t **prevptr)
 SubdivideFace
 
 If the face is >256 in either texture direction, carve a valid sized
-piece off and insert the remainder in the next link
+piece off and insert the remainder in the next link.
+Returns the number of splits made.
 ===============
 */
-void SubdivideFace (face_t *f, face_t **prevptr)
+int SubdivideFace (hullinfo_t *hull, face_t *f, face_t **prevptr)
 {
 	float		mins, maxs;
 	double		v;
-	int			axis, i;
+	int			axis, i, splits;
 	plane_t		plane;
 	face_t		*front, *back, *next;
 	texinfo_t	*tex;
@@ -137,8 +138,9 @@ void SubdivideFace (face_t *f, face_t **prevptr)
 	tex = &texinfo[f->texturenum];
 
 	if ( tex->flags & TEX_SPECIAL)
-		return;
+		return 0;
 
+	splits = 0;
 	for (axis = 0 ; axis < 2 ; axis++)
 	{
 		while (1)
@@ -159,14 +161,14 @@ void SubdivideFace (face_t *f, face_t **prevptr)
 				break;
 
 		// split it
-			subdivides++;
+			splits++;
 
 			VectorCopy (tex->vecs[axis], plane.normal);
 			v = VectorLength (plane.normal);
 			VectorNormalize (plane.normal);
 			plane.dist = (mins + 224)/v;
 			next = f->next;
-			SplitFace (f, &plane, &front, &back);
+			SplitFace (hull, f, &plane, &front, &back);
 			if (!front || !back)
 				COM_Error ("%s: didn't split the polygon", __thisfunc__);
 			*prevptr = back;
@@ -175,6 +177,8 @@ void SubdivideFace (face_t *f, face_t **prevptr)
 			f = back;
 		}
 	}
+
+	return splits;
 }
 #endif
 
@@ -185,7 +189,7 @@ SubdivideFaces
 ================
 */
 // actually, this has no users.
-void SubdivideFaces (surface_t *surfhead)
+void SubdivideFaces (hullinfo_t *hull, surface_t *surfhead)
 {
 	surface_t	*surf;
 	face_t		*f , **prevptr;
@@ -202,7 +206,7 @@ void SubdivideFaces (surface_t *surfhead)
 			f = *prevptr;
 			if (!f)
 				break;
-			SubdivideFace (f, prevptr);
+			subdivides += SubdivideFace (hull, f, prevptr);
 			f = *prevptr;
 			prevptr = &f->next;
 		}
@@ -221,7 +225,7 @@ Frees the current node tree and returns a new chain of the surfaces that
 have inside faces.
 =============================================================================
 */
-static void GatherNodeFaces_r (node_t *node)
+static void GatherNodeFaces_r (hullinfo_t *hull, node_t *node)
 {
 	face_t	*f, *next;
 
@@ -235,17 +239,17 @@ static void GatherNodeFaces_r (node_t *node)
 			next = f->next;
 			if (!f->numpoints)
 			{	// face was removed outside
-				FreeFace (f);
+				FreeFace (hull, f);
 			}
 			else
 			{
-				f->next = validfaces[f->planenum];
-				validfaces[f->planenum] = f;
+				f->next = hull->validfaces[f->planenum];
+				hull->validfaces[f->planenum] = f;
 			}
 		}
 
-		GatherNodeFaces_r (node->children[0]);
-		GatherNodeFaces_r (node->children[1]);
+		GatherNodeFaces_r (hull, node->children[0]);
+		GatherNodeFaces_r (hull, node->children[1]);
 
 		free (node);
 	}
@@ -264,11 +268,11 @@ GatherNodeFaces
 
 ================
 */
-surface_t *GatherNodeFaces (node_t *headnode)
+surface_t *GatherNodeFaces (hullinfo_t *hull, node_t *headnode)
 {
-	memset (validfaces, 0, sizeof(validfaces));
-	GatherNodeFaces_r (headnode);
-	return BuildSurfaces ();
+	memset (hull->validfaces, 0, sizeof(hull->validfaces));
+	GatherNodeFaces_r (hull, headnode);
+	return BuildSurfaces (hull);
 }
 
 //===========================================================================
@@ -283,9 +283,9 @@ static byte	superfacebuf[8192];
 static face_t	*superface = (face_t *)superfacebuf;
 static face_t	*newlist;
 
-static void FixFaceEdges (face_t *f);
+static void FixFaceEdges (hullinfo_t *hull, face_t *f);
 
-static void SplitFaceForTjunc (face_t *f, face_t *original)
+static void SplitFaceForTjunc (hullinfo_t *hull, face_t *f, face_t *original)
 {
 	int			i;
 	face_t		*newf, *chain;
@@ -352,7 +352,7 @@ restart:
 	// cut off as big a piece as possible, less than MAXPOINTS, and not
 	// past lastcorner
 
-		newf = NewFaceFromFace (f);
+		newf = NewFaceFromFace (hull, f);
 		if (f->original)
 			COM_Error ("%s: f->original", __thisfunc__);
 
@@ -387,7 +387,7 @@ FixFaceEdges
 
 ===============
 */
-static void FixFaceEdges (face_t *f)
+static void FixFaceEdges (hullinfo_t *hull, face_t *f)
 {
 	int		i, j, k;
 	wedge_t	*w;
@@ -431,7 +431,7 @@ restart:
 
 // the face needs to be split into multiple faces because of too many edges
 
-	SplitFaceForTjunc (superface, f);
+	SplitFaceForTjunc (hull, superface, f);
 }
 
 
@@ -451,7 +451,7 @@ static void tjunc_find_r (node_t *node)
 	tjunc_find_r (node->children[1]);
 }
 
-static void tjunc_fix_r (node_t *node)
+static void tjunc_fix_r (hullinfo_t *hull, node_t *node)
 {
 	face_t	*f, *next;
 
@@ -463,13 +463,13 @@ static void tjunc_fix_r (node_t *node)
 	for (f = node->faces ; f ; f = next)
 	{
 		next = f->next;
-		FixFaceEdges (f);
+		FixFaceEdges (hull, f);
 	}
 
 	node->faces = newlist;
 
-	tjunc_fix_r (node->children[0]);
-	tjunc_fix_r (node->children[1]);
+	tjunc_fix_r (hull, node->children[0]);
+	tjunc_fix_r (hull, node->children[1]);
 }
 
 /*
@@ -478,7 +478,7 @@ tjunc
 
 ===========
 */
-void tjunc (node_t *headnode)
+void tjunc (hullinfo_t *hull, node_t *headnode)
 {
 	vec3_t	maxs, mins;
 	int		i;
@@ -495,10 +495,10 @@ void tjunc (node_t *headnode)
 // origin points won't always be inside the map, so extend the hash area
 	for (i = 0 ; i < 3 ; i++)
 	{
-		if ( fabs(brushset->maxs[i]) > fabs(brushset->mins[i]) )
-			maxs[i] = fabs(brushset->maxs[i]);
+		if ( fabs(hull->brushset->maxs[i]) > fabs(hull->brushset->mins[i]) )
+			maxs[i] = fabs(hull->brushset->maxs[i]);
 		else
-			maxs[i] = fabs(brushset->mins[i]);
+			maxs[i] = fabs(hull->brushset->mins[i]);
 	}
 	VectorNegate (maxs, mins);
 
@@ -515,7 +515,7 @@ void tjunc (node_t *headnode)
 //
 	tjuncs = tjuncfaces = 0;
 
-	tjunc_fix_r (headnode);
+	tjunc_fix_r (hull, headnode);
 
 	qprintf ("%i edges added by tjunctions\n", tjuncs);
 	qprintf ("%i faces added by tjunctions\n", tjuncfaces);
@@ -30,7 +30,6 @@
 #include "bsp5.h"
 
 
-static int		headclipnode;
 static int		firstface;
 int		LightValues[MAX_MAP_CLIPNODES];
 
@@ -76,36 +75,34 @@ int FindFinalPlane (dplane_t *p)
 }
 
 
-static int		planemapping[MAX_MAP_PLANES];
-
-static void WriteNodePlanes_r (node_t *node)
+static void WriteNodePlanes_r (hullinfo_t *hull, node_t *node)
 {
 	plane_t		*plane;
 	dplane_t	*dplane;
 
 	if (node->planenum == -1)
 		return;
-	if (planemapping[node->planenum] == -1)
+	if (hull->planemapping[node->planenum] == -1)
 	{	// a new plane
-		planemapping[node->planenum] = numplanes;
+		hull->planemapping[node->planenum] = hull->numplanes;
 
-		if (numplanes == MAX_MAP_PLANES)
+		if (hull->numplanes == MAX_MAP_PLANES)
 			COM_Error ("numplanes == MAX_MAP_PLANES");
 		plane = &planes[node->planenum];
-		dplane = &dplanes[numplanes];
+		dplane = &hull->dplanes[hull->numplanes];
 		dplane->normal[0] = plane->normal[0];
 		dplane->normal[1] = plane->normal[1];
 		dplane->normal[2] = plane->normal[2];
 		dplane->dist = plane->dist;
 		dplane->type = plane->type;
 
-		numplanes++;
+		hull->numplanes++;
 	}
 
-	node->outputplanenum = planemapping[node->planenum];
+	node->outputplanenum = hull->planemapping[node->planenum];
 
-	WriteNodePlanes_r (node->children[0]);
-	WriteNodePlanes_r (node->children[1]);
+	WriteNodePlanes_r (hull, node->children[0]);
+	WriteNodePlanes_r (hull, node->children[1]);
 }
 
 /*
@@ -114,10 +111,10 @@ WriteNodePlanes
 
 ==================
 */
-void WriteNodePlanes (node_t *nodes)
+void WriteNodePlanes (hullinfo_t *hull, node_t *nodes)
 {
-	memset (planemapping,-1, sizeof(planemapping));
-	WriteNodePlanes_r (nodes);
+	memset (hull->planemapping, -1, sizeof(hull->planemapping));
+	WriteNodePlanes_r (hull, nodes);
 }
 
 //===========================================================================
@@ -128,10 +125,10 @@ WriteClipNodes_r
 
 ==================
 */
-static int WriteClipNodes_r (node_t *node)
+static int WriteClipNodes_r (hullinfo_t *hull, node_t *node)
 {
 	int			i, c;
-	dclipnode_t	*cn;
+	dclipnode2_t	*cn;
 	int			num;
 
 // FIXME: free more stuff?
@@ -143,39 +140,19 @@ static int WriteClipNodes_r (node_t *node)
 	}
 
 // emit a clipnode
-	c = numclipnodes;
-	cn = &dclipnodes[numclipnodes];
-	numclipnodes++;
+	if (hull->numclipnodes == MAX_MAP_CLIPNODES)
+		COM_Error ("numclipnodes == MAX_MAP_CLIPNODES");
+	c = hull->numclipnodes;
+	cn = &hull->clipnodes[hull->numclipnodes];
+	hull->numclipnodes++;
 	cn->planenum = node->outputplanenum;
 	for (i = 0 ; i < 2 ; i++)
-		cn->children[i] = WriteClipNodes_r(node->children[i]);
-
-	free (node);
-	return c;
-}
-
-static int WriteClipNodes_r2 (node_t *node)
-{
-	int			i, c;
-	dclipnode2_t	*cn;
-	int			num;
-
-// FIXME: free more stuff?
-	if (node->planenum == -1)
 	{
-		num = node->contents;
-		free (node);
-		return num;
+		cn->children[i] = WriteClipNodes_r(hull, node->children[i]);
+		if (!usebsp2)	// what a dclipnode_t can hold
+			cn->children[i] = (short) cn->children[i];
 	}
 
-// emit a clipnode
-	c = numclipnodes;
-	cn = &dclipnodes2[numclipnodes];
-	numclipnodes++;
-	cn->planenum = node->outputplanenum;
-	for (i = 0 ; i < 2 ; i++)
-		cn->children[i] = WriteClipNodes_r2(node->children[i]);
-
 	free (node);
 	return c;
 }
@@ -185,16 +162,13 @@ static int WriteClipNodes_r2 (node_t *node)
 WriteClipNodes
 
 Called after the clipping hull is completed.  Generates a disk format
-representation and frees the original memory.
+representation in the hull and frees the original memory.
 ==================
 */
-void WriteClipNodes (node_t *nodes)
+void WriteClipNodes (hullinfo_t *hull, node_t *nodes)
 {
-	headclipnode = numclipnodes;
-	if (usebsp2)
-		WriteClipNodes_r2 (nodes);
-	else
-		WriteClipNodes_r (nodes);
+	hull->headclipnode = hull->numclipnodes;
+	WriteClipNodes_r (hull, nodes);
 }
 
 //===========================================================================
@@ -434,20 +408,16 @@ void WriteDrawNodes (node_t *headnode)
 ==================
 BumpModel
 
-Used by the clipping hull processes that only need to store headclipnode
+Used by the clipping hulls that only need to store headclipnode
 ==================
 */
-void BumpModel (int hullnumber)
+void BumpModel (hullinfo_t *hull)
 {
-	dmodel_t	*bm;
-
 // emit a model
-	if (nummodels == MAX_MAP_MODELS)
+	if (hull->nummodels == MAX_MAP_MODELS)
 		COM_Error ("nummodels == MAX_MAP_MODELS");
-	bm = &dmodels[nummodels];
-	nummodels++;
-
-	bm->headnode[hullnumber] = headclipnode;
+	hull->headnodes[hull->nummodels] = hull->headclipnode;
+	hull->nummodels++;
 }
 
 //=============================================================================
@@ -685,7 +655,7 @@ static void AddAnimatingTextures (void)
 WriteMiptex
 ==================
 */
-static void WriteMiptex (void)
+void WriteMiptex (void)
 {
 	int		i, len;
 	byte	*data;
@@ -54,10 +54,12 @@ OBJ_COMMON= qsnprint.obj &
 	util_io.obj &
 	pathutil.obj &
 	mathlib.obj &
-	bspfile.obj
+	bspfile.obj &
+	buildcache.obj
 
 OBJ_VIS= threads.obj &
 	flow.obj &
+	flowsimd.obj &
 	soundpvs.obj &
 	vis.obj
 
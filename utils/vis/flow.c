@@ -145,6 +145,7 @@ Generates seperating planes canidates by taking two points from source and one
 point from pass, and clips target by them.
 
 If target is totally clipped away, that portal can not be seen through.
+The planes are made and tested by the kernels of flowsimd.c.
 
 Normal clip keeps target on the same side as pass, which is correct if the
 order goes source, pass, target.  If the order goes pass, source, target then
@@ -153,14 +154,6 @@ flipclip should be set.
 */
 static winding_t *ClipToSeperators (winding_t *source, winding_t *pass, winding_t *target, qboolean flipclip)
 {
-	int		i, j, k, l;
-	plane_t		plane;
-	vec3_t		v1, v2;
-	float		d;
-	double		length;
-	int		counts[3];
-	qboolean	fliptest;
-
 // check all combinations
 	if (GilMode)
 	{
@@ -185,119 +178,7 @@ static winding_t *ClipToSeperators (winding_t *source, winding_t *pass, winding_
 	}
 	Stats[0]++;
 
-	for (i = 0 ; i < source->numpoints ; i++)
-	{
-		l = (i + 1) % source->numpoints;
-		VectorSubtract (source->points[l] , source->points[i], v1);
-
-	// fing a vertex of pass that makes a plane that puts all of the
-	// vertexes of pass on the front side and all of the vertexes of
-	// source on the back side
-		for (j = 0 ; j < pass->numpoints ; j++)
-		{
-			VectorSubtract (pass->points[j], source->points[i], v2);
-
-			plane.normal[0] = v1[1]*v2[2] - v1[2]*v2[1];
-			plane.normal[1] = v1[2]*v2[0] - v1[0]*v2[2];
-			plane.normal[2] = v1[0]*v2[1] - v1[1]*v2[0];
-
-		// if points don't make a valid plane, skip it
-
-			length = plane.normal[0] * plane.normal[0]
-					+ plane.normal[1] * plane.normal[1]
-					+ plane.normal[2] * plane.normal[2];
-
-			if (length < ON_EPSILON)
-				continue;
-
-			length = 1 / sqrt(length);
-
-			plane.normal[0] *= length;
-			plane.normal[1] *= length;
-			plane.normal[2] *= length;
-
-			plane.dist = (float)DotProduct (pass->points[j], plane.normal);
-
-		//
-		// find out which side of the generated seperating plane has the
-		// source portal
-		//
-			fliptest = false;
-			for (k = 0 ; k < source->numpoints ; k++)
-			{
-				if (k == i || k == l)
-					continue;
-				d = (float)DotProduct (source->points[k], plane.normal) - plane.dist;
-				if (d < -ON_EPSILON)
-				{	// source is on the negative side, so we want all
-					// pass and target on the positive side
-					fliptest = false;
-					break;
-				}
-				else if (d > ON_EPSILON)
-				{	// source is on the positive side, so we want all
-					// pass and target on the negative side
-					fliptest = true;
-					break;
-				}
-			}
-			if (k == source->numpoints)
-				continue;	// planar with source portal
-
-		//
-		// flip the normal if the source portal is backwards
-		//
-			if (fliptest)
-			{
-				VectorNegate (plane.normal, plane.normal);
-				plane.dist = -plane.dist;
-			}
-
-		//
-		// if all of the pass portal points are now on the positive side,
-		// this is the seperating plane
-		//
-			counts[0] = counts[1] = counts[2] = 0;
-			for (k = 0 ; k < pass->numpoints ; k++)
-			{
-				if (k == j)
-					continue;
-				d = (float)DotProduct (pass->points[k], plane.normal) - plane.dist;
-				if (d < -ON_EPSILON)
-					break;
-				else if (d > ON_EPSILON)
-					counts[0]++;
-				else
-					counts[2]++;
-			}
-			if (k != pass->numpoints)
-				continue;	// points on negative side, not a seperating plane
-
-			if (!counts[0])
-			{
-				continue;	// planar with seperating plane
-			}
-
-		//
-		// flip the normal if we want the back side
-		//
-			if (flipclip)
-			{
-				VectorNegate (plane.normal, plane.normal);
-				plane.dist = -plane.dist;
-			}
-
-		//
-		// clip target by the seperating plane
-		//
-			target = ClipWinding (target, &plane, false);
-			if (!target)
-			{
-				return NULL;	// target is not visible
-			}
-		}
-	}
-	return target;
+	return flowk->clipseperators (source, pass, target, flipclip);
 }
 
 
@@ -0,0 +1,592 @@
+/* flowsimd.c -- seperating plane kernels of flow.c
+ *
+ * ClipToSeperators makes a candidate plane from every edge of the source
+ * and every point of the pass portal, tests source and pass against it
+ * and clips the target with the ones that seperate them.  The plain C
+ * version is the old loop of flow.c.  The SSE2 and AVX versions make the
+ * planes of two or four pass points at once, from the pass points in
+ * columns, and test them against the source and pass points together.
+ * They use the same double and float operations in the same order, so
+ * the planes are the same to the bit, and the target is clipped by them
+ * in the same order with the same ClipWinding.  They are picked at run
+ * time from the cpu features, vis -kernelcheck compares the results.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "q_stdinc.h"
+#include "compiler.h"
+#include "arch_def.h"
+#include "cmdlib.h"
+#include "mathlib.h"
+#include "bspfile.h"
+#include "vis.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define	FLOW_X86	1
+#include <immintrin.h>
+#else
+#define	FLOW_X86	0
+#endif
+
+const flowkernels_t	*flowk;
+
+
+/*
+==============================================================================
+
+C VERSION
+
+==============================================================================
+*/
+
+static winding_t *ClipToSeperators_C (winding_t *source, winding_t *pass, winding_t *target, qboolean flipclip)
+{
+	int		i, j, k, l;
+	plane_t		plane;
+	vec3_t		v1, v2;
+	float		d;
+	double		length;
+	int		counts[3];
+	qboolean	fliptest;
+
+	for (i = 0 ; i < source->numpoints ; i++)
+	{
+		l = (i + 1) % source->numpoints;
+		VectorSubtract (source->points[l] , source->points[i], v1);
+
+	// fing a vertex of pass that makes a plane that puts all of the
+	// vertexes of pass on the front side and all of the vertexes of
+	// source on the back side
+		for (j = 0 ; j < pass->numpoints ; j++)
+		{
+			VectorSubtract (pass->points[j], source->points[i], v2);
+
+			plane.normal[0] = v1[1]*v2[2] - v1[2]*v2[1];
+			plane.normal[1] = v1[2]*v2[0] - v1[0]*v2[2];
+			plane.normal[2] = v1[0]*v2[1] - v1[1]*v2[0];
+
+		// if points don't make a valid plane, skip it
+
+			length = plane.normal[0] * plane.normal[0]
+					+ plane.normal[1] * plane.normal[1]
+					+ plane.normal[2] * plane.normal[2];
+
+			if (length < ON_EPSILON)
+				continue;
+
+			length = 1 / sqrt(length);
+
+			plane.normal[0] *= length;
+			plane.normal[1] *= length;
+			plane.normal[2] *= length;
+
+			plane.dist = (float)DotProduct (pass->points[j], plane.normal);
+
+		//
+		// find out which side of the generated seperating plane has the
+		// source portal
+		//
+			fliptest = false;
+			for (k = 0 ; k < source->numpoints ; k++)
+			{
+				if (k == i || k == l)
+					continue;
+				d = (float)DotProduct (source->points[k], plane.normal) - plane.dist;
+				if (d < -ON_EPSILON)
+				{	// source is on the negative side, so we want all
+					// pass and target on the positive side
+					fliptest = false;
+					break;
+				}
+				else if (d > ON_EPSILON)
+				{	// source is on the positive side, so we want all
+					// pass and target on the negative side
+					fliptest = true;
+					break;
+				}
+			}
+			if (k == source->numpoints)
+				continue;	// planar with source portal
+
+		//
+		// flip the normal if the source portal is backwards
+		//
+			if (fliptest)
+			{
+				VectorNegate (plane.normal, plane.normal);
+				plane.dist = -plane.dist;
+			}
+
+		//
+		// if all of the pass portal points are now on the positive side,
+		// this is the seperating plane
+		//
+			counts[0] = counts[1] = counts[2] = 0;
+			for (k = 0 ; k < pass->numpoints ; k++)
+			{
+				if (k == j)
+					continue;
+				d = (float)DotProduct (pass->points[k], plane.normal) - plane.dist;
+				if (d < -ON_EPSILON)
+					break;
+				else if (d > ON_EPSILON)
+					counts[0]++;
+				else
+					counts[2]++;
+			}
+			if (k != pass->numpoints)
+				continue;	// points on negative side, not a seperating plane
+
+			if (!counts[0])
+			{
+				continue;	// planar with seperating plane
+			}
+
+		//
+		// flip the normal if we want the back side
+		//
+			if (flipclip)
+			{
+				VectorNegate (plane.normal, plane.normal);
+				plane.dist = -plane.dist;
+			}
+
+		//
+		// clip target by the seperating plane
+		//
+			target = ClipWinding (target, &plane, false);
+			if (!target)
+			{
+				return NULL;	// target is not visible
+			}
+		}
+	}
+	return target;
+}
+
+
+#if FLOW_X86
+/*
+==============================================================================
+
+SSE2 AND AVX VERSIONS
+
+The planes of a group of pass points are made in the lanes of a vector.
+A flipped plane is never negated: negating the normal and the distance
+only negates the distances of the points to it, exactly, so the sides
+just swap.  Which planes seperate, and which way round, is kept in lane
+bit masks.  The target is clipped by the seperating planes of each group
+in the order of the C version: the planes do not depend on the target.
+
+==============================================================================
+*/
+
+/* -ffast-math lets the compiler regroup products and sums as it likes,
+   and it does so differently for the vector code: this hands it a value
+   it cannot look into, so that the grouping stays the one of the C code */
+#define	FLOW_KEEP(v)	__asm__ ("" : "+x" (v))
+
+#define	MAX_PASSLANES	(MAX_POINTS_ON_WINDING + 4)
+
+/* the pass points in columns, padded to a whole vector with the last
+   point, and the seperating planes found for them */
+typedef struct
+{
+	double		x[MAX_PASSLANES], y[MAX_PASSLANES], z[MAX_PASSLANES];
+	double		nx[MAX_PASSLANES], ny[MAX_PASSLANES], nz[MAX_PASSLANES];
+	float		dist[MAX_PASSLANES];
+	int		flip[MAX_PASSLANES];	// the plane must be negated
+} passplanes_t;
+
+static void LoadPassPoints (passplanes_t *pp, winding_t *pass, int lanes)
+{
+	int		j, k, n;
+
+	n = (pass->numpoints + lanes - 1) & ~(lanes - 1);
+	for (j = 0 ; j < n ; j++)
+	{
+		k = (j < pass->numpoints) ? j : pass->numpoints - 1;
+		pp->x[j] = pass->points[k][0];
+		pp->y[j] = pass->points[k][1];
+		pp->z[j] = pass->points[k][2];
+	}
+}
+
+/* clips the target by the seperating planes of pass points j, j+1, ...
+   that are set in seperators */
+static winding_t *ClipByPassPlanes (passplanes_t *pp, int j, int seperators, winding_t *target, qboolean flipclip)
+{
+	plane_t		plane;
+
+	for ( ; seperators ; j++, seperators >>= 1)
+	{
+		if (!(seperators & 1))
+			continue;
+		if (pp->flip[j] ^ flipclip)
+		{
+			plane.normal[0] = -pp->nx[j];
+			plane.normal[1] = -pp->ny[j];
+			plane.normal[2] = -pp->nz[j];
+			plane.dist = -pp->dist[j];
+		}
+		else
+		{
+			plane.normal[0] = pp->nx[j];
+			plane.normal[1] = pp->ny[j];
+			plane.normal[2] = pp->nz[j];
+			plane.dist = pp->dist[j];
+		}
+		target = ClipWinding (target, &plane, false);
+		if (!target)
+			return NULL;
+	}
+	return target;
+}
+
+/*
+==============
+SSE2
+==============
+*/
+
+/* (float)DotProduct(p, n) - dist, as the C version does it */
+__attribute__((__target__("sse2")))
+static inline __m128d PlaneDist_SSE2 (double x, double y, double z, __m128d nx, __m128d ny, __m128d nz, __m128 dist)
+{
+	__m128d		xy;
+
+	xy = _mm_add_pd (_mm_mul_pd (_mm_set1_pd (x), nx), _mm_mul_pd (_mm_set1_pd (y), ny));
+	FLOW_KEEP (xy);
+	xy = _mm_add_pd (xy, _mm_mul_pd (_mm_set1_pd (z), nz));
+	return _mm_cvtps_pd (_mm_sub_ps (_mm_cvtpd_ps (xy), dist));
+}
+
+/* finds the seperating planes for pass points j and j+1 and returns them
+   as lane bits */
+__attribute__((__target__("sse2")))
+static int PassPlanes_SSE2 (passplanes_t *pp, int j, winding_t *source, winding_t *pass, int i, int l)
+{
+	__m128d		v1x, v1y, v1z, v2x, v2y, v2z;
+	__m128d		nx, ny, nz, t, len, d, eps, negeps;
+	__m128		dist;
+	int		k, lanes, decided, flip, neg, pos, self;
+	int		anyneg, anypos, valid;
+	double		*s;
+
+	lanes = (1 << 2) - 1;
+	if (pass->numpoints - j < 2)
+		lanes = (1 << (pass->numpoints - j)) - 1;
+	eps = _mm_set1_pd (ON_EPSILON);
+	negeps = _mm_set1_pd (-ON_EPSILON);
+
+	s = source->points[i];
+	v1x = _mm_set1_pd (source->points[l][0] - s[0]);
+	v1y = _mm_set1_pd (source->points[l][1] - s[1]);
+	v1z = _mm_set1_pd (source->points[l][2] - s[2]);
+	v2x = _mm_sub_pd (_mm_loadu_pd (&pp->x[j]), _mm_set1_pd (s[0]));
+	v2y = _mm_sub_pd (_mm_loadu_pd (&pp->y[j]), _mm_set1_pd (s[1]));
+	v2z = _mm_sub_pd (_mm_loadu_pd (&pp->z[j]), _mm_set1_pd (s[2]));
+
+	nx = _mm_sub_pd (_mm_mul_pd (v1y, v2z), _mm_mul_pd (v1z, v2y));
+	ny = _mm_sub_pd (_mm_mul_pd (v1z, v2x), _mm_mul_pd (v1x, v2z));
+	nz = _mm_sub_pd (_mm_mul_pd (v1x, v2y), _mm_mul_pd (v1y, v2x));
+
+// if points don't make a valid plane, skip it
+	t = _mm_add_pd (_mm_mul_pd (nx, nx), _mm_mul_pd (ny, ny));
+	FLOW_KEEP (t);
+	len = _mm_add_pd (t, _mm_mul_pd (nz, nz));
+	valid = _mm_movemask_pd (_mm_cmpge_pd (len, eps)) & lanes;
+	if (!valid)
+		return 0;
+
+	t = _mm_div_pd (_mm_set1_pd (1.0), _mm_sqrt_pd (len));
+	nx = _mm_mul_pd (nx, t);
+	ny = _mm_mul_pd (ny, t);
+	nz = _mm_mul_pd (nz, t);
+
+	t = _mm_add_pd (_mm_mul_pd (_mm_loadu_pd (&pp->x[j]), nx), _mm_mul_pd (_mm_loadu_pd (&pp->y[j]), ny));
+	FLOW_KEEP (t);
+	t = _mm_add_pd (t, _mm_mul_pd (_mm_loadu_pd (&pp->z[j]), nz));
+	dist = _mm_cvtpd_ps (t);
+
+// find out which side of each plane has the source portal
+	decided = flip = 0;
+	for (k = 0 ; k < source->numpoints && decided != valid ; k++)
+	{
+		if (k == i || k == l)
+			continue;
+		d = PlaneDist_SSE2 (source->points[k][0], source->points[k][1], source->points[k][2], nx, ny, nz, dist);
+		neg = _mm_movemask_pd (_mm_cmplt_pd (d, negeps)) & valid & ~decided;
+		pos = _mm_movemask_pd (_mm_cmpgt_pd (d, eps)) & valid & ~decided;
+		flip |= pos;
+		decided |= neg | pos;
+	}
+	if (!decided)
+		return 0;	// planar with source portal
+
+// all of the pass portal points must be on the positive side
+	anyneg = anypos = 0;
+	for (k = 0 ; k < pass->numpoints ; k++)
+	{
+		d = PlaneDist_SSE2 (pass->points[k][0], pass->points[k][1], pass->points[k][2], nx, ny, nz, dist);
+		neg = _mm_movemask_pd (_mm_cmplt_pd (d, negeps));
+		pos = _mm_movemask_pd (_mm_cmpgt_pd (d, eps));
+		self = (k >= j && k < j + 2) ? 1 << (k - j) : 0;
+		anyneg |= ((neg & ~flip) | (pos & flip)) & ~self;
+		anypos |= ((pos & ~flip) | (neg & flip)) & ~self;
+		if (!(decided & ~anyneg))
+			return 0;	// points on negative side of them all
+	}
+
+	_mm_storeu_pd (&pp->nx[j], nx);
+	_mm_storeu_pd (&pp->ny[j], ny);
+	_mm_storeu_pd (&pp->nz[j], nz);
+	_mm_storel_pi ((__m64 *)&pp->dist[j], dist);
+	pp->flip[j] = flip & 1;
+	pp->flip[j+1] = (flip >> 1) & 1;
+
+	return decided & ~anyneg & anypos;
+}
+
+__attribute__((__target__("sse2")))
+static winding_t *ClipToSeperators_SSE2 (winding_t *source, winding_t *pass, winding_t *target, qboolean flipclip)
+{
+	passplanes_t	pp;
+	int		i, j, l, seperators;
+
+	LoadPassPoints (&pp, pass, 2);
+
+	for (i = 0 ; i < source->numpoints ; i++)
+	{
+		l = (i + 1) % source->numpoints;
+
+		for (j = 0 ; j < pass->numpoints ; j += 2)
+		{
+			seperators = PassPlanes_SSE2 (&pp, j, source, pass, i, l);
+			if (!seperators)
+				continue;
+			target = ClipByPassPlanes (&pp, j, seperators, target, flipclip);
+			if (!target)
+				return NULL;	// target is not visible
+		}
+	}
+	return target;
+}
+
+/*
+==============
+AVX
+==============
+*/
+
+__attribute__((__target__("avx")))
+static inline __m256d PlaneDist_AVX (double x, double y, double z, __m256d nx, __m256d ny, __m256d nz, __m128 dist)
+{
+	__m256d		xy;
+
+	xy = _mm256_add_pd (_mm256_mul_pd (_mm256_set1_pd (x), nx), _mm256_mul_pd (_mm256_set1_pd (y), ny));
+	FLOW_KEEP (xy);
+	xy = _mm256_add_pd (xy, _mm256_mul_pd (_mm256_set1_pd (z), nz));
+	return _mm256_cvtps_pd (_mm_sub_ps (_mm256_cvtpd_ps (xy), dist));
+}
+
+/* finds the seperating planes for pass points j to j+3 and returns them
+   as lane bits */
+__attribute__((__target__("avx")))
+static int PassPlanes_AVX (passplanes_t *pp, int j, winding_t *source, winding_t *pass, int i, int l)
+{
+	__m256d		v1x, v1y, v1z, v2x, v2y, v2z;
+	__m256d		nx, ny, nz, t, len, d, eps, negeps;
+	__m128		dist;
+	int		k, lanes, decided, flip, neg, pos, self;
+	int		anyneg, anypos, valid;
+	double		*s;
+
+	lanes = (1 << 4) - 1;
+	if (pass->numpoints - j < 4)
+		lanes = (1 << (pass->numpoints - j)) - 1;
+	eps = _mm256_set1_pd (ON_EPSILON);
+	negeps = _mm256_set1_pd (-ON_EPSILON);
+
+	s = source->points[i];
+	v1x = _mm256_set1_pd (source->points[l][0] - s[0]);
+	v1y = _mm256_set1_pd (source->points[l][1] - s[1]);
+	v1z = _mm256_set1_pd (source->points[l][2] - s[2]);
+	v2x = _mm256_sub_pd (_mm256_loadu_pd (&pp->x[j]), _mm256_set1_pd (s[0]));
+	v2y = _mm256_sub_pd (_mm256_loadu_pd (&pp->y[j]), _mm256_set1_pd (s[1]));
+	v2z = _mm256_sub_pd (_mm256_loadu_pd (&pp->z[j]), _mm256_set1_pd (s[2]));
+
+	nx = _mm256_sub_pd (_mm256_mul_pd (v1y, v2z), _mm256_mul_pd (v1z, v2y));
+	ny = _mm256_sub_pd (_mm256_mul_pd (v1z, v2x), _mm256_mul_pd (v1x, v2z));
+	nz = _mm256_sub_pd (_mm256_mul_pd (v1x, v2y), _mm256_mul_pd (v1y, v2x));
+
+// if points don't make a valid plane, skip it
+	t = _mm256_add_pd (_mm256_mul_pd (nx, nx), _mm256_mul_pd (ny, ny));
+	FLOW_KEEP (t);
+	len = _mm256_add_pd (t, _mm256_mul_pd (nz, nz));
+	valid = _mm256_movemask_pd (_mm256_cmp_pd (len, eps, _CMP_GE_OQ)) & lanes;
+	if (!valid)
+		return 0;
+
+	t = _mm256_div_pd (_mm256_set1_pd (1.0), _mm256_sqrt_pd (len));
+	nx = _mm256_mul_pd (nx, t);
+	ny = _mm256_mul_pd (ny, t);
+	nz = _mm256_mul_pd (nz, t);
+
+	t = _mm256_add_pd (_mm256_mul_pd (_mm256_loadu_pd (&pp->x[j]), nx), _mm256_mul_pd (_mm256_loadu_pd (&pp->y[j]), ny));
+	FLOW_KEEP (t);
+	t = _mm256_add_pd (t, _mm256_mul_pd (_mm256_loadu_pd (&pp->z[j]), nz));
+	dist = _mm256_cvtpd_ps (t);
+
+// find out which side of each plane has the source portal
+	decided = flip = 0;
+	for (k = 0 ; k < source->numpoints && decided != valid ; k++)
+	{
+		if (k == i || k == l)
+			continue;
+		d = PlaneDist_AVX (source->points[k][0], source->points[k][1], source->points[k][2], nx, ny, nz, dist);
+		neg = _mm256_movemask_pd (_mm256_cmp_pd (d, negeps, _CMP_LT_OQ)) & valid & ~decided;
+		pos = _mm256_movemask_pd (_mm256_cmp_pd (d, eps, _CMP_GT_OQ)) & valid & ~decided;
+		flip |= pos;
+		decided |= neg | pos;
+	}
+	if (!decided)
+		return 0;	// planar with source portal
+
+// all of the pass portal points must be on the positive side
+	anyneg = anypos = 0;
+	for (k = 0 ; k < pass->numpoints ; k++)
+	{
+		d = PlaneDist_AVX (pass->points[k][0], pass->points[k][1], pass->points[k][2], nx, ny, nz, dist);
+		neg = _mm256_movemask_pd (_mm256_cmp_pd (d, negeps, _CMP_LT_OQ));
+		pos = _mm256_movemask_pd (_mm256_cmp_pd (d, eps, _CMP_GT_OQ));
+		self = (k >= j && k < j + 4) ? 1 << (k - j) : 0;
+		anyneg |= ((neg & ~flip) | (pos & flip)) & ~self;
+		anypos |= ((pos & ~flip) | (neg & flip)) & ~self;
+		if (!(decided & ~anyneg))
+			return 0;	// points on negative side of them all
+	}
+
+	_mm256_storeu_pd (&pp->nx[j], nx);
+	_mm256_storeu_pd (&pp->ny[j], ny);
+	_mm256_storeu_pd (&pp->nz[j], nz);
+	_mm_storeu_ps (&pp->dist[j], dist);
+	for (k = 0 ; k < 4 ; k++)
+		pp->flip[j+k] = (flip >> k) & 1;
+
+	return decided & ~anyneg & anypos;
+}
+
+__attribute__((__target__("avx")))
+static winding_t *ClipToSeperators_AVX (winding_t *source, winding_t *pass, winding_t *target, qboolean flipclip)
+{
+	passplanes_t	pp;
+	int		i, j, l, seperators;
+
+	LoadPassPoints (&pp, pass, 4);
+
+	for (i = 0 ; i < source->numpoints ; i++)
+	{
+		l = (i + 1) % source->numpoints;
+
+		for (j = 0 ; j < pass->numpoints ; j += 4)
+		{
+			seperators = PassPlanes_AVX (&pp, j, source, pass, i, l);
+			if (!seperators)
+				continue;
+			target = ClipByPassPlanes (&pp, j, seperators, target, flipclip);
+			if (!target)
+				return NULL;	// target is not visible
+		}
+	}
+	return target;
+}
+#endif	/* FLOW_X86 */
+
+
+static flowkernels_t	flowkernels[] =
+{
+	{ "c",		ClipToSeperators_C	},
+#if FLOW_X86
+	{ "sse2",	ClipToSeperators_SSE2	},
+	{ "avx",	ClipToSeperators_AVX	},
+#endif
+	{ NULL,		NULL			}
+};
+
+/*
+==============
+FlowKernelList
+
+The kernels that this cpu can run, slowest first
+==============
+*/
+const flowkernels_t *FlowKernelList (void)
+{
+	static qboolean	checked = false;
+	int		i, j;
+
+	if (checked)
+		return flowkernels;
+	checked = true;
+
+#if FLOW_X86
+	__builtin_cpu_init ();
+#endif
+	for (i = j = 0 ; flowkernels[i].name ; i++)
+	{
+#if FLOW_X86
+		if (flowkernels[i].clipseperators == ClipToSeperators_SSE2 && !__builtin_cpu_supports ("sse2"))
+			continue;
+		if (flowkernels[i].clipseperators == ClipToSeperators_AVX && !__builtin_cpu_supports ("avx"))
+			continue;
+#endif
+		flowkernels[j++] = flowkernels[i];
+	}
+	flowkernels[j] = flowkernels[i];
+
+	return flowkernels;
+}
+
+/*
+==============
+SetFlowKernels
+
+Picks the kernels by name, or the fastest ones for NULL
+==============
+*/
+void SetFlowKernels (const char *name)
+{
+	const flowkernels_t	*k, *fastest;
+
+	fastest = NULL;
+	for (k = FlowKernelList () ; k->name ; k++)
+	{
+		if (name && !q_strcasecmp(name, k->name))
+			break;
+		fastest = k;
+	}
+	if (!k->name)
+	{
+		if (name)
+			printf ("Unknown kernels \"%s\", using %s\n", name, fastest->name);
+		k = fastest;
+	}
+
+	flowk = k;
+}
@@ -25,9 +25,11 @@
 #include "q_endian.h"
 #include "byteordr.h"
 #include "pathutil.h"
+#include "util_io.h"
 #include "mathlib.h"
 #include "bspfile.h"
 #include "threads.h"
+#include "buildcache.h"
 #include "vis.h"
 
 
@@ -305,68 +307,365 @@ winding_t *ClipWinding (winding_t *in, plane_t *split, qboolean keepon)
 
 //=============================================================================
 
+/*
+=============================================================================
+
+PORTAL SCHEDULING
+
+The portals are sorted by their nummightsee from BasePortalVis, a rough
+estimate of how much work they are, and dealt out round robin to a queue
+for each thread.  A thread works through its own queue from the least
+complex portal, so the later ones can reuse the earlier information.  A
+thread that runs out takes the most complex portal left in the busiest
+queue, so the biggest portals don't end up running alone at the end.
+
+=============================================================================
+*/
+
+typedef struct
+{
+	int		*portalnums;	// least complex first
+	int		head, tail;	// next to do, one past the last
+	double		cost;		// of the portals left
+} workqueue_t;
+
+static workqueue_t	workqueues[MAX_THREADS];
+static int		numworkqueues;
+static int		*workportals;
+
+static int		portalsdone, portalstodo;
+static double		costdone, costtodo;
+static double		flowstart, nextprogress;
+
+#define	PROGRESS_INTERVAL	10	// seconds
+
+// the time a portal takes grows about with the square of its nummightsee
+static double PortalCost (portal_t *p)
+{
+	return (double)p->nummightsee * p->nummightsee;
+}
+
+static int CostCompare (const void *a, const void *b)
+{
+	int		n1 = *(const int *)a, n2 = *(const int *)b;
+
+	if (portals[n1].nummightsee != portals[n2].nummightsee)
+		return portals[n1].nummightsee - portals[n2].nummightsee;
+	return n1 - n2;
+}
+
+/*
+=============
+SetupWorkQueues
+
+Queues all the portals that aren't done yet
+=============
+*/
+static void SetupWorkQueues (void)
+{
+	int		i, j, n, count;
+	int		*sorted, *dest;
+	workqueue_t	*q;
+	const int	num2 = numportals * 2;
+
+	sorted = (int *) SafeMalloc (num2 * sizeof(int));
+	if (!workportals)	// kept for every run of CheckKernels
+		workportals = (int *) SafeMalloc (num2 * sizeof(int));
+
+	n = 0;
+	costtodo = 0;
+	for (i = 0 ; i < num2 ; i++)
+	{
+		if (portals[i].status != stat_none)
+			continue;
+		sorted[n++] = i;
+		costtodo += PortalCost (&portals[i]);
+	}
+	qsort (sorted, n, sizeof(int), CostCompare);
+	portalstodo = n;
+
+	numworkqueues = Thread_GetNumThreads ();
+	if (numworkqueues < 1)
+		numworkqueues = 1;
+
+	dest = workportals;
+	for (i = 0, q = workqueues ; i < numworkqueues ; i++, q++)
+	{
+		q->portalnums = dest;
+		q->head = q->tail = 0;
+		q->cost = 0;
+		count = (n - i + numworkqueues - 1) / numworkqueues;
+		for (j = 0 ; j < count ; j++)
+		{
+			q->portalnums[q->tail++] = sorted[i + j * numworkqueues];
+			q->cost += PortalCost (&portals[sorted[i + j * numworkqueues]]);
+		}
+		dest += count;
+	}
+
+	free (sorted);
+}
+
 /*
 =============
 GetNextPortal
 
 Returns the next portal for a thread to work on
-Returns the portals from the least complex, so the later ones can reuse
-the earlier information.
 =============
 */
-static portal_t *GetNextPortal (void)
+static portal_t *GetNextPortal (int threadnum)
 {
-	int		j;
-	portal_t	*p, *tp;
-	int		minsee;
-	const int	num2 = numportals * 2;
+	int		i;
+	workqueue_t	*q, *victim;
+	portal_t	*p;
 
 	ThreadLock();
 
-	minsee = 99999;
-	p = NULL;
-
-	for (j = 0, tp = portals ; j < num2 ; j++, tp++)
+	q = &workqueues[threadnum % numworkqueues];
+	if (q->head < q->tail)
 	{
-		if (tp->nummightsee < minsee && tp->status == stat_none)
+		p = &portals[q->portalnums[q->head++]];
+	}
+	else
+	{	// steal from the queue with the most work left
+		victim = NULL;
+		for (i = 0, q = workqueues ; i < numworkqueues ; i++, q++)
 		{
-			minsee = tp->nummightsee;
-			p = tp;
+			if (q->head < q->tail && (!victim || q->cost > victim->cost))
+				victim = q;
 		}
+		q = victim;
+		p = q ? &portals[q->portalnums[--q->tail]] : NULL;
 	}
 
 	if (p)
+	{
+		q->cost -= PortalCost (p);
 		p->status = stat_working;
+	}
 
 	ThreadUnlock();
 
 	return p;
 }
 
+/*
+=============================================================================
+
+CHECKPOINTS
+
+Every finished portal is appended to the checkpoint file, so that an
+interrupted vis picks up where it stopped.  The file is only used again
+for the same portal file and settings, and removed when vis completes.
+
+=============================================================================
+*/
+
+#define	CHECKPOINT_IDENT	(('1'<<24)+('K'<<16)+('C'<<8)+'V')
+
+typedef struct
+{
+	int		ident;
+	int		portalleafs, numportals;
+	int		testlevel, gilmode;
+	int		checksum;
+} checkheader_t;
+
+static char	checkfilename[1024];
+static FILE	*checkfile;
+
+static int PortalChecksum (void)
+{
+	unsigned int	h;
+	int		i, j, k;
+	portal_t	*p;
+	byte		*b;
+
+	h = 2166136261U;
+	for (i = 0, p = portals ; i < numportals * 2 ; i++, p++)
+	{
+		h = (h ^ (unsigned int)p->leaf) * 16777619U;
+		for (j = 0 ; j < p->winding->numpoints ; j++)
+		{
+			b = (byte *)p->winding->points[j];
+			for (k = 0 ; k < (int)sizeof(vec3_t) ; k++)
+				h = (h ^ b[k]) * 16777619U;
+		}
+	}
+
+	return (int)h;
+}
+
+/*
+=============
+OpenCheckpoint
+
+Loads the portals finished by an earlier run, if any, and gets the file
+ready for the new ones
+=============
+*/
+static void OpenCheckpoint (void)
+{
+	checkheader_t	header, h;
+	int		rec[2], count;
+	long		end;
+	portal_t	*p;
+
+	header.ident = LittleLong (CHECKPOINT_IDENT);
+	header.portalleafs = LittleLong (portalleafs);
+	header.numportals = LittleLong (numportals);
+	header.testlevel = LittleLong (testlevel);
+	header.gilmode = LittleLong (GilMode);
+	header.checksum = LittleLong (PortalChecksum ());
+
+	count = 0;
+	checkfile = fopen (checkfilename, "r+b");
+	if (checkfile)
+	{
+		if (fread (&h, sizeof(h), 1, checkfile) != 1 || memcmp (&h, &header, sizeof(h)))
+		{
+			printf ("%s doesn't match the portals or settings, not resuming\n", checkfilename);
+			fclose (checkfile);
+			checkfile = NULL;
+		}
+	}
+
+	if (checkfile)
+	{
+		end = ftell (checkfile);
+		while (fread (rec, sizeof(rec), 1, checkfile) == 1)
+		{
+			rec[0] = LittleLong (rec[0]);
+			rec[1] = LittleLong (rec[1]);
+			if (rec[0] < 0 || rec[0] >= numportals * 2)
+				break;
+			p = &portals[rec[0]];
+			if (p->status != stat_none)
+				break;
+			p->visbits = (byte *) SafeMalloc (bitbytes);
+			if (fread (p->visbits, bitbytes, 1, checkfile) != 1)
+			{	// cut short by the interruption
+				free (p->visbits);
+				p->visbits = NULL;
+				break;
+			}
+			p->numcansee = rec[1];
+			p->status = stat_done;
+			count++;
+			end = ftell (checkfile);
+		}
+		// anything after the last good record gets written over
+		fseek (checkfile, end, SEEK_SET);
+		printf ("resuming with %i portals from %s\n", count, checkfilename);
+	}
+	else
+	{
+		checkfile = fopen (checkfilename, "wb");
+		if (!checkfile)
+		{
+			printf ("couldn't write %s, no checkpoints\n", checkfilename);
+			return;
+		}
+		SafeWrite (checkfile, &header, sizeof(header));
+	}
+}
+
+static void CheckpointPortal (portal_t *p)
+{
+	int		rec[2];
+
+	if (!checkfile)
+		return;
+
+	rec[0] = LittleLong ((int)(p - portals));
+	rec[1] = LittleLong (p->numcansee);
+	SafeWrite (checkfile, rec, sizeof(rec));
+	SafeWrite (checkfile, p->visbits, bitbytes);
+}
+
+static void CloseCheckpoint (void)
+{
+	if (checkfile)
+		fclose (checkfile);
+	checkfile = NULL;
+}
+
+//=============================================================================
+
+static void PrintTime (double seconds)
+{
+	int		t = (int)seconds;
+
+	printf ("%i:%02i:%02i", t / 3600, (t / 60) % 60, t % 60);
+}
+
+/*
+=============
+PortalDone
+
+Counts a finished portal and prints the progress now and then, with an
+estimate of the time left from the costs of the portals done so far
+=============
+*/
+static void PortalDone (portal_t *p)
+{
+	double	now, elapsed;
+
+	ThreadLock();
+
+	CheckpointPortal (p);
+	portalsdone++;
+	costdone += PortalCost (p);
+
+	now = COM_GetTime ();
+	if (now >= nextprogress || portalsdone == portalstodo)
+	{
+		nextprogress = now + PROGRESS_INTERVAL;
+		if (checkfile)
+			fflush (checkfile);
+
+		elapsed = now - flowstart;
+		printf ("%6i of %i portals (%3i%%), ", portalsdone, portalstodo,
+				(int)(100.0 * costdone / (costtodo > 0 ? costtodo : 1)));
+		PrintTime (elapsed);
+		printf (" elapsed");
+		if (costdone > 0 && portalsdone < portalstodo)
+		{
+			printf (", about ");
+			PrintTime (elapsed * (costtodo - costdone) / costdone);
+			printf (" left");
+		}
+		printf ("\n");
+	}
+
+	ThreadUnlock();
+}
+
 /*
 ==============
 LeafThread
 ==============
 */
-static	void	LeafThread (void *junk)
+static	void	LeafThread (void *threadnum)
 {
 	portal_t	*p;
 
-	printf ("Begining %s: %i\n", __thisfunc__, (int)(intptr_t)junk);
+	printf ("Begining %s: %i\n", __thisfunc__, (int)(intptr_t)threadnum);
 	do
 	{
-		p = GetNextPortal ();
+		p = GetNextPortal ((int)(intptr_t)threadnum);
 		if (!p)
 			break;
 
 		PortalFlow (p);
+		PortalDone (p);
 		if (verbose) {
 			printf ("portal:%4i  mightsee:%4i  cansee:%4i\n",
 				(int)(p - portals), p->nummightsee, p->numcansee);
 		}
 	} while (1);
 
-	printf ("Completed %s: %i\n", __thisfunc__, (int)(intptr_t)junk);
+	printf ("Completed %s: %i\n", __thisfunc__, (int)(intptr_t)threadnum);
 }
 
 /*
@@ -503,8 +802,15 @@ static void CalcPortalVis (void)
 
 	leafon = 0;
 
+	OpenCheckpoint ();
+	SetupWorkQueues ();
+	flowstart = COM_GetTime ();
+	nextprogress = flowstart + PROGRESS_INTERVAL;
+
 	RunThreadsOn (LeafThread);
 
+	CloseCheckpoint ();
+
 	if (verbose)
 	{
 		printf ("portalcheck: %i  portaltest: %i  portalpass: %i\n",c_portalcheck, c_portaltest, c_portalpass);
@@ -536,6 +842,76 @@ static void CalcVis (void)
 }
 
 
+/*
+==================
+CheckKernels
+
+Runs the whole flow with each set of kernels this cpu has and compares
+the compressed vis data to that of the C kernels.  Single threaded, so
+that the portals are done in the same order every time.
+==================
+*/
+static int CheckKernels (void)
+{
+	const flowkernels_t	*k;
+	byte		*reference;
+	int		i, size, refsize, failed;
+	double		start;
+
+	BasePortalVis ();
+
+	reference = NULL;
+	refsize = 0;
+	failed = 0;
+	for (k = FlowKernelList () ; k->name ; k++)
+	{
+		flowk = k;
+		for (i = 0 ; i < numportals * 2 ; i++)
+		{
+			free (portals[i].visbits);
+			portals[i].visbits = NULL;
+			portals[i].status = stat_none;
+			portals[i].numcansee = 0;
+		}
+		memset (uncompressed, 0, bitbytes * portalleafs);
+		vismap_p = vismap;
+		totalvis = 0;
+		portalsdone = 0;
+		costdone = 0;
+
+		start = COM_GetTime ();
+		SetupWorkQueues ();
+		flowstart = start;
+		nextprogress = start + PROGRESS_INTERVAL;
+		LeafThread (NULL);
+		for (i = 0 ; i < portalleafs ; i++)
+			LeafFlow (i);
+		size = vismap_p - vismap;
+
+		printf ("%-6s %8.2f seconds, visdatasize:%i", k->name, COM_GetTime () - start, size);
+		if (!reference)
+		{
+			reference = (byte *) SafeMalloc (size);
+			memcpy (reference, vismap, size);
+			refsize = size;
+			printf ("\n");
+		}
+		else if (size != refsize || memcmp (reference, vismap, size))
+		{
+			printf (", DIFFERENT from %s\n", FlowKernelList()->name);
+			failed++;
+		}
+		else
+			printf (", same\n");
+	}
+
+	free (reference);
+	free (workportals);
+	workportals = NULL;
+	return failed;
+}
+
+
 /*
 ==============================================================================
 
@@ -789,6 +1165,63 @@ static void LoadPortals (char *name)
 }
 
 
+/*
+===========
+VisInputHash
+
+The portals and the options, and the bsp file the ambient sounds are
+made from
+===========
+*/
+static qboolean VisInputHash (const char *portalfile, char *out)
+{
+	buildhash_t	hash;
+	void		*buf;
+	int		len;
+
+	if (Q_FileType (portalfile) != FS_ENT_FILE)
+		return false;
+
+	Hash_Init (&hash);
+	Hash_String (&hash, "vis 1");
+	Hash_Int (&hash, testlevel);
+	Hash_Int (&hash, GilMode);
+	Hash_Int (&hash, fastvis);
+
+	len = LoadFile (portalfile, &buf);
+	Hash_Data (&hash, buf, len);
+	free (buf);
+
+	Hash_BSPGeometry (&hash);
+	Hash_Data (&hash, dtexdata, texdatasize);
+
+	Hash_Hex (&hash, out);
+	return true;
+}
+
+/*
+===========
+VisUpToDate
+
+True if the vis data in the bsp file is what vis made the last time from
+the same input
+===========
+*/
+static qboolean VisUpToDate (const char *input)
+{
+	buildhash_t	hash;
+	char		hex[HASH_STRLEN];
+
+	if (!Cache_Match ("vis:input", input))
+		return false;
+
+	Hash_Init (&hash);
+	Hash_BSPVis (&hash);
+	Hash_Hex (&hash, hex);
+	return Cache_Match ("vis:output", hex);
+}
+
+
 /*
 ===========
 main
@@ -798,15 +1231,24 @@ int main (int argc, char **argv)
 {
 	char	portalfile[1024];
 	char	source[1024];
+	char	cachefile[1024];
+	char	input[HASH_STRLEN], output[HASH_STRLEN];
+	buildhash_t	hash;
+	qboolean	cached, nocache;
 	int		i;
 	int		wantthreads;
 	double	start, end;
+	const char	*kernels;
+	qboolean	kernelcheck;
 
 	printf ("---- vis ----\n");
 
 	ValidateByteorder ();
 
 	wantthreads = -1;		// default to auto-detect.
+	kernels = NULL;			// the fastest this cpu can run
+	kernelcheck = false;
+	nocache = false;
 
 	for (i = 1 ; i < argc ; i++)
 	{
@@ -838,6 +1280,20 @@ int main (int argc, char **argv)
 			printf ("verbose = true\n");
 			verbose = true;
 		}
+		else if (!strcmp(argv[i], "-kernels"))
+		{
+			if (i >= argc - 1)
+				COM_Error("Missing argument to \"%s\"", argv[i]);
+			kernels = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-kernelcheck"))
+		{
+			kernelcheck = true;
+		}
+		else if (!strcmp(argv[i], "-nocache"))
+		{
+			nocache = true;
+		}
 		else if (argv[i][0] == '-')
 			COM_Error ("Unknown option \"%s\"", argv[i]);
 		else
@@ -845,9 +1301,13 @@ int main (int argc, char **argv)
 	}
 
 	if (i != argc - 1)
-		COM_Error ("usage: vis [-nogil] [-threads #] [-level 0-4] [-fast] [-v] bspfile");
+		COM_Error ("usage: vis [-nogil] [-threads #] [-level 0-4] [-fast] [-kernels c|sse2|avx] [-kernelcheck] [-nocache] [-v] bspfile");
 
+	if (kernelcheck)
+		wantthreads = 1;
 	InitThreads (wantthreads, 0);
+	SetFlowKernels (kernels);
+	printf ("flow kernels: %s\n", flowk->name);
 
 	start = COM_GetTime ();
 
@@ -861,10 +1321,39 @@ int main (int argc, char **argv)
 	StripExtension (portalfile);
 	strcat (portalfile, ".prt");
 
+	strcpy (checkfilename, argv[i]);
+	StripExtension (checkfilename);
+	strcat (checkfilename, ".vck");
+
+// see if the vis data is there already
+	strcpy (cachefile, argv[i]);
+	StripExtension (cachefile);
+	strcat (cachefile, ".bcache");
+	cached = !kernelcheck && VisInputHash (portalfile, input);
+	if (cached)
+	{
+		Cache_Load (cachefile);
+		if (!nocache && VisUpToDate (input))
+		{
+			printf ("%s: vis data is up to date\n", source);
+			printf ("%5.1f seconds elapsed\n", COM_GetTime () - start);
+			return 0;
+		}
+	}
+
 	LoadPortals (portalfile);
 
 	uncompressed = (byte *) SafeMalloc(bitbytes*portalleafs);
 
+	if (kernelcheck)
+	{
+		i = CheckKernels ();
+		if (i)
+			COM_Error ("%i kernel sets differ from the C ones", i);
+		printf ("%5.1f seconds elapsed\n", COM_GetTime () - start);
+		return 0;
+	}
+
 	CalcVis ();
 
 	printf ("c_chains: %i\n", c_chains);
@@ -877,7 +1366,20 @@ int main (int argc, char **argv)
 	else
 		CalcAmbientSounds2 ();
 
+	if (cached)
+	{
+		Hash_Init (&hash);
+		Hash_BSPVis (&hash);
+		Hash_Hex (&hash, output);
+		Cache_SetString ("vis:input", input);
+		Cache_SetString ("vis:output", output);
+	}
+
 	WriteBSPFile (source, is_bsp2);
+	if (!fastvis)
+		Q_unlink (checkfilename);	// finished, nothing to resume
+	if (cached)
+		Cache_Save ();
 
 //	Q_unlink (portalfile);
 	if (GilMode)
@@ -132,4 +132,16 @@ void		FreeWinding (winding_t *w);
 winding_t	*ClipWinding (winding_t *in, plane_t *split, qboolean keepon);
 winding_t	*CopyWinding (winding_t *w);
 
+// flowsimd.c
+typedef struct
+{
+	const char	*name;
+	winding_t	*(*clipseperators) (winding_t *source, winding_t *pass, winding_t *target, qboolean flipclip);
+} flowkernels_t;
+
+extern	const flowkernels_t	*flowk;
+
+const flowkernels_t	*FlowKernelList (void);	// the ones this cpu can run
+void	SetFlowKernels (const char *name);	// NULL for the fastest
+
 #endif	/* H2VIS_H */